@@ -0,0 +1,199 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Benchmark of the min-cost flow algorithms on a sequence of random
+// transshipment problems, each one obtained by perturbing a small fraction of
+// the supplies and of the arc costs of the previous one. This is typical of
+// re-planning applications.
+//
+// Each problem is solved from scratch, and by a GenericMinCostFlow which is
+// warm-started from the solution of the previous problem. The optimal costs
+// are checked to be equal, and the solve times are reported.
+
+#include <cstdio>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+
+DEFINE_int32(num_nodes, 20000, "Number of nodes of the problems.");
+DEFINE_int32(num_arcs_per_node, 8, "Average out-degree of the nodes.");
+DEFINE_int32(num_supply_nodes, 1000,
+             "Number of supply nodes, which is also the number of demand "
+             "nodes.");
+DEFINE_int32(max_cost, 10000, "Maximum unit cost of an arc.");
+DEFINE_int32(max_capacity, 50, "Maximum capacity of an arc.");
+DEFINE_int32(num_rounds, 10, "Number of perturbed problems to solve.");
+DEFINE_double(perturbation_ratio, 0.001,
+              "Ratio of the arc costs and of the supplies which are modified "
+              "between two consecutive problems.");
+DEFINE_int32(seed, 0, "Seed of the random generator.");
+
+namespace operations_research {
+
+typedef ReverseArcStaticGraph<> Graph;
+typedef GenericMinCostFlow<Graph> MinCostFlowSolver;
+
+// A transshipment problem. The arcs are indexed as in the graph.
+struct TransshipmentProblem {
+  std::vector<FlowQuantity> supplies;
+  std::vector<FlowQuantity> capacities;
+  std::vector<CostValue> costs;
+};
+
+// Creates a random graph. To make sure that all the problems are feasible, the
+// nodes are linked by a cycle of arcs with a large capacity and cost.
+void BuildRandomProblem(ACMRandom* random, Graph* graph,
+                        TransshipmentProblem* problem) {
+  const int num_nodes = FLAGS_num_nodes;
+  const int num_arcs = num_nodes * (FLAGS_num_arcs_per_node + 1);
+  std::vector<FlowQuantity> capacities;
+  std::vector<CostValue> costs;
+  for (int node = 0; node < num_nodes; ++node) {
+    graph->AddArc(node, (node + 1) % num_nodes);
+    capacities.push_back(FLAGS_max_capacity * FLAGS_num_supply_nodes);
+    costs.push_back(FLAGS_max_cost * 10);
+  }
+  while (graph->num_arcs() < num_arcs) {
+    const int tail = random->Uniform(num_nodes);
+    const int head = random->Uniform(num_nodes);
+    if (tail == head) continue;
+    graph->AddArc(tail, head);
+    capacities.push_back(1 + random->Uniform(FLAGS_max_capacity));
+    costs.push_back(random->Uniform(FLAGS_max_cost + 1));
+  }
+  std::vector<ArcIndex> permutation;
+  graph->Build(&permutation);
+  problem->capacities.resize(num_arcs);
+  problem->costs.resize(num_arcs);
+  for (int arc = 0; arc < num_arcs; ++arc) {
+    const int permuted_arc = permutation.empty() ? arc : permutation[arc];
+    problem->capacities[permuted_arc] = capacities[arc];
+    problem->costs[permuted_arc] = costs[arc];
+  }
+  problem->supplies.assign(num_nodes, 0);
+  for (int i = 0; i < FLAGS_num_supply_nodes; ++i) {
+    const FlowQuantity supply = 1 + random->Uniform(FLAGS_max_capacity);
+    problem->supplies[random->Uniform(num_nodes)] += supply;
+    problem->supplies[random->Uniform(num_nodes)] -= supply;
+  }
+}
+
+// Changes the costs of some random arcs by up to 10%, and moves some supply
+// between random pairs of nodes. The modified arcs and nodes are appended to
+// the given vectors.
+void PerturbProblem(ACMRandom* random, TransshipmentProblem* problem,
+                    std::vector<ArcIndex>* modified_arcs,
+                    std::vector<NodeIndex>* modified_nodes) {
+  const int num_nodes = problem->supplies.size();
+  const int num_arcs = problem->costs.size();
+  const int num_arc_changes = num_arcs * FLAGS_perturbation_ratio;
+  for (int i = 0; i < num_arc_changes; ++i) {
+    const int arc = num_nodes + random->Uniform(num_arcs - num_nodes);
+    problem->costs[arc] =
+        problem->costs[arc] * (90 + random->Uniform(21)) / 100;
+    modified_arcs->push_back(arc);
+  }
+  const int num_supply_changes =
+      FLAGS_num_supply_nodes * FLAGS_perturbation_ratio;
+  for (int i = 0; i < num_supply_changes; ++i) {
+    const NodeIndex from = random->Uniform(num_nodes);
+    const NodeIndex to = random->Uniform(num_nodes);
+    const FlowQuantity delta = 1 + random->Uniform(FLAGS_max_capacity);
+    problem->supplies[from] += delta;
+    problem->supplies[to] -= delta;
+    modified_nodes->push_back(from);
+    modified_nodes->push_back(to);
+  }
+}
+
+void LoadProblem(const TransshipmentProblem& problem,
+                 MinCostFlowSolver* solver) {
+  const int num_arcs = problem.costs.size();
+  for (int arc = 0; arc < num_arcs; ++arc) {
+    solver->SetArcCapacity(arc, problem.capacities[arc]);
+    solver->SetArcUnitCost(arc, problem.costs[arc]);
+  }
+  const int num_nodes = problem.supplies.size();
+  for (int node = 0; node < num_nodes; ++node) {
+    solver->SetNodeSupply(node, problem.supplies[node]);
+  }
+}
+
+void RunBenchmark() {
+  ACMRandom random(FLAGS_seed);
+  Graph graph(FLAGS_num_nodes,
+              FLAGS_num_nodes * (FLAGS_num_arcs_per_node + 1));
+  TransshipmentProblem problem;
+  BuildRandomProblem(&random, &graph, &problem);
+  LOG(INFO) << "Graph with " << graph.num_nodes() << " nodes and "
+            << graph.num_arcs() << " arcs.";
+
+  MinCostFlowSolver warm_solver(&graph);
+  warm_solver.SetUseWarmStart(true);
+  LoadProblem(problem, &warm_solver);
+  double total_cold_time = 0.0;
+  double total_warm_time = 0.0;
+  for (int round = 0; round <= FLAGS_num_rounds; ++round) {
+    if (round > 0) {
+      std::vector<ArcIndex> modified_arcs;
+      std::vector<NodeIndex> modified_nodes;
+      PerturbProblem(&random, &problem, &modified_arcs, &modified_nodes);
+      for (const ArcIndex arc : modified_arcs) {
+        warm_solver.SetArcUnitCost(arc, problem.costs[arc]);
+      }
+      for (const NodeIndex node : modified_nodes) {
+        warm_solver.SetNodeSupplyKeepingFlow(node, problem.supplies[node]);
+      }
+    }
+
+    MinCostFlowSolver cold_solver(&graph);
+    LoadProblem(problem, &cold_solver);
+    WallTimer timer;
+    timer.Start();
+    CHECK(cold_solver.Solve());
+    const double cold_time = timer.Get();
+
+    timer.Restart();
+    CHECK(warm_solver.Solve());
+    const double warm_time = timer.Get();
+    CHECK_EQ(cold_solver.GetOptimalCost(), warm_solver.GetOptimalCost());
+
+    // The first warm solve is done from scratch.
+    if (round > 0) {
+      total_cold_time += cold_time;
+      total_warm_time += warm_time;
+    }
+    printf("round %3d: cost %lld, cold %.3fs, warm %.3fs\n", round,
+           static_cast<long long>(cold_solver.GetOptimalCost()),  // NOLINT
+           cold_time, warm_time);
+  }
+  if (FLAGS_num_rounds > 0) {
+    printf("average over %d perturbed problems: cold %.3fs, warm %.3fs\n",
+           FLAGS_num_rounds, total_cold_time / FLAGS_num_rounds,
+           total_warm_time / FLAGS_num_rounds);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags( &argc, &argv, true);
+  operations_research::RunBenchmark();
+  return 0;
+}
@@ -0,0 +1,249 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Head-to-head comparison of the two min-cost flow algorithms, the cost
+// scaling of GenericMinCostFlow and the network simplex of
+// NetworkSimplexMinCostFlow, on three families of random problems:
+// - "transshipment": sparse random graphs with a few supply and demand nodes,
+//   as in min_cost_flow_benchmark.cc,
+// - "transportation": complete bipartite graphs from supply to demand nodes,
+// - "grid": square grids with arcs in both directions between neighbors, and
+//   supplies and demands on random nodes.
+// For each problem, the optimal costs are checked to be equal, and the solve
+// times and the number of pivots of the network simplex are reported.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/timer.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+#include "graph/network_simplex.h"
+
+DEFINE_int32(num_nodes, 20000,
+             "Approximate number of nodes of the transshipment and grid "
+             "problems.");
+DEFINE_int32(num_arcs_per_node, 8,
+             "Average out-degree of the nodes of the transshipment problems.");
+DEFINE_int32(num_transportation_nodes, 400,
+             "Number of supply nodes, and of demand nodes, of the "
+             "transportation problems.");
+DEFINE_int32(num_supply_nodes, 1000,
+             "Number of supply nodes, which is also the number of demand "
+             "nodes, of the transshipment and grid problems.");
+DEFINE_int32(max_cost, 10000, "Maximum unit cost of an arc.");
+DEFINE_int32(max_capacity, 50, "Maximum capacity of an arc.");
+DEFINE_int32(num_problems, 3, "Number of problems of each family.");
+DEFINE_int32(seed, 0, "Seed of the random generator.");
+
+namespace operations_research {
+
+typedef ReverseArcStaticGraph<> Graph;
+
+// A min-cost flow problem. The arcs are indexed as in the graph once it is
+// built.
+struct FlowProblem {
+  FlowProblem() : graph(NULL) {}
+  ~FlowProblem() { delete graph; }
+
+  Graph* graph;
+  std::vector<FlowQuantity> supplies;
+  std::vector<FlowQuantity> capacities;
+  std::vector<CostValue> costs;
+};
+
+// Adds an arc to the problem, whose graph is not built yet.
+void AddArc(NodeIndex tail, NodeIndex head, FlowQuantity capacity,
+            CostValue cost, FlowProblem* problem) {
+  problem->graph->AddArc(tail, head);
+  problem->capacities.push_back(capacity);
+  problem->costs.push_back(cost);
+}
+
+// Builds the graph of the problem and permutes its arc data accordingly.
+void BuildGraph(FlowProblem* problem) {
+  std::vector<ArcIndex> permutation;
+  problem->graph->Build(&permutation);
+  if (permutation.empty()) return;
+  const int num_arcs = problem->capacities.size();
+  std::vector<FlowQuantity> capacities(num_arcs);
+  std::vector<CostValue> costs(num_arcs);
+  for (int arc = 0; arc < num_arcs; ++arc) {
+    capacities[permutation[arc]] = problem->capacities[arc];
+    costs[permutation[arc]] = problem->costs[arc];
+  }
+  problem->capacities.swap(capacities);
+  problem->costs.swap(costs);
+}
+
+// Moves random amounts of supply from num_pairs random nodes to other random
+// nodes.
+void AddRandomSupplies(ACMRandom* random, int num_pairs,
+                       FlowProblem* problem) {
+  const int num_nodes = problem->supplies.size();
+  for (int i = 0; i < num_pairs; ++i) {
+    const FlowQuantity supply = 1 + random->Uniform(FLAGS_max_capacity);
+    problem->supplies[random->Uniform(num_nodes)] += supply;
+    problem->supplies[random->Uniform(num_nodes)] -= supply;
+  }
+}
+
+// A random sparse graph. To make sure that the problem is feasible, the
+// nodes are linked by a cycle of arcs with a large capacity and cost.
+void BuildTransshipmentProblem(ACMRandom* random, FlowProblem* problem) {
+  const int num_nodes = FLAGS_num_nodes;
+  const int num_arcs = num_nodes * (FLAGS_num_arcs_per_node + 1);
+  problem->graph = new Graph(num_nodes, num_arcs);
+  for (int node = 0; node < num_nodes; ++node) {
+    AddArc(node, (node + 1) % num_nodes,
+           FLAGS_max_capacity * FLAGS_num_supply_nodes, FLAGS_max_cost * 10,
+           problem);
+  }
+  while (problem->graph->num_arcs() < num_arcs) {
+    const int tail = random->Uniform(num_nodes);
+    const int head = random->Uniform(num_nodes);
+    if (tail == head) continue;
+    AddArc(tail, head, 1 + random->Uniform(FLAGS_max_capacity),
+           random->Uniform(FLAGS_max_cost + 1), problem);
+  }
+  BuildGraph(problem);
+  problem->supplies.assign(num_nodes, 0);
+  AddRandomSupplies(random, FLAGS_num_supply_nodes, problem);
+}
+
+// A complete bipartite graph with uncapacitated arcs, from the first half of
+// the nodes, which have a positive supply, to the second half, which have a
+// demand.
+void BuildTransportationProblem(ACMRandom* random, FlowProblem* problem) {
+  const int num_sides = FLAGS_num_transportation_nodes;
+  const FlowQuantity total_supply =
+      static_cast<FlowQuantity>(num_sides) * FLAGS_max_capacity;
+  problem->graph = new Graph(2 * num_sides, num_sides * num_sides);
+  for (int tail = 0; tail < num_sides; ++tail) {
+    for (int head = num_sides; head < 2 * num_sides; ++head) {
+      AddArc(tail, head, total_supply, random->Uniform(FLAGS_max_cost + 1),
+             problem);
+    }
+  }
+  BuildGraph(problem);
+  problem->supplies.assign(2 * num_sides, 0);
+  for (int i = 0; i < num_sides; ++i) {
+    const FlowQuantity supply = 1 + random->Uniform(2 * FLAGS_max_capacity);
+    problem->supplies[random->Uniform(num_sides)] += supply;
+    problem->supplies[num_sides + random->Uniform(num_sides)] -= supply;
+  }
+}
+
+// A square grid, whose neighbors are linked by arcs in both directions. As in
+// the transshipment problems, the nodes are also linked by a cycle of arcs
+// with a large capacity and cost, so that the problem is always feasible.
+void BuildGridProblem(ACMRandom* random, FlowProblem* problem) {
+  int size = 1;
+  while ((size + 1) * (size + 1) <= FLAGS_num_nodes) ++size;
+  const int num_nodes = size * size;
+  problem->graph = new Graph(num_nodes, 5 * num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    AddArc(node, (node + 1) % num_nodes,
+           FLAGS_max_capacity * FLAGS_num_supply_nodes, FLAGS_max_cost * 10,
+           problem);
+  }
+  for (int row = 0; row < size; ++row) {
+    for (int column = 0; column < size; ++column) {
+      const int node = row * size + column;
+      const int neighbors[2] = {column + 1 < size ? node + 1 : -1,
+                                row + 1 < size ? node + size : -1};
+      for (const int neighbor : neighbors) {
+        if (neighbor < 0) continue;
+        const FlowQuantity capacity = 1 + random->Uniform(FLAGS_max_capacity);
+        const CostValue cost = random->Uniform(FLAGS_max_cost + 1);
+        AddArc(node, neighbor, capacity, cost, problem);
+        AddArc(neighbor, node, capacity, cost, problem);
+      }
+    }
+  }
+  BuildGraph(problem);
+  problem->supplies.assign(num_nodes, 0);
+  AddRandomSupplies(random, FLAGS_num_supply_nodes, problem);
+}
+
+template <typename MinCostFlowSolver>
+void LoadProblem(const FlowProblem& problem, MinCostFlowSolver* solver) {
+  const int num_arcs = problem.costs.size();
+  for (int arc = 0; arc < num_arcs; ++arc) {
+    solver->SetArcCapacity(arc, problem.capacities[arc]);
+    solver->SetArcUnitCost(arc, problem.costs[arc]);
+  }
+  const int num_nodes = problem.supplies.size();
+  for (int node = 0; node < num_nodes; ++node) {
+    solver->SetNodeSupply(node, problem.supplies[node]);
+  }
+}
+
+void RunBenchmark(const std::string& name,
+                  void (*build_problem)(ACMRandom*, FlowProblem*)) {
+  ACMRandom random(FLAGS_seed);
+  double total_cost_scaling_time = 0.0;
+  double total_network_simplex_time = 0.0;
+  for (int i = 0; i < FLAGS_num_problems; ++i) {
+    FlowProblem problem;
+    build_problem(&random, &problem);
+
+    GenericMinCostFlow<Graph> cost_scaling(problem.graph);
+    LoadProblem(problem, &cost_scaling);
+    WallTimer timer;
+    timer.Start();
+    CHECK(cost_scaling.Solve());
+    const double cost_scaling_time = timer.Get();
+
+    NetworkSimplexMinCostFlow<Graph> network_simplex(problem.graph);
+    LoadProblem(problem, &network_simplex);
+    timer.Restart();
+    CHECK(network_simplex.Solve());
+    const double network_simplex_time = timer.Get();
+    CHECK_EQ(cost_scaling.GetOptimalCost(), network_simplex.GetOptimalCost());
+
+    total_cost_scaling_time += cost_scaling_time;
+    total_network_simplex_time += network_simplex_time;
+    printf(
+        "%s %d: %d nodes, %d arcs, cost scaling %.3fs, network simplex %.3fs "
+        "(%lld pivots, %lld degenerate)\n",
+        name.c_str(), i, problem.graph->num_nodes(), problem.graph->num_arcs(),
+        cost_scaling_time, network_simplex_time,
+        static_cast<long long>(network_simplex.num_pivots()),  // NOLINT
+        static_cast<long long>(                                 // NOLINT
+            network_simplex.num_degenerate_pivots()));
+  }
+  if (FLAGS_num_problems > 0) {
+    printf("%s average: cost scaling %.3fs, network simplex %.3fs\n",
+           name.c_str(), total_cost_scaling_time / FLAGS_num_problems,
+           total_network_simplex_time / FLAGS_num_problems);
+  }
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags( &argc, &argv, true);
+  operations_research::RunBenchmark(
+      "transshipment", &operations_research::BuildTransshipmentProblem);
+  operations_research::RunBenchmark(
+      "transportation", &operations_research::BuildTransportationProblem);
+  operations_research::RunBenchmark("grid",
+                                    &operations_research::BuildGridProblem);
+  return 0;
+}
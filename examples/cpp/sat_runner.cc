@@ -11,6 +11,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <limits>
 #include <string>
 #include <vector>
 
@@ -230,7 +231,9 @@ int Run() {
   if (FLAGS_use_symmetry) {
     LOG(INFO) << "Finding symmetries of the problem.";
     std::vector<std::unique_ptr<SparsePermutation>> generators;
-    FindLinearBooleanProblemSymmetries(problem, &generators);
+    FindLinearBooleanProblemSymmetries(
+        problem, std::numeric_limits<double>::infinity(), /*num_threads=*/1,
+        &generators);
     solver->AddSymmetries(&generators);
   }
 
@@ -70,7 +70,7 @@
 DEFINE_bool(colgen_verbose, false, "print verbosely");
 DEFINE_bool(colgen_complete, false, "generate all columns initially");
 DEFINE_int32(colgen_max_iterations, 500, "max iterations");
-DEFINE_string(colgen_solver, "clp", "solver - glpk or clp (default)");
+DEFINE_string(colgen_solver, "clp", "solver - glpk, glop or clp (default)");
 DEFINE_int32(colgen_instance, -1, "Which instance to solve (0 - 9)");
 
 namespace operations_research {
@@ -618,6 +618,12 @@ int main(int argc, char** argv) {
     found = true;
   }
   #endif  // USE_GLPK
+  #if defined(USE_GLOP)
+  if (FLAGS_colgen_solver == "glop") {
+    solver_type = operations_research::MPSolver::GLOP_LINEAR_PROGRAMMING;
+    found = true;
+  }
+  #endif  // USE_GLOP
   if (!found) {
     LOG(ERROR) << "Unknown solver " << FLAGS_colgen_solver;
     return 1;
@@ -0,0 +1,197 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that AuctionLinearSumAssignment and DenseLinearSumAssignment, with
+// one and several threads, find a perfect matching with the same optimal cost
+// as the push-relabel LinearSumAssignment on random sparse and dense
+// problems, and that the sparse auction returns false when there is no
+// perfect matching.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/auction_assignment.h"
+#include "graph/graph.h"
+#include "graph/linear_assignment.h"
+
+namespace operations_research {
+
+class AuctionAssignmentTest {
+ public:
+  typedef AuctionLinearSumAssignment::Graph Graph;
+  typedef Graph::NodeIndex NodeIndex;
+  typedef Graph::ArcIndex ArcIndex;
+
+  AuctionAssignmentTest() : random_(12345) {}
+
+  // Builds a random bipartite graph with about the given number of arcs per
+  // left node, and random costs. If perfect is true, the arcs of a random
+  // perfect matching are added, otherwise two left nodes are only linked to
+  // the same right node, so there is no perfect matching.
+  void BuildRandomProblem(int num_left_nodes, int arcs_per_node,
+                          CostValue max_cost, bool perfect) {
+    std::vector<NodeIndex> tails;
+    std::vector<NodeIndex> heads;
+    std::vector<NodeIndex> permutation(num_left_nodes);
+    for (int i = 0; i < num_left_nodes; ++i) permutation[i] = i;
+    for (int i = num_left_nodes - 1; i > 0; --i) {
+      std::swap(permutation[i], permutation[random_.Uniform(i + 1)]);
+    }
+    const int first_free_node = perfect ? 0 : 2;
+    for (NodeIndex left = 0; left < num_left_nodes; ++left) {
+      if (left < first_free_node) {
+        tails.push_back(left);
+        heads.push_back(num_left_nodes);
+        continue;
+      }
+      if (perfect) {
+        tails.push_back(left);
+        heads.push_back(num_left_nodes + permutation[left]);
+      }
+      for (int i = 0; i < arcs_per_node; ++i) {
+        tails.push_back(left);
+        heads.push_back(num_left_nodes + random_.Uniform(num_left_nodes));
+      }
+    }
+    graph_.reset(new Graph(2 * num_left_nodes, tails.size()));
+    costs_.clear();
+    for (int arc = 0; arc < tails.size(); ++arc) {
+      graph_->AddArc(tails[arc], heads[arc]);
+      costs_.push_back(random_.Uniform(max_cost + 1));
+    }
+    std::vector<ArcIndex> arc_permutation;
+    graph_->Build(&arc_permutation);
+    Permute(arc_permutation, &costs_);
+  }
+
+  // Checks the sparse auction with several thread counts against
+  // LinearSumAssignment.
+  void TestSparse(int num_left_nodes, int arcs_per_node, CostValue max_cost) {
+    BuildRandomProblem(num_left_nodes, arcs_per_node, max_cost, true);
+    LinearSumAssignment<Graph> expected(*graph_, num_left_nodes);
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      expected.SetArcCost(arc, costs_[arc]);
+    }
+    CHECK(expected.ComputeAssignment());
+    for (const int num_threads : {1, 2, 4}) {
+      AuctionLinearSumAssignment assignment(*graph_, num_left_nodes);
+      for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+        assignment.SetArcCost(arc, costs_[arc]);
+      }
+      assignment.SetNumThreads(num_threads);
+      CHECK(assignment.ComputeAssignment());
+      CHECK_EQ(expected.GetCost(), assignment.GetCost());
+      std::vector<bool> assigned(num_left_nodes, false);
+      CostValue cost = 0;
+      for (NodeIndex left = 0; left < num_left_nodes; ++left) {
+        const ArcIndex arc = assignment.GetAssignmentArc(left);
+        CHECK_EQ(left, graph_->Tail(arc));
+        CHECK_EQ(graph_->Head(arc), assignment.GetMate(left));
+        CHECK_EQ(costs_[arc], assignment.GetAssignmentCost(left));
+        const NodeIndex right = assignment.GetMate(left) - num_left_nodes;
+        CHECK(!assigned[right]);
+        assigned[right] = true;
+        cost += costs_[arc];
+      }
+      CHECK_EQ(cost, assignment.GetCost());
+    }
+  }
+
+  // Checks that the sparse auction detects that there is no perfect
+  // matching, with one and several threads.
+  void TestSparseWithoutPerfectMatching(int num_left_nodes,
+                                        int arcs_per_node) {
+    BuildRandomProblem(num_left_nodes, arcs_per_node, 100, false);
+    for (const int num_threads : {1, 4}) {
+      AuctionLinearSumAssignment assignment(*graph_, num_left_nodes);
+      for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+        assignment.SetArcCost(arc, costs_[arc]);
+      }
+      assignment.SetNumThreads(num_threads);
+      CHECK(!assignment.ComputeAssignment());
+    }
+  }
+
+  // Checks the dense auction with several thread counts against
+  // LinearSumAssignment on the complete bipartite graph.
+  template <typename CostType>
+  void TestDense(int size, CostValue max_cost) {
+    std::vector<CostType> costs;
+    for (int i = 0; i < size * size; ++i) {
+      costs.push_back(random_.Uniform(max_cost + 1));
+    }
+    Graph graph(2 * size, size * size);
+    for (int row = 0; row < size; ++row) {
+      for (int column = 0; column < size; ++column) {
+        graph.AddArc(row, size + column);
+      }
+    }
+    // The arcs are added in order, so Build() doesn't permute them.
+    graph.Build();
+    LinearSumAssignment<Graph> expected(graph, size);
+    for (ArcIndex arc = 0; arc < size * size; ++arc) {
+      expected.SetArcCost(arc, costs[arc]);
+    }
+    CHECK(expected.ComputeAssignment());
+    for (const int num_threads : {1, 2, 4}) {
+      DenseLinearSumAssignment<CostType> assignment(size);
+      for (int row = 0; row < size; ++row) {
+        for (int column = 0; column < size; ++column) {
+          assignment.SetCost(row, column, costs[row * size + column]);
+        }
+      }
+      assignment.SetNumThreads(num_threads);
+      CHECK(assignment.ComputeAssignment());
+      CHECK_EQ(expected.GetCost(), assignment.GetCost());
+      std::vector<bool> assigned(size, false);
+      CostValue cost = 0;
+      for (int row = 0; row < size; ++row) {
+        const int column = assignment.GetMate(row);
+        CHECK(!assigned[column]);
+        assigned[column] = true;
+        cost += assignment.Cost(row, column);
+      }
+      CHECK_EQ(cost, assignment.GetCost());
+    }
+  }
+
+ private:
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<CostValue> costs_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::AuctionAssignmentTest test;
+  for (int i = 0; i < 20; ++i) {
+    test.TestSparse(1, 0, 10);
+    test.TestSparse(10, 2, 10);
+    test.TestSparse(100, 5, 1000);
+    test.TestSparse(500, 20, 1000000);
+    test.TestSparseWithoutPerfectMatching(2, 3);
+    test.TestSparseWithoutPerfectMatching(50, 5);
+    test.TestDense<int32>(1, 10);
+    test.TestDense<int32>(20, 5);
+    test.TestDense<int32>(80, 100000);
+    test.TestDense<int64>(60, 1000000000);
+  }
+  return 0;
+}
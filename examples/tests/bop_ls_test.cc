@@ -0,0 +1,387 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks, after random flips and backtracks on random problems, that the
+// buckets of one-flip repairs of AssignmentAndConstraintFeasibilityMaintainer
+// match a full recount of the repairs of each infeasible constraint, and that
+// OneFlipConstraintRepairer::ConstraintToRepair() follows its documented
+// order given the variables assigned by the SAT propagator. Also checks the
+// lookups and the replacement policy of TranspositionTable.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/hash.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "bop/bop_ls.h"
+#include "bop/bop_solution.h"
+#include "bop/bop_types.h"
+#include "sat/boolean_problem.pb.h"
+#include "sat/sat_base.h"
+
+namespace operations_research {
+namespace bop {
+
+class BopLsTest {
+ public:
+  typedef AssignmentAndConstraintFeasibilityMaintainer Maintainer;
+
+  BopLsTest() : random_(12345) {}
+
+  // Builds a random problem whose constraints all have more than two terms,
+  // so that the maintainer keeps them all, with the same indices shifted by
+  // one for the objective. The constraints are satisfied by a random
+  // reference solution, with small slacks so that flips often violate them.
+  void BuildRandomProblem(int num_variables, int num_constraints,
+                          int max_weight) {
+    problem_.Clear();
+    problem_.set_num_variables(num_variables);
+    std::vector<bool> reference_values;
+    for (int var = 0; var < num_variables; ++var) {
+      reference_values.push_back(random_.OneIn(2));
+    }
+    for (int c = 0; c < num_constraints; ++c) {
+      LinearBooleanConstraint* const constraint = problem_.add_constraints();
+      std::vector<int> variables;
+      for (int var = 0; var < num_variables; ++var) variables.push_back(var);
+      for (int i = num_variables - 1; i > 0; --i) {
+        std::swap(variables[i], variables[random_.Uniform(i + 1)]);
+      }
+      const int size = 3 + random_.Uniform(std::min(num_variables - 2, 20));
+      int64 value = 0;
+      for (int i = 0; i < size; ++i) {
+        const int64 weight =
+            (random_.OneIn(2) ? 1 : -1) * (1 + random_.Uniform(max_weight));
+        constraint->add_literals(variables[i] + 1);
+        constraint->add_coefficients(weight);
+        if (reference_values[variables[i]]) value += weight;
+      }
+      if (!random_.OneIn(3)) {
+        constraint->set_lower_bound(value - random_.Uniform(3));
+      }
+      if (!random_.OneIn(3)) {
+        constraint->set_upper_bound(value + random_.Uniform(3));
+      }
+    }
+    LinearObjective* const objective = problem_.mutable_objective();
+    for (int var = 0; var < num_variables; ++var) {
+      if (random_.OneIn(4)) continue;
+      objective->add_literals(var + 1);
+      objective->add_coefficients(1 + random_.Uniform(max_weight));
+    }
+    reference_.reset(new BopSolution(problem_, "Reference"));
+    for (int var = 0; var < num_variables; ++var) {
+      reference_->SetValue(VariableIndex(var), reference_values[var]);
+    }
+    CHECK(reference_->IsFeasible());
+  }
+
+  // Runs a random sequence of flips, backtracks and SAT assignments, and
+  // checks the maintainer and the repairer after each step.
+  void TestRandomSearch(int num_steps) {
+    const int num_variables = problem_.num_variables();
+    Maintainer maintainer(problem_);
+    maintainer.SetReferenceSolution(*reference_);
+    sat::VariablesAssignment sat_assignment(num_variables);
+    OneFlipConstraintRepairer repairer(problem_, maintainer, sat_assignment);
+    CheckRepairBuckets(maintainer);
+    CheckConstraintToRepair(maintainer, sat_assignment, repairer);
+    int num_levels = 0;
+    for (int step = 0; step < num_steps; ++step) {
+      const VariableIndex var(random_.Uniform(num_variables));
+      switch (random_.Uniform(4)) {
+        case 0:
+          if (num_levels > 0) {
+            maintainer.BacktrackOneLevel();
+            --num_levels;
+          }
+          break;
+        case 1: {
+          // The SAT propagator assignment only changes which repairs the
+          // repairer may use.
+          const sat::Literal literal(sat::VariableIndex(var.value()),
+                                     random_.OneIn(2));
+          if (sat_assignment.IsVariableAssigned(literal.Variable())) {
+            sat_assignment.UnassignLiteral(
+                sat_assignment.IsLiteralTrue(literal) ? literal
+                                                      : literal.Negated());
+          } else {
+            sat_assignment.AssignFromTrueLiteral(literal);
+          }
+          break;
+        }
+        default:
+          // A variable can only be flipped once from the reference.
+          if (maintainer.Assignment(var) != reference_->Value(var)) break;
+          if (random_.OneIn(2) || num_levels == 0) {
+            maintainer.AddBacktrackingLevel();
+            ++num_levels;
+          }
+          maintainer.Assign({sat::Literal(sat::VariableIndex(var.value()),
+                                          !maintainer.Assignment(var))});
+      }
+      CheckRepairBuckets(maintainer);
+      CheckConstraintToRepair(maintainer, sat_assignment, repairer);
+    }
+  }
+
+  // Checks the replacement policy of TranspositionTable on a single bucket:
+  // in a full bucket, the deepest entry is replaced, and after a new
+  // generation, the stale entries are replaced before the current ones.
+  void TestTranspositionTableBucket() {
+    const int kNumEntries = TranspositionTable::kNumEntriesPerBucket;
+    TranspositionTable table;
+    table.Resize(0);
+    CHECK_EQ(1, table.num_buckets());
+    table.NewGeneration();
+    std::vector<uint64> hashes;
+    for (int i = 0; i < 3 * kNumEntries; ++i) hashes.push_back(NewHash());
+    for (int i = 0; i < kNumEntries; ++i) {
+      CHECK(table.Insert(hashes[i], 1 + i));
+      CHECK(!table.Insert(hashes[i], 1 + i));
+    }
+    CHECK(table.Insert(hashes[kNumEntries], 1));
+    for (int i = 0; i <= kNumEntries; ++i) {
+      CHECK_EQ(i != kNumEntries - 1, table.Contains(hashes[i]));
+    }
+
+    // The new entries are deeper than the stale ones, but replace them.
+    table.NewGeneration();
+    for (int i = 0; i <= kNumEntries; ++i) CHECK(!table.Contains(hashes[i]));
+    for (int i = 0; i < kNumEntries; ++i) {
+      CHECK(table.Insert(hashes[2 * kNumEntries + i], 100 - i));
+    }
+    for (int i = 0; i < kNumEntries; ++i) {
+      CHECK(table.Contains(hashes[2 * kNumEntries + i]));
+    }
+
+    // A hash of a previous generation is inserted again.
+    CHECK(table.Insert(hashes[0], 1));
+    CHECK(table.Contains(hashes[0]));
+    CHECK(!table.Contains(hashes[2 * kNumEntries]));
+  }
+
+  // Inserts random hashes in a table of several buckets during several
+  // generations, and checks that a hash is found iff it was inserted in the
+  // current generation and its bucket did not overflow, and that the
+  // shallowest entry of an overflowing bucket is kept.
+  void TestTranspositionTable(int64 max_memory_in_bytes, int num_generations,
+                              int num_inserts_per_generation) {
+    const int kNumEntries = TranspositionTable::kNumEntriesPerBucket;
+    TranspositionTable table;
+    table.Resize(max_memory_in_bytes);
+    const int64 num_buckets = table.num_buckets();
+    CHECK_LE(num_buckets * kNumEntries * sizeof(uint64), max_memory_in_bytes);
+    CHECK_GT(2 * num_buckets * kNumEntries * sizeof(uint64),
+             max_memory_in_bytes);
+    std::vector<uint64> previous_hashes;
+    for (int generation = 0; generation < num_generations; ++generation) {
+      table.NewGeneration();
+      std::vector<std::vector<uint64>> inserted(num_buckets);
+      std::vector<uint64> hashes;
+      for (int i = 0; i < num_inserts_per_generation; ++i) {
+        // Some hashes of the previous generation are inserted again.
+        const uint64 hash = !previous_hashes.empty() && random_.OneIn(4)
+                                ? previous_hashes[random_.Uniform(
+                                      previous_hashes.size())]
+                                : NewHash();
+        std::vector<uint64>* const bucket =
+            &inserted[hash & (num_buckets - 1)];
+        const bool is_new =
+            std::find(bucket->begin(), bucket->end(), hash) == bucket->end();
+        // The first entry of each bucket is the shallowest one.
+        const int depth = bucket->empty() ? 1 : 2 + random_.Uniform(300);
+        if (bucket->size() < kNumEntries) {
+          CHECK_EQ(is_new, table.Insert(hash, depth));
+        } else {
+          table.Insert(hash, depth);
+        }
+        if (is_new) bucket->push_back(hash);
+        hashes.push_back(hash);
+      }
+      for (const std::vector<uint64>& bucket : inserted) {
+        for (int i = 0; i < bucket.size(); ++i) {
+          if (bucket.size() <= kNumEntries || i == 0) {
+            CHECK(table.Contains(bucket[i]));
+          }
+        }
+      }
+      for (const uint64 hash : previous_hashes) {
+        const std::vector<uint64>& bucket = inserted[hash & (num_buckets - 1)];
+        if (std::find(bucket.begin(), bucket.end(), hash) == bucket.end()) {
+          CHECK(!table.Contains(hash));
+        }
+      }
+      previous_hashes = hashes;
+    }
+  }
+
+ private:
+  uint64 NewHash() { return Hash64NumWithSeed(++num_hashes_, 0x12345678); }
+
+  // Returns the number of variables of the given constraint, which are not
+  // assigned in sat_assignment if it is not null, whose flip would make the
+  // constraint feasible.
+  int CountOneFlipRepairs(const Maintainer& maintainer, ConstraintIndex ct,
+                          const sat::VariablesAssignment* sat_assignment) {
+    if (ct == Maintainer::kObjectiveConstraint) {
+      return CountOneFlipRepairs(maintainer, ct, problem_.objective(),
+                                 sat_assignment);
+    }
+    return CountOneFlipRepairs(maintainer, ct,
+                               problem_.constraints(ct.value() - 1),
+                               sat_assignment);
+  }
+
+  // Same, given the linear terms of the constraint or of the objective.
+  template <typename LinearTerms>
+  static int CountOneFlipRepairs(
+      const Maintainer& maintainer, ConstraintIndex ct,
+      const LinearTerms& terms,
+      const sat::VariablesAssignment* sat_assignment) {
+    const int64 value = maintainer.ConstraintValue(ct);
+    int num_repairs = 0;
+    for (int i = 0; i < terms.literals_size(); ++i) {
+      const VariableIndex var(terms.literals(i) - 1);
+      if (sat_assignment != nullptr &&
+          sat_assignment->IsVariableAssigned(sat::VariableIndex(var.value()))) {
+        continue;
+      }
+      const int64 new_value =
+          value + (maintainer.Assignment(var) ? -terms.coefficients(i)
+                                              : terms.coefficients(i));
+      if (new_value >= maintainer.ConstraintLowerBound(ct) &&
+          new_value <= maintainer.ConstraintUpperBound(ct)) {
+        ++num_repairs;
+      }
+    }
+    return num_repairs;
+  }
+
+  // Returns the bucket of the given constraint, or -1 if it is in none.
+  static int BucketOf(const Maintainer& maintainer, ConstraintIndex ct) {
+    int bucket_of_ct = -1;
+    for (int bucket = 0; bucket <= Maintainer::kMaxNumOneFlipRepairs;
+         ++bucket) {
+      for (const ConstraintIndex other :
+           maintainer.InfeasibleConstraintsWithNumRepairs(bucket)) {
+        if (other != ct) continue;
+        CHECK_EQ(-1, bucket_of_ct);
+        bucket_of_ct = bucket;
+      }
+    }
+    return bucket_of_ct;
+  }
+
+  // Checks that the infeasible constraints other than the objective, and
+  // only them, are in the bucket of their number of one-flip repairs.
+  void CheckRepairBuckets(const Maintainer& maintainer) {
+    int num_bucketed_constraints = 0;
+    for (ConstraintIndex ct(1); ct < maintainer.NumConstraints(); ++ct) {
+      int expected_bucket = -1;
+      if (!maintainer.ConstraintIsFeasible(ct)) {
+        expected_bucket =
+            std::min<int>(Maintainer::kMaxNumOneFlipRepairs,
+                          CountOneFlipRepairs(maintainer, ct, nullptr));
+        ++num_bucketed_constraints;
+      }
+      CHECK_EQ(expected_bucket, BucketOf(maintainer, ct));
+    }
+    CHECK_EQ(-1, BucketOf(maintainer, Maintainer::kObjectiveConstraint));
+    int num_constraints_in_buckets = 0;
+    for (int bucket = 0; bucket <= Maintainer::kMaxNumOneFlipRepairs;
+         ++bucket) {
+      num_constraints_in_buckets +=
+          maintainer.InfeasibleConstraintsWithNumRepairs(bucket).size();
+    }
+    CHECK_EQ(num_bucketed_constraints, num_constraints_in_buckets);
+  }
+
+  // Checks the order documented in OneFlipConstraintRepairer: the only
+  // infeasible constraint is returned unchecked, otherwise the returned
+  // constraint is one of the repairable constraints other than the objective
+  // with the fewest one-flip repairs as counted by the maintainer, and the
+  // objective is only returned if no other constraint is repairable.
+  void CheckConstraintToRepair(const Maintainer& maintainer,
+                               const sat::VariablesAssignment& sat_assignment,
+                               const OneFlipConstraintRepairer& repairer) {
+    const ConstraintIndex selected_ct = repairer.ConstraintToRepair();
+    std::vector<ConstraintIndex> infeasible_constraints;
+    for (ConstraintIndex ct(0); ct < maintainer.NumConstraints(); ++ct) {
+      if (!maintainer.ConstraintIsFeasible(ct)) {
+        infeasible_constraints.push_back(ct);
+      }
+    }
+    CHECK_EQ(infeasible_constraints.size(),
+             maintainer.NumInfeasibleConstraints());
+    if (infeasible_constraints.empty()) {
+      CHECK_EQ(OneFlipConstraintRepairer::kInvalidConstraint, selected_ct);
+      return;
+    }
+    if (infeasible_constraints.size() == 1) {
+      CHECK_EQ(infeasible_constraints[0], selected_ct);
+      return;
+    }
+    int min_bucket = Maintainer::kMaxNumOneFlipRepairs + 1;
+    bool objective_is_repairable = false;
+    for (const ConstraintIndex ct : infeasible_constraints) {
+      if (CountOneFlipRepairs(maintainer, ct, &sat_assignment) == 0) continue;
+      if (ct == Maintainer::kObjectiveConstraint) {
+        objective_is_repairable = true;
+      } else {
+        min_bucket = std::min(min_bucket, BucketOf(maintainer, ct));
+      }
+    }
+    if (min_bucket <= Maintainer::kMaxNumOneFlipRepairs) {
+      CHECK_NE(Maintainer::kObjectiveConstraint, selected_ct);
+      CHECK_LT(0, CountOneFlipRepairs(maintainer, selected_ct,
+                                      &sat_assignment));
+      CHECK_EQ(min_bucket, BucketOf(maintainer, selected_ct));
+    } else if (objective_is_repairable) {
+      CHECK_EQ(Maintainer::kObjectiveConstraint, selected_ct);
+    } else {
+      CHECK_EQ(OneFlipConstraintRepairer::kInvalidConstraint, selected_ct);
+    }
+  }
+
+  ACMRandom random_;
+  LinearBooleanProblem problem_;
+  std::unique_ptr<BopSolution> reference_;
+  uint64 num_hashes_ = 0;
+};
+
+}  // namespace bop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::bop::BopLsTest test;
+  for (int i = 0; i < 100; ++i) {
+    test.BuildRandomProblem(5, 3, 2);
+    test.TestRandomSearch(200);
+    test.BuildRandomProblem(30, 12, 3);
+    test.TestRandomSearch(500);
+    // With many terms with the same weight, some constraints have more than
+    // kMaxNumOneFlipRepairs repairs.
+    test.BuildRandomProblem(60, 20, 1);
+    test.TestRandomSearch(500);
+  }
+  test.TestTranspositionTableBucket();
+  test.TestTranspositionTable(1000, 10, 50);
+  test.TestTranspositionTable(1 << 16, 300, 4000);
+  return 0;
+}
@@ -0,0 +1,194 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that BopSolver, with one solver and with several solvers using each
+// synchronization type, proves the same optimal objective on random linear
+// Boolean problems, which is also the one found by enumerating all the
+// assignments, and that it proves the infeasible problems infeasible.
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "bop/bop_parameters.pb.h"
+#include "bop/bop_solver.h"
+#include "bop/bop_types.h"
+#include "sat/boolean_problem.pb.h"
+
+namespace operations_research {
+namespace bop {
+
+class BopSolverTest {
+ public:
+  BopSolverTest() : random_(12345) {}
+
+  // Builds a random problem with the given number of variables and
+  // constraints, with positive literals only, as BopSolution requires, and
+  // coefficients of both signs. The constraints are satisfied by a random
+  // hidden assignment, so the problem is feasible, unless infeasible is true
+  // in which case two contradictory constraints are added.
+  void BuildRandomProblem(int num_variables, int num_constraints,
+                          bool infeasible) {
+    problem_.Clear();
+    problem_.set_num_variables(num_variables);
+    std::vector<bool> hidden_assignment;
+    for (int var = 0; var < num_variables; ++var) {
+      hidden_assignment.push_back(random_.OneIn(2));
+    }
+    for (int c = 0; c < num_constraints; ++c) {
+      LinearBooleanConstraint* const constraint = problem_.add_constraints();
+      int64 value = 0;
+      int64 sum_of_magnitudes = 0;
+      for (int var = 0; var < num_variables; ++var) {
+        if (!random_.OneIn(3)) continue;
+        const int64 coefficient =
+            (random_.OneIn(2) ? 1 : -1) * (1 + random_.Uniform(10));
+        constraint->add_literals(var + 1);
+        constraint->add_coefficients(coefficient);
+        sum_of_magnitudes += std::abs(coefficient);
+        if (hidden_assignment[var]) value += coefficient;
+      }
+      const int64 slack = random_.Uniform(1 + sum_of_magnitudes / 4);
+      if (random_.OneIn(2)) {
+        constraint->set_lower_bound(value - slack);
+      } else {
+        constraint->set_upper_bound(value + slack);
+      }
+    }
+    if (infeasible) {
+      LinearBooleanConstraint* const at_least = problem_.add_constraints();
+      LinearBooleanConstraint* const at_most = problem_.add_constraints();
+      for (int var = 0; var < num_variables; ++var) {
+        at_least->add_literals(var + 1);
+        at_least->add_coefficients(1);
+        at_most->add_literals(var + 1);
+        at_most->add_coefficients(1);
+      }
+      const int64 bound = random_.Uniform(num_variables + 1);
+      at_least->set_lower_bound(bound + 1);
+      at_most->set_upper_bound(bound);
+    }
+    LinearObjective* const objective = problem_.mutable_objective();
+    for (int var = 0; var < num_variables; ++var) {
+      objective->add_literals(var + 1);
+      objective->add_coefficients((random_.OneIn(2) ? 1 : -1) *
+                                  (1 + random_.Uniform(100)));
+    }
+  }
+
+  // Returns the optimal objective value of the problem, or kint64max if it
+  // is infeasible, by enumerating all the assignments.
+  int64 BruteForceOptimalCost() const {
+    int64 best_cost = kint64max;
+    for (uint32 assignment = 0;
+         assignment < (uint32{1} << problem_.num_variables()); ++assignment) {
+      bool feasible = true;
+      for (const LinearBooleanConstraint& constraint : problem_.constraints()) {
+        const int64 value = Evaluate(assignment, constraint);
+        if ((constraint.has_lower_bound() &&
+             value < constraint.lower_bound()) ||
+            (constraint.has_upper_bound() &&
+             value > constraint.upper_bound())) {
+          feasible = false;
+          break;
+        }
+      }
+      if (!feasible) continue;
+      best_cost =
+          std::min(best_cost, Evaluate(assignment, problem_.objective()));
+    }
+    return best_cost;
+  }
+
+  // Solves the problem with the given parameters, and returns the optimal
+  // cost, or kint64max if it is infeasible.
+  int64 Solve(int number_of_solvers,
+              BopParameters::ThreadSynchronizationType synchronization_type,
+              bool use_dedicated_lp_solver) {
+    BopParameters parameters;
+    parameters.set_max_time_in_seconds(120.0);
+    parameters.set_number_of_solvers(number_of_solvers);
+    parameters.set_synchronization_type(synchronization_type);
+    parameters.set_use_dedicated_lp_solver(use_dedicated_lp_solver);
+    BopSolver solver(problem_);
+    solver.SetParameters(parameters);
+    const BopSolveStatus status = solver.Solve();
+    if (status == BopSolveStatus::INFEASIBLE_PROBLEM) return kint64max;
+    CHECK(status == BopSolveStatus::OPTIMAL_SOLUTION_FOUND);
+    CHECK(solver.best_solution().IsFeasible());
+    return solver.best_solution().GetCost();
+  }
+
+  void TestRandomProblem(int num_variables, int num_constraints,
+                         bool infeasible) {
+    BuildRandomProblem(num_variables, num_constraints, infeasible);
+    const int64 expected_cost =
+        Solve(1, BopParameters::NO_SYNCHRONIZATION, false);
+    if (infeasible) CHECK_EQ(kint64max, expected_cost);
+    if (num_variables <= kMaxBruteForceVariables) {
+      CHECK_EQ(BruteForceOptimalCost(), expected_cost);
+    }
+    for (const BopParameters::ThreadSynchronizationType synchronization_type :
+         {BopParameters::NO_SYNCHRONIZATION, BopParameters::SYNCHRONIZE_ALL,
+          BopParameters::SYNCHRONIZE_ON_RIGHT,
+          BopParameters::SYNCHRONIZE_ASYNCHRONOUSLY}) {
+      for (const int number_of_solvers : {2, 4}) {
+        for (const bool use_dedicated_lp_solver : {false, true}) {
+          CHECK_EQ(expected_cost, Solve(number_of_solvers, synchronization_type,
+                                        use_dedicated_lp_solver));
+        }
+      }
+    }
+  }
+
+ private:
+  // Returns the value of the linear terms of a constraint or of the
+  // objective under the given assignment, whose bit i is the value of the
+  // variable i.
+  template <typename LinearTerms>
+  static int64 Evaluate(uint32 assignment, const LinearTerms& terms) {
+    int64 value = 0;
+    for (int i = 0; i < terms.literals_size(); ++i) {
+      if ((assignment >> (terms.literals(i) - 1)) & 1) {
+        value += terms.coefficients(i);
+      }
+    }
+    return value;
+  }
+
+  static const int kMaxBruteForceVariables = 16;
+
+  ACMRandom random_;
+  LinearBooleanProblem problem_;
+};
+
+}  // namespace bop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::bop::BopSolverTest test;
+  for (int i = 0; i < 10; ++i) {
+    test.TestRandomProblem(1 + i, 1 + i % 3, false);
+    test.TestRandomProblem(12, 6, false);
+    test.TestRandomProblem(16, 10, false);
+    test.TestRandomProblem(16, 4, true);
+    // Larger problems, only checked against the single solver.
+    test.TestRandomProblem(40, 20, false);
+  }
+  return 0;
+}
@@ -0,0 +1,243 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks BitsetCliqueFinder, with 1 to 3 threads, on random graphs: its
+// maximal cliques against the ones of FindCliques(), its maximum clique
+// against the largest of them, its degeneracy ordering against a brute-force
+// computation of the degeneracy, and that its arc cover only reports maximal
+// cliques and covers all the arcs.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/cliques.h"
+
+namespace operations_research {
+
+class CliquesTest {
+ public:
+  CliquesTest() : random_(12345) {}
+
+  // Builds a random graph where each arc exists with the given probability,
+  // plus some planted cliques so that there are large maximal cliques.
+  void BuildRandomGraph(int num_nodes, double density, int num_planted) {
+    num_nodes_ = num_nodes;
+    adjacency_.assign(num_nodes, std::vector<bool>(num_nodes, false));
+    for (int i = 0; i < num_nodes; ++i) {
+      for (int j = i + 1; j < num_nodes; ++j) {
+        if (random_.RndDouble() < density) AddArc(i, j);
+      }
+    }
+    for (int k = 0; k < num_planted; ++k) {
+      std::vector<int> clique;
+      const int size = 2 + random_.Uniform(std::max(1, num_nodes / 4));
+      for (int i = 0; i < size; ++i) {
+        clique.push_back(random_.Uniform(num_nodes));
+      }
+      for (const int a : clique) {
+        for (const int b : clique) {
+          if (a != b) AddArc(a, b);
+        }
+      }
+    }
+    finder_.reset(new BitsetCliqueFinder(num_nodes));
+    for (int i = 0; i < num_nodes; ++i) {
+      // Self-loops must be ignored.
+      if (random_.Uniform(10) == 0) finder_->AddArc(i, i);
+      for (int j = i + 1; j < num_nodes; ++j) {
+        if (adjacency_[i][j]) finder_->AddArc(i, j);
+      }
+    }
+    for (int i = 0; i < num_nodes; ++i) {
+      int degree = 0;
+      for (int j = 0; j < num_nodes; ++j) {
+        CHECK_EQ(adjacency_[i][j], finder_->IsArc(i, j));
+        if (adjacency_[i][j]) ++degree;
+      }
+      CHECK_EQ(degree, finder_->Degree(i));
+    }
+  }
+
+  void TestMaximalCliques(int num_threads) {
+    std::vector<std::vector<int>> expected;
+    cliques_ = &expected;
+    FindCliques(NewPermanentCallback(this, &CliquesTest::IsArc), num_nodes_,
+                NewPermanentCallback(this, &CliquesTest::AddClique));
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<std::vector<int>> cliques;
+    finder_->SetNumThreads(num_threads);
+    CHECK(BronKerboschAlgorithmStatus::COMPLETED ==
+          finder_->FindMaximalCliques([&cliques](const std::vector<int>& c) {
+            cliques.push_back(c);
+            std::sort(cliques.back().begin(), cliques.back().end());
+            return CliqueResponse::CONTINUE;
+          }));
+    std::sort(cliques.begin(), cliques.end());
+    CHECK(expected == cliques);
+
+    // Stopping after the first clique.
+    if (!expected.empty()) {
+      int num_calls = 0;
+      CHECK(BronKerboschAlgorithmStatus::INTERRUPTED ==
+            finder_->FindMaximalCliques([&num_calls](const std::vector<int>&) {
+              ++num_calls;
+              return CliqueResponse::STOP;
+            }));
+      CHECK_EQ(1, num_calls);
+    }
+
+    // The maximum clique is a clique, as large as the largest maximal one.
+    int max_size = 0;
+    for (const std::vector<int>& clique : expected) {
+      max_size = std::max<int>(max_size, clique.size());
+    }
+    const std::vector<int> maximum_clique = finder_->FindMaximumClique();
+    CHECK_EQ(max_size, maximum_clique.size());
+    CHECK(std::is_sorted(maximum_clique.begin(), maximum_clique.end()));
+    CHECK(IsClique(maximum_clique));
+  }
+
+  void TestDegeneracyOrdering() {
+    // Brute force: the degeneracy is the largest minimum degree of the
+    // subgraphs left by repeatedly removing a node of minimum degree.
+    std::vector<bool> removed(num_nodes_, false);
+    int expected_degeneracy = 0;
+    for (int step = 0; step < num_nodes_; ++step) {
+      int min_degree = num_nodes_;
+      int min_node = -1;
+      for (int i = 0; i < num_nodes_; ++i) {
+        if (removed[i]) continue;
+        int degree = 0;
+        for (int j = 0; j < num_nodes_; ++j) {
+          if (!removed[j] && adjacency_[i][j]) ++degree;
+        }
+        if (degree < min_degree) {
+          min_degree = degree;
+          min_node = i;
+        }
+      }
+      expected_degeneracy = std::max(expected_degeneracy, min_degree);
+      removed[min_node] = true;
+    }
+
+    int degeneracy = -1;
+    const std::vector<int> ordering = finder_->DegeneracyOrdering(&degeneracy);
+    CHECK_EQ(expected_degeneracy, degeneracy);
+    CHECK_EQ(num_nodes_, ordering.size());
+    std::vector<int> position(num_nodes_, -1);
+    for (int i = 0; i < num_nodes_; ++i) {
+      CHECK_EQ(-1, position[ordering[i]]);
+      position[ordering[i]] = i;
+    }
+    for (int i = 0; i < num_nodes_; ++i) {
+      int num_later_neighbors = 0;
+      for (int j = 0; j < num_nodes_; ++j) {
+        if (adjacency_[i][j] && position[j] > position[i]) {
+          ++num_later_neighbors;
+        }
+      }
+      CHECK_LE(num_later_neighbors, degeneracy);
+    }
+  }
+
+  void TestCoverArcsByCliques() {
+    std::vector<std::vector<bool>> covered(num_nodes_,
+                                           std::vector<bool>(num_nodes_));
+    CHECK(BronKerboschAlgorithmStatus::COMPLETED ==
+          finder_->CoverArcsByCliques([this, &covered](
+              const std::vector<int>& clique) {
+            CHECK_LE(2, clique.size());
+            CHECK(IsClique(clique));
+            CHECK(IsMaximal(clique));
+            for (const int a : clique) {
+              for (const int b : clique) covered[a][b] = true;
+            }
+            return CliqueResponse::CONTINUE;
+          }));
+    for (int i = 0; i < num_nodes_; ++i) {
+      for (int j = 0; j < num_nodes_; ++j) {
+        if (adjacency_[i][j]) CHECK(covered[i][j]);
+      }
+    }
+  }
+
+ private:
+  void AddArc(int i, int j) {
+    adjacency_[i][j] = true;
+    adjacency_[j][i] = true;
+  }
+
+  bool IsArc(int i, int j) { return adjacency_[i][j]; }
+
+  bool AddClique(const std::vector<int>& clique) {
+    cliques_->push_back(clique);
+    std::sort(cliques_->back().begin(), cliques_->back().end());
+    return false;
+  }
+
+  bool IsClique(const std::vector<int>& clique) const {
+    for (const int a : clique) {
+      for (const int b : clique) {
+        if (a != b && !adjacency_[a][b]) return false;
+      }
+    }
+    return true;
+  }
+
+  bool IsMaximal(const std::vector<int>& clique) const {
+    for (int node = 0; node < num_nodes_; ++node) {
+      bool extends = true;
+      for (const int a : clique) {
+        if (a == node || !adjacency_[a][node]) {
+          extends = false;
+          break;
+        }
+      }
+      if (extends) return false;
+    }
+    return true;
+  }
+
+  ACMRandom random_;
+  int num_nodes_;
+  std::vector<std::vector<bool>> adjacency_;
+  std::unique_ptr<BitsetCliqueFinder> finder_;
+  std::vector<std::vector<int>>* cliques_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::CliquesTest test;
+  const double kDensities[] = {0.0, 0.05, 0.2, 0.5, 0.8};
+  for (int i = 0; i < 400; ++i) {
+    // Some sparser graphs span several words of the bitsets.
+    const bool large = i % 10 == 1 || i % 10 == 7;
+    const int num_nodes = large ? 65 + i % 80 : 1 + i % 50;
+    test.BuildRandomGraph(num_nodes, kDensities[i % 5], i % 3);
+    for (int num_threads = 1; num_threads <= 3; ++num_threads) {
+      test.TestMaximalCliques(num_threads);
+    }
+    test.TestDegeneracyOrdering();
+    test.TestCoverArcsByCliques();
+  }
+  return 0;
+}
@@ -0,0 +1,139 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that CompactSparseMatrix::PopulateFromSparseMatrixAndAddSlacks()
+// builds the same matrix as PopulateFromMatrixView() on [A | I], and that the
+// lp_utils functions return the same results on its columns as on the
+// corresponding SparseColumn.
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "lp_data/lp_utils.h"
+#include "lp_data/sparse.h"
+
+namespace operations_research {
+namespace glop {
+
+class CompactSparseMatrixTest {
+ public:
+  CompactSparseMatrixTest() : random_(12345) {}
+
+  // Fills a random matrix with about the given density. Some columns are
+  // left empty.
+  void FillRandomMatrix(RowIndex num_rows, ColIndex num_cols, double density,
+                        SparseMatrix* matrix) {
+    matrix->PopulateFromZero(num_rows, num_cols);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      for (RowIndex row(0); row < num_rows; ++row) {
+        if (random_.RndDouble() >= density) continue;
+        const Fractional value = random_.RndDouble() * 20.0 - 10.0;
+        matrix->mutable_column(col)->SetCoefficient(row, value);
+      }
+    }
+  }
+
+  // Checks that the given column view has the same entries, in the same
+  // order, and the same lp_utils results as the given SparseColumn.
+  void CheckSameColumn(const SparseColumn& expected, RowIndex num_rows,
+                       const CompactSparseMatrix::ColumnView& view) {
+    CHECK_EQ(expected.num_entries(), view.num_entries());
+    EntryIndex i(0);
+    for (const CompactSparseMatrix::ColumnView::Entry e : view) {
+      CHECK_EQ(expected.EntryRow(i), e.row());
+      CHECK_EQ(expected.EntryCoefficient(i), e.coefficient());
+      CHECK_EQ(view.EntryRow(i), e.row());
+      CHECK_EQ(view.EntryCoefficient(i), e.coefficient());
+      ++i;
+    }
+    CHECK_EQ(expected.num_entries(), i);
+    CHECK_EQ(expected.IsEmpty(), view.IsEmpty());
+    if (!expected.IsEmpty()) {
+      CHECK_EQ(expected.GetFirstRow(), view.GetFirstRow());
+      CHECK_EQ(expected.GetFirstCoefficient(), view.GetFirstCoefficient());
+    }
+    for (RowIndex row(0); row < num_rows; ++row) {
+      CHECK_EQ(expected.LookUpCoefficient(row), view.LookUpCoefficient(row));
+    }
+
+    CHECK_EQ(SquaredNorm(expected), SquaredNorm(view));
+    CHECK_EQ(InfinityNorm(expected), InfinityNorm(view));
+
+    // Only consider every other row.
+    DenseBooleanColumn rows_to_consider(num_rows, false);
+    for (RowIndex row(0); row < num_rows; row += 2) {
+      rows_to_consider[row] = true;
+    }
+    RowIndex expected_row(-1);
+    RowIndex row(-1);
+    CHECK_EQ(RestrictedInfinityNorm(expected, rows_to_consider, &expected_row),
+             RestrictedInfinityNorm(view, rows_to_consider, &row));
+    CHECK_EQ(expected_row, row);
+
+    DenseBooleanColumn expected_support(num_rows, true);
+    DenseBooleanColumn support(num_rows, true);
+    SetSupportToFalse(expected, &expected_support);
+    SetSupportToFalse(view, &support);
+    CHECK(expected_support == support);
+
+    const DenseColumn small_radius(num_rows, 5.0);
+    const DenseColumn large_radius(num_rows, 10.0);
+    CHECK_EQ(IsDominated(expected, small_radius),
+             IsDominated(view, small_radius));
+    CHECK(IsDominated(view, large_radius));
+  }
+
+  void TestSameAsMatrixViewWithIdentity(RowIndex num_rows, ColIndex num_cols,
+                                        double density) {
+    SparseMatrix matrix;
+    FillRandomMatrix(num_rows, num_cols, density, &matrix);
+    SparseMatrix identity;
+    identity.PopulateFromIdentity(RowToColIndex(num_rows));
+    MatrixView view;
+    view.PopulateFromMatrixPair(matrix, identity);
+    CompactSparseMatrix expected;
+    expected.PopulateFromMatrixView(view);
+
+    CompactSparseMatrix compact_matrix;
+    compact_matrix.PopulateFromSparseMatrixAndAddSlacks(matrix);
+    CHECK_EQ(expected.num_rows(), compact_matrix.num_rows());
+    CHECK_EQ(expected.num_cols(), compact_matrix.num_cols());
+    CHECK_EQ(expected.num_entries(), compact_matrix.num_entries());
+    CHECK_EQ(num_cols + RowToColIndex(num_rows), compact_matrix.num_cols());
+    for (ColIndex col(0); col < compact_matrix.num_cols(); ++col) {
+      CHECK_EQ(expected.ColumnNumEntries(col),
+               compact_matrix.ColumnNumEntries(col));
+      CheckSameColumn(view.column(col), num_rows, compact_matrix.column(col));
+    }
+  }
+
+ private:
+  ACMRandom random_;
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  using operations_research::glop::ColIndex;
+  using operations_research::glop::RowIndex;
+  operations_research::glop::CompactSparseMatrixTest test;
+  test.TestSameAsMatrixViewWithIdentity(RowIndex(0), ColIndex(0), 0.5);
+  test.TestSameAsMatrixViewWithIdentity(RowIndex(0), ColIndex(3), 0.5);
+  test.TestSameAsMatrixViewWithIdentity(RowIndex(5), ColIndex(0), 0.5);
+  for (const double density : {0.0, 0.1, 0.5, 1.0}) {
+    test.TestSameAsMatrixViewWithIdentity(RowIndex(30), ColIndex(50), density);
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the distances computed with a ContractionHierarchy, by point-to-point
+// queries and by distance tables with several thread counts, against plain
+// Dijkstra searches on random graphs, before and after a Write()/Open() round
+// trip.
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/contraction_hierarchy.h"
+#include "graph/graph.h"
+#include "graph/shortest_path_search.h"
+
+DEFINE_string(hierarchy_file, "/tmp/contraction_hierarchy_test.ch",
+              "File used to check ContractionHierarchy::Write() and Open().");
+
+namespace operations_research {
+
+class ContractionHierarchyTest {
+ public:
+  typedef ContractionHierarchy::Graph Graph;
+  typedef ContractionHierarchy::NodeIndex NodeIndex;
+
+  ContractionHierarchyTest() : random_(12345) {}
+
+  // Builds a random road-like graph: a grid with arcs in both directions and
+  // random lengths, some missing arcs, and a few long-range arcs. If
+  // num_extra_nodes > 0, that many isolated or one-way nodes are added so that
+  // some distances are kUnreachableDistance.
+  void BuildRandomGraph(int width, int height, int num_extra_nodes) {
+    const int num_grid_nodes = width * height;
+    const int num_nodes = num_grid_nodes + num_extra_nodes;
+    graph_.reset(new Graph(num_nodes, 4 * num_nodes));
+    arc_lengths_.clear();
+    for (int x = 0; x < width; ++x) {
+      for (int y = 0; y < height; ++y) {
+        const NodeIndex node = x * height + y;
+        if (x + 1 < width) AddRandomArcs(node, node + height);
+        if (y + 1 < height) AddRandomArcs(node, node + 1);
+      }
+    }
+    for (int i = 0; i < num_grid_nodes / 10; ++i) {
+      AddArc(random_.Uniform(num_grid_nodes), random_.Uniform(num_grid_nodes),
+             random_.Uniform(1000));
+    }
+    for (int i = 0; i < num_extra_nodes; ++i) {
+      // One-way nodes: only reachable, or only able to reach the grid.
+      const NodeIndex node = num_grid_nodes + i;
+      if (i % 3 == 1) AddArc(random_.Uniform(num_grid_nodes), node, 7);
+      if (i % 3 == 2) AddArc(node, random_.Uniform(num_grid_nodes), 7);
+    }
+    std::vector<Graph::ArcIndex> permutation;
+    graph_->Build(&permutation);
+    Permute(permutation, &arc_lengths_);
+  }
+
+  // Checks the point-to-point queries and the distance tables of the given
+  // hierarchy against Dijkstra searches.
+  void CheckHierarchy(const ContractionHierarchy& hierarchy, int num_queries) {
+    const int num_nodes = graph_->num_nodes();
+    CHECK_EQ(num_nodes, hierarchy.num_nodes());
+    ShortestPathSearch<Graph> search(graph_.get(), &arc_lengths_);
+    ContractionHierarchyQuery query(&hierarchy);
+    for (int i = 0; i < num_queries; ++i) {
+      const NodeIndex source = random_.Uniform(num_nodes);
+      const NodeIndex target = random_.Uniform(num_nodes);
+      search.ComputeShortestPath(source, target);
+      CHECK_EQ(search.Distance(target), query.Distance(source, target));
+    }
+
+    std::vector<NodeIndex> sources;
+    std::vector<NodeIndex> targets;
+    for (int i = 0; i < 20; ++i) sources.push_back(random_.Uniform(num_nodes));
+    for (int j = 0; j < 30; ++j) targets.push_back(random_.Uniform(num_nodes));
+    sources.push_back(sources[0]);
+    targets.push_back(targets[0]);
+    std::vector<int64> expected;
+    ComputeShortestPathDistanceMatrix(*graph_, arc_lengths_, sources, targets,
+                                      1, &expected);
+    std::vector<int64> distances;
+    for (const int num_threads : {1, 2, 4}) {
+      hierarchy.ComputeDistanceTable(sources, targets, num_threads,
+                                     &distances);
+      CHECK(expected == distances);
+    }
+    hierarchy.ComputeDistanceTable(sources, std::vector<NodeIndex>(), 2,
+                                   &distances);
+    CHECK(distances.empty());
+  }
+
+  void TestRandomGraph(int width, int height, int num_extra_nodes,
+                       int witness_search_settle_limit) {
+    BuildRandomGraph(width, height, num_extra_nodes);
+    ContractionHierarchy hierarchy;
+    hierarchy.set_witness_search_settle_limit(witness_search_settle_limit);
+    hierarchy.Build(*graph_, arc_lengths_);
+    CheckHierarchy(hierarchy, 200);
+
+    CHECK(hierarchy.Write(FLAGS_hierarchy_file));
+    ContractionHierarchy opened;
+    CHECK(opened.Open(FLAGS_hierarchy_file));
+    CHECK_EQ(hierarchy.num_upward_arcs(), opened.num_upward_arcs());
+    CHECK_EQ(hierarchy.num_downward_arcs(), opened.num_downward_arcs());
+    CheckHierarchy(opened, 200);
+  }
+
+ private:
+  void AddArc(NodeIndex tail, NodeIndex head, int64 length) {
+    graph_->AddArc(tail, head);
+    arc_lengths_.push_back(length);
+  }
+
+  // Adds arcs between a and b, in one direction, both or none, with
+  // possibly different lengths.
+  void AddRandomArcs(NodeIndex a, NodeIndex b) {
+    const int64 length = 1 + random_.Uniform(100);
+    switch (random_.Uniform(8)) {
+      case 0:
+        break;
+      case 1:
+        AddArc(a, b, length);
+        break;
+      case 2:
+        AddArc(a, b, length);
+        AddArc(b, a, 1 + random_.Uniform(100));
+        break;
+      default:
+        AddArc(a, b, length);
+        AddArc(b, a, length);
+        break;
+    }
+  }
+
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<int64> arc_lengths_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::ContractionHierarchyTest test;
+  for (int i = 0; i < 5; ++i) {
+    test.TestRandomGraph(20, 15, 0, 50);
+    test.TestRandomGraph(20, 15, 10, 50);
+    // With a tiny witness search limit, many useless shortcuts are added.
+    test.TestRandomGraph(12, 10, 5, 1);
+  }
+  test.TestRandomGraph(1, 1, 0, 50);
+  test.TestRandomGraph(60, 50, 20, 500);
+  return 0;
+}
@@ -0,0 +1,288 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that GraphSymmetryFinder finds the same symmetries with and without
+// its invariant pre-pass, and with one or several threads, on random graphs
+// with many symmetries: the same orbits, the same automorphism group size,
+// and generators which are automorphisms respecting the given node classes.
+// On the graphs with small automorphism groups, the groups generated by the
+// generators are enumerated and must be identical, and of the size found.
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "algorithms/find_graph_symmetries.h"
+#include "algorithms/sparse_permutation.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/status.h"
+#include "graph/graph.h"
+
+namespace operations_research {
+
+class FindGraphSymmetriesTest {
+ public:
+  typedef GraphSymmetryFinder::Graph Graph;
+  typedef std::vector<int> Permutation;
+
+  // The results of a call to FindSymmetries().
+  struct Symmetries {
+    std::vector<int> node_classes;
+    std::vector<Permutation> generators;
+    std::vector<int> factorized_group_size;
+  };
+
+  FindGraphSymmetriesTest() : random_(12345) {}
+
+  // Builds a graph made of several copies of a random graph, which are
+  // themselves linked by the arcs of another random graph between copies, so
+  // that the automorphisms can permute the copies and act inside them. If
+  // undirected, each arc is added in both directions. Some initial node
+  // classes are set at random.
+  void BuildRandomGraph(int num_copies, int copy_size, double density,
+                        bool undirected, int num_classes) {
+    undirected_ = undirected;
+    const int num_nodes = num_copies * copy_size;
+    std::set<std::pair<int, int>> arcs;
+    std::vector<std::pair<int, int>> copy_arcs;
+    for (int i = 0; i < copy_size; ++i) {
+      for (int j = 0; j < copy_size; ++j) {
+        if (i != j && random_.RndDouble() < density) {
+          copy_arcs.push_back({i, j});
+        }
+      }
+    }
+    std::vector<std::pair<int, int>> links;
+    for (int a = 0; a < num_copies; ++a) {
+      for (int b = 0; b < num_copies; ++b) {
+        if (a != b && random_.RndDouble() < density) links.push_back({a, b});
+      }
+    }
+    const int linked_node = random_.Uniform(copy_size);
+    for (int copy = 0; copy < num_copies; ++copy) {
+      for (const std::pair<int, int>& arc : copy_arcs) {
+        AddArc(copy * copy_size + arc.first, copy * copy_size + arc.second,
+               &arcs);
+      }
+    }
+    for (const std::pair<int, int>& link : links) {
+      AddArc(link.first * copy_size + linked_node,
+             link.second * copy_size + linked_node, &arcs);
+    }
+    graph_.reset(new Graph(num_nodes, arcs.size()));
+    for (const std::pair<int, int>& arc : arcs) {
+      graph_->AddArc(arc.first, arc.second);
+    }
+    graph_->Build();
+    arcs_ = arcs;
+
+    // The classes are the same in each copy, so they keep some symmetries.
+    // FindSymmetries() needs them to be numbered densely from 0.
+    std::vector<int> copy_classes(copy_size);
+    std::map<int, int> dense_class;
+    for (int i = 0; i < copy_size; ++i) {
+      const int random_class = random_.Uniform(num_classes);
+      if (!dense_class.count(random_class)) {
+        const int new_class = dense_class.size();
+        dense_class[random_class] = new_class;
+      }
+      copy_classes[i] = dense_class[random_class];
+    }
+    node_classes_.resize(num_nodes);
+    for (int node = 0; node < num_nodes; ++node) {
+      node_classes_[node] = copy_classes[node % copy_size];
+    }
+  }
+
+  Symmetries FindSymmetries(bool use_invariant_pre_pass, int num_threads) {
+    GraphSymmetryFinder finder(*graph_, undirected_);
+    finder.set_use_invariant_pre_pass(use_invariant_pre_pass);
+    finder.set_num_threads(num_threads);
+    Symmetries symmetries;
+    symmetries.node_classes = node_classes_;
+    std::vector<std::unique_ptr<SparsePermutation>> generators;
+    CHECK(finder.FindSymmetries(1e9, &symmetries.node_classes, &generators,
+                                &symmetries.factorized_group_size).ok());
+    const int num_nodes = graph_->num_nodes();
+    for (const std::unique_ptr<SparsePermutation>& generator : generators) {
+      Permutation permutation(num_nodes);
+      for (int node = 0; node < num_nodes; ++node) permutation[node] = node;
+      for (int c = 0; c < generator->NumCycles(); ++c) {
+        int element = generator->LastElementInCycle(c);
+        for (const int image : generator->Cycle(c)) {
+          permutation[element] = image;
+          element = image;
+        }
+      }
+      symmetries.generators.push_back(permutation);
+    }
+    return symmetries;
+  }
+
+  // Checks that the generators are automorphisms which respect the initial
+  // node classes, and returns the orbits of the nodes as a sorted list of
+  // sorted node lists.
+  std::vector<std::vector<int>> CheckGeneratorsAndGetOrbits(
+      const Symmetries& symmetries) {
+    for (const Permutation& generator : symmetries.generators) {
+      for (int node = 0; node < generator.size(); ++node) {
+        CHECK_EQ(node_classes_[node], node_classes_[generator[node]]);
+      }
+      for (const std::pair<int, int>& arc : arcs_) {
+        CHECK(arcs_.count({generator[arc.first], generator[arc.second]}));
+      }
+    }
+    std::map<int, std::vector<int>> orbit_of_class;
+    for (int node = 0; node < symmetries.node_classes.size(); ++node) {
+      orbit_of_class[symmetries.node_classes[node]].push_back(node);
+    }
+    std::vector<std::vector<int>> orbits;
+    for (const auto& entry : orbit_of_class) orbits.push_back(entry.second);
+    std::sort(orbits.begin(), orbits.end());
+
+    // The orbits are the ones generated by the generators.
+    std::vector<int> orbit_index(graph_->num_nodes());
+    for (int i = 0; i < orbits.size(); ++i) {
+      for (const int node : orbits[i]) orbit_index[node] = i;
+    }
+    std::vector<bool> reached(graph_->num_nodes(), false);
+    for (const std::vector<int>& orbit : orbits) {
+      std::vector<int> to_visit = {orbit[0]};
+      reached[orbit[0]] = true;
+      int num_reached = 0;
+      while (!to_visit.empty()) {
+        const int node = to_visit.back();
+        to_visit.pop_back();
+        ++num_reached;
+        CHECK_EQ(orbit_index[orbit[0]], orbit_index[node]);
+        for (const Permutation& generator : symmetries.generators) {
+          if (!reached[generator[node]]) {
+            reached[generator[node]] = true;
+            to_visit.push_back(generator[node]);
+          }
+        }
+      }
+      CHECK_EQ(orbit.size(), num_reached);
+    }
+    return orbits;
+  }
+
+  // Returns the prime factors of the automorphism group size, sorted.
+  static std::vector<int> PrimeFactorsOfGroupSize(
+      const Symmetries& symmetries) {
+    std::vector<int> primes;
+    for (int factor : symmetries.factorized_group_size) {
+      for (int p = 2; p * p <= factor; ++p) {
+        while (factor % p == 0) {
+          primes.push_back(p);
+          factor /= p;
+        }
+      }
+      if (factor > 1) primes.push_back(factor);
+    }
+    std::sort(primes.begin(), primes.end());
+    return primes;
+  }
+
+  // Returns all the elements of the group generated by the generators, or an
+  // empty set if there are more than max_size of them.
+  std::set<Permutation> EnumerateGroup(const Symmetries& symmetries,
+                                       int max_size) {
+    Permutation identity(graph_->num_nodes());
+    for (int node = 0; node < identity.size(); ++node) identity[node] = node;
+    std::set<Permutation> group = {identity};
+    std::vector<Permutation> to_visit = {identity};
+    while (!to_visit.empty()) {
+      const Permutation element = to_visit.back();
+      to_visit.pop_back();
+      for (const Permutation& generator : symmetries.generators) {
+        Permutation product(element.size());
+        for (int node = 0; node < element.size(); ++node) {
+          product[node] = generator[element[node]];
+        }
+        if (group.insert(product).second) {
+          if (group.size() > max_size) return std::set<Permutation>();
+          to_visit.push_back(product);
+        }
+      }
+    }
+    return group;
+  }
+
+  void TestRandomGraph(int num_copies, int copy_size, double density,
+                       bool undirected, int num_classes) {
+    BuildRandomGraph(num_copies, copy_size, density, undirected, num_classes);
+    const Symmetries expected = FindSymmetries(false, 1);
+    const std::vector<std::vector<int>> expected_orbits =
+        CheckGeneratorsAndGetOrbits(expected);
+    const std::vector<int> expected_primes = PrimeFactorsOfGroupSize(expected);
+    int64 group_size = 1;
+    for (const int p : expected_primes) {
+      group_size = std::min<int64>(kMaxGroupSize + 1, group_size * p);
+    }
+    const std::set<Permutation> expected_group =
+        EnumerateGroup(expected, kMaxGroupSize);
+    if (group_size <= kMaxGroupSize) {
+      CHECK_EQ(group_size, expected_group.size());
+    }
+    for (const bool use_invariant_pre_pass : {false, true}) {
+      for (const int num_threads : {1, 2, 4}) {
+        const Symmetries symmetries =
+            FindSymmetries(use_invariant_pre_pass, num_threads);
+        CHECK(expected_orbits == CheckGeneratorsAndGetOrbits(symmetries));
+        CHECK(expected_primes == PrimeFactorsOfGroupSize(symmetries));
+        if (group_size <= kMaxGroupSize) {
+          CHECK(expected_group == EnumerateGroup(symmetries, kMaxGroupSize));
+        }
+      }
+    }
+  }
+
+ private:
+  static const int kMaxGroupSize = 5000;
+
+  void AddArc(int tail, int head, std::set<std::pair<int, int>>* arcs) {
+    arcs->insert({tail, head});
+    if (undirected_) arcs->insert({head, tail});
+  }
+
+  ACMRandom random_;
+  bool undirected_;
+  std::unique_ptr<Graph> graph_;
+  std::set<std::pair<int, int>> arcs_;
+  std::vector<int> node_classes_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::FindGraphSymmetriesTest test;
+  for (int i = 0; i < 50; ++i) {
+    const bool undirected = i % 2 == 0;
+    test.TestRandomGraph(1, 1 + i % 7, 0.5, undirected, 1);
+    test.TestRandomGraph(2 + i % 4, 2 + i % 5, 0.3, undirected, 1);
+    test.TestRandomGraph(3, 5, 0.4, undirected, 2);
+    test.TestRandomGraph(4, 3, 0.1, undirected, 1);
+    // Larger graphs, whose groups are too large to be enumerated.
+    test.TestRandomGraph(6, 20, 0.1, undirected, 3);
+    test.TestRandomGraph(30, 40, 0.05, undirected, 2);
+  }
+  return 0;
+}
@@ -0,0 +1,240 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the exchange of nogoods and root bounds between the workers of the
+// multi-threaded FlatZinc support: a short nogood, or a root bound tightened
+// by a long nogood, of one worker cuts the search of another worker. Then
+// checks that 4 cooperating workers prove the pigeonhole problems with more
+// pigeons than holes unsatisfiable, and report valid solutions otherwise.
+// The number of branches of the parallel search depends on the thread
+// scheduling, so it is not checked.
+
+#include <iostream>  // NOLINT
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/stringprintf.h"
+#include "base/threadpool.h"
+#include "constraint_solver/constraint_solver.h"
+#include "flatzinc/model.h"
+#include "flatzinc/parser.h"
+#include "flatzinc/presolve.h"
+#include "flatzinc/search.h"
+#include "flatzinc/solver.h"
+
+namespace operations_research {
+
+// Records the minimum of a variable when the first decision is taken, i.e.
+// at the root node, after the monitors added before it have been applied.
+class RootMinRecorder : public SearchMonitor {
+ public:
+  RootMinRecorder(Solver* const s, IntVar* const var)
+      : SearchMonitor(s), var_(var), root_min_(kint64min) {}
+
+  void BeginNextDecision(DecisionBuilder* const db) override {
+    if (root_min_ == kint64min) root_min_ = var_->Min();
+  }
+
+  int64 root_min() const { return root_min_; }
+
+ private:
+  IntVar* const var_;
+  int64 root_min_;
+};
+
+class FzParallelTest {
+ public:
+  // Worker 0 learns the short nogood (x0 == 1 && x1 != 2), and a nogood of
+  // more than 8 terms which removes 0 from x2 at the root node. Worker 1
+  // must import the first one, and the root bound x2 >= 1, but not the
+  // second nogood itself. Both workers then find the same solutions.
+  void TestNoGoodExchange() {
+    std::unique_ptr<FzParallelSupportInterface> support(
+        MakeMtSupport(false, 1, false));
+    Solver s0("worker 0");
+    Solver s1("worker 1");
+    std::vector<IntVar*> x0;
+    std::vector<IntVar*> x1;
+    s0.MakeIntVarArray(kNumVariables, 0, 2, "x", &x0);
+    s1.MakeIntVarArray(kNumVariables, 0, 2, "x", &x1);
+    NoGoodManager* const manager0 = support->NoGoods(&s0, x0, 0);
+    NoGoodManager* const manager1 = support->NoGoods(&s1, x1, 1);
+    CHECK(manager0 != nullptr);
+    CHECK(manager1 != nullptr);
+
+    NoGood* const short_nogood = manager0->MakeNoGood();
+    short_nogood->AddIntegerVariableEqualValueTerm(x0[0], 1);
+    short_nogood->AddIntegerVariableNotEqualValueTerm(x0[1], 2);
+    manager0->AddNoGood(short_nogood);
+    NoGood* const long_nogood = manager0->MakeNoGood();
+    long_nogood->AddIntegerVariableEqualValueTerm(x0[2], 0);
+    for (int i = 0; i < 8; ++i) {
+      // Always true terms, as 3 is not in the domain of x3.
+      long_nogood->AddIntegerVariableNotEqualValueTerm(x0[3], 3);
+    }
+    manager0->AddNoGood(long_nogood);
+
+    // Worker 0 exports the root bound during its search.
+    CHECK_EQ(1, RootMinOfX2(&s0, x0, manager0));
+    CHECK_EQ(kNumExpectedSolutions, CountSolutions(&s0, x0, manager0));
+    CHECK_EQ(2, manager0->NoGoodCount());
+
+    CHECK_EQ(1, RootMinOfX2(&s1, x1, manager1));
+    CHECK_EQ(kNumExpectedSolutions, CountSolutions(&s1, x1, manager1));
+    CHECK_EQ(1, manager1->NoGoodCount());
+
+    // A worker does not import its own nogoods again.
+    CHECK_EQ(kNumExpectedSolutions, CountSolutions(&s0, x0, manager0));
+    CHECK_EQ(2, manager0->NoGoodCount());
+  }
+
+  // Solves the pigeonhole problem with the given number of pigeons and
+  // holes, with the given number of workers, and checks its result.
+  void TestPigeonHole(int num_pigeons, int num_holes, int num_workers) {
+    std::string fzn;
+    for (int p = 0; p < num_pigeons; ++p) {
+      fzn += StringPrintf("var 1..%d: p%d :: output_var;\n", num_holes, p);
+    }
+    for (int p = 0; p < num_pigeons; ++p) {
+      for (int q = p + 1; q < num_pigeons; ++q) {
+        fzn += StringPrintf("constraint int_ne(p%d, p%d);\n", p, q);
+      }
+    }
+    fzn += "solve satisfy;\n";
+    FzModel model("pigeon_hole");
+    CHECK(ParseFlatzincString(fzn, &model));
+    FzPresolver presolve;
+    presolve.CleanUpModelForTheCpSolver(&model, false);
+
+    // The solutions and the final output are printed on std::cout.
+    std::stringstream output;
+    std::streambuf* const cout_buffer = std::cout.rdbuf(output.rdbuf());
+    std::unique_ptr<FzParallelSupportInterface> support(
+        MakeMtSupport(false, 1, false));
+    const FzSolverSharedData shared_data(&model);
+    {
+      ThreadPool pool("Parallel FlatZinc test", num_workers);
+      for (int w = 0; w < num_workers; ++w) {
+        pool.Add(NewCallback(&FzParallelTest::RunWorker, &model, &shared_data,
+                             w, num_workers, support.get()));
+      }
+      pool.StartWorkers();
+    }
+    std::cout.rdbuf(cout_buffer);
+
+    CHECK(!support->Interrupted());
+    const std::string result = output.str();
+    if (num_pigeons > num_holes) {
+      CHECK_EQ(0, support->NumSolutions());
+      CHECK_NE(std::string::npos, result.find("=====UNSATISFIABLE====="));
+      return;
+    }
+    CHECK_LE(1, support->NumSolutions());
+    CHECK_EQ(std::string::npos, result.find("UNSATISFIABLE"));
+    std::set<int> holes;
+    for (int p = 0; p < num_pigeons; ++p) {
+      const std::string prefix = StringPrintf("p%d = ", p);
+      const size_t position = result.find(prefix);
+      CHECK_NE(std::string::npos, position);
+      const int hole = atoi(result.c_str() + position + prefix.size());
+      CHECK_LE(1, hole);
+      CHECK_GE(num_holes, hole);
+      CHECK(holes.insert(hole).second);
+    }
+  }
+
+ private:
+  static const int kNumVariables = 4;
+  // 81 assignments, minus the 27 ones with x2 == 0, and minus the 12 others
+  // with x0 == 1 and x1 != 2.
+  static const int kNumExpectedSolutions = 42;
+
+  static int64 RootMinOfX2(Solver* const s, const std::vector<IntVar*>& x,
+                           NoGoodManager* const manager) {
+    RootMinRecorder* const recorder =
+        s->RevAlloc(new RootMinRecorder(s, x[2]));
+    s->Solve(s->MakePhase(x, Solver::CHOOSE_FIRST_UNBOUND,
+                          Solver::ASSIGN_MIN_VALUE),
+             manager, recorder);
+    return recorder->root_min();
+  }
+
+  // Returns the number of solutions, and checks that they respect both
+  // nogoods.
+  static int CountSolutions(Solver* const s, const std::vector<IntVar*>& x,
+                            NoGoodManager* const manager) {
+    int num_solutions = 0;
+    s->NewSearch(s->MakePhase(x, Solver::CHOOSE_FIRST_UNBOUND,
+                              Solver::ASSIGN_MIN_VALUE),
+                 manager);
+    while (s->NextSolution()) {
+      CHECK(x[0]->Value() != 1 || x[1]->Value() == 2);
+      CHECK_NE(0, x[2]->Value());
+      ++num_solutions;
+    }
+    s->EndSearch();
+    return num_solutions;
+  }
+
+  // All the workers run an impact-based search with restarts, with different
+  // seeds, so that they all learn and exchange nogoods.
+  static void RunWorker(const FzModel* const model,
+                        const FzSolverSharedData* const shared_data,
+                        int worker_id, int num_workers,
+                        FzParallelSupportInterface* const support) {
+    FzSolverParameters parameters;
+    parameters.all_solutions = false;
+    parameters.free_search = true;
+    parameters.heuristic_period = 100;
+    parameters.ignore_unknown = false;
+    parameters.log_period = 0;
+    parameters.luby_restart = -1;
+    parameters.num_solutions = 1;
+    parameters.random_seed = worker_id * 10;
+    parameters.restart_log_size = 1.0;
+    parameters.search_type = FzSolverParameters::IBS;
+    parameters.threads = num_workers;
+    parameters.time_limit_in_ms = 0;
+    parameters.use_log = false;
+    parameters.verbose_impact = false;
+    parameters.worker_id = worker_id;
+    FzSolver solver(*model, shared_data);
+    CHECK(solver.Extract());
+    solver.Solve(parameters, support);
+  }
+};
+
+const int FzParallelTest::kNumVariables;
+const int FzParallelTest::kNumExpectedSolutions;
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::FzParallelTest test;
+  test.TestNoGoodExchange();
+  for (int i = 0; i < 5; ++i) {
+    test.TestPigeonHole(7, 6, 4);
+    test.TestPigeonHole(6, 6, 4);
+    test.TestPigeonHole(5, 3, 2);
+    test.TestPigeonHole(4, 5, 2);
+  }
+  return 0;
+}
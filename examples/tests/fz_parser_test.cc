@@ -0,0 +1,147 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the flatzinc parser builds the same model, and returns the
+// same status, when it parses the constraint items in chunks with several
+// threads as when it parses the whole file sequentially. The chunks are
+// forced to be small, so that every model is split. This is checked on all
+// the models of a directory, which include some that do not parse, and on
+// random models with comments, strings and syntax errors in the constraint
+// items.
+
+#include <dirent.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "flatzinc/model.h"
+#include "flatzinc/parser.h"
+
+DEFINE_string(fzn_directory, "examples/flatzinc",
+              "Directory of the .fzn models to parse.");
+DECLARE_int32(fz_parser_threads);
+DECLARE_int32(fz_parser_min_chunk_size);
+
+namespace operations_research {
+
+class FzParserTest {
+ public:
+  FzParserTest() : random_(12345) {}
+
+  // Parses all the .fzn files of the given directory in both modes.
+  void TestDirectory(const std::string& directory) {
+    DIR* const dir = opendir(directory.c_str());
+    CHECK(dir != nullptr) << "Could not open " << directory;
+    std::vector<std::string> files;
+    for (struct dirent* entry = readdir(dir); entry != nullptr;
+         entry = readdir(dir)) {
+      const std::string name = entry->d_name;
+      if (name.size() > 4 && name.substr(name.size() - 4) == ".fzn") {
+        files.push_back(directory + "/" + name);
+      }
+    }
+    closedir(dir);
+    CHECK(!files.empty()) << "No .fzn file in " << directory;
+    std::sort(files.begin(), files.end());
+    for (const std::string& file : files) {
+      const std::string expected = Parse(file, true, 1);
+      CHECK_EQ(expected, Parse(file, true, 4)) << file;
+    }
+  }
+
+  // Builds a random model whose constraint items contain comments, strings
+  // with ';' in annotations, and sometimes syntax errors, and parses it in
+  // both modes.
+  void TestRandomModel(int num_variables, int num_constraints) {
+    std::string model;
+    for (int i = 0; i < num_variables; ++i) {
+      model += StringPrintf("var 0..%d: x%d;\n", 1 + random_.Uniform(10), i);
+    }
+    model += StringPrintf("array [1..%d] of var int: a = [", num_variables);
+    for (int i = 0; i < num_variables; ++i) {
+      model += StringPrintf("%sx%d", i == 0 ? "" : ", ", i);
+    }
+    model += "];\n";
+    for (int c = 0; c < num_constraints; ++c) {
+      const int x = random_.Uniform(num_variables);
+      const int y = random_.Uniform(num_variables);
+      switch (random_.Uniform(6)) {
+        case 0:
+          model += StringPrintf("constraint int_ne(x%d, x%d);", x, y);
+          break;
+        case 1:
+          model += StringPrintf("constraint int_le(a[%d], %d);  %% ; \"\n",
+                                1 + x, random_.Uniform(5));
+          break;
+        case 2:
+          model += StringPrintf(
+              "constraint int_lin_le([1, -2], [x%d, x%d], %d) :: "
+              "mzn_path(\"a;b\");",
+              x, y, static_cast<int>(random_.Uniform(7)) - 3);
+          break;
+        case 3:
+          model += StringPrintf("%% constraint int_eq(x%d, 1);\n", x);
+          break;
+        case 4:
+          // A syntax error, which makes the parse fail but is skipped.
+          if (random_.OneIn(10)) {
+            model += StringPrintf("constraint int_eq(x%d, ..);\n", x);
+            break;
+          }
+          model += StringPrintf("constraint int_eq(x%d, %d);\n", x,
+                                random_.Uniform(3));
+          break;
+        default:
+          model += StringPrintf("constraint\n  int_lt(x%d,\n x%d);\n", x, y);
+      }
+    }
+    model += "solve satisfy;\n";
+    const std::string expected = Parse(model, false, 1);
+    for (int num_threads = 2; num_threads <= 4; ++num_threads) {
+      CHECK_EQ(expected, Parse(model, false, num_threads));
+    }
+  }
+
+ private:
+  // Parses the given file, or string, with the given number of threads, and
+  // returns the parse status followed by the model.
+  static std::string Parse(const std::string& input, bool is_file,
+                           int num_threads) {
+    FLAGS_fz_parser_threads = num_threads;
+    FLAGS_fz_parser_min_chunk_size = 1;
+    FzModel model("model");
+    const bool ok = is_file ? ParseFlatzincFile(input, &model)
+                            : ParseFlatzincString(input, &model);
+    return (ok ? "ok\n" : "failed\n") + model.DebugString();
+  }
+
+  ACMRandom random_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::FzParserTest test;
+  test.TestDirectory(FLAGS_fzn_directory);
+  for (int i = 0; i < 100; ++i) {
+    test.TestRandomModel(1 + i % 10, i);
+    test.TestRandomModel(20, 200);
+  }
+  return 0;
+}
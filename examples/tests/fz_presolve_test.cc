@@ -0,0 +1,298 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the flatzinc presolve keeps the solutions of the model: on
+// random models mixing the constraints that the presolve rules merge,
+// substitute, rewrite or regroup, the set of all the solutions printed after
+// FzPresolver::Run() is the one printed without it. The models are small
+// enough for the solver to enumerate all their solutions. Like the models
+// generated by mzn2fzn, they give bounds to all the variables, and define a
+// new variable for each affine, sum, abs or reified expression.
+
+#include <algorithm>
+#include <iostream>  // NOLINT
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "flatzinc/model.h"
+#include "flatzinc/parser.h"
+#include "flatzinc/presolve.h"
+#include "flatzinc/search.h"
+#include "flatzinc/solver.h"
+
+namespace operations_research {
+
+class FzPresolveTest {
+ public:
+  FzPresolveTest() : random_(12345), num_new_variables_(0) {}
+
+  // Builds a random model with the given number of integer variables, at
+  // least 3, and of constraints, and checks that the presolve does not change
+  // its solutions. All the variables are printed.
+  void TestRandomModel(int num_integers, int num_constraints) {
+    fzn_.clear();
+    variables_.clear();
+    num_new_variables_ = 0;
+    for (int i = 0; i < num_integers; ++i) {
+      NewVariable("x", 0, 2 + random_.Uniform(3), true);
+    }
+    std::string constraints;
+    for (int c = 0; c < num_constraints; ++c) {
+      // Like the models generated by mzn2fzn, a constraint does not refer
+      // twice to the same variable, even after the equal variables are
+      // merged.
+      const int num_variables = variables_.size();
+      const int x = random_.Uniform(num_variables);
+      const int y =
+          (x + 1 + random_.Uniform(num_variables - 1)) % num_variables;
+      int z = random_.Uniform(num_variables);
+      while (z == x || z == y) z = random_.Uniform(num_variables);
+      const std::string x_name = Alias(x);
+      const std::string y_name = Alias(y);
+      const std::string z_name = Alias(z);
+      const int x_min = variables_[x].min;
+      const int x_max = variables_[x].max;
+      const int value = random_.Uniform(4);
+      switch (random_.Uniform(12)) {
+        case 0: {
+          // A new variable equal to x, which the presolve merges with it.
+          const std::string name =
+              NewVariable("e", 0, 2 + random_.Uniform(3), false);
+          constraints += StringPrintf("constraint int_eq(%s, %s);\n",
+                                      x_name.c_str(), name.c_str());
+          variables_[x].names.push_back(name);
+          break;
+        }
+        case 1:
+          constraints += StringPrintf("constraint int_ne(%s, %d);\n",
+                                      x_name.c_str(), value);
+          break;
+        case 2:
+          constraints += StringPrintf("constraint int_ne(%s, %s);\n",
+                                      x_name.c_str(), y_name.c_str());
+          break;
+        case 3:
+          constraints += StringPrintf("constraint int_le(%s, %s);\n",
+                                      x_name.c_str(), y_name.c_str());
+          break;
+        case 4: {
+          // An affine mapping.
+          const int offset = static_cast<int>(random_.Uniform(3)) - 1;
+          const std::string name = NewVariable(
+              "a", 2 * x_min - offset, 2 * x_max - offset, true);
+          constraints += StringPrintf(
+              "constraint int_lin_eq([2, -1], [%s, %s], %d);\n",
+              x_name.c_str(), name.c_str(), offset);
+          break;
+        }
+        case 5: {
+          // A flattening mapping.
+          const std::string name =
+              NewVariable("s", x_min + variables_[y].min,
+                          x_max + variables_[y].max, true);
+          constraints += StringPrintf(
+              "constraint int_lin_eq([1, 1, -1], [%s, %s, %s], 0);\n",
+              x_name.c_str(), y_name.c_str(), name.c_str());
+          break;
+        }
+        case 6:
+          constraints += StringPrintf(
+              "constraint int_lin_le([1, 1, 1], [%s, %s, %s], %d);\n",
+              x_name.c_str(), y_name.c_str(), z_name.c_str(), 2 + value);
+          break;
+        case 7:
+        case 8: {
+          // Like the models generated by mzn2fzn, each reification defines
+          // its own Boolean variable. The ones of the same equality are
+          // merged by the presolve.
+          const int index = num_new_variables_++;
+          fzn_ += StringPrintf("var bool: r%d :: output_var;\n", index);
+          constraints += StringPrintf(
+              "constraint int_%s_reif(%s, %d, r%d);\n",
+              random_.OneIn(2) ? "eq" : "ne", x_name.c_str(), value, index);
+          break;
+        }
+        case 9: {
+          // A new 0..1 variable, and the Boolean variable it converts, which
+          // the presolve merges with it.
+          const std::string name = NewVariable("d", 0, 1, true);
+          const char* const index = name.c_str() + 1;
+          fzn_ += StringPrintf("var bool: c%s :: output_var;\n", index);
+          constraints += StringPrintf("constraint bool2int(c%s, %s);\n", index,
+                                      name.c_str());
+          break;
+        }
+        case 10: {
+          // An abs mapping. The abs of an abs is not built.
+          const std::string name =
+              NewVariable("p", 0, std::max(-x_min, x_max), false);
+          constraints += StringPrintf("constraint int_abs(%s, %s);\n",
+                                      x_name.c_str(), name.c_str());
+          break;
+        }
+        default: {
+          // A chain of int_max, through temporaries, which is regrouped into
+          // one maximum_int defining a new variable.
+          const int chain_length = 2 + random_.Uniform(3);
+          int chain_min = x_min;
+          int chain_max = x_max;
+          std::string previous = x_name;
+          for (int i = 0; i < chain_length; ++i) {
+            const int next = i == 0 ? x : random_.Uniform(num_variables);
+            const std::string next_name = i == 0 ? x_name : Alias(next);
+            chain_min = std::max(chain_min, variables_[next].min);
+            chain_max = std::max(chain_max, variables_[next].max);
+            const std::string name =
+                i + 1 == chain_length
+                    ? NewVariable("m", chain_min, chain_max, false)
+                    : NewTemporary(chain_min, chain_max);
+            constraints += StringPrintf(
+                "constraint int_max(%s, %s, %s) :: defines_var(%s);\n",
+                next_name.c_str(), previous.c_str(), name.c_str(),
+                name.c_str());
+            previous = name;
+          }
+        }
+      }
+    }
+    const std::string fzn = fzn_ + constraints + "solve satisfy;\n";
+    CHECK(AllSolutions(fzn, false) == AllSolutions(fzn, true)) << fzn;
+  }
+
+ private:
+  // Returns the solutions printed by the solver, with or without the
+  // presolve, or the unsatisfiability message.
+  static std::set<std::string> AllSolutions(const std::string& fzn,
+                                            bool presolve) {
+    FzModel model("presolve");
+    CHECK(ParseFlatzincString(fzn, &model));
+    FzPresolver presolver;
+    presolver.CleanUpModelForTheCpSolver(&model, false);
+    if (presolve) presolver.Run(&model);
+
+    FzSolverParameters parameters;
+    parameters.all_solutions = true;
+    parameters.free_search = false;
+    parameters.heuristic_period = 100;
+    parameters.ignore_unknown = false;
+    parameters.log_period = 0;
+    parameters.luby_restart = -1;
+    parameters.num_solutions = kint32max;
+    parameters.random_seed = 0;
+    parameters.restart_log_size = -1.0;
+    parameters.search_type = FzSolverParameters::DEFAULT;
+    parameters.threads = 0;
+    parameters.time_limit_in_ms = 0;
+    parameters.use_log = false;
+    parameters.verbose_impact = false;
+    parameters.worker_id = -1;
+
+    // The solutions are printed on std::cout.
+    std::stringstream output;
+    std::streambuf* const cout_buffer = std::cout.rdbuf(output.rdbuf());
+    {
+      std::unique_ptr<FzParallelSupportInterface> support(
+          MakeSequentialSupport(true, kint32max));
+      const FzSolverSharedData shared_data(&model);
+      FzSolver solver(model, &shared_data);
+      CHECK(solver.Extract());
+      solver.Solve(parameters, support.get());
+    }
+    std::cout.rdbuf(cout_buffer);
+
+    // Each solution ends with a line of dashes. The variables that are not
+    // printed may give the same solution more than once.
+    std::set<std::string> solutions;
+    std::string line;
+    std::string solution;
+    while (std::getline(output, line)) {
+      if (line == "----------") {
+        solutions.insert(solution);
+        solution.clear();
+      } else if (line == "=====UNSATISFIABLE=====") {
+        solutions.insert(line);
+      } else if (line.find(" = ") != std::string::npos) {
+        solution += line + "\n";
+      }
+    }
+    return solutions;
+  }
+
+  // Declares a new printed integer variable with the given bounds, and
+  // returns its name. The variables that are not 'reused' are only used by
+  // the constraint built by the caller.
+  std::string NewVariable(const char* prefix, int min, int max, bool reused) {
+    const std::string name = StringPrintf("%s%d", prefix, num_new_variables_++);
+    fzn_ += StringPrintf("var %d..%d: %s :: output_var;\n", min, max,
+                         name.c_str());
+    if (reused) {
+      variables_.push_back(Variable());
+      variables_.back().names.push_back(name);
+      variables_.back().min = min;
+      variables_.back().max = max;
+    }
+    return name;
+  }
+
+  // Declares a new variable, defined by a constraint and not printed, and
+  // returns its name.
+  std::string NewTemporary(int min, int max) {
+    const std::string name = StringPrintf("t%d", num_new_variables_++);
+    fzn_ += StringPrintf(
+        "var %d..%d: %s :: is_defined_var :: var_is_introduced;\n", min, max,
+        name.c_str());
+    return name;
+  }
+
+  // Returns one of the names of the given variable.
+  std::string Alias(int variable) {
+    const std::vector<std::string>& names = variables_[variable].names;
+    return names[random_.Uniform(names.size())];
+  }
+
+  // An integer variable of the model being built, that the next constraints
+  // may use.
+  struct Variable {
+    // Its own name, and the ones of the variables constrained to be equal to
+    // it.
+    std::vector<std::string> names;
+    // Its initial bounds.
+    int min;
+    int max;
+  };
+
+  ACMRandom random_;
+  // The model being built.
+  std::string fzn_;
+  std::vector<Variable> variables_;
+  int num_new_variables_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::FzPresolveTest test;
+  for (int i = 0; i < 1000; ++i) {
+    test.TestRandomModel(3 + i % 4, 1 + i % 12);
+  }
+  return 0;
+}
@@ -0,0 +1,176 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the incremental re-solves of an MPSolver using Glop, which
+// warm-start from the basis of the last optimal solve, give the same results
+// as solving the modified model from scratch, and that the simplex algorithm
+// chosen for a warm-start doesn't leak into the following solves.
+
+#include <cmath>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "glop/lp_solver.h"
+#include "linear_solver/linear_solver.h"
+
+namespace operations_research {
+
+class GlopIncrementalTest {
+ public:
+  GlopIncrementalTest() : random_(12345) {}
+
+  // Fills the solver with a random bounded and feasible problem: all the
+  // variables are in [0, 10] and x = 0 satisfies all the constraints.
+  void FillRandomProblem(int num_rows, int num_cols, MPSolver* solver) {
+    for (int col = 0; col < num_cols; ++col) {
+      AddRandomVariable(solver);
+    }
+    for (int row = 0; row < num_rows; ++row) {
+      AddRandomConstraint(solver);
+    }
+    solver->MutableObjective()->SetMaximization();
+  }
+
+  void AddRandomVariable(MPSolver* solver) {
+    MPVariable* const var = solver->MakeNumVar(0.0, 10.0, "");
+    solver->MutableObjective()->SetCoefficient(var, RandomCoefficient());
+    for (MPConstraint* const ct : solver->constraints()) {
+      if (random_.Uniform(3) == 0) ct->SetCoefficient(var, RandomCoefficient());
+    }
+  }
+
+  void AddRandomConstraint(MPSolver* solver) {
+    const double upper_bound = 1.0 + random_.Uniform(50);
+    MPConstraint* const ct = solver->MakeRowConstraint(
+        random_.Uniform(3) == 0 ? -upper_bound : -solver->infinity(),
+        upper_bound);
+    for (MPVariable* const var : solver->variables()) {
+      if (random_.Uniform(3) == 0) ct->SetCoefficient(var, RandomCoefficient());
+    }
+  }
+
+  // Solves the model incrementally, then from scratch, and checks that both
+  // solves give the same result.
+  MPSolver::ResultStatus CheckSameAsFromScratch(
+      MPSolver* solver, const MPSolverParameters& param) {
+    const MPSolver::ResultStatus status = solver->Solve(param);
+    const double objective =
+        status == MPSolver::OPTIMAL ? solver->Objective().Value() : 0.0;
+    MPSolverParameters from_scratch_param;
+    from_scratch_param.SetIntegerParam(MPSolverParameters::INCREMENTALITY,
+                                       MPSolverParameters::INCREMENTALITY_OFF);
+    CHECK_EQ(status, solver->Solve(from_scratch_param));
+    if (status == MPSolver::OPTIMAL) {
+      CHECK_LE(std::abs(objective - solver->Objective().Value()),
+               1e-6 * (1.0 + std::abs(objective)));
+    }
+
+    // The algorithm chosen for a warm-start isn't kept by the solve from
+    // scratch.
+    CHECK(!GetLpSolver(solver).GetParameters().has_use_dual_simplex());
+    return status;
+  }
+
+  void TestRandomModifications(int num_rows, int num_cols) {
+    MPSolver solver("glop_incremental_test",
+                    MPSolver::GLOP_LINEAR_PROGRAMMING);
+    FillRandomProblem(num_rows, num_cols, &solver);
+    const MPSolverParameters param;
+    CHECK_EQ(MPSolver::OPTIMAL, CheckSameAsFromScratch(&solver, param));
+
+    // Re-solving the same model starts from its optimal basis.
+    CHECK_EQ(MPSolver::OPTIMAL, solver.Solve(param));
+    CHECK_EQ(0, solver.iterations());
+
+    // A change of bounds only may break the primal feasibility of the last
+    // basis, so the warm-start uses the dual simplex, unless the algorithm is
+    // imposed.
+    solver.variables()[0]->SetBounds(0.0, 5.0);
+    CHECK_EQ(MPSolver::OPTIMAL, solver.Solve(param));
+    CHECK(GetLpSolver(&solver).GetParameters().use_dual_simplex());
+    MPSolverParameters primal_param;
+    primal_param.SetIntegerParam(MPSolverParameters::LP_ALGORITHM,
+                                 MPSolverParameters::PRIMAL);
+    solver.variables()[0]->SetBounds(0.0, 10.0);
+    CHECK_EQ(MPSolver::OPTIMAL, solver.Solve(primal_param));
+    CHECK(!GetLpSolver(&solver).GetParameters().use_dual_simplex());
+
+    for (int i = 0; i < 50; ++i) {
+      const std::vector<MPVariable*>& variables = solver.variables();
+      const std::vector<MPConstraint*>& constraints = solver.constraints();
+      MPVariable* const var = variables[random_.Uniform(variables.size())];
+      MPConstraint* const ct = constraints[random_.Uniform(constraints.size())];
+      switch (random_.Uniform(6)) {
+        case 0:
+          solver.MutableObjective()->SetCoefficient(var, RandomCoefficient());
+          break;
+        case 1:
+          var->SetBounds(0.0, 3.0 + random_.Uniform(8));
+          break;
+        case 2:
+          ct->SetBounds(-ct->ub(), ct->ub());
+          break;
+        case 3:
+          ct->SetCoefficient(var, RandomCoefficient());
+          break;
+        case 4:
+          AddRandomVariable(&solver);
+          break;
+        case 5:
+          AddRandomConstraint(&solver);
+          break;
+      }
+      CHECK_EQ(MPSolver::OPTIMAL, CheckSameAsFromScratch(&solver, param));
+    }
+
+    // An infeasible solve gives no basis to warm-start from.
+    MPConstraint* const ct = solver.constraints()[0];
+    const double lb = ct->lb();
+    const double ub = ct->ub();
+    solver.variables()[0]->SetBounds(0.0, 10.0);
+    ct->SetCoefficient(solver.variables()[0], 1.0);
+    ct->SetBounds(1e6, 1e6);
+    CHECK_EQ(MPSolver::INFEASIBLE, CheckSameAsFromScratch(&solver, param));
+    CHECK_EQ(MPSolver::INFEASIBLE, solver.Solve(param));
+    ct->SetBounds(lb, ub);
+    CHECK_EQ(MPSolver::OPTIMAL, CheckSameAsFromScratch(&solver, param));
+
+    // Neither does a cleared model.
+    solver.Clear();
+    FillRandomProblem(num_rows, num_cols, &solver);
+    CHECK_EQ(MPSolver::OPTIMAL, CheckSameAsFromScratch(&solver, param));
+  }
+
+ private:
+  double RandomCoefficient() { return random_.Uniform(19) - 9.0; }
+
+  static const glop::LPSolver& GetLpSolver(MPSolver* solver) {
+    return *static_cast<glop::LPSolver*>(solver->underlying_solver());
+  }
+
+  ACMRandom random_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::GlopIncrementalTest test;
+  for (int i = 0; i < 10; ++i) {
+    test.TestRandomModifications(10, 15);
+    test.TestRandomModifications(40, 30);
+  }
+  return 0;
+}
@@ -0,0 +1,261 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that HamiltonianPathSolver, with several thread counts, checkpoint
+// intervals and in cost-only mode, returns exactly the same costs and paths
+// as the implementation that kept the whole dynamic programming lattice in
+// memory, on random int32, int64 and double cost matrices with up to 18
+// nodes. That implementation is reproduced by ReferenceHamiltonianPathSolver
+// below: same recurrence, and same choice among the optimal predecessors when
+// the paths are rebuilt.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/hamiltonian_path.h"
+#include "util/saturated_arithmetic.h"
+
+namespace operations_research {
+
+template <typename CostType>
+class ReferenceHamiltonianPathSolver {
+ public:
+  explicit ReferenceHamiltonianPathSolver(
+      const std::vector<std::vector<CostType>>& cost)
+      : cost_(cost),
+        num_nodes_(cost.size()),
+        lattice_((num_nodes_ == 0 ? 0 : uint64{1} << num_nodes_) * num_nodes_,
+                 std::numeric_limits<CostType>::max()) {
+    if (num_nodes_ == 0) return;
+    for (int dest = 0; dest < num_nodes_; ++dest) {
+      Value(uint32{1} << dest, dest) = cost_[0][dest];
+    }
+    // The sets are enumerated by increasing values, so the subsets of a set
+    // are computed before it.
+    for (uint32 set = 1; set < (uint32{1} << num_nodes_); ++set) {
+      if ((set & (set - 1)) == 0) continue;
+      for (int dest = 0; dest < num_nodes_; ++dest) {
+        if (!Contains(set, dest)) continue;
+        const uint32 subset = set & ~(uint32{1} << dest);
+        CostType min_cost = std::numeric_limits<CostType>::max();
+        for (int src = 0; src < num_nodes_; ++src) {
+          if (!Contains(subset, src)) continue;
+          min_cost = std::min(
+              min_cost, SaturatedAdd(cost_[src][dest], Value(subset, src)));
+        }
+        Value(set, dest) = min_cost;
+      }
+    }
+  }
+
+  CostType TravelingSalesmanCost() const {
+    if (num_nodes_ == 0) return 0;
+    return Value(FullSet(), 0);
+  }
+
+  std::vector<int> TravelingSalesmanPath() const {
+    if (num_nodes_ == 0) return {0};
+    return ComputePath(TravelingSalesmanCost(), FullSet(), 0);
+  }
+
+  CostType HamiltonianCost(int end_node) const {
+    if (num_nodes_ == 0) return 0;
+    return Value(FullSet() & ~uint32{1}, end_node);
+  }
+
+  std::vector<int> HamiltonianPath(int end_node) const {
+    if (num_nodes_ == 0) return {0};
+    return ComputePath(HamiltonianCost(end_node), FullSet() & ~uint32{1},
+                       end_node);
+  }
+
+  int BestHamiltonianPathEndNode() const {
+    int best_end_node = 0;
+    CostType min_cost = std::numeric_limits<CostType>::max();
+    for (int end_node = 1; end_node < num_nodes_; ++end_node) {
+      if (HamiltonianCost(end_node) < min_cost) {
+        min_cost = HamiltonianCost(end_node);
+        best_end_node = end_node;
+      }
+    }
+    return best_end_node;
+  }
+
+ private:
+  static bool Contains(uint32 set, int node) {
+    return (set & (uint32{1} << node)) != 0;
+  }
+
+  uint32 FullSet() const {
+    return static_cast<uint32>((uint64{1} << num_nodes_) - 1);
+  }
+
+  CostType& Value(uint32 set, int node) {
+    return lattice_[static_cast<uint64>(set) * num_nodes_ + node];
+  }
+  CostType Value(uint32 set, int node) const {
+    return lattice_[static_cast<uint64>(set) * num_nodes_ + node];
+  }
+
+  static CostType SaturatedAdd(CostType a, CostType b) { return a + b; }
+
+  // Rebuilds the path backwards, taking the first predecessor in increasing
+  // order whose cost matches, up to the precision of CostType.
+  std::vector<int> ComputePath(CostType cost, uint32 set, int end_node) const {
+    int path_size = 1;
+    for (int node = 0; node < num_nodes_; ++node) {
+      if (Contains(set, node)) ++path_size;
+    }
+    std::vector<int> path(path_size, 0);
+    uint32 subset = set & ~(uint32{1} << end_node);
+    path[path_size - 1] = end_node;
+    int dest = end_node;
+    CostType current_cost = cost;
+    for (int rank = path_size - 2; rank >= 0; --rank) {
+      for (int src = 0; src < num_nodes_; ++src) {
+        if (!Contains(subset, src)) continue;
+        const CostType partial_cost = Value(subset, src);
+        const CostType incumbent_cost = partial_cost + cost_[src][dest];
+        if (std::abs(current_cost - incumbent_cost) <=
+            std::numeric_limits<CostType>::epsilon() * current_cost) {
+          subset &= ~(uint32{1} << src);
+          current_cost = partial_cost;
+          path[rank] = src;
+          dest = src;
+          break;
+        }
+      }
+    }
+    CHECK_EQ(0, subset);
+    return path;
+  }
+
+  const std::vector<std::vector<CostType>> cost_;
+  const int num_nodes_;
+  std::vector<CostType> lattice_;
+};
+
+template <>
+int64 ReferenceHamiltonianPathSolver<int64>::SaturatedAdd(int64 a, int64 b) {
+  return CapAdd(a, b);
+}
+
+template <>
+int32 ReferenceHamiltonianPathSolver<int32>::SaturatedAdd(int32 a, int32 b) {
+  const int64 sum = static_cast<int64>(a) + b;
+  return static_cast<int32>(
+      std::max<int64>(std::numeric_limits<int32>::min(),
+                      std::min<int64>(std::numeric_limits<int32>::max(), sum)));
+}
+
+class HamiltonianPathTest {
+ public:
+  HamiltonianPathTest() : random_(12345) {}
+
+  // Returns a random cost matrix. With a small max_cost, many paths have the
+  // same cost, which checks the choice between them.
+  template <typename CostType>
+  std::vector<std::vector<CostType>> RandomCostMatrix(int num_nodes,
+                                                      int max_cost) {
+    std::vector<std::vector<CostType>> cost(num_nodes);
+    for (int i = 0; i < num_nodes; ++i) {
+      for (int j = 0; j < num_nodes; ++j) {
+        cost[i].push_back(RandomCost<CostType>(max_cost));
+      }
+    }
+    return cost;
+  }
+
+  // Checks all the costs and paths of the solver against the reference.
+  template <typename CostType>
+  void CheckSolver(const ReferenceHamiltonianPathSolver<CostType>& expected,
+                   int num_nodes, HamiltonianPathSolver<CostType>* solver) {
+    CHECK_EQ(expected.TravelingSalesmanCost(), solver->TravelingSalesmanCost());
+    for (int end_node = 1; end_node < num_nodes; ++end_node) {
+      CHECK_EQ(expected.HamiltonianCost(end_node),
+               solver->HamiltonianCost(end_node));
+    }
+    CHECK_EQ(expected.BestHamiltonianPathEndNode(),
+             solver->BestHamiltonianPathEndNode());
+    CHECK(expected.TravelingSalesmanPath() == solver->TravelingSalesmanPath());
+    for (int end_node = 1; end_node < num_nodes; ++end_node) {
+      CHECK(expected.HamiltonianPath(end_node) ==
+            solver->HamiltonianPath(end_node));
+    }
+  }
+
+  template <typename CostType>
+  void TestRandomMatrix(int num_nodes, int max_cost) {
+    const std::vector<std::vector<CostType>> cost =
+        RandomCostMatrix<CostType>(num_nodes, max_cost);
+    const ReferenceHamiltonianPathSolver<CostType> expected(cost);
+    for (const int num_threads : {1, 2, 4}) {
+      for (const bool cost_only : {false, true}) {
+        HamiltonianPathSolver<CostType> solver(cost);
+        solver.SetNumThreads(num_threads);
+        solver.SetCostOnlyMode(cost_only);
+        solver.SetCheckpointInterval(1 + random_.Uniform(num_nodes + 1));
+        CheckSolver(expected, num_nodes, &solver);
+      }
+    }
+
+    // The memory is reused for another matrix of the same size.
+    HamiltonianPathSolver<CostType> solver(cost);
+    CHECK_EQ(expected.TravelingSalesmanCost(), solver.TravelingSalesmanCost());
+    const std::vector<std::vector<CostType>> other_cost =
+        RandomCostMatrix<CostType>(num_nodes, max_cost);
+    solver.ChangeCostMatrix(other_cost);
+    CheckSolver(ReferenceHamiltonianPathSolver<CostType>(other_cost),
+                num_nodes, &solver);
+  }
+
+ private:
+  template <typename CostType>
+  CostType RandomCost(int max_cost) {
+    return random_.Uniform(max_cost + 1);
+  }
+
+  ACMRandom random_;
+};
+
+template <>
+double HamiltonianPathTest::RandomCost<double>(int max_cost) {
+  return random_.RndDouble() * max_cost;
+}
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::HamiltonianPathTest test;
+  for (int num_nodes = 0; num_nodes <= 12; ++num_nodes) {
+    for (int i = 0; i < 3; ++i) {
+      test.TestRandomMatrix<int32>(num_nodes, 3);
+      test.TestRandomMatrix<int32>(num_nodes, 1000);
+      test.TestRandomMatrix<int64>(num_nodes, 1000000);
+      test.TestRandomMatrix<double>(num_nodes, 100);
+    }
+  }
+  for (const int num_nodes : {15, 18}) {
+    test.TestRandomMatrix<int32>(num_nodes, 5);
+    test.TestRandomMatrix<int64>(num_nodes, 1000000);
+    test.TestRandomMatrix<double>(num_nodes, 100);
+  }
+  return 0;
+}
@@ -0,0 +1,125 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the parallel branch and bound finds the same optimal profit as
+// the sequential multi-dimensional branch and bound, for several numbers of
+// threads, and that its solutions are feasible.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "algorithms/knapsack_solver.h"
+
+namespace operations_research {
+
+class KnapsackParallelSolverTest {
+ public:
+  KnapsackParallelSolverTest() : random_(12345) {}
+
+  // Fills a random problem whose capacities are half of the total weights, so
+  // that about half of the items are packed.
+  void FillRandomProblem(int num_items, int num_dimensions,
+                         std::vector<int64>* profits,
+                         std::vector<std::vector<int64> >* weights,
+                         std::vector<int64>* capacities) {
+    profits->clear();
+    weights->assign(num_dimensions, std::vector<int64>());
+    capacities->assign(num_dimensions, 0LL);
+    for (int item = 0; item < num_items; ++item) {
+      profits->push_back(1 + random_.Uniform(1000));
+      for (int dim = 0; dim < num_dimensions; ++dim) {
+        const int64 weight = 1 + random_.Uniform(1000);
+        (*weights)[dim].push_back(weight);
+        (*capacities)[dim] += weight;
+      }
+    }
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      (*capacities)[dim] /= 2;
+    }
+  }
+
+  int64 Solve(KnapsackSolver::SolverType solver_type, int num_threads,
+              const std::vector<int64>& profits,
+              const std::vector<std::vector<int64> >& weights,
+              const std::vector<int64>& capacities) {
+    KnapsackSolver solver(solver_type, "KnapsackTest");
+    solver.set_num_threads(num_threads);
+    solver.Init(profits, weights, capacities);
+    const int64 profit = solver.Solve();
+
+    // Checks that the solution is feasible and has the returned profit.
+    int64 solution_profit = 0LL;
+    std::vector<int64> consumed_capacities(capacities.size(), 0LL);
+    for (int item = 0; item < profits.size(); ++item) {
+      if (!solver.BestSolutionContains(item)) continue;
+      solution_profit += profits[item];
+      for (int dim = 0; dim < capacities.size(); ++dim) {
+        consumed_capacities[dim] += weights[dim][item];
+      }
+    }
+    CHECK_EQ(profit, solution_profit);
+    for (int dim = 0; dim < capacities.size(); ++dim) {
+      CHECK_LE(consumed_capacities[dim], capacities[dim]);
+    }
+    return profit;
+  }
+
+  void TestSameProfitAsSequentialSolver(int num_items, int num_dimensions) {
+    for (int problem = 0; problem < 5; ++problem) {
+      std::vector<int64> profits;
+      std::vector<std::vector<int64> > weights;
+      std::vector<int64> capacities;
+      FillRandomProblem(num_items, num_dimensions, &profits, &weights,
+                        &capacities);
+      const int64 expected_profit =
+          Solve(KnapsackSolver::KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER,
+                1, profits, weights, capacities);
+      for (const int num_threads : {1, 2, 4}) {
+        CHECK_EQ(expected_profit,
+                 Solve(KnapsackSolver::
+                           KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER,
+                       num_threads, profits, weights, capacities))
+            << "num_items: " << num_items
+            << " num_dimensions: " << num_dimensions
+            << " num_threads: " << num_threads;
+      }
+    }
+  }
+
+  void TestEmptyProblem() {
+    const std::vector<int64> profits;
+    const std::vector<std::vector<int64> > weights(1);
+    const std::vector<int64> capacities(1, 10LL);
+    CHECK_EQ(0LL,
+             Solve(KnapsackSolver::
+                       KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER,
+                   4, profits, weights, capacities));
+  }
+
+ private:
+  ACMRandom random_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::KnapsackParallelSolverTest test;
+  test.TestEmptyProblem();
+  test.TestSameProfitAsSequentialSolver(20, 1);
+  test.TestSameProfitAsSequentialSolver(30, 3);
+  test.TestSameProfitAsSequentialSolver(40, 5);
+  return 0;
+}
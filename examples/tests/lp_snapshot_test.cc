@@ -0,0 +1,316 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that a LinearProgram and its basis survive a round trip through a
+// snapshot file, that corrupted snapshots are rejected by Open(), and that
+// LPSolver reaches the same optimum when it starts from an external basis:
+// the optimal basis of the same problem, the optimal basis of a problem with
+// another objective or with fixed variables and constraints, or a random
+// (possibly singular) basis.
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "base/stringprintf.h"
+#include "glop/lp_snapshot.h"
+#include "glop/lp_solver.h"
+#include "lp_data/lp_data.h"
+
+DEFINE_string(test_tmpdir, "/tmp", "Directory where the snapshots are written.");
+
+namespace operations_research {
+namespace glop {
+
+class LpSnapshotTest {
+ public:
+  LpSnapshotTest()
+      : random_(12345),
+        file_name_(FLAGS_test_tmpdir + "/lp_snapshot_test.snp") {}
+
+  // Fills a random bounded and feasible problem: all the variables are in
+  // [0, 10] and x = 0 satisfies all the constraints.
+  void FillRandomProblem(int num_rows, int num_cols, LinearProgram* lp) {
+    lp->Clear();
+    for (int col = 0; col < num_cols; ++col) {
+      const ColIndex var = lp->CreateNewVariable();
+      lp->SetVariableBounds(var, 0.0, 10.0);
+      lp->SetObjectiveCoefficient(var, random_.Uniform(21) - 5.0);
+      lp->SetVariableName(var, StringPrintf("x%d", col));
+      if (random_.Uniform(4) == 0) lp->SetVariableIntegrality(var, true);
+    }
+    for (int row = 0; row < num_rows; ++row) {
+      const RowIndex ct = lp->CreateNewConstraint();
+      const Fractional upper_bound = 1.0 + random_.Uniform(50);
+      const Fractional lower_bound =
+          random_.Uniform(3) == 0 ? -upper_bound : -kInfinity;
+      lp->SetConstraintBounds(ct, lower_bound, upper_bound);
+      lp->SetConstraintName(ct, StringPrintf("c%d", row));
+      for (int col = 0; col < num_cols; ++col) {
+        if (random_.Uniform(3) != 0) continue;
+        lp->SetCoefficient(ct, ColIndex(col), random_.Uniform(19) - 9.0);
+      }
+    }
+    lp->SetMaximizationProblem(true);
+    lp->SetObjectiveOffset(1.5);
+    lp->CleanUp();
+  }
+
+  // Solves the given problem from scratch and returns its optimal basis.
+  BasisState SolveFromScratch(const LinearProgram& lp, Fractional* objective) {
+    LPSolver solver;
+    CHECK(solver.Solve(lp) == ProblemStatus::OPTIMAL);
+    *objective = solver.GetObjectiveValue();
+    return solver.GetBasisState();
+  }
+
+  // Solves the given problem from the given basis, checks that the optimum is
+  // the expected one, and returns the number of simplex iterations.
+  int SolveFromBasis(const LinearProgram& lp, const BasisState& basis,
+                     Fractional expected_objective) {
+    LPSolver solver;
+    solver.SetInitialBasis(basis);
+    CHECK(solver.Solve(lp) == ProblemStatus::OPTIMAL);
+    CHECK_LE(std::abs(solver.GetObjectiveValue() - expected_objective),
+             1e-6 * (1.0 + std::abs(expected_objective)));
+    return solver.GetNumberOfSimplexIterations();
+  }
+
+  void CheckSameLinearProgram(const LinearProgram& a, const LinearProgram& b) {
+    CHECK_EQ(a.num_constraints(), b.num_constraints());
+    CHECK_EQ(a.num_variables(), b.num_variables());
+    CHECK(a.GetSparseMatrix().Equals(b.GetSparseMatrix(), 0.0));
+    CHECK_EQ(a.IsMaximizationProblem(), b.IsMaximizationProblem());
+    CHECK_EQ(a.objective_offset(), b.objective_offset());
+    for (ColIndex col(0); col < a.num_variables(); ++col) {
+      CHECK_EQ(a.objective_coefficients()[col],
+               b.objective_coefficients()[col]);
+      CHECK_EQ(a.variable_lower_bounds()[col], b.variable_lower_bounds()[col]);
+      CHECK_EQ(a.variable_upper_bounds()[col], b.variable_upper_bounds()[col]);
+      CHECK_EQ(a.is_variable_integer()[col], b.is_variable_integer()[col]);
+      CHECK_EQ(a.GetVariableName(col), b.GetVariableName(col));
+    }
+    for (RowIndex row(0); row < a.num_constraints(); ++row) {
+      CHECK_EQ(a.constraint_lower_bounds()[row],
+               b.constraint_lower_bounds()[row]);
+      CHECK_EQ(a.constraint_upper_bounds()[row],
+               b.constraint_upper_bounds()[row]);
+      CHECK_EQ(a.GetConstraintName(row), b.GetConstraintName(row));
+    }
+  }
+
+  void TestRoundTripAndWarmStart(int num_rows, int num_cols) {
+    LinearProgram lp;
+    FillRandomProblem(num_rows, num_cols, &lp);
+    Fractional objective = 0.0;
+    const BasisState basis = SolveFromScratch(lp, &objective);
+    CHECK(WriteLinearProgramSnapshot(lp, &basis, /*with_names=*/true,
+                                     file_name_));
+
+    LinearProgramSnapshot snapshot;
+    CHECK(snapshot.Open(file_name_));
+    CHECK(snapshot.HasBasis());
+    CHECK(snapshot.HasNames());
+    LinearProgram loaded_lp;
+    snapshot.PopulateLinearProgram(&loaded_lp);
+    CheckSameLinearProgram(lp, loaded_lp);
+    BasisState loaded_basis;
+    CHECK(snapshot.GetBasisState(&loaded_basis));
+    CHECK(loaded_basis.statuses == basis.statuses);
+    snapshot.Close();
+
+    // Starting from the optimal basis, the solver has nothing to do.
+    CHECK_EQ(0, SolveFromBasis(loaded_lp, loaded_basis, objective));
+
+    // The optimal basis of a perturbed problem is still a valid start.
+    LinearProgram perturbed_lp;
+    perturbed_lp.PopulateFromLinearProgram(lp, /*keep_names=*/false);
+    for (ColIndex col(0); col < perturbed_lp.num_variables(); ++col) {
+      if (random_.Uniform(4) != 0) continue;
+      perturbed_lp.SetObjectiveCoefficient(
+          col, perturbed_lp.objective_coefficients()[col] + 1.0);
+    }
+    Fractional perturbed_objective = 0.0;
+    SolveFromScratch(perturbed_lp, &perturbed_objective);
+    SolveFromBasis(perturbed_lp, basis, perturbed_objective);
+
+    // So is the optimal basis of a problem whose variables and constraints
+    // become fixed, at a value that keeps x = 0 feasible.
+    LinearProgram fixed_lp;
+    fixed_lp.PopulateFromLinearProgram(lp, /*keep_names=*/false);
+    for (ColIndex col(0); col < fixed_lp.num_variables(); ++col) {
+      if (random_.Uniform(3) == 0) fixed_lp.SetVariableBounds(col, 0.0, 0.0);
+    }
+    for (RowIndex row(0); row < fixed_lp.num_constraints(); ++row) {
+      if (random_.Uniform(3) == 0) fixed_lp.SetConstraintBounds(row, 0.0, 0.0);
+    }
+    Fractional fixed_objective = 0.0;
+    SolveFromScratch(fixed_lp, &fixed_objective);
+    SolveFromBasis(fixed_lp, basis, fixed_objective);
+
+    // So is any basis, even a singular one, which is then ignored.
+    for (int i = 0; i < 5; ++i) {
+      BasisState random_basis = basis;
+      for (VariableStatus& status : random_basis.statuses) {
+        status = static_cast<VariableStatus>(random_.Uniform(5));
+      }
+      SolveFromBasis(lp, random_basis, objective);
+    }
+  }
+
+  // Writes a snapshot of a fixed problem and returns its content.
+  std::string WriteReferenceSnapshot(int* num_rows, int* num_cols) {
+    LinearProgram lp;
+    FillRandomProblem(5, 7, &lp);
+    Fractional objective = 0.0;
+    const BasisState basis = SolveFromScratch(lp, &objective);
+    CHECK(WriteLinearProgramSnapshot(lp, &basis, /*with_names=*/true,
+                                     file_name_));
+    *num_rows = lp.num_constraints().value();
+    *num_cols = lp.num_variables().value();
+    return ReadFile();
+  }
+
+  std::string ReadFile() {
+    std::ifstream file(file_name_.c_str(), std::ios::binary);
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }
+
+  void WriteFile(const std::string& content) {
+    std::ofstream file(file_name_.c_str(), std::ios::binary);
+    file.write(content.data(), content.size());
+  }
+
+  template <typename T>
+  void Patch(int64 offset, T value, std::string* content) {
+    CHECK_LE(offset + sizeof(T), content->size());
+    memcpy(&(*content)[offset], &value, sizeof(T));
+  }
+
+  bool OpenPatchedSnapshot(const std::string& content) {
+    WriteFile(content);
+    LinearProgramSnapshot snapshot;
+    return snapshot.Open(file_name_);
+  }
+
+  // Corrupts the fields of a valid snapshot one at a time, following the
+  // layout described in lp_snapshot.h, and checks that Open() rejects them.
+  void TestCorruptedSnapshots() {
+    int num_rows = 0;
+    int num_cols = 0;
+    const std::string reference = WriteReferenceSnapshot(&num_rows, &num_cols);
+    CHECK(OpenPatchedSnapshot(reference));
+    LinearProgramSnapshot snapshot;
+    CHECK(snapshot.Open(file_name_));
+    const int num_entries = snapshot.num_entries().value();
+    CHECK_GT(num_entries, 0);
+    snapshot.Close();
+
+    const int64 kHeaderSize = 64;
+    const int64 kNumRowsOffset = 16;
+    const int64 kNumColsOffset = 24;
+    const int64 kNumEntriesOffset = 32;
+    const int64 kNumNameCharsOffset = 40;
+    const int64 entry_rows_offset =
+        kHeaderSize + RoundUp((num_cols + 1) * sizeof(int64));
+    const int64 basis_offset =
+        entry_rows_offset + RoundUp(num_entries * sizeof(int32)) +
+        num_entries * sizeof(double) + 3 * num_cols * sizeof(double) +
+        2 * num_rows * sizeof(double) + RoundUp(num_cols);
+    const int64 name_offsets_offset =
+        basis_offset + RoundUp(num_cols + num_rows);
+
+    // Truncated or extended file.
+    CHECK(!OpenPatchedSnapshot(reference.substr(0, reference.size() - 8)));
+    CHECK(!OpenPatchedSnapshot(reference.substr(0, kHeaderSize - 1)));
+    CHECK(!OpenPatchedSnapshot(reference + std::string(8, '\0')));
+
+    // Wrong or huge sizes, which must not overflow the size computations.
+    std::string content = reference;
+    Patch<int64>(kNumRowsOffset, num_rows + 1, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int64>(kNumColsOffset, kint64max / 4, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int64>(kNumEntriesOffset, -1, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int64>(kNumNameCharsOffset, kint64max, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+
+    // Decreasing column starts.
+    content = reference;
+    Patch<int64>(kHeaderSize + sizeof(int64), num_entries + 1, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+
+    // Row indices out of range.
+    content = reference;
+    Patch<int32>(entry_rows_offset, num_rows, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int32>(entry_rows_offset + (num_entries - 1) * sizeof(int32), -1,
+                 &content);
+    CHECK(!OpenPatchedSnapshot(content));
+
+    // Invalid basis status.
+    content = reference;
+    Patch<int8>(basis_offset, 17, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+
+    // Negative, decreasing or too large name offsets.
+    content = reference;
+    Patch<int64>(name_offsets_offset, -3, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int64>(name_offsets_offset + sizeof(int64), 1000, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+    content = reference;
+    Patch<int64>(name_offsets_offset + (num_cols + num_rows) * sizeof(int64),
+                 1000, &content);
+    CHECK(!OpenPatchedSnapshot(content));
+
+    // The reference is still fine.
+    CHECK(OpenPatchedSnapshot(reference));
+    remove(file_name_.c_str());
+  }
+
+ private:
+  static int64 RoundUp(int64 size) { return (size + 7) / 8 * 8; }
+
+  ACMRandom random_;
+  const std::string file_name_;
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::glop::LpSnapshotTest test;
+  test.TestCorruptedSnapshots();
+  for (int i = 0; i < 10; ++i) {
+    test.TestRoundTripAndWarmStart(10, 15);
+    test.TestRoundTripAndWarmStart(40, 30);
+  }
+  return 0;
+}
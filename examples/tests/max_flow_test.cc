@@ -0,0 +1,215 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that ParallelMaxFlow, with several thread counts, finds the same
+// optimal flow and the same minimum cuts as GenericMaxFlow on random graphs,
+// and that its flow is feasible. The minimum cuts returned are the sets of
+// nodes reachable from the source, resp. reaching the sink, in the residual
+// graph, which are the same for all the maximum flows.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/graph.h"
+#include "graph/max_flow.h"
+
+namespace operations_research {
+
+class MaxFlowTest {
+ public:
+  typedef ParallelMaxFlow::Graph Graph;
+
+  MaxFlowTest() : random_(12345) {}
+
+  // Builds a random graph with about the given number of arcs per node,
+  // including some self-loops, parallel arcs and zero capacities. The source
+  // is node 0 and the sink is the last node.
+  void BuildRandomGraph(int num_nodes, int arcs_per_node,
+                        FlowQuantity max_capacity) {
+    tails_.clear();
+    heads_.clear();
+    capacities_.clear();
+    for (int i = 0; i < num_nodes * arcs_per_node; ++i) {
+      tails_.push_back(random_.Uniform(num_nodes));
+      // Favor arcs between close nodes, so the flow has long paths to follow.
+      const int offset = random_.Uniform(num_nodes / 4 + 2) - 1;
+      heads_.push_back(
+          std::min(num_nodes - 1, std::max(0, tails_.back() + offset)));
+      capacities_.push_back(random_.Uniform(max_capacity + 1));
+    }
+    graph_.reset(new Graph(num_nodes, tails_.size()));
+    for (int arc = 0; arc < tails_.size(); ++arc) {
+      graph_->AddArc(tails_[arc], heads_[arc]);
+    }
+    std::vector<Graph::ArcIndex> permutation;
+    graph_->Build(&permutation);
+    Permute(permutation, &tails_);
+    Permute(permutation, &heads_);
+    Permute(permutation, &capacities_);
+  }
+
+  // Checks that the flow of the given solved max flow respects the
+  // capacities and the flow conservation, and returns the nodes of its two
+  // minimum cuts, sorted.
+  template <class MaxFlow>
+  void CheckFlowAndGetCuts(MaxFlow* max_flow,
+                           std::vector<NodeIndex>* source_cut,
+                           std::vector<NodeIndex>* sink_cut) {
+    const NodeIndex num_nodes = graph_->num_nodes();
+    const NodeIndex source = 0;
+    const NodeIndex sink = num_nodes - 1;
+    std::vector<FlowQuantity> excess(num_nodes, 0);
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      const FlowQuantity flow = max_flow->Flow(arc);
+      CHECK_LE(0, flow);
+      CHECK_LE(flow, capacities_[arc]);
+      excess[tails_[arc]] -= flow;
+      excess[heads_[arc]] += flow;
+    }
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      if (node != source && node != sink) CHECK_EQ(0, excess[node]);
+    }
+    CHECK_EQ(max_flow->GetOptimalFlow(), excess[sink]);
+    CHECK_EQ(-max_flow->GetOptimalFlow(), excess[source]);
+
+    max_flow->GetSourceSideMinCut(source_cut);
+    max_flow->GetSinkSideMinCut(sink_cut);
+    std::sort(source_cut->begin(), source_cut->end());
+    std::sort(sink_cut->begin(), sink_cut->end());
+
+    // The arcs leaving the source side form a cut of the flow's value.
+    std::vector<bool> in_source_cut(num_nodes, false);
+    for (const NodeIndex node : *source_cut) in_source_cut[node] = true;
+    FlowQuantity cut_capacity = 0;
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      if (in_source_cut[tails_[arc]] && !in_source_cut[heads_[arc]]) {
+        cut_capacity += capacities_[arc];
+      }
+    }
+    CHECK_EQ(max_flow->GetOptimalFlow(), cut_capacity);
+  }
+
+  // Checks the given solved max flow against a GenericMaxFlow solved from
+  // scratch with the current capacities.
+  void CheckSameAsGenericMaxFlow(ParallelMaxFlow* max_flow) {
+    GenericMaxFlow<Graph> expected(graph_.get(), 0, graph_->num_nodes() - 1);
+    SetCapacities(&expected);
+    CHECK(expected.Solve());
+    std::vector<NodeIndex> expected_source_cut;
+    std::vector<NodeIndex> expected_sink_cut;
+    CheckFlowAndGetCuts(&expected, &expected_source_cut, &expected_sink_cut);
+    std::vector<NodeIndex> source_cut;
+    std::vector<NodeIndex> sink_cut;
+    CheckFlowAndGetCuts(max_flow, &source_cut, &sink_cut);
+    CHECK_EQ(expected.GetOptimalFlow(), max_flow->GetOptimalFlow());
+    CHECK(expected_source_cut == source_cut);
+    CHECK(expected_sink_cut == sink_cut);
+  }
+
+  // Checks that ParallelMaxFlow, solved from scratch or again after some
+  // capacity changes, finds the same flow value and minimum cuts as
+  // GenericMaxFlow solved from scratch.
+  void TestRandomGraph(int num_nodes, int arcs_per_node,
+                       FlowQuantity max_capacity) {
+    BuildRandomGraph(num_nodes, arcs_per_node, max_capacity);
+    for (const int num_threads : {1, 2, 3, 4, 8}) {
+      ParallelMaxFlow max_flow(graph_.get(), 0, num_nodes - 1);
+      max_flow.SetNumThreads(num_threads);
+      SetCapacities(&max_flow);
+      CHECK(max_flow.Solve());
+      CheckSameAsGenericMaxFlow(&max_flow);
+
+      for (int i = 0; i < 5; ++i) {
+        const ArcIndex arc = random_.Uniform(graph_->num_arcs());
+        capacities_[arc] = random_.Uniform(max_capacity + 1);
+        max_flow.SetArcCapacity(arc, capacities_[arc]);
+      }
+      CHECK(max_flow.Solve());
+      CheckSameAsGenericMaxFlow(&max_flow);
+    }
+  }
+
+  // Checks that SimpleMaxFlow gives the same results with one thread
+  // (GenericMaxFlow) and with several (ParallelMaxFlow).
+  void TestSimpleMaxFlow(int num_nodes, int arcs_per_node,
+                         FlowQuantity max_capacity) {
+    BuildRandomGraph(num_nodes, arcs_per_node, max_capacity);
+    SimpleMaxFlow max_flow;
+    for (ArcIndex arc = 0; arc < tails_.size(); ++arc) {
+      max_flow.AddArcWithCapacity(tails_[arc], heads_[arc], capacities_[arc]);
+    }
+    CHECK_EQ(SimpleMaxFlow::OPTIMAL, max_flow.Solve(0, num_nodes - 1));
+    const FlowQuantity expected_flow = max_flow.OptimalFlow();
+    std::vector<NodeIndex> expected_source_cut;
+    std::vector<NodeIndex> expected_sink_cut;
+    max_flow.GetSourceSideMinCut(&expected_source_cut);
+    max_flow.GetSinkSideMinCut(&expected_sink_cut);
+    std::sort(expected_source_cut.begin(), expected_source_cut.end());
+    std::sort(expected_sink_cut.begin(), expected_sink_cut.end());
+    for (const int num_threads : {2, 4}) {
+      max_flow.SetNumThreads(num_threads);
+      CHECK_EQ(SimpleMaxFlow::OPTIMAL, max_flow.Solve(0, num_nodes - 1));
+      CHECK_EQ(expected_flow, max_flow.OptimalFlow());
+      std::vector<FlowQuantity> excess(num_nodes, 0);
+      for (ArcIndex arc = 0; arc < max_flow.NumArcs(); ++arc) {
+        CHECK_LE(0, max_flow.Flow(arc));
+        CHECK_LE(max_flow.Flow(arc), max_flow.Capacity(arc));
+        excess[max_flow.Tail(arc)] -= max_flow.Flow(arc);
+        excess[max_flow.Head(arc)] += max_flow.Flow(arc);
+      }
+      CHECK_EQ(expected_flow, excess[num_nodes - 1]);
+      std::vector<NodeIndex> source_cut;
+      std::vector<NodeIndex> sink_cut;
+      max_flow.GetSourceSideMinCut(&source_cut);
+      max_flow.GetSinkSideMinCut(&sink_cut);
+      std::sort(source_cut.begin(), source_cut.end());
+      std::sort(sink_cut.begin(), sink_cut.end());
+      CHECK(expected_source_cut == source_cut);
+      CHECK(expected_sink_cut == sink_cut);
+    }
+  }
+
+ private:
+  template <class MaxFlow>
+  void SetCapacities(MaxFlow* max_flow) {
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      max_flow->SetArcCapacity(arc, capacities_[arc]);
+    }
+  }
+
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<NodeIndex> tails_;
+  std::vector<NodeIndex> heads_;
+  std::vector<FlowQuantity> capacities_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::MaxFlowTest test;
+  for (int i = 0; i < 10; ++i) {
+    test.TestRandomGraph(2, 2, 10);
+    test.TestRandomGraph(50, 3, 1);
+    test.TestRandomGraph(200, 4, 100);
+    test.TestRandomGraph(1000, 8, 1000000);
+    test.TestSimpleMaxFlow(300, 5, 1000);
+  }
+  return 0;
+}
@@ -0,0 +1,214 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that GenericMinCostFlow, warm-started after changes of the supplies,
+// costs and capacities, finds a feasible flow with the same optimal cost as a
+// solve from scratch, on random transshipment problems. Also checks that
+// SetNodeSupply() and SetArcFlow() still make the next Solve() start from
+// scratch, and that a warm start survives an infeasible modification.
+
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+
+namespace operations_research {
+
+const FlowQuantity kMaxCapacity = 20;
+const CostValue kMaxCost = 1000;
+const FlowQuantity kCycleCapacity = 1000000;
+
+class MinCostFlowTest {
+ public:
+  typedef ReverseArcStaticGraph<> Graph;
+  typedef GenericMinCostFlow<Graph> MinCostFlowSolver;
+
+  MinCostFlowTest() : random_(12345) {}
+
+  // Builds a random graph whose nodes are linked by a cycle of arcs with a
+  // large capacity and cost, so that all the balanced supplies used by the
+  // tests are feasible, and random capacities, costs and supplies.
+  void BuildRandomProblem(int num_nodes, int arcs_per_node,
+                          int num_supply_nodes) {
+    graph_.reset(new Graph(num_nodes, num_nodes * (arcs_per_node + 1)));
+    std::vector<FlowQuantity> capacities;
+    std::vector<CostValue> costs;
+    for (int node = 0; node < num_nodes; ++node) {
+      graph_->AddArc(node, (node + 1) % num_nodes);
+      capacities.push_back(kCycleCapacity);
+      costs.push_back(kMaxCost * 10);
+    }
+    for (int i = 0; i < num_nodes * arcs_per_node; ++i) {
+      graph_->AddArc(random_.Uniform(num_nodes), random_.Uniform(num_nodes));
+      capacities.push_back(random_.Uniform(kMaxCapacity + 1));
+      costs.push_back(random_.Uniform(kMaxCost + 1));
+    }
+    std::vector<Graph::ArcIndex> permutation;
+    graph_->Build(&permutation);
+    Permute(permutation, &capacities);
+    Permute(permutation, &costs);
+    capacities_ = capacities;
+    costs_ = costs;
+    supplies_.assign(num_nodes, 0);
+    for (int i = 0; i < num_supply_nodes; ++i) {
+      MoveRandomSupply(nullptr);
+    }
+  }
+
+  // Checks that the flow of the given solved problem is feasible and that its
+  // cost is the one of a solve from scratch.
+  void CheckOptimalFlow(const MinCostFlowSolver& solver) {
+    CHECK_EQ(MinCostFlowSolver::OPTIMAL, solver.status());
+    const NodeIndex num_nodes = graph_->num_nodes();
+    std::vector<FlowQuantity> excess(supplies_);
+    CostValue cost = 0;
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      const FlowQuantity flow = solver.Flow(arc);
+      CHECK_LE(0, flow);
+      CHECK_LE(flow, capacities_[arc]);
+      CHECK_EQ(capacities_[arc], solver.Capacity(arc));
+      excess[graph_->Tail(arc)] -= flow;
+      excess[graph_->Head(arc)] += flow;
+      cost += flow * costs_[arc];
+    }
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      CHECK_EQ(0, excess[node]);
+    }
+    CHECK_EQ(cost, solver.GetOptimalCost());
+
+    MinCostFlowSolver cold_solver(graph_.get());
+    Load(&cold_solver);
+    CHECK(cold_solver.Solve());
+    CHECK_EQ(cold_solver.GetOptimalCost(), solver.GetOptimalCost());
+  }
+
+  // Solves a random problem, then modifies and solves it again many times
+  // with a warm start.
+  void TestWarmStart(int num_nodes, int arcs_per_node, int num_supply_nodes,
+                     int num_changes) {
+    BuildRandomProblem(num_nodes, arcs_per_node, num_supply_nodes);
+    MinCostFlowSolver solver(graph_.get());
+    solver.SetUseWarmStart(true);
+    Load(&solver);
+    CHECK(solver.Solve());
+    CheckOptimalFlow(solver);
+    for (int round = 0; round < 20; ++round) {
+      for (int i = 0; i < num_changes; ++i) {
+        const ArcIndex arc = random_.Uniform(graph_->num_arcs());
+        switch (random_.Uniform(3)) {
+          case 0:
+            costs_[arc] = random_.Uniform(kMaxCost + 1);
+            solver.SetArcUnitCost(arc, costs_[arc]);
+            break;
+          case 1:
+            // The capacities of the cycle arcs are kept.
+            if (capacities_[arc] == kCycleCapacity) break;
+            capacities_[arc] = random_.Uniform(kMaxCapacity + 1);
+            solver.SetArcCapacity(arc, capacities_[arc]);
+            break;
+          case 2:
+            MoveRandomSupply(&solver);
+            break;
+        }
+      }
+      CHECK(solver.Solve());
+      CheckOptimalFlow(solver);
+    }
+
+    // An infeasible modification, where a node gets more supply than its
+    // outgoing arcs can carry, is detected and does not prevent the next solves
+    // from being warm-started.
+    const NodeIndex node = random_.Uniform(num_nodes);
+    const NodeIndex other_node = (node + 1) % num_nodes;
+    const FlowQuantity supply = supplies_[node];
+    const FlowQuantity other_supply = supplies_[other_node];
+    FlowQuantity out_capacity = 0;
+    for (const ArcIndex arc : graph_->OutgoingArcs(node)) {
+      out_capacity += capacities_[arc];
+    }
+    const FlowQuantity delta = out_capacity - supply + 1;
+    solver.SetNodeSupplyKeepingFlow(node, supply + delta);
+    solver.SetNodeSupplyKeepingFlow(other_node, other_supply - delta);
+    CHECK(!solver.Solve());
+    CHECK_EQ(MinCostFlowSolver::INFEASIBLE, solver.status());
+    solver.SetNodeSupplyKeepingFlow(other_node, other_supply);
+    solver.SetNodeSupplyKeepingFlow(node, supply);
+    MoveRandomSupply(&solver);
+    CHECK(solver.Solve());
+    CheckOptimalFlow(solver);
+
+    // SetNodeSupply() resets the excesses, so the flow must be reset too. The
+    // next Solve() starts from scratch.
+    MoveRandomSupply(nullptr);
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      solver.SetArcFlow(arc, 0);
+    }
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      solver.SetNodeSupply(node, supplies_[node]);
+    }
+    CHECK(solver.Solve());
+    CheckOptimalFlow(solver);
+  }
+
+ private:
+  void Load(MinCostFlowSolver* solver) {
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      solver->SetArcCapacity(arc, capacities_[arc]);
+      solver->SetArcUnitCost(arc, costs_[arc]);
+    }
+    for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
+      solver->SetNodeSupply(node, supplies_[node]);
+    }
+  }
+
+  // Moves some supply between two random nodes, which may be the same, and
+  // updates the solver if it is not null.
+  void MoveRandomSupply(MinCostFlowSolver* solver) {
+    const NodeIndex from = random_.Uniform(graph_->num_nodes());
+    const NodeIndex to = random_.Uniform(graph_->num_nodes());
+    const FlowQuantity delta = 1 + random_.Uniform(kMaxCapacity);
+    supplies_[from] += delta;
+    supplies_[to] -= delta;
+    if (solver != nullptr) {
+      solver->SetNodeSupplyKeepingFlow(from, supplies_[from]);
+      solver->SetNodeSupplyKeepingFlow(to, supplies_[to]);
+    }
+  }
+
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<FlowQuantity> supplies_;
+  std::vector<FlowQuantity> capacities_;
+  std::vector<CostValue> costs_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::MinCostFlowTest test;
+  for (int i = 0; i < 5; ++i) {
+    test.TestWarmStart(2, 2, 1, 1);
+    test.TestWarmStart(30, 3, 10, 1);
+    test.TestWarmStart(100, 5, 30, 5);
+    // More changes than nodes, so that all of them are considered modified.
+    test.TestWarmStart(50, 4, 20, 80);
+  }
+  test.TestWarmStart(2000, 6, 200, 10);
+  return 0;
+}
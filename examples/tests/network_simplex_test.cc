@@ -0,0 +1,197 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that NetworkSimplexMinCostFlow finds the same optimal cost as the
+// cost-scaling GenericMinCostFlow on random min-cost flow problems, with a
+// feasible flow and node potentials which prove its optimality, and that both
+// detect the same infeasible problems. Also checks the two algorithms of
+// SimpleMinCostFlow against each other.
+
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+#include "graph/network_simplex.h"
+
+namespace operations_research {
+
+class NetworkSimplexTest {
+ public:
+  typedef ReverseArcStaticGraph<> Graph;
+
+  NetworkSimplexTest() : random_(12345) {}
+
+  // Builds a random problem with about the given number of arcs per node,
+  // including some self-loops, parallel arcs, zero capacities and negative
+  // costs. The supplies are balanced, but the problem may be infeasible.
+  void BuildRandomProblem(int num_nodes, int arcs_per_node, int max_capacity,
+                          int max_cost, int num_supply_nodes) {
+    tails_.clear();
+    heads_.clear();
+    capacities_.clear();
+    costs_.clear();
+    for (int i = 0; i < num_nodes * arcs_per_node; ++i) {
+      tails_.push_back(random_.Uniform(num_nodes));
+      heads_.push_back(random_.Uniform(num_nodes));
+      capacities_.push_back(random_.Uniform(max_capacity + 1));
+      costs_.push_back(random_.Uniform(2 * max_cost + 1) - max_cost / 4);
+    }
+    graph_.reset(new Graph(num_nodes, tails_.size()));
+    for (int arc = 0; arc < tails_.size(); ++arc) {
+      graph_->AddArc(tails_[arc], heads_[arc]);
+    }
+    std::vector<Graph::ArcIndex> permutation;
+    graph_->Build(&permutation);
+    Permute(permutation, &tails_);
+    Permute(permutation, &heads_);
+    Permute(permutation, &capacities_);
+    Permute(permutation, &costs_);
+    supplies_.assign(num_nodes, 0);
+    for (int i = 0; i < num_supply_nodes; ++i) {
+      const FlowQuantity supply = 1 + random_.Uniform(max_capacity);
+      supplies_[random_.Uniform(num_nodes)] += supply;
+      supplies_[random_.Uniform(num_nodes)] -= supply;
+    }
+  }
+
+  // Checks that the flow of the network simplex is feasible, that its cost is
+  // the optimal cost, and that the reduced costs of its potentials satisfy the
+  // complementary slackness conditions.
+  void CheckNetworkSimplexSolution(
+      const NetworkSimplexMinCostFlow<Graph>& network_simplex) {
+    const int num_nodes = graph_->num_nodes();
+    std::vector<FlowQuantity> excess(supplies_);
+    CostValue cost = 0;
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      const FlowQuantity flow = network_simplex.Flow(arc);
+      CHECK_LE(0, flow);
+      CHECK_LE(flow, capacities_[arc]);
+      excess[tails_[arc]] -= flow;
+      excess[heads_[arc]] += flow;
+      cost += flow * costs_[arc];
+      const CostValue reduced_cost = costs_[arc] +
+                                     network_simplex.Potential(tails_[arc]) -
+                                     network_simplex.Potential(heads_[arc]);
+      if (flow < capacities_[arc]) CHECK_LE(0, reduced_cost);
+      if (flow > 0) CHECK_GE(0, reduced_cost);
+    }
+    for (int node = 0; node < num_nodes; ++node) {
+      CHECK_EQ(0, excess[node]);
+    }
+    CHECK_EQ(cost, network_simplex.GetOptimalCost());
+  }
+
+  // Solves a random problem with both algorithms.
+  void TestRandomProblem(int num_nodes, int arcs_per_node, int max_capacity,
+                         int max_cost, int num_supply_nodes) {
+    BuildRandomProblem(num_nodes, arcs_per_node, max_capacity, max_cost,
+                       num_supply_nodes);
+    GenericMinCostFlow<Graph> cost_scaling(graph_.get());
+    NetworkSimplexMinCostFlow<Graph> network_simplex(graph_.get());
+    for (ArcIndex arc = 0; arc < graph_->num_arcs(); ++arc) {
+      cost_scaling.SetArcCapacity(arc, capacities_[arc]);
+      cost_scaling.SetArcUnitCost(arc, costs_[arc]);
+      network_simplex.SetArcCapacity(arc, capacities_[arc]);
+      network_simplex.SetArcUnitCost(arc, costs_[arc]);
+    }
+    for (int node = 0; node < num_nodes; ++node) {
+      cost_scaling.SetNodeSupply(node, supplies_[node]);
+      network_simplex.SetNodeSupply(node, supplies_[node]);
+    }
+    const bool feasible = cost_scaling.Solve();
+    CHECK_EQ(feasible, network_simplex.Solve());
+    if (feasible) {
+      ++num_feasible_;
+      CHECK_EQ(GenericMinCostFlow<Graph>::OPTIMAL, network_simplex.status());
+      CHECK_EQ(cost_scaling.GetOptimalCost(), network_simplex.GetOptimalCost());
+      CheckNetworkSimplexSolution(network_simplex);
+    } else {
+      ++num_infeasible_;
+      CHECK_EQ(GenericMinCostFlow<Graph>::INFEASIBLE, cost_scaling.status());
+      CHECK_EQ(GenericMinCostFlow<Graph>::INFEASIBLE, network_simplex.status());
+    }
+  }
+
+  // Checks that the two algorithms of SimpleMinCostFlow give the same maximum
+  // flow and the same cost.
+  void TestSimpleMinCostFlow(int num_nodes, int arcs_per_node,
+                             int max_capacity, int max_cost,
+                             int num_supply_nodes) {
+    BuildRandomProblem(num_nodes, arcs_per_node, max_capacity, max_cost,
+                       num_supply_nodes);
+    SimpleMinCostFlow cost_scaling;
+    SimpleMinCostFlow network_simplex;
+    network_simplex.SetAlgorithm(SimpleMinCostFlow::NETWORK_SIMPLEX);
+    for (ArcIndex arc = 0; arc < tails_.size(); ++arc) {
+      cost_scaling.AddArcWithCapacityAndUnitCost(tails_[arc], heads_[arc],
+                                                 capacities_[arc], costs_[arc]);
+      network_simplex.AddArcWithCapacityAndUnitCost(
+          tails_[arc], heads_[arc], capacities_[arc], costs_[arc]);
+    }
+    for (int node = 0; node < num_nodes; ++node) {
+      cost_scaling.SetNodeSupply(node, supplies_[node]);
+      network_simplex.SetNodeSupply(node, supplies_[node]);
+    }
+    CHECK_EQ(SimpleMinCostFlow::OPTIMAL,
+             cost_scaling.SolveMaxFlowWithMinCost());
+    CHECK_EQ(SimpleMinCostFlow::OPTIMAL,
+             network_simplex.SolveMaxFlowWithMinCost());
+    CHECK_EQ(cost_scaling.MaximumFlow(), network_simplex.MaximumFlow());
+    CHECK_EQ(cost_scaling.OptimalCost(), network_simplex.OptimalCost());
+    const SimpleMinCostFlow::Status status = cost_scaling.Solve();
+    CHECK_EQ(status, network_simplex.Solve());
+    if (status == SimpleMinCostFlow::OPTIMAL) {
+      CHECK_EQ(cost_scaling.OptimalCost(), network_simplex.OptimalCost());
+    }
+  }
+
+  int num_feasible() const { return num_feasible_; }
+  int num_infeasible() const { return num_infeasible_; }
+
+ private:
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<NodeIndex> tails_;
+  std::vector<NodeIndex> heads_;
+  std::vector<FlowQuantity> capacities_;
+  std::vector<CostValue> costs_;
+  std::vector<FlowQuantity> supplies_;
+  int num_feasible_ = 0;
+  int num_infeasible_ = 0;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::NetworkSimplexTest test;
+  for (int i = 0; i < 100; ++i) {
+    test.TestRandomProblem(2, 2, 10, 10, 1);
+    test.TestRandomProblem(10, 3, 5, 100, 3);
+    test.TestRandomProblem(50, 6, 20, 1000, 10);
+    test.TestRandomProblem(200, 8, 100, 100000, 20);
+    test.TestSimpleMinCostFlow(50, 5, 20, 1000, 10);
+  }
+  for (int i = 0; i < 5; ++i) {
+    test.TestRandomProblem(5000, 10, 1000, 10000, 500);
+  }
+  // Both outcomes must have been tested.
+  CHECK_LT(0, test.num_feasible());
+  CHECK_LT(0, test.num_infeasible());
+  return 0;
+}
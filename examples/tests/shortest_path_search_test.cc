@@ -0,0 +1,171 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks the searches of graph/shortest_path_search.h, and in particular the
+// many-to-many distance matrix with several thread counts, against the
+// distances computed by the Bellman-Ford algorithm on random graphs.
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "graph/graph.h"
+#include "graph/shortest_path_search.h"
+
+namespace operations_research {
+
+class ShortestPathSearchTest {
+ public:
+  typedef ReverseArcStaticGraph<> Graph;
+  typedef Graph::NodeIndex NodeIndex;
+
+  ShortestPathSearchTest() : random_(12345) {}
+
+  // Builds a random graph, with some parallel arcs, self-loops and zero
+  // lengths, and computes all its distances with the Bellman-Ford algorithm.
+  void BuildRandomGraph(int num_nodes, int num_arcs, int max_length) {
+    std::vector<NodeIndex> tails;
+    std::vector<NodeIndex> heads;
+    graph_.reset(new Graph(num_nodes, num_arcs));
+    arc_lengths_.clear();
+    for (int arc = 0; arc < num_arcs; ++arc) {
+      tails.push_back(random_.Uniform(num_nodes));
+      heads.push_back(random_.Uniform(num_nodes));
+      arc_lengths_.push_back(random_.Uniform(max_length + 1));
+      graph_->AddArc(tails.back(), heads.back());
+    }
+    expected_.assign(num_nodes, std::vector<int64>(num_nodes,
+                                                   kUnreachableDistance));
+    for (int source = 0; source < num_nodes; ++source) {
+      std::vector<int64>& distance = expected_[source];
+      distance[source] = 0;
+      bool changed = true;
+      while (changed) {
+        changed = false;
+        for (int arc = 0; arc < num_arcs; ++arc) {
+          if (distance[tails[arc]] == kUnreachableDistance) continue;
+          const int64 new_distance = distance[tails[arc]] + arc_lengths_[arc];
+          if (new_distance < distance[heads[arc]]) {
+            distance[heads[arc]] = new_distance;
+            changed = true;
+          }
+        }
+      }
+    }
+    std::vector<Graph::ArcIndex> permutation;
+    graph_->Build(&permutation);
+    Permute(permutation, &arc_lengths_);
+  }
+
+  // Returns the length of the given path, checking that it follows arcs of
+  // the graph (taking the shortest of the parallel arcs).
+  int64 PathLength(const std::vector<NodeIndex>& path) {
+    int64 length = 0;
+    for (int i = 0; i + 1 < path.size(); ++i) {
+      int64 arc_length = kUnreachableDistance;
+      for (const Graph::ArcIndex arc : graph_->OutgoingArcs(path[i])) {
+        if (graph_->Head(arc) == path[i + 1]) {
+          arc_length = std::min(arc_length, arc_lengths_[arc]);
+        }
+      }
+      CHECK_NE(kUnreachableDistance, arc_length);
+      length += arc_length;
+    }
+    return length;
+  }
+
+  void TestSingleQueries(int num_queries) {
+    const int num_nodes = graph_->num_nodes();
+    ShortestPathSearch<Graph> search(graph_.get(), &arc_lengths_);
+    BidirectionalShortestPathSearch<Graph> bidirectional(graph_.get(),
+                                                         &arc_lengths_);
+    std::vector<NodeIndex> path;
+    for (int i = 0; i < num_queries; ++i) {
+      const NodeIndex source = random_.Uniform(num_nodes);
+      const NodeIndex target = random_.Uniform(num_nodes);
+      const int64 expected = expected_[source][target];
+      CHECK_EQ(expected != kUnreachableDistance,
+               search.ComputeShortestPath(source, target));
+      CHECK_EQ(expected, search.Distance(target));
+      if (expected != kUnreachableDistance) {
+        search.GetPath(target, &path);
+        CHECK_EQ(source, path.front());
+        CHECK_EQ(target, path.back());
+        CHECK_EQ(expected, PathLength(path));
+      }
+      CHECK_EQ(expected != kUnreachableDistance,
+               bidirectional.ComputeShortestPath(source, target));
+      CHECK_EQ(expected, bidirectional.Distance());
+    }
+    const NodeIndex source = random_.Uniform(num_nodes);
+    search.ComputeShortestPathsFromSource(source);
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      CHECK_EQ(expected_[source][node], search.Distance(node));
+    }
+  }
+
+  // Checks the distance matrix between random sets of sources and targets,
+  // which may contain duplicates.
+  void TestDistanceMatrix(int num_sources, int num_targets, int num_threads) {
+    const int num_nodes = graph_->num_nodes();
+    std::vector<NodeIndex> sources;
+    std::vector<NodeIndex> targets;
+    for (int i = 0; i < num_sources; ++i) {
+      sources.push_back(random_.Uniform(num_nodes));
+    }
+    for (int j = 0; j < num_targets; ++j) {
+      targets.push_back(random_.Uniform(num_nodes));
+    }
+    std::vector<int64> distances;
+    ComputeShortestPathDistanceMatrix(*graph_, arc_lengths_, sources, targets,
+                                      num_threads, &distances);
+    CHECK_EQ(num_sources * num_targets, distances.size());
+    for (int i = 0; i < num_sources; ++i) {
+      for (int j = 0; j < num_targets; ++j) {
+        CHECK_EQ(expected_[sources[i]][targets[j]],
+                 distances[i * num_targets + j]);
+      }
+    }
+  }
+
+ private:
+  ACMRandom random_;
+  std::unique_ptr<Graph> graph_;
+  std::vector<int64> arc_lengths_;
+  std::vector<std::vector<int64>> expected_;
+};
+
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  operations_research::ShortestPathSearchTest test;
+  for (int i = 0; i < 20; ++i) {
+    // Sparse graphs, where many nodes are unreachable, and denser graphs.
+    test.BuildRandomGraph(60, 90, 100);
+    test.TestSingleQueries(200);
+    test.BuildRandomGraph(60, 600, i % 2 == 0 ? 5 : 100000);
+    test.TestSingleQueries(200);
+    for (const int num_threads : {1, 2, 4}) {
+      test.TestDistanceMatrix(0, 10, num_threads);
+      test.TestDistanceMatrix(10, 0, num_threads);
+      test.TestDistanceMatrix(1, 60, num_threads);
+      test.TestDistanceMatrix(25, 40, num_threads);
+    }
+  }
+  return 0;
+}
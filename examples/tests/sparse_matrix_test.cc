@@ -0,0 +1,288 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Checks that the SparseMatrix builders store the entries of all the columns
+// in a single allocation, and that the columns behave as before when they are
+// modified, copied, grown past their reserved range or moved out of the
+// matrix.
+
+#include <vector>
+
+#include "base/commandlineflags.h"
+#include "base/logging.h"
+#include "base/random.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/sparse.h"
+
+namespace operations_research {
+namespace glop {
+
+class SparseMatrixTest {
+ public:
+  SparseMatrixTest() : random_(12345) {}
+
+  // Fills a random matrix with about the given density, using one allocation
+  // per column. Some columns are left empty and some entries are duplicated or
+  // zero, so the matrix is not cleaned up.
+  void FillRandomMatrix(RowIndex num_rows, ColIndex num_cols, double density,
+                        SparseMatrix* matrix) {
+    matrix->PopulateFromZero(num_rows, num_cols);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      for (RowIndex row(0); row < num_rows; ++row) {
+        if (random_.RndDouble() >= density) continue;
+        const Fractional value = random_.Uniform(5) - 2.0;
+        matrix->mutable_column(col)->SetCoefficient(row, value);
+        if (random_.Uniform(10) == 0) {
+          matrix->mutable_column(col)->SetCoefficient(row, value + 1.0);
+        }
+      }
+    }
+  }
+
+  // Checks that all the non-empty columns of the matrix share one allocation.
+  // The entries of consecutive columns are consecutive, unless the columns
+  // were cleaned up since they were reserved.
+  void CheckUsesEntryBlock(const SparseMatrix& matrix) {
+    for (ColIndex col(0); col < matrix.num_cols(); ++col) {
+      const SparseColumn& column = matrix.column(col);
+      CHECK(column.IsEmpty() || column.UsesEntryBlock());
+    }
+  }
+
+  // Checks that a and b have exactly the same entries, in the same order.
+  void CheckSameEntries(const SparseMatrix& a, const SparseMatrix& b) {
+    CHECK_EQ(a.num_rows(), b.num_rows());
+    CHECK_EQ(a.num_cols(), b.num_cols());
+    for (ColIndex col(0); col < a.num_cols(); ++col) {
+      CheckSameEntries(a.column(col), b.column(col));
+    }
+  }
+  void CheckSameEntries(const SparseColumn& a, const SparseColumn& b) {
+    CHECK_EQ(a.num_entries_with_duplicates(),
+             b.num_entries_with_duplicates());
+    for (EntryIndex i(0); i < a.num_entries_with_duplicates(); ++i) {
+      CHECK_EQ(a.EntryRow(i), b.EntryRow(i));
+      CHECK_EQ(a.EntryCoefficient(i), b.EntryCoefficient(i));
+    }
+  }
+
+  void TestBuilders(RowIndex num_rows, ColIndex num_cols, double density) {
+    SparseMatrix matrix;
+    FillRandomMatrix(num_rows, num_cols, density, &matrix);
+    SparseMatrix reference;
+    CopyColumnByColumn(matrix, &reference);
+
+    // CleanUp() compacts the columns.
+    SparseMatrix cleaned;
+    cleaned.PopulateFromSparseMatrix(matrix);
+    CheckUsesEntryBlock(cleaned);
+    CheckSameEntries(reference, cleaned);
+    cleaned.CleanUp();
+    CheckUsesEntryBlock(cleaned);
+    CHECK(cleaned.IsCleanedUp());
+    for (ColIndex col(0); col < num_cols; ++col) {
+      SparseColumn expected = reference.column(col);
+      expected.CleanUp();
+      CheckSameEntries(expected, cleaned.column(col));
+    }
+    matrix.CleanUp();
+    CheckUsesEntryBlock(matrix);
+    CheckSameEntries(cleaned, matrix);
+
+    SparseMatrix transpose;
+    transpose.PopulateFromTranspose(matrix);
+    CheckUsesEntryBlock(transpose);
+    CHECK(transpose.IsCleanedUp());
+    for (ColIndex col(0); col < num_cols; ++col) {
+      for (RowIndex row(0); row < num_rows; ++row) {
+        CHECK_EQ(matrix.LookUpValue(row, col),
+                 transpose.LookUpValue(ColToRowIndex(col), RowToColIndex(row)));
+      }
+    }
+    SparseMatrix transpose_of_transpose;
+    transpose_of_transpose.PopulateFromTranspose(transpose);
+    CheckSameEntries(matrix, transpose_of_transpose);
+
+    RowPermutation row_perm(num_rows);
+    ColumnPermutation col_perm(num_cols);
+    row_perm.PopulateRandomly();
+    col_perm.PopulateRandomly();
+    ColumnPermutation inverse_col_perm(num_cols);
+    inverse_col_perm.PopulateFromInverse(col_perm);
+    SparseMatrix permuted;
+    permuted.PopulateFromPermutedMatrix(matrix, row_perm, inverse_col_perm);
+    CheckUsesEntryBlock(permuted);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      for (RowIndex row(0); row < num_rows; ++row) {
+        CHECK_EQ(matrix.LookUpValue(row, col),
+                 permuted.LookUpValue(row_perm[row], col_perm[col]));
+      }
+    }
+
+    SparseMatrix sum;
+    sum.PopulateFromLinearCombination(2.0, matrix, -1.0, transpose_of_transpose);
+    CheckUsesEntryBlock(sum);
+    CHECK(sum.Equals(matrix, 0.0));
+
+    SparseMatrix identity;
+    identity.PopulateFromIdentity(num_cols);
+    CheckUsesEntryBlock(identity);
+    SparseMatrix product;
+    product.PopulateFromProduct(matrix, identity);
+    CheckUsesEntryBlock(product);
+    CHECK(product.Equals(matrix, 0.0));
+  }
+
+  // Modifies the columns of a compact matrix in place and out of their
+  // reserved range, and checks that they stay correct.
+  void TestModifications(RowIndex num_rows, ColIndex num_cols, double density) {
+    SparseMatrix matrix;
+    FillRandomMatrix(num_rows, num_cols, density, &matrix);
+    matrix.CleanUp();
+    SparseMatrix reference;
+    CopyColumnByColumn(matrix, &reference);
+    for (int i = 0; i < 20 * num_cols.value(); ++i) {
+      const ColIndex col(random_.Uniform(num_cols.value()));
+      const RowIndex row(random_.Uniform(num_rows.value()));
+      const Fractional value = random_.Uniform(5) - 2.0;
+      switch (random_.Uniform(3)) {
+        case 0:
+          // Appends to the column, which may grow it past its range.
+          matrix.mutable_column(col)->SetCoefficient(row, value);
+          reference.mutable_column(col)->SetCoefficient(row, value);
+          break;
+        case 1:
+          // Shrinks the column.
+          matrix.mutable_column(col)->CleanUp();
+          reference.mutable_column(col)->CleanUp();
+          matrix.mutable_column(col)->DeleteEntry(row);
+          reference.mutable_column(col)->DeleteEntry(row);
+          break;
+        case 2:
+          matrix.mutable_column(col)->Clear();
+          reference.mutable_column(col)->Clear();
+          break;
+      }
+      if (random_.Uniform(10) == 0) {
+        matrix.mutable_column(col)->CleanUp();
+        reference.mutable_column(col)->CleanUp();
+      }
+    }
+    CheckSameEntries(reference, matrix);
+
+    // Copies own their entries, and don't change with the matrix.
+    const SparseColumn copy = matrix.column(ColIndex(0));
+    CHECK(copy.IsEmpty() || !copy.UsesEntryBlock());
+    SparseColumn assigned;
+    assigned = matrix.column(ColIndex(0));
+    matrix.mutable_column(ColIndex(0))->Clear();
+    CheckSameEntries(copy, assigned);
+    CheckSameEntries(reference.column(ColIndex(0)), copy);
+    reference.mutable_column(ColIndex(0))->Clear();
+
+    matrix.CleanUp();
+    reference.CleanUp();
+    CheckUsesEntryBlock(matrix);
+    CheckSameEntries(reference, matrix);
+
+    // Appending columns moves the existing ones without copying their
+    // entries.
+    const ColIndex new_col = matrix.AppendEmptyColumn();
+    matrix.mutable_column(new_col)->SetCoefficient(RowIndex(0), 1.0);
+    reference.AppendEmptyColumn();
+    reference.mutable_column(new_col)->SetCoefficient(RowIndex(0), 1.0);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      CHECK(matrix.column(col).IsEmpty() ||
+            matrix.column(col).UsesEntryBlock());
+    }
+    CheckSameEntries(reference, matrix);
+
+    // A column swapped out of the matrix stays valid after the matrix is
+    // destroyed.
+    SparseColumn column;
+    {
+      SparseMatrix transpose;
+      transpose.PopulateFromTranspose(matrix);
+      column.Swap(transpose.mutable_column(ColIndex(0)));
+      CHECK(transpose.column(ColIndex(0)).IsEmpty());
+    }
+    for (const SparseColumn::Entry e : column) {
+      CHECK_EQ(matrix.LookUpValue(RowIndex(0), RowToColIndex(e.row())),
+               e.coefficient());
+    }
+    column.SetCoefficient(RowIndex(num_cols.value()), 1.0);
+  }
+
+  // Checks that a LinearProgram filled after ClearAndReserveColumnEntries()
+  // uses a single allocation and no other.
+  void TestLinearProgram(RowIndex num_rows, ColIndex num_cols, double density) {
+    SparseMatrix matrix;
+    FillRandomMatrix(num_rows, num_cols, density, &matrix);
+    matrix.CleanUp();
+    LinearProgram lp;
+    StrictITIVector<ColIndex, EntryIndex> num_entries(num_cols, EntryIndex(0));
+    for (ColIndex col(0); col < num_cols; ++col) {
+      lp.CreateNewVariable();
+      num_entries[col] = matrix.column(col).num_entries_with_duplicates();
+    }
+    for (RowIndex row(0); row < num_rows; ++row) {
+      lp.CreateNewConstraint();
+    }
+    lp.ClearAndReserveColumnEntries(num_entries);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      for (const SparseColumn::Entry e : matrix.column(col)) {
+        lp.SetCoefficient(e.row(), col, e.coefficient());
+      }
+    }
+    CheckUsesEntryBlock(lp.GetSparseMatrix());
+    CheckSameEntries(matrix, lp.GetSparseMatrix());
+    lp.CleanUp();
+    CheckUsesEntryBlock(lp.GetSparseMatrix());
+    CheckUsesEntryBlock(lp.GetTransposeSparseMatrix());
+    CheckSameEntries(matrix, lp.GetSparseMatrix());
+  }
+
+ private:
+  // Returns a copy of the given matrix whose columns each have their own
+  // allocation.
+  static void CopyColumnByColumn(const SparseMatrix& matrix,
+                                 SparseMatrix* copy) {
+    copy->PopulateFromZero(matrix.num_rows(), matrix.num_cols());
+    for (ColIndex col(0); col < matrix.num_cols(); ++col) {
+      *copy->mutable_column(col) = matrix.column(col);
+      CHECK(copy->column(col).IsEmpty() ||
+            !copy->column(col).UsesEntryBlock());
+    }
+  }
+
+  ACMRandom random_;
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+int main(int argc, char** argv) {
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  using operations_research::glop::ColIndex;
+  using operations_research::glop::RowIndex;
+  operations_research::glop::SparseMatrixTest test;
+  test.TestBuilders(RowIndex(0), ColIndex(0), 0.5);
+  test.TestBuilders(RowIndex(0), ColIndex(3), 0.5);
+  test.TestBuilders(RowIndex(5), ColIndex(0), 0.5);
+  for (const double density : {0.0, 0.1, 0.5, 1.0}) {
+    test.TestBuilders(RowIndex(30), ColIndex(50), density);
+    test.TestModifications(RowIndex(30), ColIndex(50), density);
+    test.TestLinearProgram(RowIndex(30), ColIndex(50), density);
+  }
+  return 0;
+}
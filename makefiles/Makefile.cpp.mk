@@ -285,9 +285,11 @@ CPBINARIES = \
 	$(BIN_DIR)/linear_assignment_api$E \
 	$(BIN_DIR)/ls_api$E \
 	$(BIN_DIR)/magic_square$E \
+	$(BIN_DIR)/min_cost_flow_benchmark$E \
 	$(BIN_DIR)/model_util$E \
 	$(BIN_DIR)/multidim_knapsack$E \
 	$(BIN_DIR)/network_routing$E \
+	$(BIN_DIR)/network_simplex_benchmark$E \
 	$(BIN_DIR)/nqueens$E \
 	$(BIN_DIR)/pdptw$E \
 	$(BIN_DIR)/dimacs_assignment$E \
@@ -726,15 +728,20 @@ endif
 GRAPH_LIB_OBJS=\
 	$(OBJ_DIR)/graph/simple_assignment.$O \
 	$(OBJ_DIR)/graph/linear_assignment.$O \
+	$(OBJ_DIR)/graph/auction_assignment.$O \
 	$(OBJ_DIR)/graph/cliques.$O \
 	$(OBJ_DIR)/graph/connectivity.$O \
 	$(OBJ_DIR)/graph/flow_problem.pb.$O \
 	$(OBJ_DIR)/graph/max_flow.$O \
-	$(OBJ_DIR)/graph/min_cost_flow.$O
+	$(OBJ_DIR)/graph/min_cost_flow.$O \
+	$(OBJ_DIR)/graph/network_simplex.$O
 
 $(OBJ_DIR)/graph/linear_assignment.$O:$(SRC_DIR)/graph/linear_assignment.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/linear_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Slinear_assignment.$O
 
+$(OBJ_DIR)/graph/auction_assignment.$O:$(SRC_DIR)/graph/auction_assignment.cc $(SRC_DIR)/graph/auction_assignment.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/auction_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sauction_assignment.$O
+
 $(OBJ_DIR)/graph/simple_assignment.$O:$(SRC_DIR)/graph/assignment.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Ssimple_assignment.$O
 
@@ -760,6 +767,9 @@ $(OBJ_DIR)/graph/max_flow.$O:$(SRC_DIR)/graph/max_flow.cc $(SRC_DIR)/util/stats.
 $(OBJ_DIR)/graph/min_cost_flow.$O:$(SRC_DIR)/graph/min_cost_flow.cc $(GEN_DIR)/graph/flow_problem.pb.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/min_cost_flow.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Smin_cost_flow.$O
 
+$(OBJ_DIR)/graph/network_simplex.$O:$(SRC_DIR)/graph/network_simplex.cc $(SRC_DIR)/graph/network_simplex.h $(SRC_DIR)/graph/min_cost_flow.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/network_simplex.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Snetwork_simplex.$O
+
 $(LIB_DIR)/$(LIBPREFIX)graph.$(DYNAMIC_LIB_SUFFIX): $(GRAPH_LIB_OBJS)
 	$(DYNAMIC_LINK_CMD) $(DYNAMIC_LINK_PREFIX)$(LIB_DIR)$S$(LIBPREFIX)graph.$(DYNAMIC_LIB_SUFFIX) $(GRAPH_LIB_OBJS)
 
@@ -772,12 +782,16 @@ endif
 
 SHORTESTPATHS_LIB_OBJS=\
 	$(OBJ_DIR)/graph/bellman_ford.$O \
+	$(OBJ_DIR)/graph/contraction_hierarchy.$O \
 	$(OBJ_DIR)/graph/dijkstra.$O \
 	$(OBJ_DIR)/graph/shortestpaths.$O
 
 $(OBJ_DIR)/graph/bellman_ford.$O:$(SRC_DIR)/graph/bellman_ford.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/bellman_ford.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sbellman_ford.$O
 
+$(OBJ_DIR)/graph/contraction_hierarchy.$O:$(SRC_DIR)/graph/contraction_hierarchy.cc $(SRC_DIR)/graph/contraction_hierarchy.h $(SRC_DIR)/graph/shortest_path_search.h
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/contraction_hierarchy.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Scontraction_hierarchy.$O
+
 $(OBJ_DIR)/graph/dijkstra.$O:$(SRC_DIR)/graph/dijkstra.cc
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)/graph/dijkstra.cc $(OBJ_OUT)$(OBJ_DIR)$Sgraph$Sdijkstra.$O
 
@@ -977,6 +991,7 @@ GLOP_LIB_OBJS= $(LP_DATA_OBJS) \
   $(OBJ_DIR)/glop/dual_edge_norms.$O \
   $(OBJ_DIR)/glop/entering_variable.$O \
   $(OBJ_DIR)/glop/initial_basis.$O \
+  $(OBJ_DIR)/glop/lp_snapshot.$O \
   $(OBJ_DIR)/glop/lp_solver.$O \
   $(OBJ_DIR)/glop/lu_factorization.$O \
   $(OBJ_DIR)/glop/markowitz.$O \
@@ -1011,6 +1026,9 @@ $(OBJ_DIR)/glop/entering_variable.$O:$(SRC_DIR)/glop/entering_variable.cc
 $(OBJ_DIR)/glop/initial_basis.$O:$(SRC_DIR)/glop/initial_basis.cc
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Sinitial_basis.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Sinitial_basis.$O
 
+$(OBJ_DIR)/glop/lp_snapshot.$O:$(SRC_DIR)/glop/lp_snapshot.cc
+	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Slp_snapshot.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Slp_snapshot.$O
+
 $(OBJ_DIR)/glop/lp_solver.$O:$(SRC_DIR)/glop/lp_solver.cc  $(GEN_DIR)/linear_solver/linear_solver2.pb.h
 	 $(CCC) $(CFLAGS) -c $(SRC_DIR)$Sglop$Slp_solver.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop$Slp_solver.$O
 
@@ -1107,20 +1125,17 @@ $(LIB_DIR)/$(LIBPREFIX)fap.$(DYNAMIC_LIB_SUFFIX): $(FAP_LIB_OBJS)
 FLATZINC_LIB_OBJS=\
 	$(OBJ_DIR)/flatzinc/constraints.$O\
 	$(OBJ_DIR)/flatzinc/flatzinc_constraints.$O\
+	$(OBJ_DIR)/flatzinc/lexer.$O\
 	$(OBJ_DIR)/flatzinc/model.$O\
 	$(OBJ_DIR)/flatzinc/parallel_support.$O\
 	$(OBJ_DIR)/flatzinc/parser.$O\
 	$(OBJ_DIR)/flatzinc/parser.tab.$O\
-	$(OBJ_DIR)/flatzinc/parser.yy.$O\
 	$(OBJ_DIR)/flatzinc/presolve.$O\
 	$(OBJ_DIR)/flatzinc/sat_constraint.$O\
 	$(OBJ_DIR)/flatzinc/search.$O\
 	$(OBJ_DIR)/flatzinc/sequential_support.$O\
 	$(OBJ_DIR)/flatzinc/solver.$O
 
-$(GEN_DIR)/flatzinc/parser.yy.cc: $(SRC_DIR)/flatzinc/parser.lex $(FLEX)
-	$(FLEX) -o$(GEN_DIR)/flatzinc/parser.yy.cc $(SRC_DIR)/flatzinc/parser.lex
-
 $(GEN_DIR)/flatzinc/parser.tab.cc: $(SRC_DIR)/flatzinc/parser.yy $(BISON)
 	$(BISON) -t -o $(GEN_DIR)/flatzinc/parser.tab.cc -d $<
 
@@ -1132,21 +1147,21 @@ $(OBJ_DIR)/flatzinc/constraints.$O:$(SRC_DIR)/flatzinc/constraints.cc $(SRC_DIR)
 $(OBJ_DIR)/flatzinc/flatzinc_constraints.$O:$(SRC_DIR)/flatzinc/flatzinc_constraints.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sflatzinc_constraints.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sflatzinc_constraints.$O
 
+$(OBJ_DIR)/flatzinc/lexer.$O:$(SRC_DIR)/flatzinc/lexer.cc $(SRC_DIR)/flatzinc/lexer.h $(GEN_DIR)/flatzinc/parser.tab.hh
+	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Slexer.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Slexer.$O
+
 $(OBJ_DIR)/flatzinc/model.$O:$(SRC_DIR)/flatzinc/model.cc $(SRC_DIR)/flatzinc/model.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Smodel.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Smodel.$O
 
 $(OBJ_DIR)/flatzinc/parallel_support.$O:$(SRC_DIR)/flatzinc/parallel_support.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/solver.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sparallel_support.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparallel_support.$O
 
-$(OBJ_DIR)/flatzinc/parser.$O:$(SRC_DIR)/flatzinc/parser.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(GEN_DIR)/flatzinc/parser.tab.hh
+$(OBJ_DIR)/flatzinc/parser.$O:$(SRC_DIR)/flatzinc/parser.cc $(SRC_DIR)/flatzinc/lexer.h $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(GEN_DIR)/flatzinc/parser.tab.hh
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Sparser.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparser.$O
 
-$(OBJ_DIR)/flatzinc/parser.tab.$O:$(GEN_DIR)/flatzinc/parser.tab.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(GEN_DIR)/flatzinc/parser.tab.hh
+$(OBJ_DIR)/flatzinc/parser.tab.$O:$(GEN_DIR)/flatzinc/parser.tab.cc $(SRC_DIR)/flatzinc/lexer.h $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(GEN_DIR)/flatzinc/parser.tab.hh
 	$(CCC) $(CFLAGS) -c $(GEN_DIR)$Sflatzinc$Sparser.tab.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparser.tab.$O
 
-$(OBJ_DIR)/flatzinc/parser.yy.$O:$(GEN_DIR)/flatzinc/parser.yy.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(GEN_DIR)/flatzinc/parser.tab.hh
-	$(CCC) $(CFLAGS) -c $(GEN_DIR)$Sflatzinc$Sparser.yy.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Sparser.yy.$O
-
 $(OBJ_DIR)/flatzinc/presolve.$O:$(SRC_DIR)/flatzinc/presolve.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/presolve.h
 	$(CCC) $(CFLAGS) -c $(SRC_DIR)$Sflatzinc$Spresolve.cc $(OBJ_OUT)$(OBJ_DIR)$Sflatzinc$Spresolve.$O
 
@@ -1193,6 +1208,18 @@ $(OBJ_DIR)/flow_api.$O:$(EX_DIR)/cpp/flow_api.cc
 $(BIN_DIR)/flow_api$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/flow_api.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/flow_api.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sflow_api$E
 
+$(OBJ_DIR)/min_cost_flow_benchmark.$O:$(EX_DIR)/cpp/min_cost_flow_benchmark.cc $(SRC_DIR)/graph/min_cost_flow.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/min_cost_flow_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Smin_cost_flow_benchmark.$O
+
+$(BIN_DIR)/min_cost_flow_benchmark$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/min_cost_flow_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/min_cost_flow_benchmark.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smin_cost_flow_benchmark$E
+
+$(OBJ_DIR)/network_simplex_benchmark.$O:$(EX_DIR)/cpp/network_simplex_benchmark.cc $(SRC_DIR)/graph/min_cost_flow.h $(SRC_DIR)/graph/network_simplex.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/network_simplex_benchmark.cc $(OBJ_OUT)$(OBJ_DIR)$Snetwork_simplex_benchmark.$O
+
+$(BIN_DIR)/network_simplex_benchmark$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/network_simplex_benchmark.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/network_simplex_benchmark.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Snetwork_simplex_benchmark$E
+
 $(OBJ_DIR)/dimacs_assignment.$O:$(EX_DIR)/cpp/dimacs_assignment.cc
 	$(CCC) $(CFLAGS) -c $(EX_DIR)$Scpp/dimacs_assignment.cc $(OBJ_OUT)$(OBJ_DIR)$Sdimacs_assignment.$O
 
@@ -1401,6 +1428,120 @@ $(OBJ_DIR)/cpp11_test.$O:$(EX_DIR)/tests/cpp11_test.cc
 $(BIN_DIR)/cpp11_test$E: $(OBJ_DIR)/cpp11_test.$O
 	$(CCC) $(CFLAGS) $(OBJ_DIR)/cpp11_test.$O $(EXE_OUT)$(BIN_DIR)$Scpp11_test$E
 
+$(OBJ_DIR)/knapsack_test.$O:$(EX_DIR)/tests/knapsack_test.cc $(SRC_DIR)/algorithms/knapsack_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/knapsack_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sknapsack_test.$O
+
+$(BIN_DIR)/knapsack_test$E: $(DYNAMIC_ALGORITHMS_DEPS) $(OBJ_DIR)/knapsack_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/knapsack_test.$O $(DYNAMIC_ALGORITHMS_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sknapsack_test$E
+
+$(OBJ_DIR)/compact_sparse_matrix_test.$O:$(EX_DIR)/tests/compact_sparse_matrix_test.cc $(SRC_DIR)/lp_data/sparse.h $(SRC_DIR)/lp_data/lp_utils.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/compact_sparse_matrix_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scompact_sparse_matrix_test.$O
+
+$(BIN_DIR)/compact_sparse_matrix_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/compact_sparse_matrix_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/compact_sparse_matrix_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scompact_sparse_matrix_test$E
+
+$(OBJ_DIR)/sparse_matrix_test.$O:$(EX_DIR)/tests/sparse_matrix_test.cc $(SRC_DIR)/lp_data/sparse.h $(SRC_DIR)/lp_data/sparse_vector.h $(SRC_DIR)/lp_data/lp_data.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/sparse_matrix_test.cc $(OBJ_OUT)$(OBJ_DIR)$Ssparse_matrix_test.$O
+
+$(BIN_DIR)/sparse_matrix_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/sparse_matrix_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/sparse_matrix_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Ssparse_matrix_test$E
+
+$(OBJ_DIR)/lp_snapshot_test.$O:$(EX_DIR)/tests/lp_snapshot_test.cc $(SRC_DIR)/glop/lp_snapshot.h $(SRC_DIR)/glop/lp_solver.h $(SRC_DIR)/lp_data/lp_data.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/lp_snapshot_test.cc $(OBJ_OUT)$(OBJ_DIR)$Slp_snapshot_test.$O
+
+$(BIN_DIR)/lp_snapshot_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/lp_snapshot_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/lp_snapshot_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Slp_snapshot_test$E
+
+$(OBJ_DIR)/glop_incremental_test.$O:$(EX_DIR)/tests/glop_incremental_test.cc $(SRC_DIR)/linear_solver/linear_solver.h $(SRC_DIR)/glop/lp_solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/glop_incremental_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sglop_incremental_test.$O
+
+$(BIN_DIR)/glop_incremental_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/glop_incremental_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/glop_incremental_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sglop_incremental_test$E
+
+$(OBJ_DIR)/shortest_path_search_test.$O:$(EX_DIR)/tests/shortest_path_search_test.cc $(SRC_DIR)/graph/shortest_path_search.h $(SRC_DIR)/graph/graph.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/shortest_path_search_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sshortest_path_search_test.$O
+
+$(BIN_DIR)/shortest_path_search_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/shortest_path_search_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/shortest_path_search_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sshortest_path_search_test$E
+
+$(OBJ_DIR)/contraction_hierarchy_test.$O:$(EX_DIR)/tests/contraction_hierarchy_test.cc $(SRC_DIR)/graph/contraction_hierarchy.h $(SRC_DIR)/graph/shortest_path_search.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/contraction_hierarchy_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scontraction_hierarchy_test.$O
+
+$(BIN_DIR)/contraction_hierarchy_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/contraction_hierarchy_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/contraction_hierarchy_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scontraction_hierarchy_test$E
+
+$(OBJ_DIR)/max_flow_test.$O:$(EX_DIR)/tests/max_flow_test.cc $(SRC_DIR)/graph/max_flow.h $(SRC_DIR)/graph/graph.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/max_flow_test.cc $(OBJ_OUT)$(OBJ_DIR)$Smax_flow_test.$O
+
+$(BIN_DIR)/max_flow_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/max_flow_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/max_flow_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smax_flow_test$E
+
+$(OBJ_DIR)/min_cost_flow_test.$O:$(EX_DIR)/tests/min_cost_flow_test.cc $(SRC_DIR)/graph/min_cost_flow.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/min_cost_flow_test.cc $(OBJ_OUT)$(OBJ_DIR)$Smin_cost_flow_test.$O
+
+$(BIN_DIR)/min_cost_flow_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/min_cost_flow_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/min_cost_flow_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Smin_cost_flow_test$E
+
+$(OBJ_DIR)/network_simplex_test.$O:$(EX_DIR)/tests/network_simplex_test.cc $(SRC_DIR)/graph/min_cost_flow.h $(SRC_DIR)/graph/network_simplex.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/network_simplex_test.cc $(OBJ_OUT)$(OBJ_DIR)$Snetwork_simplex_test.$O
+
+$(BIN_DIR)/network_simplex_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/network_simplex_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/network_simplex_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Snetwork_simplex_test$E
+
+$(OBJ_DIR)/auction_assignment_test.$O:$(EX_DIR)/tests/auction_assignment_test.cc $(SRC_DIR)/graph/auction_assignment.h $(SRC_DIR)/graph/linear_assignment.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/auction_assignment_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sauction_assignment_test.$O
+
+$(BIN_DIR)/auction_assignment_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/auction_assignment_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/auction_assignment_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sauction_assignment_test$E
+
+$(OBJ_DIR)/hamiltonian_path_test.$O:$(EX_DIR)/tests/hamiltonian_path_test.cc $(SRC_DIR)/graph/hamiltonian_path.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/hamiltonian_path_test.cc $(OBJ_OUT)$(OBJ_DIR)$Shamiltonian_path_test.$O
+
+$(BIN_DIR)/hamiltonian_path_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/hamiltonian_path_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/hamiltonian_path_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Shamiltonian_path_test$E
+
+$(OBJ_DIR)/cliques_test.$O:$(EX_DIR)/tests/cliques_test.cc $(SRC_DIR)/graph/cliques.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/cliques_test.cc $(OBJ_OUT)$(OBJ_DIR)$Scliques_test.$O
+
+$(BIN_DIR)/cliques_test$E: $(DYNAMIC_GRAPH_DEPS) $(OBJ_DIR)/cliques_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/cliques_test.$O $(DYNAMIC_GRAPH_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Scliques_test$E
+
+$(OBJ_DIR)/find_graph_symmetries_test.$O:$(EX_DIR)/tests/find_graph_symmetries_test.cc $(SRC_DIR)/algorithms/find_graph_symmetries.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/find_graph_symmetries_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sfind_graph_symmetries_test.$O
+
+$(BIN_DIR)/find_graph_symmetries_test$E: $(DYNAMIC_SAT_DEPS) $(OBJ_DIR)/find_graph_symmetries_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/find_graph_symmetries_test.$O $(DYNAMIC_SAT_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfind_graph_symmetries_test$E
+
+$(OBJ_DIR)/bop_solver_test.$O:$(EX_DIR)/tests/bop_solver_test.cc $(SRC_DIR)/bop/bop_solver.h $(GEN_DIR)/bop/bop_parameters.pb.h $(GEN_DIR)/sat/boolean_problem.pb.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/bop_solver_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sbop_solver_test.$O
+
+$(BIN_DIR)/bop_solver_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/bop_solver_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/bop_solver_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sbop_solver_test$E
+
+$(OBJ_DIR)/bop_ls_test.$O:$(EX_DIR)/tests/bop_ls_test.cc $(SRC_DIR)/bop/bop_ls.h $(GEN_DIR)/bop/bop_parameters.pb.h $(GEN_DIR)/sat/boolean_problem.pb.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/bop_ls_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sbop_ls_test.$O
+
+$(BIN_DIR)/bop_ls_test$E: $(DYNAMIC_LP_DEPS) $(OBJ_DIR)/bop_ls_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/bop_ls_test.$O $(DYNAMIC_LP_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sbop_ls_test$E
+
+$(OBJ_DIR)/fz_parallel_test.$O:$(EX_DIR)/tests/fz_parallel_test.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(SRC_DIR)/flatzinc/presolve.h $(SRC_DIR)/flatzinc/search.h $(SRC_DIR)/flatzinc/solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/fz_parallel_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sfz_parallel_test.$O
+
+$(BIN_DIR)/fz_parallel_test$E: $(DYNAMIC_FLATZINC_DEPS) $(OBJ_DIR)/fz_parallel_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/fz_parallel_test.$O $(DYNAMIC_FLATZINC_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfz_parallel_test$E
+
+$(OBJ_DIR)/fz_parser_test.$O:$(EX_DIR)/tests/fz_parser_test.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/fz_parser_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sfz_parser_test.$O
+
+$(BIN_DIR)/fz_parser_test$E: $(DYNAMIC_FLATZINC_DEPS) $(OBJ_DIR)/fz_parser_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/fz_parser_test.$O $(DYNAMIC_FLATZINC_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfz_parser_test$E
+
+$(OBJ_DIR)/fz_presolve_test.$O:$(EX_DIR)/tests/fz_presolve_test.cc $(SRC_DIR)/flatzinc/model.h $(SRC_DIR)/flatzinc/parser.h $(SRC_DIR)/flatzinc/presolve.h $(SRC_DIR)/flatzinc/search.h $(SRC_DIR)/flatzinc/solver.h
+	$(CCC) $(CFLAGS) -c $(EX_DIR)$Stests/fz_presolve_test.cc $(OBJ_OUT)$(OBJ_DIR)$Sfz_presolve_test.$O
+
+$(BIN_DIR)/fz_presolve_test$E: $(DYNAMIC_FLATZINC_DEPS) $(OBJ_DIR)/fz_presolve_test.$O
+	$(CCC) $(CFLAGS) $(OBJ_DIR)/fz_presolve_test.$O $(DYNAMIC_FLATZINC_LNK) $(DYNAMIC_LD_FLAGS) $(EXE_OUT)$(BIN_DIR)$Sfz_presolve_test$E
+
 # Frequency Assignment Problem
 
 $(OBJ_DIR)/frequency_assignment_problem.$O:$(EX_DIR)/cpp/frequency_assignment_problem.cc
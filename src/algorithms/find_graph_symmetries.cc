@@ -14,10 +14,15 @@
 #include "algorithms/find_graph_symmetries.h"
 
 #include <algorithm>
+#include <atomic>  // NOLINT
 #include <limits>
 #include <numeric>
+#include <utility>
 
+#include "base/callback.h"
 #include "base/commandlineflags.h"
+#include "base/hash.h"
+#include "base/threadpool.h"
 #include "base/stringprintf.h"
 #include "base/join.h"
 #include "algorithms/dense_doubly_linked_list.h"
@@ -36,6 +41,24 @@ DEFINE_bool(minimize_permutation_support_size, false,
 namespace operations_research {
 
 namespace {
+// Maximum number of rounds of the invariant pre-pass of FindSymmetries().
+const int kMaxNumHashRounds = 8;
+
+// Seeds of the hashes of the invariant pre-pass.
+const uint64 kNodeClassSeed = GG_ULONGLONG(0x9e3779b97f4a7c15);
+const uint64 kOutgoingArcSeed = GG_ULONGLONG(0xc2b2ae3d27d4eb4f);
+const uint64 kIncomingArcSeed = GG_ULONGLONG(0x165667b19e3779f9);
+
+// The work is only split among several threads above these sizes: the
+// number of nodes for the invariant pre-pass, and the number of elements in
+// the parts of a batch for the refinement by adjacency.
+const int kMinNumNodesForParallelHashing = 10000;
+const int kMinNumElementsForParallelRefinement = 10000;
+
+// The parts of a batch are split in this many chunks per thread, to balance
+// the work between the threads.
+const int kNumChunksPerThread = 4;
+
 // Some routines used below.
 void SwapFrontAndBack(std::vector<int>* v) {
   DCHECK(!v->empty());
@@ -94,6 +117,8 @@ bool ListMapsToList(const List& l1, const List& l2,
 
 GraphSymmetryFinder::GraphSymmetryFinder(const Graph& graph, bool is_undirected)
     : graph_(graph),
+      num_threads_(1),
+      use_invariant_pre_pass_(true),
       tmp_dynamic_permutation_(NumNodes()),
       tmp_node_mask_(NumNodes(), false),
       tmp_degree_(NumNodes(), 0),
@@ -182,6 +207,11 @@ inline void IncrementCounterForNonSingletons(const T& nodes,
 
 void GraphSymmetryFinder::RecursivelyRefinePartitionByAdjacency(
     int first_unrefined_part_index, DynamicPartition* partition) {
+  if (num_threads_ > 1) {
+    RefinePartitionByAdjacencyInBatches(first_unrefined_part_index, partition);
+    return;
+  }
+
   // Rename, for readability of the code below.
   std::vector<int>& tmp_nodes_with_nonzero_degree = tmp_stack_;
 
@@ -238,6 +268,150 @@ void GraphSymmetryFinder::RecursivelyRefinePartitionByAdjacency(
   }
 }
 
+struct GraphSymmetryFinder::RefinementBatch {
+  const DynamicPartition* partition;
+
+  // The parts of the batch are split in chunks of consecutive parts: chunk #c
+  // holds the parts [chunk_begin[c], chunk_begin[c + 1]).
+  std::vector<int> chunk_begin;
+
+  // For each chunk, the concatenation of the sets of nodes by which the
+  // partition must be refined, in order, and the end of each set in it.
+  std::vector<std::vector<int>> refining_nodes;
+  std::vector<std::vector<int>> refining_set_ends;
+
+  // The next chunk to process.
+  std::atomic<int> next_chunk;
+};
+
+void GraphSymmetryFinder::RefinePartitionByAdjacencyInBatches(
+    int first_unrefined_part_index, DynamicPartition* partition) {
+  // A batch is made of all the parts that weren't refined on yet. They are
+  // all processed against the partition as it is at the start of the batch,
+  // and the new parts created by the refinements go to the next batch. This
+  // yields the same final partition as the sequential version: when a part
+  // #p of the batch was split in #p and #p' before its refinements are
+  // applied, refining on the union of #p and #p', and then on #p' in the next
+  // batch, is equivalent to refining on both.
+  refinement_workers_.resize(num_threads_);
+  RefinementBatch batch;
+  batch.partition = partition;
+  std::vector<int> refining_set;
+  int batch_begin = first_unrefined_part_index;
+  while (batch_begin < partition->NumParts()) {
+    const int batch_end = partition->NumParts();
+    int64 num_elements = 0;
+    for (int p = batch_begin; p < batch_end; ++p) {
+      num_elements += partition->SizeOfPart(p);
+    }
+    const bool use_threads =
+        num_elements >= kMinNumElementsForParallelRefinement;
+    const int max_num_chunks =
+        use_threads ? kNumChunksPerThread * num_threads_ : 1;
+
+    // Split the batch in chunks with roughly the same number of elements.
+    batch.chunk_begin.assign(1, batch_begin);
+    int64 num_elements_so_far = 0;
+    for (int p = batch_begin; p + 1 < batch_end; ++p) {
+      num_elements_so_far += partition->SizeOfPart(p);
+      if (num_elements_so_far * max_num_chunks >=
+          num_elements * static_cast<int64>(batch.chunk_begin.size())) {
+        batch.chunk_begin.push_back(p + 1);
+      }
+    }
+    batch.chunk_begin.push_back(batch_end);
+    const int num_chunks = batch.chunk_begin.size() - 1;
+    if (static_cast<int>(batch.refining_nodes.size()) < num_chunks) {
+      batch.refining_nodes.resize(num_chunks);
+      batch.refining_set_ends.resize(num_chunks);
+    }
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      batch.refining_nodes[chunk].clear();
+      batch.refining_set_ends[chunk].clear();
+    }
+    batch.next_chunk = 0;
+
+    if (use_threads && num_chunks > 1) {
+      ThreadPool pool("GraphSymmetryFinder", num_threads_);
+      pool.StartWorkers();
+      for (int worker = 0; worker < num_threads_; ++worker) {
+        pool.Add(NewCallback(this, &GraphSymmetryFinder::RefineChunksOfBatch,
+                             &batch, worker));
+      }
+    } else {
+      RefineChunksOfBatch(&batch, 0);
+    }
+
+    // Apply the refinements in order, which makes the result independent of
+    // the scheduling of the threads.
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      const std::vector<int>& nodes = batch.refining_nodes[chunk];
+      int begin = 0;
+      for (const int end : batch.refining_set_ends[chunk]) {
+        refining_set.assign(nodes.begin() + begin, nodes.begin() + end);
+        partition->Refine(refining_set);
+        begin = end;
+      }
+    }
+    batch_begin = batch_end;
+  }
+}
+
+void GraphSymmetryFinder::RefineChunksOfBatch(RefinementBatch* batch,
+                                              int worker_index) {
+  RefinementWorker* const worker = &refinement_workers_[worker_index];
+  if (worker->degree.empty()) worker->degree.assign(NumNodes(), 0);
+  const DynamicPartition& partition = *batch->partition;
+  const int num_directions = reverse_adj_list_index_.empty() ? 1 : 2;
+  const int num_chunks = batch->chunk_begin.size() - 1;
+  while (true) {
+    const int chunk = batch->next_chunk.fetch_add(1);
+    if (chunk >= num_chunks) break;
+    std::vector<int>* const refining_nodes = &batch->refining_nodes[chunk];
+    std::vector<int>* const refining_set_ends =
+        &batch->refining_set_ends[chunk];
+    for (int part_index = batch->chunk_begin[chunk];
+         part_index < batch->chunk_begin[chunk + 1]; ++part_index) {
+      for (int direction = 0; direction < num_directions; ++direction) {
+        // Same as in RecursivelyRefinePartitionByAdjacency(), but the sets of
+        // nodes with each degree are output instead of being applied.
+        if (direction == 0) {
+          for (const int node : partition.ElementsInPart(part_index)) {
+            IncrementCounterForNonSingletons(
+                graph_[node], partition, &worker->degree,
+                &worker->nodes_with_nonzero_degree);
+          }
+        } else {
+          for (const int node : partition.ElementsInPart(part_index)) {
+            IncrementCounterForNonSingletons(
+                TailsOfIncomingArcsTo(node), partition, &worker->degree,
+                &worker->nodes_with_nonzero_degree);
+          }
+        }
+        int max_degree = 0;
+        for (const int node : worker->nodes_with_nonzero_degree) {
+          const int degree = worker->degree[node];
+          worker->degree[node] = 0;  // To clean up after us.
+          max_degree = std::max(max_degree, degree);
+          if (degree >= static_cast<int>(worker->nodes_with_degree.size())) {
+            worker->nodes_with_degree.resize(degree + 1);
+          }
+          worker->nodes_with_degree[degree].push_back(node);
+        }
+        worker->nodes_with_nonzero_degree.clear();  // To clean up after us.
+        for (int degree = 1; degree <= max_degree; ++degree) {
+          std::vector<int>* const nodes = &worker->nodes_with_degree[degree];
+          if (nodes->empty()) continue;
+          refining_nodes->insert(refining_nodes->end(), nodes->begin(),
+                                 nodes->end());
+          refining_set_ends->push_back(refining_nodes->size());
+          nodes->clear();  // To clean up after us.
+        }
+      }
+    }
+  }
+}
+
 void GraphSymmetryFinder::DistinguishNodeInPartition(
     int node, DynamicPartition* partition, std::vector<int>* new_singletons) {
   const int original_num_parts = partition->NumParts();
@@ -267,6 +441,93 @@ void GraphSymmetryFinder::DistinguishNodeInPartition(
   }
 }
 
+namespace {
+// Sorts "values" and returns its number of distinct values.
+int NumDistinctValues(std::vector<uint64>* values) {
+  std::sort(values->begin(), values->end());
+  return std::unique(values->begin(), values->end()) - values->begin();
+}
+}  // namespace
+
+void GraphSymmetryFinder::ComputeNextNodeHashes(
+    int begin, int end, const std::vector<uint64>* hashes,
+    std::vector<uint64>* next_hashes) const {
+  for (int node = begin; node < end; ++node) {
+    // The hashes of the neighbors are summed, so that the result doesn't
+    // depend on their order.
+    uint64 outgoing_sum = 0;
+    for (const int head : graph_[node]) {
+      outgoing_sum += Hash64NumWithSeed((*hashes)[head], kOutgoingArcSeed);
+    }
+    uint64 hash = Hash64NumWithSeed((*hashes)[node], outgoing_sum);
+    if (!reverse_adj_list_index_.empty()) {
+      uint64 incoming_sum = 0;
+      for (const int tail : TailsOfIncomingArcsTo(node)) {
+        incoming_sum += Hash64NumWithSeed((*hashes)[tail], kIncomingArcSeed);
+      }
+      hash = Hash64NumWithSeed(hash, incoming_sum);
+    }
+    (*next_hashes)[node] = hash;
+  }
+}
+
+void GraphSymmetryFinder::RefineNodeClassesByHashes(
+    std::vector<int>* node_classes) const {
+  const int num_nodes = NumNodes();
+  std::vector<uint64> hashes(num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    hashes[node] = Hash64NumWithSeed((*node_classes)[node], kNodeClassSeed);
+  }
+  std::vector<uint64> next_hashes(num_nodes);
+  std::vector<uint64> sorted_hashes = hashes;
+  int num_classes = NumDistinctValues(&sorted_hashes);
+
+  // Each round splits the classes of the nodes whose neighbors have different
+  // classes. Since the hash of a node depends on its previous hash, the
+  // classes can only be split, and the refinement is stable as soon as the
+  // number of classes stops growing.
+  const int num_threads =
+      num_nodes >= kMinNumNodesForParallelHashing ? num_threads_ : 1;
+  for (int round = 0; round < kMaxNumHashRounds; ++round) {
+    if (num_classes == num_nodes || time_limit_->LimitReached()) break;
+    if (num_threads > 1) {
+      ThreadPool pool("GraphSymmetryFinder", num_threads);
+      pool.StartWorkers();
+      for (int thread = 0; thread < num_threads; ++thread) {
+        const int begin =
+            static_cast<int64>(num_nodes) * thread / num_threads;
+        const int end =
+            static_cast<int64>(num_nodes) * (thread + 1) / num_threads;
+        pool.Add(NewCallback(this, &GraphSymmetryFinder::ComputeNextNodeHashes,
+                             begin, end, &hashes, &next_hashes));
+      }
+    } else {
+      ComputeNextNodeHashes(0, num_nodes, &hashes, &next_hashes);
+    }
+    hashes.swap(next_hashes);
+    sorted_hashes = hashes;
+    const int num_new_classes = NumDistinctValues(&sorted_hashes);
+    if (num_new_classes == num_classes) break;
+    num_classes = num_new_classes;
+  }
+
+  // The new classes are the distinct (original class, hash) pairs, so that a
+  // hash collision can never merge two original classes.
+  std::vector<std::pair<int, uint64>> keys(num_nodes);
+  for (int node = 0; node < num_nodes; ++node) {
+    keys[node] = std::make_pair((*node_classes)[node], hashes[node]);
+  }
+  std::vector<std::pair<int, uint64>> sorted_keys = keys;
+  std::sort(sorted_keys.begin(), sorted_keys.end());
+  sorted_keys.erase(std::unique(sorted_keys.begin(), sorted_keys.end()),
+                    sorted_keys.end());
+  for (int node = 0; node < num_nodes; ++node) {
+    (*node_classes)[node] =
+        std::lower_bound(sorted_keys.begin(), sorted_keys.end(), keys[node]) -
+        sorted_keys.begin();
+  }
+}
+
 namespace {
 void MergeNodeEquivalenceClassesAccordingToPermutation(
     const SparsePermutation& perm, MergingPartition* node_equivalence_classes,
@@ -358,8 +619,14 @@ util::Status GraphSymmetryFinder::FindSymmetries(
     return util::Status(util::error::INVALID_ARGUMENT,
                         "Invalid 'node_equivalence_classes_io'.");
   }
-  DynamicPartition base_partition(*node_equivalence_classes_io);
-  // Break all inherent asymmetries in the graph.
+  // Cheaply break most of the inherent asymmetries in the graph with the
+  // invariant pre-pass, then break all of them.
+  std::vector<int> node_classes = *node_equivalence_classes_io;
+  if (use_invariant_pre_pass_) {
+    ScopedTimeDistributionUpdater u(&stats_.initialization_refine_time);
+    RefineNodeClassesByHashes(&node_classes);
+  }
+  DynamicPartition base_partition(node_classes);
   {
     ScopedTimeDistributionUpdater u(&stats_.initialization_refine_time);
     RecursivelyRefinePartitionByAdjacency(/*first_unrefined_part_index=*/0,
@@ -619,7 +886,18 @@ GraphSymmetryFinder::FindOneSuitablePermutation(
     DistinguishNodeInPartition(root_node, base_partition, &base_singletons);
   }
   while (!search_states_.empty()) {
-    if (time_limit_->LimitReached()) return nullptr;
+    if (time_limit_->LimitReached()) {
+      // Restore the partitions and the temporary objects, as when a
+      // permutation is found, so that the caller can return the generators
+      // found so far.
+      const int base_num_parts =
+          search_states_[0].num_parts_before_trying_to_map_base_node;
+      base_partition->UndoRefineUntilNumPartsEqual(base_num_parts);
+      image_partition->UndoRefineUntilNumPartsEqual(base_num_parts);
+      tmp_dynamic_permutation_.Reset();
+      search_states_.clear();
+      return nullptr;
+    }
     // When exploring a SearchState "ss", we're supposed to have:
     // - A base_partition that has already been refined on ss->base_node.
     //   (base_singleton is the list of singletons created on the base
@@ -19,6 +19,7 @@
 #include "base/unique_ptr.h"
 #include <vector>
 
+#include "base/integral_types.h"
 #include "algorithms/dynamic_partition.h"
 #include "algorithms/dynamic_permutation.h"
 #include "graph/graph.h"
@@ -48,6 +49,18 @@ class GraphSymmetryFinder {
   // TODO(user): support multi-arcs.
   GraphSymmetryFinder(const Graph& graph, bool is_undirected);
 
+  // Sets the number of threads used by FindSymmetries() to compute the node
+  // invariants of its pre-pass, and to refine the partitions by adjacency.
+  // The default is 1. See RecursivelyRefinePartitionByAdjacency().
+  void set_num_threads(int num_threads) { num_threads_ = num_threads; }
+
+  // Whether FindSymmetries() starts with the invariant pre-pass described
+  // below. The default is true. Disabling it gives the same search as before
+  // the pre-pass existed, which is mostly useful to compare the results.
+  void set_use_invariant_pre_pass(bool use_invariant_pre_pass) {
+    use_invariant_pre_pass_ = use_invariant_pre_pass;
+  }
+
   // Whether the given permutation is an automorphism of the graph given at
   // construction. This costs O(sum(degree(x))) (the sum is over all nodes x
   // that are displaced by the permutation).
@@ -91,6 +104,17 @@ class GraphSymmetryFinder {
   // - "factorized_automorphism_group_size" will also be incomplete, and
   //   partially valid: its last element may be undervalued. But all prior
   //   elements are valid factors of the automorphism group size.
+  // The search can thus be used in an "anytime" fashion: with a short time
+  // limit, the generators found so far can still be used to break symmetries.
+  //
+  // INVARIANT PRE-PASS:
+  // Before the search, the node equivalence classes are refined by a cheap
+  // invariant: a hash of the class of each node, iteratively mixed with the
+  // hashes of its neighbors (a few rounds of Weisfeiler-Lehman color
+  // refinement). Since any automorphism preserves these hashes, this doesn't
+  // change the result, but it splits most of the classes at a fraction of the
+  // cost of RecursivelyRefinePartitionByAdjacency(). It can be disabled with
+  // set_use_invariant_pre_pass(false).
   //
   // This method is largely based on the following article, published in 2008:
   // "Faster Symmetry Discovery using Sparsity of Symmetries" by Darga, Sakallah
@@ -113,6 +137,13 @@ class GraphSymmetryFinder {
   // In our use cases, we may call this in a scenario where the partition was
   // already partially refined on all parts #0...#K, then you should set
   // "first_unrefined_part_index" to K+1.
+  //
+  // With several threads (see set_num_threads()), the parts are processed by
+  // batches: all the parts created by the previous batch are scanned in
+  // parallel, each thread grouping the nodes by degree in its own buckets, and
+  // the resulting refinements are then applied in order. The final partition
+  // is the same (the coarsest equitable refinement), but the part indices may
+  // differ from the ones obtained with a single thread.
   void RecursivelyRefinePartitionByAdjacency(
       int first_unrefined_part_index, DynamicPartition* partition);
 
@@ -128,6 +159,35 @@ class GraphSymmetryFinder {
 
   inline int NumNodes() const { return graph_.num_nodes(); }
 
+  int num_threads_;
+  bool use_invariant_pre_pass_;
+
+  // The invariant pre-pass of FindSymmetries(): refines "node_classes" by the
+  // hashes of the iterated neighborhoods of the nodes. The output classes are
+  // dense, and two nodes that were in different classes are still in
+  // different classes, even in case of hash collisions.
+  void RefineNodeClassesByHashes(std::vector<int>* node_classes) const;
+
+  // Computes one round of the hashes of RefineNodeClassesByHashes() for the
+  // nodes in [begin, end), as a function of the previous round.
+  void ComputeNextNodeHashes(int begin, int end,
+                             const std::vector<uint64>* hashes,
+                             std::vector<uint64>* next_hashes) const;
+
+  // The multi-threaded version of RecursivelyRefinePartitionByAdjacency(). The
+  // parts of a batch are split in chunks which are processed by
+  // RefineChunksOfBatch(), each worker with its own RefinementWorker.
+  struct RefinementBatch;
+  struct RefinementWorker {
+    std::vector<int> degree;                            // [0..N-1] = 0.
+    std::vector<int> nodes_with_nonzero_degree;         // Empty.
+    std::vector<std::vector<int>> nodes_with_degree;    // All empty.
+  };
+  void RefinePartitionByAdjacencyInBatches(int first_unrefined_part_index,
+                                           DynamicPartition* partition);
+  void RefineChunksOfBatch(RefinementBatch* batch, int worker_index);
+  std::vector<RefinementWorker> refinement_workers_;
+
   // If the graph isn't symmetric, then we store the reverse adjacency lists
   // here: for each i in 0..NumNodes()-1, the list of nodes that have an
   // outgoing arc to i is stored (sorted by node) in:
@@ -14,7 +14,9 @@
 //
 // IMPORTANT NOTE: we advise to use the code in
 // graph/linear_assignment.h whose complexity is
-// usually much smaller.
+// usually much smaller. For dense problems with integer
+// costs, DenseLinearSumAssignment in graph/auction_assignment.h
+// takes the cost matrix directly.
 // TODO(user): base this code on LinearSumAssignment.
 //
 // See: //depot/google3/java/com/google/wireless/genie/frontend
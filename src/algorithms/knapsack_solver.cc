@@ -15,11 +15,17 @@
 #include "algorithms/knapsack_solver.h"
 
 #include <algorithm>
+#include <atomic>
+#include <limits>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "base/callback.h"
+#include "base/mutex.h"
 #include "base/stl_util.h"
+#include "base/threadpool.h"
 #include "linear_solver/linear_solver.h"
 #include "util/bitset.h"
 
@@ -30,6 +36,11 @@ const int kNoSelection = -1;
 const int kMasterPropagatorId = 0;
 const int kMaxNumberOfBruteForceItems = 30;
 const int kMaxNumberOf64Items = 64;
+const int kMaxNumberOfDominanceItems = 2048;
+// Maximum number of open nodes in the queue of KnapsackParallelSolver.
+const int kMaxNumberOfOpenNodes = 1 << 20;
+// Relative tolerance on the bounds computed with doubles.
+const double kRelativeTolerance = 1e-9;
 
 // Comparator used to sort item in decreasing efficiency order
 // (see KnapsackCapacityPropagator).
@@ -393,17 +404,17 @@ int64 KnapsackGenericSolver::Solve() {
 
   SearchQueue search_queue;
   const KnapsackAssignment assignment(kNoSelection, true);
-  KnapsackSearchNode* root_node = new KnapsackSearchNode(NULL, assignment);
+  search_nodes_.emplace_back(nullptr, assignment);
+  KnapsackSearchNode* const root_node = &search_nodes_.back();
   root_node->set_current_profit(GetCurrentProfit());
   root_node->set_profit_upper_bound(GetAggregatedProfitUpperBound());
   root_node->set_next_item_id(GetNextItemId());
-  search_nodes_.push_back(root_node);
 
   if (MakeNewNode(*root_node, false)) {
-    search_queue.push(search_nodes_.back());
+    search_queue.push(&search_nodes_.back());
   }
   if (MakeNewNode(*root_node, true)) {
-    search_queue.push(search_nodes_.back());
+    search_queue.push(&search_nodes_.back());
   }
 
   KnapsackSearchNode* current_node = root_node;
@@ -421,10 +432,10 @@ int64 KnapsackGenericSolver::Solve() {
     }
 
     if (MakeNewNode(*node, false)) {
-      search_queue.push(search_nodes_.back());
+      search_queue.push(&search_nodes_.back());
     }
     if (MakeNewNode(*node, true)) {
-      search_queue.push(search_nodes_.back());
+      search_queue.push(&search_nodes_.back());
     }
   }
   return best_solution_profit_;
@@ -432,7 +443,7 @@ int64 KnapsackGenericSolver::Solve() {
 
 void KnapsackGenericSolver::Clear() {
   STLDeleteElements(&propagators_);
-  STLDeleteElements(&search_nodes_);
+  search_nodes_.clear();
 }
 
 // Returns false when at least one propagator fails.
@@ -492,11 +503,11 @@ bool KnapsackGenericSolver::MakeNewNode(const KnapsackSearchNode& node,
   }
 
   // The node is relevant.
-  KnapsackSearchNode* relevant_node = new KnapsackSearchNode(&node, assignment);
+  search_nodes_.emplace_back(&node, assignment);
+  KnapsackSearchNode* const relevant_node = &search_nodes_.back();
   relevant_node->set_current_profit(new_node.current_profit());
   relevant_node->set_profit_upper_bound(new_node.profit_upper_bound());
   relevant_node->set_next_item_id(new_node.next_item_id());
-  search_nodes_.push_back(relevant_node);
 
   return true;
 }
@@ -1081,6 +1092,660 @@ int64 KnapsackMIPSolver::Solve() {
   return -objective->Value() + kRoundNear;
 }
 
+// ----- KnapsackParallelSolver -----
+// KnapsackParallelSolver solves the multi-dimensional knapsack problem with a
+// best-first branch and bound, which can be run by several threads.
+//
+// The bounds are based on the linear relaxation of the problem, which is
+// solved once by GLOP in Init. Its dual values u give the surrogate constraint
+// Sum(i:1..n)(u.weight_i * item_i) <= u.capacity, which is implied by the d
+// capacity constraints. At each search node, the linear relaxation of this
+// one-dimension constraint is solved in O(log(n)) (see Dantzig bound); at the
+// root node, it is equal to the linear relaxation of the problem. The items
+// are assigned in decreasing order of surrogate efficiency, so that the first
+// dive builds the greedy solution, and the capacities are checked exactly.
+// The dual values also give Lagrangian bounds when an item is in or out of
+// the knapsack, which are used by KnapsackSolver to reduce large problems to
+// their core items, ie. the items which are not fixed by the bounds.
+//
+// An item dominates another one when its profit is greater or equal and its
+// weights are lower or equal in all dimensions. There is an optimal solution
+// in which a dominated item is only packed when the dominating item is, so the
+// nodes which break this rule are not explored.
+//
+// The open nodes are kept in a priority queue, shared by all threads and
+// protected by a mutex. Each thread pops the node with the highest bound, then
+// dives into its best child and pushes the other one, until the dive reaches a
+// leaf or can be pruned. The profit of the best solution found so far is
+// shared by all threads. The states of the open nodes (consumed capacities
+// and packed items) are stored in a pool of fixed-size slots, which are
+// reused once the nodes are popped. The threads wait on a condition variable
+// while the queue is empty and other threads are still diving. When the queue
+// is full (see kMaxNumberOfOpenNodes), a thread keeps the other child for
+// itself and explores it depth-first after its dive, which needs at most one
+// pending node per depth.
+class KnapsackParallelSolver : public BaseKnapsackSolver {
+ public:
+  explicit KnapsackParallelSolver(const std::string& solver_name);
+
+  // Initializes the solver and enters the problem to be solved.
+  void Init(const std::vector<int64>& profits,
+            const std::vector<std::vector<int64> >& weights,
+            const std::vector<int64>& capacities) override;
+
+  // Gets the Lagrangian upper bound when the item is in or out of the
+  // knapsack, and the profit of the greedy solution as lower bound.
+  void GetLowerAndUpperBoundWhenItem(int item_id, bool is_item_in,
+                                     int64* lower_bound,
+                                     int64* upper_bound) override;
+
+  // Solves the problem and returns the profit of the optimal solution.
+  int64 Solve() override;
+
+  // Returns true if the item 'item_id' is packed in the optimal knapsack.
+  bool best_solution(int item_id) const override {
+    return best_solution_.at(item_id);
+  }
+
+  void set_num_threads(int num_threads) override {
+    num_threads_ = num_threads;
+  }
+
+ private:
+  // The state of a search node: the items at positions [0, depth) of 'order_'
+  // are assigned, and 'is_in' has one bit per position.
+  struct NodeState {
+    int depth;
+    int64 profit;
+    std::vector<int64> consumed_capacities;
+    std::vector<uint64> is_in;
+  };
+
+  // A node of the priority queue, whose state is stored in the slot 'slot' of
+  // the pool. The node with the highest upper bound, then with the highest
+  // profit, is popped first.
+  struct OpenNode {
+    bool operator<(const OpenNode& other) const {
+      if (upper_bound == other.upper_bound) {
+        return profit < other.profit;
+      }
+      return upper_bound < other.upper_bound;
+    }
+
+    int64 upper_bound;
+    int64 profit;
+    int depth;
+    int slot;
+  };
+
+  // Computes the multipliers of the surrogate constraint from the dual values
+  // of the linear relaxation.
+  void ComputeMultipliers();
+  // Sorts the items which fit in the knapsack by decreasing surrogate
+  // efficiency, and computes the Lagrangian bound of the problem.
+  void ComputeOrder();
+  // Packs the items in 'order_' as long as they fit.
+  void ComputeGreedySolution();
+  // Fills 'dominators_' and 'dominated_items_' when there are not too many
+  // items.
+  void ComputeDominance();
+
+  // Returns an upper bound of the profit of the nodes at the given depth,
+  // given their profit and remaining surrogate capacity.
+  int64 GetUpperBound(int depth, int64 profit,
+                      double remaining_surrogate_capacity) const;
+  double GetRemainingSurrogateCapacity(const NodeState& state) const;
+  // Returns true when the item at the next position can be packed, resp. left
+  // out, in the given state.
+  bool CanPackNextItem(const NodeState& state) const;
+  bool CanLeaveOutNextItem(const NodeState& state) const;
+  // Applies the decision on the item at the next position to 'state'.
+  void AssignNextItem(bool is_in, NodeState* state) const;
+  // Returns the largest integer lower or equal to 'value', up to a tolerance
+  // which makes up for the rounding errors.
+  int64 FloorWithTolerance(double value) const;
+
+  // Search. The methods which access the queue and the pool lock the mutex.
+  void RunWorker();
+  // Dives from 'state', then from the children that could not be pushed
+  // because the queue was full.
+  void Search(NodeState* state);
+  // Dives from 'state' until a leaf, or until it can be pruned. The other
+  // children are pushed in the queue, or appended to 'pending_nodes' when it
+  // is full.
+  void Dive(NodeState* state, std::vector<std::pair<int64, NodeState> >*
+                                  pending_nodes);
+  bool PopNode(NodeState* state);
+  // Returns false, and does nothing, when the queue is full.
+  bool PushChild(const NodeState& state, bool is_item_in, int64 upper_bound);
+  void UpdateBestSolution(const NodeState& state);
+
+  std::vector<int64> profits_;
+  std::vector<std::vector<int64> > weights_;
+  std::vector<int64> capacities_;
+  int num_threads_;
+
+  // Surrogate relaxation.
+  std::vector<double> multipliers_;
+  std::vector<double> surrogate_weights_;
+  double surrogate_capacity_;
+  double lagrangian_bound_;
+  std::vector<bool> fits_;
+
+  // Items which fit in the knapsack, by position, with the prefix sums of
+  // their surrogate weights and profits.
+  std::vector<int> order_;
+  std::vector<double> prefix_surrogate_weights_;
+  std::vector<double> prefix_profits_;
+  int num_words_;
+  int64 greedy_profit_;
+  std::vector<uint64> greedy_is_in_;
+
+  // When 'use_dominance_' is true, the num_words_ words at
+  // position * num_words_ in 'dominators_' (resp. 'dominated_items_') have
+  // the bits of the previous positions whose item dominates the item at
+  // 'position' (resp. is dominated by it).
+  bool use_dominance_;
+  std::vector<uint64> dominators_;
+  std::vector<uint64> dominated_items_;
+
+  // Shared search data.
+  Mutex mutex_;
+  // Signaled when a node is pushed, or when the search is over.
+  CondVar node_pushed_;
+  std::priority_queue<OpenNode> open_nodes_;
+  std::vector<int64> slot_consumed_capacities_;
+  std::vector<uint64> slot_is_in_;
+  std::vector<int> free_slots_;
+  int num_slots_;
+  int num_active_workers_;
+  std::atomic<int64> best_profit_;
+  std::vector<uint64> best_is_in_;
+  std::vector<bool> best_solution_;
+
+  DISALLOW_COPY_AND_ASSIGN(KnapsackParallelSolver);
+};
+
+KnapsackParallelSolver::KnapsackParallelSolver(const std::string& solver_name)
+    : BaseKnapsackSolver(solver_name),
+      num_threads_(1),
+      surrogate_capacity_(0.0),
+      lagrangian_bound_(0.0),
+      num_words_(0),
+      greedy_profit_(0LL),
+      use_dominance_(false),
+      num_slots_(0),
+      num_active_workers_(0),
+      best_profit_(0LL) {}
+
+void KnapsackParallelSolver::Init(
+    const std::vector<int64>& profits,
+    const std::vector<std::vector<int64> >& weights,
+    const std::vector<int64>& capacities) {
+  CHECK_EQ(capacities.size(), weights.size());
+  const int num_items = profits.size();
+  for (const std::vector<int64>& one_dimension_weights : weights) {
+    CHECK_EQ(num_items, one_dimension_weights.size());
+  }
+  profits_ = profits;
+  weights_ = weights;
+  capacities_ = capacities;
+  best_solution_.assign(num_items, false);
+  use_dominance_ = false;
+
+  ComputeMultipliers();
+  ComputeOrder();
+  ComputeGreedySolution();
+}
+
+void KnapsackParallelSolver::ComputeMultipliers() {
+  const int num_items = profits_.size();
+  const int num_dimensions = capacities_.size();
+  multipliers_.assign(num_dimensions, 0.0);
+  if (num_items == 0 || num_dimensions == 0) return;
+#if defined(USE_GLOP)
+  MPSolver solver(GetName(), MPSolver::GLOP_LINEAR_PROGRAMMING);
+  std::vector<MPVariable*> variables;
+  solver.MakeNumVarArray(num_items, 0.0, 1.0, "x", &variables);
+  std::vector<MPConstraint*> constraints(num_dimensions);
+  for (int dim = 0; dim < num_dimensions; ++dim) {
+    constraints[dim] =
+        solver.MakeRowConstraint(-solver.infinity(), capacities_[dim]);
+    for (int item = 0; item < num_items; ++item) {
+      constraints[dim]->SetCoefficient(variables[item], weights_[dim][item]);
+    }
+  }
+  MPObjective* const objective = solver.MutableObjective();
+  for (int item = 0; item < num_items; ++item) {
+    objective->SetCoefficient(variables[item], profits_[item]);
+  }
+  objective->SetMaximization();
+  solver.SuppressOutput();
+  if (solver.Solve() == MPSolver::OPTIMAL) {
+    // The sign of the dual values depends on the conventions of the solver,
+    // the multipliers of <= constraints are non-negative.
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      multipliers_[dim] = fabs(constraints[dim]->dual_value());
+    }
+    return;
+  }
+#endif  // USE_GLOP
+  // Any non-negative multipliers give valid bounds. Without the dual values,
+  // the weights are normalized by the capacities.
+  for (int dim = 0; dim < num_dimensions; ++dim) {
+    if (capacities_[dim] > 0) {
+      multipliers_[dim] = 1.0 / static_cast<double>(capacities_[dim]);
+    }
+  }
+}
+
+void KnapsackParallelSolver::ComputeOrder() {
+  const int num_items = profits_.size();
+  const int num_dimensions = capacities_.size();
+  surrogate_capacity_ = 0.0;
+  for (int dim = 0; dim < num_dimensions; ++dim) {
+    surrogate_capacity_ += multipliers_[dim] * capacities_[dim];
+  }
+  lagrangian_bound_ = surrogate_capacity_;
+  surrogate_weights_.assign(num_items, 0.0);
+  fits_.assign(num_items, true);
+  std::vector<double> efficiencies(num_items, 0.0);
+  order_.clear();
+  for (int item = 0; item < num_items; ++item) {
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      surrogate_weights_[item] += multipliers_[dim] * weights_[dim][item];
+      if (weights_[dim][item] > capacities_[dim]) fits_[item] = false;
+    }
+    // The items which do not fit are never packed, and are left out of the
+    // relaxations.
+    if (!fits_[item]) continue;
+    order_.push_back(item);
+    lagrangian_bound_ +=
+        std::max(0.0, profits_[item] - surrogate_weights_[item]);
+    efficiencies[item] =
+        surrogate_weights_[item] > 0.0
+            ? profits_[item] / surrogate_weights_[item]
+            : std::numeric_limits<double>::infinity();
+  }
+  std::stable_sort(order_.begin(), order_.end(), [&efficiencies](int a, int b) {
+    return efficiencies[a] > efficiencies[b];
+  });
+
+  const int num_positions = order_.size();
+  prefix_surrogate_weights_.assign(num_positions + 1, 0.0);
+  prefix_profits_.assign(num_positions + 1, 0.0);
+  for (int position = 0; position < num_positions; ++position) {
+    const int item = order_[position];
+    prefix_surrogate_weights_[position + 1] =
+        prefix_surrogate_weights_[position] + surrogate_weights_[item];
+    prefix_profits_[position + 1] = prefix_profits_[position] + profits_[item];
+  }
+  num_words_ = BitLength64(num_positions);
+}
+
+void KnapsackParallelSolver::ComputeGreedySolution() {
+  NodeState state;
+  state.depth = 0;
+  state.profit = 0LL;
+  state.consumed_capacities.assign(capacities_.size(), 0LL);
+  state.is_in.assign(num_words_, 0ULL);
+  const int num_positions = order_.size();
+  while (state.depth < num_positions) {
+    AssignNextItem(CanPackNextItem(state), &state);
+  }
+  greedy_profit_ = state.profit;
+  greedy_is_in_.swap(state.is_in);
+}
+
+void KnapsackParallelSolver::ComputeDominance() {
+  const int num_positions = order_.size();
+  const int num_dimensions = capacities_.size();
+  use_dominance_ = num_positions <= kMaxNumberOfDominanceItems;
+  dominators_.clear();
+  dominated_items_.clear();
+  if (!use_dominance_) return;
+  dominators_.assign(num_positions * num_words_, 0ULL);
+  dominated_items_.assign(num_positions * num_words_, 0ULL);
+  // Item 'a' dominates item 'b' when it is at least as good in all respects.
+  // Equal items are ordered by position, so that the relation has no cycle.
+  auto dominates = [this, num_dimensions](int a, int b) {
+    if (profits_[a] < profits_[b]) return false;
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      if (weights_[dim][a] > weights_[dim][b]) return false;
+    }
+    return true;
+  };
+  for (int position = 0; position < num_positions; ++position) {
+    const int item = order_[position];
+    uint64* const dominators = &dominators_[position * num_words_];
+    uint64* const dominated_items = &dominated_items_[position * num_words_];
+    for (int previous = 0; previous < position; ++previous) {
+      const int previous_item = order_[previous];
+      if (dominates(previous_item, item)) {
+        SetBit64(dominators, previous);
+      } else if (dominates(item, previous_item)) {
+        SetBit64(dominated_items, previous);
+      }
+    }
+  }
+}
+
+int64 KnapsackParallelSolver::FloorWithTolerance(double value) const {
+  const double rounded_value =
+      floor(value + kRelativeTolerance * (1.0 + prefix_profits_.back()));
+  return rounded_value >= static_cast<double>(kint64max)
+             ? kint64max
+             : static_cast<int64>(rounded_value);
+}
+
+int64 KnapsackParallelSolver::GetUpperBound(
+    int depth, int64 profit, double remaining_surrogate_capacity) const {
+  const int num_positions = order_.size();
+  // The capacity is rounded up, so that the items which fit up to the rounding
+  // errors are not taken for break items.
+  const double max_surrogate_weight =
+      prefix_surrogate_weights_[depth] +
+      std::max(0.0, remaining_surrogate_capacity) +
+      kRelativeTolerance * (1.0 + prefix_surrogate_weights_.back());
+  // The break position is the last position whose prefix fits.
+  const int break_position =
+      std::upper_bound(prefix_surrogate_weights_.begin() + depth + 1,
+                       prefix_surrogate_weights_.end(), max_surrogate_weight) -
+      prefix_surrogate_weights_.begin() - 1;
+  double additional_profit =
+      prefix_profits_[break_position] - prefix_profits_[depth];
+  if (break_position < num_positions) {
+    // As in KnapsackCapacityPropagator::GetAdditionalProfit, the Martello-Toth
+    // bound U2 enforces the integrality of the break item: either it is out,
+    // and the next item fills the remaining capacity, or it is in, and the
+    // previous item makes room for it.
+    const double remaining_capacity =
+        max_surrogate_weight - prefix_surrogate_weights_[break_position];
+    const int break_item = order_[break_position];
+    DCHECK_GT(surrogate_weights_[break_item], 0.0);
+    double additional_profit_when_no_break_item = 0.0;
+    if (break_position + 1 < num_positions) {
+      const int next_item = order_[break_position + 1];
+      additional_profit_when_no_break_item = remaining_capacity *
+                                             profits_[next_item] /
+                                             surrogate_weights_[next_item];
+    }
+    double additional_profit_when_break_item = 0.0;
+    if (break_position > depth) {
+      // When the previous surrogate weight is zero, the break item does not
+      // fit even alone.
+      const int previous_item = order_[break_position - 1];
+      if (surrogate_weights_[previous_item] > 0.0) {
+        additional_profit_when_break_item =
+            profits_[break_item] -
+            (surrogate_weights_[break_item] - remaining_capacity) *
+                profits_[previous_item] / surrogate_weights_[previous_item];
+      }
+    }
+    additional_profit += std::max(additional_profit_when_no_break_item,
+                                  additional_profit_when_break_item);
+  }
+  const int64 additional_profit_bound = FloorWithTolerance(additional_profit);
+  return additional_profit_bound >= kint64max - profit
+             ? kint64max
+             : profit + additional_profit_bound;
+}
+
+double KnapsackParallelSolver::GetRemainingSurrogateCapacity(
+    const NodeState& state) const {
+  double remaining_capacity = surrogate_capacity_;
+  const int num_dimensions = capacities_.size();
+  for (int dim = 0; dim < num_dimensions; ++dim) {
+    remaining_capacity -= multipliers_[dim] * state.consumed_capacities[dim];
+  }
+  return remaining_capacity;
+}
+
+bool KnapsackParallelSolver::CanPackNextItem(const NodeState& state) const {
+  const int item = order_[state.depth];
+  const int num_dimensions = capacities_.size();
+  for (int dim = 0; dim < num_dimensions; ++dim) {
+    if (state.consumed_capacities[dim] + weights_[dim][item] >
+        capacities_[dim]) {
+      return false;
+    }
+  }
+  if (use_dominance_) {
+    // All dominating items at previous positions must be in.
+    const uint64* const dominators = &dominators_[state.depth * num_words_];
+    for (int word = 0; word < num_words_; ++word) {
+      if ((dominators[word] & ~state.is_in[word]) != 0ULL) return false;
+    }
+  }
+  return true;
+}
+
+bool KnapsackParallelSolver::CanLeaveOutNextItem(const NodeState& state) const {
+  if (use_dominance_) {
+    // All dominated items at previous positions must be out.
+    const uint64* const dominated_items =
+        &dominated_items_[state.depth * num_words_];
+    for (int word = 0; word < num_words_; ++word) {
+      if ((dominated_items[word] & state.is_in[word]) != 0ULL) return false;
+    }
+  }
+  return true;
+}
+
+void KnapsackParallelSolver::AssignNextItem(bool is_in,
+                                            NodeState* state) const {
+  if (is_in) {
+    const int item = order_[state->depth];
+    const int num_dimensions = capacities_.size();
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      state->consumed_capacities[dim] += weights_[dim][item];
+    }
+    state->profit += profits_[item];
+    SetBit64(state->is_in.data(), state->depth);
+  }
+  ++state->depth;
+}
+
+int64 KnapsackParallelSolver::Solve() {
+  ComputeDominance();
+  best_profit_ = greedy_profit_;
+  best_is_in_ = greedy_is_in_;
+  open_nodes_ = std::priority_queue<OpenNode>();
+  slot_consumed_capacities_.clear();
+  slot_is_in_.clear();
+  free_slots_.clear();
+  num_slots_ = 0;
+  num_active_workers_ = 0;
+
+  // The root node is pushed as the 'out' child of a fake node at depth -1.
+  NodeState root;
+  root.depth = -1;
+  root.profit = 0LL;
+  root.consumed_capacities.assign(capacities_.size(), 0LL);
+  root.is_in.assign(num_words_, 0ULL);
+  const int64 root_upper_bound = GetUpperBound(0, 0LL, surrogate_capacity_);
+  if (root_upper_bound > best_profit_) {
+    PushChild(root, false, root_upper_bound);
+    if (num_threads_ <= 1) {
+      RunWorker();
+    } else {
+      ThreadPool pool("KnapsackParallelSolver", num_threads_);
+      pool.StartWorkers();
+      for (int i = 0; i < num_threads_; ++i) {
+        pool.Add(NewCallback(this, &KnapsackParallelSolver::RunWorker));
+      }
+    }
+  }
+
+  const int num_positions = order_.size();
+  best_solution_.assign(profits_.size(), false);
+  for (int position = 0; position < num_positions; ++position) {
+    if (IsBitSet64(best_is_in_.data(), position)) {
+      best_solution_[order_[position]] = true;
+    }
+  }
+  return best_profit_;
+}
+
+void KnapsackParallelSolver::RunWorker() {
+  NodeState state;
+  while (PopNode(&state)) {
+    Search(&state);
+    MutexLock lock(&mutex_);
+    --num_active_workers_;
+    // Wakes up the waiting workers so that they see the end of the search.
+    if (num_active_workers_ == 0 && open_nodes_.empty()) {
+      node_pushed_.SignalAll();
+    }
+  }
+}
+
+bool KnapsackParallelSolver::PopNode(NodeState* state) {
+  MutexLock lock(&mutex_);
+  for (;;) {
+    // The queue is sorted by decreasing bound: when its top node can be
+    // pruned, all its nodes can.
+    while (!open_nodes_.empty() &&
+           open_nodes_.top().upper_bound <= best_profit_) {
+      free_slots_.push_back(open_nodes_.top().slot);
+      open_nodes_.pop();
+    }
+    if (!open_nodes_.empty()) {
+      const OpenNode node = open_nodes_.top();
+      open_nodes_.pop();
+      const int num_dimensions = capacities_.size();
+      const int64* const consumed_capacities =
+          slot_consumed_capacities_.data() + node.slot * num_dimensions;
+      const uint64* const is_in = slot_is_in_.data() + node.slot * num_words_;
+      state->depth = node.depth;
+      state->profit = node.profit;
+      state->consumed_capacities.assign(consumed_capacities,
+                                        consumed_capacities + num_dimensions);
+      state->is_in.assign(is_in, is_in + num_words_);
+      free_slots_.push_back(node.slot);
+      ++num_active_workers_;
+      return true;
+    }
+    // The search is over when no other worker can push new nodes.
+    if (num_active_workers_ == 0) return false;
+    node_pushed_.Wait(&mutex_);
+  }
+}
+
+bool KnapsackParallelSolver::PushChild(const NodeState& state,
+                                       bool is_item_in, int64 upper_bound) {
+  MutexLock lock(&mutex_);
+  if (open_nodes_.size() >= kMaxNumberOfOpenNodes) return false;
+  int slot = 0;
+  if (free_slots_.empty()) {
+    slot = num_slots_++;
+    slot_consumed_capacities_.resize(num_slots_ * capacities_.size());
+    slot_is_in_.resize(num_slots_ * num_words_);
+  } else {
+    slot = free_slots_.back();
+    free_slots_.pop_back();
+  }
+  const int num_dimensions = capacities_.size();
+  int64* const consumed_capacities =
+      slot_consumed_capacities_.data() + slot * num_dimensions;
+  uint64* const is_in = slot_is_in_.data() + slot * num_words_;
+  std::copy(state.consumed_capacities.begin(), state.consumed_capacities.end(),
+            consumed_capacities);
+  std::copy(state.is_in.begin(), state.is_in.end(), is_in);
+  OpenNode node;
+  node.upper_bound = upper_bound;
+  node.profit = state.profit;
+  node.depth = state.depth + 1;
+  node.slot = slot;
+  if (is_item_in) {
+    const int item = order_[state.depth];
+    for (int dim = 0; dim < num_dimensions; ++dim) {
+      consumed_capacities[dim] += weights_[dim][item];
+    }
+    node.profit += profits_[item];
+    SetBit64(is_in, state.depth);
+  }
+  open_nodes_.push(node);
+  node_pushed_.Signal();
+  return true;
+}
+
+void KnapsackParallelSolver::Search(NodeState* state) {
+  // The pending nodes are explored depth-first: each dive appends at most one
+  // node per depth below its start, so there are at most order_.size() of
+  // them. Each one comes with its upper bound.
+  std::vector<std::pair<int64, NodeState> > pending_nodes;
+  Dive(state, &pending_nodes);
+  while (!pending_nodes.empty()) {
+    NodeState pending_state;
+    std::swap(pending_state, pending_nodes.back().second);
+    const int64 upper_bound = pending_nodes.back().first;
+    pending_nodes.pop_back();
+    if (upper_bound > best_profit_) Dive(&pending_state, &pending_nodes);
+  }
+}
+
+void KnapsackParallelSolver::Dive(
+    NodeState* state,
+    std::vector<std::pair<int64, NodeState> >* pending_nodes) {
+  const int num_positions = order_.size();
+  while (state->depth < num_positions) {
+    const int item = order_[state->depth];
+    const double remaining_surrogate_capacity =
+        GetRemainingSurrogateCapacity(*state);
+    int64 in_upper_bound = kint64min;
+    int64 out_upper_bound = kint64min;
+    if (CanPackNextItem(*state)) {
+      in_upper_bound = GetUpperBound(
+          state->depth + 1, state->profit + profits_[item],
+          remaining_surrogate_capacity - surrogate_weights_[item]);
+    }
+    if (CanLeaveOutNextItem(*state)) {
+      out_upper_bound = GetUpperBound(state->depth + 1, state->profit,
+                                      remaining_surrogate_capacity);
+    }
+    const int64 best_profit = best_profit_;
+    const bool is_in = in_upper_bound >= out_upper_bound;
+    if (std::max(in_upper_bound, out_upper_bound) <= best_profit) return;
+    const int64 other_upper_bound = std::min(in_upper_bound, out_upper_bound);
+    if (other_upper_bound > best_profit &&
+        !PushChild(*state, !is_in, other_upper_bound)) {
+      pending_nodes->push_back(std::make_pair(other_upper_bound, *state));
+      AssignNextItem(!is_in, &pending_nodes->back().second);
+    }
+    AssignNextItem(is_in, state);
+  }
+  if (state->profit > best_profit_) {
+    UpdateBestSolution(*state);
+  }
+}
+
+void KnapsackParallelSolver::UpdateBestSolution(const NodeState& state) {
+  MutexLock lock(&mutex_);
+  if (state.profit > best_profit_) {
+    best_profit_ = state.profit;
+    best_is_in_ = state.is_in;
+  }
+}
+
+void KnapsackParallelSolver::GetLowerAndUpperBoundWhenItem(
+    int item_id, bool is_item_in, int64* lower_bound, int64* upper_bound) {
+  CHECK_NOTNULL(lower_bound);
+  CHECK_NOTNULL(upper_bound);
+  if (is_item_in && !fits_.at(item_id)) {
+    *lower_bound = 0LL;
+    *upper_bound = 0LL;
+    return;
+  }
+  // The Lagrangian relaxation packs the items with a positive reduced profit.
+  const double reduced_profit =
+      fits_[item_id] ? profits_[item_id] - surrogate_weights_[item_id] : 0.0;
+  double bound = lagrangian_bound_ - std::max(0.0, reduced_profit);
+  if (is_item_in) bound += reduced_profit;
+  *lower_bound = greedy_profit_;
+  *upper_bound = FloorWithTolerance(bound);
+}
+
 // ----- KnapsackSolver -----
 KnapsackSolver::KnapsackSolver(const std::string& solver_name)
     : solver_(new KnapsackGenericSolver(solver_name)),
@@ -1113,6 +1778,9 @@ KnapsackSolver::KnapsackSolver(SolverType solver_type,
     case KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER:
       solver_.reset(new KnapsackGenericSolver(solver_name));
       break;
+    case KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER:
+      solver_.reset(new KnapsackParallelSolver(solver_name));
+      break;
     #if defined(USE_CBC)
     case KNAPSACK_MULTIDIMENSION_CBC_MIP_SOLVER:
       solver_.reset(new KnapsackMIPSolver(
@@ -1254,6 +1922,10 @@ bool KnapsackSolver::BestSolutionContains(int item_id) const {
 
 std::string KnapsackSolver::GetName() const { return solver_->GetName(); }
 
+void KnapsackSolver::set_num_threads(int num_threads) {
+  solver_->set_num_threads(num_threads);
+}
+
 // ----- BaseKnapsackSolver -----
 void BaseKnapsackSolver::GetLowerAndUpperBoundWhenItem(int item_id,
                                                        bool is_item_in,
@@ -58,6 +58,7 @@
 #define OR_TOOLS_ALGORITHMS_KNAPSACK_SOLVER_H_
 
 #include <math.h>
+#include <deque>
 #include "base/unique_ptr.h"
 #include <string>
 #include <vector>
@@ -93,6 +94,11 @@ namespace operations_research {
 //  - KNAPSACK_MULTIDIMENSION_GLPK_MIP_SOLVER: This solver can deal with both
 //    large number of items and several dimensions. This solver is based on
 //    Integer Programming solver GLPK.
+//  - KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER: This solver is
+//    meant for large multi-dimensional problems, eg. hundreds of items and
+//    tens of dimensions. It is based on a best-first branch and bound, which
+//    can be run by several threads (see set_num_threads), with bounds given
+//    by the linear relaxation of the problem, and dominance between items.
 //
 // KnapsackSolver also implements a problem reduction algorithm based on lower
 // and upper bounds (see Ingargolia and Korsh - A reduction algorithm for
@@ -119,7 +125,8 @@ class KnapsackSolver {
     #if defined(USE_GLPK)
     KNAPSACK_MULTIDIMENSION_GLPK_MIP_SOLVER = 4,
     #endif  // USE_GLPK
-    KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER = 5
+    KNAPSACK_MULTIDIMENSION_BRANCH_AND_BOUND_SOLVER = 5,
+    KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER = 6
   };
 
   explicit KnapsackSolver(const std::string& solver_name);
@@ -140,6 +147,11 @@ class KnapsackSolver {
   bool use_reduction() const { return use_reduction_; }
   void set_use_reduction(bool use_reduction) { use_reduction_ = use_reduction; }
 
+  // Sets the number of threads used by the solver. Only the
+  // KNAPSACK_MULTIDIMENSION_PARALLEL_BRANCH_AND_BOUND_SOLVER uses several
+  // threads; the other solvers ignore this value. The default is 1.
+  void set_num_threads(int num_threads);
+
  private:
   int ReduceProblem(int num_items);
   void ComputeAdditionalProfit(const std::vector<int64>& profits);
@@ -484,6 +496,10 @@ class BaseKnapsackSolver {
 
   virtual std::string GetName() const { return solver_name_; }
 
+  // Sets the number of threads used by Solve(). Solvers which are not
+  // parallel ignore it.
+  virtual void set_num_threads(int num_threads) {}
+
  private:
   const std::string solver_name_;
 };
@@ -555,7 +571,9 @@ class KnapsackGenericSolver : public BaseKnapsackSolver {
 
   std::vector<KnapsackPropagator*> propagators_;
   int master_propagator_id_;
-  std::vector<KnapsackSearchNode*> search_nodes_;
+  // The search nodes are allocated by chunks, and keep their address as new
+  // nodes are added.
+  std::deque<KnapsackSearchNode> search_nodes_;
   KnapsackState state_;
   int64 best_solution_profit_;
   std::vector<bool> best_solution_;
@@ -11,6 +11,7 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 
 #include "base/mutex.h"
@@ -25,8 +26,17 @@ bool Mutex::TryLock() { return real_mutex_.try_lock(); }
 CondVar::CondVar() {}
 CondVar::~CondVar() {}
 void CondVar::Wait(Mutex* const mu) {
-  std::unique_lock<std::mutex> mutex_lock(mu->real_mutex_);
+  // The mutex is already held by the caller, and must stay held on return.
+  std::unique_lock<std::mutex> mutex_lock(mu->real_mutex_, std::adopt_lock);
   real_condition_.wait(mutex_lock);
+  mutex_lock.release();
+}
+bool CondVar::WaitWithTimeout(Mutex* const mu, int64 timeout_ms) {
+  std::unique_lock<std::mutex> mutex_lock(mu->real_mutex_, std::adopt_lock);
+  const std::cv_status status = real_condition_.wait_for(
+      mutex_lock, std::chrono::milliseconds(timeout_ms));
+  mutex_lock.release();
+  return status == std::cv_status::no_timeout;
 }
 void CondVar::Signal() { real_condition_.notify_one(); }
 void CondVar::SignalAll() { real_condition_.notify_all(); }
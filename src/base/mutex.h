@@ -17,6 +17,7 @@
 #include <condition_variable>  // NOLINT
 #include <mutex>  // NOLINT
 
+#include "base/integral_types.h"
 #include "base/macros.h"
 
 namespace operations_research {
@@ -52,7 +53,10 @@ class CondVar {
  public:
   CondVar();
   ~CondVar();
+  // Both wait functions must be called with mu held, and return with mu held.
   void Wait(Mutex* const mu);
+  // Returns false if the timeout expired before the condition was signaled.
+  bool WaitWithTimeout(Mutex* const mu, int64 timeout_ms);
   void Signal();
   void SignalAll();
 
@@ -45,6 +45,7 @@ struct Status {
     return StrCat("ERROR #", error_code_, ": '", error_message_, "'");
   }
 
+  int error_code() const { return error_code_; }
   std::string error_message() const { return error_message_; }
 
   void IgnoreError() const {}
@@ -17,7 +17,9 @@
 #include <condition_variable>  // NOLINT
 #include <mutex>               // NOLINT
 
+#include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/macros.h"
 
 namespace operations_research {
 class Barrier {
@@ -48,5 +50,38 @@ class Barrier {
   int num_to_exit_;
   DISALLOW_COPY_AND_ASSIGN(Barrier);
 };
+
+// A barrier which, contrary to the one above, can be used repeatedly by the
+// same threads, e.g. between the steps of a parallel algorithm.
+class ReusableBarrier {
+ public:
+  explicit ReusableBarrier(int num_threads)
+      : num_threads_(num_threads), num_waiting_(0), generation_(0) {}
+
+  // Blocks until num_threads threads have called Wait() since the last time
+  // the barrier was passed.
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    const int64 generation = generation_;
+    if (++num_waiting_ == num_threads_) {
+      num_waiting_ = 0;
+      ++generation_;
+      condition_.notify_all();
+      return;
+    }
+    condition_.wait(lock, [this, generation] {
+      return generation_ != generation;
+    });
+  }
+
+ private:
+  const int num_threads_;
+  int num_waiting_;
+  int64 generation_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+
+  DISALLOW_COPY_AND_ASSIGN(ReusableBarrier);
+};
 }  // namespace operations_research
 #endif  // OR_TOOLS_BASE_SYNCHRONIZATION_H_
@@ -174,7 +174,14 @@ bool ProblemState::MergeLearnedInfo(
     const bool value = literal.IsPositive();
     if (is_fixed_[var]) {
       if (fixed_values_[var] != value) {
-        MarkAsInfeasible();
+        // The variables are fixed in order to find a better solution than the
+        // current one (if any), which thus is optimal. This happens when the
+        // fixed variables come from several solvers running in parallel.
+        if (solution_.IsFeasible()) {
+          MarkAsOptimal();
+        } else {
+          MarkAsInfeasible();
+        }
         return true;
       }
     } else {
@@ -13,11 +13,14 @@
 
 #include "bop/bop_lns.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/commandlineflags.h"
 #include "base/stringprintf.h"
+#include "base/threadpool.h"
 #include "google/protobuf/text_format.h"
 #include "base/cleanup.h"
 #include "base/stl_util.h"
@@ -200,6 +203,142 @@ bool UseLinearRelaxationForSatAssignmentPreference(
 }
 }  // namespace
 
+struct BopAdaptiveLNSOptimizer::Subproblem {
+  enum Outcome { SOLUTION_FOUND, INFEASIBLE, LP_LIMIT_REACHED, NOT_SOLVED };
+
+  explicit Subproblem(const BopSolution& current_solution)
+      : fixed_literals(),
+        luby_value(0),
+        parameters(),
+        outcome(NOT_SOLVED),
+        num_failures(0),
+        solution(current_solution) {}
+
+  // The literals fixed by the neighborhood, the luby value used to generate it
+  // and the parameters of the SAT solver used to explore it.
+  std::vector<sat::Literal> fixed_literals;
+  int luby_value;
+  sat::SatParameters parameters;
+
+  // The result of the exploration. The solution is initialized with the
+  // current solution, and is replaced by the better solution found, if any.
+  Outcome outcome;
+  int64 num_failures;
+  BopSolution solution;
+};
+
+void BopAdaptiveLNSOptimizer::SolveSubproblem(
+    const LinearBooleanProblem* problem, bool use_lp_to_guide_sat,
+    Subproblem* subproblem) {
+  const sat::SatParameters& params = subproblem->parameters;
+  sat::SatSolver sat_solver;
+  sat_solver.SetParameters(params);
+
+  // Starts by adding the unit clauses to fix the variables.
+  sat_solver.SetNumVariables(problem->num_variables());
+  for (const sat::Literal literal : subproblem->fixed_literals) {
+    CHECK(sat_solver.AddUnitClause(literal));
+  }
+
+  // Load the rest of the problem. This will automatically create the small
+  // local subproblem using the already fixed variable.
+  //
+  // TODO(user): modify LoadStateProblemToSatSolver() so that we can call it
+  // instead and don't need to over constraint the objective below. As a
+  // bonus we will also have the learned binary clauses.
+  if (!LoadBooleanProblem(*problem, &sat_solver)) {
+    // The local problem is infeasible.
+    subproblem->outcome = Subproblem::INFEASIBLE;
+    return;
+  }
+
+  if (use_lp_to_guide_sat) {
+    // Note that we use a lower time limit for the relaxation so that we
+    // still have some time to exploit what this is returning.
+    const double ratio = 0.5;
+    if (!UseLinearRelaxationForSatAssignmentPreference(
+            *problem, ratio * params.max_time_in_seconds(),
+            ratio * params.max_deterministic_time(), &sat_solver)) {
+      subproblem->outcome = Subproblem::LP_LIMIT_REACHED;
+      return;
+    }
+  } else {
+    UseObjectiveForSatAssignmentPreference(*problem, &sat_solver);
+  }
+
+  if (!AddObjectiveUpperBound(
+          *problem, sat::Coefficient(subproblem->solution.GetCost()) - 1,
+          &sat_solver)) {
+    // The local problem is infeasible.
+    subproblem->outcome = Subproblem::INFEASIBLE;
+    return;
+  }
+
+  // Solve the local problem.
+  const sat::SatSolver::Status status = sat_solver.Solve();
+  if (status == sat::SatSolver::MODEL_SAT) {
+    SatAssignmentToBopSolution(sat_solver.Assignment(), &subproblem->solution);
+    subproblem->outcome = Subproblem::SOLUTION_FOUND;
+    return;
+  }
+  subproblem->num_failures = sat_solver.num_failures();
+  subproblem->outcome = Subproblem::NOT_SOLVED;
+}
+
+BopOptimizerBase::Status BopAdaptiveLNSOptimizer::SolveSubproblems(
+    const ProblemState& problem_state, std::vector<Subproblem>* subproblems,
+    LearnedInfo* learned_info) {
+  const LinearBooleanProblem& problem = problem_state.original_problem();
+  if (subproblems->size() == 1) {
+    SolveSubproblem(&problem, use_lp_to_guide_sat_, &subproblems->front());
+  } else {
+    // Each subproblem has its own SAT solver and only reads the problem, so
+    // they can be solved concurrently. The pool destructor waits for all of
+    // them.
+    ThreadPool pool("LNS", subproblems->size());
+    pool.StartWorkers();
+    for (Subproblem& subproblem : *subproblems) {
+      pool.Add(NewCallback(&BopAdaptiveLNSOptimizer::SolveSubproblem, &problem,
+                           use_lp_to_guide_sat_, &subproblem));
+    }
+  }
+
+  // Adapt the difficulty of each neighborhood, and keep the best solution.
+  const Subproblem* best_subproblem = nullptr;
+  bool lp_limit_reached = false;
+  for (const Subproblem& subproblem : *subproblems) {
+    const int conflict_limit = subproblem.parameters.max_number_of_conflicts();
+    switch (subproblem.outcome) {
+      case Subproblem::SOLUTION_FOUND:
+        if (best_subproblem == nullptr ||
+            subproblem.solution.GetCost() <
+                best_subproblem->solution.GetCost()) {
+          best_subproblem = &subproblem;
+        }
+        break;
+      case Subproblem::INFEASIBLE:
+        adaptive_difficulty_.IncreaseParameter(subproblem.luby_value);
+        break;
+      case Subproblem::LP_LIMIT_REACHED:
+        lp_limit_reached = true;
+        break;
+      case Subproblem::NOT_SOLVED:
+        if (subproblem.num_failures < 0.5 * conflict_limit) {
+          adaptive_difficulty_.IncreaseParameter(subproblem.luby_value);
+        } else if (subproblem.num_failures > 0.95 * conflict_limit) {
+          adaptive_difficulty_.DecreaseParameter(subproblem.luby_value);
+        }
+        break;
+    }
+  }
+  if (best_subproblem != nullptr) {
+    learned_info->solution = best_subproblem->solution;
+    return BopOptimizerBase::SOLUTION_FOUND;
+  }
+  return lp_limit_reached ? BopOptimizerBase::LIMIT_REACHED
+                          : BopOptimizerBase::CONTINUE;
+}
+
 BopAdaptiveLNSOptimizer::BopAdaptiveLNSOptimizer(
     const std::string& name, bool use_lp_to_guide_sat,
     NeighborhoodGenerator* neighborhood_generator,
@@ -248,10 +387,15 @@ BopOptimizerBase::Status BopAdaptiveLNSOptimizer::Optimize(
   // difficulty of the problem. There is one "target" difficulty for each
   // different numbers in the Luby sequence. Note that the initial value is
   // reused from the last run.
+  //
+  // With several threads, the neighborhoods are generated one after the other
+  // with the sat_propagator_, and solved by batches of num_threads.
   BopParameters local_parameters = parameters;
+  const int num_threads = std::max(1, parameters.random_lns_num_threads());
+  std::vector<Subproblem> subproblems;
   int num_tries = 0;  // TODO(user): remove? our limit is 1 by default.
   while (!time_limit->LimitReached() &&
-         num_tries < local_parameters.num_random_lns_tries()) {
+         num_tries < local_parameters.num_random_lns_tries() * num_threads) {
     // Compute the target problem difficulty and generate the neighborhood.
     adaptive_difficulty_.UpdateLuby();
     const double difficulty = adaptive_difficulty_.GetParameterValue();
@@ -309,7 +453,7 @@ BopOptimizerBase::Status BopAdaptiveLNSOptimizer::Optimize(
       sat_propagator_->RestoreSolverToAssumptionLevel();
     }
 
-    // Construct and Solve the LNS subproblem.
+    // Construct the LNS subproblem, which is solved by SolveSubproblems().
     //
     // Note that we don't use the sat_propagator_ all the way because using a
     // clean solver on a really small problem is usually a lot faster (even we
@@ -319,71 +463,29 @@ BopOptimizerBase::Status BopAdaptiveLNSOptimizer::Optimize(
         adaptive_difficulty_.luby_value() *
         parameters.max_number_of_conflicts_in_random_lns();
 
-    sat::SatParameters params;
-    params.set_max_number_of_conflicts(conflict_limit);
-    params.set_max_time_in_seconds(LocalTimeLimitInSeconds(time_limit));
-    params.set_max_deterministic_time(LocalDeterministicTimeLimit(time_limit));
-
-    sat::SatSolver sat_solver;
-    sat_solver.SetParameters(params);
-
-    // Starts by adding the unit clauses to fix the variables.
-    const LinearBooleanProblem& problem = problem_state.original_problem();
-    sat_solver.SetNumVariables(problem.num_variables());
+    subproblems.push_back(Subproblem(problem_state.solution()));
+    Subproblem* const subproblem = &subproblems.back();
+    subproblem->luby_value = adaptive_difficulty_.luby_value();
+    subproblem->parameters.set_max_number_of_conflicts(conflict_limit);
+    subproblem->parameters.set_max_time_in_seconds(
+        LocalTimeLimitInSeconds(time_limit));
+    subproblem->parameters.set_max_deterministic_time(
+        LocalDeterministicTimeLimit(time_limit));
     for (int i = 0; i < sat_propagator_->LiteralTrail().Index(); ++i) {
-      CHECK(sat_solver.AddUnitClause(sat_propagator_->LiteralTrail()[i]));
-    }
-
-    // Load the rest of the problem. This will automatically create the small
-    // local subproblem using the already fixed variable.
-    //
-    // TODO(user): modify LoadStateProblemToSatSolver() so that we can call it
-    // instead and don't need to over constraint the objective below. As a
-    // bonus we will also have the learned binary clauses.
-    if (!LoadBooleanProblem(problem, &sat_solver)) {
-      // The local problem is infeasible.
-      adaptive_difficulty_.IncreaseParameter();
-      continue;
+      subproblem->fixed_literals.push_back(sat_propagator_->LiteralTrail()[i]);
     }
+    if (static_cast<int>(subproblems.size()) < num_threads) continue;
 
-    if (use_lp_to_guide_sat_) {
-      // Note that we use a lower time limit for the relaxation so that we
-      // still have some time to exploit what this is returning.
-      const double ratio = 0.5;
-      if (!UseLinearRelaxationForSatAssignmentPreference(
-              problem, ratio * LocalTimeLimitInSeconds(time_limit),
-              ratio * LocalDeterministicTimeLimit(time_limit), &sat_solver)) {
-        return BopOptimizerBase::LIMIT_REACHED;
-      }
-    } else {
-      UseObjectiveForSatAssignmentPreference(problem, &sat_solver);
-    }
-
-    if (!AddObjectiveUpperBound(
-            problem, sat::Coefficient(problem_state.solution().GetCost()) - 1,
-            &sat_solver)) {
-      // The local problem is infeasible.
-      adaptive_difficulty_.IncreaseParameter();
-      continue;
-    }
-
-    // Solve the local problem.
-    const sat::SatSolver::Status status = sat_solver.Solve();
-    if (status == sat::SatSolver::MODEL_SAT) {
-      // We found a solution! abort now.
-      SatAssignmentToBopSolution(sat_solver.Assignment(),
-                                 &learned_info->solution);
-      return BopOptimizerBase::SOLUTION_FOUND;
-    }
-
-    // Adapt the difficulty.
-    if (sat_solver.num_failures() < 0.5 * conflict_limit) {
-      adaptive_difficulty_.IncreaseParameter();
-    } else if (sat_solver.num_failures() > 0.95 * conflict_limit) {
-      adaptive_difficulty_.DecreaseParameter();
-    }
+    const BopOptimizerBase::Status status =
+        SolveSubproblems(problem_state, &subproblems, learned_info);
+    if (status != BopOptimizerBase::CONTINUE) return status;
+    subproblems.clear();
   }
 
+  // Solve the last incomplete batch, if any.
+  if (!subproblems.empty() && !time_limit->LimitReached()) {
+    return SolveSubproblems(problem_state, &subproblems, learned_info);
+  }
   return BopOptimizerBase::CONTINUE;
 }
 
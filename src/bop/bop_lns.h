@@ -113,6 +113,22 @@ class BopAdaptiveLNSOptimizer : public BopOptimizerBase {
                   const ProblemState& problem_state, LearnedInfo* learned_info,
                   TimeLimit* time_limit) final;
 
+  // A neighborhood to explore, with the result of its exploration. This is
+  // defined in the .cc.
+  struct Subproblem;
+
+  // Solves the given subproblem of the given problem. This only reads the
+  // problem, so it can be called concurrently on different subproblems.
+  static void SolveSubproblem(const LinearBooleanProblem* problem,
+                              bool use_lp_to_guide_sat, Subproblem* subproblem);
+
+  // Solves the given subproblems, concurrently if there is more than one,
+  // adapts the neighborhood difficulties and fills learned_info with the best
+  // solution found if any. Returns CONTINUE if no better solution was found.
+  Status SolveSubproblems(const ProblemState& problem_state,
+                          std::vector<Subproblem>* subproblems,
+                          LearnedInfo* learned_info);
+
   const bool use_lp_to_guide_sat_;
   std::unique_ptr<NeighborhoodGenerator> neighborhood_generator_;
   sat::SatSolver* const sat_propagator_;
@@ -15,6 +15,7 @@
 
 #include "bop/bop_util.h"
 #include "sat/boolean_problem.h"
+#include "util/saturated_arithmetic.h"
 
 namespace operations_research {
 namespace bop {
@@ -32,7 +33,11 @@ LocalSearchOptimizer::LocalSearchOptimizer(const std::string& name,
       sat_wrapper_(sat_propagator),
       assignment_iterator_() {}
 
-LocalSearchOptimizer::~LocalSearchOptimizer() {}
+LocalSearchOptimizer::~LocalSearchOptimizer() {
+  IF_STATS_ENABLED(if (assignment_iterator_ != nullptr) {
+    VLOG(1) << assignment_iterator_->StatString();
+  });
+}
 
 bool LocalSearchOptimizer::ShouldBeRun(
     const ProblemState& problem_state) const {
@@ -59,8 +64,10 @@ BopOptimizerBase::Status LocalSearchOptimizer::Optimize(
   assignment_iterator_->SynchronizeSatWrapper();
 
   double prev_deterministic_time = assignment_iterator_->deterministic_time();
+  const int64 max_memory_in_mb =
+      parameters.max_transposition_table_memory_in_mb_in_ls();
   assignment_iterator_->UseTranspositionTable(
-      parameters.use_transposition_table_in_ls());
+      parameters.use_transposition_table_in_ls(), max_memory_in_mb << 20);
   int64 num_assignments_to_explore =
       parameters.max_number_of_explored_assignments_per_try_in_ls();
 
@@ -169,26 +176,38 @@ template class BacktrackableIntegerSet<ConstraintIndex>;
 AssignmentAndConstraintFeasibilityMaintainer::
     AssignmentAndConstraintFeasibilityMaintainer(
         const LinearBooleanProblem& problem)
-    : by_variable_matrix_(problem.num_variables()),
+    : by_variable_start_(),
+      by_variable_entries_(),
+      delta_start_(),
+      deltas_(),
+      num_terms_with_delta_(),
       constraint_lower_bounds_(),
       constraint_upper_bounds_(),
       assignment_(problem, "Assignment"),
       reference_(problem, "Assignment"),
       constraint_values_(),
+      one_flip_repair_buckets_(kMaxNumOneFlipRepairs + 1),
+      one_flip_repair_bucket_(),
+      position_in_one_flip_repair_bucket_(),
       flipped_var_trail_backtrack_levels_(),
       flipped_var_trail_() {
-  // Add the objective constraint as the first constraint.
+  // The by variable matrix is compacted at the end.
+  ITIVector<VariableIndex, std::vector<ConstraintEntry>> by_variable_matrix(
+      problem.num_variables());
+
+  // Add the objective constraint as the first constraint. It is never
+  // bucketed, so it has no deltas.
   ConstraintIndex num_constraints(0);
   const LinearObjective& objective = problem.objective();
   CHECK_EQ(objective.literals_size(), objective.coefficients_size());
+  delta_start_.push_back(deltas_.size());
   for (int i = 0; i < objective.literals_size(); ++i) {
     CHECK_GT(objective.literals(i), 0);
     CHECK_NE(objective.coefficients(i), 0);
 
     const VariableIndex var(objective.literals(i) - 1);
     const int64 weight = objective.coefficients(i);
-    by_variable_matrix_[var].push_back(
-        ConstraintEntry(num_constraints, weight));
+    by_variable_matrix[var].push_back(ConstraintEntry(num_constraints, weight));
   }
   constraint_lower_bounds_.push_back(kint64min);
   constraint_values_.push_back(0);
@@ -205,22 +224,53 @@ AssignmentAndConstraintFeasibilityMaintainer::
 
     ++num_constraints;
     CHECK_EQ(constraint.literals_size(), constraint.coefficients_size());
+    delta_start_.push_back(deltas_.size());
     for (int i = 0; i < constraint.literals_size(); ++i) {
       const VariableIndex var(constraint.literals(i) - 1);
       const int64 weight = constraint.coefficients(i);
-      by_variable_matrix_[var].push_back(
+      by_variable_matrix[var].push_back(
           ConstraintEntry(num_constraints, weight));
+      deltas_.push_back(weight);
+      deltas_.push_back(-weight);
     }
+    std::sort(deltas_.begin() + delta_start_[num_constraints], deltas_.end());
+    deltas_.erase(std::unique(deltas_.begin() + delta_start_[num_constraints],
+                              deltas_.end()),
+                  deltas_.end());
     constraint_lower_bounds_.push_back(
         constraint.has_lower_bound() ? constraint.lower_bound() : kint64min);
     constraint_values_.push_back(0);
     constraint_upper_bounds_.push_back(
         constraint.has_upper_bound() ? constraint.upper_bound() : kint64max);
   }
+  delta_start_.push_back(deltas_.size());
+  num_terms_with_delta_.assign(deltas_.size(), 0);
+
+  for (const std::vector<ConstraintEntry>& entries : by_variable_matrix) {
+    by_variable_start_.push_back(EntryIndex(by_variable_entries_.size()));
+    by_variable_entries_.insert(by_variable_entries_.end(), entries.begin(),
+                                entries.end());
+  }
+  by_variable_start_.push_back(EntryIndex(by_variable_entries_.size()));
+
+  // Locate the two possible deltas of each term.
+  for (ConstraintEntry& entry : by_variable_entries_) {
+    if (entry.constraint == kObjectiveConstraint) continue;
+    const std::vector<int64>::const_iterator begin =
+        deltas_.begin() + delta_start_[entry.constraint];
+    const std::vector<int64>::const_iterator end =
+        deltas_.begin() + delta_start_[entry.constraint + 1];
+    entry.delta_when_false =
+        std::lower_bound(begin, end, entry.weight) - deltas_.begin();
+    entry.delta_when_true =
+        std::lower_bound(begin, end, -entry.weight) - deltas_.begin();
+  }
 
   // Initialize infeasible_constraint_set_;
   infeasible_constraint_set_.ClearAndResize(
       ConstraintIndex(constraint_values_.size()));
+  one_flip_repair_bucket_.assign(constraint_values_.size(), -1);
+  position_in_one_flip_repair_bucket_.assign(constraint_values_.size(), -1);
 
   CHECK_EQ(constraint_values_.size(), constraint_lower_bounds_.size());
   CHECK_EQ(constraint_values_.size(), constraint_upper_bounds_.size());
@@ -228,6 +278,8 @@ AssignmentAndConstraintFeasibilityMaintainer::
 
 const ConstraintIndex
     AssignmentAndConstraintFeasibilityMaintainer::kObjectiveConstraint(0);
+const int AssignmentAndConstraintFeasibilityMaintainer::kMaxNumOneFlipRepairs =
+    16;
 
 void AssignmentAndConstraintFeasibilityMaintainer::SetReferenceSolution(
     const BopSolution& reference_solution) {
@@ -240,16 +292,29 @@ void AssignmentAndConstraintFeasibilityMaintainer::SetReferenceSolution(
   flipped_var_trail_.clear();
   AddBacktrackingLevel();  // To handle initial propagation.
 
-  // Recompute the value of all constraints.
+  // Recompute the value of all constraints, and the deltas of their terms.
   constraint_values_.assign(NumConstraints(), 0);
+  num_terms_with_delta_.assign(deltas_.size(), 0);
   for (VariableIndex var(0); var < assignment_.Size(); ++var) {
-    if (assignment_.Value(var)) {
-      for (const ConstraintEntry& entry : by_variable_matrix_[var]) {
-        constraint_values_[entry.constraint] += entry.weight;
+    const bool value = assignment_.Value(var);
+    for (EntryIndex i = by_variable_start_[var];
+         i < by_variable_start_[var + 1]; ++i) {
+      const ConstraintEntry& entry = by_variable_entries_[i];
+      if (value) constraint_values_[entry.constraint] += entry.weight;
+      if (entry.constraint != kObjectiveConstraint) {
+        AddToNumTermsWithDelta(
+            entry.constraint,
+            value ? entry.delta_when_true : entry.delta_when_false, 1);
       }
     }
   }
 
+  // All the constraints but the objective are feasible.
+  for (std::vector<ConstraintIndex>& bucket : one_flip_repair_buckets_) {
+    bucket.clear();
+  }
+  one_flip_repair_bucket_.assign(NumConstraints(), -1);
+
   MakeObjectiveConstraintInfeasible(1);
 }
 
@@ -278,6 +343,7 @@ void AssignmentAndConstraintFeasibilityMaintainer::
   if (DEBUG_MODE) {
     for (ConstraintIndex ct(1); ct < NumConstraints(); ++ct) {
       CHECK(ConstraintIsFeasible(ct));
+      CHECK_EQ(-1, one_flip_repair_bucket_[ct]);
     }
   }
 }
@@ -290,7 +356,9 @@ void AssignmentAndConstraintFeasibilityMaintainer::Assign(
     if (assignment_.Value(var) != value) {
       flipped_var_trail_.push_back(var);
       assignment_.SetValue(var, value);
-      for (const ConstraintEntry& entry : by_variable_matrix_[var]) {
+      for (EntryIndex i = by_variable_start_[var];
+           i < by_variable_start_[var + 1]; ++i) {
+        const ConstraintEntry& entry = by_variable_entries_[i];
         const bool was_feasible = ConstraintIsFeasible(entry.constraint);
         constraint_values_[entry.constraint] +=
             value ? entry.weight : -entry.weight;
@@ -298,11 +366,94 @@ void AssignmentAndConstraintFeasibilityMaintainer::Assign(
           infeasible_constraint_set_.ChangeState(entry.constraint,
                                                  was_feasible);
         }
+        UpdateDelta(entry, value);
+        UpdateOneFlipRepairBucket(entry.constraint);
       }
     }
   }
 }
 
+void AssignmentAndConstraintFeasibilityMaintainer::AddToNumTermsWithDelta(
+    ConstraintIndex constraint, int delta_index, int count) {
+  // Fenwick tree update, on the range of the deltas of the constraint.
+  const int start = delta_start_[constraint];
+  const int size = delta_start_[constraint + 1] - start;
+  for (int i = delta_index - start + 1; i <= size; i += i & -i) {
+    num_terms_with_delta_[start + i - 1] += count;
+  }
+}
+
+int AssignmentAndConstraintFeasibilityMaintainer::NumTermsWithDeltaBefore(
+    ConstraintIndex constraint, int delta_index) const {
+  // Fenwick tree prefix sum, on the range of the deltas of the constraint.
+  const int start = delta_start_[constraint];
+  int num_terms = 0;
+  for (int i = delta_index - start; i > 0; i -= i & -i) {
+    num_terms += num_terms_with_delta_[start + i - 1];
+  }
+  return num_terms;
+}
+
+void AssignmentAndConstraintFeasibilityMaintainer::UpdateDelta(
+    const ConstraintEntry& entry, bool new_value) {
+  if (entry.constraint == kObjectiveConstraint) return;
+  AddToNumTermsWithDelta(
+      entry.constraint,
+      new_value ? entry.delta_when_false : entry.delta_when_true, -1);
+  AddToNumTermsWithDelta(
+      entry.constraint,
+      new_value ? entry.delta_when_true : entry.delta_when_false, 1);
+}
+
+int AssignmentAndConstraintFeasibilityMaintainer::ComputeNumOneFlipRepairs(
+    ConstraintIndex constraint) const {
+  // A term repairs the constraint iff its delta is in [lb - value,
+  // ub - value], so the repairs are counted with two binary searches in the
+  // sorted deltas of the constraint.
+  const int64 value = constraint_values_[constraint];
+  const std::vector<int64>::const_iterator begin =
+      deltas_.begin() + delta_start_[constraint];
+  const std::vector<int64>::const_iterator end =
+      deltas_.begin() + delta_start_[constraint + 1];
+  const int first =
+      std::lower_bound(begin, end,
+                       CapSub(constraint_lower_bounds_[constraint], value)) -
+      deltas_.begin();
+  const int last =
+      std::upper_bound(begin, end,
+                       CapSub(constraint_upper_bounds_[constraint], value)) -
+      deltas_.begin();
+  if (last <= first) return 0;
+  return std::min(kMaxNumOneFlipRepairs,
+                  NumTermsWithDeltaBefore(constraint, last) -
+                      NumTermsWithDeltaBefore(constraint, first));
+}
+
+void AssignmentAndConstraintFeasibilityMaintainer::UpdateOneFlipRepairBucket(
+    ConstraintIndex constraint) {
+  // Note that the number of repairs is only computed for the infeasible
+  // constraints, in O(log(number of terms)).
+  const int new_bucket = constraint == kObjectiveConstraint ||
+                                 ConstraintIsFeasible(constraint)
+                             ? -1
+                             : ComputeNumOneFlipRepairs(constraint);
+  const int old_bucket = one_flip_repair_bucket_[constraint];
+  if (new_bucket == old_bucket) return;
+  if (old_bucket != -1) {
+    std::vector<ConstraintIndex>& bucket = one_flip_repair_buckets_[old_bucket];
+    const int position = position_in_one_flip_repair_bucket_[constraint];
+    bucket[position] = bucket.back();
+    position_in_one_flip_repair_bucket_[bucket[position]] = position;
+    bucket.pop_back();
+  }
+  if (new_bucket != -1) {
+    std::vector<ConstraintIndex>& bucket = one_flip_repair_buckets_[new_bucket];
+    position_in_one_flip_repair_bucket_[constraint] = bucket.size();
+    bucket.push_back(constraint);
+  }
+  one_flip_repair_bucket_[constraint] = new_bucket;
+}
+
 void AssignmentAndConstraintFeasibilityMaintainer::AddBacktrackingLevel() {
   flipped_var_trail_backtrack_levels_.push_back(flipped_var_trail_.size());
   infeasible_constraint_set_.AddBacktrackingLevel();
@@ -316,9 +467,13 @@ void AssignmentAndConstraintFeasibilityMaintainer::BacktrackOneLevel() {
     const bool new_value = !assignment_.Value(var);
     DCHECK_EQ(new_value, reference_.Value(var));
     assignment_.SetValue(var, new_value);
-    for (const ConstraintEntry& entry : by_variable_matrix_[var]) {
+    for (EntryIndex j = by_variable_start_[var];
+         j < by_variable_start_[var + 1]; ++j) {
+      const ConstraintEntry& entry = by_variable_entries_[j];
       constraint_values_[entry.constraint] +=
           new_value ? entry.weight : -entry.weight;
+      UpdateDelta(entry, new_value);
+      UpdateOneFlipRepairBucket(entry.constraint);
     }
   }
   flipped_var_trail_.resize(flipped_var_trail_backtrack_levels_.back());
@@ -362,7 +517,8 @@ OneFlipConstraintRepairer::OneFlipConstraintRepairer(
     const LinearBooleanProblem& problem,
     const AssignmentAndConstraintFeasibilityMaintainer& maintainer,
     const sat::VariablesAssignment& sat_assignment)
-    : by_constraint_matrix_(problem.constraints_size() + 1),
+    : by_constraint_start_(),
+      by_constraint_matrix_(),
       maintainer_(maintainer),
       sat_assignment_(sat_assignment) {
   // Fill the by_constraint_matrix_.
@@ -374,14 +530,14 @@ OneFlipConstraintRepairer::OneFlipConstraintRepairer(
   ConstraintIndex num_constraint(0);
   const LinearObjective& objective = problem.objective();
   CHECK_EQ(objective.literals_size(), objective.coefficients_size());
+  by_constraint_start_.push_back(by_constraint_matrix_.size());
   for (int i = 0; i < objective.literals_size(); ++i) {
     CHECK_GT(objective.literals(i), 0);
     CHECK_NE(objective.coefficients(i), 0);
 
     const VariableIndex var(objective.literals(i) - 1);
     const int64 weight = objective.coefficients(i);
-    by_constraint_matrix_[num_constraint].push_back(
-        ConstraintTerm(var, weight));
+    by_constraint_matrix_.push_back(ConstraintTerm(var, weight));
   }
 
   // Add the non-binary problem constraints.
@@ -395,13 +551,14 @@ OneFlipConstraintRepairer::OneFlipConstraintRepairer(
 
     ++num_constraint;
     CHECK_EQ(constraint.literals_size(), constraint.coefficients_size());
+    by_constraint_start_.push_back(by_constraint_matrix_.size());
     for (int i = 0; i < constraint.literals_size(); ++i) {
       const VariableIndex var(constraint.literals(i) - 1);
       const int64 weight = constraint.coefficients(i);
-      by_constraint_matrix_[num_constraint].push_back(
-          ConstraintTerm(var, weight));
+      by_constraint_matrix_.push_back(ConstraintTerm(var, weight));
     }
   }
+  by_constraint_start_.push_back(by_constraint_matrix_.size());
 
   SortTermsOfEachConstraints(problem.num_variables());
 }
@@ -411,74 +568,67 @@ const TermIndex OneFlipConstraintRepairer::kInitTerm(-1);
 const TermIndex OneFlipConstraintRepairer::kInvalidTerm(-2);
 
 ConstraintIndex OneFlipConstraintRepairer::ConstraintToRepair() const {
-  ConstraintIndex selected_ct = kInvalidConstraint;
-  int32 selected_num_branches = kint32max;
-  int num_infeasible_constraints_left = maintainer_.NumInfeasibleConstraints();
-
-  // Optimization: We inspect the constraints in reverse order because the
-  // objective one will always be first (in our current code) and with some
-  // luck, we will break early instead of fully exploring it.
-  const std::vector<ConstraintIndex>& infeasible_constraints =
-      maintainer_.PossiblyInfeasibleConstraints();
-  for (int index = infeasible_constraints.size() - 1; index >= 0; --index) {
-    const ConstraintIndex& i = infeasible_constraints[index];
-    if (maintainer_.ConstraintIsFeasible(i)) continue;
-    --num_infeasible_constraints_left;
-
-    // Optimization: We return the only candidate without inspecting it.
-    // This is critical at the beginning of the search or later if the only
-    // candidate is the objective constraint which can be really long.
-    if (num_infeasible_constraints_left == 0 &&
-        selected_ct == kInvalidConstraint) {
-      return i;
+  const ConstraintIndex kObjectiveConstraint =
+      AssignmentAndConstraintFeasibilityMaintainer::kObjectiveConstraint;
+  const int kMaxNumOneFlipRepairs =
+      AssignmentAndConstraintFeasibilityMaintainer::kMaxNumOneFlipRepairs;
+  const int num_infeasible_constraints = maintainer_.NumInfeasibleConstraints();
+  if (num_infeasible_constraints == 0) return kInvalidConstraint;
+  const bool objective_is_infeasible =
+      !maintainer_.ConstraintIsFeasible(kObjectiveConstraint);
+
+  // Optimization: We return the only candidate without inspecting it.
+  // This is critical at the beginning of the search or later if the only
+  // candidate is the objective constraint which can be really long.
+  if (num_infeasible_constraints == 1) {
+    if (objective_is_infeasible) return kObjectiveConstraint;
+    for (int num_repairs = 0; num_repairs <= kMaxNumOneFlipRepairs;
+         ++num_repairs) {
+      const std::vector<ConstraintIndex>& constraints =
+          maintainer_.InfeasibleConstraintsWithNumRepairs(num_repairs);
+      if (!constraints.empty()) return constraints.front();
     }
+  }
 
-    const int64 constraint_value = maintainer_.ConstraintValue(i);
-    const int64 lb = maintainer_.ConstraintLowerBound(i);
-    const int64 ub = maintainer_.ConstraintUpperBound(i);
-
-    int32 num_branches = 0;
-    for (const ConstraintTerm& term : by_constraint_matrix_[i]) {
-      if (sat_assignment_.IsVariableAssigned(
-              sat::VariableIndex(term.var.value()))) {
-        continue;
-      }
-      const int64 new_value =
-          constraint_value +
-          (maintainer_.Assignment(term.var) ? -term.weight : term.weight);
-      if (new_value >= lb && new_value <= ub) {
-        ++num_branches;
-        if (num_branches >= selected_num_branches) break;
+  // The maintainer buckets the infeasible constraints by an upper bound on
+  // their number of one-flip repairs, so we look at the constraints with the
+  // fewest possible branches first, and return the first one that can really
+  // be repaired by flipping a variable not assigned by the SAT propagator.
+  // Note that the constraints of the bucket 0 can't be repaired in one flip.
+  for (int num_repairs = 1; num_repairs <= kMaxNumOneFlipRepairs;
+       ++num_repairs) {
+    for (const ConstraintIndex ct :
+         maintainer_.InfeasibleConstraintsWithNumRepairs(num_repairs)) {
+      if (NextRepairingTerm(ct, kInitTerm, kInitTerm) != kInvalidTerm) {
+        return ct;
       }
     }
+  }
 
-    // The constraint can't be repaired in one decision.
-    if (num_branches == 0) continue;
-    if (num_branches < selected_num_branches) {
-      selected_ct = i;
-      selected_num_branches = num_branches;
-      if (num_branches == 1) break;
-    }
+  // The objective constraint, which can be really long, is inspected last.
+  if (objective_is_infeasible &&
+      NextRepairingTerm(kObjectiveConstraint, kInitTerm, kInitTerm) !=
+          kInvalidTerm) {
+    return kObjectiveConstraint;
   }
-  return selected_ct;
+  return kInvalidConstraint;
 }
 
 TermIndex OneFlipConstraintRepairer::NextRepairingTerm(
     ConstraintIndex ct_index, TermIndex init_term_index,
     TermIndex start_term_index) const {
-  const ITIVector<TermIndex, ConstraintTerm>& terms =
-      by_constraint_matrix_[ct_index];
+  const int num_terms = NumTerms(ct_index);
   const int64 constraint_value = maintainer_.ConstraintValue(ct_index);
   const int64 lb = maintainer_.ConstraintLowerBound(ct_index);
   const int64 ub = maintainer_.ConstraintUpperBound(ct_index);
 
-  const TermIndex end_term_index(terms.size() + init_term_index + 1);
+  const TermIndex end_term_index(num_terms + init_term_index + 1);
   for (TermIndex loop_term_index(
            start_term_index + 1 +
-           (start_term_index < init_term_index ? terms.size() : 0));
+           (start_term_index < init_term_index ? num_terms : 0));
        loop_term_index < end_term_index; ++loop_term_index) {
-    const TermIndex term_index(loop_term_index % terms.size());
-    const ConstraintTerm term = terms[term_index];
+    const TermIndex term_index(loop_term_index % num_terms);
+    const ConstraintTerm& term = Term(ct_index, term_index);
     if (sat_assignment_.IsVariableAssigned(
             sat::VariableIndex(term.var.value()))) {
       continue;
@@ -496,7 +646,7 @@ TermIndex OneFlipConstraintRepairer::NextRepairingTerm(
 bool OneFlipConstraintRepairer::RepairIsValid(ConstraintIndex ct_index,
                                               TermIndex term_index) const {
   if (maintainer_.ConstraintIsFeasible(ct_index)) return false;
-  const ConstraintTerm term = by_constraint_matrix_[ct_index][term_index];
+  const ConstraintTerm& term = Term(ct_index, term_index);
   if (sat_assignment_.IsVariableAssigned(
           sat::VariableIndex(term.var.value()))) {
     return false;
@@ -512,20 +662,23 @@ bool OneFlipConstraintRepairer::RepairIsValid(ConstraintIndex ct_index,
 
 sat::Literal OneFlipConstraintRepairer::GetFlip(ConstraintIndex ct_index,
                                                 TermIndex term_index) const {
-  const ConstraintTerm term = by_constraint_matrix_[ct_index][term_index];
+  const ConstraintTerm& term = Term(ct_index, term_index);
   const bool value = maintainer_.Assignment(term.var);
   return sat::Literal(sat::VariableIndex(term.var.value()), !value);
 }
 
 void OneFlipConstraintRepairer::SortTermsOfEachConstraints(int num_variables) {
+  const ConstraintIndex kObjectiveConstraint =
+      AssignmentAndConstraintFeasibilityMaintainer::kObjectiveConstraint;
   ITIVector<VariableIndex, int64> objective(num_variables, 0);
-  for (const ConstraintTerm& term :
-       by_constraint_matrix_[AssignmentAndConstraintFeasibilityMaintainer::
-                                 kObjectiveConstraint]) {
+  for (TermIndex i(0); i < NumTerms(kObjectiveConstraint); ++i) {
+    const ConstraintTerm& term = Term(kObjectiveConstraint, i);
     objective[term.var] = std::abs(term.weight);
   }
-  for (ITIVector<TermIndex, ConstraintTerm>& terms : by_constraint_matrix_) {
-    std::sort(terms.begin(), terms.end(),
+  const ConstraintIndex num_constraints(by_constraint_start_.size() - 1);
+  for (ConstraintIndex ct(0); ct < num_constraints; ++ct) {
+    std::sort(by_constraint_matrix_.begin() + by_constraint_start_[ct],
+              by_constraint_matrix_.begin() + by_constraint_start_[ct + 1],
               [&objective](const ConstraintTerm& a, const ConstraintTerm& b) {
                 return objective[a.var] > objective[b.var];
               });
@@ -590,6 +743,73 @@ double SatWrapper::deterministic_time() const {
   return sat_solver_->deterministic_time();
 }
 
+//------------------------------------------------------------------------------
+// TranspositionTable
+//------------------------------------------------------------------------------
+
+const int TranspositionTable::kNumEntriesPerBucket = 8;
+
+TranspositionTable::TranspositionTable()
+    : num_buckets_(0), memory_(), table_(nullptr), generation_(0) {}
+
+void TranspositionTable::Resize(int64 max_memory_in_bytes) {
+  const int64 bucket_size = kNumEntriesPerBucket * sizeof(uint64);
+  int64 num_buckets = 1;
+  while (2 * num_buckets * bucket_size <= max_memory_in_bytes) {
+    num_buckets *= 2;
+  }
+  if (num_buckets == num_buckets_) return;
+  num_buckets_ = num_buckets;
+
+  // The table is aligned on the bucket size, which is the size of a cache line
+  // on most architectures, so that a lookup touches a single cache line.
+  const int64 num_entries = num_buckets * kNumEntriesPerBucket;
+  memory_.reset(new uint64[num_entries + kNumEntriesPerBucket - 1]());
+  const uintptr_t address = reinterpret_cast<uintptr_t>(memory_.get());
+  table_ = reinterpret_cast<uint64*>((address + bucket_size - 1) /
+                                     bucket_size * bucket_size);
+}
+
+void TranspositionTable::NewGeneration() {
+  generation_ = (generation_ + 1) & 0xFF;
+}
+
+bool TranspositionTable::Contains(uint64 hash) const {
+  const uint64 key = Key(hash);
+  const uint64* const bucket = Bucket(hash);
+  for (int i = 0; i < kNumEntriesPerBucket; ++i) {
+    if (bucket[i] != 0 && (bucket[i] & ~GG_ULONGLONG(0xFF)) == key) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TranspositionTable::Insert(uint64 hash, int depth) {
+  DCHECK_GT(depth, 0);
+  const uint64 key = Key(hash);
+  uint64* const bucket = Bucket(hash);
+
+  // Replace the first empty or stale entry if any, otherwise the deepest one.
+  int replaced_entry = -1;
+  bool replaced_entry_is_stale = false;
+  uint64 replaced_entry_depth = 0;
+  for (int i = 0; i < kNumEntriesPerBucket; ++i) {
+    const uint64 entry = bucket[i];
+    if (entry != 0 && (entry & ~GG_ULONGLONG(0xFF)) == key) return false;
+    if (replaced_entry_is_stale) continue;
+    if (entry == 0 || ((entry >> 8) & 0xFF) != generation_) {
+      replaced_entry = i;
+      replaced_entry_is_stale = true;
+    } else if ((entry & 0xFF) > replaced_entry_depth) {
+      replaced_entry = i;
+      replaced_entry_depth = entry & 0xFF;
+    }
+  }
+  bucket[replaced_entry] = key | std::min(depth, 255);
+  return true;
+}
+
 //------------------------------------------------------------------------------
 // LocalSearchAssignmentIterator
 //------------------------------------------------------------------------------
@@ -607,20 +827,51 @@ LocalSearchAssignmentIterator::LocalSearchAssignmentIterator(
           problem_state.original_problem().constraints_size() + 1,
           OneFlipConstraintRepairer::kInitTerm),
       use_transposition_table_(false),
+      zobrist_keys_(2 * problem_state.original_problem().num_variables()),
+      num_restarts_(0),
+      transposition_table_salt_(0),
+      transposition_table_(),
       num_nodes_(0),
-      num_skipped_nodes_(0) {}
+      num_lookups_(0),
+      num_skipped_nodes_(0),
+      num_stored_(0),
+      stats_() {
+  for (sat::LiteralIndex i(0); i < zobrist_keys_.size(); ++i) {
+    zobrist_keys_[i] = Hash64NumWithSeed(i.value(), GG_ULONGLONG(0x5bd1e995));
+  }
+}
 
-void LocalSearchAssignmentIterator::Synchronize(
-    const ProblemState& problem_state) {
-  better_solution_has_been_found_ = false;
-  maintainer_.SetReferenceSolution(problem_state.solution());
+void LocalSearchAssignmentIterator::UseTranspositionTable(
+    bool v, int64 max_memory_in_bytes) {
+  use_transposition_table_ = v;
+  if (!use_transposition_table_) return;
+  transposition_table_.Resize(max_memory_in_bytes);
+}
+
+void LocalSearchAssignmentIterator::RestartSearch() {
   for (const SearchNode& node : search_nodes_) {
     initial_term_index_[node.constraint] = node.term_index;
   }
   search_nodes_.clear();
-  transposition_table_.clear();
+  IF_STATS_ENABLED(if (num_lookups_ > 0) {
+    stats_.transposition_table_hit_ratio.Add(
+        static_cast<double>(num_skipped_nodes_) / num_lookups_);
+    stats_.num_transposition_table_lookups.Add(num_lookups_);
+  });
+  transposition_table_salt_ =
+      Hash64NumWithSeed(++num_restarts_, GG_ULONGLONG(0x9e3779b97f4a7c15));
+  transposition_table_.NewGeneration();
   num_nodes_ = 0;
+  num_lookups_ = 0;
   num_skipped_nodes_ = 0;
+  num_stored_ = 0;
+}
+
+void LocalSearchAssignmentIterator::Synchronize(
+    const ProblemState& problem_state) {
+  better_solution_has_been_found_ = false;
+  maintainer_.SetReferenceSolution(problem_state.solution());
+  RestartSearch();
 }
 
 // In order to restore the synchronization from any state, we backtrack
@@ -657,13 +908,7 @@ bool LocalSearchAssignmentIterator::NextAssignment() {
     // variable and the new reference, so there is no need to do:
     // maintainer_.Assign(sat_wrapper_->FullSatTrail());
 
-    for (const SearchNode& node : search_nodes_) {
-      initial_term_index_[node.constraint] = node.term_index;
-    }
-    search_nodes_.clear();
-    transposition_table_.clear();
-    num_nodes_ = 0;
-    num_skipped_nodes_ = 0;
+    RestartSearch();
     return true;
   }
 
@@ -677,8 +922,8 @@ bool LocalSearchAssignmentIterator::NextAssignment() {
   // All nodes have been explored.
   if (search_nodes_.empty()) {
     VLOG(1) << std::string(25, ' ') + "LS finished."
-            << " #explored:" << num_nodes_
-            << " #stored:" << transposition_table_.size()
+            << " #explored:" << num_nodes_ << " #stored:" << num_stored_
+            << " #lookups:" << num_lookups_
             << " #skipped:" << num_skipped_nodes_;
     return false;
   }
@@ -729,51 +974,20 @@ void LocalSearchAssignmentIterator::ApplyDecision(sat::Literal literal) {
   }
 }
 
-void LocalSearchAssignmentIterator::InitializeTranspositionTableKey(
-    std::array<int32, kStoredMaxDecisions>* a) {
-  int i = 0;
-  for (const SearchNode& n : search_nodes_) {
-    // Negated because we already fliped this variable, so GetFlip() will
-    // returns the old value.
-    (*a)[i] = -repairer_.GetFlip(n.constraint, n.term_index).SignedValue();
-    ++i;
-  }
-
-  // 'a' is not zero-initialized, so we need to complete it with zeros.
-  while (i < kStoredMaxDecisions) {
-    (*a)[i] = 0;
-    ++i;
-  }
-}
-
 bool LocalSearchAssignmentIterator::NewStateIsInTranspositionTable(
-    sat::Literal l) {
-  if (search_nodes_.size() + 1 > kStoredMaxDecisions) return false;
-
-  // Fill the transposition table element, i.e the array 'a' of decisions.
-  std::array<int32, kStoredMaxDecisions> a;
-  InitializeTranspositionTableKey(&a);
-  a[search_nodes_.size()] = l.SignedValue();
-  std::sort(a.begin(), a.begin() + 1 + search_nodes_.size());
-
-  if (transposition_table_.find(a) == transposition_table_.end()) {
-    return false;
-  } else {
+    uint64 hash) {
+  ++num_lookups_;
+  if (transposition_table_.Contains(hash)) {
     ++num_skipped_nodes_;
     return true;
   }
+  return false;
 }
 
 void LocalSearchAssignmentIterator::InsertInTranspositionTable() {
-  // If there is more decision that kStoredMaxDecisions, do nothing.
-  if (search_nodes_.size() > kStoredMaxDecisions) return;
-
-  // Fill the transposition table element, i.e the array 'a' of decisions.
-  std::array<int32, kStoredMaxDecisions> a;
-  InitializeTranspositionTableKey(&a);
-  std::sort(a.begin(), a.begin() + search_nodes_.size());
-
-  transposition_table_.insert(a);
+  if (transposition_table_.Insert(CurrentHash(), search_nodes_.size())) {
+    ++num_stored_;
+  }
 }
 
 bool LocalSearchAssignmentIterator::EnqueueNextRepairingTermIfAny(
@@ -786,10 +1000,11 @@ bool LocalSearchAssignmentIterator::EnqueueNextRepairingTermIfAny(
     term_index = repairer_.NextRepairingTerm(
         ct_to_repair, initial_term_index_[ct_to_repair], term_index);
     if (term_index == OneFlipConstraintRepairer::kInvalidTerm) return false;
-    if (!use_transposition_table_ ||
-        !NewStateIsInTranspositionTable(
-            repairer_.GetFlip(ct_to_repair, term_index))) {
-      search_nodes_.push_back(SearchNode(ct_to_repair, term_index));
+    const uint64 hash =
+        CurrentHash() ^
+        zobrist_keys_[repairer_.GetFlip(ct_to_repair, term_index).Index()];
+    if (!use_transposition_table_ || !NewStateIsInTranspositionTable(hash)) {
+      search_nodes_.push_back(SearchNode(ct_to_repair, term_index, hash));
       return true;
     }
     if (term_index == initial_term_index_[ct_to_repair]) return false;
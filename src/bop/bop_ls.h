@@ -19,16 +19,16 @@
 // objective cost.
 //
 // The class BopLocalSearchOptimizer is the only public interface for Local
-// Search in Bop. For unit-testing purposes this file also contains the four
+// Search in Bop. For unit-testing purposes this file also contains the five
 // internal classes AssignmentAndConstraintFeasibilityMaintainer,
-// OneFlipConstraintRepairer, SatWrapper and LocalSearchAssignmentIterator.
+// OneFlipConstraintRepairer, SatWrapper, TranspositionTable and
+// LocalSearchAssignmentIterator.
 // They are implementation details and should not be used outside of bop_ls.
 
 #ifndef OR_TOOLS_BOP_BOP_LS_H_
 #define OR_TOOLS_BOP_BOP_LS_H_
 
-#include <array>
-#include "base/hash.h"
+#include <memory>
 
 #include "base/hash.h"
 #include "bop/bop_base.h"
@@ -307,6 +307,20 @@ class AssignmentAndConstraintFeasibilityMaintainer {
            value <= ConstraintUpperBound(constraint);
   }
 
+  // The infeasible constraints, except the objective one, are bucketed by
+  // their number of "one-flip repairs", i.e. the number of their variables
+  // whose flip would make them feasible. Note that this number does not take
+  // into account the variables assigned by the SAT propagator, so it is only
+  // an upper bound on the number of ways to repair a constraint in one flip.
+  // The buckets are updated incrementally on each flip (and on backtrack)
+  // from the flipped terms only, and the last one contains all the
+  // constraints with at least kMaxNumOneFlipRepairs repairs.
+  static const int kMaxNumOneFlipRepairs;
+  const std::vector<ConstraintIndex>& InfeasibleConstraintsWithNumRepairs(
+      int num_repairs) const {
+    return one_flip_repair_buckets_[num_repairs];
+  }
+
   std::string DebugString() const;
 
  private:
@@ -314,16 +328,56 @@ class AssignmentAndConstraintFeasibilityMaintainer {
   // called on a feasible reference solution and a fully backtracked state.
   void MakeObjectiveConstraintInfeasible(int delta);
 
+  // Returns the number of one-flip repairs of the given constraint in the
+  // current assignment, capped at kMaxNumOneFlipRepairs.
+  int ComputeNumOneFlipRepairs(ConstraintIndex constraint) const;
+
   // Local structure to represent the sparse matrix by variable used for fast
-  // update of the contraint values.
+  // update of the contraint values. For a term of a constraint other than the
+  // objective, delta_when_false (resp. delta_when_true) is the index in
+  // deltas_ of the change of the constraint value when flipping the variable
+  // from false (resp. true), i.e. of weight (resp. -weight).
   struct ConstraintEntry {
-    ConstraintEntry(ConstraintIndex c, int64 w) : constraint(c), weight(w) {}
+    ConstraintEntry(ConstraintIndex c, int64 w)
+        : constraint(c), weight(w), delta_when_false(-1), delta_when_true(-1) {}
     ConstraintIndex constraint;
     int64 weight;
+    int delta_when_false;
+    int delta_when_true;
   };
 
-  ITIVector<VariableIndex, ITIVector<EntryIndex, ConstraintEntry>>
-      by_variable_matrix_;
+  // Adds count to the number of terms of the constraint whose flip changes its
+  // value by deltas_[delta_index].
+  void AddToNumTermsWithDelta(ConstraintIndex constraint, int delta_index,
+                              int count);
+
+  // Returns the number of terms of the constraint whose flip changes its value
+  // by one of the deltas before deltas_[delta_index].
+  int NumTermsWithDeltaBefore(ConstraintIndex constraint,
+                              int delta_index) const;
+
+  // Moves the term of the given entry to the delta of its new value.
+  void UpdateDelta(const ConstraintEntry& entry, bool new_value);
+
+  // Moves the given constraint to its bucket, or removes it from the buckets
+  // if it is feasible or if it is the objective constraint.
+  void UpdateOneFlipRepairBucket(ConstraintIndex constraint);
+
+  // The matrix is stored contiguously: the entries of the variable var are
+  // by_variable_entries_[by_variable_start_[var] ..
+  // by_variable_start_[var + 1]).
+  ITIVector<VariableIndex, EntryIndex> by_variable_start_;
+  ITIVector<EntryIndex, ConstraintEntry> by_variable_entries_;
+
+  // The distinct possible deltas of the constraint ct, sorted, are
+  // deltas_[delta_start_[ct] .. delta_start_[ct + 1]). On the same range,
+  // num_terms_with_delta_ is a Fenwick tree counting the terms whose flip
+  // would change the constraint value by each delta in the current
+  // assignment. A flip only moves its term from one delta to the other.
+  ITIVector<ConstraintIndex, int> delta_start_;
+  std::vector<int64> deltas_;
+  std::vector<int> num_terms_with_delta_;
+
   ITIVector<ConstraintIndex, int64> constraint_lower_bounds_;
   ITIVector<ConstraintIndex, int64> constraint_upper_bounds_;
 
@@ -333,6 +387,12 @@ class AssignmentAndConstraintFeasibilityMaintainer {
   ITIVector<ConstraintIndex, int64> constraint_values_;
   BacktrackableIntegerSet<ConstraintIndex> infeasible_constraint_set_;
 
+  // The buckets of one-flip repairs. For each constraint, the bucket it is in
+  // (or -1) and its position in this bucket, for O(1) removals.
+  std::vector<std::vector<ConstraintIndex>> one_flip_repair_buckets_;
+  ITIVector<ConstraintIndex, int> one_flip_repair_bucket_;
+  ITIVector<ConstraintIndex, int> position_in_one_flip_repair_bucket_;
+
   // This contains the list of variable flipped in assignment_.
   // flipped_var_trail_backtrack_levels_[i-1] is the index in flipped_var_trail_
   // of the first variable flipped after the i-th AddBacktrackingLevel() call.
@@ -377,6 +437,15 @@ class OneFlipConstraintRepairer {
   // returned without checking that it can indeed be repaired in one flip.
   // This is because the later check can be expensive, and is not needed in our
   // context.
+  //
+  // Otherwise, the constraints other than the objective are considered by
+  // increasing number of one-flip repairs, as bucketed by the maintainer, and
+  // the first one that can be repaired in one flip is returned. The objective
+  // constraint, which can be really long, is only returned if no other
+  // constraint can be repaired in one flip. Note that the returned constraint
+  // is thus not always the one with the fewest repairs: the bucket counts
+  // include the variables assigned by the SAT propagator, and the objective
+  // is never preferred to another constraint.
   ConstraintIndex ConstraintToRepair() const;
 
   // Returns the index of the next term which repairs the constraint when the
@@ -413,14 +482,87 @@ class OneFlipConstraintRepairer {
   // on most promising variables first.
   void SortTermsOfEachConstraints(int num_variables);
 
-  ITIVector<ConstraintIndex, ITIVector<TermIndex, ConstraintTerm> >
-      by_constraint_matrix_;
+  int NumTerms(ConstraintIndex constraint) const {
+    return by_constraint_start_[constraint + 1] -
+           by_constraint_start_[constraint];
+  }
+  const ConstraintTerm& Term(ConstraintIndex constraint,
+                             TermIndex term_index) const {
+    return by_constraint_matrix_[by_constraint_start_[constraint] +
+                                 term_index.value()];
+  }
+
+  // The matrix is stored contiguously: the terms of the constraint ct are
+  // by_constraint_matrix_[by_constraint_start_[ct] ..
+  // by_constraint_start_[ct + 1]), and the TermIndex of a term is its position
+  // in this range.
+  ITIVector<ConstraintIndex, int> by_constraint_start_;
+  std::vector<ConstraintTerm> by_constraint_matrix_;
   const AssignmentAndConstraintFeasibilityMaintainer& maintainer_;
   const sat::VariablesAssignment& sat_assignment_;
 
   DISALLOW_COPY_AND_ASSIGN(OneFlipConstraintRepairer);
 };
 
+// A lossy, fixed-size table of 64-bit hashes, used by the
+// LocalSearchAssignmentIterator to remember the explored sets of decisions.
+//
+// The table is divided in buckets of kNumEntriesPerBucket entries aligned on a
+// cache line, so that a lookup touches a single cache line. The low bits of a
+// hash select its bucket, and its entry packs the 48 high bits of the hash,
+// the generation in which it was inserted and its depth, i.e. the number of
+// decisions of the set. NewGeneration() logically empties the table: the entries of the
+// previous generations are not found anymore and are the first to be replaced.
+// In a bucket without such entries, the deepest entry is replaced, since it
+// stands for the smallest explored subtree.
+//
+// Note that the generation is stored modulo 256, so an entry inserted 256
+// generations ago is seen as a current one. The caller should thus also change
+// its hashes at each generation if the old ones must never match again.
+class TranspositionTable {
+ public:
+  TranspositionTable();
+
+  // Uses the largest power of two number of buckets that fits in the given
+  // memory, with at least one bucket. The table is allocated on the first call,
+  // and reallocated (thus cleared) only if its number of buckets changes.
+  void Resize(int64 max_memory_in_bytes);
+  int64 num_buckets() const { return num_buckets_; }
+
+  // Logically empties the table.
+  void NewGeneration();
+
+  // Returns true if the given hash was inserted in the current generation and
+  // was not replaced since. Note that, since only the high bits of the hashes
+  // are stored, two hashes may (very rarely) be confused.
+  bool Contains(uint64 hash) const;
+
+  // Inserts the given hash, with its depth which must be positive, and returns
+  // false if it was already present.
+  bool Insert(uint64 hash, int depth);
+
+  static const int kNumEntriesPerBucket;
+
+ private:
+  // An entry is (hash & kHashMask) | generation << 8 | depth, with the depth
+  // capped at 255, and 0 for an empty entry.
+  static const uint64 kHashMask = ~GG_ULONGLONG(0xFFFF);
+
+  uint64* Bucket(uint64 hash) const {
+    return table_ + (hash & (num_buckets_ - 1)) * kNumEntriesPerBucket;
+  }
+  uint64 Key(uint64 hash) const {
+    return (hash & kHashMask) | generation_ << 8;
+  }
+
+  int64 num_buckets_;
+  std::unique_ptr<uint64[]> memory_;
+  uint64* table_;
+  uint64 generation_;
+
+  DISALLOW_COPY_AND_ASSIGN(TranspositionTable);
+};
+
 // This class is used to iterate on all assignments that can be obtained by
 // deliberately flipping 'n' variables from the reference solution, 'n' being
 // smaller than or equal to max_num_decisions.
@@ -431,8 +573,10 @@ class LocalSearchAssignmentIterator {
   LocalSearchAssignmentIterator(const ProblemState& problem_state,
                                 int max_num_decisions, SatWrapper* sat_wrapper);
 
-  // Sets whether or not a transposition table is used.
-  void UseTranspositionTable(bool v) { use_transposition_table_ = v; }
+  // Sets whether or not a transposition table is used, and the maximum memory
+  // it can use. The table is allocated on its first use, and reallocated (thus
+  // cleared) if its size changes.
+  void UseTranspositionTable(bool v, int64 max_memory_in_bytes);
 
   // Synchronizes the iterator with the problem state, e.g. set fixed variables,
   // set the reference solution. Call this only when a new solution has been
@@ -465,19 +609,35 @@ class LocalSearchAssignmentIterator {
 
   std::string DebugString() const;
 
- private:
-  // See transposition_table_ below.
-  static const size_t kStoredMaxDecisions = 4;
+  // Returns the statistics about the transposition table.
+  std::string StatString() const { return stats_.StatString(); }
 
+ private:
   // Internal structure used to represent a node of the search tree during local
-  // search.
+  // search. The hash is the one of the set of decisions from the root to this
+  // node included, see transposition_table_ below.
   struct SearchNode {
     SearchNode()
         : constraint(OneFlipConstraintRepairer::kInvalidConstraint),
-          term_index(OneFlipConstraintRepairer::kInvalidTerm) {}
-    SearchNode(ConstraintIndex c, TermIndex t) : constraint(c), term_index(t) {}
+          term_index(OneFlipConstraintRepairer::kInvalidTerm),
+          hash(0) {}
+    SearchNode(ConstraintIndex c, TermIndex t, uint64 h)
+        : constraint(c), term_index(t), hash(h) {}
     ConstraintIndex constraint;
     TermIndex term_index;
+    uint64 hash;
+  };
+
+  // Statistics about the transposition table, one value per explored
+  // neighborhood of a reference solution.
+  struct Stats : public StatsGroup {
+    Stats()
+        : StatsGroup("LocalSearchAssignmentIterator"),
+          transposition_table_hit_ratio("transposition_table_hit_ratio", this),
+          num_transposition_table_lookups("num_transposition_table_lookups",
+                                          this) {}
+    RatioDistribution transposition_table_hit_ratio;
+    IntegerDistribution num_transposition_table_lookups;
   };
 
   // Applies the decision. Automatically backtracks when SAT detects conflicts.
@@ -490,17 +650,23 @@ class LocalSearchAssignmentIterator {
   // Backtracks and moves to the next decision in the search tree.
   void Backtrack();
 
-  // Looks if the current decisions (in search_nodes_) plus the new one (given
-  // by l) lead to a position already present in transposition_table_.
-  bool NewStateIsInTranspositionTable(sat::Literal l);
+  // Returns the hash of the current set of decisions (in search_nodes_).
+  uint64 CurrentHash() const {
+    return search_nodes_.empty() ? transposition_table_salt_
+                                 : search_nodes_.back().hash;
+  }
+
+  // Looks if the set of decisions with the given hash, i.e. the current
+  // decisions plus a new one, is already present in transposition_table_.
+  bool NewStateIsInTranspositionTable(uint64 hash);
 
   // Inserts the current set of decisions in transposition_table_.
   void InsertInTranspositionTable();
 
-  // Initializes the given array with the current decisions in search_nodes_ and
-  // by filling the other positions with 0.
-  void InitializeTranspositionTableKey(
-      std::array<int32, kStoredMaxDecisions>* a);
+  // Starts the exploration of the neighborhood of a new reference solution:
+  // clears the search nodes, logically empties the transposition table and
+  // updates the statistics.
+  void RestartSearch();
 
   // Looks for the next repairing term in the given constraints while skipping
   // the position already present in transposition_table_. A given TermIndex of
@@ -519,32 +685,36 @@ class LocalSearchAssignmentIterator {
   // Temporary vector used by ApplyDecision().
   std::vector<sat::Literal> tmp_propagated_literals_;
 
-  // For each set of explored decisions, we store it in this table so that we
-  // don't explore decisions (a, b) and later (b, a) for instance. The decisions
-  // are converted to int32, sorted and padded with 0 before beeing inserted
-  // here.
+  // For each set of explored decisions, we store its hash in this table so
+  // that we don't explore decisions (a, b) and later (b, a) for instance.
+  //
+  // The hash of a set of decisions is the xor of the pseudo-random "Zobrist"
+  // keys of its literals and of a salt, so it is maintained incrementally in
+  // the search nodes. Each restart starts a new generation of the table and
+  // changes the salt, so that the old entries will (almost surely) never match
+  // again. Note that a hash collision may wrongly skip a state, but this is
+  // very unlikely with the 48 stored bits of the hashes.
   //
   // TODO(user): We may still miss some equivalent states because it is possible
   // that completely differents decisions lead to exactly the same state.
   // However this is more time consuming to detect because we must apply the
   // last decision first before trying to compare the states.
-  //
-  // TODO(user): Currently, we only store kStoredMaxDecisions or less decisions.
-  // Ideally, this should be related to the maximum number of decision in the
-  // LS, but that requires templating the whole LS optimizer.
   bool use_transposition_table_;
-#if defined(_MSC_VER)
-  hash_set<std::array<int32, kStoredMaxDecisions>,
-           StdArrayHasher<int32, kStoredMaxDecisions>> transposition_table_;
-#else
-  hash_set<std::array<int32, kStoredMaxDecisions>> transposition_table_;
-#endif
+  ITIVector<sat::LiteralIndex, uint64> zobrist_keys_;
+  int64 num_restarts_;
+  uint64 transposition_table_salt_;
+  TranspositionTable transposition_table_;
 
   // The number of explored nodes.
   int64 num_nodes_;
 
-  // The number of skipped nodes thanks to the transposition table.
+  // The number of lookups in the transposition table, of skipped nodes thanks
+  // to it (i.e. of hits), and of stored sets of decisions.
+  int64 num_lookups_;
   int64 num_skipped_nodes_;
+  int64 num_stored_;
+
+  mutable Stats stats_;
 
   DISALLOW_COPY_AND_ASSIGN(LocalSearchAssignmentIterator);
 };
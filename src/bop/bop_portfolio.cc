@@ -13,6 +13,8 @@
 
 #include "bop/bop_portfolio.h"
 
+#include <algorithm>
+
 #include "bop/bop_fs.h"
 #include "bop/bop_lns.h"
 #include "bop/bop_ls.h"
@@ -264,7 +266,11 @@ void PortfolioOptimizer::CreateOptimizers(
   if (parameters.use_symmetry()) {
     VLOG(1) << "Finding symmetries of the problem.";
     std::vector<std::unique_ptr<SparsePermutation>> generators;
-    sat::FindLinearBooleanProblemSymmetries(problem, &generators);
+    sat::FindLinearBooleanProblemSymmetries(
+        problem,
+        std::min(parameters.max_symmetry_detection_time_in_seconds(),
+                 parameters.max_time_in_seconds()),
+        parameters.symmetry_detection_num_threads(), &generators);
     sat_propagator_.AddSymmetries(&generators);
   }
 
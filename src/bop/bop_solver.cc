@@ -13,11 +13,16 @@
 
 #include "bop/bop_solver.h"
 
+#include <algorithm>
+#include <atomic>
 #include <string>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/commandlineflags.h"
+#include "base/mutex.h"
 #include "base/stringprintf.h"
+#include "base/threadpool.h"
 #include "google/protobuf/text_format.h"
 #include "base/stl_util.h"
 #include "bop/bop_fs.h"
@@ -66,6 +71,337 @@ bool UpdateProblemStateBasedOnStatus(BopOptimizerBase::Status status,
   return false;
 }
 
+// The solvers of BopSolver::InternalMultithreadSolver(). Each solver has its
+// own ProblemState and runs its own PortfolioOptimizer in a thread. After each
+// optimizer run, a solver publishes what it learned (its best solution, lower
+// bound, fixed variables, new binary clauses and LP values), and merges what
+// the other solvers published, according to the synchronization type:
+// - NO_SYNCHRONIZATION: nothing is exchanged until the end of the search.
+// - SYNCHRONIZE_ALL: the solver waits until all the other solvers completed as
+//   many optimizer runs as itself, and merges what they learned.
+// - SYNCHRONIZE_ON_RIGHT: the same, but solver i only waits for, and merges
+//   what was learned by, the solvers 0 .. i-1.
+// - SYNCHRONIZE_ASYNCHRONOUSLY: the solver merges what all the other solvers
+//   published so far, without waiting for them.
+// In all cases, the search stops as soon as a solver proves the problem
+// optimal or infeasible.
+class ParallelSolvers {
+ public:
+  ParallelSolvers(const ProblemState& initial_state,
+                  const BopParameters& parameters,
+                  const bool* external_boolean_as_limit);
+
+  // Runs all the solvers until they stop.
+  void Run();
+
+  // Merges what all the solvers learned into the given problem state.
+  void MergeLearnedInfoInto(ProblemState* problem_state) const;
+
+ private:
+  // What a solver published for the others. The binary clauses are all the
+  // ones the solver learned since the beginning, in order. The LP values are
+  // the last ones, and num_lp_values_updates counts their changes.
+  struct PublishedInfo {
+    explicit PublishedInfo(const LinearBooleanProblem& problem)
+        : solution(problem, "AllZero"),
+          lower_bound(kint64min),
+          num_lp_values_updates(0),
+          num_optimizer_runs(0),
+          done(false) {}
+
+    BopSolution solution;
+    int64 lower_bound;
+    std::vector<sat::Literal> fixed_literals;
+    std::vector<sat::BinaryClause> binary_clauses;
+    glop::DenseRow lp_values;
+    int num_lp_values_updates;
+    int num_optimizer_runs;
+    bool done;
+  };
+
+  void RunSolver(int solver_index);
+
+  // Publishes what solver #solver_index learned, waits for the solvers it
+  // synchronizes with, and merges what they published into its problem state.
+  void Synchronize(int solver_index);
+
+  // Whether solver #solver_index synchronizes with solver #other_index.
+  bool SynchronizesWith(int solver_index, int other_index) const;
+
+  // Whether one of the solvers that solver #solver_index synchronizes with is
+  // still running and completed less than num_optimizer_runs optimizer runs.
+  bool IsWaitingForOtherSolvers(int solver_index, int num_optimizer_runs) const
+      EXCLUSIVE_LOCKS_REQUIRED(mutex_);
+
+  // Stops all the solvers, and marks the given solver as done.
+  void StopAllSolvers();
+  void SolverDone(int solver_index);
+
+  const LinearBooleanProblem& problem_;
+  const BopParameters& parameters_;
+  const bool* const external_boolean_as_limit_;
+  const int num_solvers_;
+  std::vector<std::unique_ptr<ProblemState>> problem_states_;
+
+  // The Boolean registered as the limit of the time limits of all the
+  // solvers. It is read by the solver threads without holding mutex_, hence
+  // the atomic; it is only set to true, always while holding mutex_ so that
+  // no wait on condition_ can miss it.
+  std::atomic<bool> stop_;
+
+  // All the fields below are protected by mutex_.
+  Mutex mutex_;
+  CondVar condition_;
+  std::vector<PublishedInfo> published_infos_ GUARDED_BY(mutex_);
+  // The number of binary clauses published by solver #j that were already
+  // merged by solver #i is num_binary_clauses_merged_[i][j].
+  std::vector<std::vector<int>> num_binary_clauses_merged_ GUARDED_BY(mutex_);
+  // Same for the number of updates of the LP values.
+  std::vector<std::vector<int>> num_lp_values_updates_merged_
+      GUARDED_BY(mutex_);
+  int num_running_solvers_ GUARDED_BY(mutex_);
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelSolvers);
+};
+
+ParallelSolvers::ParallelSolvers(const ProblemState& initial_state,
+                                 const BopParameters& parameters,
+                                 const bool* external_boolean_as_limit)
+    : problem_(initial_state.original_problem()),
+      parameters_(parameters),
+      external_boolean_as_limit_(external_boolean_as_limit),
+      num_solvers_(parameters.number_of_solvers()),
+      stop_(false),
+      published_infos_(num_solvers_, PublishedInfo(problem_)),
+      num_binary_clauses_merged_(num_solvers_,
+                                 std::vector<int>(num_solvers_, 0)),
+      num_lp_values_updates_merged_(num_solvers_,
+                                    std::vector<int>(num_solvers_, 0)),
+      num_running_solvers_(0) {
+  // All the solvers start from what is already known, e.g. the first solution
+  // given to BopSolver::Solve().
+  const LearnedInfo initial_info = initial_state.GetLearnedInfo();
+  for (int i = 0; i < num_solvers_; ++i) {
+    problem_states_.emplace_back(new ProblemState(problem_));
+    problem_states_.back()->SetParameters(parameters_);
+    problem_states_.back()->set_assignment_preference(
+        initial_state.assignment_preference());
+    problem_states_.back()->MergeLearnedInfo(initial_info,
+                                             BopOptimizerBase::CONTINUE);
+    problem_states_.back()->SynchronizationDone();
+  }
+}
+
+void ParallelSolvers::Run() {
+  {
+    MutexLock mutex_lock(&mutex_);
+    num_running_solvers_ = num_solvers_;
+  }
+  ThreadPool pool("BopSolver", num_solvers_);
+  pool.StartWorkers();
+  for (int i = 0; i < num_solvers_; ++i) {
+    pool.Add(NewCallback(this, &ParallelSolvers::RunSolver, i));
+  }
+
+  // The external limit is only checked here: the solvers only look at stop_.
+  MutexLock mutex_lock(&mutex_);
+  while (num_running_solvers_ > 0) {
+    if (external_boolean_as_limit_ != nullptr && *external_boolean_as_limit_ &&
+        !stop_) {
+      stop_ = true;
+      condition_.SignalAll();
+    }
+    condition_.WaitWithTimeout(&mutex_, 10);
+  }
+}
+
+void ParallelSolvers::RunSolver(int solver_index) {
+  ProblemState* const problem_state = problem_states_[solver_index].get();
+  // The solvers use different seeds, so that they don't run the same search
+  // when they run the same optimizers.
+  BopParameters parameters = parameters_;
+  parameters.set_random_seed(parameters_.random_seed() + solver_index);
+  const int optimizer_set_index =
+      std::min(solver_index, parameters.solver_optimizer_sets_size() - 1);
+
+  TimeLimit time_limit(parameters.max_time_in_seconds(),
+                       parameters.max_deterministic_time());
+  time_limit.RegisterExternalBooleanAsLimit(&stop_);
+  LearnedInfo learned_info(problem_);
+  PortfolioOptimizer optimizer(
+      *problem_state, parameters,
+      parameters.solver_optimizer_sets(optimizer_set_index),
+      StringPrintf("Portfolio_%d", solver_index));
+  while (!time_limit.LimitReached()) {
+    const BopOptimizerBase::Status optimization_status = optimizer.Optimize(
+        parameters, *problem_state, &learned_info, &time_limit);
+    problem_state->MergeLearnedInfo(learned_info, optimization_status);
+    learned_info.Clear();
+
+    if (optimization_status == BopOptimizerBase::SOLUTION_FOUND) {
+      CHECK(problem_state->solution().IsFeasible());
+      VLOG(1) << problem_state->solution().GetScaledCost()
+              << "  New solution! (solver " << solver_index << ")";
+    }
+    if (problem_state->IsOptimal() || problem_state->IsInfeasible()) {
+      StopAllSolvers();
+      break;
+    }
+    if (optimization_status == BopOptimizerBase::ABORT) break;
+
+    Synchronize(solver_index);
+    if (problem_state->IsOptimal() || problem_state->IsInfeasible()) {
+      StopAllSolvers();
+      break;
+    }
+  }
+  SolverDone(solver_index);
+}
+
+bool ParallelSolvers::SynchronizesWith(int solver_index,
+                                       int other_index) const {
+  switch (parameters_.synchronization_type()) {
+    case BopParameters::NO_SYNCHRONIZATION:
+      return false;
+    case BopParameters::SYNCHRONIZE_ALL:
+    case BopParameters::SYNCHRONIZE_ASYNCHRONOUSLY:
+      return other_index != solver_index;
+    case BopParameters::SYNCHRONIZE_ON_RIGHT:
+      return other_index < solver_index;
+  }
+  return false;
+}
+
+void ParallelSolvers::Synchronize(int solver_index) {
+  if (parameters_.synchronization_type() ==
+      BopParameters::NO_SYNCHRONIZATION) {
+    return;
+  }
+  ProblemState* const problem_state = problem_states_[solver_index].get();
+  LearnedInfo learned_info(problem_);
+  {
+    MutexLock mutex_lock(&mutex_);
+
+    // Publish what this solver learned since its last synchronization.
+    PublishedInfo* const published = &published_infos_[solver_index];
+    const BopSolution& solution = problem_state->solution();
+    if (solution.IsFeasible() && (!published->solution.IsFeasible() ||
+                                  solution.GetCost() <
+                                      published->solution.GetCost())) {
+      published->solution = solution;
+    }
+    published->lower_bound = problem_state->lower_bound();
+    published->fixed_literals.clear();
+    for (VariableIndex var(0); var < problem_state->is_fixed().size(); ++var) {
+      if (problem_state->IsVariableFixed(var)) {
+        published->fixed_literals.push_back(
+            sat::Literal(sat::VariableIndex(var.value()),
+                         problem_state->GetVariableFixedValue(var)));
+      }
+    }
+    const std::vector<sat::BinaryClause>& new_binary_clauses =
+        problem_state->NewlyAddedBinaryClauses();
+    published->binary_clauses.insert(published->binary_clauses.end(),
+                                     new_binary_clauses.begin(),
+                                     new_binary_clauses.end());
+    if (!problem_state->lp_values().empty() &&
+        problem_state->lp_values() != published->lp_values) {
+      published->lp_values = problem_state->lp_values();
+      ++published->num_lp_values_updates;
+    }
+    problem_state->SynchronizationDone();
+    const int num_optimizer_runs = ++published->num_optimizer_runs;
+    condition_.SignalAll();
+
+    // Wait for the solvers this one synchronizes with.
+    if (parameters_.synchronization_type() !=
+        BopParameters::SYNCHRONIZE_ASYNCHRONOUSLY) {
+      while (!stop_ &&
+             IsWaitingForOtherSolvers(solver_index, num_optimizer_runs)) {
+        condition_.Wait(&mutex_);
+      }
+    }
+    if (stop_) return;
+
+    // Collect what they published. The merge itself is done without the lock,
+    // since the problem state belongs to this solver.
+    for (int other = 0; other < num_solvers_; ++other) {
+      if (!SynchronizesWith(solver_index, other)) continue;
+      const PublishedInfo& info = published_infos_[other];
+      if (info.solution.IsFeasible() &&
+          (!learned_info.solution.IsFeasible() ||
+           info.solution.GetCost() < learned_info.solution.GetCost())) {
+        learned_info.solution = info.solution;
+      }
+      learned_info.lower_bound =
+          std::max(learned_info.lower_bound, info.lower_bound);
+      learned_info.fixed_literals.insert(learned_info.fixed_literals.end(),
+                                         info.fixed_literals.begin(),
+                                         info.fixed_literals.end());
+      int* const num_merged = &num_binary_clauses_merged_[solver_index][other];
+      learned_info.binary_clauses.insert(learned_info.binary_clauses.end(),
+                                         info.binary_clauses.begin() +
+                                             *num_merged,
+                                         info.binary_clauses.end());
+      *num_merged = info.binary_clauses.size();
+      // Only take the LP values that changed since the last merge, so that the
+      // solvers don't keep exchanging the same ones.
+      int* const num_lp_updates =
+          &num_lp_values_updates_merged_[solver_index][other];
+      if (info.num_lp_values_updates > *num_lp_updates) {
+        learned_info.lp_values = info.lp_values;
+        *num_lp_updates = info.num_lp_values_updates;
+      }
+    }
+  }
+  problem_state->MergeLearnedInfo(learned_info, BopOptimizerBase::CONTINUE);
+  // The merged binary clauses must not be published again by this solver.
+  problem_state->SynchronizationDone();
+}
+
+bool ParallelSolvers::IsWaitingForOtherSolvers(int solver_index,
+                                               int num_optimizer_runs) const {
+  for (int other = 0; other < num_solvers_; ++other) {
+    const PublishedInfo& info = published_infos_[other];
+    if (SynchronizesWith(solver_index, other) && !info.done &&
+        info.num_optimizer_runs < num_optimizer_runs) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ParallelSolvers::StopAllSolvers() {
+  MutexLock mutex_lock(&mutex_);
+  stop_ = true;
+  condition_.SignalAll();
+}
+
+void ParallelSolvers::SolverDone(int solver_index) {
+  MutexLock mutex_lock(&mutex_);
+  published_infos_[solver_index].done = true;
+  --num_running_solvers_;
+  condition_.SignalAll();
+}
+
+void ParallelSolvers::MergeLearnedInfoInto(ProblemState* problem_state) const {
+  bool infeasibility_proved = false;
+  for (const std::unique_ptr<ProblemState>& solver_state : problem_states_) {
+    if (solver_state->IsInfeasible()) {
+      infeasibility_proved = true;
+      continue;
+    }
+    const BopOptimizerBase::Status status =
+        solver_state->IsOptimal() ? BopOptimizerBase::OPTIMAL_SOLUTION_FOUND
+                                  : BopOptimizerBase::CONTINUE;
+    problem_state->MergeLearnedInfo(solver_state->GetLearnedInfo(), status);
+  }
+  if (infeasibility_proved && !problem_state->solution().IsFeasible()) {
+    problem_state->MergeLearnedInfo(LearnedInfo(problem_),
+                                    BopOptimizerBase::INFEASIBLE);
+  }
+}
+
 }  // anonymous namespace
 
 //------------------------------------------------------------------------------
@@ -130,8 +466,20 @@ BopSolveStatus BopSolver::InternalMonothreadSolver() {
 }
 
 BopSolveStatus BopSolver::InternalMultithreadSolver() {
-  // Not implemented.
-  return BopSolveStatus::INVALID_PROBLEM;
+  ParallelSolvers solvers(problem_state_, parameters_,
+                          external_boolean_as_limit_);
+  solvers.Run();
+  solvers.MergeLearnedInfoInto(&problem_state_);
+
+  if (problem_state_.IsOptimal()) {
+    CHECK(problem_state_.solution().IsFeasible());
+    return BopSolveStatus::OPTIMAL_SOLUTION_FOUND;
+  } else if (problem_state_.IsInfeasible()) {
+    return BopSolveStatus::INFEASIBLE_PROBLEM;
+  }
+  return problem_state_.solution().IsFeasible()
+             ? BopSolveStatus::FEASIBLE_SOLUTION_FOUND
+             : BopSolveStatus::NO_SOLUTION_FOUND;
 }
 
 BopSolveStatus BopSolver::Solve(const BopSolution& first_solution) {
@@ -181,9 +529,40 @@ void BopSolver::UpdateParameters() {
     CHECK(::google::protobuf::TextFormat::ParseFromString(
         parameters_.default_solver_optimizer_sets(),
         parameters_.add_solver_optimizer_sets()));
+    if (parameters_.number_of_solvers() > 1 &&
+        parameters_.use_dedicated_lp_solver()) {
+      SplitDefaultOptimizerSet();
+    }
   }
 
   problem_state_.SetParameters(parameters_);
 }
+
+void BopSolver::SplitDefaultOptimizerSet() {
+  BopSolverOptimizerSet lp_set;
+  BopSolverOptimizerSet search_set;
+  for (const BopOptimizerMethod& method :
+       parameters_.solver_optimizer_sets(0).methods()) {
+    switch (method.type()) {
+      case BopOptimizerMethod::LINEAR_RELAXATION: {
+        // The LP has its own thread, it can use all the time it needs.
+        BopOptimizerMethod* const lp_method = lp_set.add_methods();
+        lp_method->CopyFrom(method);
+        lp_method->set_time_limit_ratio(1.0);
+        break;
+      }
+      case BopOptimizerMethod::SAT_CORE_BASED:
+        lp_set.add_methods()->CopyFrom(method);
+        break;
+      default:
+        search_set.add_methods()->CopyFrom(method);
+    }
+  }
+  // Keep the default set when one of the two sets would be empty.
+  if (lp_set.methods_size() == 0 || search_set.methods_size() == 0) return;
+  parameters_.clear_solver_optimizer_sets();
+  parameters_.add_solver_optimizer_sets()->Swap(&lp_set);
+  parameters_.add_solver_optimizer_sets()->Swap(&search_set);
+}
 }  // namespace bop
 }  // namespace operations_research
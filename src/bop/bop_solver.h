@@ -90,6 +90,10 @@ class BopSolver {
 
  private:
   void UpdateParameters();
+
+  // Splits the default optimizer set in two sets as described by the
+  // use_dedicated_lp_solver parameter.
+  void SplitDefaultOptimizerSet();
   BopSolveStatus InternalMonothreadSolver();
   BopSolveStatus InternalMultithreadSolver();
 
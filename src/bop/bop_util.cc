@@ -173,12 +173,20 @@ void LubyAdaptiveParameterValue::Reset() {
 }
 
 void LubyAdaptiveParameterValue::IncreaseParameter() {
-  const int luby_msb = MostSignificantBitPosition64(luby_value_);
-  difficulties_[luby_msb].Increase();
+  IncreaseParameter(luby_value_);
 }
 
 void LubyAdaptiveParameterValue::DecreaseParameter() {
-  const int luby_msb = MostSignificantBitPosition64(luby_value_);
+  DecreaseParameter(luby_value_);
+}
+
+void LubyAdaptiveParameterValue::IncreaseParameter(int luby_value) {
+  const int luby_msb = MostSignificantBitPosition64(luby_value);
+  difficulties_[luby_msb].Increase();
+}
+
+void LubyAdaptiveParameterValue::DecreaseParameter(int luby_value) {
+  const int luby_msb = MostSignificantBitPosition64(luby_value);
   difficulties_[luby_msb].Decrease();
 }
 
@@ -71,6 +71,11 @@ class LubyAdaptiveParameterValue {
   void IncreaseParameter();
   void DecreaseParameter();
 
+  // Same as above for the parameter associated with the given luby value
+  // instead of the current one.
+  void IncreaseParameter(int luby_value);
+  void DecreaseParameter(int luby_value);
+
   double GetParameterValue() const;
 
   void UpdateLuby();
@@ -99,6 +99,10 @@ sat::SatSolver::Status SatCoreBasedOptimizer::SolveWithAssumptions() {
     nodes_.resize(new_node_index);
   }
   CHECK_LE(assumptions.size(), nodes_.size());
+
+  // Reducing the nodes or applying the upper bound may already prove the
+  // model UNSAT, which ResetAndSolveWithGivenAssumptions() doesn't expect.
+  if (solver_.IsModelUnsat()) return sat::SatSolver::MODEL_UNSAT;
   return solver_.ResetAndSolveWithGivenAssumptions(assumptions);
 }
 
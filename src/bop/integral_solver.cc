@@ -15,6 +15,8 @@
 
 #include <math.h>
 #include <vector>
+#include "base/callback.h"
+#include "base/threadpool.h"
 #include "bop/bop_solver.h"
 #include "lp_data/lp_decomposer.h"
 
@@ -971,24 +973,32 @@ BopSolveStatus InternalSolve(const LinearProgram& linear_problem,
   return status;
 }
 
+// The result of the solve of one sub-problem of a decomposed problem.
+struct SubProblemResult {
+  SubProblemResult()
+      : variable_values(),
+        objective_value(0.0),
+        best_bound(0.0),
+        status(BopSolveStatus::INVALID_PROBLEM) {}
+
+  DenseRow variable_values;
+  Fractional objective_value;
+  Fractional best_bound;
+  BopSolveStatus status;
+};
+
+// Solves the sub-problem #problem_index of the decomposer, starting from the
+// given local initial solution (if not empty). The decomposer is thread-safe,
+// so that the sub-problems can be solved concurrently.
 void RunOneBop(const BopParameters& parameters, int problem_index,
-               const DenseRow& initial_solution,
+               const DenseRow& local_initial_solution,
                bool* external_boolean_as_limit, LPDecomposer* decomposer,
-               DenseRow* variable_values, Fractional* objective_value,
-               Fractional* best_bound, BopSolveStatus* status) {
+               SubProblemResult* result) {
   CHECK(decomposer != nullptr);
-  CHECK(variable_values != nullptr);
-  CHECK(objective_value != nullptr);
-  CHECK(best_bound != nullptr);
-  CHECK(status != nullptr);
+  CHECK(result != nullptr);
 
   LinearProgram problem;
   decomposer->ExtractLocalProblem(problem_index, &problem);
-  DenseRow local_initial_solution;
-  if (initial_solution.size() > 0) {
-    local_initial_solution =
-        decomposer->ExtractLocalAssignment(problem_index, initial_solution);
-  }
   // TODO(user): Investigate a better approximation of the time needed to
   //              solve the problem than just the number of variables.
   const double total_num_variables =
@@ -1006,9 +1016,10 @@ void RunOneBop(const BopParameters& parameters, int problem_index,
   local_parameters.set_max_deterministic_time(deterministic_time_per_variable *
                                               local_num_variables);
 
-  *status = InternalSolve(problem, local_parameters, local_initial_solution,
-                          external_boolean_as_limit, variable_values,
-                          objective_value, best_bound);
+  result->status = InternalSolve(
+      problem, local_parameters, local_initial_solution,
+      external_boolean_as_limit, &result->variable_values,
+      &result->objective_value, &result->best_bound);
 }
 }  // anonymous namespace
 
@@ -1045,34 +1056,55 @@ BopSolveStatus IntegralSolver::Solve(const LinearProgram& linear_problem,
     if (num_sub_problems > 1) {
       // The problem can be decomposed. Solve each sub-problem and aggregate the
       // result.
-      std::vector<DenseRow> variable_values(num_sub_problems);
-      std::vector<Fractional> objective_values(num_sub_problems, Fractional(0.0));
-      std::vector<Fractional> best_bounds(num_sub_problems, Fractional(0.0));
-      std::vector<BopSolveStatus> statuses(num_sub_problems,
-                                      BopSolveStatus::INVALID_PROBLEM);
-
+      std::vector<SubProblemResult> results(num_sub_problems);
+      std::vector<DenseRow> local_initial_solutions(num_sub_problems);
+      if (initial_solution.size() > 0) {
         for (int i = 0; i < num_sub_problems; ++i) {
-          RunOneBop(parameters_, i, initial_solution, &interrupt_solve_,
-                    &decomposer, &(variable_values[i]), &(objective_values[i]),
-                    &(best_bounds[i]), &(statuses[i]));
+          local_initial_solutions[i] =
+              decomposer.ExtractLocalAssignment(i, initial_solution);
         }
+      }
+      const int num_workers = std::min(
+          num_sub_problems,
+          std::max(1, parameters_.num_bop_solvers_used_by_decomposition()));
+      if (num_workers == 1) {
+        for (int i = 0; i < num_sub_problems; ++i) {
+          RunOneBop(parameters_, i, local_initial_solutions[i],
+                    &interrupt_solve_, &decomposer, &results[i]);
+        }
+      } else {
+        // The threads of the BopSolvers are shared by the sub-problems solved
+        // at the same time. The pool destructor waits for all of them.
+        BopParameters parameters = parameters_;
+        parameters.set_number_of_solvers(
+            std::max(1, parameters_.number_of_solvers() / num_workers));
+        ThreadPool pool("ParallelIntegralSolver", num_workers);
+        pool.StartWorkers();
+        for (int i = 0; i < num_sub_problems; ++i) {
+          pool.Add(NewCallback(&RunOneBop, parameters, i,
+                               local_initial_solutions[i], &interrupt_solve_,
+                               &decomposer, &results[i]));
+        }
+      }
 
       // Aggregate results.
       status = BopSolveStatus::OPTIMAL_SOLUTION_FOUND;
       objective_value_ = lp->objective_offset();
       best_bound_ = 0.0;
+      std::vector<DenseRow> variable_values(num_sub_problems);
       for (int i = 0; i < num_sub_problems; ++i) {
-        objective_value_ += objective_values[i];
-        best_bound_ += best_bounds[i];
-        if (statuses[i] == BopSolveStatus::NO_SOLUTION_FOUND ||
-            statuses[i] == BopSolveStatus::INFEASIBLE_PROBLEM ||
-            statuses[i] == BopSolveStatus::INVALID_PROBLEM) {
-          return statuses[i];
+        objective_value_ += results[i].objective_value;
+        best_bound_ += results[i].best_bound;
+        if (results[i].status == BopSolveStatus::NO_SOLUTION_FOUND ||
+            results[i].status == BopSolveStatus::INFEASIBLE_PROBLEM ||
+            results[i].status == BopSolveStatus::INVALID_PROBLEM) {
+          return results[i].status;
         }
 
-        if (statuses[i] == BopSolveStatus::FEASIBLE_SOLUTION_FOUND) {
+        if (results[i].status == BopSolveStatus::FEASIBLE_SOLUTION_FOUND) {
           status = BopSolveStatus::FEASIBLE_SOLUTION_FOUND;
         }
+        variable_values[i].swap(results[i].variable_values);
       }
       variable_values_ = decomposer.AggregateAssignments(variable_values);
       CheckSolution(*lp, variable_values_);
@@ -251,6 +251,7 @@ struct DefaultPhaseParameters {
         restart_log_size(kDefaultRestartLogSize),
         display_level(NORMAL),
         use_no_goods(kDefaultUseNoGoods),
+        no_good_manager(nullptr),
         decision_builder(nullptr) {}
 
   // This parameter describes how the next variable to instantiate
@@ -302,6 +303,11 @@ struct DefaultPhaseParameters {
   // Should we use Nogoods when restarting. The default is false.
   bool use_no_goods;
 
+  // When defined, the nogoods created at restarts are added to this manager
+  // instead of a manager private to the default phase. The caller must then
+  // install it in the search, e.g. by passing it as a search monitor.
+  NoGoodManager* no_good_manager;
+
   // When defined, this override the default impact based decision builder.
   DecisionBuilder* decision_builder;
 };
@@ -4196,6 +4202,13 @@ class NoGood {
   // term is added to the solver. It returns true if the nogood is
   // still active and needs to be reevaluated.
   bool Apply(Solver* const solver);
+  // Returns the number of terms.
+  int NumTerms() const { return terms_.size(); }
+  // If the term at the given index is var == value ('assign' is true) or
+  // var != value ('assign' is false), fills the three fields and returns
+  // true. Returns false otherwise.
+  bool IntegerVariableTerm(int index, IntVar** var, int64* value,
+                           bool* assign) const;
   // Pretty print.
   std::string DebugString() const;
   // TODO(user) : support interval variables and more types of constraints.
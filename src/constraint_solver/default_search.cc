@@ -676,10 +676,12 @@ class RestartMonitor : public SearchMonitor {
         parameters_(parameters),
         domain_watcher_(domain_watcher),
         min_log_search_space_(std::numeric_limits<double>::infinity()),
-        no_good_manager_(parameters_.restart_log_size >= 0 &&
-                                 parameters_.use_no_goods
-                             ? solver->MakeNoGoodManager()
-                             : nullptr),
+        no_good_manager_(parameters_.restart_log_size < 0 ||
+                                 !parameters_.use_no_goods
+                             ? nullptr
+                             : parameters_.no_good_manager != nullptr
+                                   ? parameters_.no_good_manager
+                                   : solver->MakeNoGoodManager()),
         branches_between_restarts_(0),
         min_restart_period_(ComputeBranchRestart(parameters_.restart_log_size)),
         maximum_restart_depth_(kint64max),
@@ -753,7 +755,9 @@ class RestartMonitor : public SearchMonitor {
 
   void Install() override {
     SearchMonitor::Install();
-    if (no_good_manager_ != nullptr) {
+    // An external manager is installed by its owner.
+    if (no_good_manager_ != nullptr &&
+        parameters_.no_good_manager == nullptr) {
       no_good_manager_->Install();
     }
   }
@@ -53,6 +53,12 @@ class NoGoodTerm {
   virtual TermStatus Evaluate() const = 0;
   virtual void Refute() = 0;
   virtual std::string DebugString() const = 0;
+  // Fills the fields and returns true if the term is var == value or
+  // var != value.
+  virtual bool IntegerVariableTerm(IntVar** var, int64* value,
+                                   bool* assign) const {
+    return false;
+  }
 
  private:
   DISALLOW_COPY_AND_ASSIGN(NoGoodTerm);
@@ -92,6 +98,14 @@ class IntegerVariableNoGoodTerm : public NoGoodTerm {
                         assign_ ? "==" : "!=", value_);
   }
 
+  bool IntegerVariableTerm(IntVar** var, int64* value,
+                           bool* assign) const override {
+    *var = integer_variable_;
+    *value = value_;
+    *assign = assign_;
+    return true;
+  }
+
   IntVar* integer_variable() const { return integer_variable_; }
   int64 value() const { return value_; }
   bool assign() const { return assign_; }
@@ -147,6 +161,11 @@ bool NoGood::Apply(Solver* const solver) {
   return false;
 }
 
+bool NoGood::IntegerVariableTerm(int index, IntVar** var, int64* value,
+                                 bool* assign) const {
+  return terms_[index]->IntegerVariableTerm(var, value, assign);
+}
+
 std::string NoGood::DebugString() const {
   return StringPrintf("(%s)", JoinDebugStringPtr(terms_, " && ").c_str());
 }
@@ -23,6 +23,7 @@
 #include "constraint_solver/constraint_solveri.h"
 
 DECLARE_bool(use_sat);
+DECLARE_bool(use_lcg);
 DECLARE_bool(fz_verbose);
 
 namespace operations_research {
@@ -32,9 +33,18 @@ void AddConstraint(Solver* s, FzConstraint* ct, Constraint* cte) {
   s->AddConstraint(cte);
 }
 
+// In lazy clause generation mode, the integer constraints on small domains
+// are posted to the sat solver, see --use_lcg.
+bool UseLcg(FzSolver* fzsolver) {
+  return FLAGS_use_lcg && fzsolver->Sat() != nullptr;
+}
+
 void ExtractAllDifferentInt(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const s = fzsolver->solver();
   const std::vector<IntVar*> vars = fzsolver->GetVariableArray(ct->Arg(0));
+  if (UseLcg(fzsolver) && AddAllDifferent(fzsolver->Sat(), vars)) {
+    FZVLOG << "  - also posted to sat" << FZENDL;
+  }
   Constraint* const constraint = s->MakeAllDifferent(vars, vars.size() < 100);
   AddConstraint(s, ct, constraint);
 }
@@ -214,8 +224,17 @@ void ExtractArrayIntElement(FzSolver* fzsolver, FzConstraint* ct) {
       FZVLOG << "  - creating " << ct->target_variable->DebugString()
              << " := " << target->DebugString() << FZENDL;
       fzsolver->SetExtracted(ct->target_variable, target);
+      if (UseLcg(fzsolver) && AddArrayIntElement(fzsolver->Sat(), index->Var(),
+                                                 values, target->Var())) {
+        FZVLOG << "  - also posted to sat" << FZENDL;
+      }
     } else {
       IntVar* const target = fzsolver->GetExpression(ct->Arg(2))->Var();
+      if (UseLcg(fzsolver) &&
+          AddArrayIntElement(fzsolver->Sat(), index->Var(), values, target)) {
+        FZVLOG << "  - posted to sat" << FZENDL;
+        return;
+      }
       Constraint* const constraint =
           solver->MakeElementEquality(coefficients, shifted_index, target);
       AddConstraint(solver, ct, constraint);
@@ -759,7 +778,7 @@ void ExtractDiffn(FzSolver* fzsolver, FzConstraint* ct) {
 
 void ExtractGlobalCardinality(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
-  const std::vector<int64> values = ct->Arg(1).values;
+  const std::vector<int64>& values = ct->Arg(1).values;
   std::vector<IntVar*> variables;
   for (FzIntegerVariable* const fzvar : ct->Arg(0).variables) {
     IntVar* const var = fzsolver->Extract(fzvar)->Var();
@@ -781,7 +800,7 @@ void ExtractGlobalCardinality(FzSolver* fzsolver, FzConstraint* ct) {
 
 void ExtractGlobalCardinalityClosed(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
-  const std::vector<int64> values = ct->Arg(1).values;
+  const std::vector<int64>& values = ct->Arg(1).values;
   const std::vector<IntVar*> variables = fzsolver->GetVariableArray(ct->Arg(0));
 
   const std::vector<IntVar*> cards = fzsolver->GetVariableArray(ct->Arg(2));
@@ -800,7 +819,7 @@ void ExtractGlobalCardinalityClosed(FzSolver* fzsolver, FzConstraint* ct) {
 
 void ExtractGlobalCardinalityLowUp(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
-  const std::vector<int64> values = ct->Arg(1).values;
+  const std::vector<int64>& values = ct->Arg(1).values;
   std::vector<IntVar*> variables;
   for (FzIntegerVariable* const fzvar : ct->Arg(0).variables) {
     IntVar* const var = fzsolver->Extract(fzvar)->Var();
@@ -821,7 +840,7 @@ void ExtractGlobalCardinalityLowUp(FzSolver* fzsolver, FzConstraint* ct) {
 void ExtractGlobalCardinalityLowUpClosed(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
   const std::vector<IntVar*> variables = fzsolver->GetVariableArray(ct->Arg(0));
-  const std::vector<int64> values = ct->Arg(1).values;
+  const std::vector<int64>& values = ct->Arg(1).values;
   const std::vector<int64>& low = ct->Arg(2).values;
   const std::vector<int64>& up = ct->Arg(3).values;
   Constraint* const constraint =
@@ -1272,6 +1291,32 @@ bool AreAllExtractedAsVariables(
   return true;
 }
 
+// In lazy clause generation mode, posts the linear constraint to the sat
+// solver, where its propagation is explained, if all its variables have two
+// values. Returns false if it was not posted. The pure boolean sums are left
+// to PostBooleanSumInRange().
+bool AddIntLinToSat(FzSolver* fzsolver, FzConstraint* ct, bool use_lower_bound,
+                    bool use_upper_bound) {
+  if (!UseLcg(fzsolver) ||
+      !AreAllExtractedAsVariables(fzsolver, ct->Arg(1).variables)) {
+    return false;
+  }
+  std::vector<IntVar*> vars;
+  std::vector<int64> coeffs;
+  int64 rhs = 0;
+  ParseLongIntLin(fzsolver, ct, &vars, &coeffs, &rhs);
+  if (AreAllBooleans(vars) && AreAllOnes(coeffs)) {
+    return false;
+  }
+  if (AddScalProdInRange(fzsolver->Sat(), vars, coeffs,
+                         use_lower_bound ? rhs : kint64min,
+                         use_upper_bound ? rhs : kint64max)) {
+    FZVLOG << "  - posted to sat" << FZENDL;
+    return true;
+  }
+  return false;
+}
+
 bool AreAllFzVariablesBoolean(FzSolver* fzsolver, FzConstraint* ct) {
   for (FzIntegerVariable* const fz_var : ct->Arg(1).variables) {
     IntVar* var = fzsolver->Extract(fz_var)->Var();
@@ -1332,6 +1377,9 @@ void ExtractIntLinEq(FzSolver* fzsolver, FzConstraint* ct) {
       fzsolver->SetExtracted(ct->target_variable, target);
     }
   } else {
+    if (AddIntLinToSat(fzsolver, ct, true, true)) {
+      return;
+    }
     Constraint* constraint = nullptr;
     if (size <= 3 &&
         !AreAllExtractedAsVariables(fzsolver, ct->Arg(1).variables)) {
@@ -1410,6 +1458,9 @@ void ExtractIntLinEqReif(FzSolver* fzsolver, FzConstraint* ct) {
 void ExtractIntLinGe(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
   const int size = ct->Arg(0).values.size();
+  if (AddIntLinToSat(fzsolver, ct, true, false)) {
+    return;
+  }
   if (size <= 3) {
     // Checks if it is not a hidden or.
     if (ct->Arg(2).Value() == 1 && AreAllOnes(ct->Arg(0).values)) {
@@ -1538,6 +1589,9 @@ bool PostHiddenLeMax(SatPropagator* const sat, const std::vector<int64>& coeffs,
 void ExtractIntLinLe(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
   const int size = ct->Arg(0).values.size();
+  if (AddIntLinToSat(fzsolver, ct, false, true)) {
+    return;
+  }
   if (size <= 3) {
     IntExpr* left = nullptr;
     IntExpr* right = nullptr;
@@ -2162,20 +2216,7 @@ void ExtractRegular(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
 
   const std::vector<IntVar*> variables = fzsolver->GetVariableArray(ct->Arg(0));
-  const int64 num_states = ct->Arg(1).Value();
-  const int64 num_values = ct->Arg(2).Value();
-
-  const std::vector<int64>& array_transitions = ct->Arg(3).values;
-  IntTupleSet tuples(3);
-  int count = 0;
-  for (int q = 1; q <= num_states; ++q) {
-    for (int s = 1; s <= num_values; ++s) {
-      const int64 next = array_transitions[count++];
-      if (next != 0) {
-        tuples.Insert3(q, s, next);
-      }
-    }
-  }
+  const IntTupleSet& tuples = fzsolver->TupleSet(ct);
 
   const int64 initial_state = ct->Arg(4).Value();
 
@@ -2300,19 +2341,8 @@ void ExtractSubCircuit(FzSolver* fzsolver, FzConstraint* ct) {
 void ExtractTableInt(FzSolver* fzsolver, FzConstraint* ct) {
   Solver* const solver = fzsolver->solver();
   const std::vector<IntVar*> variables = fzsolver->GetVariableArray(ct->Arg(0));
-  const int size = variables.size();
-  IntTupleSet tuples(size);
-  const std::vector<int64>& t = ct->Arg(1).values;
-  const int t_size = t.size();
-  DCHECK_EQ(0, t_size % size);
-  const int num_tuples = t_size / size;
-  std::vector<int64> one_tuple(size);
-  for (int tuple_index = 0; tuple_index < num_tuples; ++tuple_index) {
-    for (int var_index = 0; var_index < size; ++var_index) {
-      one_tuple[var_index] = t[tuple_index * size + var_index];
-    }
-    tuples.Insert(one_tuple);
-  }
+  const IntTupleSet& tuples = fzsolver->TupleSet(ct);
+  DCHECK_EQ(variables.size(), tuples.Arity());
   Constraint* const constraint =
       solver->MakeAllowedAssignments(variables, tuples);
   AddConstraint(solver, ct, constraint);
@@ -56,14 +56,15 @@ using operations_research::ThreadPool;
 extern void interrupt_handler(int s);
 
 namespace operations_research {
-void Solve(const FzModel* const model, const FzSolverParameters& parameters,
+void Solve(const FzModel* const model, const FzSolverSharedData* shared_data,
+           const FzSolverParameters& parameters,
            FzParallelSupportInterface* parallel_support) {
-  FzSolver solver(*model);
+  FzSolver solver(*model, shared_data);
   CHECK(solver.Extract());
   solver.Solve(parameters, parallel_support);
 }
 
-void SequentialRun(const FzModel* model) {
+void SequentialRun(FzModel* model) {
   FzSolverParameters parameters;
   parameters.all_solutions = FLAGS_all;
   parameters.free_search = FLAGS_free;
@@ -83,10 +84,12 @@ void SequentialRun(const FzModel* model) {
 
   std::unique_ptr<FzParallelSupportInterface> parallel_support(
       MakeSequentialSupport(FLAGS_all, FLAGS_num_solutions));
-  Solve(model, parameters, parallel_support.get());
+  const FzSolverSharedData shared_data(model);
+  Solve(model, &shared_data, parameters, parallel_support.get());
 }
 
-void ParallelRun(const FzModel* const model, int worker_id,
+void ParallelRun(const FzModel* const model,
+                 const FzSolverSharedData* const shared_data, int worker_id,
                  FzParallelSupportInterface* parallel_support) {
   FzSolverParameters parameters;
   parameters.all_solutions = FLAGS_all;
@@ -147,7 +150,7 @@ void ParallelRun(const FzModel* const model, int worker_id,
       parameters.luby_restart = 250;
     }
   }
-  Solve(model, parameters, parallel_support);
+  Solve(model, shared_data, parameters, parallel_support);
 }
 
 void FixAndParseParameters(int* argc, char*** argv) {
@@ -224,10 +227,17 @@ void ParseAndRun(const std::string& filename, int num_workers) {
     std::unique_ptr<operations_research::FzParallelSupportInterface>
         parallel_support(operations_research::MakeMtSupport(
             FLAGS_all, FLAGS_num_solutions, FLAGS_verbose_mt));
+    // The shared data is built once for all the workers, which then only
+    // read the model and extract it concurrently.
+    timer.Reset();
+    timer.Start();
+    const FzSolverSharedData shared_data(&model);
+    FZLOG << "Shared data built in " << timer.GetInMs() << " ms" << FZENDL;
     {
       ThreadPool pool("Parallel FlatZinc", num_workers);
       for (int w = 0; w < num_workers; ++w) {
-        pool.Add(NewCallback(ParallelRun, &model, w, parallel_support.get()));
+        pool.Add(NewCallback(ParallelRun, &model, &shared_data, w,
+                             parallel_support.get()));
       }
       pool.StartWorkers();
     }
@@ -0,0 +1,240 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include "flatzinc/lexer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "base/integral_types.h"
+#include "flatzinc/parser.tab.hh"
+
+namespace operations_research {
+namespace {
+inline bool IsLetter(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+inline bool IsIdentifierChar(char c) {
+  return IsLetter(c) || IsDigit(c) || c == '_';
+}
+
+inline int DigitValue(char c) {
+  if (IsDigit(c)) return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return 16;
+}
+
+struct Keyword {
+  const char* text;
+  int token;
+};
+
+const Keyword kKeywords[] = {{"array", ARRAY},
+                             {"bool", BOOL},
+                             {"constraint", CONSTRAINT},
+                             {"float", FLOAT},
+                             {"int", INT},
+                             {"maximize", MAXIMIZE},
+                             {"minimize", MINIMIZE},
+                             {"of", OF},
+                             {"predicate", PREDICATE},
+                             {"satisfy", SATISFY},
+                             {"set", SET},
+                             {"solve", SOLVE},
+                             {"var", VAR}};
+
+// Returns the token of the keyword [start, start + length), or 0 if it is not
+// a keyword.
+int KeywordToken(const char* start, size_t length) {
+  for (const Keyword& keyword : kKeywords) {
+    if (strlen(keyword.text) == length &&
+        memcmp(keyword.text, start, length) == 0) {
+      return keyword.token;
+    }
+  }
+  return 0;
+}
+}  // namespace
+
+FzLexer::FzLexer(const char* data, size_t size)
+    : current_(data),
+      end_(data + size),
+      line_number_(1),
+      first_token_(0),
+      skip_begin_(nullptr),
+      skip_end_(nullptr),
+      skipped_lines_(0),
+      identifiers_(),
+      shared_identifiers_(nullptr),
+      identifier_() {}
+
+void FzLexer::SkipRange(const char* begin, const char* end, int num_lines) {
+  skip_begin_ = begin;
+  skip_end_ = end;
+  skipped_lines_ = num_lines;
+}
+
+const std::string* FzLexer::Intern(const char* start, size_t length) {
+  identifier_.assign(start, length);
+  if (shared_identifiers_ != nullptr) {
+    const hash_set<std::string>::const_iterator it =
+        shared_identifiers_->find(identifier_);
+    if (it != shared_identifiers_->end()) return &*it;
+  }
+  return &*identifiers_.insert(identifier_).first;
+}
+
+int FzLexer::Next(LexerInfo* value) {
+  if (first_token_ != 0) {
+    const int token = first_token_;
+    first_token_ = 0;
+    return token;
+  }
+  // Skip blanks and comments.
+  for (;;) {
+    if (current_ == skip_begin_) {
+      current_ = skip_end_;
+      line_number_ += skipped_lines_;
+    }
+    if (current_ == end_) return 0;
+    const char c = *current_;
+    if (c == '\n') {
+      ++line_number_;
+      ++current_;
+    } else if (c == ' ' || c == '\t' || c == '\r') {
+      ++current_;
+    } else if (c == '%') {
+      while (current_ != end_ && *current_ != '\n') ++current_;
+    } else {
+      break;
+    }
+  }
+  const char* const start = current_;
+  const char c = *start;
+  const char next = start + 1 != end_ ? start[1] : '\0';
+  if (IsLetter(c) || c == '_') {
+    const char* p = start;
+    while (p != end_ && *p == '_') ++p;
+    if (p == end_ || !IsLetter(*p)) {
+      // Underscores that do not start an identifier.
+      ++current_;
+      return c;
+    }
+    while (p != end_ && IsIdentifierChar(*p)) ++p;
+    current_ = p;
+    const size_t length = p - start;
+    if (c != '_') {
+      const int token = KeywordToken(start, length);
+      if (token != 0) return token;
+      if (length == 4 && memcmp(start, "true", 4) == 0) {
+        value->integer_value = 1;
+        return IVALUE;
+      }
+      if (length == 5 && memcmp(start, "false", 5) == 0) {
+        value->integer_value = 0;
+        return IVALUE;
+      }
+    }
+    value->identifier = Intern(start, length);
+    return IDENTIFIER;
+  }
+  if (IsDigit(c) || (c == '-' && IsDigit(next))) {
+    return ReadNumber(value);
+  }
+  if (c == '.' && next == '.') {
+    current_ += 2;
+    return DOTDOT;
+  }
+  if (c == ':' && next == ':') {
+    current_ += 2;
+    return COLONCOLON;
+  }
+  if (c == '"') {
+    const char* p = start + 1;
+    while (p != end_ && *p != '"' && *p != '\n') ++p;
+    if (p != end_ && *p == '"') {
+      current_ = p + 1;
+      // As the flex lexer did, the value includes the quotes.
+      value->string_value.assign(start, current_ - start);
+      return SVALUE;
+    }
+  }
+  ++current_;
+  return static_cast<unsigned char>(c);
+}
+
+int FzLexer::ReadNumber(LexerInfo* value) {
+  const char* const start = current_;
+  const char* p = start;
+  const bool negative = *p == '-';
+  if (negative) ++p;
+  // Hexadecimal and octal integers.
+  int base = 10;
+  if (*p == '0' && p + 2 < end_ && (p[1] == 'x' || p[1] == 'o')) {
+    const int prefix_base = p[1] == 'x' ? 16 : 8;
+    if (DigitValue(p[2]) < prefix_base) {
+      base = prefix_base;
+      p += 2;
+    }
+  }
+  const char* const digits = p;
+  while (p != end_ && DigitValue(*p) < base) ++p;
+  bool is_double = false;
+  if (base == 10) {
+    // Fractional part, which must have at least one digit to tell it apart
+    // from the '..' of intervals.
+    if (p + 1 < end_ && *p == '.' && IsDigit(p[1])) {
+      is_double = true;
+      p += 2;
+      while (p != end_ && IsDigit(*p)) ++p;
+    }
+    // Exponent.
+    if (p != end_ && (*p == 'e' || *p == 'E')) {
+      const char* q = p + 1;
+      if (q != end_ && (*q == '+' || *q == '-')) ++q;
+      if (q != end_ && IsDigit(*q)) {
+        is_double = true;
+        while (q != end_ && IsDigit(*q)) ++q;
+        p = q;
+      }
+    }
+  }
+  current_ = p;
+  if (is_double) {
+    // The buffer is not null terminated: copy the number for strtod().
+    const std::string text(start, p - start);
+    value->double_value = strtod(text.c_str(), nullptr);
+    return DVALUE;
+  }
+  uint64 magnitude = 0;
+  for (const char* d = digits; d != p; ++d) {
+    magnitude = magnitude * base + DigitValue(*d);
+  }
+  value->integer_value = negative ? -static_cast<int64>(magnitude)
+                                  : static_cast<int64>(magnitude);
+  return IVALUE;
+}
+}  // namespace operations_research
+
+// Called by the bison parser, with the lexer as scanner.
+int orfz_lex(YYSTYPE* lvalp, void* scanner) {
+  return static_cast<operations_research::FzLexer*>(scanner)->Next(lvalp);
+}
+
+int orfz_get_lineno(void* scanner) {
+  return static_cast<operations_research::FzLexer*>(scanner)->line_number();
+}
@@ -0,0 +1,86 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef OR_TOOLS_FLATZINC_LEXER_H_
+#define OR_TOOLS_FLATZINC_LEXER_H_
+
+#include <cstddef>
+#include <string>
+
+#include "base/hash.h"
+
+namespace operations_research {
+struct LexerInfo;
+
+// Hand-written lexer of the flatzinc format, called by the bison parser of
+// parser.yy through orfz_lex(). It reads the input in place from a memory
+// buffer, typically a memory-mapped file: numbers are converted directly
+// from the buffer, and only the text of the strings is copied, in the value
+// of the token, whose storage is reused from one token to the next.
+//
+// The identifiers are interned: the value of an IDENTIFIER token is a
+// pointer to the unique copy of its text, so that the parser can compare and
+// hash identifiers by address.
+class FzLexer {
+ public:
+  // The buffer must outlive the lexer. It does not need to be null
+  // terminated.
+  FzLexer(const char* data, size_t size);
+
+  // Reads the next token, stores its value (if any) in 'value', and returns
+  // its type as defined in parser.tab.hh, or a character for the single
+  // character tokens, or 0 at the end of the input.
+  int Next(LexerInfo* value);
+
+  // Current line, starting at 1.
+  int line_number() const { return line_number_; }
+  void set_line_number(int line_number) { line_number_ = line_number; }
+
+  // The interned identifiers read so far.
+  const hash_set<std::string>& identifiers() const { return identifiers_; }
+
+  // Makes the lexer return the addresses of the identifiers already interned
+  // by another lexer, which must outlive this one and not read any more
+  // tokens. This is how several lexers can read different parts of the same
+  // model concurrently.
+  void set_shared_identifiers(const hash_set<std::string>* identifiers) {
+    shared_identifiers_ = identifiers;
+  }
+
+  // Makes the lexer return the given token before reading the buffer.
+  void set_first_token(int token) { first_token_ = token; }
+
+  // Makes the lexer jump from begin to end when it reaches begin at the start
+  // of a token. [begin, end) must contain num_lines newlines.
+  void SkipRange(const char* begin, const char* end, int num_lines);
+
+ private:
+  // Reads a number starting at current_, with an optional minus sign.
+  int ReadNumber(LexerInfo* value);
+
+  // Returns the interned copy of [start, start + length).
+  const std::string* Intern(const char* start, size_t length);
+
+  const char* current_;
+  const char* const end_;
+  int line_number_;
+  int first_token_;
+  const char* skip_begin_;
+  const char* skip_end_;
+  int skipped_lines_;
+  hash_set<std::string> identifiers_;
+  const hash_set<std::string>* shared_identifiers_;
+  // Storage reused to look up the identifiers.
+  std::string identifier_;
+};
+}  // namespace operations_research
+#endif  // OR_TOOLS_FLATZINC_LEXER_H_
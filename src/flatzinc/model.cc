@@ -12,6 +12,7 @@
 // limitations under the License.
 #include "base/hash.h"
 #include <iostream>  // NOLINT
+#include <new>
 #include <set>
 #include <vector>
 
@@ -597,14 +598,13 @@ std::string FzOnSolutionOutput::DebugString() const {
 
 // ----- FzModel -----
 
-FzModel::~FzModel() {
-  STLDeleteElements(&variables_);
-  STLDeleteElements(&constraints_);
-}
+// The variables and constraints are destroyed with their arenas.
+FzModel::~FzModel() {}
 
 FzIntegerVariable* FzModel::AddVariable(const std::string& name,
                                         const FzDomain& domain, bool defined) {
-  FzIntegerVariable* const var = new FzIntegerVariable(name, domain, defined);
+  FzIntegerVariable* const var = new (variable_arena_.Allocate())
+      FzIntegerVariable(name, domain, defined);
   variables_.push_back(var);
   return var;
 }
@@ -612,14 +612,21 @@ FzIntegerVariable* FzModel::AddVariable(const std::string& name,
 void FzModel::AddConstraint(const std::string& id,
                             const std::vector<FzArgument>& arguments,
                             bool is_domain, FzIntegerVariable* const defines) {
-  FzConstraint* const constraint =
-      new FzConstraint(id, arguments, is_domain, defines);
+  FzConstraint* const constraint = new (constraint_arena_.Allocate())
+      FzConstraint(id, arguments, is_domain, defines);
   constraints_.push_back(constraint);
   if (defines != nullptr) {
     defines->defining_constraint = constraint;
   }
 }
 
+void FzModel::AddConstraint(const std::string& id,
+                            std::vector<FzArgument>* arguments, bool is_domain,
+                            FzIntegerVariable* const defines) {
+  AddConstraint(id, std::vector<FzArgument>(), is_domain, defines);
+  constraints_.back()->arguments.swap(*arguments);
+}
+
 void FzModel::AddOutput(const FzOnSolutionOutput& output) {
   output_.push_back(output);
 }
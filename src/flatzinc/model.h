@@ -14,7 +14,9 @@
 #define OR_TOOLS_FLATZINC_MODEL_H_
 
 #include <iostream>  // NOLINT
+#include <memory>
 #include <string>
+#include <vector>
 #include "base/hash.h"
 #include "base/commandlineflags.h"
 #include "base/integral_types.h"
@@ -300,6 +302,40 @@ struct FzOnSolutionOutput {
   bool is_boolean;
 };
 
+// Allocates objects of type T in blocks of kBlockSize objects, instead of
+// one by one, and destroys them all at once when it is deleted. The objects
+// never move. Allocate() only returns the memory: the caller constructs the
+// object in place.
+template <class T>
+class FzArena {
+ public:
+  FzArena() : num_in_last_block_(kBlockSize) {}
+  ~FzArena() {
+    for (int b = 0; b < blocks_.size(); ++b) {
+      const int num_objects =
+          b + 1 == blocks_.size() ? num_in_last_block_ : kBlockSize;
+      for (int i = 0; i < num_objects; ++i) {
+        reinterpret_cast<T*>(blocks_[b].get() + i * sizeof(T))->~T();
+      }
+    }
+  }
+
+  void* Allocate() {
+    if (num_in_last_block_ == kBlockSize) {
+      blocks_.emplace_back(new char[kBlockSize * sizeof(T)]);
+      num_in_last_block_ = 0;
+    }
+    return blocks_.back().get() + sizeof(T) * num_in_last_block_++;
+  }
+
+ private:
+  static const int kBlockSize = 1024;
+  std::vector<std::unique_ptr<char[]> > blocks_;
+  int num_in_last_block_;
+
+  DISALLOW_COPY_AND_ASSIGN(FzArena);
+};
+
 class FzModel {
  public:
   explicit FzModel(const std::string& name)
@@ -315,6 +351,10 @@ class FzModel {
   void AddConstraint(const std::string& type,
                      const std::vector<FzArgument>& arguments, bool is_domain,
                      FzIntegerVariable* const target_variable);
+  // Same as above, but takes the arguments, and leaves 'arguments' empty.
+  void AddConstraint(const std::string& type,
+                     std::vector<FzArgument>* arguments, bool is_domain,
+                     FzIntegerVariable* const target_variable);
   void AddOutput(const FzOnSolutionOutput& output);
 
   // Set the search annotations and the objective: either simply satisfy the
@@ -352,10 +392,12 @@ class FzModel {
 
  private:
   const std::string name_;
-  // owned.
+  // Allocated in variable_arena_.
   std::vector<FzIntegerVariable*> variables_;
-  // owned.
+  // Allocated in constraint_arena_.
   std::vector<FzConstraint*> constraints_;
+  FzArena<FzIntegerVariable> variable_arena_;
+  FzArena<FzConstraint> constraint_arena_;
   // The objective variable (it belongs to variables_).
   FzIntegerVariable* objective_;
   bool maximize_;
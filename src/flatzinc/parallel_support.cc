@@ -11,10 +11,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 #include <iostream>  // NOLINT
+#include <atomic>
+#include <memory>
 #include <string>
+#include <vector>
+#include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/map_util.h"
 #include "base/mutex.h"
+#include "base/stl_util.h"
 #include "base/stringprintf.h"
 #include "constraint_solver/constraint_solver.h"
 #include "constraint_solver/constraint_solveri.h"
@@ -79,6 +85,271 @@ class MtCustomLimit : public SearchLimit {
   const int worker_id_;
 };
 
+// ----- Nogood and bound exchange -----
+
+// Nogoods with more terms are kept by the worker that learned them.
+const int kMaxSharedNoGoodSize = 8;
+// Maximum number of nogoods and of bound reductions exchanged during a
+// search. Further ones are not exchanged.
+const int kMaxSharedNoGoods = 1 << 14;
+const int kMaxSharedBounds = 1 << 16;
+
+// A nogood expressed on the indices of the variables of the model, which are
+// the same in all the workers.
+struct SharedNoGood {
+  int worker_id;
+  int num_terms;
+  int variables[kMaxSharedNoGoodSize];
+  int64 values[kMaxSharedNoGoodSize];
+  bool assigns[kMaxSharedNoGoodSize];
+};
+
+// The bounds of a variable of the model at the root node of a worker.
+struct SharedBounds {
+  int worker_id;
+  int variable;
+  int64 min;
+  int64 max;
+};
+
+// A lock-free, append-only channel, in which each worker can publish
+// messages that all the workers read at their own pace. A writer reserves a
+// slot with an atomic increment, fills it, and then marks it as ready. Each
+// reader keeps its own position in the channel, and stops at the first slot
+// that is not ready yet. Messages published once the channel is full are
+// dropped.
+template <class T>
+class BroadcastChannel {
+ public:
+  explicit BroadcastChannel(int capacity)
+      : capacity_(capacity),
+        messages_(capacity),
+        ready_(new std::atomic<bool>[capacity]()),
+        num_reserved_(0) {}
+
+  // Returns false if the message was dropped.
+  bool Publish(const T& message) {
+    if (num_reserved_.load(std::memory_order_relaxed) >= capacity_) {
+      return false;
+    }
+    const int index = num_reserved_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= capacity_) return false;
+    messages_[index] = message;
+    ready_[index].store(true, std::memory_order_release);
+    return true;
+  }
+
+  // Returns the message at the given position and increments the position,
+  // or returns nullptr if this message is not published yet.
+  const T* Read(int* position) const {
+    if (*position >= capacity_ ||
+        !ready_[*position].load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &messages_[(*position)++];
+  }
+
+ private:
+  const int capacity_;
+  std::vector<T> messages_;
+  std::unique_ptr<std::atomic<bool>[]> ready_;
+  std::atomic<int> num_reserved_;
+};
+
+// The nogood manager of a worker. It stores the nogoods learned by the
+// worker and publishes the short ones. When the search starts or restarts,
+// it imports the nogoods and the root bounds published by the other
+// workers, applies them with its own nogoods, and publishes the bounds of
+// the variables that this tightened at the root node.
+class MtNoGoodManager : public NoGoodManager {
+ public:
+  MtNoGoodManager(Solver* const s, const std::vector<IntVar*>& variables,
+                  BroadcastChannel<SharedNoGood>* nogood_channel,
+                  BroadcastChannel<SharedBounds>* bounds_channel,
+                  FzParallelSupportInterface* support, int worker_id)
+      : NoGoodManager(s),
+        variables_(variables),
+        nogood_channel_(nogood_channel),
+        bounds_channel_(bounds_channel),
+        support_(support),
+        worker_id_(worker_id),
+        imported_min_(variables.size(), kint64min),
+        imported_max_(variables.size(), kint64max),
+        exported_min_(variables.size(), kint64min),
+        exported_max_(variables.size(), kint64max),
+        nogood_position_(0),
+        bounds_position_(0),
+        at_root_(false),
+        num_exported_nogoods_(0),
+        num_imported_nogoods_(0),
+        num_exported_bounds_(0),
+        num_imported_bounds_(0) {
+    for (int i = 0; i < variables_.size(); ++i) {
+      if (variables_[i] != nullptr) {
+        InsertIfNotPresent(&variable_indices_, variables_[i], i);
+      }
+    }
+  }
+
+  ~MtNoGoodManager() override { Clear(); }
+
+  void Clear() override { STLDeleteElements(&nogoods_); }
+
+  void AddNoGood(NoGood* const nogood) override {
+    nogoods_.push_back(nogood);
+    Export(*nogood);
+  }
+
+  int NoGoodCount() const override { return nogoods_.size(); }
+
+  void RestartSearch() override { at_root_ = true; }
+
+  void ExitSearch() override {
+    support_->Log(
+        worker_id_,
+        StringPrintf("exported %d nogoods and %d bounds, imported %d nogoods "
+                     "and %d bounds",
+                     num_exported_nogoods_, num_exported_bounds_,
+                     num_imported_nogoods_, num_imported_bounds_));
+  }
+
+  std::string DebugString() const override {
+    return StringPrintf("MtNoGoodManager(%d)", NoGoodCount());
+  }
+
+ private:
+  void Init() override { at_root_ = true; }
+
+  void Apply() override {
+    Solver* const s = solver();
+    const bool at_root = at_root_;
+    at_root_ = false;
+    if (at_root) {
+      Import();
+    }
+    for (NoGood* const nogood : nogoods_) {
+      nogood->Apply(s);
+    }
+    if (at_root) {
+      ExportRootBounds();
+    }
+  }
+
+  void Export(const NoGood& nogood) {
+    if (nogood.NumTerms() > kMaxSharedNoGoodSize) return;
+    SharedNoGood shared;
+    shared.worker_id = worker_id_;
+    shared.num_terms = nogood.NumTerms();
+    for (int i = 0; i < nogood.NumTerms(); ++i) {
+      IntVar* var = nullptr;
+      if (!nogood.IntegerVariableTerm(i, &var, &shared.values[i],
+                                      &shared.assigns[i])) {
+        return;
+      }
+      const int* const index = FindOrNull(variable_indices_, var);
+      if (index == nullptr) return;
+      shared.variables[i] = *index;
+    }
+    if (nogood_channel_->Publish(shared)) {
+      num_exported_nogoods_++;
+    }
+  }
+
+  // Reads the nogoods and bounds published by the other workers since the
+  // last call, and applies all the imported bounds, which were undone by the
+  // restart.
+  void Import() {
+    if (root_min_.empty()) {
+      // Root domains, used to only export the reductions of this worker.
+      root_min_.resize(variables_.size(), kint64min);
+      root_max_.resize(variables_.size(), kint64max);
+      for (int i = 0; i < variables_.size(); ++i) {
+        if (variables_[i] != nullptr) {
+          root_min_[i] = variables_[i]->Min();
+          root_max_[i] = variables_[i]->Max();
+        }
+      }
+    }
+    for (const SharedNoGood* shared = nogood_channel_->Read(&nogood_position_);
+         shared != nullptr; shared = nogood_channel_->Read(&nogood_position_)) {
+      if (shared->worker_id == worker_id_) continue;
+      NoGood* const nogood = MakeNoGood();
+      for (int i = 0; i < shared->num_terms; ++i) {
+        IntVar* const var = variables_[shared->variables[i]];
+        DCHECK(var != nullptr);
+        if (shared->assigns[i]) {
+          nogood->AddIntegerVariableEqualValueTerm(var, shared->values[i]);
+        } else {
+          nogood->AddIntegerVariableNotEqualValueTerm(var, shared->values[i]);
+        }
+      }
+      nogoods_.push_back(nogood);
+      num_imported_nogoods_++;
+    }
+    for (const SharedBounds* shared = bounds_channel_->Read(&bounds_position_);
+         shared != nullptr; shared = bounds_channel_->Read(&bounds_position_)) {
+      if (shared->worker_id == worker_id_) continue;
+      const int index = shared->variable;
+      if (imported_min_[index] == kint64min &&
+          imported_max_[index] == kint64max) {
+        imported_variables_.push_back(index);
+      }
+      imported_min_[index] = std::max(imported_min_[index], shared->min);
+      imported_max_[index] = std::min(imported_max_[index], shared->max);
+      num_imported_bounds_++;
+    }
+    for (const int index : imported_variables_) {
+      variables_[index]->SetRange(imported_min_[index], imported_max_[index]);
+    }
+  }
+
+  // Publishes the bounds tightened at the root node since the last call,
+  // and which were not imported from another worker.
+  void ExportRootBounds() {
+    for (int i = 0; i < variables_.size(); ++i) {
+      IntVar* const var = variables_[i];
+      if (var == nullptr) continue;
+      const int64 known_min =
+          std::max(root_min_[i], std::max(imported_min_[i], exported_min_[i]));
+      const int64 known_max =
+          std::min(root_max_[i], std::min(imported_max_[i], exported_max_[i]));
+      if (var->Min() > known_min || var->Max() < known_max) {
+        SharedBounds shared;
+        shared.worker_id = worker_id_;
+        shared.variable = i;
+        shared.min = var->Min();
+        shared.max = var->Max();
+        if (!bounds_channel_->Publish(shared)) return;
+        exported_min_[i] = var->Min();
+        exported_max_[i] = var->Max();
+        num_exported_bounds_++;
+      }
+    }
+  }
+
+  const std::vector<IntVar*> variables_;
+  hash_map<const IntVar*, int> variable_indices_;
+  BroadcastChannel<SharedNoGood>* const nogood_channel_;
+  BroadcastChannel<SharedBounds>* const bounds_channel_;
+  FzParallelSupportInterface* const support_;
+  const int worker_id_;
+  std::vector<NoGood*> nogoods_;
+  std::vector<int64> root_min_;
+  std::vector<int64> root_max_;
+  std::vector<int64> imported_min_;
+  std::vector<int64> imported_max_;
+  std::vector<int> imported_variables_;
+  std::vector<int64> exported_min_;
+  std::vector<int64> exported_max_;
+  int nogood_position_;
+  int bounds_position_;
+  bool at_root_;
+  int num_exported_nogoods_;
+  int num_imported_nogoods_;
+  int num_exported_bounds_;
+  int num_imported_bounds_;
+};
+
 class MtSupportInterface : public FzParallelSupportInterface {
  public:
   MtSupportInterface(bool print_all, int num_solutions, bool verbose)
@@ -89,7 +360,9 @@ class MtSupportInterface : public FzParallelSupportInterface {
         last_worker_(-1),
         best_solution_(0),
         should_finish_(false),
-        interrupted_(false) {}
+        interrupted_(false),
+        nogood_channel_(kMaxSharedNoGoods),
+        bounds_channel_(kMaxSharedBounds) {}
 
   virtual ~MtSupportInterface() {}
 
@@ -202,6 +475,13 @@ class MtSupportInterface : public FzParallelSupportInterface {
     return s->RevAlloc(new MtCustomLimit(s, this, worker_id));
   }
 
+  virtual NoGoodManager* NoGoods(Solver* s,
+                                 const std::vector<IntVar*>& variables,
+                                 int worker_id) {
+    return s->RevAlloc(new MtNoGoodManager(
+        s, variables, &nogood_channel_, &bounds_channel_, this, worker_id));
+  }
+
   virtual void Log(int worker_id, const std::string& message) {
     if (verbose_) {
       MutexLock lock(&mutex_);
@@ -228,6 +508,8 @@ class MtSupportInterface : public FzParallelSupportInterface {
   int64 best_solution_;
   bool should_finish_;
   bool interrupted_;
+  BroadcastChannel<SharedNoGood> nogood_channel_;
+  BroadcastChannel<SharedBounds> bounds_channel_;
 };
 }  // namespace
 
@@ -10,67 +10,240 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
-#include <cstdio>
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/commandlineflags.h"
 #include "base/file.h"
+#include "base/logging.h"
+#include "base/threadpool.h"
+#include "flatzinc/lexer.h"
 #include "flatzinc/parser.h"
 #include "flatzinc/parser.tab.hh"
 
+DEFINE_int32(fz_parser_threads, 1,
+             "Number of threads that parse the constraint items of a "
+             "flatzinc model. The parsed model does not depend on it.");
+DEFINE_int32(fz_parser_min_chunk_size, 1 << 20,
+             "Minimum size in bytes of the chunks of constraint items parsed "
+             "by each thread when fz_parser_threads > 1.");
+
 // Declare external functions in the flatzinc.tab.cc generated file.
-extern int orfz_parse(operations_research::FzParserContext* parser,
-                      operations_research::FzModel* model, bool* ok,
-                      void* scanner);
-extern int orfz_lex_init(void** scanner);
-extern int orfz_lex_destroy(void* scanner);
-extern void orfz_set_in(FILE* in_str, void* yyscanner);
-// Declare external functions and structures in the flatzinc.yy.cc
-// generated file.
-struct yy_buffer_state;
-extern yy_buffer_state* orfz__scan_bytes(const char* input, size_t size,
-                                         void* scanner);
-extern void orfz__delete_buffer(yy_buffer_state* b, void* scanner);
+extern int orfz_parse(
+    operations_research::FzParserContext* parser,
+    operations_research::FzModel* model,
+    std::vector<operations_research::FzParsedConstraint>* parsed_constraints,
+    bool* ok, void* scanner);
 
 namespace operations_research {
-// ----- public parsing API -----
+namespace {
+// A part of the buffer made of whole constraint items.
+struct ConstraintChunk {
+  const char* begin;
+  const char* end;
+  // The line of begin, starting at 1.
+  int line_number;
+  // The result of the parsing of the chunk.
+  std::vector<FzParsedConstraint> constraints;
+  bool ok;
+};
 
-bool ParseFlatzincFile(const std::string& filename, FzModel* const model) {
-  // Init.
-  FILE* const input = fopen(filename.c_str(), "r");
-  if (input == nullptr) {
-    LOG(INFO) << "Could not open file '" << filename << "'";
+// Returns true if the item starting at p is a constraint item.
+bool IsConstraintItem(const char* p, const char* end) {
+  static const char kConstraint[] = "constraint";
+  const size_t length = sizeof(kConstraint) - 1;
+  if (static_cast<size_t>(end - p) <= length ||
+      memcmp(p, kConstraint, length) != 0) {
     return false;
   }
+  const char c = p[length];
+  return !(c == '_' || (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') ||
+           (c >= 'A' && c <= 'Z'));
+}
+
+// Scans the items of the buffer, without parsing them, to find the sequence
+// of constraint items, which is between the declarations and the solve item.
+// Splits it in about num_chunks chunks of whole items, and returns false if
+// it is not worth splitting. Also returns in skipped_lines the number of
+// lines of the constraint items.
+bool SplitConstraintItems(const char* data, size_t size, int num_chunks,
+                          std::vector<ConstraintChunk>* chunks,
+                          int* skipped_lines) {
+  const char* const end = data + size;
+  const char* p = data;
+  int line_number = 1;
+  int constraints_line_number = 0;
+  size_t chunk_size = 0;
+  for (;;) {
+    // Skip blanks and comments to the start of the next item.
+    while (p != end) {
+      if (*p == '\n') {
+        ++line_number;
+        ++p;
+      } else if (*p == ' ' || *p == '\t' || *p == '\r') {
+        ++p;
+      } else if (*p == '%') {
+        while (p != end && *p != '\n') ++p;
+      } else {
+        break;
+      }
+    }
+    const bool is_constraint = IsConstraintItem(p, end);
+    if (chunks->empty()) {
+      if (p == end) return false;
+      if (is_constraint) {
+        chunk_size = (end - p) / num_chunks;
+        if (chunk_size == 0 ||
+            chunk_size < static_cast<size_t>(FLAGS_fz_parser_min_chunk_size)) {
+          return false;
+        }
+        constraints_line_number = line_number;
+        chunks->push_back({p, nullptr, line_number});
+      }
+    } else if (!is_constraint) {
+      chunks->back().end = p;
+      *skipped_lines = line_number - constraints_line_number;
+      return chunks->size() > 1;
+    } else if (p - chunks->back().begin >= chunk_size) {
+      chunks->back().end = p;
+      chunks->push_back({p, nullptr, line_number});
+    }
+    // Skip the item, up to its ';'.
+    while (p != end && *p != ';') {
+      if (*p == '\n') {
+        ++line_number;
+        ++p;
+      } else if (*p == '%') {
+        while (p != end && *p != '\n') ++p;
+      } else if (*p == '"') {
+        ++p;
+        while (p != end && *p != '"' && *p != '\n') ++p;
+        if (p != end && *p == '"') ++p;
+      } else {
+        ++p;
+      }
+    }
+    if (p == end) {
+      // No solve item: let the sequential parser report the error.
+      chunks->clear();
+      return false;
+    }
+    ++p;
+  }
+}
+
+// The grammar only reads the context while parsing constraint items, so
+// several chunks can be parsed concurrently with the same context.
+void ParseConstraintChunk(FzParserContext* context,
+                          const hash_set<std::string>* identifiers,
+                          ConstraintChunk* chunk) {
+  FzLexer lexer(chunk->begin, chunk->end - chunk->begin);
+  lexer.set_shared_identifiers(identifiers);
+  lexer.set_line_number(chunk->line_number);
+  lexer.set_first_token(START_CONSTRAINTS);
+  chunk->ok = true;
+  orfz_parse(context, nullptr, &chunk->constraints, &chunk->ok, &lexer);
+}
+
+bool ParseFlatzincBuffer(const char* data, size_t size, FzModel* const model) {
   FzParserContext context;
   bool ok = true;
-  void* scanner = nullptr;
-  orfz_lex_init(&scanner);
-  orfz_set_in(input, scanner);
-  // Parse.
-  orfz_parse(&context, model, &ok, scanner);
-  // Clean up.
-  if (scanner != nullptr) {
-    orfz_lex_destroy(scanner);
+  FzLexer lexer(data, size);
+  std::vector<ConstraintChunk> chunks;
+  int skipped_lines = 0;
+  if (FLAGS_fz_parser_threads <= 1 ||
+      !SplitConstraintItems(data, size, FLAGS_fz_parser_threads, &chunks,
+                            &skipped_lines)) {
+    orfz_parse(&context, model, nullptr, &ok, &lexer);
+    return ok;
+  }
+  // The declarations and the solve item are parsed first. Then the chunks of
+  // constraint items are parsed concurrently, each in its own vector, and
+  // their constraints are added to the model in the order of the file. As in
+  // the sequential parser, the items with a syntax error are skipped, and the
+  // other ones are still added to the model.
+  lexer.SkipRange(chunks.front().begin, chunks.back().end, skipped_lines);
+  orfz_parse(&context, model, nullptr, &ok, &lexer);
+  {
+    ThreadPool pool("FlatZinc parser", FLAGS_fz_parser_threads);
+    for (ConstraintChunk& chunk : chunks) {
+      pool.Add(NewCallback(&ParseConstraintChunk, &context,
+                           &lexer.identifiers(), &chunk));
+    }
+    pool.StartWorkers();
+  }
+  for (ConstraintChunk& chunk : chunks) {
+    ok &= chunk.ok;
+    for (FzParsedConstraint& ct : chunk.constraints) {
+      model->AddConstraint(ct.type, &ct.arguments, ct.is_domain,
+                           ct.target_variable);
+    }
   }
-  fclose(input);
   return ok;
 }
+}  // namespace
 
-bool ParseFlatzincString(const std::string& input, FzModel* const model) {
-  // Init.
-  FzParserContext context;
-  bool ok = true;
-  void* scanner = nullptr;
-  orfz_lex_init(&scanner);
-  yy_buffer_state* const string_buffer =
-      orfz__scan_bytes(input.data(), input.size(), scanner);
-  // Parse.
-  orfz_parse(&context, model, &ok, scanner);
-  // Clean up.
-  if (string_buffer != nullptr) {
-    orfz__delete_buffer(string_buffer, scanner);
+// ----- public parsing API -----
+
+bool ParseFlatzincFile(const std::string& filename, FzModel* const model) {
+#if !defined(_MSC_VER)
+  // The file is memory-mapped, and read in place by the lexer.
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(INFO) << "Could not open file '" << filename << "'";
+    return false;
   }
-  if (scanner != nullptr) {
-    orfz_lex_destroy(scanner);
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    LOG(INFO) << "Could not read file '" << filename << "'";
+    close(fd);
+    return false;
+  }
+  const size_t size = file_stat.st_size;
+  if (size == 0) {
+    close(fd);
+    return ParseFlatzincBuffer("", 0, model);
+  }
+  void* const address = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping stays valid after the file descriptor is closed.
+  close(fd);
+  if (address == MAP_FAILED) {
+    LOG(INFO) << "Could not map file '" << filename << "'";
+    return false;
   }
+  madvise(address, size, MADV_SEQUENTIAL);
+  const bool ok =
+      ParseFlatzincBuffer(static_cast<const char*>(address), size, model);
+  munmap(address, size);
   return ok;
+#else
+  std::unique_ptr<File> file(File::Open(filename, "rb"));
+  if (file == nullptr) {
+    LOG(INFO) << "Could not open file '" << filename << "'";
+    return false;
+  }
+  std::string contents;
+  const int64 size = file->Size();
+  const bool read = size == 0 || file->ReadToString(&contents, size) == size;
+  file->Close();
+  if (!read) {
+    LOG(INFO) << "Could not read file '" << filename << "'";
+    return false;
+  }
+  return ParseFlatzincBuffer(contents.data(), contents.size(), model);
+#endif
+}
+
+bool ParseFlatzincString(const std::string& input, FzModel* const model) {
+  return ParseFlatzincBuffer(input.data(), input.size(), model);
 }
 }  // namespace operations_research
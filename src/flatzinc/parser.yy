@@ -9,6 +9,7 @@
 // parameter of orfz_lex() is defined below (see YYLEX_PARAM).
 %parse-param {operations_research::FzParserContext* context}
 %parse-param {operations_research::FzModel* model}
+%parse-param {std::vector<operations_research::FzParsedConstraint>* parsed_constraints}
 %parse-param {bool* ok}
 %parse-param {void* scanner}
 
@@ -24,14 +25,25 @@
 #include "flatzinc/model.h"
 
 namespace operations_research {
-// This is the context used during parsing.
+// This is the context used during parsing. The identifiers are interned by
+// the lexer, so they are mapped by address.
 struct FzParserContext {
-  hash_map<std::string, int64> integer_map;
-  hash_map<std::string, std::vector<int64> > integer_array_map;
-  hash_map<std::string, FzIntegerVariable*> variable_map;
-  hash_map<std::string, std::vector<FzIntegerVariable*> > variable_array_map;
-  hash_map<std::string, FzDomain> domain_map;
-  hash_map<std::string, std::vector<FzDomain> > domain_array_map;
+  hash_map<const std::string*, int64> integer_map;
+  hash_map<const std::string*, std::vector<int64> > integer_array_map;
+  hash_map<const std::string*, FzIntegerVariable*> variable_map;
+  hash_map<const std::string*, std::vector<FzIntegerVariable*> >
+      variable_array_map;
+  hash_map<const std::string*, FzDomain> domain_map;
+  hash_map<const std::string*, std::vector<FzDomain> > domain_array_map;
+};
+
+// A constraint parsed but not yet added to the model, see
+// START_CONSTRAINTS below.
+struct FzParsedConstraint {
+  std::string type;
+  std::vector<FzArgument> arguments;
+  bool is_domain;
+  FzIntegerVariable* target_variable;
 };
 
 // An optional reference to a variable, or an integer value, used in
@@ -85,6 +97,7 @@ struct LexerInfo {
   int64 integer_value;
   double double_value;
   std::string string_value;
+  const std::string* identifier;
   FzDomain domain;
   std::vector<FzDomain>* domains;
   std::vector<int64>* integers;
@@ -97,7 +110,8 @@ struct LexerInfo {
 };
 }  // namespace operations_research
 
-// Tells flex to use the LexerInfo class to communicate with the bison parser.
+// Tells the lexer (see lexer.h) to use the LexerInfo class to communicate with
+// the bison parser.
 typedef operations_research::LexerInfo YYSTYPE;
 
 // Defines the parameter to the orfz_lex() call from the orfz_parse() method.
@@ -123,7 +137,8 @@ extern int orfz_debug;
 
 using namespace operations_research;
 
-void orfz_error(FzParserContext* context, FzModel* model, bool* ok,
+void orfz_error(FzParserContext* context, FzModel* model,
+                std::vector<FzParsedConstraint>* parsed_constraints, bool* ok,
                 void* scanner, const char* str) {
   LOG(ERROR) << "Error: " << str << " in line no. " << orfz_get_lineno(scanner);
   *ok = false;
@@ -169,7 +184,7 @@ template<class T> const T& FzLookup(const std::vector<T>& v, int index) {
 
 // Type declarations.
 
-// The lexer, defined in the ./flazinc.lex file, does the low-level parsing
+// The lexer, defined in lexer.cc, does the low-level parsing
 // of std::string tokens and converts each of them them into a YACC token. A YACC
 // token has a type (VAR, IVALUE, const_literal) and optionally a value,
 // stored in a token-specific field of a LexerInfo instance dedicated to this
@@ -181,15 +196,21 @@ template<class T> const T& FzLookup(const std::vector<T>& v, int index) {
 // Multi-characters constants (eg. "::") aren't, which is why we need to
 // define them here.
 //
-// Here are the terminal, valueless tokens. See the .lex file to see where
-// they come from.
+// Here are the terminal, valueless tokens. See lexer.cc to see where they
+// come from.
 %token ARRAY BOOL CONSTRAINT FLOAT INT MAXIMIZE MINIMIZE OF
 %token PREDICATE SATISFY SET SOLVE VAR DOTDOT COLONCOLON
+// This token is never in the input. The lexer returns it first to parse only
+// a sequence of constraint items, with the context of the declarations
+// already parsed. The constraints are then stored in parsed_constraints
+// instead of the model.
+%token START_CONSTRAINTS
 // Here are the terminal, value-carrying tokens, preceded by the name of the
 // LexerInfo field in which their value is stored (eg. the value of a IVALUE
 //  token is stored in LexerInfo::integer_value).
 %token <integer_value> IVALUE
-%token <string_value> SVALUE IDENTIFIER
+%token <string_value> SVALUE
+%token <identifier> IDENTIFIER
 %token <double_value> DVALUE
 // Here are the non-terminal, value-carrying rules.
 // Again they are preceded by the name of the LexerInfo field in which
@@ -211,6 +232,10 @@ template<class T> const T& FzLookup(const std::vector<T>& v, int index) {
 // Model top-level
 //---------------------------------------------------------------------------
 
+start:
+  model
+| START_CONSTRAINTS constraint_chunk
+
 model: predicates variable_or_constant_declarations constraints solve ';'
 
 //---------------------------------------------------------------------------
@@ -261,7 +286,7 @@ variable_or_constant_declaration:
   // Declaration of a (named) constant: we simply register it in the
   // parser's context, and don't store it in the model.
   const FzDomain& domain = $1;
-  const std::string& identifier = $3;
+  const std::string* const identifier = $3;
   const FzDomain& assignment = $6;
   std::vector<FzAnnotation>* const annotations = $4;
 
@@ -282,7 +307,7 @@ variable_or_constant_declaration:
   // Declaration of a (named) constant array. See rule right above.
   CHECK_EQ($3, 1) << "Only [1..n] array are supported here.";
   const int64 num_constants = $5;
-  const std::string& identifier = $10;
+  const std::string* const identifier = $10;
   const std::vector<int64>* const assignments = $14;
   CHECK(assignments != nullptr);
   CHECK_EQ(num_constants, assignments->size());
@@ -298,7 +323,7 @@ variable_or_constant_declaration:
   CHECK_EQ($3, 1) << "Only [1..n] array are supported here.";
   const int64 num_constants = $5;
   CHECK_EQ($5, 0) << "Empty arrays should have a size of 0";
-  const std::string& identifier = $10;
+  const std::string* const identifier = $10;
   context->integer_array_map[identifier] = std::vector<int64>();
   delete annotations;
 }| ARRAY '[' IVALUE DOTDOT IVALUE ']' OF set_domain ':' IDENTIFIER
@@ -307,7 +332,7 @@ variable_or_constant_declaration:
   CHECK_EQ($3, 1) << "Only [1..n] array are supported here.";
   const int64 num_constants = $5;
   const FzDomain& domain = $8;
-  const std::string& identifier = $10;
+  const std::string* const identifier = $10;
   const std::vector<FzDomain>* const assignments = $14;
   const std::vector<FzAnnotation>* const annotations = $11;
   CHECK(assignments != nullptr);
@@ -333,28 +358,28 @@ variable_or_constant_declaration:
   // assigned to another variable x then we simply adjust that
   // existing variable x according to the current (re-)declaration.
   const FzDomain& domain = $2;
-  const std::string& identifier = $4;
+  const std::string* const identifier = $4;
   std::vector<FzAnnotation>* const annotations = $5;
   const VariableRefOrValue& assignment = $6;
   const bool introduced = ContainsId(annotations, "var_is_introduced");
   FzIntegerVariable* var = nullptr;
   if (!assignment.defined) {
-    var = model->AddVariable(identifier, domain, introduced);
+    var = model->AddVariable(*identifier, domain, introduced);
   } else if (assignment.variable == nullptr) {  // just an integer constant.
     CHECK(domain.Contains(assignment.value));
     var = model->AddVariable(
-        identifier, FzDomain::Singleton(assignment.value), introduced);
+        *identifier, FzDomain::Singleton(assignment.value), introduced);
   } else {  // a variable.
     var = assignment.variable;
-    var->Merge(identifier, domain, nullptr, introduced);
+    var->Merge(*identifier, domain, nullptr, introduced);
   }
 
   // We also register the variable in the parser's context, and add some
   // output to the model if needed.
   context->variable_map[identifier] = var;
   if (ContainsId(annotations, "output_var")) {
-    model->AddOutput(
-        FzOnSolutionOutput::SingleVariable(identifier, var, domain.is_boolean));
+    model->AddOutput(FzOnSolutionOutput::SingleVariable(*identifier, var,
+                                                        domain.is_boolean));
   }
   delete annotations;
 }
@@ -366,7 +391,7 @@ variable_or_constant_declaration:
   CHECK_EQ($3, 1);
   const int64 num_vars = $5;
   const FzDomain& domain = $9;
-  const std::string& identifier = $11;
+  const std::string* const identifier = $11;
   std::vector<FzAnnotation>* const annotations = $12;
   VariableRefOrValueArray* const assignments = $13;
   CHECK(assignments == nullptr || assignments->variables.size() == num_vars);
@@ -376,7 +401,7 @@ variable_or_constant_declaration:
   std::vector<FzIntegerVariable*> vars(num_vars, nullptr);
 
   for (int i = 0; i < num_vars; ++i) {
-    const std::string var_name = StringPrintf("%s[%d]", identifier.c_str(), i + 1);
+    const std::string var_name = StringPrintf("%s[%d]", identifier->c_str(), i + 1);
     if (assignments == nullptr) {
       vars[i] = model->AddVariable(var_name, domain, introduced);
     } else if (assignments->variables[i] == nullptr) {
@@ -418,7 +443,7 @@ variable_or_constant_declaration:
         }
         // We add the output information.
         model->AddOutput(
-            FzOnSolutionOutput::MultiDimensionalArray(identifier, bounds, vars,
+            FzOnSolutionOutput::MultiDimensionalArray(*identifier, bounds, vars,
       domain.is_boolean));
       }
     }
@@ -448,20 +473,20 @@ var_or_value:
   IVALUE { $$ = VariableRefOrValue::Value($1); }  // An integer value.
 | IDENTIFIER {
   // A reference to an existing integer constant or variable.
-  const std::string& id = $1;
+  const std::string* const id = $1;
   if (ContainsKey(context->integer_map, id)) {
     $$ = VariableRefOrValue::Value(FindOrDie(context->integer_map, id));
   } else if (ContainsKey(context->variable_map, id)) {
     $$ = VariableRefOrValue::VariableRef(FindOrDie(context->variable_map, id));
   } else {
-    LOG(ERROR) << "Unknown symbol " << id;
+    LOG(ERROR) << "Unknown symbol " << *id;
     $$ = VariableRefOrValue::Undefined();
     *ok = false;
   }
 }
 | IDENTIFIER '[' IVALUE ']' {
   // A given element of an existing constant array or variable array.
-  const std::string& id = $1;
+  const std::string* const id = $1;
   const int64 value = $3;
   if (ContainsKey(context->integer_array_map, id)) {
     $$ = VariableRefOrValue::Value(
@@ -470,7 +495,7 @@ var_or_value:
     $$ = VariableRefOrValue::VariableRef(
         FzLookup(FindOrDie(context->variable_array_map, id), value));
   } else {
-    LOG(ERROR) << "Unknown symbol " << id;
+    LOG(ERROR) << "Unknown symbol " << *id;
     $$ = VariableRefOrValue::Undefined();
     *ok = false;
   }
@@ -547,10 +572,18 @@ const_literals:
 constraints: constraints constraint ';'
 | /* empty */
 
+// The constraint items parsed after START_CONSTRAINTS. As the error clause of
+// the predicates does for a whole model, an item that fails to parse is
+// skipped, and the next ones are still parsed.
+constraint_chunk:
+  constraint_chunk constraint ';'
+| constraint_chunk error ';' { yyerrok; }
+| /* empty */
+
 constraint :
   CONSTRAINT IDENTIFIER '(' arguments ')' annotations {
-  const std::string& identifier = $2;
-  const std::vector<FzArgument>* const arguments = $4;
+  const std::string& identifier = *$2;
+  std::vector<FzArgument>* const arguments = $4;
   std::vector<FzAnnotation>* const annotations = $6;
 
   // Does the constraint has a defines_var annotation?
@@ -568,8 +601,17 @@ constraint :
   }
 
   CHECK(arguments != nullptr);
-  model->AddConstraint(identifier, *arguments,
-                       ContainsId(annotations, "domain"), defines_var);
+  const bool is_domain = ContainsId(annotations, "domain");
+  if (parsed_constraints != nullptr) {
+    parsed_constraints->emplace_back();
+    FzParsedConstraint* const parsed = &parsed_constraints->back();
+    parsed->type = identifier;
+    parsed->arguments.swap(*arguments);
+    parsed->is_domain = is_domain;
+    parsed->target_variable = defines_var;
+  } else {
+    model->AddConstraint(identifier, arguments, is_domain, defines_var);
+  }
   delete annotations;
   delete arguments;
 }
@@ -589,7 +631,7 @@ argument:
   delete $2;
 }
 | IDENTIFIER {
-  const std::string& id = $1;
+  const std::string* const id = $1;
   if (ContainsKey(context->integer_map, id)) {
     $$ = FzArgument::IntegerValue(FindOrDie(context->integer_map, id));
   } else if (ContainsKey(context->integer_array_map, id)) {
@@ -599,13 +641,14 @@ argument:
   } else if (ContainsKey(context->variable_array_map, id)) {
     $$ = FzArgument::IntVarRefArray(FindOrDie(context->variable_array_map, id));
   } else {
-    CHECK(ContainsKey(context->domain_map, id)) << "Unknown identifier: " << id;
+    CHECK(ContainsKey(context->domain_map, id)) << "Unknown identifier: "
+                                                << *id;
     const FzDomain& d = FindOrDie(context->domain_map, id);
     $$ = FzArgument::FromDomain(d);
   }
 }
 | IDENTIFIER '[' IVALUE ']' {
-  const std::string& id = $1;
+  const std::string* const id = $1;
   const int64 index = $3;
   if (ContainsKey(context->integer_array_map, id)) {
     $$ = FzArgument::IntegerValue(
@@ -615,7 +658,7 @@ argument:
         FzLookup(FindOrDie(context->variable_array_map, id), index));
   } else {
     CHECK(ContainsKey(context->domain_array_map, id))
-        << "Unknown identifier: " << id;
+        << "Unknown identifier: " << *id;
     const FzDomain& d =
         FzLookup(FindOrDie(context->domain_array_map, id), index);
     $$ = FzArgument::FromDomain(d);
@@ -667,23 +710,23 @@ annotation:
 | IVALUE { $$ = FzAnnotation::IntegerValue($1); }
 | SVALUE { $$ = FzAnnotation::String($1); }
 | IDENTIFIER {
-  const std::string& id = $1;
+  const std::string* const id = $1;
   if (ContainsKey(context->variable_map, id)) {
     $$ = FzAnnotation::Variable(FindOrDie(context->variable_map, id));
   } else if (ContainsKey(context->variable_array_map, id)) {
     $$ = FzAnnotation::VariableList(FindOrDie(context->variable_array_map, id));
   } else {
-    $$ = FzAnnotation::Identifier(id);
+    $$ = FzAnnotation::Identifier(*id);
   }
 }
 | IDENTIFIER '(' annotation_arguments ')' {
   std::vector<FzAnnotation>* const annotations = $3;
-  $$ = FzAnnotation::FunctionCall($1, annotations);
+  $$ = FzAnnotation::FunctionCall(*$1, annotations);
   delete annotations;
 }
 | IDENTIFIER '[' IVALUE ']' {
   CHECK(ContainsKey(context->variable_array_map, $1))
-      << "Unknown identifier: " << $1;
+      << "Unknown identifier: " << *$1;
   $$ = FzAnnotation::Variable(
       FzLookup(FindOrDie(context->variable_array_map, $1), $3));
 }
@@ -13,11 +13,20 @@
 // This binary reads an input file in the flatzinc format (see
 // http://www.minizinc.org/), parses it, and spits out the model it
 // has built.
+//
+// With --benchmark_iterations=n, it instead parses n times each file given on
+// the command line after the flags, and reports the parse times, e.g.:
+//   parser_main --benchmark_iterations=10 examples/flatzinc/*.fzn
 
+#include <iostream>
 #include <string>
+#include <vector>
 
 #include "base/commandlineflags.h"
 #include "base/commandlineflags.h"
+#include "base/file.h"
+#include "base/stringprintf.h"
+#include "base/timer.h"
 #include "flatzinc/model.h"
 #include "flatzinc/parser.h"
 #include "flatzinc/presolve.h"
@@ -26,6 +35,9 @@ DEFINE_string(file, "", "Input file in the flatzinc format.");
 DEFINE_bool(print, false, "Print model.");
 DEFINE_bool(presolve, false, "Presolve loaded file.");
 DEFINE_bool(statistics, false, "Print model statistics");
+DEFINE_int32(benchmark_iterations, 0,
+             "If positive, parse each file given after the flags this many "
+             "times, and print the parse times.");
 DECLARE_bool(fz_logging);
 
 namespace operations_research {
@@ -55,11 +67,53 @@ void ParseFile(const std::string& filename, bool presolve) {
     FZLOG << model.DebugString() << FZENDL;
   }
 }
+
+void BenchmarkParser(const std::vector<std::string>& filenames,
+                     int iterations) {
+  int num_parsed = 0;
+  double total_bytes = 0.0;
+  double total_seconds = 0.0;
+  for (const std::string& filename : filenames) {
+    File* const file = File::OpenOrDie(filename, "r");
+    const double bytes = file->Size();
+    file->Close();
+    WallTimer timer;
+    timer.Start();
+    bool ok = true;
+    for (int i = 0; ok && i < iterations; ++i) {
+      FzModel model(filename);
+      ok = ParseFlatzincFile(filename, &model);
+    }
+    timer.Stop();
+    if (!ok) {
+      std::cout << filename << ": parse error, skipped" << std::endl;
+      continue;
+    }
+    const double seconds = timer.Get() / iterations;
+    std::cout << StringPrintf("%-60s %10.3f ms %8.2f MB/s", filename.c_str(),
+                              seconds * 1e3, bytes * 1e-6 / seconds)
+              << std::endl;
+    ++num_parsed;
+    total_bytes += bytes;
+    total_seconds += seconds;
+  }
+  std::cout << StringPrintf("Parsed %d files (%.2f MB) in %.3f ms, %.2f MB/s",
+                            num_parsed, total_bytes * 1e-6,
+                            total_seconds * 1e3,
+                            total_bytes * 1e-6 / total_seconds)
+            << std::endl;
+}
 }  // namespace operations_research
 
 int main(int argc, char** argv) {
   FLAGS_log_prefix = false;
   gflags::ParseCommandLineFlags(&argc, &argv, /*remove_flags=*/ true);
+  if (FLAGS_benchmark_iterations > 0) {
+    const std::vector<std::string> filenames(argv + 1, argv + argc);
+    operations_research::BenchmarkParser(filenames,
+                                         FLAGS_benchmark_iterations);
+    return 0;
+  }
   operations_research::ParseFile(FLAGS_file, FLAGS_presolve);
   return 0;
 }
@@ -39,8 +39,6 @@ bool IsBooleanValue(int64 value) { return value == 0 || value == 1; }
 //   - table_int -> intersect variables domains with tuple set.
 //
 // TODO(user):
-//   - store dependency graph of constraints -> variable to speed up presolve.
-//   - use the same dependency graph to speed up variable substitution.
 //   - add more check when presolving out a variable or a constraint.
 
 // ----- Presolve rules -----
@@ -1606,6 +1604,7 @@ void FzPresolver::MergeIntEqNe(FzModel* model) {
           ct->arguments.clear();
           ct->arguments.push_back(FzArgument::IntVarRef(stored));
           ct->arguments.push_back(FzArgument::IntVarRef(boolvar));
+          AddConstraintToMapping(ct);
           FZVLOG << "  -> " << ct->DebugString() << FZENDL;
         }
       }
@@ -1632,6 +1631,7 @@ void FzPresolver::MergeIntEqNe(FzModel* model) {
           ct->arguments.clear();
           ct->arguments.push_back(FzArgument::IntVarRef(stored));
           ct->arguments.push_back(FzArgument::IntVarRef(boolvar));
+          AddConstraintToMapping(ct);
           FZVLOG << "  -> " << ct->DebugString() << FZENDL;
         }
       }
@@ -1658,6 +1658,13 @@ void FzPresolver::FirstPassModelScan(FzModel* model) {
 bool FzPresolver::Run(FzModel* model) {
   FirstPassModelScan(model);
 
+  // The mapping is already built if CleanUpModelForTheCpSolver() was called.
+  if (var_to_constraints_.empty()) {
+    for (FzConstraint* const ct : model->constraints()) {
+      AddConstraintToMapping(ct);
+    }
+  }
+
   MergeIntEqNe(model);
 
   bool changed_since_start = false;
@@ -1667,35 +1674,122 @@ bool FzPresolver::Run(FzModel* model) {
       changed_since_start |= PresolveBool2Int(ct);
     }
   }
-  if (!var_representative_map_.empty()) {
-    // Some new substitutions were introduced. Let's process them.
-    SubstituteEverywhere(model);
-    var_representative_map_.clear();
+
+  // Apply the rest of the presolve rules. All constraints are presolved once,
+  // then only the ones impacted by a change are presolved again.
+  for (FzConstraint* const ct : model->constraints()) {
+    if (ct->active) {
+      AddToWorklist(ct);
+    }
+  }
+  // Some substitutions may have been introduced by the bool2int predicates.
+  SubstituteInConstraints();
+  while (!worklist_.empty()) {
+    FzConstraint* const ct = worklist_.front();
+    worklist_.pop_front();
+    in_worklist_.erase(ct);
+    if (!ct->active) continue;
+    variable_states_.clear();
+    for (const FzArgument& arg : ct->arguments) {
+      for (FzIntegerVariable* const var : arg.variables) {
+        variable_states_.push_back(VariableState(var));
+      }
+    }
+    const int num_mappings =
+        abs_map_.size() + affine_map_.size() + flatten_map_.size();
+    if (PresolveOneConstraint(ct)) {
+      changed_since_start = true;
+      const int new_num_mappings =
+          abs_map_.size() + affine_map_.size() + flatten_map_.size();
+      UpdateAfterChange(ct, new_num_mappings != num_mappings);
+    }
+    // Process new substitutions before presolving another constraint.
+    SubstituteInConstraints();
   }
+  SubstituteInSearchAndOutput(model);
+  var_representative_map_.clear();
+  return changed_since_start;
+}
 
-  // Apply the rest of the presolve rules.
-  for (;;) {
-    bool changed = false;
-    var_representative_map_.clear();
-    for (FzConstraint* const ct : model->constraints()) {
+void FzPresolver::AddConstraintToMapping(FzConstraint* ct) {
+  for (const FzArgument& arg : ct->arguments) {
+    for (FzIntegerVariable* const var : arg.variables) {
+      var_to_constraints_[var].insert(ct);
+    }
+  }
+}
+
+void FzPresolver::AddToWorklist(FzConstraint* ct) {
+  if (in_worklist_.insert(ct).second) {
+    worklist_.push_back(ct);
+  }
+}
+
+void FzPresolver::AddConstraintsOfVariableToWorklist(
+    const FzIntegerVariable* var) {
+  const hash_set<FzConstraint*>* const constraints =
+      FindOrNull(var_to_constraints_, var);
+  if (constraints != nullptr) {
+    for (FzConstraint* const ct : *constraints) {
       if (ct->active) {
-        changed |= PresolveOneConstraint(ct);
-      }
-      if (!var_representative_map_.empty()) {
-        break;
+        AddToWorklist(ct);
       }
     }
-    if (!var_representative_map_.empty()) {
-      // Some new substitutions were introduced. Let's process them.
-      DCHECK(changed);
-      changed = true;  // To be safe in opt mode.
-      SubstituteEverywhere(model);
-      var_representative_map_.clear();
+  }
+}
+
+void FzPresolver::UpdateAfterChange(FzConstraint* ct, bool new_mappings) {
+  if (ct->active) {
+    AddToWorklist(ct);
+  }
+  for (const VariableState& state : variable_states_) {
+    if (new_mappings || state.HasChanged()) {
+      AddConstraintsOfVariableToWorklist(state.variable);
+    }
+  }
+  // Look for the variables added to ct. In most cases, the variables of ct
+  // are unchanged, and are in the same order as in variable_states_.
+  int index = 0;
+  std::vector<const FzIntegerVariable*> previous_variables;
+  for (const FzArgument& arg : ct->arguments) {
+    for (FzIntegerVariable* const var : arg.variables) {
+      if (index < variable_states_.size() &&
+          variable_states_[index].variable == var) {
+        ++index;
+        continue;
+      }
+      if (previous_variables.empty()) {
+        for (const VariableState& state : variable_states_) {
+          previous_variables.push_back(state.variable);
+        }
+        std::sort(previous_variables.begin(), previous_variables.end());
+      }
+      if (!std::binary_search(previous_variables.begin(),
+                              previous_variables.end(), var)) {
+        if (var_to_constraints_[var].insert(ct).second) {
+          AddConstraintsOfVariableToWorklist(var);
+        }
+      }
     }
-    changed_since_start |= changed;
-    if (!changed) break;
   }
-  return changed_since_start;
+}
+
+FzPresolver::VariableState::VariableState(FzIntegerVariable* var)
+    : variable(var),
+      is_interval(var->domain.is_interval),
+      size(var->domain.values.size()),
+      first(size == 0 ? 0 : var->domain.values.front()),
+      last(size == 0 ? 0 : var->domain.values.back()),
+      defining_constraint(var->defining_constraint),
+      active(var->active) {}
+
+bool FzPresolver::VariableState::HasChanged() const {
+  const FzDomain& domain = variable->domain;
+  return domain.is_interval != is_interval || domain.values.size() != size ||
+         (size != 0 &&
+          (domain.values.front() != first || domain.values.back() != last)) ||
+         variable->defining_constraint != defining_constraint ||
+         variable->active != active;
 }
 
 // ----- Substitution support -----
@@ -1726,6 +1820,7 @@ void FzPresolver::MarkVariablesAsEquivalent(FzIntegerVariable* from,
                     from->temporary));
     from->active = false;
     var_representative_map_[from] = to;
+    pending_substitutions_.push_back(from);
   }
 }
 
@@ -1749,12 +1844,16 @@ FzIntegerVariable* FzPresolver::FindRepresentativeOfVar(
   return FindWithDefault(var_representative_map_, var, var);
 }
 
-void FzPresolver::SubstituteEverywhere(FzModel* model) {
+void FzPresolver::SubstituteInConstraints() {
+  if (pending_substitutions_.empty()) return;
   // Collected impacted constraints.
   hash_set<FzConstraint*> impacted;
-  for (const auto& p : var_representative_map_) {
-    const hash_set<FzConstraint*>& contains = var_to_constraints_[p.first];
-    impacted.insert(contains.begin(), contains.end());
+  for (FzIntegerVariable* const var : pending_substitutions_) {
+    const hash_set<FzConstraint*>* const contains =
+        FindOrNull(var_to_constraints_, var);
+    if (contains != nullptr) {
+      impacted.insert(contains->begin(), contains->end());
+    }
   }
   // Rewrite the constraints.
   for (FzConstraint* const ct : impacted) {
@@ -1781,8 +1880,30 @@ void FzPresolver::SubstituteEverywhere(FzModel* model) {
       // No need to update var_to_constraints, it should have been done already
       // in the arguments of the constraints.
       ct->target_variable = FindRepresentativeOfVar(ct->target_variable);
+      AddToWorklist(ct);
+    }
+  }
+  // Do not forget to merge domain that could have evolved asynchronously
+  // during presolve. The constraints of the representative must then be
+  // presolved again.
+  for (FzIntegerVariable* const var : pending_substitutions_) {
+    FzIntegerVariable* const representative = FindRepresentativeOfVar(var);
+    representative->domain.IntersectWithFzDomain(var->domain);
+    const hash_set<FzConstraint*>* const contains =
+        FindOrNull(var_to_constraints_, representative);
+    if (contains != nullptr) {
+      for (FzConstraint* const ct : *contains) {
+        if (ct->active) {
+          AddToWorklist(ct);
+        }
+      }
     }
   }
+  pending_substitutions_.clear();
+}
+
+void FzPresolver::SubstituteInSearchAndOutput(FzModel* model) {
+  if (var_representative_map_.empty()) return;
   // Rewrite the search.
   for (FzAnnotation* const ann : model->mutable_search_annotations()) {
     SubstituteAnnotation(ann);
@@ -1795,11 +1916,6 @@ void FzPresolver::SubstituteEverywhere(FzModel* model) {
           FindRepresentativeOfVar(output->flat_variables[i]);
     }
   }
-  // Do not forget to merge domain that could have evolved asynchronously
-  // during presolve.
-  for (const auto& iter : var_representative_map_) {
-    iter.second->domain.IntersectWithFzDomain(iter.first->domain);
-  }
 }
 
 void FzPresolver::SubstituteAnnotation(FzAnnotation* ann) {
@@ -1954,13 +2070,10 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
   FzConstraint* start = nullptr;
   std::vector<FzIntegerVariable*> chain;
   std::vector<FzIntegerVariable*> carry_over;
+  std::vector<FzConstraint*> regrouped;
   var_to_constraints_.clear();
   for (FzConstraint* const ct : model->constraints()) {
-    for (const FzArgument& arg : ct->arguments) {
-      for (FzIntegerVariable* const var : arg.variables) {
-        var_to_constraints_[var].insert(ct);
-      }
-    }
+    AddConstraintToMapping(ct);
   }
   for (FzConstraint* const ct : model->constraints()) {
     if (start == nullptr) {
@@ -1975,6 +2088,7 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
       carry_over.back()->defining_constraint = nullptr;
     } else {
       Regroup(start, chain, carry_over);
+      regrouped.push_back(start);
       // Clean
       start = nullptr;
       chain.clear();
@@ -1986,6 +2100,11 @@ void FzPresolver::CleanUpModelForTheCpSolver(FzModel* model, bool use_sat) {
   // Checks left over from the loop.
   if (start != nullptr) {
     Regroup(start, chain, carry_over);
+    regrouped.push_back(start);
+  }
+  // Keep the mapping up to date for Run().
+  for (FzConstraint* const ct : regrouped) {
+    AddConstraintToMapping(ct);
   }
 }
 }  // namespace operations_research
@@ -13,7 +13,9 @@
 #ifndef OR_TOOLS_FLATZINC_PRESOLVE_H_
 #define OR_TOOLS_FLATZINC_PRESOLVE_H_
 
+#include <deque>
 #include <string>
+#include <vector>
 #include "base/hash.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
@@ -87,6 +89,22 @@ class FzPresolver {
           constraint(ct) {}
   };
 
+  // The part of the state of a variable that the presolve rules depend on. It
+  // is stored before presolving a constraint, to only presolve again the
+  // constraints of the variables that were modified.
+  struct VariableState {
+    FzIntegerVariable* variable;
+    bool is_interval;
+    int size;
+    int64 first;
+    int64 last;
+    FzConstraint* defining_constraint;
+    bool active;
+
+    explicit VariableState(FzIntegerVariable* var);
+    bool HasChanged() const;
+  };
+
   // First pass of model scanning. Useful to get information that will
   // prevent some destructive modifications of the model.
   void FirstPassModelScan(FzModel* model);
@@ -98,10 +116,24 @@ class FzPresolver {
   // Returns true iff the model was modified.
   bool PresolveOneConstraint(FzConstraint* ct);
 
-  // Substitution support.
-  void SubstituteEverywhere(FzModel* model);
+  // Substitution support. SubstituteInConstraints() rewrites the
+  // constraints that refer to the variables marked as equivalent since its
+  // last call, and adds them to the worklist. The search annotations and the
+  // output are only rewritten once, at the end of Run().
+  void SubstituteInConstraints();
+  void SubstituteInSearchAndOutput(FzModel* model);
   void SubstituteAnnotation(FzAnnotation* ann);
 
+  // Worklist support.
+  void AddConstraintToMapping(FzConstraint* ct);
+  void AddToWorklist(FzConstraint* ct);
+  void AddConstraintsOfVariableToWorklist(const FzIntegerVariable* var);
+  // Called after a presolve rule modified ct. It updates the mapping with the
+  // variables added to ct since variable_states_ was filled, and adds to the
+  // worklist ct and the constraints of the variables that were added or
+  // modified, or of all the variables of ct if 'new_mappings' is true.
+  void UpdateAfterChange(FzConstraint* ct, bool new_mappings);
+
   // Presolve rules. They returns true iff that some presolve has been
   // performed. These methods are called by the PresolveOneConstraint() method.
   bool PresolveBool2Int(FzConstraint* ct);
@@ -145,6 +177,8 @@ class FzPresolver {
   FzIntegerVariable* FindRepresentativeOfVar(FzIntegerVariable* var);
   hash_map<const FzIntegerVariable*, FzIntegerVariable*>
       var_representative_map_;
+  // Variables marked as equivalent and not yet substituted in the constraints.
+  std::vector<FzIntegerVariable*> pending_substitutions_;
 
   // Stores abs_map_[x] = y if x = abs(y).
   hash_map<const FzIntegerVariable*, FzIntegerVariable*> abs_map_;
@@ -162,9 +196,22 @@ class FzPresolver {
   // Stores all variables defined in the search annotations.
   hash_set<FzIntegerVariable*> decision_variables_;
 
-  // Stores all constraints containing a variable.
+  // Stores all constraints containing a variable. It is built by
+  // CleanUpModelForTheCpSolver(), or by Run() if it was not called, and it is
+  // updated when presolve rules or substitutions add variables to a
+  // constraint, but variables removed from a constraint are not removed from
+  // it.
   hash_map<const FzIntegerVariable*,
            hash_set<FzConstraint*>> var_to_constraints_;
+
+  // Constraints to presolve again, because they, or the domain or mappings of
+  // one of their variables, changed since they were last presolved. Run()
+  // presolves constraints in this order until the worklist is empty.
+  std::deque<FzConstraint*> worklist_;
+  hash_set<FzConstraint*> in_worklist_;
+  // State of the variables of the constraint being presolved, before the
+  // presolve rules are applied.
+  std::vector<VariableState> variable_states_;
 };
 }  // namespace operations_research
 
@@ -13,6 +13,7 @@
 #include "flatzinc/sat_constraint.h"
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 #include <iostream>  // NOLINT
@@ -27,7 +28,9 @@
 #include "constraint_solver/constraint_solver.h"
 #include "constraint_solver/constraint_solveri.h"
 
-#define NEW_SAT
+DEFINE_int32(lcg_max_domain_size, 64,
+             "Maximum domain size of the integer variables encoded in the sat "
+             "solver in lazy clause generation mode (--use_lcg).");
 
 #if defined(NEW_SAT)
 #include "sat/pb_constraint.h"
@@ -35,12 +38,43 @@
 #include "sat/sat_solver.h"
 
 namespace operations_research {
+// Order encoding of an integer variable with a small domain, used by the lazy
+// clause generation mode. An integer variable x with domain [min..max] is
+// represented in the sat solver by the literals [x >= v] for v in
+// ]min..max], tied by the clauses [x >= v + 1] => [x >= v], and by the
+// literals [x == v] for the values v of the domain. All these literals are
+// boolean variables of the CP solver, kept in sync by the CP propagation.
+struct IntegerEncoding {
+  int64 min;
+  // greater_or_equal[i] is the literal [x >= min + 1 + i].
+  std::vector<sat::Literal> greater_or_equal;
+  // equal[i] is the literal [x == min + i], valid only if in_domain[i].
+  std::vector<sat::Literal> equal;
+  std::vector<bool> in_domain;
+
+  int64 max() const { return min + greater_or_equal.size(); }
+
+  // Returns false if the value is not in the domain of the variable.
+  bool EqualLiteral(int64 value, sat::Literal* literal) const {
+    if (value < min || value > max() || !in_domain[value - min]) {
+      return false;
+    }
+    *literal = equal[value - min];
+    return true;
+  }
+};
+
 // Constraint that tight together boolean variables in the CP solver to sat
 // variables and clauses.
 class SatPropagator : public Constraint {
  public:
-  explicit SatPropagator(Solver* solver)
-      : Constraint(solver), sat_decision_level_(0) {}
+  SatPropagator(Solver* solver, bool learn_clauses)
+      : Constraint(solver),
+        learn_clauses_(learn_clauses),
+        sat_decision_level_(0),
+        num_cp_decisions_(0),
+        num_backjumps_(0),
+        sync_backjumps_(0) {}
 
   ~SatPropagator() {}
 
@@ -86,6 +120,11 @@ class SatPropagator : public Constraint {
     }
   }
 
+  // Returns the order encoding of the given integer variable, creating it on
+  // the first call. Returns nullptr if the variable is bound, or if its domain
+  // is too large to be encoded (see --lcg_max_domain_size).
+  const IntegerEncoding* Encoding(IntVar* var);
+
   void PullSatAssignmentFrom(int from_index) {
     const int to_index = sat_.LiteralTrail().Index();
     for (int index = from_index; index < to_index; ++index) {
@@ -101,9 +140,85 @@ class SatPropagator : public Constraint {
     }
   }
 
+  // Returns true if the literal is true in the current state of the CP solver.
+  bool IsTrueInCp(sat::Literal literal) const {
+    IntVar* const var = vars_[literal.Variable().value()];
+    return var->Bound() && (var->Value() != 0) == literal.IsPositive();
+  }
+
+  // When learning clauses, a conflict makes the sat solver backjump, possibly
+  // well above the current node of the CP search. The sat decisions then no
+  // longer match the reversible sat_decision_level_ of the CP nodes created
+  // before the conflict. This method rebuilds the sat state from the CP
+  // state: it keeps the sat decisions that are still true in the CP solver,
+  // replays the literals pushed on the current CP branch, and pulls back all
+  // the sat deductions, including the ones of the learned clauses.
+  void Resynchronize() {
+    const std::vector<sat::SatSolver::Decision>& decisions = sat_.Decisions();
+    int level = 0;
+    while (level < sat_.CurrentDecisionLevel() &&
+           IsTrueInCp(decisions[level].literal)) {
+      ++level;
+    }
+    sat_.Backtrack(level);
+    for (int i = 0; i < num_cp_decisions_.Value(); ++i) {
+      const sat::Literal literal = cp_decisions_[i];
+      if (sat_.Assignment().IsLiteralTrue(literal)) continue;
+      if (sat_.Assignment().IsLiteralFalse(literal)) {
+        solver()->Fail();
+      }
+      EnqueueDecisionAndLearn(literal);
+    }
+    PullSatAssignmentFrom(0);
+    sat_decision_level_.SetValue(solver(), sat_.CurrentDecisionLevel());
+    sync_backjumps_.SetValue(solver(), num_backjumps_);
+  }
+
+  // Enqueues a decision in the sat solver. On conflict, the sat solver learns
+  // a clause and backjumps, and the CP solver fails.
+  void EnqueueDecisionAndLearn(sat::Literal literal) {
+    const int level = sat_.CurrentDecisionLevel();
+    sat_.EnqueueDecisionAndBackjumpOnConflict(literal);
+    if (sat_.CurrentDecisionLevel() <= level) {
+      ++num_backjumps_;
+      solver()->Fail();
+    }
+  }
+
+  // Version of VariableIndexBound() used when learning clauses.
+  void LearningVariableIndexBound(int index) {
+    if (sat_.IsModelUnsat()) {
+      solver()->Fail();
+    }
+    if (sync_backjumps_.Value() != num_backjumps_) {
+      Resynchronize();
+    } else if (sat_decision_level_.Value() < sat_.CurrentDecisionLevel()) {
+      sat_.Backtrack(sat_decision_level_.Value());
+    }
+    IntVar* const var = vars_[index];
+    if (!var->Bound()) return;
+    const sat::Literal literal(sat::VariableIndex(index), var->Value() != 0);
+    if (sat_.Assignment().IsLiteralTrue(literal)) return;
+    if (sat_.Assignment().IsLiteralFalse(literal)) {
+      solver()->Fail();
+    }
+    const int trail_index = sat_.LiteralTrail().Index();
+    EnqueueDecisionAndLearn(literal);
+    const int num_cp_decisions = num_cp_decisions_.Value();
+    cp_decisions_.resize(num_cp_decisions);
+    cp_decisions_.push_back(literal);
+    num_cp_decisions_.SetValue(solver(), num_cp_decisions + 1);
+    sat_decision_level_.SetValue(solver(), sat_.CurrentDecisionLevel());
+    PullSatAssignmentFrom(trail_index);
+  }
+
   // This method is called during the processing of the CP solver queue when
   // a boolean variable is bound.
   void VariableIndexBound(int index) {
+    if (learn_clauses_) {
+      LearningVariableIndexBound(index);
+      return;
+    }
     if (sat_decision_level_.Value() < sat_.CurrentDecisionLevel()) {
 #ifdef SAT_DEBUG
       FZDLOG << "After failure, sat_decision_level = "
@@ -191,14 +306,91 @@ class SatPropagator : public Constraint {
 
  private:
   sat::SatSolver sat_;
+  const bool learn_clauses_;
   std::vector<IntVar*> vars_;
   hash_map<IntVar*, sat::VariableIndex> indices_;
   std::vector<sat::Literal> bound_literals_;
   NumericalRev<int> sat_decision_level_;
   std::vector<Demon*> demons_;
   std::vector<sat::Literal> early_deductions_;
+  // Order encodings of the integer variables, nullptr if not encodable.
+  hash_map<IntVar*, IntegerEncoding*> encodings_;
+  std::vector<std::unique_ptr<IntegerEncoding>> owned_encodings_;
+  // Literals pushed as decisions by the current branch of the CP search,
+  // only the first num_cp_decisions_ are valid. Used to rebuild the sat state
+  // after a backjump.
+  std::vector<sat::Literal> cp_decisions_;
+  NumericalRev<int> num_cp_decisions_;
+  // Number of backjumps of the sat solver, and its value when the current CP
+  // node was synchronized with the sat solver.
+  int num_backjumps_;
+  NumericalRev<int> sync_backjumps_;
 };
 
+const IntegerEncoding* SatPropagator::Encoding(IntVar* var) {
+  IntegerEncoding* const cached = FindWithDefault(encodings_, var, nullptr);
+  if (cached != nullptr || ContainsKey(encodings_, var)) {
+    return cached;
+  }
+  encodings_[var] = nullptr;
+  const int64 vmin = var->Min();
+  const int64 vmax = var->Max();
+  if (vmin == vmax || vmax - vmin >= FLAGS_lcg_max_domain_size) {
+    return nullptr;
+  }
+  // The boolean variables [var >= value] and [var == value], the latter only
+  // for the values strictly inside the domain, as the extreme ones are
+  // already given by the order literals.
+  std::vector<IntVar*> greater_or_equal_vars;
+  std::vector<IntVar*> equal_vars(vmax - vmin + 1, nullptr);
+  for (int64 value = vmin + 1; value <= vmax; ++value) {
+    IntVar* const boolvar = solver()->MakeIsGreaterOrEqualCstVar(var, value);
+    if (!IsExpressionBoolean(boolvar)) {
+      return nullptr;
+    }
+    greater_or_equal_vars.push_back(boolvar);
+    if (value < vmax && var->Contains(value)) {
+      IntVar* const equal_var = solver()->MakeIsEqualCstVar(var, value);
+      if (!IsExpressionBoolean(equal_var)) {
+        return nullptr;
+      }
+      equal_vars[value - vmin] = equal_var;
+    }
+  }
+  IntegerEncoding* const encoding = new IntegerEncoding;
+  owned_encodings_.emplace_back(encoding);
+  encoding->min = vmin;
+  for (IntVar* const boolvar : greater_or_equal_vars) {
+    encoding->greater_or_equal.push_back(Literal(boolvar));
+  }
+  const std::vector<sat::Literal>& ge = encoding->greater_or_equal;
+  const int size = ge.size();
+  // [var >= v + 1] => [var >= v].
+  for (int i = 0; i + 1 < size; ++i) {
+    sat_.AddBinaryClause(ge[i + 1].Negated(), ge[i]);
+  }
+  encoding->in_domain.assign(size + 1, true);
+  encoding->equal.resize(size + 1);
+  encoding->equal[0] = ge[0].Negated();
+  encoding->equal[size] = ge[size - 1];
+  for (int i = 1; i < size; ++i) {
+    if (equal_vars[i] == nullptr) {
+      // Hole: [var >= value] => [var >= value + 1].
+      encoding->in_domain[i] = false;
+      sat_.AddBinaryClause(ge[i - 1].Negated(), ge[i]);
+      continue;
+    }
+    // [var == value] <=> [var >= value] and not [var >= value + 1].
+    const sat::Literal equal = Literal(equal_vars[i]);
+    encoding->equal[i] = equal;
+    sat_.AddBinaryClause(equal.Negated(), ge[i - 1]);
+    sat_.AddBinaryClause(equal.Negated(), ge[i].Negated());
+    sat_.AddTernaryClause(equal, ge[i - 1].Negated(), ge[i]);
+  }
+  encodings_[var] = encoding;
+  return encoding;
+}
+
 void DeclareVariableIndex(SatPropagator* sat, IntVar* var) {
   CHECK(sat->IsExpressionBoolean(var));
   sat->Literal(var);
@@ -534,8 +726,114 @@ bool AddSumInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
   return true;
 }
 
-SatPropagator* MakeSatPropagator(Solver* solver) {
-  return solver->RevAlloc(new SatPropagator(solver));
+bool AddScalProdInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
+                        const std::vector<int64>& coefficients, int64 range_min,
+                        int64 range_max) {
+  // On larger domains, the pseudo-boolean propagation is weaker than the
+  // bound propagation of the CP solver, as it ignores that the order literals
+  // of a variable are implied by one another: it deduces x <= max - 1 where
+  // the CP solver deduces x <= max - k.
+  std::vector<const IntegerEncoding*> encodings(vars.size());
+  for (int i = 0; i < vars.size(); ++i) {
+    if (!vars[i]->Bound()) {
+      if (vars[i]->Max() - vars[i]->Min() != 1) {
+        return false;
+      }
+      encodings[i] = sat->Encoding(vars[i]);
+      if (encodings[i] == nullptr) {
+        return false;
+      }
+    }
+  }
+  // Each variable is replaced by min + its order literal.
+  std::vector<sat::LiteralWithCoeff> terms;
+  int64 offset = 0;
+  for (int i = 0; i < vars.size(); ++i) {
+    const int64 coefficient = coefficients[i];
+    if (vars[i]->Bound()) {
+      offset += coefficient * vars[i]->Min();
+      continue;
+    }
+    offset += coefficient * encodings[i]->min;
+    for (const sat::Literal literal : encodings[i]->greater_or_equal) {
+      terms.push_back(sat::LiteralWithCoeff(literal, coefficient));
+    }
+  }
+  const bool use_lower_bound = range_min != kint64min;
+  const bool use_upper_bound = range_max != kint64max;
+  sat->sat()->AddLinearConstraint(
+      use_lower_bound,
+      sat::Coefficient(use_lower_bound ? range_min - offset : 0),
+      use_upper_bound,
+      sat::Coefficient(use_upper_bound ? range_max - offset : 0), &terms);
+  return true;
+}
+
+bool AddArrayIntElement(SatPropagator* sat, IntVar* index,
+                        const std::vector<int64>& values, IntVar* target) {
+  const IntegerEncoding* const index_encoding = sat->Encoding(index);
+  const IntegerEncoding* const target_encoding = sat->Encoding(target);
+  if (index_encoding == nullptr || target_encoding == nullptr) {
+    return false;
+  }
+  // [index == i] => [target == values[i - 1]].
+  hash_map<int64, std::vector<sat::Literal>> supports;
+  for (int64 i = index_encoding->min; i <= index_encoding->max(); ++i) {
+    sat::Literal index_literal;
+    if (!index_encoding->EqualLiteral(i, &index_literal)) continue;
+    sat::Literal target_literal;
+    if (i < 1 || i > values.size() ||
+        !target_encoding->EqualLiteral(values[i - 1], &target_literal)) {
+      sat->sat()->AddUnitClause(index_literal.Negated());
+      continue;
+    }
+    sat->sat()->AddBinaryClause(index_literal.Negated(), target_literal);
+    supports[values[i - 1]].push_back(index_literal);
+  }
+  // [target == value] => OR([index == i] for values[i - 1] == value).
+  for (int64 value = target_encoding->min; value <= target_encoding->max();
+       ++value) {
+    sat::Literal target_literal;
+    if (!target_encoding->EqualLiteral(value, &target_literal)) continue;
+    std::vector<sat::Literal> clause = FindWithDefault(
+        supports, value, std::vector<sat::Literal>());
+    clause.push_back(target_literal.Negated());
+    sat->sat()->AddProblemClause(clause);
+  }
+  return true;
+}
+
+bool AddAllDifferent(SatPropagator* sat, const std::vector<IntVar*>& vars) {
+  std::vector<const IntegerEncoding*> encodings(vars.size());
+  int64 vmin = kint64max;
+  int64 vmax = kint64min;
+  for (int i = 0; i < vars.size(); ++i) {
+    encodings[i] = sat->Encoding(vars[i]);
+    if (encodings[i] == nullptr) {
+      return false;
+    }
+    vmin = std::min(vmin, encodings[i]->min);
+    vmax = std::max(vmax, encodings[i]->max());
+  }
+  // At most one variable takes each value.
+  for (int64 value = vmin; value <= vmax; ++value) {
+    std::vector<sat::LiteralWithCoeff> terms;
+    for (const IntegerEncoding* const encoding : encodings) {
+      sat::Literal literal;
+      if (encoding->EqualLiteral(value, &literal)) {
+        terms.push_back(sat::LiteralWithCoeff(literal, 1));
+      }
+    }
+    if (terms.size() > 1) {
+      sat->sat()->AddLinearConstraint(false, sat::Coefficient(0), true,
+                                      sat::Coefficient(1), &terms);
+    }
+  }
+  return true;
+}
+
+SatPropagator* MakeSatPropagator(Solver* solver, bool learn_clauses) {
+  return solver->RevAlloc(new SatPropagator(solver, learn_clauses));
 }
 
 int NumSatConstraints(SatPropagator* sat) {
@@ -1402,12 +1700,25 @@ bool AddSumInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
   return false;
 }
 
+bool AddScalProdInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
+                        const std::vector<int64>& coefficients, int64 range_min,
+                        int64 range_max) {
+  return false;
+}
+
+bool AddArrayIntElement(SatPropagator* sat, IntVar* index,
+                        const std::vector<int64>& values, IntVar* target) {
+  return false;
+}
+
+bool AddAllDifferent(SatPropagator* sat, const std::vector<IntVar*>& vars) {
+  return false;
+}
+
 SatPropagator* MakeSatPropagator(Solver* solver) {
   return solver->RevAlloc(new SatPropagator(solver));
 }
 
-int NumSatConstraints(SatPropagator* sat) {
-  return sat->sat()->NumClauses();
-}
+int NumSatConstraints(SatPropagator* sat) { return sat->NumClauses(); }
 }  // namespace operations_research
 #endif
@@ -15,10 +15,22 @@
 
 #include "constraint_solver/constraint_solver.h"
 
+// Selects the sat solver of src/sat. Without it, a simpler solver with no
+// conflict analysis is used, and the lazy clause generation mode is not
+// available.
+#define NEW_SAT
+
 namespace operations_research {
 class SatPropagator;
 
+#if defined(NEW_SAT)
+// If learn_clauses is true, a conflict in the sat solver is analyzed and a
+// clause is learned before the CP solver fails. This is the lazy clause
+// generation mode, see AddScalProdInRange() and below.
+SatPropagator* MakeSatPropagator(Solver* solver, bool learn_clauses);
+#else
 SatPropagator* MakeSatPropagator(Solver* solver);
+#endif  // NEW_SAT
 
 int NumSatConstraints(SatPropagator* sat);
 
@@ -81,6 +93,26 @@ bool AddIntNeReif(SatPropagator* sat, IntExpr* left, IntExpr* right,
 bool AddSumInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
                    int64 range_min, int64 range_max);
 
+// The following constraints are posted on the order encoding of the integer
+// variables, see --lcg_max_domain_size, so that the sat solver explains their
+// propagation and learns from their failures. They return false if a
+// variable cannot be encoded. The linear and element constraints are as
+// strong as their CP counterpart, the all different is only pairwise and
+// should be posted together with the CP one.
+
+// Only accepts variables with two values, for instance booleans with any
+// coefficients. range_min (resp. range_max) can be kint64min (resp.
+// kint64max) if unused.
+bool AddScalProdInRange(SatPropagator* sat, const std::vector<IntVar*>& vars,
+                        const std::vector<int64>& coefficients, int64 range_min,
+                        int64 range_max);
+
+// target == values[index - 1].
+bool AddArrayIntElement(SatPropagator* sat, IntVar* index,
+                        const std::vector<int64>& values, IntVar* target);
+
+bool AddAllDifferent(SatPropagator* sat, const std::vector<IntVar*>& vars);
+
 void DeclareVariable(SatPropagator* sat, IntVar* var);
 }       // namespace operations_research
 #endif  // OR_TOOLS_FLATZINC_SAT_CONSTRAINT_H_
@@ -443,8 +443,9 @@ void FzSolver::AddCompletionDecisionBuilders(
   }
 }
 
-DecisionBuilder* FzSolver::CreateDecisionBuilders(const FzSolverParameters& p,
-                                                  SearchLimit* limit) {
+DecisionBuilder* FzSolver::CreateDecisionBuilders(
+    const FzSolverParameters& p, SearchLimit* limit,
+    NoGoodManager* no_good_manager) {
   FZLOG << "Defining search" << std::endl;
   // Fill builders_ with predefined search.
   std::vector<DecisionBuilder*> defined;
@@ -519,6 +520,7 @@ DecisionBuilder* FzSolver::CreateDecisionBuilders(const FzSolverParameters& p,
                                       : DefaultPhaseParameters::NORMAL)
                   : DefaultPhaseParameters::NONE;
     parameters.use_no_goods = (p.restart_log_size > 0);
+    parameters.no_good_manager = no_good_manager;
     parameters.var_selection_schema =
         DefaultPhaseParameters::CHOOSE_MAX_SUM_IMPACT;
     parameters.value_selection_schema =
@@ -580,8 +582,25 @@ void FzSolver::Solve(FzSolverParameters p,
                              : nullptr;
   SearchLimit* const shadow = limit == nullptr ? nullptr :
       solver()->MakeCustomLimit(NewPermanentCallback(limit, &SearchLimit::Check));
-  DecisionBuilder* const db = CreateDecisionBuilders(p, shadow);
+  // Nogoods and root domain reductions are only valid for the other workers
+  // if the solutions in the part of the search tree they cut are no longer
+  // needed, i.e. in optimization, or when searching for one solution.
+  NoGoodManager* no_good_manager = nullptr;
+  if (model_.objective() != nullptr ||
+      (!p.all_solutions && p.num_solutions == 1)) {
+    std::vector<IntVar*> variables;
+    for (FzIntegerVariable* const fz_var : model_.variables()) {
+      IntExpr* const expr = FindPtrOrNull(extrated_map_, fz_var);
+      variables.push_back(expr != nullptr && expr->IsVar() ? expr->Var()
+                                                           : nullptr);
+    }
+    no_good_manager =
+        parallel_support->NoGoods(solver(), variables, p.worker_id);
+  }
+  DecisionBuilder* const db =
+      CreateDecisionBuilders(p, shadow, no_good_manager);
   std::vector<SearchMonitor*> monitors;
+  monitors.push_back(no_good_manager);
   if (model_.objective() != nullptr) {
     objective_monitor_ = parallel_support->Objective(
         solver(), model_.maximize(), objective_var_, 1, p.worker_id);
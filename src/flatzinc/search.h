@@ -50,7 +50,8 @@ struct FzSolverParameters {
 
 // This class is used to abstract the interface to parallelism from
 // the search code. It offers two sets of API:
-//    - Create specific search objects (Objective(), Limit(), Log()).
+//    - Create specific search objects (Objective(), Limit(), Log(),
+//      NoGoods()).
 //    - Report solution (SatSolution(), OptimizeSolution(), FinalOutput(),
 //                       EndSearch(), BestSolution(), Interrupted()).
 class FzParallelSupportInterface {
@@ -93,6 +94,14 @@ class FzParallelSupportInterface {
                                  int64 step, int worker_id) = 0;
   // Creates a dedicated search limit.
   virtual SearchLimit* Limit(Solver* s, int worker_id) = 0;
+  // Creates a nogood manager that shares the short nogoods and the root
+  // domain reductions of the worker with the other workers, or returns
+  // nullptr if nothing is shared. 'variables' contains the variable of the
+  // worker for each variable of the model, in the order of the model, or
+  // nullptr when a variable of the model is not extracted as an IntVar.
+  virtual NoGoodManager* NoGoods(Solver* s,
+                                 const std::vector<IntVar*>& variables,
+                                 int worker_id) = 0;
   // Creates a dedicated search log.
   virtual void Log(int worker_id, const std::string& message) = 0;
   // Returns if the search was interrupted, usually by a time or
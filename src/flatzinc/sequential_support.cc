@@ -88,6 +88,12 @@ class SequentialSupportInterface : public FzParallelSupportInterface {
 
   virtual SearchLimit* Limit(Solver* s, int worker_id) { return nullptr; }
 
+  virtual NoGoodManager* NoGoods(Solver* s,
+                                 const std::vector<IntVar*>& variables,
+                                 int worker_id) {
+    return nullptr;
+  }
+
   virtual void Log(int worker_id, const std::string& message) {
     std::cout << "%%  worker " << worker_id << ": " << message << std::endl;
   }
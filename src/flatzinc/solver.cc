@@ -15,6 +15,7 @@
 #include "base/logging.h"
 #include "base/hash.h"
 #include "base/map_util.h"
+#include "base/stl_util.h"
 #include "flatzinc/model.h"
 #include "flatzinc/sat_constraint.h"
 #include "flatzinc/solver.h"
@@ -25,6 +26,10 @@ DECLARE_bool(fz_logging);
 DECLARE_bool(fz_verbose);
 DECLARE_bool(fz_debug);
 DEFINE_bool(use_sat, true, "Use a sat solver for propagating on booleans.");
+DEFINE_bool(use_lcg, false,
+            "Lazy clause generation: with --use_sat, also encode the small "
+            "integer variables and the linear, element and all different "
+            "constraints in the sat solver, and learn clauses from failures.");
 
 namespace operations_research {
 IntExpr* FzSolver::GetExpression(const FzArgument& arg) {
@@ -197,26 +202,15 @@ struct ConstraintWithIoComparator {
 };
 }  // namespace
 
-bool FzSolver::Extract() {
-  // Create the sat solver.
-  if (FLAGS_use_sat) {
-    FZLOG << "  - Use sat" << FZENDL;
-    sat_ = MakeSatPropagator(&solver_);
-    solver_.AddConstraint(reinterpret_cast<Constraint*>(sat_));
-  } else {
-    sat_ = nullptr;
-  }
-  // Build statistics.
-  statistics_.BuildStatistics();
-  // Extract variables.
-  FZLOG << "Extract variables" << FZENDL;
-  int extracted_variables = 0;
-  int skipped_variables = 0;
+// ----- Shared data -----
+
+FzSolverSharedData::FzSolverSharedData(FzModel* model_to_prepare) {
+  const FzModel& model = *model_to_prepare;
+  // Collect the variables to create before the constraints.
   hash_set<FzIntegerVariable*> defined_variables;
-  for (FzIntegerVariable* const var : model_.variables()) {
+  for (FzIntegerVariable* const var : model.variables()) {
     if (var->defining_constraint == nullptr && var->active) {
-      Extract(var);
-      extracted_variables++;
+      variables_to_create_.push_back(var);
     } else {
       FZVLOG << "Skip " << var->DebugString() << FZENDL;
       if (var->defining_constraint != nullptr) {
@@ -224,26 +218,37 @@ bool FzSolver::Extract() {
                << FZENDL;
       }
       defined_variables.insert(var);
-      skipped_variables++;
     }
   }
-  FZLOG << "  - " << extracted_variables << " variables created" << FZENDL;
-  FZLOG << "  - " << skipped_variables << " variables skipped" << FZENDL;
   // Parse model to store info.
-  FZLOG << "Extract constraints" << FZENDL;
-  for (FzConstraint* const ct : model_.constraints()) {
+  for (FzConstraint* const ct : model.constraints()) {
     if (ct->type == "all_different_int") {
       StoreAllDifferent(ct->Arg(0).variables);
     }
   }
+  // Breaks the cycles of defined variables in the model.
+  SortConstraints(model, defined_variables);
+  // Precompute tuple sets.
+  for (FzConstraint* const ct : sorted_constraints_) {
+    if (ct->type == "table_bool" || ct->type == "table_int" ||
+        ct->type == "regular") {
+      BuildTupleSet(ct);
+    }
+  }
+}
+
+FzSolverSharedData::~FzSolverSharedData() { STLDeleteValues(&tuple_sets_); }
+
+void FzSolverSharedData::SortConstraints(
+    const FzModel& model,
+    const hash_set<FzIntegerVariable*>& defined_variables) {
   // Sort constraints such that defined variables are created before the
   // extraction of the constraints that use them.
   int index = 0;
   std::vector<ConstraintWithIo*> to_sort;
-  std::vector<FzConstraint*> sorted;
   hash_map<const FzIntegerVariable*, std::vector<ConstraintWithIo*>>
       dependencies;
-  for (FzConstraint* ct : model_.constraints()) {
+  for (FzConstraint* ct : model.constraints()) {
     if (ct != nullptr && ct->active) {
       ConstraintWithIo* const ctio =
           new ConstraintWithIo(ct, index++, defined_variables);
@@ -289,7 +294,7 @@ bool FzSolver::Extract() {
     FZDLOG << "Pop " << ctio->ct->DebugString() << FZENDL;
     CHECK(ctio->required.empty());
     // TODO(user): Implement recovery mode.
-    sorted.push_back(ctio->ct);
+    sorted_constraints_.push_back(ctio->ct);
     FzIntegerVariable* const var = ctio->ct->target_variable;
     if (var != nullptr && ContainsKey(dependencies, var)) {
       FZDLOG << "  - clean " << var->DebugString() << FZENDL;
@@ -299,10 +304,119 @@ bool FzSolver::Extract() {
     }
     delete ctio;
   }
-  for (FzConstraint* const ct : sorted) {
+}
+
+void FzSolverSharedData::BuildTupleSet(FzConstraint* ct) {
+  IntTupleSet* tuples = nullptr;
+  if (ct->type == "table_bool" || ct->type == "table_int") {
+    const FzArgument& arg = ct->Arg(0);
+    const int size = arg.type == FzArgument::INT_LIST ? arg.values.size()
+                                                      : arg.variables.size();
+    tuples = new IntTupleSet(size);
+    const std::vector<int64>& t = ct->Arg(1).values;
+    const int t_size = t.size();
+    DCHECK_EQ(0, t_size % size);
+    const int num_tuples = t_size / size;
+    std::vector<int64> one_tuple(size);
+    for (int tuple_index = 0; tuple_index < num_tuples; ++tuple_index) {
+      for (int var_index = 0; var_index < size; ++var_index) {
+        one_tuple[var_index] = t[tuple_index * size + var_index];
+      }
+      tuples->Insert(one_tuple);
+    }
+  } else {
+    CHECK_EQ("regular", ct->type);
+    const int64 num_states = ct->Arg(1).Value();
+    const int64 num_values = ct->Arg(2).Value();
+    const std::vector<int64>& array_transitions = ct->Arg(3).values;
+    tuples = new IntTupleSet(3);
+    int count = 0;
+    for (int q = 1; q <= num_states; ++q) {
+      for (int s = 1; s <= num_values; ++s) {
+        const int64 next = array_transitions[count++];
+        if (next != 0) {
+          tuples->Insert3(q, s, next);
+        }
+      }
+    }
+  }
+  tuple_sets_[ct] = tuples;
+}
+
+void FzSolverSharedData::StoreAllDifferent(
+    const std::vector<FzIntegerVariable*>& diffs) {
+  if (!diffs.empty()) {
+    std::vector<FzIntegerVariable*> local(diffs);
+    std::sort(local.begin(), local.end());
+    FZVLOG << "Store AllDifferent info for [" << JoinDebugStringPtr(diffs, ", ")
+           << "]" << FZENDL;
+    alldiffs_[local.front()].push_back(local);
+  }
+}
+
+namespace {
+template <class T>
+bool EqualVector(const std::vector<T>& v1, const std::vector<T>& v2) {
+  if (v1.size() != v2.size()) return false;
+  for (int i = 0; i < v1.size(); ++i) {
+    if (v1[i] != v2[i]) return false;
+  }
+  return true;
+}
+}  // namespace
+
+bool FzSolverSharedData::IsAllDifferent(
+    const std::vector<FzIntegerVariable*>& diffs) const {
+  std::vector<FzIntegerVariable*> local(diffs);
+  std::sort(local.begin(), local.end());
+  const FzIntegerVariable* const start = local.front();
+  if (!ContainsKey(alldiffs_, start)) return false;
+  const std::vector<std::vector<FzIntegerVariable*>>& stored =
+      FindOrDie(alldiffs_, start);
+  for (const std::vector<FzIntegerVariable*>& one_diff : stored) {
+    if (EqualVector(local, one_diff)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// ----- Extraction -----
+
+bool FzSolver::Extract() {
+  CHECK(shared_data_ != nullptr);
+  // Create the sat solver.
+  if (FLAGS_use_sat) {
+    FZLOG << "  - Use sat" << FZENDL;
+#if defined(NEW_SAT)
+    sat_ = MakeSatPropagator(&solver_, FLAGS_use_lcg);
+#else
+    LOG_IF(WARNING, FLAGS_use_lcg)
+        << "--use_lcg needs the sat solver of src/sat, it is ignored.";
+    sat_ = MakeSatPropagator(&solver_);
+#endif  // NEW_SAT
+    solver_.AddConstraint(reinterpret_cast<Constraint*>(sat_));
+  } else {
+    sat_ = nullptr;
+  }
+  // Build statistics.
+  statistics_.BuildStatistics();
+  // Extract variables.
+  FZLOG << "Extract variables" << FZENDL;
+  for (FzIntegerVariable* const var : shared_data_->variables_to_create()) {
+    Extract(var);
+  }
+  const int extracted_variables = shared_data_->variables_to_create().size();
+  const int skipped_variables =
+      model_.variables().size() - extracted_variables;
+  FZLOG << "  - " << extracted_variables << " variables created" << FZENDL;
+  FZLOG << "  - " << skipped_variables << " variables skipped" << FZENDL;
+  FZLOG << "Extract constraints" << FZENDL;
+  for (FzConstraint* const ct : shared_data_->sorted_constraints()) {
     ExtractConstraint(ct);
   }
-  FZLOG << "  - " << sorted.size() << " constraints parsed" << FZENDL;
+  FZLOG << "  - " << shared_data_->sorted_constraints().size()
+        << " constraints parsed" << FZENDL;
   const int num_cp_constraints = solver_.constraints();
   if (num_cp_constraints <= 1) {
     FZLOG << "  - " << num_cp_constraints
@@ -322,22 +436,23 @@ bool FzSolver::Extract() {
   for (FzIntegerVariable* const var : model_.variables()) {
     if (var->defining_constraint != nullptr && var->active) {
       const FzDomain& domain = var->domain;
-      if (!domain.is_interval && domain.values.size() == 2 &&
-          domain.values[0] == 0 && domain.values[1] == 1) {
-        // Canonicalize domains: {0, 1} -> [0 ,, 1]
-        var->domain.is_interval = true;
-      }
+      // Canonicalize domains: {0, 1} -> [0 ,, 1]. The model is shared by all
+      // the solvers, so this is done locally instead of in the domain.
+      const bool is_interval =
+          domain.is_interval ||
+          (domain.values.size() == 2 && domain.values[0] == 0 &&
+           domain.values[1] == 1);
       IntExpr* const expr = Extract(var);
-      if (expr->IsVar() && domain.is_interval && !domain.values.empty() &&
+      if (expr->IsVar() && is_interval && !domain.values.empty() &&
           (expr->Min() < domain.values[0] || expr->Max() > domain.values[1])) {
         FZVLOG << "Intersect variable domain of " << expr->DebugString()
                << " with" << domain.DebugString() << FZENDL;
         expr->Var()->SetRange(domain.values[0], domain.values[1]);
-      } else if (expr->IsVar() && !domain.is_interval) {
+      } else if (expr->IsVar() && !is_interval) {
         FZVLOG << "Intersect variable domain of " << expr->DebugString()
                << " with " << domain.DebugString() << FZENDL;
         expr->Var()->SetValues(domain.values);
-      } else if (domain.is_interval && !domain.values.empty() &&
+      } else if (is_interval && !domain.values.empty() &&
                  (expr->Min() < domain.values[0] ||
                   expr->Max() > domain.values[1])) {
         FZVLOG << "Add domain constraint " << domain.DebugString() << " onto "
@@ -345,7 +460,7 @@ bool FzSolver::Extract() {
         solver_.AddConstraint(solver_.MakeBetweenCt(
             expr->Var(), domain.values[0], domain.values[1]));
         domain_constraints++;
-      } else if (!domain.is_interval) {
+      } else if (!is_interval) {
         FZVLOG << "Add domain constraint " << domain.DebugString() << " onto "
                << expr->DebugString() << FZENDL;
         solver_.AddConstraint(solver_.MakeMemberCt(expr->Var(), domain.values));
@@ -358,43 +473,4 @@ bool FzSolver::Extract() {
 
   return true;
 }
-
-// ----- Alldiff info support -----
-
-void FzSolver::StoreAllDifferent(const std::vector<FzIntegerVariable*>& diffs) {
-  if (!diffs.empty()) {
-    std::vector<FzIntegerVariable*> local(diffs);
-    std::sort(local.begin(), local.end());
-    FZVLOG << "Store AllDifferent info for [" << JoinDebugStringPtr(diffs, ", ")
-           << "]" << FZENDL;
-    alldiffs_[local.front()].push_back(local);
-  }
-}
-
-namespace {
-template <class T>
-bool EqualVector(const std::vector<T>& v1, const std::vector<T>& v2) {
-  if (v1.size() != v2.size()) return false;
-  for (int i = 0; i < v1.size(); ++i) {
-    if (v1[i] != v2[i]) return false;
-  }
-  return true;
-}
-}  // namespace
-
-bool FzSolver::IsAllDifferent(
-    const std::vector<FzIntegerVariable*>& diffs) const {
-  std::vector<FzIntegerVariable*> local(diffs);
-  std::sort(local.begin(), local.end());
-  const FzIntegerVariable* const start = local.front();
-  if (!ContainsKey(alldiffs_, start)) return false;
-  const std::vector<std::vector<FzIntegerVariable*>>& stored =
-      FindOrDie(alldiffs_, start);
-  for (const std::vector<FzIntegerVariable*>& one_diff : stored) {
-    if (EqualVector(local, one_diff)) {
-      return true;
-    }
-  }
-  return false;
-}
 }  // namespace operations_research
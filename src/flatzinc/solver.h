@@ -13,22 +13,84 @@
 #ifndef OR_TOOLS_FLATZINC_SOLVER_H_
 #define OR_TOOLS_FLATZINC_SOLVER_H_
 
+#include <vector>
+
+#include "base/hash.h"
+#include "base/macros.h"
+#include "base/map_util.h"
 #include "constraint_solver/constraint_solver.h"
 #include "flatzinc/model.h"
 #include "flatzinc/search.h"
+#include "util/tuple_set.h"
 
 namespace operations_research {
 class SatPropagator;
 
+// Data computed once from a model, and then shared read-only by all the
+// FzSolver that extract this model, e.g. the workers of a parallel run:
+//  - the variables to create before the constraints, and the order in which
+//    the constraints are extracted,
+//  - the all-different information,
+//  - the tuple sets of the table and regular constraints. The tuple sets are
+//    only copied lazily by the CP constraints, so their payload is stored
+//    once for all the workers.
+// Building this object also breaks the cycles of defined variables, which
+// modifies the model. The FzSolver that use it then never modify the model,
+// and can extract it concurrently.
+class FzSolverSharedData {
+ public:
+  explicit FzSolverSharedData(FzModel* model);
+  ~FzSolverSharedData();
+
+  // Variables that are not defined by a constraint, in the order of the
+  // model.
+  const std::vector<FzIntegerVariable*>& variables_to_create() const {
+    return variables_to_create_;
+  }
+
+  // Active constraints, sorted such that the defined variables are created
+  // before the extraction of the constraints that use them.
+  const std::vector<FzConstraint*>& sorted_constraints() const {
+    return sorted_constraints_;
+  }
+
+  // Returns true if the variables are the ones of an all_different_int
+  // constraint of the model.
+  bool IsAllDifferent(const std::vector<FzIntegerVariable*>& diffs) const;
+
+  // Returns the allowed tuples of a table_bool or table_int constraint, or
+  // the transitions of a regular constraint.
+  const IntTupleSet& TupleSet(const FzConstraint* ct) const {
+    return *FindOrDie(tuple_sets_, ct);
+  }
+
+ private:
+  void SortConstraints(const FzModel& model,
+                       const hash_set<FzIntegerVariable*>& defined_variables);
+  void StoreAllDifferent(const std::vector<FzIntegerVariable*>& diffs);
+  void BuildTupleSet(FzConstraint* ct);
+
+  std::vector<FzIntegerVariable*> variables_to_create_;
+  std::vector<FzConstraint*> sorted_constraints_;
+  hash_map<const FzIntegerVariable*,
+           std::vector<std::vector<FzIntegerVariable*> > > alldiffs_;
+  hash_map<const FzConstraint*, IntTupleSet*> tuple_sets_;
+
+  DISALLOW_COPY_AND_ASSIGN(FzSolverSharedData);
+};
+
 // The main class to search for a solution in a flatzinc model.  It is
 // responsible for parsing the search annotations, setting up the
 // search state and perform the actual search.
 class FzSolver {
  public:
-  explicit FzSolver(const FzModel& model)
+  // The shared data must have been built from the same model, and must
+  // outlive this object.
+  FzSolver(const FzModel& model, const FzSolverSharedData* shared_data)
       : model_(model),
         statistics_(model),
         solver_(model.name()),
+        shared_data_(shared_data),
         sat_(nullptr) {}
 
   // Search for for solutions in the model passed at construction
@@ -46,7 +108,12 @@ class FzSolver {
   std::vector<IntVar*> GetVariableArray(const FzArgument& argument);
   IntExpr* Extract(FzIntegerVariable* var);
   void SetExtracted(FzIntegerVariable* var, IntExpr* expr);
-  bool IsAllDifferent(const std::vector<FzIntegerVariable*>& diffs) const;
+  bool IsAllDifferent(const std::vector<FzIntegerVariable*>& diffs) const {
+    return shared_data_->IsAllDifferent(diffs);
+  }
+  const IntTupleSet& TupleSet(const FzConstraint* ct) const {
+    return shared_data_->TupleSet(ct);
+  }
 
   // Output support.
   std::string SolutionString(const FzOnSolutionOutput& output);
@@ -73,7 +140,8 @@ class FzSolver {
       const std::vector<IntVar*>& active_variables, SearchLimit* limit,
       std::vector<DecisionBuilder*>* builders);
   DecisionBuilder* CreateDecisionBuilders(const FzSolverParameters& p,
-                                          SearchLimit* limit);
+                                          SearchLimit* limit,
+                                          NoGoodManager* no_good_manager);
   void CollectOutputVariables(std::vector<IntVar*>* output_variables);
   void SyncWithModel();
 
@@ -87,10 +155,8 @@ class FzSolver {
   std::string search_name_;
   IntVar* objective_var_;
   OptimizeVar* objective_monitor_;
-  // Alldiff info before extraction
-  void StoreAllDifferent(const std::vector<FzIntegerVariable*>& diffs);
-  hash_map<const FzIntegerVariable*,
-           std::vector<std::vector<FzIntegerVariable*> > > alldiffs_;
+  // Data precomputed from the model.
+  const FzSolverSharedData* const shared_data_;
   // Sat constraint.
   SatPropagator* sat_;
 };
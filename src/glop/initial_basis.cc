@@ -21,7 +21,8 @@
 namespace operations_research {
 namespace glop {
 
-InitialBasis::InitialBasis(const MatrixView& matrix, const DenseRow& objective,
+InitialBasis::InitialBasis(const CompactSparseMatrix& matrix,
+                           const DenseRow& objective,
                            const DenseRow& lower_bound,
                            const DenseRow& upper_bound,
                            const VariableTypeRow& variable_type)
@@ -63,7 +64,8 @@ void InitialBasis::CompleteBixbyBasis(ColIndex num_cols,
   for (int i = 0; i < candidates.size(); ++i) {
     bool enter_basis = false;
     const ColIndex candidate_col_index = candidates[i];
-    const SparseColumn& candidate_col = matrix_.column(candidate_col_index);
+    const CompactSparseMatrix::ColumnView candidate_col =
+        matrix_.column(candidate_col_index);
 
     // Bixby's heuristic only works with scaled columns. This should be the
     // case by default since we only use this when the matrix is scaled, but
@@ -125,7 +127,8 @@ bool InitialBasis::CompleteTriangularBasis(ColIndex num_cols,
   residual_pattern.Reset(num_rows, num_cols);
   for (ColIndex col(0); col < num_cols; ++col) {
     if (only_allow_zero_cost_column && objective_[col] != 0.0) continue;
-    for (const SparseColumn::Entry e : matrix_.column(col)) {
+    for (const CompactSparseMatrix::ColumnView::Entry e :
+         matrix_.column(col)) {
       if (can_be_replaced[e.row()]) {
         residual_pattern.AddEntry(e.row(), col);
       }
@@ -170,7 +173,8 @@ bool InitialBasis::CompleteTriangularBasis(ColIndex num_cols,
     RowIndex row(kInvalidRow);
     Fractional coeff = 0.0;
     Fractional max_magnitude = 0.0;
-    for (const SparseColumn::Entry e : matrix_.column(candidate)) {
+    for (const CompactSparseMatrix::ColumnView::Entry e :
+         matrix_.column(candidate)) {
       max_magnitude = std::max(max_magnitude, fabs(e.coefficient()));
       if (can_be_replaced[e.row()]) {
         row = e.row();
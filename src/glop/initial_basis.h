@@ -44,7 +44,7 @@ namespace glop {
 class InitialBasis {
  public:
   // Takes references to the linear program data we need.
-  InitialBasis(const MatrixView& matrix, const DenseRow& objective,
+  InitialBasis(const CompactSparseMatrix& matrix, const DenseRow& objective,
                const DenseRow& lower_bound, const DenseRow& upper_bound,
                const VariableTypeRow& variable_type);
 
@@ -107,7 +107,7 @@ class InitialBasis {
     const InitialBasis& initial_basis_;
   } triangular_column_comparator_;
 
-  const MatrixView& matrix_;
+  const CompactSparseMatrix& matrix_;
   const DenseRow& objective_;
   const DenseRow& lower_bound_;
   const DenseRow& upper_bound_;
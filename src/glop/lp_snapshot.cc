@@ -0,0 +1,576 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "glop/lp_snapshot.h"
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstring>
+#include <limits>
+#include "base/unique_ptr.h"
+
+#include "base/file.h"
+#include "base/logging.h"
+
+namespace operations_research {
+namespace glop {
+
+namespace {
+
+const char kSnapshotMagic[8] = {'G', 'L', 'O', 'P', 'S', 'N', 'A', 'P'};
+
+// Written as is in the header, it allows to detect a snapshot written on a
+// machine with a different byte order.
+const uint32 kByteOrderMark = 0x01020304;
+
+// Bits of SnapshotHeader::flags.
+const uint32 kMaximizationFlag = 1 << 0;
+const uint32 kHasBasisFlag = 1 << 1;
+const uint32 kHasNamesFlag = 1 << 2;
+const uint32 kColumnsAreCleanFlag = 1 << 3;
+
+// All the sections start on a multiple of this.
+const int64 kSectionAlignment = 8;
+
+// The fixed-size part of a snapshot file. Its size is a multiple of
+// kSectionAlignment so the first section is aligned.
+struct SnapshotHeader {
+  char magic[8];
+  uint32 version;
+  uint32 byte_order_mark;
+  int64 num_rows;
+  int64 num_cols;
+  int64 num_entries;
+  int64 num_name_chars;
+  uint32 flags;
+  uint32 unused;
+  double objective_offset;
+};
+static_assert(sizeof(SnapshotHeader) % kSectionAlignment == 0,
+              "The snapshot header size must be a multiple of the alignment.");
+
+// The sections of a snapshot file, in order.
+enum SnapshotSection {
+  COLUMN_STARTS = 0,
+  ENTRY_ROWS,
+  ENTRY_COEFFICIENTS,
+  OBJECTIVE_COEFFICIENTS,
+  VARIABLE_LOWER_BOUNDS,
+  VARIABLE_UPPER_BOUNDS,
+  CONSTRAINT_LOWER_BOUNDS,
+  CONSTRAINT_UPPER_BOUNDS,
+  VARIABLE_INTEGRALITY,
+  BASIS_STATUSES,
+  NAME_OFFSETS,
+  NAME_CHARS,
+  NUM_SECTIONS
+};
+
+int64 RoundUpToAlignment(int64 size) {
+  return (size + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+// Fills offsets with the byte offset of each section, plus a last one which is
+// the expected file size. Empty sections (for instance the basis if there is
+// none) have the same offset as the next section.
+void ComputeSectionOffsets(const SnapshotHeader& header,
+                           std::vector<int64>* offsets) {
+  const bool has_basis = header.flags & kHasBasisFlag;
+  const bool has_names = header.flags & kHasNamesFlag;
+  int64 sizes[NUM_SECTIONS];
+  sizes[COLUMN_STARTS] = (header.num_cols + 1) * sizeof(int64);
+  sizes[ENTRY_ROWS] = header.num_entries * sizeof(int32);
+  sizes[ENTRY_COEFFICIENTS] = header.num_entries * sizeof(double);
+  sizes[OBJECTIVE_COEFFICIENTS] = header.num_cols * sizeof(double);
+  sizes[VARIABLE_LOWER_BOUNDS] = header.num_cols * sizeof(double);
+  sizes[VARIABLE_UPPER_BOUNDS] = header.num_cols * sizeof(double);
+  sizes[CONSTRAINT_LOWER_BOUNDS] = header.num_rows * sizeof(double);
+  sizes[CONSTRAINT_UPPER_BOUNDS] = header.num_rows * sizeof(double);
+  sizes[VARIABLE_INTEGRALITY] = header.num_cols * sizeof(uint8);
+  sizes[BASIS_STATUSES] =
+      has_basis ? (header.num_cols + header.num_rows) * sizeof(int8) : 0;
+  sizes[NAME_OFFSETS] =
+      has_names ? (header.num_cols + header.num_rows + 1) * sizeof(int64) : 0;
+  sizes[NAME_CHARS] = has_names ? header.num_name_chars : 0;
+
+  offsets->resize(NUM_SECTIONS + 1);
+  int64 offset = sizeof(SnapshotHeader);
+  for (int i = 0; i < NUM_SECTIONS; ++i) {
+    (*offsets)[i] = offset;
+    offset += RoundUpToAlignment(sizes[i]);
+  }
+  (*offsets)[NUM_SECTIONS] = offset;
+}
+
+// Helper class to write the successive sections of a snapshot file while
+// keeping track of the alignment.
+class SnapshotWriter {
+ public:
+  explicit SnapshotWriter(File* file) : file_(file), position_(0), ok_(true) {}
+
+  void Write(const void* data, int64 size) {
+    if (!ok_ || size == 0) return;
+    ok_ = file_->Write(data, size) == static_cast<size_t>(size);
+    position_ += size;
+  }
+
+  template <typename T>
+  void WriteArray(const T* data, int64 num_elements) {
+    Write(data, num_elements * sizeof(T));
+  }
+
+  // Pads the file with zeros up to the given offset which must be the start of
+  // the next section.
+  void PadTo(int64 offset) {
+    DCHECK_LE(position_, offset);
+    DCHECK_LT(offset - position_, kSectionAlignment);
+    const char kZeros[kSectionAlignment] = {0};
+    Write(kZeros, offset - position_);
+  }
+
+  bool ok() const { return ok_; }
+
+ private:
+  File* file_;
+  int64 position_;
+  bool ok_;
+};
+
+}  // namespace
+
+bool WriteLinearProgramSnapshot(const LinearProgram& linear_program,
+                                const BasisState* basis, bool with_names,
+                                const std::string& file_name) {
+  if (!linear_program.IsCleanedUp()) {
+    LOG(DFATAL) << "The columns of the linear program must be cleaned up "
+                << "before writing a snapshot.";
+    return false;
+  }
+  const RowIndex num_rows = linear_program.num_constraints();
+  const ColIndex num_cols = linear_program.num_variables();
+  const bool has_basis = basis != nullptr && !basis->IsEmpty() &&
+                         basis->num_rows == num_rows &&
+                         basis->num_cols == num_cols;
+  if (basis != nullptr && !basis->IsEmpty() && !has_basis) {
+    LOG(WARNING) << "The basis dimension doesn't match the linear program, "
+                 << "it will not be saved in " << file_name;
+  }
+
+  // Compute the names section first since we need its size in the header.
+  std::vector<int64> name_offsets;
+  std::string name_chars;
+  if (with_names) {
+    name_offsets.reserve(num_cols.value() + num_rows.value() + 1);
+    for (ColIndex col(0); col < num_cols; ++col) {
+      name_offsets.push_back(name_chars.size());
+      name_chars += linear_program.GetVariableName(col);
+    }
+    for (RowIndex row(0); row < num_rows; ++row) {
+      name_offsets.push_back(name_chars.size());
+      name_chars += linear_program.GetConstraintName(row);
+    }
+    name_offsets.push_back(name_chars.size());
+  }
+
+  SnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic));
+  header.version = kLinearProgramSnapshotVersion;
+  header.byte_order_mark = kByteOrderMark;
+  header.num_rows = num_rows.value();
+  header.num_cols = num_cols.value();
+  header.num_entries = linear_program.num_entries().value();
+  header.num_name_chars = name_chars.size();
+  header.flags = kColumnsAreCleanFlag;
+  if (linear_program.IsMaximizationProblem()) header.flags |= kMaximizationFlag;
+  if (has_basis) header.flags |= kHasBasisFlag;
+  if (with_names) header.flags |= kHasNamesFlag;
+  header.objective_offset = linear_program.objective_offset();
+  std::vector<int64> offsets;
+  ComputeSectionOffsets(header, &offsets);
+
+  std::unique_ptr<File> file(File::Open(file_name, "wb"));
+  if (file == nullptr) {
+    LOG(ERROR) << "Could not open " << file_name << " for writing.";
+    return false;
+  }
+  SnapshotWriter writer(file.get());
+  writer.Write(&header, sizeof(header));
+
+  // The matrix, in compressed-column form. We write it column by column to
+  // avoid an extra copy of the whole matrix in memory.
+  const SparseMatrix& matrix = linear_program.GetSparseMatrix();
+  int64 start = 0;
+  writer.Write(&start, sizeof(start));
+  for (ColIndex col(0); col < num_cols; ++col) {
+    start += matrix.column(col).num_entries().value();
+    writer.Write(&start, sizeof(start));
+  }
+  writer.PadTo(offsets[ENTRY_ROWS]);
+  std::vector<int32> rows;
+  for (ColIndex col(0); col < num_cols; ++col) {
+    rows.clear();
+    for (const SparseColumn::Entry e : matrix.column(col)) {
+      rows.push_back(e.row().value());
+    }
+    writer.WriteArray(rows.data(), rows.size());
+  }
+  writer.PadTo(offsets[ENTRY_COEFFICIENTS]);
+  std::vector<Fractional> coefficients;
+  for (ColIndex col(0); col < num_cols; ++col) {
+    coefficients.clear();
+    for (const SparseColumn::Entry e : matrix.column(col)) {
+      coefficients.push_back(e.coefficient());
+    }
+    writer.WriteArray(coefficients.data(), coefficients.size());
+  }
+  writer.PadTo(offsets[OBJECTIVE_COEFFICIENTS]);
+
+  // The dense vectors. Note that these sections are all naturally aligned.
+  writer.WriteArray(linear_program.objective_coefficients().data(),
+                    num_cols.value());
+  writer.WriteArray(linear_program.variable_lower_bounds().data(),
+                    num_cols.value());
+  writer.WriteArray(linear_program.variable_upper_bounds().data(),
+                    num_cols.value());
+  writer.WriteArray(linear_program.constraint_lower_bounds().data(),
+                    num_rows.value());
+  writer.WriteArray(linear_program.constraint_upper_bounds().data(),
+                    num_rows.value());
+  std::vector<uint8> is_integer(num_cols.value());
+  for (ColIndex col(0); col < num_cols; ++col) {
+    is_integer[col.value()] = linear_program.is_variable_integer()[col];
+  }
+  writer.WriteArray(is_integer.data(), is_integer.size());
+  writer.PadTo(offsets[BASIS_STATUSES]);
+
+  if (has_basis) {
+    writer.WriteArray(basis->statuses.data(),
+                      basis->statuses.size().value());
+    writer.PadTo(offsets[NAME_OFFSETS]);
+  }
+  if (with_names) {
+    writer.WriteArray(name_offsets.data(), name_offsets.size());
+    writer.Write(name_chars.data(), name_chars.size());
+    writer.PadTo(offsets[NUM_SECTIONS]);
+  }
+
+  if (!writer.ok() || !file->Close()) {
+    LOG(ERROR) << "Error while writing " << file_name;
+    return false;
+  }
+  return true;
+}
+
+LinearProgramSnapshot::LinearProgramSnapshot()
+    : data_(nullptr), size_(0), buffer_(), is_mapped_(false) {}
+
+LinearProgramSnapshot::~LinearProgramSnapshot() { Close(); }
+
+bool LinearProgramSnapshot::Open(const std::string& file_name) {
+  Close();
+#if !defined(_MSC_VER)
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Could not open " << file_name;
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    void* const address =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address != MAP_FAILED) {
+      data_ = static_cast<const char*>(address);
+      size_ = file_stat.st_size;
+      is_mapped_ = true;
+    }
+  }
+  // The mapping stays valid after the file descriptor is closed.
+  close(fd);
+#else
+  std::unique_ptr<File> file(File::Open(file_name, "rb"));
+  if (file != nullptr) {
+    const int64 size = file->Size();
+    if (size > 0 && file->ReadToString(&buffer_, size) == size) {
+      data_ = buffer_.data();
+      size_ = size;
+    }
+    file->Close();
+  }
+#endif
+  if (data_ == nullptr) {
+    LOG(ERROR) << "Could not read " << file_name;
+    return false;
+  }
+  if (!ComputeAndCheckSectionOffsets()) {
+    LOG(ERROR) << file_name << " is not a valid snapshot (version "
+               << kLinearProgramSnapshotVersion << ") or is corrupted.";
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void LinearProgramSnapshot::Close() {
+#if !defined(_MSC_VER)
+  if (is_mapped_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  is_mapped_ = false;
+  buffer_.clear();
+  section_offsets_.clear();
+}
+
+bool LinearProgramSnapshot::ComputeAndCheckSectionOffsets() {
+  if (size_ < static_cast<int64>(sizeof(SnapshotHeader))) return false;
+  const SnapshotHeader& header = *Section<SnapshotHeader>(0);
+  if (memcmp(header.magic, kSnapshotMagic, sizeof(kSnapshotMagic)) != 0 ||
+      header.byte_order_mark != kByteOrderMark ||
+      header.version != kLinearProgramSnapshotVersion) {
+    return false;
+  }
+  // Each row, column, entry or name character takes at least one byte of the
+  // file, so this bounds the section sizes and avoids any overflow when
+  // computing them. The row and column indices must also fit in an int32.
+  if (header.num_rows < 0 || header.num_cols < 0 || header.num_entries < 0 ||
+      header.num_name_chars < 0 || header.num_rows > size_ ||
+      header.num_cols > size_ || header.num_entries > size_ ||
+      header.num_name_chars > size_ ||
+      header.num_rows > std::numeric_limits<int32>::max() ||
+      header.num_cols > std::numeric_limits<int32>::max()) {
+    return false;
+  }
+  ComputeSectionOffsets(header, &section_offsets_);
+  if (section_offsets_[NUM_SECTIONS] != size_) return false;
+
+  // Check the content of the sections that are used as indices, so that no
+  // accessor ever reads outside of the file, even on a corrupted snapshot.
+  const int64* const starts = column_starts();
+  if (starts[0] != 0 || starts[header.num_cols] != header.num_entries) {
+    return false;
+  }
+  for (int64 col = 0; col < header.num_cols; ++col) {
+    if (starts[col] > starts[col + 1]) return false;
+  }
+  const int32* const rows = entry_rows();
+  for (int64 i = 0; i < header.num_entries; ++i) {
+    if (rows[i] < 0 || rows[i] >= header.num_rows) return false;
+  }
+  if (header.flags & kHasBasisFlag) {
+    const int8* const statuses =
+        Section<int8>(section_offsets_[BASIS_STATUSES]);
+    for (int64 i = 0; i < header.num_cols + header.num_rows; ++i) {
+      if (statuses[i] < static_cast<int8>(VariableStatus::BASIC) ||
+          statuses[i] > static_cast<int8>(VariableStatus::FREE)) {
+        return false;
+      }
+    }
+  }
+  if (header.flags & kHasNamesFlag) {
+    const int64* const offsets = Section<int64>(section_offsets_[NAME_OFFSETS]);
+    const int64 num_names = header.num_cols + header.num_rows;
+    if (offsets[0] != 0 || offsets[num_names] != header.num_name_chars) {
+      return false;
+    }
+    for (int64 i = 0; i < num_names; ++i) {
+      if (offsets[i] > offsets[i + 1]) return false;
+    }
+  }
+  return true;
+}
+
+RowIndex LinearProgramSnapshot::num_rows() const {
+  DCHECK(IsOpen());
+  return RowIndex(Section<SnapshotHeader>(0)->num_rows);
+}
+
+ColIndex LinearProgramSnapshot::num_cols() const {
+  DCHECK(IsOpen());
+  return ColIndex(Section<SnapshotHeader>(0)->num_cols);
+}
+
+EntryIndex LinearProgramSnapshot::num_entries() const {
+  DCHECK(IsOpen());
+  return EntryIndex(Section<SnapshotHeader>(0)->num_entries);
+}
+
+bool LinearProgramSnapshot::IsMaximizationProblem() const {
+  DCHECK(IsOpen());
+  return Section<SnapshotHeader>(0)->flags & kMaximizationFlag;
+}
+
+Fractional LinearProgramSnapshot::objective_offset() const {
+  DCHECK(IsOpen());
+  return Section<SnapshotHeader>(0)->objective_offset;
+}
+
+bool LinearProgramSnapshot::HasBasis() const {
+  DCHECK(IsOpen());
+  return Section<SnapshotHeader>(0)->flags & kHasBasisFlag;
+}
+
+bool LinearProgramSnapshot::HasNames() const {
+  DCHECK(IsOpen());
+  return Section<SnapshotHeader>(0)->flags & kHasNamesFlag;
+}
+
+const int64* LinearProgramSnapshot::column_starts() const {
+  return Section<int64>(section_offsets_[COLUMN_STARTS]);
+}
+
+const int32* LinearProgramSnapshot::entry_rows() const {
+  return Section<int32>(section_offsets_[ENTRY_ROWS]);
+}
+
+const Fractional* LinearProgramSnapshot::entry_coefficients() const {
+  return Section<Fractional>(section_offsets_[ENTRY_COEFFICIENTS]);
+}
+
+const Fractional* LinearProgramSnapshot::objective_coefficients() const {
+  return Section<Fractional>(section_offsets_[OBJECTIVE_COEFFICIENTS]);
+}
+
+const Fractional* LinearProgramSnapshot::variable_lower_bounds() const {
+  return Section<Fractional>(section_offsets_[VARIABLE_LOWER_BOUNDS]);
+}
+
+const Fractional* LinearProgramSnapshot::variable_upper_bounds() const {
+  return Section<Fractional>(section_offsets_[VARIABLE_UPPER_BOUNDS]);
+}
+
+const Fractional* LinearProgramSnapshot::constraint_lower_bounds() const {
+  return Section<Fractional>(section_offsets_[CONSTRAINT_LOWER_BOUNDS]);
+}
+
+const Fractional* LinearProgramSnapshot::constraint_upper_bounds() const {
+  return Section<Fractional>(section_offsets_[CONSTRAINT_UPPER_BOUNDS]);
+}
+
+const uint8* LinearProgramSnapshot::is_variable_integer() const {
+  return Section<uint8>(section_offsets_[VARIABLE_INTEGRALITY]);
+}
+
+std::string LinearProgramSnapshot::GetName(int64 index) const {
+  // The offsets were checked to be non-decreasing and within the names section
+  // by Open().
+  const int64* const offsets = Section<int64>(section_offsets_[NAME_OFFSETS]);
+  const char* const chars = Section<char>(section_offsets_[NAME_CHARS]);
+  return std::string(chars + offsets[index],
+                     offsets[index + 1] - offsets[index]);
+}
+
+std::string LinearProgramSnapshot::GetVariableName(ColIndex col) const {
+  DCHECK_LT(col, num_cols());
+  return HasNames() ? GetName(col.value()) : std::string();
+}
+
+std::string LinearProgramSnapshot::GetConstraintName(RowIndex row) const {
+  DCHECK_LT(row, num_rows());
+  return HasNames() ? GetName(num_cols().value() + row.value()) : std::string();
+}
+
+void LinearProgramSnapshot::PopulateLinearProgram(
+    LinearProgram* linear_program) const {
+  RETURN_IF_NULL(linear_program);
+  DCHECK(IsOpen());
+  linear_program->Clear();
+  const RowIndex num_rows = this->num_rows();
+  const ColIndex num_cols = this->num_cols();
+  const bool has_names = HasNames();
+
+  // Constraints.
+  const Fractional* const row_lower_bounds = constraint_lower_bounds();
+  const Fractional* const row_upper_bounds = constraint_upper_bounds();
+  for (RowIndex row(0); row < num_rows; ++row) {
+    linear_program->CreateNewConstraint();
+    linear_program->SetConstraintBounds(row, row_lower_bounds[row.value()],
+                                        row_upper_bounds[row.value()]);
+    if (has_names) linear_program->SetConstraintName(row, GetConstraintName(row));
+  }
+
+  // Variables and matrix columns. We also check that the columns are clean on
+  // the fly, so we never have to call CleanUp() on a valid snapshot.
+  const Fractional* const objective = objective_coefficients();
+  const Fractional* const col_lower_bounds = variable_lower_bounds();
+  const Fractional* const col_upper_bounds = variable_upper_bounds();
+  const uint8* const is_integer = is_variable_integer();
+  const int64* const starts = column_starts();
+  const int32* const rows = entry_rows();
+  const Fractional* const coefficients = entry_coefficients();
+  bool columns_are_clean =
+      Section<SnapshotHeader>(0)->flags & kColumnsAreCleanFlag;
+  StrictITIVector<ColIndex, EntryIndex> num_entries(num_cols, EntryIndex(0));
+  for (ColIndex col(0); col < num_cols; ++col) {
+    linear_program->CreateNewVariable();
+    linear_program->SetVariableBounds(col, col_lower_bounds[col.value()],
+                                      col_upper_bounds[col.value()]);
+    linear_program->SetObjectiveCoefficient(col, objective[col.value()]);
+    if (is_integer[col.value()]) {
+      linear_program->SetVariableIntegrality(col, true);
+    }
+    if (has_names) linear_program->SetVariableName(col, GetVariableName(col));
+    num_entries[col] = EntryIndex(starts[col.value() + 1] - starts[col.value()]);
+  }
+
+  // All the columns share a single allocation of the right size.
+  linear_program->ClearAndReserveColumnEntries(num_entries);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    SparseColumn* const column = linear_program->GetMutableSparseColumn(col);
+    int32 previous_row = -1;
+    for (int64 i = starts[col.value()]; i < starts[col.value() + 1]; ++i) {
+      // The row indices were checked by Open().
+      const int32 row = rows[i];
+      DCHECK(row >= 0 && row < num_rows.value());
+      if (row <= previous_row || coefficients[i] == 0.0) {
+        columns_are_clean = false;
+      }
+      previous_row = row;
+      column->SetCoefficient(RowIndex(row), coefficients[i]);
+    }
+  }
+  linear_program->SetObjectiveOffset(objective_offset());
+  linear_program->SetMaximizationProblem(IsMaximizationProblem());
+  if (columns_are_clean) {
+    linear_program->NotifyThatColumnsAreClean();
+  } else {
+    linear_program->CleanUp();
+  }
+}
+
+bool LinearProgramSnapshot::GetBasisState(BasisState* state) const {
+  RETURN_VALUE_IF_NULL(state, false);
+  DCHECK(IsOpen());
+  if (!HasBasis()) return false;
+  state->num_rows = num_rows();
+  state->num_cols = num_cols();
+  const int num_statuses = num_cols().value() + num_rows().value();
+  const int8* const statuses = Section<int8>(section_offsets_[BASIS_STATUSES]);
+  state->statuses.clear();
+  // The statuses were checked to be valid by Open().
+  for (int i = 0; i < num_statuses; ++i) {
+    state->statuses.push_back(static_cast<VariableStatus>(statuses[i]));
+  }
+  return true;
+}
+
+}  // namespace glop
+}  // namespace operations_research
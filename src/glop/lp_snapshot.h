@@ -0,0 +1,159 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A compact and versioned binary format to save a LinearProgram together with
+// a warm-start BasisState, and to load it back without any parsing.
+//
+// A snapshot file is made of a fixed-size header followed by a sequence of
+// sections, each starting on an 8-byte boundary:
+//   - the column starts of the matrix (int64, num_cols + 1 values),
+//   - the row index of each entry (int32, num_entries values),
+//   - the coefficient of each entry (double, num_entries values),
+//   - the objective coefficients, variable lower bounds and variable upper
+//     bounds (double, num_cols values each),
+//   - the constraint lower bounds and upper bounds (double, num_rows values
+//     each),
+//   - the variable integrality (uint8, num_cols values),
+//   - optionally, the BasisState statuses (int8, num_cols + num_rows values),
+//   - optionally, the variable and constraint names, stored as num_cols +
+//     num_rows + 1 int64 offsets into a block of characters.
+//
+// The matrix is thus stored in compressed-column form and all the data is
+// stored in the native byte order of the machine that wrote the file (this is
+// checked on loading). This makes it possible to memory-map a snapshot and to
+// access all its data in place, see LinearProgramSnapshot below.
+
+#ifndef OR_TOOLS_GLOP_LP_SNAPSHOT_H_
+#define OR_TOOLS_GLOP_LP_SNAPSHOT_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "glop/revised_simplex.h"
+#include "lp_data/lp_data.h"
+#include "lp_data/lp_types.h"
+
+namespace operations_research {
+namespace glop {
+
+// Version of the snapshot format written by WriteLinearProgramSnapshot(). It
+// must be increased each time the layout described above changes. Snapshots
+// with a different version are rejected by LinearProgramSnapshot::Open().
+const uint32 kLinearProgramSnapshotVersion = 1;
+
+// Writes the given linear program to a snapshot file. If basis is not null and
+// has the same dimension as the linear program, it is saved too. The variable
+// and constraint names are only saved if with_names is true.
+//
+// The columns of the linear program must be cleaned up (see
+// LinearProgram::CleanUp()). Returns false if the file couldn't be written.
+bool WriteLinearProgramSnapshot(const LinearProgram& linear_program,
+                                const BasisState* basis, bool with_names,
+                                const std::string& file_name);
+
+// Read-only view of a snapshot file.
+//
+// On POSIX systems the file is memory-mapped, so opening even a large snapshot
+// is only bounded by the time needed to check its header, and the pages are
+// only read when their data is actually accessed. On other platforms the file
+// is read in one block.
+class LinearProgramSnapshot {
+ public:
+  LinearProgramSnapshot();
+  ~LinearProgramSnapshot();
+
+  // Opens the given snapshot file and checks its header, its section sizes,
+  // and the row indices, basis statuses and name offsets it contains. Returns
+  // false, and leaves the object closed, if the file cannot be read or if it
+  // is not a valid snapshot with the current format version.
+  bool Open(const std::string& file_name);
+
+  // Releases the underlying file. This invalidates all the pointers returned
+  // by the accessors below.
+  void Close();
+
+  bool IsOpen() const { return data_ != nullptr; }
+
+  // Dimension and global information of the stored linear program.
+  RowIndex num_rows() const;
+  ColIndex num_cols() const;
+  EntryIndex num_entries() const;
+  bool IsMaximizationProblem() const;
+  Fractional objective_offset() const;
+
+  // Returns true if the snapshot contains a warm-start basis (resp. names).
+  bool HasBasis() const;
+  bool HasNames() const;
+
+  // Direct access to the stored data, see the format description at the top
+  // of this file. These pointers are only valid while the snapshot is open.
+  const int64* column_starts() const;
+  const int32* entry_rows() const;
+  const Fractional* entry_coefficients() const;
+  const Fractional* objective_coefficients() const;
+  const Fractional* variable_lower_bounds() const;
+  const Fractional* variable_upper_bounds() const;
+  const Fractional* constraint_lower_bounds() const;
+  const Fractional* constraint_upper_bounds() const;
+  const uint8* is_variable_integer() const;
+
+  // Returns the stored name of a variable or constraint, or an empty std::string
+  // if the snapshot does not contain the names.
+  std::string GetVariableName(ColIndex col) const;
+  std::string GetConstraintName(RowIndex row) const;
+
+  // Clears the given linear program and fills it with the stored one. The
+  // matrix columns are copied in bulk (with a single allocation per column)
+  // and the linear program is directly marked as cleaned up if the stored
+  // columns are.
+  void PopulateLinearProgram(LinearProgram* linear_program) const;
+
+  // Fills the given state with the stored warm-start basis. Returns false if
+  // the snapshot does not contain any.
+  bool GetBasisState(BasisState* state) const;
+
+ private:
+  // Returns a pointer to the section starting at the given byte offset.
+  template <typename T>
+  const T* Section(int64 offset) const {
+    return reinterpret_cast<const T*>(data_ + offset);
+  }
+
+  // Returns the name stored at the given index of the names section.
+  std::string GetName(int64 index) const;
+
+  // Computes section_offsets_ from the header and checks that they are
+  // consistent with the file size. Also checks that all the stored indices
+  // are valid, so the accessors never read outside of the file.
+  bool ComputeAndCheckSectionOffsets();
+
+  // The beginning of the file and its size.
+  const char* data_;
+  int64 size_;
+
+  // If the file is not memory-mapped, its content is stored here.
+  std::string buffer_;
+  bool is_mapped_;
+
+  // Byte offset of each section in the file, see the .cc.
+  std::vector<int64> section_offsets_;
+
+  DISALLOW_COPY_AND_ASSIGN(LinearProgramSnapshot);
+};
+
+}  // namespace glop
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GLOP_LP_SNAPSHOT_H_
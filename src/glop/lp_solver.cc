@@ -14,6 +14,7 @@
 
 #include "glop/lp_solver.h"
 
+#include <atomic>
 #include <cmath>
 #include <stack>
 #include <vector>
@@ -24,9 +25,11 @@
 
 #include "base/join.h"
 #include "base/strutil.h"
+#include "base/threadpool.h"
 #include "glop/preprocessor.h"
 #include "glop/proto_utils.h"
 #include "glop/status.h"
+#include "lp_data/lp_decomposer.h"
 #include "lp_data/lp_types.h"
 #include "lp_data/lp_utils.h"
 #include "util/fp_utils.h"
@@ -86,13 +89,174 @@ void DumpLinearProgramIfRequiredByFlags(const LinearProgram& linear_program,
 }
 #endif
 
+// The status of a constraint is the status of its associated slack variable
+// with a change of sign. See RevisedSimplex::GetConstraintStatus().
+VariableStatus ConstraintToSlackStatus(ConstraintStatus status) {
+  switch (status) {
+    case ConstraintStatus::BASIC:
+      return VariableStatus::BASIC;
+    case ConstraintStatus::FIXED_VALUE:
+      return VariableStatus::FIXED_VALUE;
+    case ConstraintStatus::AT_LOWER_BOUND:
+      return VariableStatus::AT_UPPER_BOUND;
+    case ConstraintStatus::AT_UPPER_BOUND:
+      return VariableStatus::AT_LOWER_BOUND;
+    case ConstraintStatus::FREE:
+      return VariableStatus::FREE;
+  }
+  LOG(DFATAL) << "Invalid ConstraintStatus " << static_cast<int>(status);
+  return VariableStatus::FREE;
+}
+
+// Copies the solution found by the given RevisedSimplex into solution.
+void GetRevisedSimplexSolution(const RevisedSimplex& revised_simplex,
+                               ProblemSolution* solution) {
+  solution->status = revised_simplex.GetProblemStatus();
+
+  const ColIndex num_cols = revised_simplex.GetProblemNumCols();
+  DCHECK_EQ(solution->primal_values.size(), num_cols);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    solution->primal_values[col] = revised_simplex.GetVariableValue(col);
+    solution->variable_statuses[col] = revised_simplex.GetVariableStatus(col);
+  }
+
+  const RowIndex num_rows = revised_simplex.GetProblemNumRows();
+  DCHECK_EQ(solution->dual_values.size(), num_rows);
+  for (RowIndex row(0); row < num_rows; ++row) {
+    solution->dual_values[row] = revised_simplex.GetDualValue(row);
+    solution->constraint_statuses[row] =
+        revised_simplex.GetConstraintStatus(row);
+  }
+}
+
+// The result of the solve of one independent block of a linear program.
+struct BlockSolveResult {
+  BlockSolveResult()
+      : solution(RowIndex(0), ColIndex(0)),
+        num_iterations(0),
+        deterministic_time(0.0) {}
+  ProblemSolution solution;
+  int num_iterations;
+  double deterministic_time;
+};
+
+// Returns the size of a linear program used to share the deterministic time
+// limit between its blocks. The sizes of the blocks add up to the size of the
+// whole problem when it has no empty constraints.
+double GetSizeForDeterministicTimeShare(const LinearProgram& lp) {
+  return static_cast<double>(lp.num_entries().value()) +
+         lp.num_constraints().value() + lp.num_variables().value();
+}
+
+// Extracts the given block from the decomposer and solves it. This is
+// thread-safe as long as each call uses a different result. The block gets the
+// part of the deterministic time limit proportional to its share of
+// total_size, so that the limit holds for the sum of the blocks whatever the
+// number of threads.
+void SolveBlock(const GlopParameters* parameters, const TimeLimit* time_limit,
+                double total_size, LPDecomposer* decomposer, int block,
+                BlockSolveResult* result) {
+  LinearProgram block_lp;
+  decomposer->ExtractLocalProblem(block, &block_lp);
+  block_lp.CleanUp();
+  result->solution = ProblemSolution(block_lp.num_constraints(),
+                                     block_lp.num_variables());
+
+  GlopParameters block_parameters(*parameters);
+  block_parameters.set_max_time_in_seconds(time_limit->GetTimeLeft());
+  block_parameters.set_max_deterministic_time(
+      parameters->max_deterministic_time() *
+      GetSizeForDeterministicTimeShare(block_lp) / total_size);
+  RevisedSimplex revised_simplex;
+  revised_simplex.SetParameters(block_parameters);
+  if (revised_simplex.Solve(block_lp).ok()) {
+    GetRevisedSimplexSolution(revised_simplex, &result->solution);
+  } else {
+    VLOG(1) << "Error during the revised simplex algorithm on block " << block;
+    result->solution.status = ProblemStatus::ABNORMAL;
+  }
+  result->num_iterations = revised_simplex.GetNumberOfIterations();
+  result->deterministic_time = revised_simplex.DeterministicTime();
+}
+
+// Returns the status of a linear program made of independent blocks with the
+// given statuses. The whole problem is infeasible as soon as one block is, and
+// it is optimal only if all the blocks are.
+ProblemStatus GetStatusOfIndependentBlocks(
+    const std::vector<BlockSolveResult>& results) {
+  ProblemStatus status = ProblemStatus::OPTIMAL;
+  for (const BlockSolveResult& result : results) {
+    const ProblemStatus block_status = result.solution.status;
+    if (block_status == ProblemStatus::PRIMAL_INFEASIBLE ||
+        block_status == ProblemStatus::DUAL_UNBOUNDED) {
+      return block_status;
+    }
+    if (block_status == ProblemStatus::OPTIMAL || block_status == status) {
+      continue;
+    }
+    // Two blocks with different non-optimal statuses, e.g. one primal
+    // feasible and one unbounded, do not allow to conclude.
+    status = status == ProblemStatus::OPTIMAL ? block_status
+                                               : ProblemStatus::INIT;
+  }
+  return status;
+}
+
+// One of the simplex algorithms run by LPSolver::RunConcurrentSimplex().
+struct ConcurrentSimplexRun {
+  ConcurrentSimplexRun()
+      : revised_simplex(new RevisedSimplex()),
+        solve_ok(false),
+        is_first(false) {}
+  std::unique_ptr<RevisedSimplex> revised_simplex;
+  bool solve_ok;
+
+  // Whether this run was the first one to reach a conclusive status.
+  bool is_first;
+};
+
+// Returns true if the given status is a final answer for the problem, as
+// opposed to the statuses returned when the solve is interrupted.
+bool IsConclusiveStatus(ProblemStatus status) {
+  switch (status) {
+    case ProblemStatus::OPTIMAL:
+    case ProblemStatus::PRIMAL_INFEASIBLE:
+    case ProblemStatus::DUAL_INFEASIBLE:
+    case ProblemStatus::INFEASIBLE_OR_UNBOUNDED:
+    case ProblemStatus::PRIMAL_UNBOUNDED:
+    case ProblemStatus::DUAL_UNBOUNDED:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Solves the given linear program with the RevisedSimplex of the given run. If
+// this is the first run to reach a conclusive status, sets *interrupt to true
+// so that the other runs stop (their RevisedSimplex must have been given
+// interrupt with RegisterExternalBooleanAsLimit()).
+void SolveConcurrentSimplexRun(const LinearProgram* lp,
+                               std::atomic<bool>* interrupt,
+                               ConcurrentSimplexRun* run) {
+  run->solve_ok = run->revised_simplex->Solve(*lp).ok();
+  if (!run->solve_ok ||
+      !IsConclusiveStatus(run->revised_simplex->GetProblemStatus())) {
+    return;
+  }
+  // Only the run that flips the Boolean from false to true is the first one.
+  bool expected = false;
+  if (interrupt->compare_exchange_strong(expected, true)) {
+    run->is_first = true;
+  }
+}
+
 }  // anonymous namespace
 
 // --------------------------------------------------------
 // LPSolver
 // --------------------------------------------------------
 
-LPSolver::LPSolver() : num_solves_(0) {}
+LPSolver::LPSolver() : blocks_deterministic_time_(0.0), num_solves_(0) {}
 
 void LPSolver::SetParameters(const GlopParameters& parameters) {
   parameters_ = parameters;
@@ -143,6 +307,15 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
   initial_num_cols_ = lp.num_variables();
   current_linear_program_.PopulateFromLinearProgram(lp, /*keep_names=*/false);
 
+  // A warm-start basis refers to the given lp, so it can only be used if the
+  // preprocessors do not change the problem. See RunPreprocessors().
+  if (!initial_basis_.IsEmpty() &&
+      (initial_basis_.num_rows != lp.num_constraints() ||
+       initial_basis_.num_cols != lp.num_variables())) {
+    VLOG(1) << "Ignoring the initial basis since its dimension doesn't match.";
+    initial_basis_ = BasisState();
+  }
+
   // Preprocess.
   status_ = ProblemStatus::INIT;
   RunPreprocessors(time_limit);
@@ -152,7 +325,8 @@ ProblemStatus LPSolver::Solve(const LinearProgram& lp) {
   ProblemSolution solution(current_linear_program_.num_constraints(),
                            current_linear_program_.num_variables());
   solution.status = status_;
-  RunRevisedSimplexIfNeeded(&solution);
+  RunRevisedSimplexIfNeeded(time_limit, &solution);
+  initial_basis_ = BasisState();
   PostprocessSolution(&solution);
   return LoadAndVerifySolution(lp, solution);
 }
@@ -161,6 +335,36 @@ void LPSolver::Clear() {
   ResizeSolution(RowIndex(0), ColIndex(0));
   preprocessors_.clear();
   revised_simplex_.reset(nullptr);
+  initial_basis_ = BasisState();
+}
+
+BasisState LPSolver::GetBasisState() const {
+  BasisState state;
+  state.num_cols = variable_statuses_.size();
+  state.num_rows = constraint_statuses_.size();
+  state.statuses = variable_statuses_;
+  for (RowIndex row(0); row < state.num_rows; ++row) {
+    state.statuses.push_back(ConstraintToSlackStatus(constraint_statuses_[row]));
+  }
+  return state;
+}
+
+void LPSolver::SetInitialBasis(const BasisState& state) {
+  DCHECK_EQ(state.statuses.size(),
+            state.num_cols + RowToColIndex(state.num_rows));
+  initial_basis_ = state;
+}
+
+void LPSolver::SetInitialBasis(
+    const VariableStatusRow& variable_statuses,
+    const ConstraintStatusColumn& constraint_statuses) {
+  initial_basis_.num_cols = variable_statuses.size();
+  initial_basis_.num_rows = constraint_statuses.size();
+  initial_basis_.statuses = variable_statuses;
+  for (RowIndex row(0); row < initial_basis_.num_rows; ++row) {
+    initial_basis_.statuses.push_back(
+        ConstraintToSlackStatus(constraint_statuses[row]));
+  }
 }
 
 ProblemStatus LPSolver::LoadAndVerifySolution(const LinearProgram& lp,
@@ -334,8 +538,9 @@ int LPSolver::GetNumberOfSimplexIterations() const {
 }
 
 double LPSolver::DeterministicTime() const {
-  return revised_simplex_ == nullptr ? 0.0
-                                     : revised_simplex_->DeterministicTime();
+  return blocks_deterministic_time_ +
+         (revised_simplex_ == nullptr ? 0.0
+                                      : revised_simplex_->DeterministicTime());
 }
 
 void LPSolver::MovePrimalValuesWithinBounds(const LinearProgram& lp) {
@@ -385,7 +590,10 @@ void LPSolver::ResizeSolution(RowIndex num_rows, ColIndex num_cols) {
                        time_limit)
 
 void LPSolver::RunPreprocessors(const TimeLimit& time_limit) {
-  if (parameters_.use_preprocessing()) {
+  // With a warm-start basis, only the scaling is performed since it is the only
+  // preprocessor that preserves the meaning of the variable statuses.
+  const bool has_initial_basis = !initial_basis_.IsEmpty();
+  if (parameters_.use_preprocessing() && !has_initial_basis) {
     RUN_PREPROCESSOR(ShiftVariableBoundsPreprocessor);
     RUN_PREPROCESSOR(RemoveNearZeroEntriesPreprocessor);
 
@@ -435,7 +643,9 @@ void LPSolver::RunPreprocessors(const TimeLimit& time_limit) {
 
   // These are implemented as preprocessors, but are not controlled by the
   // use_preprocessing() parameter.
-  RUN_PREPROCESSOR(SingletonColumnSignPreprocessor);
+  if (!has_initial_basis) {
+    RUN_PREPROCESSOR(SingletonColumnSignPreprocessor);
+  }
   RUN_PREPROCESSOR(ScalingPreprocessor);
 }
 
@@ -482,38 +692,164 @@ void LPSolver::RunAndPushIfRelevant(std::unique_ptr<Preprocessor> preprocessor,
   }
 }
 
-void LPSolver::RunRevisedSimplexIfNeeded(ProblemSolution* solution) {
+void LPSolver::RunRevisedSimplexIfNeeded(const TimeLimit& time_limit,
+                                         ProblemSolution* solution) {
+  if (solution->status == ProblemStatus::INIT &&
+      parameters_.use_block_decomposition() &&
+      SolveIndependentBlocks(time_limit, solution)) {
+    return;
+  }
+
   // Note that the transpose matrix is no longer needed at this point.
   // This helps reduce the peak memory usage of the solver.
   current_linear_program_.ClearTransposeMatrix();
   if (solution->status != ProblemStatus::INIT) return;
+  if (parameters_.use_concurrent_simplex()) {
+    RunConcurrentSimplex(solution);
+    return;
+  }
   if (revised_simplex_ == nullptr) {
     revised_simplex_.reset(new RevisedSimplex());
   }
   revised_simplex_->SetParameters(parameters_);
+  if (!initial_basis_.IsEmpty()) {
+    revised_simplex_->LoadStateForNextSolve(initial_basis_);
+  }
   if (revised_simplex_->Solve(current_linear_program_).ok()) {
     num_revised_simplex_iterations_ = revised_simplex_->GetNumberOfIterations();
-    solution->status = revised_simplex_->GetProblemStatus();
+    GetRevisedSimplexSolution(*revised_simplex_, solution);
+  } else {
+    VLOG(1) << "Error during the revised simplex algorithm.";
+    solution->status = ProblemStatus::ABNORMAL;
+  }
+}
 
-    const ColIndex num_cols = revised_simplex_->GetProblemNumCols();
-    DCHECK_EQ(solution->primal_values.size(), num_cols);
-    for (ColIndex col(0); col < num_cols; ++col) {
-      solution->primal_values[col] = revised_simplex_->GetVariableValue(col);
-      solution->variable_statuses[col] =
-          revised_simplex_->GetVariableStatus(col);
+void LPSolver::RunConcurrentSimplex(ProblemSolution* solution) {
+  // All the runs read current_linear_program_. IsCleanedUp() caches its result
+  // on the first call, so it is done here to not do it concurrently.
+  current_linear_program_.IsCleanedUp();
+
+  // The primal simplex is the run #0 and the dual simplex the run #1.
+  const int kNumRuns = 2;
+  std::vector<ConcurrentSimplexRun> runs(kNumRuns);
+  std::atomic<bool> interrupt(false);
+  for (int i = 0; i < kNumRuns; ++i) {
+    GlopParameters run_parameters(parameters_);
+    run_parameters.set_use_dual_simplex(i == 1);
+    runs[i].revised_simplex->SetParameters(run_parameters);
+    runs[i].revised_simplex->RegisterExternalBooleanAsLimit(&interrupt);
+    if (!initial_basis_.IsEmpty()) {
+      runs[i].revised_simplex->LoadStateForNextSolve(initial_basis_);
     }
-
-    const RowIndex num_rows = revised_simplex_->GetProblemNumRows();
-    DCHECK_EQ(solution->dual_values.size(), num_rows);
-    for (RowIndex row(0); row < num_rows; ++row) {
-      solution->dual_values[row] = revised_simplex_->GetDualValue(row);
-      solution->constraint_statuses[row] =
-          revised_simplex_->GetConstraintStatus(row);
+  }
+  {
+    // The destructor of the pool waits for all the runs to finish.
+    const LinearProgram* const lp = &current_linear_program_;
+    ThreadPool pool("LPConcurrentSimplex", kNumRuns);
+    pool.StartWorkers();
+    for (int i = 0; i < kNumRuns; ++i) {
+      pool.Add(
+          NewCallback(&SolveConcurrentSimplexRun, lp, &interrupt, &runs[i]));
     }
-  } else {
+  }
+
+  // Use the first run that reached a conclusive status. If there is none, for
+  // instance because the time limit was reached, use the first run without
+  // error.
+  int chosen_run = -1;
+  for (int i = 0; i < kNumRuns; ++i) {
+    if (runs[i].is_first) chosen_run = i;
+  }
+  for (int i = 0; chosen_run == -1 && i < kNumRuns; ++i) {
+    if (runs[i].solve_ok) chosen_run = i;
+  }
+  if (chosen_run == -1) {
     VLOG(1) << "Error during the revised simplex algorithm.";
     solution->status = ProblemStatus::ABNORMAL;
+    return;
+  }
+  VLOG(1) << "Using the result of the "
+          << (chosen_run == 1 ? "dual" : "primal") << " simplex.";
+
+  // The chosen RevisedSimplex becomes the one used by the accessors of this
+  // class, so it must not refer to the local interrupt Boolean anymore.
+  revised_simplex_ = std::move(runs[chosen_run].revised_simplex);
+  revised_simplex_->RegisterExternalBooleanAsLimit(nullptr);
+  num_revised_simplex_iterations_ = revised_simplex_->GetNumberOfIterations();
+  GetRevisedSimplexSolution(*revised_simplex_, solution);
+}
+
+bool LPSolver::SolveIndependentBlocks(const TimeLimit& time_limit,
+                                      ProblemSolution* solution) {
+  // A warm-start basis and the objective limits refer to the whole problem.
+  if (!initial_basis_.IsEmpty() ||
+      parameters_.objective_lower_limit() != -kInfinity ||
+      parameters_.objective_upper_limit() != kInfinity) {
+    return false;
+  }
+  LPDecomposer decomposer;
+  decomposer.Decompose(&current_linear_program_);
+  current_linear_program_.ClearTransposeMatrix();
+  const int num_blocks = decomposer.GetNumberOfProblems();
+  if (num_blocks < 2 || decomposer.HasEmptyConstraints()) return false;
+  VLOG(1) << "Solving " << num_blocks << " independent blocks.";
+
+  std::vector<BlockSolveResult> results(num_blocks);
+  const double total_size =
+      GetSizeForDeterministicTimeShare(current_linear_program_);
+  const int num_threads =
+      std::min(num_blocks, std::max(1, parameters_.num_block_solver_threads()));
+  if (num_threads == 1) {
+    for (int block = 0; block < num_blocks; ++block) {
+      SolveBlock(&parameters_, &time_limit, total_size, &decomposer, block,
+                 &results[block]);
+    }
+  } else {
+    // The destructor of the pool waits for all the blocks to be solved.
+    ThreadPool pool("LPBlockSolver", num_threads);
+    pool.StartWorkers();
+    for (int block = 0; block < num_blocks; ++block) {
+      pool.Add(NewCallback(&SolveBlock, &parameters_, &time_limit, total_size,
+                           &decomposer, block, &results[block]));
+    }
   }
+  for (int block = 0; block < num_blocks; ++block) {
+    num_revised_simplex_iterations_ += results[block].num_iterations;
+    blocks_deterministic_time_ += results[block].deterministic_time;
+  }
+
+  // When the statuses of the blocks do not allow to conclude, the whole problem
+  // is solved by the usual path instead.
+  const ProblemStatus status = GetStatusOfIndependentBlocks(results);
+  if (status == ProblemStatus::INIT) {
+    VLOG(1) << "The statuses of the blocks are inconclusive, solving the "
+            << "whole problem.";
+    return false;
+  }
+
+  // The solution does not come from revised_simplex_ anymore, so its state
+  // must not be used, e.g. by DeterministicTime() or as a warm-start.
+  revised_simplex_.reset(nullptr);
+
+  std::vector<DenseRow> primal_values(num_blocks);
+  std::vector<DenseColumn> dual_values(num_blocks);
+  std::vector<VariableStatusRow> variable_statuses(num_blocks);
+  std::vector<ConstraintStatusColumn> constraint_statuses(num_blocks);
+  for (int block = 0; block < num_blocks; ++block) {
+    ProblemSolution* const block_solution = &results[block].solution;
+    primal_values[block].swap(block_solution->primal_values);
+    dual_values[block].swap(block_solution->dual_values);
+    variable_statuses[block].swap(block_solution->variable_statuses);
+    constraint_statuses[block].swap(block_solution->constraint_statuses);
+  }
+  solution->status = status;
+  solution->primal_values = decomposer.AggregateAssignments(primal_values);
+  solution->dual_values = decomposer.AggregateConstraintValues(dual_values);
+  solution->variable_statuses =
+      decomposer.AggregateVariableStatuses(variable_statuses);
+  solution->constraint_statuses =
+      decomposer.AggregateConstraintStatuses(constraint_statuses);
+  return true;
 }
 
 void LPSolver::PostprocessSolution(ProblemSolution* solution) {
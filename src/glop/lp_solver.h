@@ -70,6 +70,25 @@ class LPSolver {
   ProblemStatus LoadAndVerifySolution(const LinearProgram& lp,
                                       const ProblemSolution& solution);
 
+  // Returns the basis of the last Solve() in the BasisState format used by
+  // RevisedSimplex: the variable statuses followed by the statuses of the slack
+  // variables associated with the constraints. Note that this basis refers to
+  // the linear program given to Solve(), not to the preprocessed one.
+  BasisState GetBasisState() const;
+
+  // Uses the given basis (see GetBasisState()) as a warm-start for the next
+  // Solve(). It is ignored if its dimension doesn't match the one of the next
+  // linear program. Since the basis refers to the problem before
+  // preprocessing, the next Solve() will only run the preprocessors that do
+  // not change the problem structure (i.e. the scaling).
+  void SetInitialBasis(const BasisState& state);
+
+  // Same as above, with a basis given by the statuses of the variables and of
+  // the constraints, as returned by variable_statuses() and
+  // constraint_statuses().
+  void SetInitialBasis(const VariableStatusRow& variable_statuses,
+                       const ConstraintStatusColumn& constraint_statuses);
+
   // Returns the objective value of the solution with its offset.
   Fractional GetObjectiveValue() const;
 
@@ -144,8 +163,24 @@ class LPSolver {
                             const std::string& name, const TimeLimit& time_limit);
 
   // Runs the revised simplex algorithm if needed (i.e. if the program was not
-  // already solved by the preprocessors).
-  void RunRevisedSimplexIfNeeded(ProblemSolution* solution);
+  // already solved by the preprocessors). If use_block_decomposition is true,
+  // this first tries SolveIndependentBlocks(). If use_concurrent_simplex is
+  // true, this uses RunConcurrentSimplex().
+  void RunRevisedSimplexIfNeeded(const TimeLimit& time_limit,
+                                 ProblemSolution* solution);
+
+  // Solves the current linear program with a primal and a dual simplex running
+  // in two threads. The first one to finish with a conclusive status stops the
+  // other, and becomes revised_simplex_.
+  void RunConcurrentSimplex(ProblemSolution* solution);
+
+  // Splits the current linear program into independent blocks (see
+  // LPDecomposer) and solves each of them with its own RevisedSimplex, using
+  // num_block_solver_threads threads. Returns false, without modifying the
+  // solution, if the problem doesn't have at least two blocks or if its blocks
+  // cannot be solved separately.
+  bool SolveIndependentBlocks(const TimeLimit& time_limit,
+                              ProblemSolution* solution);
 
   // Postprocess the solution by calling the StoreSolution() of the
   // preprocessors in the reverse order in which their where applied.
@@ -218,9 +253,17 @@ class LPSolver {
   // The revised simplex solver.
   std::unique_ptr<RevisedSimplex> revised_simplex_;
 
+  // The warm-start basis given by SetInitialBasis() for the next Solve(), or
+  // an empty state if there is none.
+  BasisState initial_basis_;
+
   // The number of revised simplex iterations used by the last Solve().
   int num_revised_simplex_iterations_;
 
+  // The deterministic time spent by the simplex of the independent blocks since
+  // the creation of the solver. See SolveIndependentBlocks().
+  double blocks_deterministic_time_;
+
   // The current ProblemSolution.
   // TODO(user): use a ProblemSolution directly?
   ProblemStatus status_;
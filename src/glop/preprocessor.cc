@@ -1412,9 +1412,13 @@ bool DoubletonFreeColumnPreprocessor::Run(LinearProgram* lp) {
     // Save the deleted row for postsolve. Note that we remove it from the
     // transpose at the same time. This last operation is not strictly needed,
     // but it is faster to do it this way (both here and later when we will take
-    // the transpose of the final transpose matrix).
-    r.deleted_row_as_column.Swap(
-        transpose->mutable_column(RowToColIndex(r.row[DELETED])));
+    // the transpose of the final transpose matrix). We copy the row rather than
+    // swapping it, so the saved row doesn't keep the entries of the whole
+    // transpose alive (they share a single allocation).
+    SparseColumn* const deleted_row =
+        transpose->mutable_column(RowToColIndex(r.row[DELETED]));
+    r.deleted_row_as_column.PopulateFromSparseVector(*deleted_row);
+    deleted_row->Clear();
 
     // Move the bound of the deleted constraint to the initially free variable.
     {
@@ -119,10 +119,10 @@ void PrimalEdgeNorms::UpdateBeforeBasisPivot(ColIndex entering_col,
 
 void PrimalEdgeNorms::ComputeMatrixColumnNorms() {
   SCOPED_TIME_STAT(&stats_);
-  matrix_column_norms_.resize(matrix_.num_cols(), 0.0);
-  for (ColIndex col(0); col < matrix_.num_cols(); ++col) {
-    matrix_column_norms_[col] = sqrt(SquaredNorm(matrix_.column(col)));
-    num_operations_ += matrix_.column(col).num_entries().value();
+  matrix_column_norms_.resize(compact_matrix_.num_cols(), 0.0);
+  for (ColIndex col(0); col < compact_matrix_.num_cols(); ++col) {
+    matrix_column_norms_[col] = sqrt(SquaredNorm(compact_matrix_.column(col)));
+    num_operations_ += compact_matrix_.ColumnNumEntries(col).value();
   }
 }
 
@@ -175,7 +175,8 @@ void PrimalEdgeNorms::ComputeDirectionLeftInverse(
 
   // TODO(user): Refactorize if estimated accuracy above a threshold.
   IF_STATS_ENABLED(stats_.direction_left_inverse_accuracy.Add(
-      ScalarProduct(direction_left_inverse_, matrix_.column(entering_col)) -
+      compact_matrix_.ColumnScalarProduct(entering_col,
+                                          direction_left_inverse_) -
       SquaredNorm(direction.dense_column)));
   IF_STATS_ENABLED(stats_.direction_left_inverse_density.Add(
       Density(direction_left_inverse_)));
@@ -48,6 +48,11 @@ DEFINE_int64(max_time_in_ms, -1, "Maximum time allowed in milliseconds.");
 DEFINE_int64(threads, 1, "Number of threads.");
 DEFINE_double(variable_tolerance, 1e-7, "Tolerance on variable values.");
 DEFINE_double(cost_tolerance, 1e-7, "Tolerance on cost value.");
+DEFINE_bool(use_snapshots, false,
+            "If true, Glop loads each problem from the binary snapshot "
+            "<input>.glopsnap when it exists instead of parsing the proto, and "
+            "warm-starts from the basis it contains. The snapshot is "
+            "(re)written with the final basis after each Glop solve.");
 
 namespace operations_research {
 namespace glop {
@@ -73,21 +78,6 @@ struct InstanceResult {
 
 void Solve(MPSolver::OptimizationProblemType type, const std::string& file_name,
            InstanceResult* result) {
-  std::string raw_data;
-  CHECK_OK(file::GetContents(file_name, &raw_data, file::Defaults()));
-  std::string uncompressed;
-  if (!GunzipString(raw_data, &uncompressed)) {
-    uncompressed = raw_data;
-  }
-  new_proto::MPModelProto proto;
-  {
-    ScopedWallTime timer(&(result->parsing_time_in_sec));
-    if (!proto.ParseFromString(uncompressed)) {
-      // We do not care about timing the parsing from a text proto, that's why
-      // we try first to parse the proto as binary.
-      CHECK(TextFormat::ParseFromString(uncompressed, &proto));
-    }
-  }
   MPSolver solver(file_name, type);
   if (FLAGS_max_time_in_ms >= 0) {
     solver.set_time_limit(FLAGS_max_time_in_ms);
@@ -95,7 +85,31 @@ void Solve(MPSolver::OptimizationProblemType type, const std::string& file_name,
   MPSolverParameters param;
   param.SetIntegerParam(MPSolverParameters::SCALING,
                         MPSolverParameters::SCALING_OFF);
-  {
+  const bool use_snapshot =
+      FLAGS_use_snapshots && type == MPSolver::GLOP_LINEAR_PROGRAMMING;
+  const std::string snapshot_file_name = file_name + ".glopsnap";
+  bool loaded_from_snapshot = false;
+  if (use_snapshot && File::Exists(snapshot_file_name.c_str())) {
+    // There is no parsing involved, everything is counted as loading time.
+    ScopedWallTime timer(&(result->loading_time_in_sec));
+    loaded_from_snapshot = solver.LoadModelFromLpSnapshot(snapshot_file_name);
+  }
+  if (!loaded_from_snapshot) {
+    std::string raw_data;
+    CHECK_OK(file::GetContents(file_name, &raw_data, file::Defaults()));
+    std::string uncompressed;
+    if (!GunzipString(raw_data, &uncompressed)) {
+      uncompressed = raw_data;
+    }
+    new_proto::MPModelProto proto;
+    {
+      ScopedWallTime timer(&(result->parsing_time_in_sec));
+      if (!proto.ParseFromString(uncompressed)) {
+        // We do not care about timing the parsing from a text proto, that's
+        // why we try first to parse the proto as binary.
+        CHECK(TextFormat::ParseFromString(uncompressed, &proto));
+      }
+    }
     ScopedWallTime timer(&(result->loading_time_in_sec));
     const MPSolver::LoadStatus load_status = solver.LoadModelFromProto(proto);
     CHECK(load_status == MPSolver::NO_ERROR);
@@ -104,6 +118,9 @@ void Solve(MPSolver::OptimizationProblemType type, const std::string& file_name,
     ScopedWallTime timer(&(result->solving_time_in_sec));
     result->result_status = solver.Solve(param);
   }
+  if (use_snapshot && !solver.WriteLpSnapshot(snapshot_file_name)) {
+    LOG(WARNING) << "Could not write the snapshot " << snapshot_file_name;
+  }
   result->objective_value = (result->result_status == MPSolver::OPTIMAL)
                                 ? solver.Objective().Value()
                                 : 0;
@@ -63,6 +63,16 @@ void MPModelProtoToLinearProgram(const new_proto::MPModelProto& input,
     output->SetObjectiveCoefficient(col, var.objective_coefficient());
     output->SetVariableIntegrality(col, var.is_integer());
   }
+  StrictITIVector<ColIndex, EntryIndex> num_entries(output->num_variables(),
+                                                    EntryIndex(0));
+  for (int j = 0; j < input.constraint_size(); ++j) {
+    for (const int var_index : input.constraint(j).var_index()) {
+      if (var_index >= 0 && var_index < input.variable_size()) {
+        ++num_entries[ColIndex(var_index)];
+      }
+    }
+  }
+  output->ClearAndReserveColumnEntries(num_entries);
   for (int j = 0; j < input.constraint_size(); ++j) {
     const new_proto::MPConstraintProto& cst = input.constraint(j);
     const RowIndex row = output->CreateNewConstraint();
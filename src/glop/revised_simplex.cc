@@ -97,7 +97,8 @@ RevisedSimplex::RevisedSimplex()
       parameters_(),
       test_lu_(),
       feasibility_phase_(true),
-      random_("This is a deterministic seed.") {
+      random_("This is a deterministic seed."),
+      external_boolean_as_limit_(nullptr) {
   PropagateParameters();
 }
 
@@ -118,6 +119,7 @@ Status RevisedSimplex::Solve(const LinearProgram& lp) {
   SCOPED_TIME_STAT(&function_stats_);
   DCHECK(lp.IsCleanedUp());
   TimeLimit time_limit(parameters_.max_time_in_seconds());
+  time_limit.RegisterExternalBooleanAsLimit(external_boolean_as_limit_);
   WallTimer timer;
   timer.Start();
 
@@ -150,9 +152,9 @@ Status RevisedSimplex::Solve(const LinearProgram& lp) {
 
   const bool use_dual = parameters_.use_dual_simplex();
   VLOG(1) << "------ " << (use_dual ? "Dual simplex." : "Primal simplex.");
-  VLOG(1) << "The matrix has " << matrix_with_slack_.num_rows() << " rows, "
-          << matrix_with_slack_.num_cols() << " columns, "
-          << matrix_with_slack_.num_entries() << " entries.";
+  VLOG(1) << "The matrix has " << compact_matrix_.num_rows() << " rows, "
+          << compact_matrix_.num_cols() << " columns, "
+          << compact_matrix_.num_entries() << " entries.";
 
   current_objective_ = objective_;
 
@@ -374,7 +376,7 @@ VariableStatus RevisedSimplex::ComputeDefaultVariableStatus(
   // works better. We set the initial value of a boxed variable to its bound
   // that minimizes the cost.
   if (parameters_.exploit_singleton_column_in_initial_basis() &&
-      matrix_with_slack_.column(col).num_entries() == 1) {
+      compact_matrix_.column(col).num_entries() == 1) {
     const Fractional objective = objective_[col];
     if (objective > 0 && IsFinite(lower_bound_[col])) {
       return VariableStatus::AT_LOWER_BOUND;
@@ -482,10 +484,9 @@ void RevisedSimplex::UseSingletonColumnInInitialBasis(RowToColMapping* basis) {
   std::vector<ColIndex> singleton_column;
   DenseRow cost_variation(num_cols_, 0.0);
   for (ColIndex col(0); col < num_cols_; ++col) {
-    if (matrix_with_slack_.column(col).num_entries() != 1) continue;
+    if (compact_matrix_.column(col).num_entries() != 1) continue;
     if (lower_bound_[col] == upper_bound_[col]) continue;
-    const Fractional slope =
-        matrix_with_slack_.column(col).GetFirstCoefficient();
+    const Fractional slope = compact_matrix_.column(col).GetFirstCoefficient();
     if (variable_values_.Get(col) == lower_bound_[col]) {
       cost_variation[col] = objective_[col] / fabs(slope);
     } else {
@@ -580,7 +581,7 @@ bool RevisedSimplex::InitializeMatrixAndTestIfUnchanged(const LinearProgram& lp,
     // view was refering to a previous lp.GetSparseMatrix(). The matrices are
     // the same, but we do need to update the pointers.
     //
-    // TODO(user): use compact_matrix_ everywhere instead.
+    // TODO(user): use compact_matrix_ in the basis factorization too.
     matrix_with_slack_.PopulateFromMatrixPair(lp.GetSparseMatrix(),
                                               identity_matrix_);
     return true;
@@ -611,8 +612,11 @@ bool RevisedSimplex::InitializeMatrixAndTestIfUnchanged(const LinearProgram& lp,
 
   // Populate compact_matrix_ and transposed_matrix_ if needed. Note that we
   // already added all the slack and artificial variables at this point, so
-  // matrix_ will not change anymore.
-  compact_matrix_.PopulateFromMatrixView(matrix_with_slack_);
+  // matrix_ will not change anymore. compact_matrix_ is built directly from the
+  // lp matrix: this is faster than going through matrix_with_slack_ and its
+  // entries are stored contiguously in the same order.
+  compact_matrix_.PopulateFromSparseMatrixAndAddSlacks(lp.GetSparseMatrix());
+  DCHECK_EQ(num_cols_, compact_matrix_.num_cols());
   if (parameters_.use_transposed_matrix()) {
     transposed_matrix_.PopulateFromTranspose(compact_matrix_);
   }
@@ -721,11 +725,15 @@ void RevisedSimplex::InitializeVariableStatusesForWarmStart(
       }
     }
 
-    // Remove bounds incompatibilities.
+    // Remove bounds incompatibilities. Note that a non-basic variable whose
+    // bounds became equal must be FIXED_VALUE, otherwise the primal simplex
+    // may try to move it.
     if ((status == VariableStatus::FREE &&
          default_status != VariableStatus::FREE) ||
         (status == VariableStatus::FIXED_VALUE &&
          default_status != VariableStatus::FIXED_VALUE) ||
+        (default_status == VariableStatus::FIXED_VALUE &&
+         status != VariableStatus::BASIC) ||
         (status == VariableStatus::AT_LOWER_BOUND &&
          lower_bound_[col] == -kInfinity) ||
         (status == VariableStatus::AT_UPPER_BOUND &&
@@ -821,7 +829,7 @@ Status RevisedSimplex::CreateInitialBasis() {
       // Then complete the basis with an advanced initial basis algorithm.
       VLOG(1) << "Trying to remove " << num_fixed_variables
               << " fixed variables from the initial basis.";
-      InitialBasis initial_basis(matrix_with_slack_, objective_, lower_bound_,
+      InitialBasis initial_basis(compact_matrix_, objective_, lower_bound_,
                                  upper_bound_, variables_info_.GetTypeRow());
 
       if (parameters_.use_dual_simplex()) {
@@ -854,6 +862,30 @@ Status RevisedSimplex::CreateInitialBasis() {
   return InitializeFirstBasis(basis);
 }
 
+Status RevisedSimplex::InitializeFirstBasisFromState(const BasisState& state) {
+  InitializeVariableStatusesForWarmStart(state);
+  basis_.assign(num_rows_, kInvalidCol);
+  RowIndex row(0);
+  for (ColIndex col : variables_info_.GetIsBasicBitRow()) {
+    basis_[row] = col;
+    ++row;
+  }
+
+  // Complete the basis with non-basic slack columns if needed. There are
+  // always enough of them since at most row basic columns are slacks.
+  //
+  // TODO(user): We could complete the basis in a better way using a partial
+  // LU decomposition (see markowitz.h).
+  const DenseBitRow& is_basic = variables_info_.GetIsBasicBitRow();
+  ColIndex slack_col = first_slack_col_;
+  for (; row < num_rows_; ++row) {
+    while (is_basic.IsSet(slack_col)) ++slack_col;
+    basis_[row] = slack_col;
+    ++slack_col;
+  }
+  return InitializeFirstBasis(basis_);
+}
+
 Status RevisedSimplex::InitializeFirstBasis(const RowToColMapping& basis) {
   basis_ = basis;
 
@@ -917,7 +949,21 @@ Status RevisedSimplex::Initialize(const LinearProgram& lp) {
   // Warm-start? Only a few scenarios are currently supported and they are
   // tested only if the solution_state_ is not empty.
   bool solve_from_scratch = true;
-  if (!solution_state_.IsEmpty()) {
+  if (!solution_state_.IsEmpty() && solution_state_has_been_set_externally_) {
+    // The given state may come from a previous run on the same problem (for
+    // instance through a LinearProgramSnapshot). Both the primal and the dual
+    // phase-I algorithms work from any initial basis, so we only need the
+    // basis described by the state to be factorizable.
+    primal_edge_norms_.Clear();
+    dual_edge_norms_.Clear();
+    dual_pricing_vector_.clear();
+    if (InitializeFirstBasisFromState(solution_state_).ok()) {
+      reduced_costs_.ClearAndRemoveCostShifts();
+      solve_from_scratch = false;
+    } else {
+      VLOG(1) << "The given warm-start basis is singular, ignoring it.";
+    }
+  } else if (!solution_state_.IsEmpty()) {
     // For the primal simplex, we can only do a warm start if we have a primal
     // feasible solution (because introducing artificial variables only
     // works with an initial identity basis).
@@ -943,30 +989,7 @@ Status RevisedSimplex::Initialize(const LinearProgram& lp) {
 
       // The dual simplex phase-I algorithm is more tolerant, so we don't
       // even need a dual-feasible starting basis.
-      if (solution_state_has_been_set_externally_) {
-        // TODO(user): This is currently disabled since it seems to give bad
-        // results, investigate.
-        if (/* DISABLES CODE */ (false)) {
-          InitializeVariableStatusesForWarmStart(solution_state_);
-          basis_.assign(num_rows_, kInvalidCol);
-          RowIndex row(0);
-          for (ColIndex col : variables_info_.GetIsBasicBitRow()) {
-            basis_[row] = col;
-            ++row;
-          }
-          // Only start from here if the basis is refactorizable.
-          //
-          // TODO(user): If the basis is incomplete, we could complete it with
-          // slack variables in a better way than what is done by
-          // InitializeFirstBasis() using a partial LU decomposition (see
-          // markowitz.h).
-          if (InitializeFirstBasis(basis_).ok()) {
-            dual_edge_norms_.Clear();
-            reduced_costs_.ClearAndRemoveCostShifts();
-            solve_from_scratch = false;
-          }
-        }
-      } else if (is_objective_unchanged &&
+      if (is_objective_unchanged &&
                  (problem_status_ == ProblemStatus::OPTIMAL ||
                   problem_status_ == ProblemStatus::DUAL_UNBOUNDED ||
                   problem_status_ == ProblemStatus::DUAL_FEASIBLE)) {
@@ -1059,8 +1082,8 @@ void RevisedSimplex::SaveState() {
 RowIndex RevisedSimplex::ComputeNumberOfEmptyRows() {
   DenseBooleanColumn contains_data(num_rows_, false);
   for (ColIndex col(0); col < num_cols_; ++col) {
-    for (const SparseColumn::Entry e : matrix_with_slack_.column(col)) {
-      contains_data[e.row()] = true;
+    for (const EntryIndex i : compact_matrix_.Column(col)) {
+      contains_data[compact_matrix_.EntryRow(i)] = true;
     }
   }
   RowIndex num_empty_rows(0);
@@ -1076,7 +1099,7 @@ RowIndex RevisedSimplex::ComputeNumberOfEmptyRows() {
 ColIndex RevisedSimplex::ComputeNumberOfEmptyColumns() {
   ColIndex num_empty_cols(0);
   for (ColIndex col(0); col < num_cols_; ++col) {
-    if (matrix_with_slack_.column(col).IsEmpty()) {
+    if (compact_matrix_.ColumnIsEmpty(col)) {
       ++num_empty_cols;
       VLOG(1) << "Column " << col << " is empty.";
     }
@@ -2803,7 +2826,7 @@ void RevisedSimplex::DisplayProblem() const {
     output = "";
     for (ColIndex col(0); col < num_cols_; ++col) {
       output += StringifyMonomialWithFlags(
-          matrix_with_slack_.column(col).LookUpCoefficient(row),
+          compact_matrix_.column(col).LookUpCoefficient(row),
           variable_name_[col]);
     }
     VLOG(3) << output << " = 0;";
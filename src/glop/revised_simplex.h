@@ -95,6 +95,7 @@
 #ifndef OR_TOOLS_GLOP_REVISED_SIMPLEX_H_
 #define OR_TOOLS_GLOP_REVISED_SIMPLEX_H_
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -173,9 +174,22 @@ class RevisedSimplex {
   // next Solve() will behave as if the class just got created.
   void ClearStateForNextSolve();
 
-  // Uses the given state as a warm-start for the next Solve() call.
+  // Uses the given state as a warm-start for the next Solve() call. The state
+  // is matched to the next linear program by index, and incompatible statuses
+  // (for instance AT_LOWER_BOUND for a variable with an infinite lower bound)
+  // are replaced by the default ones. If the resulting basis is singular, the
+  // next Solve() starts from scratch.
   void LoadStateForNextSolve(const BasisState& state);
 
+  // Registers a Boolean that interrupts the next Solve() calls as if their
+  // time limit was reached as soon as it becomes true. This is used to stop a
+  // solve from another thread, see TimeLimit::RegisterExternalBooleanAsLimit().
+  // The Boolean must outlive the Solve() calls, and nullptr disables it.
+  void RegisterExternalBooleanAsLimit(
+      const std::atomic<bool>* external_boolean_as_limit) {
+    external_boolean_as_limit_ = external_boolean_as_limit;
+  }
+
   // Getters to retrieve all the information computed by the last Solve().
   RowIndex GetProblemNumRows() const;
   ColIndex GetProblemNumCols() const;
@@ -317,6 +331,12 @@ class RevisedSimplex {
   // Initializes the variable statuses using a warm-start basis.
   void InitializeVariableStatusesForWarmStart(const BasisState& state);
 
+  // Initializes the variable statuses and the starting basis from the given
+  // warm-start basis (completed with slack columns if it is too small), tries
+  // to factorize it and recomputes the basic variable values.
+  Status InitializeFirstBasisFromState(const BasisState& state)
+      MUST_USE_RESULT;
+
   // Initializes the starting basis. In most cases it starts by the all slack
   // basis and tries to apply some heuristics to replace fixed variables.
   Status CreateInitialBasis() MUST_USE_RESULT;
@@ -539,12 +559,13 @@ class RevisedSimplex {
   // to access this view once Solve() is finished since there is no guarantee
   // that the stored pointers are still valid.
   //
-  // TODO(user): Get rid of this and make all the internal part of the solver
-  // use compact_matrix_ everywhere instead.
+  // TODO(user): Get rid of this and make the basis factorization and the
+  // primal edge norms use compact_matrix_ instead.
   MatrixView matrix_with_slack_;
   SparseMatrix identity_matrix_;
 
-  // The compact version of matrix_with_slack_.
+  // The compact version of matrix_with_slack_, built directly from the matrix
+  // given to Solve(). All the column scans of this class use it.
   CompactSparseMatrix compact_matrix_;
 
   // The tranpose of compact_matrix_, it may be empty if it is not needed.
@@ -731,6 +752,9 @@ class RevisedSimplex {
   // A random number generator.
   MTRandom random_;
 
+  // See RegisterExternalBooleanAsLimit().
+  const std::atomic<bool>* external_boolean_as_limit_;
+
   DISALLOW_COPY_AND_ASSIGN(RevisedSimplex);
 };
 
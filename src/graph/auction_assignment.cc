@@ -0,0 +1,575 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/auction_assignment.h"
+
+#include <algorithm>
+#include <atomic>  // NOLINT
+#include <cmath>
+#include <limits>
+#include <memory>
+
+#include "base/callback.h"
+#include "base/stringprintf.h"
+#include "base/synchronization.h"
+#include "base/threadpool.h"
+
+namespace operations_research {
+
+std::string AuctionStats::StatsString() const {
+  return StringPrintf("%lld phases; %lld rounds; %lld bids", phases, rounds,
+                      bids);
+}
+
+namespace {
+
+// The bid of a person: the object it bids for, the arc or column leading to
+// this object, and the new price it offers for it.
+struct Bid {
+  int object;
+  int choice;
+  CostValue price;
+};
+
+// Updates the smallest and the second smallest costs plus prices seen so far
+// in the scan of the choices of a person, and the choice reaching the
+// smallest one.
+inline void UpdateBestAndSecond(CostValue value, int choice, CostValue* best,
+                                CostValue* second, int* best_choice) {
+  if (value < *second) {
+    if (value < *best) {
+      *second = *best;
+      *best = value;
+      *best_choice = choice;
+    } else {
+      *second = value;
+    }
+  }
+}
+
+// The arcs of a sparse problem, packed by person.
+struct PackedArc {
+  CostValue scaled_cost;
+  int object;
+};
+
+class SparseBidder {
+ public:
+  SparseBidder(const std::vector<PackedArc>& arcs,
+               const std::vector<int>& first_arc, CostValue max_increase)
+      : arcs_(arcs), first_arc_(first_arc), max_increase_(max_increase) {}
+
+  int num_persons() const { return first_arc_.size() - 1; }
+  int AverageNumChoices() const {
+    return num_persons() == 0 ? 0 : arcs_.size() / num_persons();
+  }
+
+  void ComputeBid(int person, const CostValue* prices, CostValue epsilon,
+                  Bid* bid) const {
+    CostValue best = std::numeric_limits<CostValue>::max();
+    CostValue second = best;
+    int best_choice = -1;
+    const int end = first_arc_[person + 1];
+    for (int arc = first_arc_[person]; arc < end; ++arc) {
+      UpdateBestAndSecond(arcs_[arc].scaled_cost + prices[arcs_[arc].object],
+                          arc, &best, &second, &best_choice);
+    }
+    DCHECK_NE(-1, best_choice);
+    if (second == std::numeric_limits<CostValue>::max()) {
+      second = best + max_increase_;
+    }
+    bid->object = arcs_[best_choice].object;
+    bid->choice = best_choice;
+    bid->price = prices[bid->object] + second - best + epsilon;
+  }
+
+ private:
+  const std::vector<PackedArc>& arcs_;
+  const std::vector<int>& first_arc_;
+  const CostValue max_increase_;
+};
+
+template <typename CostType>
+class DenseBidder {
+ public:
+  DenseBidder(const std::vector<CostType>& costs, int size, CostValue scale,
+              CostValue max_increase)
+      : costs_(costs), size_(size), scale_(scale),
+        max_increase_(max_increase) {}
+
+  int num_persons() const { return size_; }
+  int AverageNumChoices() const { return size_; }
+
+  void ComputeBid(int person, const CostValue* prices, CostValue epsilon,
+                  Bid* bid) const {
+    CostValue best = std::numeric_limits<CostValue>::max();
+    CostValue second = best;
+    int best_choice = -1;
+    const CostType* const row = &costs_[static_cast<int64>(person) * size_];
+    for (int column = 0; column < size_; ++column) {
+      UpdateBestAndSecond(
+          static_cast<CostValue>(row[column]) * scale_ + prices[column],
+          column, &best, &second, &best_choice);
+    }
+    if (second == std::numeric_limits<CostValue>::max()) {
+      second = best + max_increase_;
+    }
+    bid->object = best_choice;
+    bid->choice = best_choice;
+    bid->price = prices[best_choice] + second - best + epsilon;
+  }
+
+ private:
+  const std::vector<CostType>& costs_;
+  const int size_;
+  const CostValue scale_;
+  const CostValue max_increase_;
+};
+
+// The bids of a round of the parallel auction are computed by chunks of
+// persons, whose size is chosen so that each chunk scans about this number of
+// costs.
+const int kCostsPerChunk = 4096;
+
+// The epsilon-scaling auction, on a problem with as many objects as persons,
+// whose costs are accessed through a Bidder.
+template <typename Bidder>
+class Auction {
+ public:
+  Auction(const Bidder& bidder, int num_threads, AuctionStats* stats)
+      : bidder_(bidder),
+        num_persons_(bidder.num_persons()),
+        num_threads_(std::max(1, num_threads)),
+        chunk_size_(std::max(
+            1, kCostsPerChunk / std::max(1, bidder.AverageNumChoices()))),
+        stats_(stats),
+        prices_(num_persons_, 0),
+        owner_(num_persons_, -1),
+        choice_(num_persons_, -1),
+        epsilon_(0),
+        next_chunk_(0),
+        stop_threads_(false) {}
+
+  // Runs the phases, from initial_epsilon down to 1, and fills choices with
+  // the arc or column assigned to each person.
+  void Run(CostValue initial_epsilon, CostValue divisor,
+           std::vector<int>* choices);
+
+ private:
+  void RunSequentialPhase();
+  void RunParallelPhase();
+
+  // Computes the bids of unassigned_ into bids_.
+  void ComputeAllBids();
+  void ComputeBids();
+  void RunWorker();
+
+  const Bidder& bidder_;
+  const int num_persons_;
+  const int num_threads_;
+  const int chunk_size_;
+  AuctionStats* const stats_;
+
+  // The prices of the objects, the person owning each object or -1, and the
+  // arc or column through which each assigned person owns its object.
+  std::vector<CostValue> prices_;
+  std::vector<int> owner_;
+  std::vector<int> choice_;
+
+  CostValue epsilon_;
+  std::vector<int> unassigned_;
+
+  // The parallel rounds: the bids of the persons of unassigned_, and for
+  // each object, its best bid in the current round (the index in bids_ of
+  // its bidder) and the last round in which it received a bid.
+  std::vector<Bid> bids_;
+  std::vector<int> best_bid_;
+  std::vector<int64> last_bid_round_;
+  std::vector<int> bid_objects_;
+  std::vector<int> next_unassigned_;
+
+  // The synchronization of the worker threads.
+  std::unique_ptr<ReusableBarrier> barrier_;
+  std::atomic<int> next_chunk_;
+  bool stop_threads_;
+
+  DISALLOW_COPY_AND_ASSIGN(Auction);
+};
+
+template <typename Bidder>
+void Auction<Bidder>::Run(CostValue initial_epsilon, CostValue divisor,
+                          std::vector<int>* choices) {
+  std::unique_ptr<ThreadPool> pool;
+  if (num_threads_ > 1) {
+    // The calling thread is the thread 0, the others wait for the rounds.
+    barrier_.reset(new ReusableBarrier(num_threads_));
+    best_bid_.assign(num_persons_, -1);
+    last_bid_round_.assign(num_persons_, -1);
+    pool.reset(new ThreadPool("AuctionLinearSumAssignment", num_threads_ - 1));
+    pool->StartWorkers();
+    for (int i = 1; i < num_threads_; ++i) {
+      pool->Add(NewCallback(this, &Auction::RunWorker));
+    }
+  }
+  epsilon_ = initial_epsilon;
+  while (true) {
+    ++stats_->phases;
+    // The prices are shifted so that the smallest one is zero: this changes
+    // nothing to the bids and keeps the prices bounded.
+    const CostValue min_price =
+        num_persons_ == 0 ? 0 : *std::min_element(prices_.begin(),
+                                                  prices_.end());
+    for (CostValue& price : prices_) price -= min_price;
+    owner_.assign(num_persons_, -1);
+    unassigned_.clear();
+    for (int person = num_persons_ - 1; person >= 0; --person) {
+      unassigned_.push_back(person);
+    }
+    if (num_threads_ > 1) {
+      RunParallelPhase();
+    } else {
+      RunSequentialPhase();
+    }
+    if (epsilon_ == 1) break;
+    epsilon_ = std::max<CostValue>(1, epsilon_ / divisor);
+  }
+  if (pool != nullptr) {
+    stop_threads_ = true;
+    barrier_->Wait();
+    // The destructor of the pool waits for the worker threads to return.
+    pool.reset();
+  }
+  choices->swap(choice_);
+}
+
+template <typename Bidder>
+void Auction<Bidder>::RunSequentialPhase() {
+  Bid bid;
+  while (!unassigned_.empty()) {
+    const int person = unassigned_.back();
+    unassigned_.pop_back();
+    bidder_.ComputeBid(person, prices_.data(), epsilon_, &bid);
+    ++stats_->bids;
+    const int previous_owner = owner_[bid.object];
+    if (previous_owner != -1) unassigned_.push_back(previous_owner);
+    prices_[bid.object] = bid.price;
+    owner_[bid.object] = person;
+    choice_[person] = bid.choice;
+  }
+}
+
+template <typename Bidder>
+void Auction<Bidder>::RunParallelPhase() {
+  while (!unassigned_.empty()) {
+    const int64 round = stats_->rounds++;
+    const int num_bids = unassigned_.size();
+    bids_.resize(num_bids);
+    ComputeAllBids();
+    stats_->bids += num_bids;
+
+    // Each object goes to its best bidder, the first one in case of ties so
+    // that the result does not depend on the number of threads.
+    bid_objects_.clear();
+    for (int i = 0; i < num_bids; ++i) {
+      const int object = bids_[i].object;
+      if (last_bid_round_[object] != round) {
+        last_bid_round_[object] = round;
+        best_bid_[object] = i;
+        bid_objects_.push_back(object);
+      } else if (bids_[i].price > bids_[best_bid_[object]].price) {
+        best_bid_[object] = i;
+      }
+    }
+    next_unassigned_.clear();
+    for (int i = 0; i < num_bids; ++i) {
+      if (best_bid_[bids_[i].object] != i) {
+        next_unassigned_.push_back(unassigned_[i]);
+      }
+    }
+    for (const int object : bid_objects_) {
+      const int i = best_bid_[object];
+      const int person = unassigned_[i];
+      if (owner_[object] != -1) next_unassigned_.push_back(owner_[object]);
+      prices_[object] = bids_[i].price;
+      owner_[object] = person;
+      choice_[person] = bids_[i].choice;
+    }
+    unassigned_.swap(next_unassigned_);
+  }
+}
+
+template <typename Bidder>
+void Auction<Bidder>::ComputeAllBids() {
+  next_chunk_.store(0, std::memory_order_relaxed);
+  // Waking up the other threads is not worth it for a single chunk, which is
+  // common at the end of the phases.
+  if (unassigned_.size() <= static_cast<size_t>(chunk_size_)) {
+    ComputeBids();
+    return;
+  }
+  // The first wait starts the round in all the threads, the second one waits
+  // for all of them to be done with it.
+  barrier_->Wait();
+  ComputeBids();
+  barrier_->Wait();
+}
+
+template <typename Bidder>
+void Auction<Bidder>::ComputeBids() {
+  const int num_bids = unassigned_.size();
+  while (true) {
+    const int begin =
+        chunk_size_ * next_chunk_.fetch_add(1, std::memory_order_relaxed);
+    if (begin >= num_bids) return;
+    const int end = std::min(begin + chunk_size_, num_bids);
+    for (int i = begin; i < end; ++i) {
+      bidder_.ComputeBid(unassigned_[i], prices_.data(), epsilon_, &bids_[i]);
+    }
+  }
+}
+
+template <typename Bidder>
+void Auction<Bidder>::RunWorker() {
+  while (true) {
+    barrier_->Wait();
+    if (stop_threads_) return;
+    ComputeBids();
+    barrier_->Wait();
+  }
+}
+
+// Returns the first epsilon of the scaling, or 0 if the prices could
+// overflow. The scaled costs are in [min_cost, max_cost] * scale. In a phase,
+// the price of an object increases by less than 2n times the range of the
+// scaled costs plus epsilon, and the prices are shifted to start at zero in
+// each phase, after having been bounded by n times the same amount at the end
+// of the previous one (see the references in the header).
+CostValue InitialEpsilon(CostValue min_cost, CostValue max_cost,
+                         CostValue scale, CostValue divisor, int n) {
+  const double max_magnitude =
+      std::max(std::abs(static_cast<double>(min_cost)),
+               std::abs(static_cast<double>(max_cost))) *
+      scale;
+  const double range =
+      (static_cast<double>(max_cost) - static_cast<double>(min_cost)) * scale;
+  const double epsilon = std::max(1.0, range / divisor);
+  const double bound = max_magnitude + 4.0 * (n + 1) * (range + epsilon + 1);
+  if (bound >= static_cast<double>(std::numeric_limits<CostValue>::max())) {
+    return 0;
+  }
+  return std::max<CostValue>(1, (max_cost - min_cost) * scale / divisor);
+}
+
+}  // namespace
+
+// ----- AuctionLinearSumAssignment -----
+
+AuctionLinearSumAssignment::AuctionLinearSumAssignment(const Graph& graph,
+                                                       NodeIndex num_left_nodes)
+    : graph_(graph),
+      num_left_nodes_(num_left_nodes),
+      arc_cost_(graph.num_arcs(), 0),
+      num_threads_(1),
+      divisor_(5),
+      success_(false) {}
+
+void AuctionLinearSumAssignment::SetArcCost(ArcIndex arc, CostValue cost) {
+  DCHECK_LE(0, arc);
+  DCHECK_LT(arc, graph_.num_arcs());
+  arc_cost_[arc] = cost;
+  success_ = false;
+}
+
+bool AuctionLinearSumAssignment::HasPerfectMatching() const {
+  // The Hopcroft-Karp algorithm: each iteration finds a maximal set of
+  // disjoint shortest augmenting paths, by a breadth-first search from the
+  // unmatched left nodes followed by depth-first searches in its layers.
+  const NodeIndex n = num_left_nodes_;
+  const int kUnreached = std::numeric_limits<int>::max();
+  std::vector<NodeIndex> object_owner(n, -1);
+  std::vector<ArcIndex> person_arc(n, -1);
+  std::vector<int> distance(n);
+  std::vector<ArcIndex> current_arc(n);
+  std::vector<NodeIndex> queue;
+  std::vector<NodeIndex> stack;
+  NodeIndex num_matched = 0;
+  while (true) {
+    queue.clear();
+    for (NodeIndex person = 0; person < n; ++person) {
+      if (person_arc[person] == -1) {
+        distance[person] = 0;
+        queue.push_back(person);
+      } else {
+        distance[person] = kUnreached;
+      }
+    }
+    bool found_free_object = false;
+    for (size_t i = 0; i < queue.size(); ++i) {
+      const NodeIndex person = queue[i];
+      for (const ArcIndex arc : graph_.OutgoingArcs(person)) {
+        const NodeIndex owner = object_owner[graph_.Head(arc) - n];
+        if (owner == -1) {
+          found_free_object = true;
+        } else if (distance[owner] == kUnreached) {
+          distance[owner] = distance[person] + 1;
+          queue.push_back(owner);
+        }
+      }
+    }
+    if (!found_free_object) break;
+    for (NodeIndex person = 0; person < n; ++person) {
+      current_arc[person] = *graph_.OutgoingArcs(person).begin();
+    }
+    for (NodeIndex root = 0; root < n; ++root) {
+      if (person_arc[root] != -1) continue;
+      stack.assign(1, root);
+      while (!stack.empty()) {
+        const NodeIndex person = stack.back();
+        const ArcIndex arc = current_arc[person];
+        if (arc == *graph_.OutgoingArcs(person).end()) {
+          distance[person] = kUnreached;
+          stack.pop_back();
+          if (!stack.empty()) ++current_arc[stack.back()];
+          continue;
+        }
+        const NodeIndex owner = object_owner[graph_.Head(arc) - n];
+        if (owner == -1) {
+          // Augments along the path of the stack.
+          for (const NodeIndex path_person : stack) {
+            const ArcIndex path_arc = current_arc[path_person];
+            object_owner[graph_.Head(path_arc) - n] = path_person;
+            person_arc[path_person] = path_arc;
+          }
+          ++num_matched;
+          break;
+        }
+        if (distance[owner] == distance[person] + 1) {
+          stack.push_back(owner);
+        } else {
+          ++current_arc[person];
+        }
+      }
+    }
+  }
+  return num_matched == n;
+}
+
+bool AuctionLinearSumAssignment::ComputeAssignment() {
+  success_ = false;
+  stats_ = AuctionStats();
+  const NodeIndex n = num_left_nodes_;
+  if (graph_.num_nodes() != 2 * n) {
+    LOG(DFATAL) << "The graph has " << graph_.num_nodes()
+                << " nodes instead of twice the " << n << " left nodes.";
+    return false;
+  }
+  if (!HasPerfectMatching()) return false;
+
+  // Packs the arcs of the left nodes, whose indices are consecutive in a
+  // StaticGraph, with their scaled costs.
+  const CostValue scale = n + 1;
+  std::vector<PackedArc> arcs;
+  std::vector<int> first_arc(n + 1, 0);
+  CostValue min_cost = std::numeric_limits<CostValue>::max();
+  CostValue max_cost = std::numeric_limits<CostValue>::min();
+  for (NodeIndex person = 0; person < n; ++person) {
+    first_arc[person] = arcs.size();
+    for (const ArcIndex arc : graph_.OutgoingArcs(person)) {
+      DCHECK_EQ(arc, static_cast<ArcIndex>(arcs.size()));
+      const NodeIndex head = graph_.Head(arc);
+      DCHECK_LE(n, head);
+      min_cost = std::min(min_cost, arc_cost_[arc]);
+      max_cost = std::max(max_cost, arc_cost_[arc]);
+      PackedArc packed_arc = {arc_cost_[arc], head - n};
+      arcs.push_back(packed_arc);
+    }
+  }
+  first_arc[n] = arcs.size();
+  if (n == 0) {
+    success_ = true;
+    return true;
+  }
+  const CostValue initial_epsilon =
+      InitialEpsilon(min_cost, max_cost, scale, divisor_, n);
+  if (initial_epsilon == 0) {
+    LOG(DFATAL) << "The costs are too large for the auction algorithm.";
+    return false;
+  }
+  for (PackedArc& arc : arcs) arc.scaled_cost *= scale;
+
+  SparseBidder bidder(arcs, first_arc, (max_cost - min_cost) * scale);
+  Auction<SparseBidder> auction(bidder, num_threads_, &stats_);
+  auction.Run(initial_epsilon, divisor_, &matched_arc_);
+  VLOG(1) << "Auction: " << stats_.StatsString();
+  success_ = true;
+  return true;
+}
+
+CostValue AuctionLinearSumAssignment::GetCost() const {
+  DCHECK(success_);
+  CostValue cost = 0;
+  for (NodeIndex node = 0; node < num_left_nodes_; ++node) {
+    cost += GetAssignmentCost(node);
+  }
+  return cost;
+}
+
+// ----- DenseLinearSumAssignment -----
+
+template <typename CostType>
+DenseLinearSumAssignment<CostType>::DenseLinearSumAssignment(int size)
+    : size_(size),
+      cost_(static_cast<int64>(size) * size, 0),
+      num_threads_(1),
+      divisor_(5),
+      success_(false) {}
+
+template <typename CostType>
+bool DenseLinearSumAssignment<CostType>::ComputeAssignment() {
+  success_ = false;
+  stats_ = AuctionStats();
+  if (size_ == 0) {
+    mate_.clear();
+    success_ = true;
+    return true;
+  }
+  const CostValue min_cost = *std::min_element(cost_.begin(), cost_.end());
+  const CostValue max_cost = *std::max_element(cost_.begin(), cost_.end());
+  const CostValue scale = size_ + 1;
+  const CostValue initial_epsilon =
+      InitialEpsilon(min_cost, max_cost, scale, divisor_, size_);
+  if (initial_epsilon == 0) {
+    LOG(DFATAL) << "The costs are too large for the auction algorithm.";
+    return false;
+  }
+  DenseBidder<CostType> bidder(cost_, size_, scale,
+                               (max_cost - min_cost) * scale);
+  Auction<DenseBidder<CostType> > auction(bidder, num_threads_, &stats_);
+  auction.Run(initial_epsilon, divisor_, &mate_);
+  VLOG(1) << "Auction: " << stats_.StatsString();
+  success_ = true;
+  return true;
+}
+
+template <typename CostType>
+CostValue DenseLinearSumAssignment<CostType>::GetCost() const {
+  DCHECK(success_);
+  CostValue cost = 0;
+  for (int row = 0; row < size_; ++row) cost += Cost(row, mate_[row]);
+  return cost;
+}
+
+template class DenseLinearSumAssignment<int32>;
+template class DenseLinearSumAssignment<int64>;
+
+}  // namespace operations_research
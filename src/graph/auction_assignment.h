@@ -0,0 +1,217 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Auction algorithms for the linear sum assignment problem, as an alternative
+// to the cost-scaling push-relabel algorithm of linear_assignment.h:
+// - AuctionLinearSumAssignment solves sparse problems given as a
+//   StaticGraph<>, whose arcs go from the left nodes [0, num_left_nodes) to
+//   the right nodes [num_left_nodes, 2 * num_left_nodes).
+// - DenseLinearSumAssignment solves problems given as a full square cost
+//   matrix, without building any graph. It is meant for large dense problems,
+//   for which the O(n^4) algorithm of algorithms/hungarian.h is not usable.
+//
+// The forward auction algorithm of Bertsekas maintains a price for each right
+// node (or "object") and a partial assignment. Each unassigned left node (or
+// "person") bids for the object that minimizes its cost plus its price, and
+// raises the price of this object by the difference with the second best
+// object plus epsilon. The object is then assigned to the person, and its
+// previous owner becomes unassigned. The assignment found when all the
+// persons are assigned is optimal within n * epsilon. As in
+// LinearSumAssignment, the costs are multiplied by n + 1, so that the
+// assignment is optimal once epsilon reaches 1, and epsilon is decreased
+// geometrically ("epsilon-scaling"), each phase starting from the prices of
+// the previous one.
+//
+// Both classes can compute the bids of all the unassigned persons in parallel
+// (the "Jacobi" version of the auction): the bids of a round are computed by
+// several threads with the current prices, and each object then goes to its
+// highest bidder. With a single thread, each bid is applied immediately (the
+// "Gauss-Seidel" version), which needs fewer bids.
+//
+// The data read by the bids is laid out to be scanned sequentially: the arcs
+// of each person are packed in an array of (scaled cost, object) pairs, or
+// are a row of the dense cost matrix, and the prices of the objects are in a
+// single array.
+//
+// References:
+// D. P. Bertsekas, "The Auction Algorithm: A Distributed Relaxation Method for
+// the Assignment Problem", Annals of Operations Research 14 (1988) 105-123.
+// D. P. Bertsekas, D. A. Castanon, "Parallel Synchronous and Asynchronous
+// Implementations of the Auction Algorithm", Parallel Computing 17 (1991)
+// 707-732.
+//
+// Example:
+//   StaticGraph<> graph(2 * n, num_arcs);
+//   ... add the arcs, build the graph and permute the costs.
+//   AuctionLinearSumAssignment assignment(graph, n);
+//   for (int arc = 0; arc < num_arcs; ++arc) {
+//     assignment.SetArcCost(arc, costs[arc]);
+//   }
+//   assignment.SetNumThreads(8);
+//   if (assignment.ComputeAssignment()) {
+//     ... assignment.GetCost(), assignment.GetMate(left_node) ...
+//   }
+//
+//   DenseLinearSumAssignment<int32> dense(n);
+//   for (int row = 0; row < n; ++row) {
+//     for (int column = 0; column < n; ++column) {
+//       dense.SetCost(row, column, cost[row][column]);
+//     }
+//   }
+//   CHECK(dense.ComputeAssignment());
+//
+// Keywords: linear sum assignment problem, auction algorithm, Bertsekas.
+
+#ifndef OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
+#define OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+
+namespace operations_research {
+
+// Counters of the work done by the auction algorithms.
+struct AuctionStats {
+  AuctionStats() : phases(0), rounds(0), bids(0) {}
+  std::string StatsString() const;
+
+  // Number of epsilon-scaling phases.
+  int64 phases;
+  // Number of rounds of parallel bids, or 0 with a single thread.
+  int64 rounds;
+  // Number of bids, i.e. of scans of the arcs of a person.
+  int64 bids;
+};
+
+// The auction on a sparse problem.
+class AuctionLinearSumAssignment {
+ public:
+  typedef StaticGraph<> Graph;
+  typedef Graph::NodeIndex NodeIndex;
+  typedef Graph::ArcIndex ArcIndex;
+
+  // The graph must be built, and must outlive this object. Its arcs must go
+  // from [0, num_left_nodes) to [num_left_nodes, graph.num_nodes()).
+  AuctionLinearSumAssignment(const Graph& graph, NodeIndex num_left_nodes);
+
+  // Sets the cost of an arc of the graph.
+  void SetArcCost(ArcIndex arc, CostValue cost);
+
+  // Sets the number of threads computing the bids. The default is 1.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+
+  // Sets the amount by which epsilon is divided at each phase. The default
+  // is 5.
+  void SetCostScalingDivisor(CostValue divisor) { divisor_ = divisor; }
+
+  // Computes the optimum assignment. Returns false if there is no perfect
+  // matching, or if the costs are too large to rule out an arithmetic
+  // overflow.
+  bool ComputeAssignment();
+
+  // Accessors to the optimum assignment, once ComputeAssignment() succeeded.
+  CostValue GetCost() const;
+  NodeIndex NumLeftNodes() const { return num_left_nodes_; }
+  ArcIndex GetAssignmentArc(NodeIndex left_node) const {
+    DCHECK_LT(left_node, num_left_nodes_);
+    return matched_arc_[left_node];
+  }
+  CostValue GetAssignmentCost(NodeIndex left_node) const {
+    return arc_cost_[GetAssignmentArc(left_node)];
+  }
+  NodeIndex GetMate(NodeIndex left_node) const {
+    return graph_.Head(GetAssignmentArc(left_node));
+  }
+
+  std::string StatsString() const { return stats_.StatsString(); }
+
+ private:
+  // Returns true if the graph has a perfect matching, computed by the
+  // Hopcroft-Karp algorithm. The auction does not terminate otherwise.
+  bool HasPerfectMatching() const;
+
+  const Graph& graph_;
+  const NodeIndex num_left_nodes_;
+  std::vector<CostValue> arc_cost_;
+  std::vector<ArcIndex> matched_arc_;
+  int num_threads_;
+  CostValue divisor_;
+  bool success_;
+  AuctionStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(AuctionLinearSumAssignment);
+};
+
+// The auction on a dense problem, with n persons and n objects. The cost of
+// assigning person i to object j is stored in row-major order in a matrix of
+// CostType, which can be int32 to halve the memory used by large problems.
+// This class is compiled for int32 and int64.
+template <typename CostType>
+class DenseLinearSumAssignment {
+ public:
+  explicit DenseLinearSumAssignment(int size);
+
+  int size() const { return size_; }
+
+  // Sets the cost of assigning the given row (person) to the given column
+  // (object).
+  void SetCost(int row, int column, CostType cost) {
+    DCHECK_LE(0, row);
+    DCHECK_LT(row, size_);
+    DCHECK_LE(0, column);
+    DCHECK_LT(column, size_);
+    cost_[static_cast<int64>(row) * size_ + column] = cost;
+  }
+  CostType Cost(int row, int column) const {
+    return cost_[static_cast<int64>(row) * size_ + column];
+  }
+
+  // Same as for AuctionLinearSumAssignment.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+  void SetCostScalingDivisor(CostValue divisor) { divisor_ = divisor; }
+
+  // Computes the optimum assignment. A dense problem is always feasible, so
+  // this only returns false if the costs are too large to rule out an
+  // arithmetic overflow.
+  bool ComputeAssignment();
+
+  // Accessors to the optimum assignment, once ComputeAssignment() succeeded.
+  CostValue GetCost() const;
+  int GetMate(int row) const {
+    DCHECK_LE(0, row);
+    DCHECK_LT(row, size_);
+    return mate_[row];
+  }
+
+  std::string StatsString() const { return stats_.StatsString(); }
+
+ private:
+  const int size_;
+  std::vector<CostType> cost_;
+  std::vector<int> mate_;
+  int num_threads_;
+  CostValue divisor_;
+  bool success_;
+  AuctionStats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(DenseLinearSumAssignment);
+};
+
+}  // namespace operations_research
+#endif  // OR_TOOLS_GRAPH_AUCTION_ASSIGNMENT_H_
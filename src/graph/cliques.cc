@@ -15,6 +15,7 @@
 #include "graph/cliques.h"
 
 #include <algorithm>
+#include <atomic>
 #include "base/hash.h"
 #include "base/unique_ptr.h"
 #include <utility>
@@ -22,6 +23,9 @@
 
 #include "base/callback.h"
 #include "base/hash.h"
+#include "base/mutex.h"
+#include "base/threadpool.h"
+#include "util/bitset.h"
 
 namespace operations_research {
 
@@ -278,4 +282,643 @@ void CoverArcsByCliques(
          node_count, &actual, &stop);
 }
 
+namespace {
+
+// Operations on bitsets of num_words uint64 words.
+inline bool IsEmpty(const uint64* set, int num_words) {
+  for (int i = 0; i < num_words; ++i) {
+    if (set[i] != 0) return false;
+  }
+  return true;
+}
+
+inline int Cardinality(const uint64* set, int num_words) {
+  int cardinality = 0;
+  for (int i = 0; i < num_words; ++i) cardinality += BitCount64(set[i]);
+  return cardinality;
+}
+
+inline int IntersectionCardinality(const uint64* set1, const uint64* set2,
+                                   int num_words) {
+  int cardinality = 0;
+  for (int i = 0; i < num_words; ++i) {
+    cardinality += BitCount64(set1[i] & set2[i]);
+  }
+  return cardinality;
+}
+
+inline void Intersect(const uint64* set1, const uint64* set2, int num_words,
+                      uint64* result) {
+  for (int i = 0; i < num_words; ++i) result[i] = set1[i] & set2[i];
+}
+
+// Returns the smallest element of a non-empty set.
+inline int SmallestElement(const uint64* set, int num_words) {
+  for (int i = 0;; ++i) {
+    DCHECK_LT(i, num_words);
+    if (set[i] != 0) {
+      return BitShift64(i) + LeastSignificantBitPosition64(set[i]);
+    }
+  }
+}
+
+// The state of FindMaximalCliques() shared by the threads.
+struct MaximalCliqueSearch {
+  MaximalCliqueSearch(const uint64* adjacency, int num_words,
+                      const std::vector<int>& order,
+                      const BitsetCliqueFinder::CliqueCallback& callback)
+      : adjacency(adjacency),
+        num_words(num_words),
+        order(order),
+        position(order.size()),
+        callback(callback),
+        next_branch(0),
+        stop(false),
+        num_branches(0) {
+    const int num_nodes = order.size();
+    for (int i = 0; i < num_nodes; ++i) position[order[i]] = i;
+  }
+
+  const uint64* const adjacency;
+  const int num_words;
+  // The degeneracy ordering of the nodes, and the position of each node in it.
+  const std::vector<int>& order;
+  std::vector<int> position;
+  const BitsetCliqueFinder::CliqueCallback& callback;
+  // Serializes the calls to callback.
+  Mutex callback_mutex;
+  // The position in order of the next top-level branch to explore.
+  std::atomic<int> next_branch;
+  std::atomic<bool> stop;
+  std::atomic<int64> num_branches;
+};
+
+// Explores top-level branches of FindMaximalCliques() until there are none
+// left. Each thread has its own worker. A branch only involves the neighbors
+// of its first node, whose number is small compared to the number of nodes in
+// the sparse graphs, so the worker copies the subgraph they induce, with
+// bitsets of a few words, before exploring the branch.
+class MaximalCliqueWorker {
+ public:
+  MaximalCliqueWorker(MaximalCliqueSearch* search, int max_depth)
+      : search_(search), max_depth_(max_depth), num_words_(0),
+        num_branches_(0) {}
+
+  void Run() {
+    const int num_nodes = search_->order.size();
+    while (!search_->stop) {
+      const int branch = search_->next_branch.fetch_add(1);
+      if (branch >= num_nodes) break;
+      RunBranch(branch);
+    }
+    search_->num_branches += num_branches_;
+  }
+
+ private:
+  // The candidates, the "not" set, and the candidates to branch on at the
+  // given depth, which is the size of the current clique.
+  uint64* Candidates(int depth) { return &sets_[3 * depth * num_words_]; }
+  uint64* NotSet(int depth) { return Candidates(depth) + num_words_; }
+  uint64* Branches(int depth) { return Candidates(depth) + 2 * num_words_; }
+
+  // Returns the neighbors of a node of the subgraph of the current branch.
+  const uint64* Neighbors(int node) const {
+    return &subgraph_adjacency_[node * num_words_];
+  }
+
+  // Explores the maximal cliques whose first node in the degeneracy ordering
+  // is order[branch].
+  void RunBranch(int branch) {
+    const int node = search_->order[branch];
+    const int global_num_words = search_->num_words;
+    const uint64* const neighbors =
+        search_->adjacency + node * global_num_words;
+    // The candidates are the neighbors after node in the ordering, and the
+    // "not" set the neighbors before it.
+    subgraph_nodes_.clear();
+    std::vector<bool> is_candidate;
+    for (int word = 0; word < global_num_words; ++word) {
+      for (uint64 bits = neighbors[word]; bits != 0; bits &= bits - 1) {
+        const int neighbor =
+            BitShift64(word) + LeastSignificantBitPosition64(bits);
+        subgraph_nodes_.push_back(neighbor);
+        is_candidate.push_back(search_->position[neighbor] > branch);
+      }
+    }
+    const int num_subgraph_nodes = subgraph_nodes_.size();
+    num_words_ = BitLength64(num_subgraph_nodes);
+    // The arcs between two nodes of the "not" set are not needed.
+    subgraph_adjacency_.assign(num_subgraph_nodes * num_words_, 0);
+    for (int i = 0; i < num_subgraph_nodes; ++i) {
+      const uint64* const row =
+          search_->adjacency + subgraph_nodes_[i] * global_num_words;
+      for (int j = 0; j < i; ++j) {
+        if ((is_candidate[i] || is_candidate[j]) &&
+            IsBitSet64(row, subgraph_nodes_[j])) {
+          SetBit64(&subgraph_adjacency_[i * num_words_], j);
+          SetBit64(&subgraph_adjacency_[j * num_words_], i);
+        }
+      }
+    }
+    sets_.resize(3 * (max_depth_ + 1) * num_words_);
+    uint64* const candidates = Candidates(1);
+    uint64* const not_set = NotSet(1);
+    for (int i = 0; i < num_words_; ++i) {
+      candidates[i] = 0;
+      not_set[i] = 0;
+    }
+    for (int i = 0; i < num_subgraph_nodes; ++i) {
+      SetBit64(is_candidate[i] ? candidates : not_set, i);
+    }
+    clique_.assign(1, node);
+    Expand(1);
+  }
+
+  // The recursive step of the algorithm, with the current clique in clique_
+  // and its candidates and "not" set at the given depth.
+  void Expand(int depth) {
+    ++num_branches_;
+    uint64* const candidates = Candidates(depth);
+    uint64* const not_set = NotSet(depth);
+    const int num_candidates = Cardinality(candidates, num_words_);
+    if (num_candidates == 0) {
+      if (IsEmpty(not_set, num_words_)) ReportClique();
+      return;
+    }
+    // The pivot is the node of candidates u not_set with the most neighbors
+    // in candidates. Only the candidates which are not neighbors of the pivot
+    // need to be branched on.
+    int pivot = -1;
+    int max_num_neighbors = -1;
+    for (int word = 0; word < num_words_ && max_num_neighbors < num_candidates;
+         ++word) {
+      for (uint64 bits = candidates[word] | not_set[word]; bits != 0;
+           bits &= bits - 1) {
+        const int node = BitShift64(word) + LeastSignificantBitPosition64(bits);
+        const int num_neighbors =
+            IntersectionCardinality(candidates, Neighbors(node), num_words_);
+        if (num_neighbors > max_num_neighbors) {
+          pivot = node;
+          max_num_neighbors = num_neighbors;
+          if (max_num_neighbors == num_candidates) break;
+        }
+      }
+    }
+    uint64* const branches = Branches(depth);
+    const uint64* const pivot_neighbors = Neighbors(pivot);
+    for (int i = 0; i < num_words_; ++i) {
+      branches[i] = candidates[i] & ~pivot_neighbors[i];
+    }
+    for (int word = 0; word < num_words_; ++word) {
+      for (uint64 bits = branches[word]; bits != 0; bits &= bits - 1) {
+        const int node = BitShift64(word) + LeastSignificantBitPosition64(bits);
+        const uint64* const neighbors = Neighbors(node);
+        Intersect(candidates, neighbors, num_words_, Candidates(depth + 1));
+        Intersect(not_set, neighbors, num_words_, NotSet(depth + 1));
+        clique_.push_back(subgraph_nodes_[node]);
+        Expand(depth + 1);
+        clique_.pop_back();
+        if (search_->stop) return;
+        ClearBit64(candidates, node);
+        SetBit64(not_set, node);
+      }
+    }
+  }
+
+  void ReportClique() {
+    MutexLock lock(&search_->callback_mutex);
+    if (search_->stop) return;
+    if (search_->callback(clique_) == CliqueResponse::STOP) {
+      search_->stop = true;
+    }
+  }
+
+  MaximalCliqueSearch* const search_;
+  const int max_depth_;
+  // The nodes of the subgraph of the current branch, and its adjacency
+  // matrix, with num_words_ words per node.
+  std::vector<int> subgraph_nodes_;
+  int num_words_;
+  std::vector<uint64> subgraph_adjacency_;
+  // The sets of each depth of the search, see Candidates().
+  std::vector<uint64> sets_;
+  // The current clique, with the original indices of the nodes.
+  std::vector<int> clique_;
+  int64 num_branches_;
+
+  DISALLOW_COPY_AND_ASSIGN(MaximalCliqueWorker);
+};
+
+void RunMaximalCliqueWorker(MaximalCliqueSearch* search, int max_depth) {
+  MaximalCliqueWorker worker(search, max_depth);
+  worker.Run();
+}
+
+// The state of FindMaximumClique() shared by the threads. The nodes are
+// renumbered so that the coloring considers them in a fixed initial order.
+struct MaximumCliqueSearch {
+  MaximumCliqueSearch(int num_nodes, int num_words)
+      : num_nodes(num_nodes),
+        num_words(num_words),
+        adjacency(num_nodes * num_words),
+        next_branch(0),
+        best_size(0),
+        num_branches(0) {}
+
+  const int num_nodes;
+  const int num_words;
+  // The adjacency matrix with the renumbered nodes.
+  std::vector<uint64> adjacency;
+  // The top-level branches, on the nodes in root_nodes, explored by
+  // decreasing index, and the color bounds of these nodes.
+  std::vector<int> root_nodes;
+  std::vector<int> root_colors;
+  std::atomic<int> next_branch;
+  // The size of best_clique, which can be read without locking mutex.
+  std::atomic<int> best_size;
+  Mutex mutex;
+  std::vector<int> best_clique;
+  std::atomic<int64> num_branches;
+};
+
+// Explores top-level branches of FindMaximumClique() until there are none
+// left, or until the color bounds show that the best clique is maximum.
+class MaximumCliqueWorker {
+ public:
+  MaximumCliqueWorker(MaximumCliqueSearch* search, int max_depth)
+      : search_(search),
+        num_words_(search->num_words),
+        sets_(3 * (max_depth + 1) * search->num_words),
+        nodes_(max_depth + 1),
+        colors_(max_depth + 1),
+        num_branches_(0) {}
+
+  void Run() {
+    const int num_root_nodes = search_->root_nodes.size();
+    while (true) {
+      const int branch = num_root_nodes - 1 - search_->next_branch.fetch_add(1);
+      // The color bounds are sorted, so the other branches are pruned too.
+      if (branch < 0 || search_->root_colors[branch] <= search_->best_size) {
+        break;
+      }
+      RunBranch(branch);
+    }
+    search_->num_branches += num_branches_;
+  }
+
+  // Colors the root of the search, whose candidates are all the nodes, and
+  // sets the top-level branches in search_.
+  void ColorRoot() {
+    uint64* const candidates = Candidates(0);
+    for (int i = 0; i < num_words_; ++i) candidates[i] = 0;
+    for (int node = 0; node < search_->num_nodes; ++node) {
+      SetBit64(candidates, node);
+    }
+    clique_.clear();
+    ColorCandidates(0);
+    search_->root_nodes = nodes_[0];
+    search_->root_colors = colors_[0];
+  }
+
+ private:
+  // Sets in nodes_[depth] the candidates at the given depth, with their
+  // color bounds in colors_[depth], by increasing color. A greedy coloring
+  // takes the candidates in increasing order, and builds one color class at
+  // a time. The candidates whose color is too small for them to be in a
+  // larger clique than the best one are left out.
+  void ColorCandidates(int depth) {
+    const uint64* const candidates = Candidates(depth);
+    uint64* const uncolored = Uncolored(depth);
+    uint64* const colorable = Colorable(depth);
+    std::vector<int>* const nodes = &nodes_[depth];
+    std::vector<int>* const colors = &colors_[depth];
+    nodes->clear();
+    colors->clear();
+    const int clique_size = clique_.size();
+    const int min_color = search_->best_size - clique_size + 1;
+    for (int i = 0; i < num_words_; ++i) uncolored[i] = candidates[i];
+    int first_word = 0;
+    for (int color = 1;; ++color) {
+      while (first_word < num_words_ && uncolored[first_word] == 0) {
+        ++first_word;
+      }
+      if (first_word == num_words_) break;
+      for (int i = first_word; i < num_words_; ++i) colorable[i] = uncolored[i];
+      for (int word = first_word; word < num_words_; ++word) {
+        while (colorable[word] != 0) {
+          const int node =
+              BitShift64(word) + LeastSignificantBitPosition64(colorable[word]);
+          // The neighbors of node cannot have the same color.
+          const uint64* const neighbors = Neighbors(node);
+          for (int i = word; i < num_words_; ++i) colorable[i] &= ~neighbors[i];
+          colorable[word] &= colorable[word] - 1;
+          ClearBit64(uncolored, node);
+          if (color >= min_color) {
+            nodes->push_back(node);
+            colors->push_back(color);
+          }
+        }
+      }
+    }
+  }
+
+  // The candidates at the given depth, which is the size of the current
+  // clique, and the work sets of ColorCandidates().
+  uint64* Candidates(int depth) { return &sets_[3 * depth * num_words_]; }
+  // The work sets of ColorCandidates() at the given depth.
+  uint64* Uncolored(int depth) { return Candidates(depth) + num_words_; }
+  uint64* Colorable(int depth) { return Candidates(depth) + 2 * num_words_; }
+
+  const uint64* Neighbors(int node) const {
+    return search_->adjacency.data() + node * num_words_;
+  }
+
+  // Explores the cliques containing root_nodes[branch], and not containing
+  // the root nodes with a larger index.
+  void RunBranch(int branch) {
+    const int node = search_->root_nodes[branch];
+    uint64* const candidates = Candidates(1);
+    const uint64* const neighbors = Neighbors(node);
+    for (int i = 0; i < num_words_; ++i) candidates[i] = neighbors[i];
+    const int num_root_nodes = search_->root_nodes.size();
+    for (int i = branch + 1; i < num_root_nodes; ++i) {
+      ClearBit64(candidates, search_->root_nodes[i]);
+    }
+    clique_.assign(1, node);
+    if (IsEmpty(candidates, num_words_)) {
+      UpdateBestClique();
+    } else {
+      Expand(1);
+    }
+  }
+
+  // The recursive step of the algorithm, with the current clique in clique_
+  // and its non-empty set of candidates at the given depth.
+  void Expand(int depth) {
+    ++num_branches_;
+    ColorCandidates(depth);
+    uint64* const candidates = Candidates(depth);
+    const std::vector<int>& nodes = nodes_[depth];
+    const std::vector<int>& colors = colors_[depth];
+    const int clique_size = clique_.size();
+    for (int i = nodes.size() - 1; i >= 0; --i) {
+      if (clique_size + colors[i] <= search_->best_size) return;
+      const int node = nodes[i];
+      uint64* const new_candidates = Candidates(depth + 1);
+      Intersect(candidates, Neighbors(node), num_words_, new_candidates);
+      clique_.push_back(node);
+      if (IsEmpty(new_candidates, num_words_)) {
+        UpdateBestClique();
+      } else {
+        Expand(depth + 1);
+      }
+      clique_.pop_back();
+      ClearBit64(candidates, node);
+    }
+  }
+
+  void UpdateBestClique() {
+    const int clique_size = clique_.size();
+    if (clique_size <= search_->best_size) return;
+    MutexLock lock(&search_->mutex);
+    if (clique_size <= search_->best_size) return;
+    search_->best_clique = clique_;
+    search_->best_size = clique_size;
+  }
+
+  MaximumCliqueSearch* const search_;
+  const int num_words_;
+  // The sets of each depth of the search, see Candidates().
+  std::vector<uint64> sets_;
+  std::vector<std::vector<int>> nodes_;
+  std::vector<std::vector<int>> colors_;
+  std::vector<int> clique_;
+  int64 num_branches_;
+
+  DISALLOW_COPY_AND_ASSIGN(MaximumCliqueWorker);
+};
+
+void RunMaximumCliqueWorker(MaximumCliqueSearch* search, int max_depth) {
+  MaximumCliqueWorker worker(search, max_depth);
+  worker.Run();
+}
+
+}  // namespace
+
+BitsetCliqueFinder::BitsetCliqueFinder(int num_nodes)
+    : num_nodes_(num_nodes),
+      num_words_(BitLength64(num_nodes)),
+      adjacency_(static_cast<size_t>(num_nodes) * num_words_, 0),
+      num_threads_(1),
+      num_branches_(0) {}
+
+void BitsetCliqueFinder::AddArc(int node1, int node2) {
+  DCHECK_LE(0, node1);
+  DCHECK_LT(node1, num_nodes_);
+  DCHECK_LE(0, node2);
+  DCHECK_LT(node2, num_nodes_);
+  if (node1 == node2) return;
+  SetBit64(&adjacency_[node1 * num_words_], node2);
+  SetBit64(&adjacency_[node2 * num_words_], node1);
+}
+
+bool BitsetCliqueFinder::IsArc(int node1, int node2) const {
+  return IsBitSet64(&adjacency_[node1 * num_words_], node2);
+}
+
+int BitsetCliqueFinder::Degree(int node) const {
+  return Cardinality(&adjacency_[node * num_words_], num_words_);
+}
+
+std::vector<int> BitsetCliqueFinder::DegeneracyOrdering(int* degeneracy) const {
+  // The algorithm of Batagelj and Zaversnik: the nodes which are not removed
+  // yet are kept sorted by their degree in the remaining graph, in buckets
+  // delimited by bucket_start. When a node is removed, each of its remaining
+  // neighbors is swapped with the first node of its bucket, which then starts
+  // one position later, so that the neighbor moves to the previous bucket.
+  std::vector<int> degree(num_nodes_);
+  int max_degree = 0;
+  for (int node = 0; node < num_nodes_; ++node) {
+    degree[node] = Degree(node);
+    max_degree = std::max(max_degree, degree[node]);
+  }
+  std::vector<int> bucket_start(max_degree + 2, 0);
+  for (int node = 0; node < num_nodes_; ++node) {
+    ++bucket_start[degree[node] + 1];
+  }
+  for (int d = 1; d <= max_degree + 1; ++d) {
+    bucket_start[d] += bucket_start[d - 1];
+  }
+  std::vector<int> order(num_nodes_);
+  std::vector<int> position(num_nodes_);
+  {
+    std::vector<int> next(bucket_start.begin(), bucket_start.end() - 1);
+    for (int node = 0; node < num_nodes_; ++node) {
+      position[node] = next[degree[node]]++;
+      order[position[node]] = node;
+    }
+  }
+  int max_core = 0;
+  for (int i = 0; i < num_nodes_; ++i) {
+    const int node = order[i];
+    max_core = std::max(max_core, degree[node]);
+    const uint64* const neighbors = &adjacency_[node * num_words_];
+    for (int word = 0; word < num_words_; ++word) {
+      for (uint64 bits = neighbors[word]; bits != 0; bits &= bits - 1) {
+        const int neighbor =
+            BitShift64(word) + LeastSignificantBitPosition64(bits);
+        if (position[neighbor] <= i) continue;
+        // Moves neighbor to the front of its bucket, and the front of the
+        // bucket to the previous bucket.
+        const int d = degree[neighbor];
+        const int front = std::max(bucket_start[d], i + 1);
+        const int front_node = order[front];
+        std::swap(order[front], order[position[neighbor]]);
+        position[front_node] = position[neighbor];
+        position[neighbor] = front;
+        bucket_start[d] = front + 1;
+        --degree[neighbor];
+      }
+    }
+  }
+  if (degeneracy != nullptr) *degeneracy = max_core;
+  return order;
+}
+
+BronKerboschAlgorithmStatus BitsetCliqueFinder::FindMaximalCliques(
+    const CliqueCallback& callback) {
+  int degeneracy = 0;
+  const std::vector<int> order = DegeneracyOrdering(&degeneracy);
+  MaximalCliqueSearch search(adjacency_.data(), num_words_, order, callback);
+  // A clique has at most degeneracy + 1 nodes.
+  const int max_depth = degeneracy + 2;
+  if (num_threads_ <= 1) {
+    RunMaximalCliqueWorker(&search, max_depth);
+  } else {
+    ThreadPool pool("BitsetCliqueFinder", num_threads_);
+    pool.StartWorkers();
+    for (int i = 0; i < num_threads_; ++i) {
+      pool.Add(NewCallback(&RunMaximalCliqueWorker, &search, max_depth));
+    }
+  }
+  num_branches_ = search.num_branches;
+  return search.stop ? BronKerboschAlgorithmStatus::INTERRUPTED
+                     : BronKerboschAlgorithmStatus::COMPLETED;
+}
+
+std::vector<int> BitsetCliqueFinder::FindMaximumClique() {
+  num_branches_ = 0;
+  if (num_nodes_ == 0) return std::vector<int>();
+  // The nodes are renumbered in the reverse of a degeneracy ordering, so that
+  // the coloring first considers the nodes of the densest part of the graph.
+  int degeneracy = 0;
+  std::vector<int> original_node = DegeneracyOrdering(&degeneracy);
+  std::reverse(original_node.begin(), original_node.end());
+  std::vector<int> new_node(num_nodes_);
+  for (int i = 0; i < num_nodes_; ++i) new_node[original_node[i]] = i;
+  MaximumCliqueSearch search(num_nodes_, num_words_);
+  for (int node = 0; node < num_nodes_; ++node) {
+    const uint64* const neighbors = &adjacency_[node * num_words_];
+    uint64* const new_neighbors =
+        &search.adjacency[new_node[node] * num_words_];
+    for (int word = 0; word < num_words_; ++word) {
+      for (uint64 bits = neighbors[word]; bits != 0; bits &= bits - 1) {
+        SetBit64(new_neighbors,
+                 new_node[BitShift64(word) +
+                          LeastSignificantBitPosition64(bits)]);
+      }
+    }
+  }
+
+  // A greedy clique gives a first lower bound.
+  {
+    std::vector<uint64> candidates(search.adjacency.begin(),
+                                   search.adjacency.begin() + num_words_);
+    search.best_clique.assign(1, 0);
+    while (!IsEmpty(candidates.data(), num_words_)) {
+      const int node = SmallestElement(candidates.data(), num_words_);
+      search.best_clique.push_back(node);
+      Intersect(candidates.data(), &search.adjacency[node * num_words_],
+                num_words_, candidates.data());
+    }
+    search.best_size = search.best_clique.size();
+  }
+
+  // The root of the search is colored once, its branches are then explored
+  // by the threads.
+  const int max_depth = degeneracy + 2;
+  {
+    MaximumCliqueWorker root(&search, max_depth);
+    root.ColorRoot();
+  }
+  if (num_threads_ <= 1) {
+    RunMaximumCliqueWorker(&search, max_depth);
+  } else {
+    ThreadPool pool("BitsetCliqueFinder", num_threads_);
+    pool.StartWorkers();
+    for (int i = 0; i < num_threads_; ++i) {
+      pool.Add(NewCallback(&RunMaximumCliqueWorker, &search, max_depth));
+    }
+  }
+  num_branches_ = search.num_branches;
+  std::vector<int> clique;
+  for (const int node : search.best_clique) {
+    clique.push_back(original_node[node]);
+  }
+  std::sort(clique.begin(), clique.end());
+  return clique;
+}
+
+BronKerboschAlgorithmStatus BitsetCliqueFinder::CoverArcsByCliques(
+    const CliqueCallback& callback) {
+  // The neighbors of each node to which its arcs are not covered yet, stored
+  // as in adjacency_.
+  std::vector<uint64> uncovered(adjacency_);
+  // The candidates to extend the current clique, and the nodes with an arc
+  // to the clique which is not covered yet.
+  std::vector<uint64> candidates(num_words_);
+  std::vector<uint64> preferred(num_words_);
+  std::vector<uint64> preferred_candidates(num_words_);
+  std::vector<int> clique;
+  for (int node = 0; node < num_nodes_; ++node) {
+    const uint64* const uncovered_neighbors = &uncovered[node * num_words_];
+    while (!IsEmpty(uncovered_neighbors, num_words_)) {
+      const int neighbor = SmallestElement(uncovered_neighbors, num_words_);
+      clique.clear();
+      clique.push_back(node);
+      clique.push_back(neighbor);
+      Intersect(&adjacency_[node * num_words_],
+                &adjacency_[neighbor * num_words_], num_words_,
+                candidates.data());
+      for (int i = 0; i < num_words_; ++i) {
+        preferred[i] = uncovered[node * num_words_ + i] |
+                       uncovered[neighbor * num_words_ + i];
+      }
+      while (!IsEmpty(candidates.data(), num_words_)) {
+        Intersect(candidates.data(), preferred.data(), num_words_,
+                  preferred_candidates.data());
+        const int next =
+            IsEmpty(preferred_candidates.data(), num_words_)
+                ? SmallestElement(candidates.data(), num_words_)
+                : SmallestElement(preferred_candidates.data(), num_words_);
+        clique.push_back(next);
+        Intersect(candidates.data(), &adjacency_[next * num_words_],
+                  num_words_, candidates.data());
+        for (int i = 0; i < num_words_; ++i) {
+          preferred[i] |= uncovered[next * num_words_ + i];
+        }
+      }
+      for (const int node1 : clique) {
+        for (const int node2 : clique) {
+          ClearBit64(&uncovered[node1 * num_words_], node2);
+        }
+      }
+      if (callback(clique) == CliqueResponse::STOP) {
+        return BronKerboschAlgorithmStatus::INTERRUPTED;
+      }
+    }
+  }
+  return BronKerboschAlgorithmStatus::COMPLETED;
+}
+
 }  // namespace operations_research
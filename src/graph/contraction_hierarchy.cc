@@ -0,0 +1,822 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "graph/contraction_hierarchy.h"
+
+#if !defined(_MSC_VER)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include "base/unique_ptr.h"
+
+#include "base/callback.h"
+#include "base/file.h"
+#include "base/logging.h"
+#include "base/threadpool.h"
+
+namespace operations_research {
+
+namespace {
+
+typedef ContractionHierarchy::NodeIndex NodeIndex;
+
+// ----- Preprocessing -----
+
+// An arc of the graph being contracted, seen from one of its endpoints.
+struct BuilderArc {
+  BuilderArc(NodeIndex n, int64 l) : node(n), length(l) {}
+  NodeIndex node;
+  int64 length;
+};
+
+struct Shortcut {
+  Shortcut(NodeIndex t, NodeIndex h, int64 l) : tail(t), head(h), length(l) {}
+  NodeIndex tail;
+  NodeIndex head;
+  int64 length;
+};
+
+// Contracts the nodes of a graph one by one. The remaining (i.e. not yet
+// contracted) graph is stored as adjacency lists in both directions, so that
+// the arcs of a node are exactly its upward and downward arcs in the hierarchy
+// when it is contracted.
+//
+// The next node to contract is the one with the smallest priority, which is
+// its "edge difference" (the number of shortcuts its contraction adds minus
+// the number of arcs it removes) plus its number of already contracted
+// neighbors, to spread the contractions uniformly over the graph. The
+// priorities are lazily updated: the contraction of a node only increases the
+// priority of its neighbors by one, and the priority of the best node is fully
+// recomputed before contracting it, the node being put back in the queue if it
+// is no longer the best. Recomputing the edge difference of all the neighbors
+// after each contraction gives slightly fewer shortcuts, but makes the
+// preprocessing several times slower.
+class HierarchyBuilder {
+ public:
+  HierarchyBuilder(const ContractionHierarchy::Graph& graph,
+                   const std::vector<int64>& arc_lengths,
+                   int witness_search_settle_limit);
+
+  // Contracts all the nodes and fills, for each node, its upward arcs and the
+  // downward arcs entering it (given by their tail).
+  void Run(std::vector<std::vector<BuilderArc> >* upward,
+           std::vector<std::vector<BuilderArc> >* downward);
+
+ private:
+  // Fills shortcuts_ with the shortcuts needed to contract node, and returns
+  // the priority of node.
+  int64 ComputeShortcutsAndPriority(NodeIndex node);
+
+  // Runs Dijkstra's algorithm from source in the remaining graph without
+  // excluded, until all the nodes closer than max_distance, all the nodes
+  // marked in is_witness_target_ or witness_search_settle_limit_ nodes are
+  // settled. witness_distance_ then contains the length of a path from source
+  // to each node it reached.
+  void WitnessSearch(NodeIndex source, NodeIndex excluded, int64 max_distance,
+                     int num_targets);
+
+  static void AddOrShortenArc(NodeIndex node, int64 length,
+                              std::vector<BuilderArc>* arcs);
+  static void RemoveArcs(NodeIndex node, std::vector<BuilderArc>* arcs);
+
+  const NodeIndex num_nodes_;
+  const int witness_search_settle_limit_;
+  std::vector<std::vector<BuilderArc> > outgoing_;
+  std::vector<std::vector<BuilderArc> > incoming_;
+  std::vector<int> num_contracted_neighbors_;
+
+  std::vector<Shortcut> shortcuts_;
+
+  std::vector<int64> witness_distance_;
+  std::vector<bool> witness_is_settled_;
+  std::vector<bool> is_witness_target_;
+  std::vector<NodeIndex> witness_touched_nodes_;
+  RadixHeap<NodeIndex> witness_queue_;
+
+  DISALLOW_COPY_AND_ASSIGN(HierarchyBuilder);
+};
+
+HierarchyBuilder::HierarchyBuilder(const ContractionHierarchy::Graph& graph,
+                                   const std::vector<int64>& arc_lengths,
+                                   int witness_search_settle_limit)
+    : num_nodes_(graph.num_nodes()),
+      witness_search_settle_limit_(witness_search_settle_limit),
+      outgoing_(num_nodes_),
+      incoming_(num_nodes_),
+      num_contracted_neighbors_(num_nodes_, 0),
+      witness_distance_(num_nodes_, kUnreachableDistance),
+      witness_is_settled_(num_nodes_, false),
+      is_witness_target_(num_nodes_, false) {
+  // Only the shortest of parallel arcs is kept, and loops are useless.
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    for (const ContractionHierarchy::Graph::ArcIndex arc :
+         graph.OutgoingArcs(node)) {
+      DCHECK_GE(arc_lengths[arc], 0);
+      const NodeIndex head = graph.Head(arc);
+      if (head == node) continue;
+      AddOrShortenArc(head, arc_lengths[arc], &outgoing_[node]);
+      AddOrShortenArc(node, arc_lengths[arc], &incoming_[head]);
+    }
+  }
+}
+
+void HierarchyBuilder::Run(std::vector<std::vector<BuilderArc> >* upward,
+                           std::vector<std::vector<BuilderArc> >* downward) {
+  upward->assign(num_nodes_, std::vector<BuilderArc>());
+  downward->assign(num_nodes_, std::vector<BuilderArc>());
+  typedef std::pair<int64, NodeIndex> QueueElement;
+  std::priority_queue<QueueElement, std::vector<QueueElement>,
+                      std::greater<QueueElement> > queue;
+  std::vector<int64> priority(num_nodes_);
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    priority[node] = ComputeShortcutsAndPriority(node);
+    queue.push(QueueElement(priority[node], node));
+  }
+  std::vector<bool> is_contracted(num_nodes_, false);
+  std::vector<NodeIndex> neighbors;
+  while (!queue.empty()) {
+    const NodeIndex node = queue.top().second;
+    const int64 node_priority = queue.top().first;
+    queue.pop();
+    // Skip the outdated elements.
+    if (is_contracted[node] || node_priority != priority[node]) continue;
+    priority[node] = ComputeShortcutsAndPriority(node);
+    if (!queue.empty() && priority[node] > queue.top().first) {
+      queue.push(QueueElement(priority[node], node));
+      continue;
+    }
+
+    // Contract node: its remaining arcs become its arcs in the hierarchy, and
+    // they are replaced by the shortcuts in the remaining graph.
+    is_contracted[node] = true;
+    neighbors.clear();
+    for (const BuilderArc& arc : incoming_[node]) {
+      RemoveArcs(node, &outgoing_[arc.node]);
+      neighbors.push_back(arc.node);
+    }
+    for (const BuilderArc& arc : outgoing_[node]) {
+      RemoveArcs(node, &incoming_[arc.node]);
+      neighbors.push_back(arc.node);
+    }
+    for (const Shortcut& shortcut : shortcuts_) {
+      AddOrShortenArc(shortcut.head, shortcut.length,
+                      &outgoing_[shortcut.tail]);
+      AddOrShortenArc(shortcut.tail, shortcut.length,
+                      &incoming_[shortcut.head]);
+    }
+    (*upward)[node].swap(outgoing_[node]);
+    (*downward)[node].swap(incoming_[node]);
+    std::vector<BuilderArc>().swap(outgoing_[node]);
+    std::vector<BuilderArc>().swap(incoming_[node]);
+
+    std::sort(neighbors.begin(), neighbors.end());
+    neighbors.erase(std::unique(neighbors.begin(), neighbors.end()),
+                    neighbors.end());
+    for (const NodeIndex neighbor : neighbors) {
+      ++num_contracted_neighbors_[neighbor];
+      ++priority[neighbor];
+      queue.push(QueueElement(priority[neighbor], neighbor));
+    }
+  }
+}
+
+int64 HierarchyBuilder::ComputeShortcutsAndPriority(NodeIndex node) {
+  shortcuts_.clear();
+  const std::vector<BuilderArc>& outgoing = outgoing_[node];
+  for (const BuilderArc& in_arc : incoming_[node]) {
+    int64 max_out_length = -1;
+    int num_targets = 0;
+    for (const BuilderArc& out_arc : outgoing) {
+      if (out_arc.node == in_arc.node) continue;
+      max_out_length = std::max(max_out_length, out_arc.length);
+      is_witness_target_[out_arc.node] = true;
+      ++num_targets;
+    }
+    if (num_targets == 0) continue;
+    WitnessSearch(in_arc.node, node, in_arc.length + max_out_length,
+                  num_targets);
+    for (const BuilderArc& out_arc : outgoing) {
+      is_witness_target_[out_arc.node] = false;
+      if (out_arc.node == in_arc.node) continue;
+      const int64 length = in_arc.length + out_arc.length;
+      if (witness_distance_[out_arc.node] > length) {
+        shortcuts_.push_back(Shortcut(in_arc.node, out_arc.node, length));
+      }
+    }
+  }
+  const int64 num_removed_arcs = incoming_[node].size() + outgoing.size();
+  return static_cast<int64>(shortcuts_.size()) - num_removed_arcs +
+         num_contracted_neighbors_[node];
+}
+
+void HierarchyBuilder::WitnessSearch(NodeIndex source, NodeIndex excluded,
+                                     int64 max_distance, int num_targets) {
+  for (const NodeIndex node : witness_touched_nodes_) {
+    witness_distance_[node] = kUnreachableDistance;
+    witness_is_settled_[node] = false;
+  }
+  witness_touched_nodes_.clear();
+  witness_queue_.Clear();
+  witness_distance_[source] = 0;
+  witness_touched_nodes_.push_back(source);
+  witness_queue_.Push(0, source);
+  int num_settled = 0;
+  while (!witness_queue_.IsEmpty() &&
+         num_settled < witness_search_settle_limit_) {
+    const NodeIndex node = witness_queue_.Top();
+    if (static_cast<int64>(witness_queue_.TopKey()) > max_distance) break;
+    witness_queue_.Pop();
+    if (witness_is_settled_[node]) continue;
+    witness_is_settled_[node] = true;
+    ++num_settled;
+    if (is_witness_target_[node] && --num_targets == 0) break;
+    const int64 node_distance = witness_distance_[node];
+    for (const BuilderArc& arc : outgoing_[node]) {
+      if (arc.node == excluded) continue;
+      const int64 head_distance = node_distance + arc.length;
+      if (head_distance < witness_distance_[arc.node]) {
+        if (witness_distance_[arc.node] == kUnreachableDistance) {
+          witness_touched_nodes_.push_back(arc.node);
+        }
+        witness_distance_[arc.node] = head_distance;
+        witness_queue_.Push(head_distance, arc.node);
+      }
+    }
+  }
+}
+
+void HierarchyBuilder::AddOrShortenArc(NodeIndex node, int64 length,
+                                       std::vector<BuilderArc>* arcs) {
+  for (BuilderArc& arc : *arcs) {
+    if (arc.node == node) {
+      arc.length = std::min(arc.length, length);
+      return;
+    }
+  }
+  arcs->push_back(BuilderArc(node, length));
+}
+
+void HierarchyBuilder::RemoveArcs(NodeIndex node,
+                                  std::vector<BuilderArc>* arcs) {
+  for (size_t i = 0; i < arcs->size(); ++i) {
+    if ((*arcs)[i].node == node) {
+      (*arcs)[i] = arcs->back();
+      arcs->pop_back();
+      return;
+    }
+  }
+}
+
+// Flattens the adjacency lists of the hierarchy into compressed arrays.
+void FlattenArcs(const std::vector<std::vector<BuilderArc> >& arcs,
+                 std::vector<int64>* starts, std::vector<int64>* lengths,
+                 std::vector<NodeIndex>* heads) {
+  starts->assign(1, 0);
+  lengths->clear();
+  heads->clear();
+  for (const std::vector<BuilderArc>& node_arcs : arcs) {
+    for (const BuilderArc& arc : node_arcs) {
+      heads->push_back(arc.node);
+      lengths->push_back(arc.length);
+    }
+    starts->push_back(heads->size());
+  }
+}
+
+// ----- File format -----
+//
+// A hierarchy file is made of a fixed-size header followed by the arrays of
+// ContractionHierarchy, each one starting on an 8-byte boundary and stored in
+// the native byte order of the machine that wrote the file (this is checked on
+// loading): the upward starts, lengths and heads, then the downward starts,
+// lengths and heads.
+
+const char kFileMagic[8] = {'O', 'R', 'C', 'H', 'I', 'E', 'R', 'A'};
+
+// Written as is in the header, it allows to detect a file written on a machine
+// with a different byte order.
+const uint32 kByteOrderMark = 0x01020304;
+
+const int64 kSectionAlignment = 8;
+
+struct FileHeader {
+  char magic[8];
+  uint32 version;
+  uint32 byte_order_mark;
+  int64 num_nodes;
+  int64 num_upward_arcs;
+  int64 num_downward_arcs;
+};
+static_assert(sizeof(FileHeader) % kSectionAlignment == 0,
+              "The file header size must be a multiple of the alignment.");
+
+enum FileSection {
+  UPWARD_STARTS = 0,
+  UPWARD_LENGTHS,
+  UPWARD_HEADS,
+  DOWNWARD_STARTS,
+  DOWNWARD_LENGTHS,
+  DOWNWARD_HEADS,
+  NUM_SECTIONS
+};
+
+int64 RoundUpToAlignment(int64 size) {
+  return (size + kSectionAlignment - 1) / kSectionAlignment *
+         kSectionAlignment;
+}
+
+// Fills offsets with the byte offset of each section, plus a last one which is
+// the expected file size.
+void ComputeSectionOffsets(const FileHeader& header,
+                           std::vector<int64>* offsets) {
+  int64 sizes[NUM_SECTIONS];
+  sizes[UPWARD_STARTS] = (header.num_nodes + 1) * sizeof(int64);
+  sizes[UPWARD_LENGTHS] = header.num_upward_arcs * sizeof(int64);
+  sizes[UPWARD_HEADS] = header.num_upward_arcs * sizeof(NodeIndex);
+  sizes[DOWNWARD_STARTS] = (header.num_nodes + 1) * sizeof(int64);
+  sizes[DOWNWARD_LENGTHS] = header.num_downward_arcs * sizeof(int64);
+  sizes[DOWNWARD_HEADS] = header.num_downward_arcs * sizeof(NodeIndex);
+  offsets->resize(NUM_SECTIONS + 1);
+  int64 offset = sizeof(FileHeader);
+  for (int i = 0; i < NUM_SECTIONS; ++i) {
+    (*offsets)[i] = offset;
+    offset += RoundUpToAlignment(sizes[i]);
+  }
+  (*offsets)[NUM_SECTIONS] = offset;
+}
+
+// Returns true if starts and heads describe num_nodes valid adjacency lists
+// with num_arcs arcs in total.
+bool AreArcsValid(const int64* starts, const NodeIndex* heads,
+                  int64 num_nodes, int64 num_arcs) {
+  if (starts[0] != 0 || starts[num_nodes] != num_arcs) return false;
+  for (int64 node = 0; node < num_nodes; ++node) {
+    if (starts[node + 1] < starts[node]) return false;
+  }
+  for (int64 arc = 0; arc < num_arcs; ++arc) {
+    if (heads[arc] < 0 || heads[arc] >= num_nodes) return false;
+  }
+  return true;
+}
+
+// ----- Distance tables -----
+
+// The distance from a node to a target, stored in the bucket of the node.
+struct BucketEntry {
+  int target_index;
+  int64 distance;
+};
+
+// The data shared by the threads of ComputeDistanceTable().
+struct DistanceTableData {
+  const ContractionHierarchy* hierarchy;
+  const std::vector<NodeIndex>* sources;
+  const std::vector<NodeIndex>* targets;
+
+  // The backward search spaces of the targets, filled by the first phase,
+  // and the buckets computed from them: the bucket of node n is made of the
+  // entries bucket_starts[n] to bucket_starts[n + 1] - 1.
+  std::vector<std::vector<std::pair<NodeIndex, int64> > > search_spaces;
+  std::vector<int64> bucket_starts;
+  std::vector<BucketEntry> buckets;
+
+  std::vector<int64>* distances;
+};
+
+// Computes the backward search spaces of the targets first_target,
+// first_target + target_step, ...
+void ComputeTargetSearchSpaces(DistanceTableData* data, int first_target,
+                               int target_step) {
+  ContractionHierarchyQuery query(data->hierarchy);
+  const int num_targets = data->targets->size();
+  for (int j = first_target; j < num_targets; j += target_step) {
+    query.ComputeSearchSpace(/*forward=*/false, (*data->targets)[j],
+                             &data->search_spaces[j]);
+  }
+}
+
+// Fills the rows first_source, first_source + source_step, ... of the
+// distance table by scanning the buckets of the forward search space of each
+// source.
+void ComputeDistanceTableRows(const DistanceTableData* data, int first_source,
+                              int source_step) {
+  ContractionHierarchyQuery query(data->hierarchy);
+  std::vector<std::pair<NodeIndex, int64> > search_space;
+  const int num_sources = data->sources->size();
+  const int num_targets = data->targets->size();
+  for (int i = first_source; i < num_sources; i += source_step) {
+    int64* const row =
+        data->distances->data() + static_cast<int64>(i) * num_targets;
+    query.ComputeSearchSpace(/*forward=*/true, (*data->sources)[i],
+                             &search_space);
+    for (const std::pair<NodeIndex, int64>& element : search_space) {
+      const NodeIndex node = element.first;
+      for (int64 e = data->bucket_starts[node];
+           e < data->bucket_starts[node + 1]; ++e) {
+        const BucketEntry& entry = data->buckets[e];
+        row[entry.target_index] = std::min(row[entry.target_index],
+                                           element.second + entry.distance);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+// ----- ContractionHierarchy -----
+
+ContractionHierarchy::ContractionHierarchy()
+    : num_nodes_(0),
+      num_upward_arcs_(0),
+      num_downward_arcs_(0),
+      upward_starts_(nullptr),
+      upward_lengths_(nullptr),
+      upward_heads_(nullptr),
+      downward_starts_(nullptr),
+      downward_lengths_(nullptr),
+      downward_heads_(nullptr),
+      file_data_(nullptr),
+      file_size_(0),
+      is_mapped_(false),
+      witness_search_settle_limit_(500) {
+  Clear();
+}
+
+ContractionHierarchy::~ContractionHierarchy() { Clear(); }
+
+void ContractionHierarchy::Build(const Graph& graph,
+                                 const std::vector<int64>& arc_lengths) {
+  Clear();
+  std::vector<std::vector<BuilderArc> > upward;
+  std::vector<std::vector<BuilderArc> > downward;
+  {
+    HierarchyBuilder builder(graph, arc_lengths, witness_search_settle_limit_);
+    builder.Run(&upward, &downward);
+  }
+  FlattenArcs(upward, &upward_starts_storage_, &upward_lengths_storage_,
+              &upward_heads_storage_);
+  FlattenArcs(downward, &downward_starts_storage_, &downward_lengths_storage_,
+              &downward_heads_storage_);
+  num_nodes_ = graph.num_nodes();
+  num_upward_arcs_ = upward_heads_storage_.size();
+  num_downward_arcs_ = downward_heads_storage_.size();
+  UseStorage();
+  VLOG(1) << "Contraction hierarchy built with " << num_upward_arcs_
+          << " upward arcs and " << num_downward_arcs_
+          << " downward arcs for " << graph.num_arcs() << " arcs.";
+}
+
+void ContractionHierarchy::Clear() {
+#if !defined(_MSC_VER)
+  if (is_mapped_) {
+    munmap(const_cast<char*>(file_data_), file_size_);
+  }
+#endif
+  file_data_ = nullptr;
+  file_size_ = 0;
+  is_mapped_ = false;
+  file_buffer_.clear();
+  upward_starts_storage_.assign(1, 0);
+  upward_lengths_storage_.clear();
+  upward_heads_storage_.clear();
+  downward_starts_storage_.assign(1, 0);
+  downward_lengths_storage_.clear();
+  downward_heads_storage_.clear();
+  num_nodes_ = 0;
+  num_upward_arcs_ = 0;
+  num_downward_arcs_ = 0;
+  UseStorage();
+}
+
+void ContractionHierarchy::UseStorage() {
+  upward_starts_ = upward_starts_storage_.data();
+  upward_lengths_ = upward_lengths_storage_.data();
+  upward_heads_ = upward_heads_storage_.data();
+  downward_starts_ = downward_starts_storage_.data();
+  downward_lengths_ = downward_lengths_storage_.data();
+  downward_heads_ = downward_heads_storage_.data();
+}
+
+bool ContractionHierarchy::Write(const std::string& file_name) const {
+  FileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+  header.version = kContractionHierarchyFileVersion;
+  header.byte_order_mark = kByteOrderMark;
+  header.num_nodes = num_nodes_;
+  header.num_upward_arcs = num_upward_arcs_;
+  header.num_downward_arcs = num_downward_arcs_;
+  std::vector<int64> offsets;
+  ComputeSectionOffsets(header, &offsets);
+
+  std::unique_ptr<File> file(File::Open(file_name, "wb"));
+  if (file == nullptr) {
+    LOG(ERROR) << "Could not open " << file_name << " for writing.";
+    return false;
+  }
+  const void* const sections[NUM_SECTIONS] = {
+      upward_starts_,   upward_lengths_,   upward_heads_,
+      downward_starts_, downward_lengths_, downward_heads_};
+  const char kZeros[kSectionAlignment] = {0};
+  bool ok = file->Write(&header, sizeof(header)) == sizeof(header);
+  for (int i = 0; i < NUM_SECTIONS && ok; ++i) {
+    // The size of a section is the distance to the next one minus the
+    // padding, which is only needed after the arrays of NodeIndex.
+    const int64 padded_size = offsets[i + 1] - offsets[i];
+    int64 size = padded_size;
+    if (i == UPWARD_HEADS) size = num_upward_arcs_ * sizeof(NodeIndex);
+    if (i == DOWNWARD_HEADS) size = num_downward_arcs_ * sizeof(NodeIndex);
+    ok = file->Write(sections[i], size) == static_cast<size_t>(size) &&
+         file->Write(kZeros, padded_size - size) ==
+             static_cast<size_t>(padded_size - size);
+  }
+  if (!ok || !file->Close()) {
+    LOG(ERROR) << "Error while writing " << file_name;
+    return false;
+  }
+  return true;
+}
+
+bool ContractionHierarchy::Open(const std::string& file_name) {
+  Clear();
+#if !defined(_MSC_VER)
+  const int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG(ERROR) << "Could not open " << file_name;
+    return false;
+  }
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+    void* const address =
+        mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (address != MAP_FAILED) {
+      file_data_ = static_cast<const char*>(address);
+      file_size_ = file_stat.st_size;
+      is_mapped_ = true;
+    }
+  }
+  // The mapping stays valid after the file descriptor is closed.
+  close(fd);
+#else
+  std::unique_ptr<File> file(File::Open(file_name, "rb"));
+  if (file != nullptr) {
+    const int64 size = file->Size();
+    if (size > 0 && file->ReadToString(&file_buffer_, size) == size) {
+      file_data_ = file_buffer_.data();
+      file_size_ = size;
+    }
+    file->Close();
+  }
+#endif
+  if (file_data_ == nullptr) {
+    LOG(ERROR) << "Could not read " << file_name;
+    return false;
+  }
+  if (!UseFileData()) {
+    LOG(ERROR) << file_name << " is not a valid contraction hierarchy (version "
+               << kContractionHierarchyFileVersion << ").";
+    Clear();
+    return false;
+  }
+  return true;
+}
+
+bool ContractionHierarchy::UseFileData() {
+  if (file_size_ < static_cast<int64>(sizeof(FileHeader))) return false;
+  const FileHeader& header = *reinterpret_cast<const FileHeader*>(file_data_);
+  if (memcmp(header.magic, kFileMagic, sizeof(kFileMagic)) != 0 ||
+      header.byte_order_mark != kByteOrderMark ||
+      header.version != kContractionHierarchyFileVersion) {
+    return false;
+  }
+  if (header.num_nodes < 0 || header.num_nodes > kint32max ||
+      header.num_upward_arcs < 0 || header.num_downward_arcs < 0) {
+    return false;
+  }
+  std::vector<int64> offsets;
+  ComputeSectionOffsets(header, &offsets);
+  if (offsets[NUM_SECTIONS] != file_size_) return false;
+  const int64* const upward_starts =
+      reinterpret_cast<const int64*>(file_data_ + offsets[UPWARD_STARTS]);
+  const NodeIndex* const upward_heads =
+      reinterpret_cast<const NodeIndex*>(file_data_ + offsets[UPWARD_HEADS]);
+  const int64* const downward_starts =
+      reinterpret_cast<const int64*>(file_data_ + offsets[DOWNWARD_STARTS]);
+  const NodeIndex* const downward_heads =
+      reinterpret_cast<const NodeIndex*>(file_data_ + offsets[DOWNWARD_HEADS]);
+  // Check the structure so that the queries never read outside of the file,
+  // even on a corrupted one.
+  if (!AreArcsValid(upward_starts, upward_heads, header.num_nodes,
+                    header.num_upward_arcs) ||
+      !AreArcsValid(downward_starts, downward_heads, header.num_nodes,
+                    header.num_downward_arcs)) {
+    return false;
+  }
+  num_nodes_ = header.num_nodes;
+  num_upward_arcs_ = header.num_upward_arcs;
+  num_downward_arcs_ = header.num_downward_arcs;
+  upward_starts_ = upward_starts;
+  upward_lengths_ =
+      reinterpret_cast<const int64*>(file_data_ + offsets[UPWARD_LENGTHS]);
+  upward_heads_ = upward_heads;
+  downward_starts_ = downward_starts;
+  downward_lengths_ =
+      reinterpret_cast<const int64*>(file_data_ + offsets[DOWNWARD_LENGTHS]);
+  downward_heads_ = downward_heads;
+  return true;
+}
+
+void ContractionHierarchy::ComputeDistanceTable(
+    const std::vector<NodeIndex>& sources,
+    const std::vector<NodeIndex>& targets, int num_threads,
+    std::vector<int64>* distances) const {
+  distances->assign(sources.size() * targets.size(), kUnreachableDistance);
+  if (sources.empty() || targets.empty()) return;
+  DistanceTableData data;
+  data.hierarchy = this;
+  data.sources = &sources;
+  data.targets = &targets;
+  data.search_spaces.resize(targets.size());
+  data.distances = distances;
+  num_threads = std::max(1, num_threads);
+
+  // First phase: the backward searches from the targets.
+  DistanceTableData* const mutable_data = &data;
+  const int num_target_threads =
+      std::min<int>(num_threads, targets.size());
+  if (num_target_threads == 1) {
+    ComputeTargetSearchSpaces(mutable_data, 0, 1);
+  } else {
+    // The destructor of the pool waits for all the searches to be done.
+    ThreadPool pool("DistanceTableTargets", num_target_threads);
+    pool.StartWorkers();
+    for (int i = 0; i < num_target_threads; ++i) {
+      pool.Add(NewCallback(&ComputeTargetSearchSpaces, mutable_data, i,
+                           num_target_threads));
+    }
+  }
+
+  // Put the search spaces in the buckets of their nodes, with a counting
+  // sort.
+  data.bucket_starts.assign(num_nodes_ + 1, 0);
+  for (const std::vector<std::pair<NodeIndex, int64> >& search_space :
+       data.search_spaces) {
+    for (const std::pair<NodeIndex, int64>& element : search_space) {
+      ++data.bucket_starts[element.first + 1];
+    }
+  }
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    data.bucket_starts[node + 1] += data.bucket_starts[node];
+  }
+  data.buckets.resize(data.bucket_starts[num_nodes_]);
+  std::vector<int64> next_entry(data.bucket_starts.begin(),
+                                data.bucket_starts.end() - 1);
+  const int num_targets = targets.size();
+  for (int j = 0; j < num_targets; ++j) {
+    for (const std::pair<NodeIndex, int64>& element : data.search_spaces[j]) {
+      BucketEntry& entry = data.buckets[next_entry[element.first]++];
+      entry.target_index = j;
+      entry.distance = element.second;
+    }
+    std::vector<std::pair<NodeIndex, int64> >().swap(data.search_spaces[j]);
+  }
+
+  // Second phase: the forward searches from the sources.
+  const DistanceTableData* const shared_data = &data;
+  const int num_source_threads =
+      std::min<int>(num_threads, sources.size());
+  if (num_source_threads == 1) {
+    ComputeDistanceTableRows(shared_data, 0, 1);
+    return;
+  }
+  ThreadPool pool("DistanceTableSources", num_source_threads);
+  pool.StartWorkers();
+  for (int i = 0; i < num_source_threads; ++i) {
+    pool.Add(NewCallback(&ComputeDistanceTableRows, shared_data, i,
+                         num_source_threads));
+  }
+}
+
+// ----- ContractionHierarchyQuery -----
+
+void ContractionHierarchyQuery::SearchState::Reset() {
+  for (const NodeIndex node : touched_nodes) {
+    distance[node] = kUnreachableDistance;
+    is_settled[node] = false;
+  }
+  touched_nodes.clear();
+  queue.Clear();
+}
+
+ContractionHierarchyQuery::ContractionHierarchyQuery(
+    const ContractionHierarchy* hierarchy)
+    : hierarchy_(*hierarchy),
+      forward_(hierarchy->num_nodes()),
+      backward_(hierarchy->num_nodes()) {}
+
+int64 ContractionHierarchyQuery::Distance(NodeIndex source, NodeIndex target) {
+  forward_.Reset();
+  backward_.Reset();
+  forward_.Reach(source, 0);
+  backward_.Reach(target, 0);
+  int64 best_distance = source == target ? 0 : kUnreachableDistance;
+  // Each search stops when its smallest distance is not smaller than the best
+  // distance found: the top node of a shortest path would then be further.
+  while (true) {
+    const bool forward_active =
+        !forward_.queue.IsEmpty() &&
+        static_cast<int64>(forward_.queue.TopKey()) < best_distance;
+    const bool backward_active =
+        !backward_.queue.IsEmpty() &&
+        static_cast<int64>(backward_.queue.TopKey()) < best_distance;
+    if (!forward_active && !backward_active) break;
+    const bool forward =
+        forward_active &&
+        (!backward_active ||
+         forward_.queue.TopKey() <= backward_.queue.TopKey());
+    SearchState* const search = forward ? &forward_ : &backward_;
+    const SearchState& other = forward ? backward_ : forward_;
+    const NodeIndex node = ScanNextNode(forward, search);
+    if (node != -1 && other.distance[node] != kUnreachableDistance) {
+      best_distance = std::min(best_distance,
+                               search->distance[node] + other.distance[node]);
+    }
+  }
+  return best_distance;
+}
+
+void ContractionHierarchyQuery::ComputeSearchSpace(
+    bool forward, NodeIndex origin,
+    std::vector<std::pair<NodeIndex, int64> >* search_space) {
+  SearchState* const search = forward ? &forward_ : &backward_;
+  search->Reset();
+  search->Reach(origin, 0);
+  search_space->clear();
+  while (!search->queue.IsEmpty()) {
+    const NodeIndex node = ScanNextNode(forward, search);
+    if (node != -1) {
+      search_space->push_back(std::make_pair(node, search->distance[node]));
+    }
+  }
+}
+
+ContractionHierarchyQuery::NodeIndex ContractionHierarchyQuery::ScanNextNode(
+    bool forward, SearchState* search) {
+  const NodeIndex node = search->queue.Top();
+  search->queue.Pop();
+  // The queue may contain several elements for the same node, only the first
+  // one that is popped matters.
+  if (search->is_settled[node]) return -1;
+  search->is_settled[node] = true;
+  const int64 node_distance = search->distance[node];
+  const ContractionHierarchy& h = hierarchy_;
+
+  // The arcs that go up in the direction of the search are relaxed, the ones
+  // that go up in the other direction are used for the stall test: if a node
+  // of higher rank reached by the search gives a shorter distance to node
+  // through such an arc, node is not on a shortest up-down path.
+  const int64* const starts = forward ? h.upward_starts_ : h.downward_starts_;
+  const int64* const lengths =
+      forward ? h.upward_lengths_ : h.downward_lengths_;
+  const NodeIndex* const heads = forward ? h.upward_heads_ : h.downward_heads_;
+  const int64* const stall_starts =
+      forward ? h.downward_starts_ : h.upward_starts_;
+  const int64* const stall_lengths =
+      forward ? h.downward_lengths_ : h.upward_lengths_;
+  const NodeIndex* const stall_heads =
+      forward ? h.downward_heads_ : h.upward_heads_;
+  for (int64 arc = stall_starts[node]; arc < stall_starts[node + 1]; ++arc) {
+    const int64 neighbor_distance = search->distance[stall_heads[arc]];
+    if (neighbor_distance != kUnreachableDistance &&
+        neighbor_distance + stall_lengths[arc] < node_distance) {
+      return -1;
+    }
+  }
+  for (int64 arc = starts[node]; arc < starts[node + 1]; ++arc) {
+    const NodeIndex head = heads[arc];
+    const int64 head_distance = node_distance + lengths[arc];
+    if (head_distance < search->distance[head]) {
+      search->Reach(head, head_distance);
+    }
+  }
+  return node;
+}
+
+}  // namespace operations_research
@@ -0,0 +1,240 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// A contraction hierarchy is an index which answers shortest path distance
+// queries on a fixed graph (typically a road network) orders of magnitude
+// faster than Dijkstra's algorithm, at the price of a one-time preprocessing.
+// See R. Geisberger, P. Sanders, D. Schultes, D. Delling, "Contraction
+// Hierarchies: Faster and Simpler Hierarchical Routing in Road Networks",
+// WEA 2008, LNCS 5038, 319-333.
+//
+// The preprocessing contracts the nodes one by one, in an order given by a
+// heuristic importance: when a node is contracted, a shortcut arc is added
+// between each pair of its remaining neighbors whose shortest path goes
+// through it. Each node thus gets a rank, and the index only keeps, for each
+// node, the "upward" arcs leaving it towards nodes of higher rank and the
+// "downward" arcs entering it from nodes of higher rank (original arcs and
+// shortcuts). There is always a shortest path that first goes up and then
+// down in this hierarchy, so a query only needs two small searches:
+//   - a point-to-point distance is found by a forward search from the source
+//     on the upward arcs and a backward search from the target on the
+//     downward arcs (ContractionHierarchyQuery::Distance()),
+//   - a many-to-many distance table is computed with one backward search per
+//     target, which stores its distances in buckets attached to the nodes it
+//     visits, and one forward search per source, which only needs to scan the
+//     buckets of the nodes it visits (ContractionHierarchy::
+//     ComputeDistanceTable()).
+//
+// The index is made of flat arrays, which can be saved to a file and
+// memory-mapped back, so that the preprocessing is only done once per graph.
+//
+// Example:
+//   typedef ReverseArcStaticGraph<> Graph;
+//   Graph graph(num_nodes, num_arcs);
+//   std::vector<int64> arc_lengths;
+//   ... add the arcs, call graph.Build(&permutation) and permute arc_lengths.
+//
+//   ContractionHierarchy hierarchy;
+//   hierarchy.Build(graph, arc_lengths);
+//   hierarchy.Write("/tmp/roads.ch");
+//
+//   // Later, possibly in another process:
+//   ContractionHierarchy hierarchy;
+//   CHECK(hierarchy.Open("/tmp/roads.ch"));
+//   std::vector<int64> table;
+//   hierarchy.ComputeDistanceTable(nodes, nodes, num_threads, &table);
+//   // table[i * nodes.size() + j] is the distance from nodes[i] to nodes[j],
+//   // which is what a RoutingModel arc cost evaluator needs to look up.
+
+#ifndef OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
+#define OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/macros.h"
+#include "graph/graph.h"
+#include "graph/shortest_path_search.h"
+
+namespace operations_research {
+
+// Version of the file format written by ContractionHierarchy::Write(). It must
+// be increased each time the layout described in the .cc changes. Files with
+// a different version are rejected by ContractionHierarchy::Open().
+const uint32 kContractionHierarchyFileVersion = 1;
+
+// The index itself. Once built or opened it is immutable, so it can be shared
+// by several threads, each one using its own ContractionHierarchyQuery.
+class ContractionHierarchy {
+ public:
+  typedef ReverseArcStaticGraph<> Graph;
+  typedef Graph::NodeIndex NodeIndex;
+
+  ContractionHierarchy();
+  ~ContractionHierarchy();
+
+  // Computes the hierarchy of the given graph, whose arc lengths are indexed
+  // by arc and must be non-negative. Neither the graph nor the arc lengths
+  // need to outlive this object.
+  void Build(const Graph& graph, const std::vector<int64>& arc_lengths);
+
+  // Maximum number of nodes settled by each "witness" search of Build(), which
+  // checks if a shortcut is needed. A smaller limit makes the preprocessing
+  // faster but may add useless shortcuts, which slows down the queries. The
+  // result is correct in any case.
+  void set_witness_search_settle_limit(int limit) {
+    witness_search_settle_limit_ = limit;
+  }
+
+  // Saves the hierarchy to a file. Returns false if it couldn't be written.
+  bool Write(const std::string& file_name) const;
+
+  // Replaces the hierarchy by the one stored in the given file. On POSIX
+  // systems the file is memory-mapped, so this is only bounded by the time
+  // needed to check its consistency, and the memory is shared between all the
+  // processes that open the same file. Returns false, and leaves the object
+  // empty, if the file is not a valid hierarchy of the current format version.
+  bool Open(const std::string& file_name);
+
+  // Releases the hierarchy and the underlying file, if any.
+  void Clear();
+
+  NodeIndex num_nodes() const { return num_nodes_; }
+  int64 num_upward_arcs() const { return num_upward_arcs_; }
+  int64 num_downward_arcs() const { return num_downward_arcs_; }
+
+  // Computes the distances from each of the sources to each of the targets.
+  // On return, (*distances)[i * targets.size() + j] contains the distance from
+  // sources[i] to targets[j], or kUnreachableDistance if there is no path.
+  // The bucket-based algorithm described at the top of this file is used,
+  // with the searches distributed over num_threads threads. Besides the
+  // searches, this costs O(num_nodes) to index the buckets.
+  void ComputeDistanceTable(const std::vector<NodeIndex>& sources,
+                            const std::vector<NodeIndex>& targets,
+                            int num_threads,
+                            std::vector<int64>* distances) const;
+
+ private:
+  friend class ContractionHierarchyQuery;
+
+  // Points the arrays below to the given storage vectors.
+  void UseStorage();
+
+  // Computes the arrays below from the header at the beginning of file_data_.
+  // Returns false if the file is not consistent.
+  bool UseFileData();
+
+  NodeIndex num_nodes_;
+  int64 num_upward_arcs_;
+  int64 num_downward_arcs_;
+
+  // The upward arcs of node n are the arcs upward_starts_[n] to
+  // upward_starts_[n + 1] - 1, going to upward_heads_[arc]. The downward arcs
+  // entering n are stored in the same way, but downward_heads_[arc] is the
+  // tail of the arc, i.e. the node of higher rank. These arrays either point
+  // to the storage vectors below (after Build()) or into file_data_ (after
+  // Open()).
+  const int64* upward_starts_;
+  const int64* upward_lengths_;
+  const NodeIndex* upward_heads_;
+  const int64* downward_starts_;
+  const int64* downward_lengths_;
+  const NodeIndex* downward_heads_;
+
+  std::vector<int64> upward_starts_storage_;
+  std::vector<int64> upward_lengths_storage_;
+  std::vector<NodeIndex> upward_heads_storage_;
+  std::vector<int64> downward_starts_storage_;
+  std::vector<int64> downward_lengths_storage_;
+  std::vector<NodeIndex> downward_heads_storage_;
+
+  // The content of the file given to Open(), memory-mapped if possible, or
+  // read in file_buffer_ otherwise.
+  const char* file_data_;
+  int64 file_size_;
+  std::string file_buffer_;
+  bool is_mapped_;
+
+  int witness_search_settle_limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContractionHierarchy);
+};
+
+// The searches on a ContractionHierarchy. A query object holds the memory
+// needed by the searches, in O(num_nodes), and can be reused for many queries:
+// each one only costs time for the nodes it visits. It is not thread-safe,
+// but several query objects can be used in parallel on the same hierarchy.
+//
+// The searches use "stall-on-demand": a node reached by a search is not
+// expanded if the search reached one of its higher-ranked neighbors with a
+// distance that proves the node's distance not to be a shortest one.
+class ContractionHierarchyQuery {
+ public:
+  typedef ContractionHierarchy::NodeIndex NodeIndex;
+
+  // The hierarchy is not owned and must outlive this object.
+  explicit ContractionHierarchyQuery(const ContractionHierarchy* hierarchy);
+
+  // Returns the distance from source to target, or kUnreachableDistance if
+  // there is no path.
+  int64 Distance(NodeIndex source, NodeIndex target);
+
+  // Runs a complete search from origin: on the upward arcs if forward is
+  // true, on the downward arcs (i.e. towards origin) otherwise. Fills
+  // search_space with the nodes settled and not stalled by the search, with
+  // their distance from (resp. to) origin. The shortest distance from a
+  // source to a target is the minimum, over the nodes present in both the
+  // forward search space of the source and the backward search space of the
+  // target, of the sum of their two distances.
+  void ComputeSearchSpace(bool forward, NodeIndex origin,
+                          std::vector<std::pair<NodeIndex, int64> >*
+                              search_space);
+
+ private:
+  // The state of the search in one direction.
+  struct SearchState {
+    explicit SearchState(NodeIndex num_nodes)
+        : distance(num_nodes, kUnreachableDistance),
+          is_settled(num_nodes, false) {}
+
+    void Reach(NodeIndex node, int64 node_distance) {
+      if (distance[node] == kUnreachableDistance) touched_nodes.push_back(node);
+      distance[node] = node_distance;
+      queue.Push(node_distance, node);
+    }
+
+    void Reset();
+
+    std::vector<int64> distance;
+    std::vector<bool> is_settled;
+    std::vector<NodeIndex> touched_nodes;
+    RadixHeap<NodeIndex> queue;
+  };
+
+  // Settles the next node of the given search, which must not be empty.
+  // Returns the node, or -1 if it was already settled or if it is stalled, in
+  // which case its arcs are not relaxed.
+  NodeIndex ScanNextNode(bool forward, SearchState* search);
+
+  const ContractionHierarchy& hierarchy_;
+  SearchState forward_;
+  SearchState backward_;
+
+  DISALLOW_COPY_AND_ASSIGN(ContractionHierarchyQuery);
+};
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_CONTRACTION_HIERARCHY_H_
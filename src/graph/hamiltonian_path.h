@@ -30,7 +30,8 @@
 // solution.
 // The algorithm uses dynamic programming. Its time complexity is
 // O(n * 2 ^ (n - 1)), where n is the number of nodes to be visited, and '^'
-// denotes exponentiation. Its space complexity is also O(n * 2 ^ (n - 1)).
+// denotes exponentiation. Its space complexity is also O(n * 2 ^ (n - 1)) in
+// the worst case, see below.
 //
 // Note that the naive implementation of the SHPP
 // exploring all permutations without memorizing intermediate results would
@@ -76,20 +77,43 @@
 // computing f(S,j) in an array M[Offset(S,j)]. See the comments about
 // LatticeMemoryManager::BaseOffset() to see how this is computed.
 //
+// HamiltonianPathSolver stores each layer of the lattice in its own array (see
+// LayeredLatticeMemoryManager), as computing a layer only reads the previous
+// one. Only the last two computed layers and some checkpoint layers, every
+// SetCheckpointInterval() cardinalities, are kept: the memory used drops from
+// O(n * 2 ^ n) to O(n * (n choose n / 2)) plus the checkpoints. The paths are
+// reconstructed from the checkpoint layers, and the layers in between are
+// recomputed on the subsets of the nodes remaining on the path only, which is
+// cheap compared to the full computation. The paths are only computed when
+// they are queried. When only the costs are needed, SetCostOnlyMode() keeps
+// no checkpoint layers at all: the memory used is then the one of the two
+// largest consecutive layers.
+//
+// The computation of f(S, j) for all j in S is a min-reduction over the
+// contiguous values f(S \ {j}, i) and the costs to j, stored contiguously
+// in the transposed cost matrix, which the compiler can vectorize. The sets
+// of a layer are independent, so a layer can be split between several
+// threads, see SetNumThreads(). The threads are started once per solve, and
+// synchronized by a barrier between the layers.
+//
 // Keywords: Traveling Salesman, Hamiltonian Path, Dynamic Programming,
 //           Held, Karp.
 
 #include <math.h>
 #include <stddef.h>
 #include <algorithm>
+#include <atomic>
 #include <limits>
 #include "base/unique_ptr.h"
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "base/callback.h"
 #include "base/integral_types.h"
 #include "base/logging.h"
+#include "base/synchronization.h"
+#include "base/threadpool.h"
 #include "util/bitset.h"
 #include "util/saturated_arithmetic.h"
 
@@ -440,6 +464,187 @@ void LatticeMemoryManager<Set, CostType>::SetValue(Set set, int node,
   SetValueAtOffset(Offset(set, node), value);
 }
 
+// The Dynamic Programming iteration only reads the layer of the lattice with
+// cardinality card - 1 to compute the layer with cardinality card.
+// LayeredLatticeMemoryManager stores each layer in its own array, so that only
+// the layers which are still needed use memory: the layers which are marked
+// to be kept, and the last two computed layers among the others, which share
+// two buffers. Within a layer, f(set, node) is stored at
+// card * SetRank(set) + set.ElementRank(node), as in LatticeMemoryManager.
+template <typename Set, typename CostType> class LayeredLatticeMemoryManager {
+ public:
+  typedef typename Set::IntegerType IntegerType;
+
+  LayeredLatticeMemoryManager() : max_card_(-1) {}
+
+  // Prepares the storage of the layers of the lattice of the subsets of
+  // [0, max_card). The layer with cardinality card is kept once computed if
+  // keep_layer[card] is true. This makes all the layers unavailable.
+  void Init(int max_card, const std::vector<bool>& keep_layer);
+
+  // Returns the largest cardinality of the sets, as given to Init().
+  int max_card() const { return max_card_; }
+
+  // Returns the number of sets with the given cardinality.
+  uint64 NumSets(int card) const {
+    return binomial_coefficients_[max_card_][card];
+  }
+
+  // Returns the rank of a set among the sets with the same cardinality, in
+  // the order in which SetRangeWithCardinality enumerates them.
+  uint64 SetRank(Set set) const;
+
+  // Returns the set with the given cardinality and rank.
+  Set SetOfRank(int card, uint64 rank) const;
+
+  // Returns the change of the rank of a set of cardinality > rank when
+  // added_node replaces removed_node at 'rank'. See
+  // LatticeMemoryManager::OffsetDelta().
+  uint64 RankDelta(int added_node, int removed_node, int rank) const {
+    return binomial_coefficients_[added_node][rank] -
+           binomial_coefficients_[removed_node][rank];
+  }
+
+  // Returns the memory where the layer with cardinality card is to be
+  // computed. If this layer is not kept, this makes the layer which used the
+  // same buffer unavailable.
+  CostType* NewLayer(int card);
+
+  // Returns true if the layer with cardinality card is available.
+  bool HasLayer(int card) const { return layers_[card] != nullptr; }
+
+  // Returns the largest available layer with a cardinality <= card, or 0 if
+  // there is none.
+  int LargestLayerAtMost(int card) const;
+
+  // Returns the values of the layer with cardinality card, which must be
+  // available.
+  const CostType* Layer(int card) const {
+    DCHECK(HasLayer(card));
+    return layers_[card];
+  }
+
+  // Returns the memorized value f(s, node) with node in s.
+  CostType Value(Set set, int node) const {
+    DCHECK(set.Contains(node));
+    const int card = set.Cardinality();
+    return Layer(card)[card * SetRank(set) + set.ElementRank(node)];
+  }
+
+ private:
+  int max_card_;
+
+  // binomial_coefficients_[n][k] contains (n choose k).
+  std::vector<std::vector<uint64>> binomial_coefficients_;
+
+  std::vector<bool> keep_layer_;
+
+  // The storage of the kept layers, indexed by cardinality, and the two
+  // buffers shared by the other layers, with the cardinality of the layer
+  // stored in each of them, or -1.
+  std::vector<std::vector<CostType>> kept_layers_;
+  std::vector<CostType> buffers_[2];
+  int buffer_layer_[2];
+
+  // layers_[card] points to the layer with cardinality card if it is
+  // available, and is nullptr otherwise.
+  std::vector<CostType*> layers_;
+};
+
+template <typename Set, typename CostType>
+void LayeredLatticeMemoryManager<Set, CostType>::Init(
+    int max_card, const std::vector<bool>& keep_layer) {
+  DCHECK_LT(0, max_card);
+  DCHECK_GE(Set::MaxCardinality, max_card);
+  DCHECK_EQ(max_card + 1, static_cast<int>(keep_layer.size()));
+  if (max_card != max_card_) {
+    max_card_ = max_card;
+    // Same as in LatticeMemoryManager::Init().
+    binomial_coefficients_.resize(max_card_ + 1);
+    for (int n = 0; n <= max_card_; ++n) {
+      binomial_coefficients_[n].resize(n + 2);
+      binomial_coefficients_[n][0] = 1;
+      for (int k = 1; k <= n; ++k) {
+        binomial_coefficients_[n][k] = binomial_coefficients_[n - 1][k - 1] +
+                                       binomial_coefficients_[n - 1][k];
+      }
+      binomial_coefficients_[n][n + 1] = 0;
+    }
+  }
+  keep_layer_ = keep_layer;
+  kept_layers_.resize(max_card_ + 1);
+  for (int card = 0; card <= max_card_; ++card) {
+    if (!keep_layer_[card]) {
+      // Releases the memory of the layers which were kept by a previous
+      // computation.
+      std::vector<CostType>().swap(kept_layers_[card]);
+    }
+  }
+  buffer_layer_[0] = -1;
+  buffer_layer_[1] = -1;
+  layers_.assign(max_card_ + 1, nullptr);
+}
+
+template <typename Set, typename CostType>
+uint64 LayeredLatticeMemoryManager<Set, CostType>::SetRank(Set set) const {
+  uint64 rank = 0;
+  int node_rank = 0;
+  for (int node : set) {
+    rank += binomial_coefficients_[node][node_rank + 1];
+    ++node_rank;
+  }
+  return rank;
+}
+
+template <typename Set, typename CostType>
+Set LayeredLatticeMemoryManager<Set, CostType>::SetOfRank(int card,
+                                                          uint64 rank) const {
+  DCHECK_LT(rank, NumSets(card));
+  // The elements are found from the largest one, which is the largest node
+  // such that the number of sets whose largest element is smaller, i.e.
+  // (node choose card), is at most rank.
+  IntegerType value = 0;
+  int node = max_card_ - 1;
+  for (int node_rank = card - 1; node_rank >= 0; --node_rank) {
+    while (binomial_coefficients_[node][node_rank + 1] > rank) --node;
+    value |= Set::One << node;
+    rank -= binomial_coefficients_[node][node_rank + 1];
+    --node;
+  }
+  DCHECK_EQ(0, rank);
+  return Set(value);
+}
+
+template <typename Set, typename CostType>
+CostType* LayeredLatticeMemoryManager<Set, CostType>::NewLayer(int card) {
+  std::vector<CostType>* storage = nullptr;
+  if (keep_layer_[card]) {
+    storage = &kept_layers_[card];
+  } else {
+    const int buffer = card % 2;
+    if (buffer_layer_[buffer] != -1) layers_[buffer_layer_[buffer]] = nullptr;
+    buffer_layer_[buffer] = card;
+    storage = &buffers_[buffer];
+  }
+  // The previous values of the storage are not needed: it is reallocated to
+  // the exact size, since resize() could allocate up to twice the size.
+  const uint64 size = card * NumSets(card);
+  if (storage->capacity() < size) {
+    std::vector<CostType>().swap(*storage);
+    storage->reserve(size);
+  }
+  storage->resize(size);
+  layers_[card] = storage->data();
+  return layers_[card];
+}
+
+template <typename Set, typename CostType>
+int LayeredLatticeMemoryManager<Set, CostType>::LargestLayerAtMost(
+    int card) const {
+  while (card > 0 && !HasLayer(card)) --card;
+  return card;
+}
+
 // Deprecated type.
 typedef int PathNodeIndex;
 
@@ -502,17 +707,100 @@ template <typename CostType> class HamiltonianPathSolver {
   // Returns true if the cost matrix verifies the triangle inequality.
   bool VerifiesTriangleInequality();
 
+  // Sets the number of threads computing each layer of the lattice. The
+  // default is 1. Only the layers with enough sets are split between threads.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+
+  // Sets the interval between the cardinalities of the layers of the lattice
+  // which are kept to reconstruct the paths. The default is 8. A larger
+  // interval uses less memory, but more time to recompute the layers in
+  // between.
+  void SetCheckpointInterval(int interval) {
+    DCHECK_LT(0, interval);
+    checkpoint_interval_ = interval;
+    solved_ = false;
+  }
+
+  // When true, only the last two layers of the lattice are kept, which is
+  // enough to compute the costs but not the paths: querying a path then
+  // solves the problem again, with the checkpoint layers. The default is
+  // false.
+  void SetCostOnlyMode(bool cost_only) { cost_only_ = cost_only; }
+
  private:
+  typedef LayeredLatticeMemoryManager<NodeSet, CostType> LatticeMemory;
+
+  // The computation of a layer of a lattice, shared by the threads.
+  struct LayerComputation {
+    LayerComputation(const CostType* cost_by_dest, int num_elements, int card,
+                     LatticeMemory* mem)
+        : cost_by_dest(cost_by_dest),
+          num_elements(num_elements),
+          card(card),
+          mem(mem),
+          layer(nullptr),
+          next_chunk(0) {}
+
+    const CostType* const cost_by_dest;
+    const int num_elements;
+    const int card;
+    LatticeMemory* const mem;
+    CostType* layer;
+    std::atomic<uint64> next_chunk;
+  };
+
   // Returns true if the cost matrix is square, and if the type
   // NodeSet::Integer is sufficient to represent sets with num_nodes_ elements.
   // Intended to be used is a CHECK.
   bool CheckCostMatrix();
 
-  // Does all the Dynamic Progamming iterations.
-  void Solve();
+  // Copies the transpose of cost_matrix_ to cost_by_dest_.
+  void UpdateCostByDest();
+
+  // Does all the Dynamic Progamming iterations, unless they were already done
+  // with the same cost matrix, and with the checkpoint layers if
+  // with_checkpoints is true. The paths are computed on demand, and need the
+  // checkpoint layers.
+  void Solve(bool with_checkpoints);
+
+  // Splitting a layer between threads only pays off if its computation, about
+  // NumSets(card) * card * card operations, takes more than about a
+  // millisecond.
+  static const uint64 kMinWorkForThreads = 1 << 18;
+
+  // Returns the largest number of operations needed to compute a layer of the
+  // given lattice.
+  static uint64 LargestLayerWork(const LatticeMemory& mem);
 
-  // Computes a path by looking at the information in mem_.
-  std::vector<int> ComputePath(CostType cost, NodeSet set, int end);
+  // The loop of the threads started by Solve(): computes the chunks of the
+  // layer given by layer_computation_ each time the barrier is passed, until
+  // it is nullptr.
+  void RunLayerWorker();
+
+  // Computes the layer with cardinality card of a lattice from the layer with
+  // cardinality card - 1. The lattice is on the subsets of num_elements nodes,
+  // and the cost from src to dest is cost_by_dest[dest * num_elements + src].
+  void ComputeLayer(const CostType* cost_by_dest, int num_elements, int card,
+                    LatticeMemory* mem);
+
+  // Computes the chunks of sets of a layer until none is left.
+  void ComputeLayerChunks(LayerComputation* computation);
+
+  // Computes f(set, node) for the sets with a rank in [begin, end).
+  void ComputeLayerRange(const LayerComputation& computation, uint64 begin,
+                         uint64 end);
+
+  // Computes a path by looking at the information in mem_, recomputing the
+  // layers between the checkpoints when needed.
+  std::vector<int> ComputePath(NodeSet set, int end);
+
+  // Returns f(set, node) during the computation of a path: from mem_ if the
+  // layer is available, or from segment_mem_, which is recomputed if needed.
+  CostType PathValue(NodeSet set, int node);
+
+  // Recomputes in segment_mem_ the values f(subset, node) for the subsets of
+  // set, from the largest layer of mem_ below it.
+  void ComputeSegment(NodeSet set);
 
   // Returns true if the path covers all nodes, and its cost is equal to cost.
   //
@@ -522,15 +810,29 @@ template <typename CostType> class HamiltonianPathSolver {
   // ChangeCostMatrix();
   std::vector<std::vector<CostType>> cost_matrix_;
 
+  // The same matrix, transposed and stored in a single vector, so that the
+  // costs to a node are contiguous: cost_by_dest_[dest * num_nodes_ + src].
+  std::vector<CostType> cost_by_dest_;
+
   // Returns the saturated addition of a and b. By default for floating-point
   // types it is a + b. It is specialized below for int32 and int64.
-  CostType SaturatedAdd(CostType a, CostType b) {
+  static CostType SaturatedAdd(CostType a, CostType b) {
     return a + b;
   }
 
   // The number of nodes in the problem.
   int num_nodes_;
 
+  int num_threads_;
+  int checkpoint_interval_;
+  bool cost_only_;
+
+  // During Solve(), when several threads are used, the barrier shared by the
+  // calling thread and the num_threads_ - 1 threads of the pool, and the layer
+  // they compute. See ComputeLayer() and RunLayerWorker().
+  ReusableBarrier* layer_barrier_;
+  LayerComputation* layer_computation_;
+
   // The cost of the computed TSP path.
   CostType tsp_cost_;
 
@@ -542,10 +844,12 @@ template <typename CostType> class HamiltonianPathSolver {
   bool robustness_checked_;
   bool triangle_inequality_checked_;
   bool solved_;
-  std::vector<int> tsp_path_;
+  // Whether the last Solve() kept the checkpoint layers.
+  bool has_checkpoints_;
 
-  // The vector of smallest Hamiltonian paths starting at 0, indexed by their
-  // end nodes.
+  // The TSP tour and the smallest Hamiltonian paths starting at 0, indexed by
+  // their end nodes. They are computed on demand, and are empty until then.
+  std::vector<int> tsp_path_;
   std::vector<std::vector<int>> hamiltonian_paths_;
 
   // The end node that gives the smallest Hamiltonian path. The smallest
@@ -553,7 +857,16 @@ template <typename CostType> class HamiltonianPathSolver {
   // is hamiltonian_paths_[best_hamiltonian_path_end_node_].
   int best_hamiltonian_path_end_node_;
 
-  LatticeMemoryManager<NodeSet, CostType> mem_;
+  LatticeMemory mem_;
+
+  // The lattice of the subsets of segment_set_, with the layers from
+  // cardinality segment_first_card_ to the cardinality of segment_set_, which
+  // ComputePath() recomputes from a checkpoint layer of mem_. The nodes are
+  // renumbered by their rank in segment_set_.
+  NodeSet segment_set_;
+  int segment_first_card_;
+  std::vector<CostType> segment_cost_by_dest_;
+  LatticeMemory segment_mem_;
 };
 
 template <typename CostType>
@@ -561,14 +874,24 @@ HamiltonianPathSolver<CostType>::HamiltonianPathSolver(
     const std::vector<std::vector<CostType>>& cost_matrix)
     : cost_matrix_(cost_matrix),
       num_nodes_(cost_matrix_.size()),
+      num_threads_(1),
+      checkpoint_interval_(8),
+      cost_only_(false),
+      layer_barrier_(nullptr),
+      layer_computation_(nullptr),
       tsp_cost_(0),
       hamiltonian_costs_(0),
       robust_(true),
       triangle_inequality_ok_(true),
       robustness_checked_(false),
       triangle_inequality_checked_(false),
-      solved_(false) {
+      solved_(false),
+      has_checkpoints_(false),
+      best_hamiltonian_path_end_node_(0),
+      segment_set_(0),
+      segment_first_card_(0) {
   CHECK(CheckCostMatrix());
+  UpdateCostByDest();
 }
 
 template <typename CostType>
@@ -580,6 +903,17 @@ void HamiltonianPathSolver<CostType>::ChangeCostMatrix(
   cost_matrix_ = cost_matrix;
   num_nodes_ = cost_matrix_.size();
   CHECK(CheckCostMatrix());
+  UpdateCostByDest();
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::UpdateCostByDest() {
+  cost_by_dest_.resize(num_nodes_ * num_nodes_);
+  for (int src = 0; src < num_nodes_; ++src) {
+    for (int dest = 0; dest < num_nodes_; ++dest) {
+      cost_by_dest_[dest * num_nodes_ + src] = cost_matrix_[src][dest];
+    }
+  }
 }
 
 template <typename CostType>
@@ -591,14 +925,16 @@ bool HamiltonianPathSolver<CostType>::CheckCostMatrix() {
   return true;
 }
 
+// CapAddGeneric() is used rather than CapAdd(), whose inline assembly would
+// prevent the vectorization of the loop of ComputeLayerRange().
 template <>
-int64 HamiltonianPathSolver<int64>::SaturatedAdd(int64 a, int64 b) {
-  return CapAdd(a, b);
+inline int64 HamiltonianPathSolver<int64>::SaturatedAdd(int64 a, int64 b) {
+  return CapAddGeneric(a, b);
 }
 
 // TODO(user): implement this natively in saturated_arithmetic.h
 template <>
-int32 HamiltonianPathSolver<int32>::SaturatedAdd(int32 a, int32 b) {
+inline int32 HamiltonianPathSolver<int32>::SaturatedAdd(int32 a, int32 b) {
   const int64 a64 = a;
   const int64 b64 = b;
   const int64 min_int32 = std::numeric_limits<int32>::min();
@@ -607,8 +943,11 @@ int32 HamiltonianPathSolver<int32>::SaturatedAdd(int32 a, int32 b) {
       static_cast<int32>(std::max(min_int32, std::min(max_int32, a64 + b64)));
 }
 
-template <typename CostType> void HamiltonianPathSolver<CostType>::Solve() {
-  if (solved_) return;
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::Solve(bool with_checkpoints) {
+  if (solved_ && (has_checkpoints_ || !with_checkpoints)) return;
+  tsp_path_.clear();
+  hamiltonian_paths_.clear();
   if (num_nodes_ == 0) {
     tsp_cost_ = 0;
     tsp_path_ = { 0 };
@@ -617,58 +956,63 @@ template <typename CostType> void HamiltonianPathSolver<CostType>::Solve() {
     best_hamiltonian_path_end_node_ = 0;
     hamiltonian_costs_[0] = 0;
     hamiltonian_paths_[0] = { 0 };
+    solved_ = true;
+    has_checkpoints_ = true;
     return;
   }
-  mem_.Init(num_nodes_);
+  // The last two layers contain the costs of the TSP and of the Hamiltonian
+  // paths. Without checkpoints, they are the last two computed layers, which
+  // are still in the two buffers. The paths are reconstructed from the
+  // checkpoint layers.
+  std::vector<bool> keep_layer(num_nodes_ + 1, false);
+  if (with_checkpoints) {
+    for (int card = 1; card <= num_nodes_; ++card) {
+      keep_layer[card] = card == 1 || card % checkpoint_interval_ == 0 ||
+                         card >= num_nodes_ - 1;
+    }
+  }
+  mem_.Init(num_nodes_, keep_layer);
+  segment_set_ = NodeSet(0);
   // Initialize the first layer of the search lattice, taking into account
-  // that base_offset_[1] == 0. (This is what the DCHECK_EQ is for).
+  // that the rank of {dest} is dest.
+  CostType* const first_layer = mem_.NewLayer(1);
   for (int dest = 0; dest < num_nodes_; ++dest) {
-    DCHECK_EQ(dest, mem_.BaseOffset(1, NodeSet::Singleton(dest)));
-    mem_.SetValueAtOffset(dest, cost_matrix_[0][dest]);
+    DCHECK_EQ(static_cast<uint64>(dest),
+              mem_.SetRank(NodeSet::Singleton(dest)));
+    first_layer[dest] = cost_matrix_[0][dest];
   }
 
   // Populate the dynamic programming lattice layer by layer, by iterating
-  // on cardinality.
-  for (int card = 2; card <= num_nodes_; ++card) {
-    // Iterate on sets of same cardinality.
-    for (NodeSet set : SetRangeWithCardinality<Set<uint32>>(card, num_nodes_)) {
-      // Using BaseOffset and maintaining the node ranks, to reduce the
-      // computational effort for accessing the data.
-      const uint64 set_offset = mem_.BaseOffset(card, set);
-      // The first subset on which we'll iterate is set.RemoveSmallestElement().
-      // Compute its offset. It will be updated incrementaly. This saves about
-      // 30-35% of computation time.
-      uint64 subset_offset = mem_.BaseOffset(card - 1,
-                                             set.RemoveSmallestElement());
-      int prev_dest = set.SmallestElement();
-      int dest_rank = 0;
-      for (int dest : set) {
-        CostType min_cost = std::numeric_limits<CostType>::max();
-        const NodeSet subset = set.RemoveElement(dest);
-        // We compute the offset for subset from the preceding iteration
-        // by taking into account that prev_dest is now in subset, and
-        // that dest is now removed from subset.
-        subset_offset += mem_.OffsetDelta(card - 1, prev_dest, dest, dest_rank);
-        int src_rank = 0;
-        for (int src : subset) {
-          min_cost = std::min(min_cost,
-                              SaturatedAdd(cost_matrix_[src][dest],
-                              mem_.ValueAtOffset(subset_offset + src_rank)));
-          ++src_rank;
-        }
-        prev_dest = dest;
-        mem_.SetValueAtOffset(set_offset + dest_rank, min_cost);
-        ++dest_rank;
-      }
+  // on cardinality. The threads, if any, are started once for all the layers;
+  // the destructor of the pool waits for them to be done.
+  std::unique_ptr<ReusableBarrier> barrier;
+  std::unique_ptr<ThreadPool> pool;
+  if (num_threads_ > 1 && LargestLayerWork(mem_) >= kMinWorkForThreads) {
+    barrier.reset(new ReusableBarrier(num_threads_));
+    layer_barrier_ = barrier.get();
+    layer_computation_ = nullptr;
+    pool.reset(new ThreadPool("HamiltonianPathSolver", num_threads_ - 1));
+    pool->StartWorkers();
+    for (int i = 0; i < num_threads_ - 1; ++i) {
+      pool->Add(NewCallback(this, &HamiltonianPathSolver::RunLayerWorker));
     }
   }
+  for (int card = 2; card <= num_nodes_; ++card) {
+    ComputeLayer(cost_by_dest_.data(), num_nodes_, card, &mem_);
+  }
+  if (layer_barrier_ != nullptr) {
+    // Stops the threads.
+    layer_computation_ = nullptr;
+    layer_barrier_->Wait();
+    layer_barrier_ = nullptr;
+    pool.reset(nullptr);
+  }
 
   const NodeSet full_set = NodeSet::FullSet(num_nodes_);
 
   // Get the cost of the tsp from node 0. It is the path that leaves 0 and goes
   // through all other nodes, and returns at 0, with minimal cost.
   tsp_cost_ = mem_.Value(full_set, 0);
-  tsp_path_ = ComputePath(tsp_cost_, full_set, 0);
 
   hamiltonian_paths_.resize(num_nodes_);
   hamiltonian_costs_.resize(num_nodes_);
@@ -685,27 +1029,129 @@ template <typename CostType> void HamiltonianPathSolver<CostType>::Solve() {
       best_hamiltonian_path_end_node_ = end_node;
     }
     DCHECK_LE(tsp_cost_, cost + cost_matrix_[end_node][0]);
-    // Get the Hamiltonian paths.
-    hamiltonian_paths_[end_node] =
-      ComputePath(hamiltonian_costs_[end_node], hamiltonian_set, end_node);
   }
 
   solved_ = true;
+  has_checkpoints_ = with_checkpoints;
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::RunLayerWorker() {
+  for (;;) {
+    // The first barrier gives the layer to compute, and the second one waits
+    // for all the threads to be done with it.
+    layer_barrier_->Wait();
+    LayerComputation* const computation = layer_computation_;
+    if (computation == nullptr) return;
+    ComputeLayerChunks(computation);
+    layer_barrier_->Wait();
+  }
+}
+
+template <typename CostType>
+uint64 HamiltonianPathSolver<CostType>::LargestLayerWork(
+    const LatticeMemory& mem) {
+  uint64 largest_work = 0;
+  for (int card = 2; card <= mem.max_card(); ++card) {
+    largest_work = std::max(largest_work, mem.NumSets(card) * card * card);
+  }
+  return largest_work;
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::ComputeLayer(
+    const CostType* cost_by_dest, int num_elements, int card,
+    LatticeMemory* mem) {
+  LayerComputation computation(cost_by_dest, num_elements, card, mem);
+  computation.layer = mem->NewLayer(card);
+  const uint64 num_sets = mem->NumSets(card);
+  // The threads are only available during Solve(), i.e. not for the segments
+  // recomputed by ComputePath(), which are small.
+  if (layer_barrier_ == nullptr || num_sets * card * card < kMinWorkForThreads) {
+    ComputeLayerRange(computation, 0, num_sets);
+    return;
+  }
+  layer_computation_ = &computation;
+  layer_barrier_->Wait();
+  ComputeLayerChunks(&computation);
+  layer_barrier_->Wait();
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::ComputeLayerChunks(
+    LayerComputation* computation) {
+  const uint64 kNumSetsPerChunk = 1024;
+  const uint64 num_sets = computation->mem->NumSets(computation->card);
+  while (true) {
+    const uint64 begin =
+        kNumSetsPerChunk * computation->next_chunk.fetch_add(1);
+    if (begin >= num_sets) return;
+    ComputeLayerRange(*computation, begin,
+                      std::min(begin + kNumSetsPerChunk, num_sets));
+  }
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::ComputeLayerRange(
+    const LayerComputation& computation, uint64 begin, uint64 end) {
+  const int card = computation.card;
+  const LatticeMemory& mem = *computation.mem;
+  const CostType* const previous_layer = mem.Layer(card - 1);
+  CostType* const layer = computation.layer;
+  // The elements of the subset of the current set on which the minimum is
+  // computed, in increasing order.
+  int subset_elements[NodeSet::MaxCardinality];
+  SetRangeIterator<SetRangeWithCardinality<NodeSet>> set_it(
+      mem.SetOfRank(card, begin));
+  for (uint64 rank = begin; rank < end; ++rank, ++set_it) {
+    const NodeSet set = *set_it;
+    // The first subset on which we'll iterate is set.RemoveSmallestElement().
+    // Its rank and its elements are updated incrementally.
+    const NodeSet first_subset = set.RemoveSmallestElement();
+    uint64 subset_rank = mem.SetRank(first_subset);
+    int num_subset_elements = 0;
+    for (int node : first_subset) subset_elements[num_subset_elements++] = node;
+    int prev_dest = set.SmallestElement();
+    int dest_rank = 0;
+    for (int dest : set) {
+      // The subset is now set.RemoveElement(dest): prev_dest replaces dest at
+      // the rank dest_rank - 1 in the subset.
+      subset_rank += mem.RankDelta(prev_dest, dest, dest_rank);
+      if (dest_rank > 0) subset_elements[dest_rank - 1] = prev_dest;
+      // This is a min-reduction over two arrays, which the compiler can
+      // vectorize: the values f(subset, src), which are contiguous, and the
+      // costs to dest, gathered from a contiguous row.
+      const CostType* const subset_values =
+          previous_layer + (card - 1) * subset_rank;
+      const CostType* const cost_to_dest =
+          computation.cost_by_dest + dest * computation.num_elements;
+      CostType min_cost = std::numeric_limits<CostType>::max();
+      for (int src_rank = 0; src_rank < card - 1; ++src_rank) {
+        min_cost = std::min(
+            min_cost, SaturatedAdd(cost_to_dest[subset_elements[src_rank]],
+                                   subset_values[src_rank]));
+      }
+      layer[card * rank + dest_rank] = min_cost;
+      prev_dest = dest;
+      ++dest_rank;
+    }
+  }
 }
 
 template <typename CostType>
 std::vector<int> HamiltonianPathSolver<CostType>::ComputePath(
-    CostType cost, NodeSet set, int end_node) {
+    NodeSet set, int end_node) {
   DCHECK(set.Contains(end_node));
   const int path_size = set.Cardinality() + 1;
   std::vector<int> path(path_size, 0);
   NodeSet subset = set.RemoveElement(end_node);
   path[path_size - 1] = end_node;
   int dest = end_node;
+  const CostType cost = mem_.Value(set, end_node);
   CostType current_cost = cost;
   for (int rank = path_size - 2; rank >= 0; --rank) {
     for (int src : subset) {
-      const CostType partial_cost = mem_.Value(subset, src);
+      const CostType partial_cost = PathValue(subset, src);
       const CostType incumbent_cost = partial_cost + cost_matrix_[src][dest];
       // Take precision into account when CosttType is float or double.
       // There is no visible penalty in the case CostType is an integer type.
@@ -724,6 +1170,67 @@ std::vector<int> HamiltonianPathSolver<CostType>::ComputePath(
   return path;
 }
 
+template <typename CostType>
+CostType HamiltonianPathSolver<CostType>::PathValue(NodeSet set, int node) {
+  const int card = set.Cardinality();
+  if (mem_.HasLayer(card)) return mem_.Value(set, node);
+  // The subsets of set are all found in the same segment, down to the
+  // checkpoint layer it is computed from.
+  if (!segment_set_.Includes(set) || card < segment_first_card_) {
+    ComputeSegment(set);
+  }
+  // Renumbers the nodes of set by their rank in segment_set_.
+  typename NodeSet::IntegerType segment_subset = 0;
+  for (int element : set) {
+    segment_subset |= NodeSet::One << segment_set_.ElementRank(element);
+  }
+  return segment_mem_.Value(NodeSet(segment_subset),
+                            segment_set_.ElementRank(node));
+}
+
+template <typename CostType>
+void HamiltonianPathSolver<CostType>::ComputeSegment(NodeSet set) {
+  const int num_elements = set.Cardinality();
+  const int first_card = mem_.LargestLayerAtMost(num_elements);
+  DCHECK_LT(0, first_card);
+  DCHECK_LT(first_card, num_elements);
+  segment_set_ = set;
+  segment_first_card_ = first_card;
+  std::vector<int> elements;
+  for (int element : set) elements.push_back(element);
+  segment_cost_by_dest_.resize(num_elements * num_elements);
+  for (int src = 0; src < num_elements; ++src) {
+    for (int dest = 0; dest < num_elements; ++dest) {
+      segment_cost_by_dest_[dest * num_elements + src] =
+          cost_matrix_[elements[src]][elements[dest]];
+    }
+  }
+  segment_mem_.Init(num_elements, std::vector<bool>(num_elements + 1, true));
+  // Copies the values of the checkpoint layer for the subsets of set. The
+  // renumbering preserves the order of the nodes, hence their ranks.
+  CostType* const first_layer = segment_mem_.NewLayer(first_card);
+  const CostType* const checkpoint_layer = mem_.Layer(first_card);
+  uint64 rank = 0;
+  for (NodeSet subset :
+       SetRangeWithCardinality<NodeSet>(first_card, num_elements)) {
+    typename NodeSet::IntegerType original_subset = 0;
+    for (int element : subset) {
+      original_subset |= NodeSet::One << elements[element];
+    }
+    const uint64 checkpoint_offset =
+        first_card * mem_.SetRank(NodeSet(original_subset));
+    for (int i = 0; i < first_card; ++i) {
+      first_layer[first_card * rank + i] =
+          checkpoint_layer[checkpoint_offset + i];
+    }
+    ++rank;
+  }
+  for (int card = first_card + 1; card <= num_elements; ++card) {
+    ComputeLayer(segment_cost_by_dest_.data(), num_elements, card,
+                 &segment_mem_);
+  }
+}
+
 template <typename CostType>
 bool HamiltonianPathSolver<CostType>::PathIsValid(const std::vector<int>& path,
                                                   CostType cost) {
@@ -784,37 +1291,44 @@ bool HamiltonianPathSolver<CostType>::VerifiesTriangleInequality() {
 
 template <typename CostType>
 int HamiltonianPathSolver<CostType>::BestHamiltonianPathEndNode() {
-  Solve();
+  Solve(!cost_only_);
   return best_hamiltonian_path_end_node_;
 }
 
 template <typename CostType>
 CostType HamiltonianPathSolver<CostType>::HamiltonianCost(int end_node) {
-  Solve();
+  Solve(!cost_only_);
   return hamiltonian_costs_[end_node];
 }
 
 template <typename CostType>
 std::vector<int> HamiltonianPathSolver<CostType>::HamiltonianPath(int end_node) {
-  Solve();
+  Solve(true);
+  if (end_node != 0 && hamiltonian_paths_[end_node].empty()) {
+    hamiltonian_paths_[end_node] =
+        ComputePath(NodeSet::FullSet(num_nodes_).RemoveElement(0), end_node);
+  }
   return hamiltonian_paths_[end_node];
 }
 
 template <typename CostType>
 void HamiltonianPathSolver<CostType>::HamiltonianPath(
     std::vector<PathNodeIndex>* path) {
-  *path = HamiltonianPath(best_hamiltonian_path_end_node_);
+  *path = HamiltonianPath(BestHamiltonianPathEndNode());
 }
 
 template <typename CostType>
 CostType HamiltonianPathSolver<CostType>::TravelingSalesmanCost() {
-  Solve();
+  Solve(!cost_only_);
   return tsp_cost_;
 }
 
 template <typename CostType>
 std::vector<int> HamiltonianPathSolver<CostType>::TravelingSalesmanPath() {
-  Solve();
+  Solve(true);
+  if (tsp_path_.empty()) {
+    tsp_path_ = ComputePath(NodeSet::FullSet(num_nodes_), 0);
+  }
   return tsp_path_;
 }
 
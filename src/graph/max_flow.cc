@@ -15,13 +15,17 @@
 #include "graph/max_flow.h"
 
 #include <algorithm>
+#include <atomic>  // NOLINT
 
+#include "base/callback.h"
 #include "base/stringprintf.h"
+#include "base/synchronization.h"
+#include "base/threadpool.h"
 #include "graph/graphs.h"
 
 namespace operations_research {
 
-SimpleMaxFlow::SimpleMaxFlow() : num_nodes_(0) {}
+SimpleMaxFlow::SimpleMaxFlow() : num_nodes_(0), num_threads_(1) {}
 
 ArcIndex SimpleMaxFlow::AddArcWithCapacity(NodeIndex tail, NodeIndex head,
                                            FlowQuantity capacity) {
@@ -65,8 +69,15 @@ SimpleMaxFlow::Status SimpleMaxFlow::Solve(NodeIndex source, NodeIndex sink) {
     underlying_graph_->AddArc(arc_tail_[arc], arc_head_[arc]);
   }
   underlying_graph_->Build(&arc_permutation_);
-  underlying_max_flow_.reset(
-      new GenericMaxFlow<Graph>(underlying_graph_.get(), source, sink));
+  if (num_threads_ > 1) {
+    ParallelMaxFlow* const parallel_max_flow =
+        new ParallelMaxFlow(underlying_graph_.get(), source, sink);
+    parallel_max_flow->SetNumThreads(num_threads_);
+    underlying_max_flow_.reset(parallel_max_flow);
+  } else {
+    underlying_max_flow_.reset(
+        new GenericMaxFlow<Graph>(underlying_graph_.get(), source, sink));
+  }
   for (ArcIndex arc = 0; arc < num_arcs; ++arc) {
     ArcIndex permuted_arc =
         arc < arc_permutation_.size() ? arc_permutation_[arc] : arc;
@@ -977,4 +988,331 @@ template class GenericMaxFlow<ReverseArcListGraph<> >;
 template class GenericMaxFlow<ReverseArcStaticGraph<> >;
 template class GenericMaxFlow<ReverseArcMixedGraph<> >;
 
+// ----- ParallelMaxFlow -----
+
+namespace {
+
+// The nodes of a step are given to the threads by chunks of this size, to
+// balance the work between them.
+const int kNodeChunkSize = 64;
+
+}  // namespace
+
+struct ParallelMaxFlow::ParallelState {
+  ParallelState(NodeIndex num_nodes, int num_threads)
+      : barrier(num_threads),
+        step(STOP_THREADS),
+        step_nodes(nullptr),
+        next_chunk(0),
+        bfs_level(0),
+        added_excess(new std::atomic<FlowQuantity>[num_nodes]),
+        is_discovered(new std::atomic<uint8>[num_nodes]),
+        is_in_working_set(num_nodes, 0),
+        new_height(num_nodes, 0),
+        thread_nodes(num_threads),
+        thread_relabel_work(num_threads, 0) {
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      added_excess[node].store(0, std::memory_order_relaxed);
+      is_discovered[node].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  ReusableBarrier barrier;
+
+  // The current step and the nodes it processes (all the nodes if nullptr).
+  // next_chunk is the index of the next chunk of nodes to process.
+  Step step;
+  const std::vector<NodeIndex>* step_nodes;
+  std::atomic<int64> next_chunk;
+
+  // The height given to the nodes reached by the current SCAN_BFS_LEVEL step.
+  NodeHeight bfs_level;
+
+  // The excess received by each node during the current round, added to
+  // node_excess_ at the end of the round.
+  std::unique_ptr<std::atomic<FlowQuantity>[]> added_excess;
+
+  // Whether a node is already in the list of nodes to process at the end of
+  // the current round (or, during a global update, whether it was reached by
+  // the breadth-first search). The source and the sink are always marked.
+  std::unique_ptr<std::atomic<uint8>[]> is_discovered;
+
+  // The active nodes discharged by the current round, and a boolean vector
+  // version of it which is read-only during the round.
+  std::vector<NodeIndex> working_set;
+  std::vector<uint8> is_in_working_set;
+
+  // The height of the nodes of working_set after the current round. The
+  // heights in node_potential_ are those of the previous round.
+  std::vector<NodeHeight> new_height;
+
+  // The nodes whose excess or height changed during the current round, i.e.
+  // working_set and the nodes discovered by it.
+  std::vector<NodeIndex> round_nodes;
+
+  // The nodes found by each thread during the current step, and the number of
+  // arcs each thread scanned to relabel nodes since the last global update.
+  std::vector<std::vector<NodeIndex> > thread_nodes;
+  std::vector<int64> thread_relabel_work;
+};
+
+ParallelMaxFlow::ParallelMaxFlow(const Graph* graph, NodeIndex source,
+                                 NodeIndex sink)
+    : GenericMaxFlow<Graph>(graph, source, sink), num_threads_(1) {}
+
+ParallelMaxFlow::~ParallelMaxFlow() {}
+
+void ParallelMaxFlow::RefineWithGlobalUpdate() {
+  if (num_threads_ <= 1 || !use_two_phase_algorithm_) {
+    GenericMaxFlow<Graph>::RefineWithGlobalUpdate();
+    return;
+  }
+  phase_stats_.Reset();
+  state_.reset(new ParallelState(graph_->num_nodes(), num_threads_));
+  {
+    // The calling thread is the thread 0. The destructor of the pool waits for
+    // the other threads, which return after the STOP_THREADS step.
+    ThreadPool pool("ParallelMaxFlow", num_threads_ - 1);
+    pool.StartWorkers();
+    for (int i = 1; i < num_threads_; ++i) {
+      pool.Add(NewCallback(this, &ParallelMaxFlow::RunWorker, i));
+    }
+    while (true) {
+      phase_stats_.source_saturation.StartTimer();
+      const bool flow_pushed = SaturateOutgoingArcsFromSource();
+      phase_stats_.source_saturation.StopTimerAndAddElapsedTime();
+      if (!flow_pushed) break;
+      DischargeAllActiveNodes();
+      phase_stats_.excess_return.StartTimer();
+      PushFlowExcessBackToSource();
+      phase_stats_.excess_return.StopTimerAndAddElapsedTime();
+    }
+    RunStep(STOP_THREADS, nullptr);
+  }
+  state_.reset();
+  VLOG(1) << phase_stats_.StatString();
+}
+
+void ParallelMaxFlow::RunStep(Step step, const std::vector<NodeIndex>* nodes) {
+  state_->step = step;
+  state_->step_nodes = nodes;
+  state_->next_chunk.store(0, std::memory_order_relaxed);
+  // The first wait starts the step in all the threads, the second one waits
+  // for all of them to be done with it.
+  state_->barrier.Wait();
+  if (step == STOP_THREADS) return;
+  ProcessStep(0);
+  state_->barrier.Wait();
+}
+
+void ParallelMaxFlow::RunWorker(int thread_index) {
+  while (true) {
+    state_->barrier.Wait();
+    if (state_->step == STOP_THREADS) return;
+    ProcessStep(thread_index);
+    state_->barrier.Wait();
+  }
+}
+
+void ParallelMaxFlow::ProcessStep(int thread_index) {
+  ParallelState* const state = state_.get();
+  const std::vector<NodeIndex>* const nodes = state->step_nodes;
+  const int64 num_nodes =
+      nodes == nullptr ? graph_->num_nodes() : nodes->size();
+  while (true) {
+    const int64 begin = kNodeChunkSize * state->next_chunk.fetch_add(
+                                             1, std::memory_order_relaxed);
+    if (begin >= num_nodes) return;
+    const int64 end = std::min<int64>(begin + kNodeChunkSize, num_nodes);
+    for (int64 i = begin; i < end; ++i) {
+      const NodeIndex node = nodes == nullptr ? i : (*nodes)[i];
+      switch (state->step) {
+        case DISCHARGE_ACTIVE_NODES:
+          DischargeActiveNode(thread_index, node);
+          break;
+        case UPDATE_ROUND_NODES:
+          UpdateRoundNode(thread_index, node);
+          break;
+        case RESET_HEIGHTS:
+          node_potential_[node] = 2 * graph_->num_nodes() - 1;
+          state->is_discovered[node].store(0, std::memory_order_relaxed);
+          break;
+        case SCAN_BFS_LEVEL:
+          ScanBfsNode(thread_index, node);
+          break;
+        case COLLECT_ACTIVE_NODES:
+          CollectActiveNode(thread_index, node);
+          break;
+        case STOP_THREADS:
+          return;
+      }
+    }
+  }
+}
+
+void ParallelMaxFlow::DischargeActiveNode(int thread_index, NodeIndex node) {
+  ParallelState* const state = state_.get();
+  const NodeIndex num_nodes = graph_->num_nodes();
+  const NodeHeight height = node_potential_[node];
+  FlowQuantity excess = node_excess_[node];
+  DCHECK_GT(excess, 0);
+
+  // Push on the admissible arcs. Note that the heights are checked before the
+  // residual capacities: the capacities of an arc that is not admissible in
+  // either direction may be read by the thread discharging the other end, but
+  // they are not modified by anyone.
+  for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+    const ArcIndex arc = it.Index();
+    const NodeIndex head = Head(arc);
+    if (node_potential_[head] + 1 != height) continue;
+    const FlowQuantity residual_capacity = residual_arc_capacity_[arc];
+    if (residual_capacity == 0) continue;
+    const FlowQuantity delta = std::min(excess, residual_capacity);
+    residual_arc_capacity_[arc] -= delta;
+    residual_arc_capacity_[Opposite(arc)] += delta;
+    excess -= delta;
+    state->added_excess[head].fetch_add(delta, std::memory_order_relaxed);
+    if (state->is_discovered[head].load(std::memory_order_relaxed) == 0 &&
+        state->is_discovered[head].exchange(1, std::memory_order_relaxed) ==
+            0) {
+      state->thread_nodes[thread_index].push_back(head);
+    }
+    if (excess == 0) break;
+  }
+  node_excess_[node] = excess;
+  state->new_height[node] = height;
+  if (excess == 0) return;
+
+  // Relabel the node. All its admissible arcs are now saturated. The residual
+  // capacity of an arc towards an active node one level higher may be
+  // increased by this node during the round, so it is not read and the arc is
+  // assumed to be residual: this gives a valid but maybe too small height.
+  NodeHeight min_height = std::numeric_limits<NodeHeight>::max();
+  int64 num_scanned_arcs = 0;
+  for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+    const ArcIndex arc = it.Index();
+    const NodeIndex head = Head(arc);
+    const NodeHeight head_height = node_potential_[head];
+    ++num_scanned_arcs;
+    if (head_height >= min_height) continue;
+    if ((head_height == height + 1 && state->is_in_working_set[head]) ||
+        residual_arc_capacity_[arc] > 0) {
+      min_height = head_height;
+    }
+  }
+  state->thread_relabel_work[thread_index] += num_scanned_arcs;
+  state->new_height[node] =
+      min_height >= num_nodes ? 2 * num_nodes - 1 : min_height + 1;
+}
+
+void ParallelMaxFlow::UpdateRoundNode(int thread_index, NodeIndex node) {
+  ParallelState* const state = state_.get();
+  if (state->is_in_working_set[node]) {
+    node_potential_[node] = state->new_height[node];
+  }
+  node_excess_[node] +=
+      state->added_excess[node].exchange(0, std::memory_order_relaxed);
+  const bool is_active = node_excess_[node] > 0 &&
+                         node_potential_[node] < graph_->num_nodes();
+  state->is_in_working_set[node] = is_active;
+  state->is_discovered[node].store(is_active, std::memory_order_relaxed);
+  if (is_active) state->thread_nodes[thread_index].push_back(node);
+}
+
+void ParallelMaxFlow::ScanBfsNode(int thread_index, NodeIndex node) {
+  ParallelState* const state = state_.get();
+  for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+    const ArcIndex arc = it.Index();
+    const NodeIndex head = Head(arc);
+    if (state->is_discovered[head].load(std::memory_order_relaxed) != 0) {
+      continue;
+    }
+    if (residual_arc_capacity_[Opposite(arc)] == 0) continue;
+    if (state->is_discovered[head].exchange(1, std::memory_order_relaxed) ==
+        0) {
+      node_potential_[head] = state->bfs_level;
+      state->thread_nodes[thread_index].push_back(head);
+    }
+  }
+}
+
+void ParallelMaxFlow::CollectActiveNode(int thread_index, NodeIndex node) {
+  ParallelState* const state = state_.get();
+  const bool is_active = node != source_ && node != sink_ &&
+                         node_excess_[node] > 0 &&
+                         node_potential_[node] < graph_->num_nodes();
+  state->is_in_working_set[node] = is_active;
+  state->is_discovered[node].store(
+      is_active || node == source_ || node == sink_,
+      std::memory_order_relaxed);
+  if (is_active) state->thread_nodes[thread_index].push_back(node);
+}
+
+void ParallelMaxFlow::GatherThreadNodes(std::vector<NodeIndex>* nodes) {
+  for (std::vector<NodeIndex>& thread_nodes : state_->thread_nodes) {
+    nodes->insert(nodes->end(), thread_nodes.begin(), thread_nodes.end());
+    thread_nodes.clear();
+  }
+}
+
+void ParallelMaxFlow::ParallelGlobalUpdate() {
+  phase_stats_.global_update.StartTimer();
+  ParallelState* const state = state_.get();
+  RunStep(RESET_HEIGHTS, nullptr);
+  node_potential_[source_] = graph_->num_nodes();
+  node_potential_[sink_] = 0;
+  state->is_discovered[source_].store(1, std::memory_order_relaxed);
+  state->is_discovered[sink_].store(1, std::memory_order_relaxed);
+
+  // Note that contrary to GlobalUpdate(), the excess of the nodes is not
+  // modified, so that the levels can be scanned in parallel.
+  std::vector<NodeIndex> level(1, sink_);
+  std::vector<NodeIndex> next_level;
+  for (NodeHeight height = 1; !level.empty(); ++height) {
+    state->bfs_level = height;
+    RunStep(SCAN_BFS_LEVEL, &level);
+    next_level.clear();
+    GatherThreadNodes(&next_level);
+    level.swap(next_level);
+  }
+
+  // The nodes which were not reached cannot reach the sink and keep the
+  // height 2 * num_nodes - 1 given by RESET_HEIGHTS.
+  state->working_set.clear();
+  RunStep(COLLECT_ACTIVE_NODES, nullptr);
+  GatherThreadNodes(&state->working_set);
+  std::fill(state->thread_relabel_work.begin(),
+            state->thread_relabel_work.end(), 0);
+  phase_stats_.global_update.StopTimerAndAddElapsedTime();
+}
+
+void ParallelMaxFlow::DischargeAllActiveNodes() {
+  ParallelState* const state = state_.get();
+  // A global update costs O(num_nodes + num_arcs), so one is done each time
+  // the relabels have scanned about as many arcs.
+  const int64 global_update_threshold =
+      graph_->num_nodes() + 2 * static_cast<int64>(graph_->num_arcs());
+  ParallelGlobalUpdate();
+  while (!state->working_set.empty()) {
+    phase_stats_.discharge.StartTimer();
+    phase_stats_.active_nodes_per_round.Add(state->working_set.size());
+    RunStep(DISCHARGE_ACTIVE_NODES, &state->working_set);
+
+    // The working set and the discovered nodes are disjoint since the nodes
+    // of the working set are marked as discovered.
+    state->round_nodes.swap(state->working_set);
+    GatherThreadNodes(&state->round_nodes);
+    RunStep(UPDATE_ROUND_NODES, &state->round_nodes);
+    state->working_set.clear();
+    GatherThreadNodes(&state->working_set);
+    node_excess_[sink_] +=
+        state->added_excess[sink_].exchange(0, std::memory_order_relaxed);
+    phase_stats_.discharge.StopTimerAndAddElapsedTime();
+
+    int64 relabel_work = 0;
+    for (const int64 work : state->thread_relabel_work) relabel_work += work;
+    if (relabel_work > global_update_threshold) ParallelGlobalUpdate();
+  }
+}
+
 }  // namespace operations_research
@@ -187,6 +187,10 @@ class SimpleMaxFlow {
   };
   Status Solve(NodeIndex source, NodeIndex sink);
 
+  // Sets the number of threads used by the next Solve() calls. With more than
+  // one thread, the ParallelMaxFlow algorithm is used. The default is 1.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+
   // Returns the maximum flow we can send from the source to the sink in the
   // last OPTIMAL Solve() context.
   FlowQuantity OptimalFlow() const;
@@ -222,6 +226,7 @@ class SimpleMaxFlow {
   std::vector<ArcIndex> arc_permutation_;
   std::vector<FlowQuantity> arc_flow_;
   FlowQuantity optimal_flow_;
+  int num_threads_;
 
   // Note that we cannot free the graph before we stop using the max-flow
   // instance that uses it.
@@ -467,9 +472,10 @@ class GenericMaxFlow : public MaxFlowStatusClass {
     }
   }
 
-  // Performs optimization step.
+  // Performs optimization step. RefineWithGlobalUpdate() is virtual so that
+  // ParallelMaxFlow can replace it with a parallel version.
   void Refine();
-  void RefineWithGlobalUpdate();
+  virtual void RefineWithGlobalUpdate();
 
   // Discharges an active node node by saturating its admissible adjacent arcs,
   // if any, and by relabelling it when it becomes inactive.
@@ -640,6 +646,109 @@ class MaxFlow : public GenericMaxFlow<StarGraph> {
       : GenericMaxFlow(graph, source, target) {}
 };
 
+// A parallel version of the two-phase push-relabel algorithm of
+// GenericMaxFlow, for ReverseArcStaticGraph<>. Only the first phase, which
+// computes the value of the maximum flow and a minimum cut and usually takes
+// most of the time, is parallel. The preflow is then turned into a flow by
+// GenericMaxFlow::PushFlowExcessBackToSource() as in the sequential version.
+//
+// The first phase is the synchronous variant of the push-relabel algorithm:
+// at each round, all the active nodes are discharged in parallel using the
+// heights of the previous round, and then relabeled if they still have some
+// excess. With these heights, an arc and its opposite can never be admissible
+// at the same time, so the residual capacities of an arc are only modified by
+// one thread during a round and need no locking. Only the excess received by
+// a node is shared, and it is accumulated with atomic additions. The global
+// update heuristic is a breadth-first search from the sink done level by level,
+// each level being scanned in parallel. See for instance: N. Baumstark, G.
+// Blelloch, J. Shun, "Efficient implementation of a synchronous parallel
+// push-relabel algorithm", ESA 2015, LNCS 9294:106-117.
+//
+// The value of the maximum flow and the status are the same as the ones of
+// GenericMaxFlow, but the flow on each arc may differ since there are usually
+// many maximum flows. With one thread, or if the two-phase algorithm or the
+// global update are disabled, the sequential algorithm is used.
+class ParallelMaxFlow : public GenericMaxFlow<ReverseArcStaticGraph<> > {
+ public:
+  typedef ReverseArcStaticGraph<> Graph;
+
+  ParallelMaxFlow(const Graph* graph, NodeIndex source, NodeIndex sink);
+  ~ParallelMaxFlow() override;
+
+  // Sets the number of threads used by Solve(), including the calling one.
+  void SetNumThreads(int num_threads) { num_threads_ = num_threads; }
+
+  // Returns the time spent in each phase of the last Solve() and the number
+  // of active nodes processed at each round, as a human-readable string.
+  std::string PhaseStatString() const { return phase_stats_.StatString(); }
+
+ protected:
+  void RefineWithGlobalUpdate() override;
+
+ private:
+  // The data used by the threads during a Solve(), see the .cc.
+  struct ParallelState;
+
+  // The different steps run in parallel by all the threads. Each one processes
+  // a list of nodes, or all the nodes of the graph.
+  enum Step {
+    DISCHARGE_ACTIVE_NODES,
+    UPDATE_ROUND_NODES,
+    RESET_HEIGHTS,
+    SCAN_BFS_LEVEL,
+    COLLECT_ACTIVE_NODES,
+    STOP_THREADS
+  };
+
+  // Runs the given step on the given nodes (or on all the nodes if nodes is
+  // nullptr) with all the threads, and returns when it is done.
+  void RunStep(Step step, const std::vector<NodeIndex>* nodes);
+
+  // The loop run by the threads other than the calling one.
+  void RunWorker(int thread_index);
+
+  // Processes the part of the current step given to thread_index.
+  void ProcessStep(int thread_index);
+
+  // The work done by the steps on a single node.
+  void DischargeActiveNode(int thread_index, NodeIndex node);
+  void UpdateRoundNode(int thread_index, NodeIndex node);
+  void ScanBfsNode(int thread_index, NodeIndex node);
+  void CollectActiveNode(int thread_index, NodeIndex node);
+
+  // Discharges all the active nodes which can reach the sink, by rounds.
+  void DischargeAllActiveNodes();
+
+  // Recomputes the exact height of all the nodes with a parallel breadth-first
+  // search from the sink in the reverse residual graph, and resets the set of
+  // active nodes to process.
+  void ParallelGlobalUpdate();
+
+  // Moves the nodes found by each thread during the last step to nodes.
+  void GatherThreadNodes(std::vector<NodeIndex>* nodes);
+
+  struct PhaseStats : public StatsGroup {
+    PhaseStats()
+        : StatsGroup("ParallelMaxFlow"),
+          source_saturation("source_saturation", this),
+          discharge("discharge", this),
+          global_update("global_update", this),
+          excess_return("excess_return", this),
+          active_nodes_per_round("active_nodes_per_round", this) {}
+    TimeDistribution source_saturation;
+    TimeDistribution discharge;
+    TimeDistribution global_update;
+    TimeDistribution excess_return;
+    IntegerDistribution active_nodes_per_round;
+  };
+
+  int num_threads_;
+  std::unique_ptr<ParallelState> state_;
+  PhaseStats phase_stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelMaxFlow);
+};
+
 #endif  // SWIG
 
 template <typename Element, typename IntegerPriority>
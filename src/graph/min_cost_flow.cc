@@ -16,13 +16,18 @@
 
 #include <algorithm>
 #include <cmath>
+#include <deque>
+#include <functional>
 #include <limits>
+#include <queue>
+#include <utility>
 
 #include "base/commandlineflags.h"
 #include "base/stringprintf.h"
 #include "base/mathutil.h"
 #include "graph/graphs.h"
 #include "graph/max_flow.h"
+#include "graph/network_simplex.h"
 
 // TODO(user): Remove these flags and expose the parameters in the API.
 // New clients, please do not use these flags!
@@ -63,7 +68,14 @@ GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::GenericMinCostFlow(
       stats_("MinCostFlow"),
       feasibility_checked_(false),
       use_price_update_(false),
-      check_feasibility_(FLAGS_min_cost_flow_check_feasibility) {
+      check_feasibility_(FLAGS_min_cost_flow_check_feasibility),
+      use_warm_start_(false),
+      can_warm_start_(false),
+      modified_arcs_(),
+      all_arcs_modified_(false),
+      modified_nodes_(),
+      all_nodes_modified_(false),
+      excess_nodes_() {
   const NodeIndex max_num_nodes = Graphs<Graph>::NodeReservation(*graph_);
   if (max_num_nodes > 0) {
     node_excess_.Reserve(0, max_num_nodes - 1);
@@ -94,6 +106,19 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::SetNodeSupply(
   initial_node_excess_.Set(node, supply);
   status_ = NOT_SOLVED;
   feasibility_checked_ = false;
+  can_warm_start_ = false;
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::
+    SetNodeSupplyKeepingFlow(NodeIndex node, FlowQuantity supply) {
+  DCHECK(graph_->IsNodeValid(node));
+  node_excess_.Set(node,
+                   node_excess_[node] + supply - initial_node_excess_[node]);
+  initial_node_excess_.Set(node, supply);
+  MarkNodeAsModified(node);
+  status_ = NOT_SOLVED;
+  feasibility_checked_ = false;
 }
 
 template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
@@ -102,6 +127,7 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::SetArcUnitCost(
   DCHECK(IsArcDirect(arc));
   scaled_arc_unit_cost_.Set(arc, unit_cost);
   scaled_arc_unit_cost_.Set(Opposite(arc), -scaled_arc_unit_cost_[arc]);
+  MarkArcAsModified(arc);
   status_ = NOT_SOLVED;
   feasibility_checked_ = false;
 }
@@ -116,6 +142,7 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::SetArcCapacity(
   if (capacity_delta == 0) {
     return;  // Nothing to do.
   }
+  MarkArcAsModified(arc);
   status_ = NOT_SOLVED;
   feasibility_checked_ = false;
   const FlowQuantity new_availability = free_capacity + capacity_delta;
@@ -154,6 +181,7 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::SetArcFlow(
   residual_arc_capacity_.Set(Opposite(arc), new_flow);
   residual_arc_capacity_.Set(arc, capacity - new_flow);
   status_ = NOT_SOLVED;
+  can_warm_start_ = false;
   feasibility_checked_ = false;
 }
 
@@ -378,10 +406,9 @@ bool GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::MakeFeasible() {
     return false;
   }
   for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
-    const FlowQuantity excess = feasible_node_excess_[node];
-    node_excess_.Set(node, excess);
-    initial_node_excess_.Set(node, excess);
+    SetNodeSupply(node, feasible_node_excess_[node]);
   }
+  feasibility_checked_ = true;
   return true;
 }
 
@@ -498,15 +525,28 @@ bool GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::Solve() {
     status_ = INFEASIBLE;
     return false;
   }
-  node_potential_.SetAll(0);
+  const bool warm_start = use_warm_start_ && can_warm_start_;
+  can_warm_start_ = false;
+  if (!warm_start) node_potential_.SetAll(0);
   ResetFirstAdmissibleArcs();
   ScaleCosts();
-  Optimize();
+  if (warm_start) {
+    WarmStartOptimize();
+  } else {
+    Optimize();
+  }
+  modified_arcs_.clear();
+  all_arcs_modified_ = false;
+  modified_nodes_.clear();
+  all_nodes_modified_ = false;
   if (FLAGS_min_cost_flow_check_result && !CheckResult()) {
     status_ = BAD_RESULT;
     UnscaleCosts();
     return false;
   }
+  if (use_warm_start_ && !warm_start && status_ == OPTIMAL) {
+    ComputeExactPotentials();
+  }
   UnscaleCosts();
   if (status_ != OPTIMAL) {
     LOG(DFATAL) << "Status != OPTIMAL";
@@ -518,6 +558,8 @@ bool GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::Solve() {
     const FlowQuantity flow_on_arc = residual_arc_capacity_[Opposite(arc)];
     total_flow_cost_ += scaled_arc_unit_cost_[arc] * flow_on_arc;
   }
+  NormalizePotentials();
+  can_warm_start_ = use_warm_start_;
   status_ = OPTIMAL;
   IF_STATS_ENABLED(VLOG(1) << stats_.StatString());
   return true;
@@ -574,6 +616,259 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::Optimize() {
   }
 }
 
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::WarmStartOptimize() {
+  SCOPED_TIME_STAT(&stats_);
+  // The reduced costs of all the residual arcs are non-negative, so epsilon_
+  // can be set to its final value. Note that discharging the active nodes by
+  // push and relabel operations with such a small epsilon, or with a scaled
+  // epsilon as in Optimize(), is usually much slower than solving from scratch
+  // because it changes the potentials of most of the nodes. Successive
+  // shortest paths only change the potentials of the nodes they visit.
+  epsilon_ = 1LL;
+  RestoreOptimality();
+  const NodeIndex num_nodes = graph_->num_nodes();
+  path_distance_.assign(num_nodes, std::numeric_limits<CostValue>::max());
+  path_arc_.assign(num_nodes, Graph::kNilArc);
+
+  // Only the ends of the modified arcs and the modified nodes can have an
+  // excess, since the flow was optimal, hence balanced, before.
+  excess_nodes_.clear();
+  if (all_arcs_modified_ || all_nodes_modified_) {
+    for (NodeIndex node = 0; node < num_nodes; ++node) {
+      if (IsActive(node)) excess_nodes_.push_back(node);
+    }
+  } else {
+    // path_distance_ is used to skip the duplicates.
+    const auto add_if_active = [this](NodeIndex node) {
+      if (IsActive(node) && path_distance_[node] != 0) {
+        path_distance_[node] = 0;
+        excess_nodes_.push_back(node);
+      }
+    };
+    for (const ArcIndex arc : modified_arcs_) {
+      add_if_active(Tail(arc));
+      add_if_active(Head(arc));
+    }
+    for (const NodeIndex node : modified_nodes_) add_if_active(node);
+    for (const NodeIndex node : excess_nodes_) {
+      path_distance_[node] = std::numeric_limits<CostValue>::max();
+    }
+  }
+
+  while (!excess_nodes_.empty()) {
+    if (!AugmentAlongShortestPaths()) {
+      status_ = INFEASIBLE;
+      LOG(ERROR) << "Infeasible problem.";
+      return;
+    }
+    // The augmentations never create an excess, so the worklist only shrinks.
+    excess_nodes_.erase(
+        std::remove_if(excess_nodes_.begin(), excess_nodes_.end(),
+                       [this](NodeIndex node) { return !IsActive(node); }),
+        excess_nodes_.end());
+  }
+  if (status_ == NOT_SOLVED) {
+    status_ = OPTIMAL;
+  }
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::RestoreOptimality() {
+  SCOPED_TIME_STAT(&stats_);
+  if (all_arcs_modified_) {
+    for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
+      const CostValue tail_potential = node_potential_[node];
+      for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+        const ArcIndex arc = it.Index();
+        if (FastIsAdmissible(arc, tail_potential)) {
+          FastPushFlow(residual_arc_capacity_[arc], arc, node);
+        }
+      }
+    }
+    return;
+  }
+  for (const ArcIndex modified_arc : modified_arcs_) {
+    // Note that at most one of the two arcs can be admissible since their
+    // reduced costs are opposite.
+    const ArcIndex arcs[2] = {modified_arc, Opposite(modified_arc)};
+    for (const ArcIndex arc : arcs) {
+      if (IsAdmissible(arc)) PushFlow(residual_arc_capacity_[arc], arc);
+    }
+  }
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+bool GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::AugmentAlongShortestPaths() {
+  SCOPED_TIME_STAT(&stats_);
+  // Dijkstra's algorithm from all the nodes with an excess at once, with the
+  // reduced costs as arc lengths, until the settled nodes have enough deficit
+  // to absorb the whole excess. Each settled node with a deficit is then the
+  // end of a shortest path from one of the nodes with an excess, so a single
+  // search is used for many augmentations.
+  typedef std::pair<CostValue, NodeIndex> QueueElement;
+  std::priority_queue<QueueElement, std::vector<QueueElement>,
+                      std::greater<QueueElement> > queue;
+  std::vector<NodeIndex> reached_nodes;
+  std::vector<NodeIndex> settled_nodes;
+  std::vector<NodeIndex> deficit_nodes;
+  FlowQuantity remaining_excess = 0;
+  for (const NodeIndex node : excess_nodes_) {
+    DCHECK_LT(0, node_excess_[node]);
+    remaining_excess += node_excess_[node];
+    path_distance_[node] = 0;
+    reached_nodes.push_back(node);
+    queue.push(QueueElement(0, node));
+  }
+  while (!queue.empty() && remaining_excess > 0) {
+    const CostValue distance = queue.top().first;
+    const NodeIndex node = queue.top().second;
+    queue.pop();
+    if (distance > path_distance_[node]) continue;
+    settled_nodes.push_back(node);
+    if (node_excess_[node] < 0) {
+      deficit_nodes.push_back(node);
+      remaining_excess += node_excess_[node];
+    }
+    const CostValue tail_potential = node_potential_[node];
+    for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+      const ArcIndex arc = it.Index();
+      if (residual_arc_capacity_[arc] == 0) continue;
+      const CostValue reduced_cost = FastReducedCost(arc, tail_potential);
+      DCHECK_LE(0, reduced_cost)
+          << DebugString("AugmentAlongShortestPaths", arc);
+      const NodeIndex head = Head(arc);
+      const CostValue head_distance = distance + reduced_cost;
+      if (head_distance < path_distance_[head]) {
+        if (path_distance_[head] == std::numeric_limits<CostValue>::max()) {
+          reached_nodes.push_back(head);
+        }
+        path_distance_[head] = head_distance;
+        path_arc_[head] = arc;
+        queue.push(QueueElement(head_distance, head));
+      }
+    }
+  }
+
+  if (!deficit_nodes.empty()) {
+    // Decreasing the potential of each settled node by the difference between
+    // the largest settled distance and its distance keeps the reduced costs
+    // non-negative, and makes them zero on the shortest path tree. The other
+    // nodes keep their potential.
+    const CostValue max_distance = path_distance_[settled_nodes.back()];
+    for (const NodeIndex node : settled_nodes) {
+      node_potential_.Set(node, node_potential_[node] -
+                                    (max_distance - path_distance_[node]));
+    }
+
+    // Push as much flow as possible on the path to each deficit node. The
+    // paths may share arcs, in which case the first ones can saturate them:
+    // the remaining flow is then left for the next search.
+    for (const NodeIndex deficit_node : deficit_nodes) {
+      FlowQuantity flow = -node_excess_[deficit_node];
+      NodeIndex node = deficit_node;
+      while (path_arc_[node] != Graph::kNilArc) {
+        const ArcIndex arc = path_arc_[node];
+        flow = std::min(flow,
+                        static_cast<FlowQuantity>(residual_arc_capacity_[arc]));
+        node = Tail(arc);
+      }
+      flow = std::min(flow, node_excess_[node]);
+      if (flow <= 0) continue;
+      node = deficit_node;
+      while (path_arc_[node] != Graph::kNilArc) {
+        const ArcIndex arc = path_arc_[node];
+        node = Tail(arc);
+        PushFlow(flow, arc);
+      }
+    }
+  }
+  for (const NodeIndex node : reached_nodes) {
+    path_distance_[node] = std::numeric_limits<CostValue>::max();
+    path_arc_[node] = Graph::kNilArc;
+  }
+  return !deficit_nodes.empty();
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::ComputeExactPotentials() {
+  SCOPED_TIME_STAT(&stats_);
+  // This is a label-correcting shortest path algorithm, where the potential of
+  // the head of a residual arc with a negative reduced cost is decreased so
+  // that this reduced cost becomes zero. It terminates because the scaled cost
+  // of any cycle of the residual graph is non-negative, since the flow is
+  // optimal. As the reduced costs are all at least -1, this only changes the
+  // potentials of few nodes by small amounts. Note that the exact shortest
+  // path distances from a virtual root would also work, but they make many
+  // reduced costs zero, which makes the searches of WarmStartOptimize()
+  // visit many more nodes.
+  const NodeIndex num_nodes = graph_->num_nodes();
+  std::vector<bool> in_queue(num_nodes, true);
+  std::deque<NodeIndex> queue;
+  for (NodeIndex node = 0; node < num_nodes; ++node) queue.push_back(node);
+  while (!queue.empty()) {
+    const NodeIndex node = queue.front();
+    queue.pop_front();
+    in_queue[node] = false;
+    const CostValue tail_potential = node_potential_[node];
+    for (IncidentArcIterator it(*graph_, node); it.Ok(); it.Next()) {
+      const ArcIndex arc = it.Index();
+      if (!FastIsAdmissible(arc, tail_potential)) continue;
+      const NodeIndex head = Head(arc);
+      node_potential_.Set(head, node_potential_[head] +
+                                    FastReducedCost(arc, tail_potential));
+      if (!in_queue[head]) {
+        in_queue[head] = true;
+        queue.push_back(head);
+      }
+    }
+  }
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::MarkArcAsModified(ArcIndex arc) {
+  if (all_arcs_modified_) return;
+  if (static_cast<int64>(modified_arcs_.size()) >= graph_->num_arcs()) {
+    // Not worth tracking anymore, RestoreOptimality() will scan all the arcs.
+    // This also bounds the memory used by modified_arcs_.
+    modified_arcs_.clear();
+    all_arcs_modified_ = true;
+    return;
+  }
+  modified_arcs_.push_back(arc);
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::MarkNodeAsModified(NodeIndex node) {
+  if (all_nodes_modified_) return;
+  if (static_cast<int64>(modified_nodes_.size()) >= graph_->num_nodes()) {
+    modified_nodes_.clear();
+    all_nodes_modified_ = true;
+    return;
+  }
+  modified_nodes_.push_back(node);
+}
+
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::NormalizePotentials() {
+  if (graph_->num_nodes() == 0) return;
+  CostValue max_potential = node_potential_[0];
+  for (NodeIndex node = 1; node < graph_->num_nodes(); ++node) {
+    max_potential = std::max(max_potential, node_potential_[node]);
+  }
+  if (max_potential == 0) return;
+  for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
+    node_potential_.Set(node, node_potential_[node] - max_potential);
+  }
+}
+
 template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
 void GenericMinCostFlow<Graph, ArcFlowType,
                         ArcScaledCostType>::SaturateAdmissibleArcs() {
@@ -788,7 +1083,12 @@ void GenericMinCostFlow<Graph, ArcFlowType, ArcScaledCostType>::Refine() {
   SCOPED_TIME_STAT(&stats_);
   SaturateAdmissibleArcs();
   InitializeActiveNodeStack();
+  DischargeActiveNodes();
+}
 
+template <typename Graph, typename ArcFlowType, typename ArcScaledCostType>
+void GenericMinCostFlow<Graph, ArcFlowType,
+                        ArcScaledCostType>::DischargeActiveNodes() {
   const NodeIndex num_nodes = graph_->num_nodes();
   while (status_ != INFEASIBLE && !active_nodes_.empty()) {
     // TODO(user): Experiment with different factors in front of num_nodes.
@@ -976,7 +1276,8 @@ template class GenericMinCostFlow<ReverseArcStaticGraph<uint16, int32>,
                                   /*ArcFlowType=*/int16,
                                   /*ArcScaledCostType=*/int32>;
 
-SimpleMinCostFlow::SimpleMinCostFlow() {}
+SimpleMinCostFlow::SimpleMinCostFlow()
+    : optimal_cost_(0), maximum_flow_(0), algorithm_(COST_SCALING) {}
 
 void SimpleMinCostFlow::SetNodeSupply(NodeIndex node, FlowQuantity supply) {
   ResizeNodeVectors(node);
@@ -1089,33 +1390,51 @@ SimpleMinCostFlow::Status SimpleMinCostFlow::SolveWithPossibleAdjustment(
     return INFEASIBLE;
   }
 
-  GenericMinCostFlow<Graph> min_cost_flow(&graph);
+  switch (algorithm_) {
+    case NETWORK_SIMPLEX: {
+      NetworkSimplexMinCostFlow<Graph> min_cost_flow(&graph);
+      return SolveMinCostFlow(source, sink, &min_cost_flow);
+    }
+    case COST_SCALING: {
+      GenericMinCostFlow<Graph> min_cost_flow(&graph);
+      min_cost_flow.SetCheckFeasibility(false);
+      return SolveMinCostFlow(source, sink, &min_cost_flow);
+    }
+  }
+  LOG(DFATAL) << "Unknown algorithm: " << algorithm_;
+  return BAD_RESULT;
+}
+
+template <typename MinCostFlowSolver>
+SimpleMinCostFlow::Status SimpleMinCostFlow::SolveMinCostFlow(
+    NodeIndex source, NodeIndex sink, MinCostFlowSolver* min_cost_flow) {
+  const NodeIndex num_nodes = node_supply_.size();
+  const ArcIndex num_arcs = arc_capacity_.size();
   ArcIndex arc;
   for (arc = 0; arc < num_arcs; ++arc) {
     ArcIndex permuted_arc = PermutedArc(arc);
-    min_cost_flow.SetArcUnitCost(permuted_arc, arc_cost_[arc]);
-    min_cost_flow.SetArcCapacity(permuted_arc, arc_capacity_[arc]);
+    min_cost_flow->SetArcUnitCost(permuted_arc, arc_cost_[arc]);
+    min_cost_flow->SetArcCapacity(permuted_arc, arc_capacity_[arc]);
   }
   for (NodeIndex node = 0; node < num_nodes; ++node) {
     if (node_supply_[node] != 0) {
       ArcIndex permuted_arc = PermutedArc(arc);
-      min_cost_flow.SetArcCapacity(permuted_arc, std::abs(node_supply_[node]));
-      min_cost_flow.SetArcUnitCost(permuted_arc, 0);
+      min_cost_flow->SetArcCapacity(permuted_arc, std::abs(node_supply_[node]));
+      min_cost_flow->SetArcUnitCost(permuted_arc, 0);
       ++arc;
     }
   }
-  min_cost_flow.SetNodeSupply(source, maximum_flow_);
-  min_cost_flow.SetNodeSupply(sink, -maximum_flow_);
-  min_cost_flow.SetCheckFeasibility(false);
+  min_cost_flow->SetNodeSupply(source, maximum_flow_);
+  min_cost_flow->SetNodeSupply(sink, -maximum_flow_);
 
   arc_flow_.resize(num_arcs);
-  if (min_cost_flow.Solve()) {
-    optimal_cost_ = min_cost_flow.GetOptimalCost();
+  if (min_cost_flow->Solve()) {
+    optimal_cost_ = min_cost_flow->GetOptimalCost();
     for (arc = 0; arc < num_arcs; ++arc) {
-      arc_flow_[arc] = min_cost_flow.Flow(PermutedArc(arc));
+      arc_flow_[arc] = min_cost_flow->Flow(PermutedArc(arc));
     }
   }
-  return min_cost_flow.status();
+  return min_cost_flow->status();
 }
 
 CostValue SimpleMinCostFlow::OptimalCost() const { return optimal_cost_; }
@@ -152,6 +152,27 @@
 // changes to better accomodate with the API of the rest of our tools. A demand
 // is denoted by a negative supply.
 //
+// Warm start: when SetUseWarmStart(true) is used, Solve() does not start from
+// scratch but from the flow and the node potentials of the last successful
+// Solve(). After a solve from scratch, the potentials are made exact, i.e. such
+// that the reduced costs of all the residual arcs are non-negative, by a
+// label-correcting algorithm. When the problem is then modified, the modified
+// arcs which become admissible are saturated, which restores the exactness at
+// the price of some excesses and deficits at their ends, and the supply changes
+// made with SetNodeSupplyKeepingFlow() are simply added to the excesses. Only
+// the nodes at the ends of the modified arcs and the nodes whose supply changed
+// can then have an excess, and they are kept in a worklist. The excesses are then sent to the deficits
+// along successive shortest paths in the residual graph, computed by Dijkstra's
+// algorithm with the reduced costs as lengths. Each search starts from all the
+// excesses at once, stops as soon as it has reached enough deficit to absorb
+// them and only changes the potentials of the nodes it settled, so that the
+// work depends on the extent of the changes rather than on the size of the
+// problem. This makes re-solving a problem after a small modification of the
+// supplies, costs or capacities much faster than solving it from scratch. On
+// the other hand, on graphs where the neighborhoods grow quickly (e.g. random
+// graphs), each search can visit most of the graph, and a warm start is only
+// faster for very small modifications.
+//
 // TODO(user): See whether the following can bring any improvements on real-life
 // problems.
 // R.K. Ahuja, A.V. Goldberg, J.B. Orlin, and R.E. Tarjan, "Finding minimum-cost
@@ -218,6 +239,16 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   // valid nodes will always be [0, NumNodes()).
   SimpleMinCostFlow();
 
+  // The algorithms that Solve() can use: the cost-scaling push-relabel
+  // algorithm of GenericMinCostFlow, which is the default, or the network
+  // simplex of NetworkSimplexMinCostFlow (see network_simplex.h), which is
+  // often faster on sparse problems.
+  enum Algorithm {
+    COST_SCALING,
+    NETWORK_SIMPLEX
+  };
+  void SetAlgorithm(Algorithm algorithm) { algorithm_ = algorithm; }
+
   // Adds a directed arc from tail to head to the underlying graph with
   // a given capacity and cost per unit of flow.
   // * Node indices and the capacity must be non-negative (>= 0).
@@ -288,6 +319,12 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   // Solves the problem, potentially applying supply and demand adjustment,
   // and returns the problem status.
   Status SolveWithPossibleAdjustment(SupplyAdjustment adjustment);
+  // Solves the min-cost flow problem built by SolveWithPossibleAdjustment()
+  // on the augmented graph with the given algorithm, and fills arc_flow_ and
+  // optimal_cost_.
+  template <typename MinCostFlowSolver>
+  Status SolveMinCostFlow(NodeIndex source, NodeIndex sink,
+                          MinCostFlowSolver* min_cost_flow);
   void ResizeNodeVectors(NodeIndex node);
 
   std::vector<NodeIndex> arc_tail_;
@@ -299,6 +336,7 @@ class SimpleMinCostFlow : public MinCostFlowBase {
   std::vector<FlowQuantity> arc_flow_;
   CostValue optimal_cost_;
   FlowQuantity maximum_flow_;
+  Algorithm algorithm_;
 
   DISALLOW_COPY_AND_ASSIGN(SimpleMinCostFlow);
 };
@@ -345,9 +383,15 @@ class GenericMinCostFlow : public MinCostFlowBase {
   Status status() const { return status_; }
 
   // Sets the supply corresponding to node. A demand is modeled as a negative
-  // supply.
+  // supply. This also resets the excess of the node to the supply, so the
+  // next Solve() starts from scratch.
   void SetNodeSupply(NodeIndex node, FlowQuantity supply);
 
+  // Same as SetNodeSupply(), but the excess of the node changes by the
+  // difference with its previous supply, so that the current flow is kept and
+  // the next Solve() can be warm-started, see SetUseWarmStart().
+  void SetNodeSupplyKeepingFlow(NodeIndex node, FlowQuantity supply);
+
   // Sets the unit cost for the given arc.
   void SetArcUnitCost(ArcIndex arc, ArcScaledCostType unit_cost);
 
@@ -416,6 +460,14 @@ class GenericMinCostFlow : public MinCostFlowBase {
   // forever.
   void SetCheckFeasibility(bool value) { check_feasibility_ = value; }
 
+  // Whether Solve() starts from the flow and the node potentials of the last
+  // successful Solve(), see the comment at the top of this file. The problem
+  // can be modified between the two calls with SetNodeSupplyKeepingFlow(),
+  // SetArcUnitCost() and SetArcCapacity(), but not the graph. Solve() starts
+  // from scratch if there is no such previous solution, or after a call to
+  // SetNodeSupply() or SetArcFlow().
+  void SetUseWarmStart(bool value) { use_warm_start_ = value; }
+
  private:
   // Returns true if the given arc is admissible i.e. if its residual capacity
   // is strictly positive, and its reduced cost strictly negative, i.e., pushing
@@ -470,6 +522,39 @@ class GenericMinCostFlow : public MinCostFlowBase {
   // Optimizes the cost by dividing epsilon_ by alpha_ and calling Refine().
   void Optimize();
 
+  // Optimizes the cost starting from the flow and the exact potentials of the
+  // last successful Solve(), using successive shortest paths.
+  void WarmStartOptimize();
+
+  // Saturates the admissible arcs among the ones modified since the last
+  // Solve() and their opposites, so that the reduced costs of all the residual
+  // arcs are non-negative.
+  void RestoreOptimality();
+
+  // Finds shortest paths in the residual graph from the nodes with a positive
+  // excess to the closest nodes with a negative excess, updates the potentials
+  // so that the reduced costs stay non-negative and pushes as much flow as
+  // possible along the paths. The nodes with a positive excess are the ones in
+  // excess_nodes_. Returns false if there is no such path.
+  bool AugmentAlongShortestPaths();
+
+  // Decreases the potentials of the optimal flow computed by Optimize(), for
+  // which the reduced costs of the residual arcs are at least -1 (epsilon_),
+  // so that they become non-negative. Must be called while the costs are
+  // scaled.
+  void ComputeExactPotentials();
+
+  // Records that the cost or the capacity of the given arc changed.
+  void MarkArcAsModified(ArcIndex arc);
+
+  // Records that the supply of the given node changed.
+  void MarkNodeAsModified(NodeIndex node);
+
+  // Shifts all the node potentials so that the largest one is zero. This does
+  // not change the reduced costs and keeps the potentials far from overflowing
+  // when they are reused by many warm-started solves.
+  void NormalizePotentials();
+
   // Saturates the admissible arcs, i.e., push as much flow as possible.
   void SaturateAdmissibleArcs();
 
@@ -493,6 +578,10 @@ class GenericMinCostFlow : public MinCostFlowBase {
   // and discharging the active nodes.
   void Refine();
 
+  // Discharges the nodes of active_nodes_, and the ones they activate, until
+  // there is no active node left or the problem is found infeasible.
+  void DischargeActiveNodes();
+
   // Discharges an active node by saturating its admissible adjacent arcs,
   // if any, and by relabelling it when it becomes inactive.
   void Discharge(NodeIndex node);
@@ -602,6 +691,34 @@ class GenericMinCostFlow : public MinCostFlowBase {
   // Whether to check the problem feasibility with a max-flow.
   bool check_feasibility_;
 
+  // Whether to warm-start Solve() from the last optimal solution.
+  bool use_warm_start_;
+
+  // Whether the flow and the node potentials are the ones of the last
+  // successful Solve(), with exact potentials, so that the next Solve() can be
+  // warm-started.
+  bool can_warm_start_;
+
+  // The tentative distance of each node and the last arc of its shortest path
+  // in AugmentAlongShortestPaths(), reset after each search.
+  std::vector<CostValue> path_distance_;
+  std::vector<ArcIndex> path_arc_;
+
+  // The arcs modified since the last Solve(), possibly with duplicates, unless
+  // all_arcs_modified_ is true in which case all the arcs are considered to be
+  // modified.
+  std::vector<ArcIndex> modified_arcs_;
+  bool all_arcs_modified_;
+
+  // Same as modified_arcs_ and all_arcs_modified_, for the nodes whose supply
+  // changed since the last Solve().
+  std::vector<NodeIndex> modified_nodes_;
+  bool all_nodes_modified_;
+
+  // The nodes which may have a positive excess in WarmStartOptimize(). All the
+  // others have none.
+  std::vector<NodeIndex> excess_nodes_;
+
   DISALLOW_COPY_AND_ASSIGN(GenericMinCostFlow);
 };
 
@@ -0,0 +1,537 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file is a port of the network simplex of the LEMON library
+// (lemon/network_simplex.h, http://lemon.cs.elte.hu), adapted to the graphs
+// and the types of this library. The original code carries the following
+// notice:
+//
+//   Copyright (C) 2003-2010
+//   Egervary Jeno Kombinatorikus Optimalizalasi Kutatocsoport
+//   (Egervary Research Group on Combinatorial Optimization, EGRES).
+//
+//   Permission to use, modify and distribute this software is granted
+//   provided that this copyright notice appears in all copies. For
+//   precise terms see the accompanying LICENSE file.
+//
+//   This software is provided "AS IS" with no warranty of any kind,
+//   express or implied, and with no claim as to its suitability for any
+//   purpose.
+//
+// The LICENSE file of LEMON is the Boost Software License, Version 1.0:
+//
+//   Permission is hereby granted, free of charge, to any person or
+//   organization obtaining a copy of the software and accompanying
+//   documentation covered by this license (the "Software") to use,
+//   reproduce, display, distribute, execute, and transmit the Software, and
+//   to prepare derivative works of the Software, and to permit third-parties
+//   to whom the Software is furnished to do so, all subject to the following:
+//
+//   The copyright notices in the Software and this entire statement,
+//   including the above license grant, this restriction and the following
+//   disclaimer, must be included in all copies of the Software, in whole or
+//   in part, and all derivative works of the Software, unless such copies or
+//   derivative works are solely in the form of machine-executable object
+//   code generated by a source language processor.
+//
+//   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+//   NON-INFRINGEMENT. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE
+//   DISTRIBUTING THE SOFTWARE BE LIABLE FOR ANY DAMAGES OR OTHER LIABILITY,
+//   WHETHER IN CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//   SOFTWARE.
+
+#include "graph/network_simplex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+#include "graph/graphs.h"
+
+namespace operations_research {
+
+template <typename Graph>
+NetworkSimplexMinCostFlow<Graph>::NetworkSimplexMinCostFlow(const Graph* graph)
+    : graph_(graph),
+      num_nodes_(0),
+      num_arcs_(0),
+      in_arc_(0),
+      join_(0),
+      u_in_(0),
+      v_in_(0),
+      u_out_(0),
+      delta_(0),
+      block_size_(0),
+      next_arc_(0),
+      total_flow_cost_(0),
+      status_(NOT_SOLVED),
+      num_pivots_(0),
+      num_degenerate_pivots_(0),
+      stats_("NetworkSimplexMinCostFlow") {
+  const NodeIndex max_num_nodes = Graphs<Graph>::NodeReservation(*graph_);
+  if (max_num_nodes > 0) {
+    node_supply_.assign(max_num_nodes, 0);
+  }
+  const ArcIndex max_num_arcs = Graphs<Graph>::ArcReservation(*graph_);
+  if (max_num_arcs > 0) {
+    arc_capacity_.assign(max_num_arcs, 0);
+    arc_unit_cost_.assign(max_num_arcs, 0);
+  }
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::SetNodeSupply(NodeIndex node,
+                                                     FlowQuantity supply) {
+  DCHECK(graph_->IsNodeValid(node));
+  node_supply_[node] = supply;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::SetArcUnitCost(ArcIndex arc,
+                                                      CostValue unit_cost) {
+  DCHECK(Graphs<Graph>::IsArcValid(*graph_, arc));
+  arc_unit_cost_[arc] = unit_cost;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::SetArcCapacity(
+    ArcIndex arc, FlowQuantity new_capacity) {
+  DCHECK_LE(0, new_capacity);
+  DCHECK(Graphs<Graph>::IsArcValid(*graph_, arc));
+  arc_capacity_[arc] = new_capacity;
+  status_ = NOT_SOLVED;
+}
+
+template <typename Graph>
+FlowQuantity NetworkSimplexMinCostFlow<Graph>::Flow(ArcIndex arc) const {
+  DCHECK(Graphs<Graph>::IsArcValid(*graph_, arc));
+  return status_ == OPTIMAL ? flow_[arc] : 0;
+}
+
+template <typename Graph>
+FlowQuantity NetworkSimplexMinCostFlow<Graph>::Capacity(ArcIndex arc) const {
+  DCHECK(Graphs<Graph>::IsArcValid(*graph_, arc));
+  return arc_capacity_[arc];
+}
+
+template <typename Graph>
+CostValue NetworkSimplexMinCostFlow<Graph>::UnitCost(ArcIndex arc) const {
+  DCHECK(Graphs<Graph>::IsArcValid(*graph_, arc));
+  return arc_unit_cost_[arc];
+}
+
+template <typename Graph>
+FlowQuantity NetworkSimplexMinCostFlow<Graph>::Supply(NodeIndex node) const {
+  DCHECK(graph_->IsNodeValid(node));
+  return node_supply_[node];
+}
+
+template <typename Graph>
+CostValue NetworkSimplexMinCostFlow<Graph>::Potential(NodeIndex node) const {
+  DCHECK(graph_->IsNodeValid(node));
+  return status_ == OPTIMAL ? potential_[node] : 0;
+}
+
+template <typename Graph>
+bool NetworkSimplexMinCostFlow<Graph>::Solve() {
+  SCOPED_TIME_STAT(&stats_);
+  status_ = NOT_SOLVED;
+  total_flow_cost_ = 0;
+  num_pivots_ = 0;
+  num_degenerate_pivots_ = 0;
+  FlowQuantity total_supply = 0;
+  for (NodeIndex node = 0; node < graph_->num_nodes(); ++node) {
+    total_supply += node_supply_[node];
+  }
+  if (total_supply != 0) {
+    status_ = UNBALANCED;
+    LOG(ERROR) << "Unbalanced problem: the total supply is " << total_supply;
+    return false;
+  }
+  if (!InitializeTree()) {
+    status_ = BAD_COST_RANGE;
+    LOG(ERROR) << "Costs too large: the artificial arcs would overflow.";
+    return false;
+  }
+
+  while (FindEnteringArc()) {
+    ++num_pivots_;
+    FindJoinNode();
+    const bool change = FindLeavingArc();
+    if (delta_ == 0) ++num_degenerate_pivots_;
+    ChangeFlow(change);
+    if (change) {
+      UpdateTreeStructure();
+      UpdatePotentials();
+    }
+  }
+
+  // The artificial arcs only carry flow if the supplies cannot be routed
+  // through the arcs of the graph.
+  for (ArcIndex arc = num_arcs_; arc < num_arcs_ + num_nodes_; ++arc) {
+    if (flow_[arc] > 0) {
+      status_ = INFEASIBLE;
+      LOG(ERROR) << "Infeasible problem.";
+      return false;
+    }
+  }
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    total_flow_cost_ += flow_[arc] * cost_[arc];
+  }
+  status_ = OPTIMAL;
+  VLOG(1) << "Network simplex: " << num_pivots_ << " pivots, "
+          << num_degenerate_pivots_ << " degenerate.";
+  IF_STATS_ENABLED(VLOG(1) << stats_.StatString());
+  return true;
+}
+
+template <typename Graph>
+bool NetworkSimplexMinCostFlow<Graph>::InitializeTree() {
+  SCOPED_TIME_STAT(&stats_);
+  num_nodes_ = graph_->num_nodes();
+  num_arcs_ = graph_->num_arcs();
+  const ArcIndex num_all_arcs = num_arcs_ + num_nodes_;
+  const NodeIndex root = num_nodes_;
+
+  // Any path made of arcs of the graph costs less than
+  // num_nodes_ * max_cost, which is the cost of the artificial arcs.
+  CostValue max_cost = 0;
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    max_cost = std::max(max_cost, std::abs(arc_unit_cost_[arc]));
+  }
+  const CostValue kMaxCost = std::numeric_limits<CostValue>::max();
+  if (max_cost + 1 > kMaxCost / 4 / (num_nodes_ + 1)) return false;
+  const CostValue artificial_cost = (max_cost + 1) * (num_nodes_ + 1);
+
+  source_.resize(num_all_arcs);
+  target_.resize(num_all_arcs);
+  capacity_.resize(num_all_arcs);
+  cost_.resize(num_all_arcs);
+  flow_.assign(num_all_arcs, 0);
+  arc_state_.assign(num_all_arcs, kLower);
+  for (ArcIndex arc = 0; arc < num_arcs_; ++arc) {
+    source_[arc] = graph_->Tail(arc);
+    target_[arc] = graph_->Head(arc);
+    capacity_[arc] = arc_capacity_[arc];
+    cost_[arc] = arc_unit_cost_[arc];
+  }
+
+  potential_.resize(num_nodes_ + 1);
+  parent_.resize(num_nodes_ + 1);
+  parent_arc_.resize(num_nodes_ + 1);
+  parent_arc_direction_.resize(num_nodes_ + 1);
+  thread_.resize(num_nodes_ + 1);
+  reverse_thread_.resize(num_nodes_ + 1);
+  subtree_size_.resize(num_nodes_ + 1);
+  last_successor_.resize(num_nodes_ + 1);
+
+  // The initial tree is a star centered on the root, whose thread visits the
+  // nodes in increasing order. Each node sends its supply to the root, or
+  // receives its demand from it.
+  parent_[root] = -1;
+  parent_arc_[root] = Graph::kNilArc;
+  parent_arc_direction_[root] = kUp;
+  thread_[root] = 0;
+  reverse_thread_[0] = root;
+  subtree_size_[root] = num_nodes_ + 1;
+  last_successor_[root] = root - 1;
+  potential_[root] = 0;
+  for (NodeIndex node = 0; node < num_nodes_; ++node) {
+    const ArcIndex arc = num_arcs_ + node;
+    parent_[node] = root;
+    parent_arc_[node] = arc;
+    thread_[node] = node + 1;
+    reverse_thread_[node + 1] = node;
+    subtree_size_[node] = 1;
+    last_successor_[node] = node;
+    capacity_[arc] = std::numeric_limits<FlowQuantity>::max();
+    arc_state_[arc] = kTree;
+    if (node_supply_[node] >= 0) {
+      parent_arc_direction_[node] = kUp;
+      potential_[node] = 0;
+      source_[arc] = node;
+      target_[arc] = root;
+      flow_[arc] = node_supply_[node];
+      cost_[arc] = 0;
+    } else {
+      parent_arc_direction_[node] = kDown;
+      potential_[node] = artificial_cost;
+      source_[arc] = root;
+      target_[arc] = node;
+      flow_[arc] = -node_supply_[node];
+      cost_[arc] = artificial_cost;
+    }
+  }
+  if (num_nodes_ == 0) last_successor_[root] = root;
+
+  block_size_ = std::max(static_cast<ArcIndex>(std::sqrt(num_arcs_)),
+                         static_cast<ArcIndex>(10));
+  next_arc_ = 0;
+  return true;
+}
+
+template <typename Graph>
+bool NetworkSimplexMinCostFlow<Graph>::FindEnteringArc() {
+  SCOPED_TIME_STAT(&stats_);
+  // The artificial arcs are never searched: once they leave the tree, they
+  // are not needed anymore.
+  CostValue min_reduced_cost = 0;
+  ArcIndex remaining_in_block = block_size_;
+  ArcIndex arc = next_arc_;
+  for (ArcIndex i = 0; i < num_arcs_; ++i) {
+    const CostValue reduced_cost = SignedReducedCost(arc);
+    if (reduced_cost < min_reduced_cost) {
+      min_reduced_cost = reduced_cost;
+      in_arc_ = arc;
+    }
+    if (++arc == num_arcs_) arc = 0;
+    if (--remaining_in_block == 0) {
+      if (min_reduced_cost < 0) break;
+      remaining_in_block = block_size_;
+    }
+  }
+  next_arc_ = arc;
+  return min_reduced_cost < 0;
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::FindJoinNode() {
+  NodeIndex u = source_[in_arc_];
+  NodeIndex v = target_[in_arc_];
+  // The node with the smallest subtree cannot be an ancestor of the other.
+  while (u != v) {
+    if (subtree_size_[u] < subtree_size_[v]) {
+      u = parent_[u];
+    } else {
+      v = parent_[v];
+    }
+  }
+  join_ = u;
+}
+
+template <typename Graph>
+bool NetworkSimplexMinCostFlow<Graph>::FindLeavingArc() {
+  // The flow changes from first to second on in_arc_, then from second up to
+  // join_, and from join_ down to first along the tree.
+  NodeIndex first;
+  NodeIndex second;
+  if (arc_state_[in_arc_] == kLower) {
+    first = source_[in_arc_];
+    second = target_[in_arc_];
+  } else {
+    first = target_[in_arc_];
+    second = source_[in_arc_];
+  }
+  delta_ = capacity_[in_arc_];
+  int result = 0;
+  // To keep the tree strongly feasible, the leaving arc is the last blocking
+  // arc of the cycle starting from join_ in the direction of the flow: the
+  // ties are resolved in favor of the second side, and of the arcs closest
+  // to join_ on the first side.
+  for (NodeIndex u = first; u != join_; u = parent_[u]) {
+    const ArcIndex arc = parent_arc_[u];
+    const FlowQuantity residual = parent_arc_direction_[u] == kDown
+                                      ? capacity_[arc] - flow_[arc]
+                                      : flow_[arc];
+    if (residual < delta_) {
+      delta_ = residual;
+      u_out_ = u;
+      result = 1;
+    }
+  }
+  for (NodeIndex u = second; u != join_; u = parent_[u]) {
+    const ArcIndex arc = parent_arc_[u];
+    const FlowQuantity residual = parent_arc_direction_[u] == kUp
+                                      ? capacity_[arc] - flow_[arc]
+                                      : flow_[arc];
+    if (residual <= delta_) {
+      delta_ = residual;
+      u_out_ = u;
+      result = 2;
+    }
+  }
+  if (result == 1) {
+    u_in_ = first;
+    v_in_ = second;
+  } else {
+    u_in_ = second;
+    v_in_ = first;
+  }
+  return result != 0;
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::ChangeFlow(bool change) {
+  if (delta_ > 0) {
+    const FlowQuantity value = arc_state_[in_arc_] * delta_;
+    flow_[in_arc_] += value;
+    for (NodeIndex u = source_[in_arc_]; u != join_; u = parent_[u]) {
+      flow_[parent_arc_[u]] -= parent_arc_direction_[u] * value;
+    }
+    for (NodeIndex u = target_[in_arc_]; u != join_; u = parent_[u]) {
+      flow_[parent_arc_[u]] += parent_arc_direction_[u] * value;
+    }
+  }
+  if (change) {
+    arc_state_[in_arc_] = kTree;
+    const ArcIndex out_arc = parent_arc_[u_out_];
+    arc_state_[out_arc] = flow_[out_arc] == 0 ? kLower : kUpper;
+  } else {
+    arc_state_[in_arc_] = -arc_state_[in_arc_];
+  }
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::UpdateTreeStructure() {
+  SCOPED_TIME_STAT(&stats_);
+  const NodeIndex old_reverse_thread = reverse_thread_[u_out_];
+  const NodeIndex old_subtree_size = subtree_size_[u_out_];
+  const NodeIndex old_last_successor = last_successor_[u_out_];
+  const NodeIndex v_out = parent_[u_out_];
+
+  if (u_in_ == u_out_) {
+    // The subtree of u_out_ is simply moved under v_in_.
+    parent_[u_in_] = v_in_;
+    parent_arc_[u_in_] = in_arc_;
+    parent_arc_direction_[u_in_] = u_in_ == source_[in_arc_] ? kUp : kDown;
+    if (thread_[v_in_] != u_out_) {
+      NodeIndex after = thread_[old_last_successor];
+      thread_[old_reverse_thread] = after;
+      reverse_thread_[after] = old_reverse_thread;
+      after = thread_[v_in_];
+      thread_[v_in_] = u_out_;
+      reverse_thread_[u_out_] = v_in_;
+      thread_[old_last_successor] = after;
+      reverse_thread_[after] = old_last_successor;
+    }
+  } else {
+    // The "stem" is the path from u_in_ up to u_out_, whose parent links are
+    // reversed. If old_reverse_thread is v_in_, then join_ is v_out.
+    const NodeIndex thread_continue = old_reverse_thread == v_in_
+                                          ? thread_[old_last_successor]
+                                          : thread_[v_in_];
+    NodeIndex stem = u_in_;
+    NodeIndex new_stem_parent = v_in_;
+    NodeIndex last = last_successor_[u_in_];
+    NodeIndex after = thread_[last];
+    thread_[v_in_] = u_in_;
+    dirty_reverse_threads_.clear();
+    dirty_reverse_threads_.push_back(v_in_);
+    while (stem != u_out_) {
+      // Inserts the next stem node in the thread, after the subtree of stem
+      // without the subtree of the next stem node.
+      const NodeIndex next_stem = parent_[stem];
+      thread_[last] = next_stem;
+      dirty_reverse_threads_.push_back(last);
+
+      // Removes the subtree of stem from the thread.
+      const NodeIndex before = reverse_thread_[stem];
+      thread_[before] = after;
+      reverse_thread_[after] = before;
+
+      parent_[stem] = new_stem_parent;
+      new_stem_parent = stem;
+      stem = next_stem;
+
+      last = last_successor_[stem] == last_successor_[new_stem_parent]
+                 ? reverse_thread_[new_stem_parent]
+                 : last_successor_[stem];
+      after = thread_[last];
+    }
+    parent_[u_out_] = new_stem_parent;
+    thread_[last] = thread_continue;
+    reverse_thread_[thread_continue] = last;
+    last_successor_[u_out_] = last;
+
+    // Removes the subtree of u_out_ from the thread, unless it has already
+    // been done because old_reverse_thread is v_in_.
+    if (old_reverse_thread != v_in_) {
+      thread_[old_reverse_thread] = after;
+      reverse_thread_[after] = old_reverse_thread;
+    }
+    for (const NodeIndex u : dirty_reverse_threads_) {
+      reverse_thread_[thread_[u]] = u;
+    }
+
+    // Reverses the parent arcs and updates the subtree sizes and last
+    // successors along the stem, from u_out_ down to u_in_.
+    NodeIndex size = 0;
+    const NodeIndex last_successor = last_successor_[u_out_];
+    for (NodeIndex u = u_out_, p = parent_[u]; u != u_in_;
+         u = p, p = parent_[u]) {
+      parent_arc_[u] = parent_arc_[p];
+      parent_arc_direction_[u] = -parent_arc_direction_[p];
+      size += subtree_size_[u] - subtree_size_[p];
+      subtree_size_[u] = size;
+      last_successor_[p] = last_successor;
+    }
+    parent_arc_[u_in_] = in_arc_;
+    parent_arc_direction_[u_in_] = u_in_ == source_[in_arc_] ? kUp : kDown;
+    subtree_size_[u_in_] = old_subtree_size;
+  }
+
+  // Updates the last successors from v_in_ and from v_out towards the root.
+  const NodeIndex up_limit_out = last_successor_[join_] == v_in_ ? join_ : -1;
+  const NodeIndex last_successor_out = last_successor_[u_out_];
+  for (NodeIndex u = v_in_; u != -1 && last_successor_[u] == v_in_;
+       u = parent_[u]) {
+    last_successor_[u] = last_successor_out;
+  }
+  if (join_ != old_reverse_thread && v_in_ != old_reverse_thread) {
+    for (NodeIndex u = v_out;
+         u != up_limit_out && last_successor_[u] == old_last_successor;
+         u = parent_[u]) {
+      last_successor_[u] = old_reverse_thread;
+    }
+  } else if (last_successor_out != old_last_successor) {
+    for (NodeIndex u = v_out;
+         u != up_limit_out && last_successor_[u] == old_last_successor;
+         u = parent_[u]) {
+      last_successor_[u] = last_successor_out;
+    }
+  }
+
+  // Updates the subtree sizes from v_in_ and from v_out up to join_.
+  for (NodeIndex u = v_in_; u != join_; u = parent_[u]) {
+    subtree_size_[u] += old_subtree_size;
+  }
+  for (NodeIndex u = v_out; u != join_; u = parent_[u]) {
+    subtree_size_[u] -= old_subtree_size;
+  }
+}
+
+template <typename Graph>
+void NetworkSimplexMinCostFlow<Graph>::UpdatePotentials() {
+  const CostValue sigma = potential_[v_in_] - potential_[u_in_] -
+                          parent_arc_direction_[u_in_] * cost_[in_arc_];
+  const NodeIndex end = thread_[last_successor_[u_in_]];
+  for (NodeIndex u = u_in_; u != end; u = thread_[u]) {
+    potential_[u] += sigma;
+  }
+}
+
+// Explicit instantiations that can be used by a client.
+template class NetworkSimplexMinCostFlow<StarGraph>;
+template class NetworkSimplexMinCostFlow<StaticGraph<> >;
+template class NetworkSimplexMinCostFlow<ListGraph<> >;
+template class NetworkSimplexMinCostFlow<ReverseArcListGraph<> >;
+template class NetworkSimplexMinCostFlow<ReverseArcStaticGraph<> >;
+template class NetworkSimplexMinCostFlow<ReverseArcMixedGraph<> >;
+
+}  // namespace operations_research
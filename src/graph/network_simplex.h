@@ -0,0 +1,304 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file is a port of the network simplex of the LEMON library
+// (lemon/network_simplex.h, http://lemon.cs.elte.hu), adapted to the graphs
+// and the types of this library. The original code carries the following
+// notice:
+//
+//   Copyright (C) 2003-2010
+//   Egervary Jeno Kombinatorikus Optimalizalasi Kutatocsoport
+//   (Egervary Research Group on Combinatorial Optimization, EGRES).
+//
+//   Permission to use, modify and distribute this software is granted
+//   provided that this copyright notice appears in all copies. For
+//   precise terms see the accompanying LICENSE file.
+//
+//   This software is provided "AS IS" with no warranty of any kind,
+//   express or implied, and with no claim as to its suitability for any
+//   purpose.
+//
+// The LICENSE file of LEMON is the Boost Software License, Version 1.0:
+//
+//   Permission is hereby granted, free of charge, to any person or
+//   organization obtaining a copy of the software and accompanying
+//   documentation covered by this license (the "Software") to use,
+//   reproduce, display, distribute, execute, and transmit the Software, and
+//   to prepare derivative works of the Software, and to permit third-parties
+//   to whom the Software is furnished to do so, all subject to the following:
+//
+//   The copyright notices in the Software and this entire statement,
+//   including the above license grant, this restriction and the following
+//   disclaimer, must be included in all copies of the Software, in whole or
+//   in part, and all derivative works of the Software, unless such copies or
+//   derivative works are solely in the form of machine-executable object
+//   code generated by a source language processor.
+//
+//   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+//   OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+//   MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE, TITLE AND
+//   NON-INFRINGEMENT. IN NO EVENT SHALL THE COPYRIGHT HOLDERS OR ANYONE
+//   DISTRIBUTING THE SOFTWARE BE LIABLE FOR ANY DAMAGES OR OTHER LIABILITY,
+//   WHETHER IN CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+//   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//   SOFTWARE.
+
+// An implementation of the primal network simplex algorithm for the min-cost
+// flow problem, as an alternative to the cost-scaling push-relabel algorithm
+// of min_cost_flow.h. The problem and the statuses are the same (see the
+// comments at the top of min_cost_flow.h), but the network simplex is often
+// several times faster on sparse transshipment networks with small supplies,
+// while the cost scaling is more robust on large or dense problems.
+//
+// The algorithm maintains a spanning tree of the graph, extended by an
+// artificial root node linked to every node by an artificial arc, and a flow
+// in which every arc out of the tree is either empty or saturated. The node
+// potentials are defined by the tree arcs, whose reduced costs are zero. At
+// each iteration (pivot), an arc out of the tree whose reduced cost shows that
+// it can decrease the cost enters the tree, the flow is augmented along the
+// cycle that it closes with the tree, and one of the arcs of the cycle that
+// become empty or saturated leaves the tree. The solution is optimal when no
+// arc can enter the tree. The artificial arcs have a large cost, so that they
+// end up with no flow unless the problem is infeasible.
+//
+// As LEMON, the implementation follows the one described in:
+// Z. Kiraly, P. Kovacs, "Efficient implementations of minimum-cost flow
+// algorithms", Acta Universitatis Sapientiae, Informatica 4(1) (2012) 67-118.
+// http://arxiv.org/abs/1207.6381
+// - The tree is stored with parent pointers and a "thread", i.e. a preorder
+//   traversal of the tree as a doubly linked list, together with the size and
+//   the last node of each subtree in this order. This makes the update of the
+//   tree and of the potentials after a pivot proportional to the size of the
+//   subtree that is moved.
+// - The tree is kept "strongly feasible", which prevents cycling on
+//   degenerate pivots.
+// - The entering arc is chosen by "block search" as in:
+//   M. D. Grigoriadis, "An efficient implementation of the network simplex
+//   method", Mathematical Programming Study 26 (1986) 83-111.
+//   The arcs are scanned in blocks of about sqrt(num_arcs) arcs, starting
+//   where the previous search stopped, and the arc with the most negative
+//   reduced cost of the first block containing a candidate is chosen.
+//
+// Example:
+//   typedef ReverseArcStaticGraph<> Graph;
+//   NetworkSimplexMinCostFlow<Graph> network_simplex(&graph);
+//   ... call SetArcUnitCost(), SetArcCapacity() and SetNodeSupply().
+//   if (network_simplex.Solve()) {
+//     LOG(INFO) << network_simplex.GetOptimalCost() << " after "
+//               << network_simplex.num_pivots() << " pivots";
+//   }
+//
+// Keywords: Network simplex, min-cost flow, block search, strongly feasible
+//           tree.
+
+#ifndef OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
+#define OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
+
+#include <string>
+#include <vector>
+
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "graph/ebert_graph.h"
+#include "graph/graph.h"
+#include "graph/min_cost_flow.h"
+#include "util/stats.h"
+
+namespace operations_research {
+
+// Network simplex on any graph of graph.h (or a StarGraph). Only the direct
+// arcs are used, so the graph does not need to have reverse arcs. See the
+// end of network_simplex.cc for the exact types this class is compiled for.
+//
+// The interface mirrors the one of GenericMinCostFlow, so that both can be
+// used interchangeably: SimpleMinCostFlow::SetAlgorithm() selects the one it
+// uses.
+template <typename Graph>
+class NetworkSimplexMinCostFlow : public MinCostFlowBase {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  // Initializes a network simplex on the given graph. The graph does not need
+  // to be fully built yet, but its capacity reservation is used to initialize
+  // the memory of this class. It must be built before Solve() is called.
+  explicit NetworkSimplexMinCostFlow(const Graph* graph);
+
+  // Returns the graph associated to the current object.
+  const Graph* graph() const { return graph_; }
+
+  // Returns the status of the last call to Solve(). NOT_SOLVED is returned
+  // if Solve() has never been called or if the problem has been modified in
+  // such a way that the previous solution becomes invalid.
+  Status status() const { return status_; }
+
+  // Sets the supply corresponding to node. A demand is modeled as a negative
+  // supply.
+  void SetNodeSupply(NodeIndex node, FlowQuantity supply);
+
+  // Sets the unit cost for the given arc.
+  void SetArcUnitCost(ArcIndex arc, CostValue unit_cost);
+
+  // Sets the capacity for the given arc, which must be non-negative.
+  void SetArcCapacity(ArcIndex arc, FlowQuantity new_capacity);
+
+  // Solves the problem, returning true if a min-cost flow could be found.
+  // The supplies must be balanced, otherwise the status is UNBALANCED. The
+  // status is INFEASIBLE if the supplies cannot be routed, and
+  // BAD_COST_RANGE if the costs are so large that the cost of the artificial
+  // arcs would overflow.
+  bool Solve();
+
+  // Returns the cost of the minimum-cost flow found by the algorithm.
+  CostValue GetOptimalCost() const { return total_flow_cost_; }
+
+  // Returns the flow on the given arc.
+  FlowQuantity Flow(ArcIndex arc) const;
+
+  // Returns the capacity of the given arc.
+  FlowQuantity Capacity(ArcIndex arc) const;
+
+  // Returns the unit cost of the given arc.
+  CostValue UnitCost(ArcIndex arc) const;
+
+  // Returns the supply of the given node.
+  FlowQuantity Supply(NodeIndex node) const;
+
+  // Returns the potential of the given node in the optimal solution, i.e. the
+  // dual value of its flow conservation constraint: the reduced cost
+  // UnitCost(arc) + Potential(tail) - Potential(head) of each arc is
+  // non-negative if the arc is not saturated, and non-positive if it has a
+  // positive flow.
+  CostValue Potential(NodeIndex node) const;
+
+  // Number of pivots of the last Solve(), including the degenerate ones,
+  // which change the tree but not the flow.
+  int64 num_pivots() const { return num_pivots_; }
+  int64 num_degenerate_pivots() const { return num_degenerate_pivots_; }
+
+ private:
+  // The state of an arc out of the tree is kLower if it is empty, and kUpper
+  // if it is saturated. The state is also the direction in which the flow of
+  // the arc can change, which simplifies the computation of the reduced costs.
+  enum ArcState { kUpper = -1, kTree = 0, kLower = 1 };
+
+  // The direction of the arc linking a node to its parent in the tree: kUp if
+  // the node is its tail, kDown if it is its head.
+  enum ArcDirection { kDown = -1, kUp = 1 };
+
+  // Copies the graph and the problem to the arrays below, and builds the
+  // initial tree made of the artificial arcs. Returns false if the cost of
+  // the artificial arcs overflows.
+  bool InitializeTree();
+
+  // Finds an arc with a negative reduced cost by block search, and sets
+  // in_arc_ to it. Returns false if there is none, i.e. if the solution is
+  // optimal.
+  bool FindEnteringArc();
+
+  // Sets join_ to the root of the smallest subtree containing both ends of
+  // in_arc_, i.e. the apex of the cycle that in_arc_ closes with the tree.
+  void FindJoinNode();
+
+  // Finds the arc leaving the tree, i.e. the last arc of the cycle, in the
+  // direction of the flow change, which has the smallest residual capacity
+  // delta_. Returns false if this arc is in_arc_ itself, in which case the
+  // tree does not change. Otherwise u_out_ is the node whose arc to its
+  // parent leaves the tree, and u_in_ and v_in_ are the ends of in_arc_ on
+  // the side of u_out_ and on the other side.
+  bool FindLeavingArc();
+
+  // Augments the flow by delta_ along the cycle, and updates the states of
+  // in_arc_ and, if change is true, of the leaving arc.
+  void ChangeFlow(bool change);
+
+  // Replaces the leaving arc by in_arc_ in the tree: the subtree of u_out_ is
+  // re-rooted at u_in_ and attached to v_in_.
+  void UpdateTreeStructure();
+
+  // Updates the potentials of the nodes of the subtree moved by
+  // UpdateTreeStructure(), so that the reduced cost of in_arc_ becomes zero.
+  void UpdatePotentials();
+
+  // Returns the reduced cost of the given arc in the direction in which its
+  // flow can change, which is negative if the arc can enter the tree.
+  CostValue SignedReducedCost(ArcIndex arc) const {
+    return arc_state_[arc] * (cost_[arc] + potential_[source_[arc]] -
+                              potential_[target_[arc]]);
+  }
+
+  // Pointer to the graph passed as argument.
+  const Graph* graph_;
+
+  // The problem, as given by the setters.
+  std::vector<FlowQuantity> node_supply_;
+  std::vector<FlowQuantity> arc_capacity_;
+  std::vector<CostValue> arc_unit_cost_;
+
+  // The working arrays of the algorithm. The arcs of the graph are followed
+  // by one artificial arc per node, linking it to the artificial root, whose
+  // index is num_nodes_.
+  NodeIndex num_nodes_;
+  ArcIndex num_arcs_;
+  std::vector<NodeIndex> source_;
+  std::vector<NodeIndex> target_;
+  std::vector<FlowQuantity> capacity_;
+  std::vector<CostValue> cost_;
+  std::vector<FlowQuantity> flow_;
+  std::vector<int8> arc_state_;
+  std::vector<CostValue> potential_;
+
+  // The spanning tree. For each node: its parent, the arc linking it to its
+  // parent and the direction of this arc, the next and previous nodes in the
+  // thread, the number of nodes of its subtree, and the last node of its
+  // subtree in the thread.
+  std::vector<NodeIndex> parent_;
+  std::vector<ArcIndex> parent_arc_;
+  std::vector<int8> parent_arc_direction_;
+  std::vector<NodeIndex> thread_;
+  std::vector<NodeIndex> reverse_thread_;
+  std::vector<NodeIndex> subtree_size_;
+  std::vector<NodeIndex> last_successor_;
+
+  // Nodes whose reverse_thread_ entry must be recomputed by
+  // UpdateTreeStructure().
+  std::vector<NodeIndex> dirty_reverse_threads_;
+
+  // The state of the current pivot.
+  ArcIndex in_arc_;
+  NodeIndex join_;
+  NodeIndex u_in_;
+  NodeIndex v_in_;
+  NodeIndex u_out_;
+  FlowQuantity delta_;
+
+  // The block search: the number of arcs per block, and the arc from which
+  // the next search starts.
+  ArcIndex block_size_;
+  ArcIndex next_arc_;
+
+  // The result of the last Solve().
+  CostValue total_flow_cost_;
+  Status status_;
+  int64 num_pivots_;
+  int64 num_degenerate_pivots_;
+
+  // Statistics about this class.
+  StatsGroup stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(NetworkSimplexMinCostFlow);
+};
+
+}  // namespace operations_research
+#endif  // OR_TOOLS_GRAPH_NETWORK_SIMPLEX_H_
@@ -0,0 +1,547 @@
+// Copyright 2010-2014 Google
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Shortest path algorithms on the graphs of graph.h (StaticGraph<>,
+// ReverseArcStaticGraph<>, ...) with non-negative integer arc lengths:
+//   - Dijkstra's algorithm, from one source to one target, to a set of
+//     targets, or to all the nodes (ShortestPathSearch).
+//   - A*, i.e. Dijkstra's algorithm guided by a lower bound on the distance to
+//     the target (ShortestPathSearch::ComputeShortestPathWithHeuristic()).
+//   - The bidirectional Dijkstra algorithm, for graphs with reverse arcs
+//     (BidirectionalShortestPathSearch).
+//   - The distance matrix between two sets of nodes, computed with one
+//     search per source in parallel (ComputeShortestPathDistanceMatrix()).
+//
+// Contrary to DijkstraShortestPath() in shortestpaths.h, which asks a callback
+// for the distance between every pair of nodes, these algorithms only scan the
+// arcs of the graph. A search thus runs in O(num_arcs + num_nodes * log(C))
+// where C is the maximum arc length, using the radix heap described in:
+// R.K. Ahuja, K. Mehlhorn, J.B. Orlin, R.E. Tarjan, "Faster algorithms for the
+// shortest path problem", Journal of the ACM 37 (1990) 213-223.
+//
+// Example:
+//   typedef StaticGraph<> Graph;
+//   Graph graph(num_nodes, num_arcs);
+//   std::vector<int64> arc_lengths;
+//   for (...) {
+//     graph.AddArc(tail, head);
+//     arc_lengths.push_back(length);
+//   }
+//   std::vector<Graph::ArcIndex> permutation;
+//   graph.Build(&permutation);
+//   Permute(permutation, &arc_lengths);
+//
+//   ShortestPathSearch<Graph> search(&graph, &arc_lengths);
+//   if (search.ComputeShortestPath(source, target)) {
+//     const int64 distance = search.Distance(target);
+//     std::vector<Graph::NodeIndex> path;
+//     search.GetPath(target, &path);
+//   }
+//
+// The search objects can be reused for many queries. Each query only costs
+// time for the nodes it visits, not for the whole graph.
+
+#ifndef OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
+#define OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
+
+#include <algorithm>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/integral_types.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/threadpool.h"
+#include "util/bitset.h"
+
+namespace operations_research {
+
+// Distance returned for the nodes that are not reachable.
+const int64 kUnreachableDistance = kint64max;
+
+// A priority queue for non-negative integer keys which only supports monotone
+// usage: the keys pushed must never be smaller than the last key popped. This
+// is the case in Dijkstra's algorithm with non-negative arc lengths, and in A*
+// with a consistent heuristic.
+//
+// An element is stored in the bucket given by the position of the highest bit
+// in which its key differs from the last popped key. When the first bucket is
+// empty, the next non-empty bucket is redistributed into the lower ones, so
+// each element moves at most 64 times and Push() is O(1).
+template <typename Value>
+class RadixHeap {
+ public:
+  RadixHeap() : last_key_(0), size_(0) {}
+
+  bool IsEmpty() const { return size_ == 0; }
+
+  // Removes all the elements and allows to push any key again.
+  void Clear() {
+    for (std::vector<Element>& bucket : buckets_) bucket.clear();
+    last_key_ = 0;
+    size_ = 0;
+  }
+
+  void Push(uint64 key, Value value) {
+    DCHECK_GE(key, last_key_);
+    buckets_[BucketIndex(key)].push_back(Element(key, value));
+    ++size_;
+  }
+
+  // Returns the minimum key, and one element with this key. The heap must not
+  // be empty. Note that these functions are not const because they may move
+  // elements between the buckets.
+  uint64 TopKey() {
+    RefillFirstBucket();
+    return last_key_;
+  }
+  Value Top() {
+    RefillFirstBucket();
+    return buckets_[0].back().value;
+  }
+
+  void Pop() {
+    RefillFirstBucket();
+    buckets_[0].pop_back();
+    --size_;
+  }
+
+ private:
+  struct Element {
+    Element(uint64 k, Value v) : key(k), value(v) {}
+    uint64 key;
+    Value value;
+  };
+
+  int BucketIndex(uint64 key) const {
+    return key == last_key_ ? 0
+                            : MostSignificantBitPosition64(key ^ last_key_) + 1;
+  }
+
+  // Makes sure that the first bucket, which contains the elements whose key is
+  // last_key_, is not empty.
+  void RefillFirstBucket() {
+    DCHECK(!IsEmpty());
+    if (!buckets_[0].empty()) return;
+    int i = 1;
+    while (buckets_[i].empty()) ++i;
+    std::vector<Element>& bucket = buckets_[i];
+    uint64 min_key = bucket[0].key;
+    for (const Element& element : bucket) {
+      min_key = std::min(min_key, element.key);
+    }
+    last_key_ = min_key;
+    for (const Element& element : bucket) {
+      buckets_[BucketIndex(element.key)].push_back(element);
+    }
+    bucket.clear();
+  }
+
+  uint64 last_key_;
+  int64 size_;
+  std::vector<Element> buckets_[65];
+
+  DISALLOW_COPY_AND_ASSIGN(RadixHeap);
+};
+
+// Dijkstra's algorithm and A* on a graph with non-negative arc lengths. The
+// graph and the arc lengths (indexed by arc) are not owned and must outlive
+// this class. Only the forward arcs are used, so this works with all the
+// graphs of graph.h.
+//
+// This class is not thread-safe, but several instances can be used in
+// parallel on the same graph.
+template <class Graph>
+class ShortestPathSearch {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  ShortestPathSearch(const Graph* graph, const std::vector<int64>* arc_lengths)
+      : graph_(*graph),
+        arc_lengths_(*arc_lengths),
+        distance_(graph->num_nodes(), kUnreachableDistance),
+        parent_(graph->num_nodes(), -1),
+        is_settled_(graph->num_nodes(), false),
+        is_target_(graph->num_nodes(), false) {}
+
+  // Computes the shortest path from source to target. Returns false if target
+  // is not reachable from source. The search stops as soon as the distance of
+  // target is known, so the other nodes may not be settled.
+  bool ComputeShortestPath(NodeIndex source, NodeIndex target) {
+    Search(source, ZeroHeuristic(),
+           [target](NodeIndex node) { return node == target; });
+    return is_settled_[target];
+  }
+
+  // Same as ComputeShortestPath(), but guided by the given heuristic which
+  // must return, for a node, a lower bound of its distance to target. The
+  // heuristic must be consistent, i.e. heuristic(tail) <= length(arc) +
+  // heuristic(head) for all arcs, which is for instance the case of the
+  // euclidean distance to the target when the arc lengths are at least the
+  // euclidean distance between their nodes. The closer the heuristic is to
+  // the actual distance, the fewer nodes are visited.
+  template <typename Heuristic>
+  bool ComputeShortestPathWithHeuristic(NodeIndex source, NodeIndex target,
+                                        const Heuristic& heuristic) {
+    Search(source, heuristic,
+           [target](NodeIndex node) { return node == target; });
+    return is_settled_[target];
+  }
+
+  // Computes the shortest paths from source to all the given targets. The
+  // search stops when all of them have been reached, or when all the nodes
+  // reachable from source have been settled.
+  void ComputeShortestPathsToTargets(NodeIndex source,
+                                     const std::vector<NodeIndex>& targets) {
+    int num_targets_left = 0;
+    for (const NodeIndex target : targets) {
+      if (!is_target_[target]) {
+        is_target_[target] = true;
+        ++num_targets_left;
+      }
+    }
+    if (num_targets_left == 0) {
+      Reset();
+      return;
+    }
+    Search(source, ZeroHeuristic(), [this, &num_targets_left](NodeIndex node) {
+      return is_target_[node] && --num_targets_left == 0;
+    });
+    for (const NodeIndex target : targets) is_target_[target] = false;
+  }
+
+  // Computes the shortest paths from source to all the nodes of the graph.
+  void ComputeShortestPathsFromSource(NodeIndex source) {
+    Search(source, ZeroHeuristic(), [](NodeIndex) { return false; });
+  }
+
+  // Returns the distance from the source of the last computation to the given
+  // node, or kUnreachableDistance if the node was not reached or if the search
+  // stopped before its distance was known.
+  int64 Distance(NodeIndex node) const {
+    return is_settled_[node] ? distance_[node] : kUnreachableDistance;
+  }
+
+  // Fills path with the nodes of the shortest path from the source of the
+  // last computation to the given node, both included. The node must have a
+  // distance, see Distance().
+  void GetPath(NodeIndex node, std::vector<NodeIndex>* path) const {
+    DCHECK(is_settled_[node]);
+    path->clear();
+    for (NodeIndex n = node; n != -1; n = parent_[n]) path->push_back(n);
+    std::reverse(path->begin(), path->end());
+  }
+
+ private:
+  struct ZeroHeuristic {
+    int64 operator()(NodeIndex) const { return 0; }
+  };
+
+  // Runs Dijkstra's algorithm from source using the keys distance + heuristic
+  // until there is no more node to visit or until should_stop(node) returns
+  // true for a newly settled node.
+  template <typename Heuristic, typename ShouldStop>
+  void Search(NodeIndex source, const Heuristic& heuristic,
+              ShouldStop should_stop) {
+    Reset();
+    Reach(source, 0, -1);
+    queue_.Push(heuristic(source), source);
+    while (!queue_.IsEmpty()) {
+      const NodeIndex node = queue_.Top();
+      queue_.Pop();
+      // The queue may contain several elements for the same node, only the
+      // first one that is popped matters.
+      if (is_settled_[node]) continue;
+      is_settled_[node] = true;
+      if (should_stop(node)) break;
+      const int64 node_distance = distance_[node];
+      for (const ArcIndex arc : graph_.OutgoingArcs(node)) {
+        DCHECK_GE(arc_lengths_[arc], 0);
+        const NodeIndex head = graph_.Head(arc);
+        const int64 head_distance = node_distance + arc_lengths_[arc];
+        if (head_distance < distance_[head]) {
+          Reach(head, head_distance, node);
+          queue_.Push(head_distance + heuristic(head), head);
+        }
+      }
+    }
+  }
+
+  void Reach(NodeIndex node, int64 distance, NodeIndex parent) {
+    if (distance_[node] == kUnreachableDistance) touched_nodes_.push_back(node);
+    distance_[node] = distance;
+    parent_[node] = parent;
+  }
+
+  // Clears the information of the last search in O(number of visited nodes).
+  void Reset() {
+    for (const NodeIndex node : touched_nodes_) {
+      distance_[node] = kUnreachableDistance;
+      parent_[node] = -1;
+      is_settled_[node] = false;
+    }
+    touched_nodes_.clear();
+    queue_.Clear();
+  }
+
+  const Graph& graph_;
+  const std::vector<int64>& arc_lengths_;
+
+  // The tentative distance of each node from the source (final once the node
+  // is settled) and its predecessor on the corresponding path.
+  std::vector<int64> distance_;
+  std::vector<NodeIndex> parent_;
+  std::vector<bool> is_settled_;
+
+  // The nodes whose distance_ is not kUnreachableDistance.
+  std::vector<NodeIndex> touched_nodes_;
+
+  // Used by ComputeShortestPathsToTargets(), always all false otherwise.
+  std::vector<bool> is_target_;
+
+  RadixHeap<NodeIndex> queue_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShortestPathSearch);
+};
+
+// The bidirectional version of Dijkstra's algorithm: a forward search from the
+// source and a backward search from the target are run alternately until the
+// sum of their smallest distances is larger than the length of the best path
+// found where they meet. On road networks this usually visits a lot fewer
+// nodes than a one-directional search.
+//
+// The graph must have reverse arcs (e.g. ReverseArcStaticGraph<>) since the
+// backward search follows the arcs entering the nodes. The arc lengths are
+// indexed by forward arc, as for ShortestPathSearch.
+template <class Graph>
+class BidirectionalShortestPathSearch {
+ public:
+  typedef typename Graph::NodeIndex NodeIndex;
+  typedef typename Graph::ArcIndex ArcIndex;
+
+  BidirectionalShortestPathSearch(const Graph* graph,
+                                  const std::vector<int64>* arc_lengths)
+      : graph_(*graph),
+        arc_lengths_(*arc_lengths),
+        forward_(graph->num_nodes()),
+        backward_(graph->num_nodes()),
+        best_distance_(kUnreachableDistance),
+        meeting_node_(-1) {}
+
+  // Computes the shortest path from source to target. Returns false if target
+  // is not reachable from source.
+  bool ComputeShortestPath(NodeIndex source, NodeIndex target) {
+    forward_.Reset();
+    backward_.Reset();
+    best_distance_ = kUnreachableDistance;
+    meeting_node_ = -1;
+    forward_.Reach(source, 0, -1);
+    backward_.Reach(target, 0, -1);
+    if (source == target) {
+      best_distance_ = 0;
+      meeting_node_ = source;
+      return true;
+    }
+    // Note that when one of the searches has visited all the nodes it can
+    // reach, the best path found is optimal: all the nodes of a shortest path
+    // were reached by this search, including the last one which was also
+    // reached by the other search.
+    while (!forward_.queue.IsEmpty() && !backward_.queue.IsEmpty()) {
+      const int64 forward_key = forward_.queue.TopKey();
+      const int64 backward_key = backward_.queue.TopKey();
+      if (best_distance_ != kUnreachableDistance &&
+          forward_key + backward_key >= best_distance_) {
+        break;
+      }
+      // Advance the search whose smallest distance is the smallest.
+      if (forward_key <= backward_key) {
+        ScanNextNode</*forward=*/true>(&forward_, backward_);
+      } else {
+        ScanNextNode</*forward=*/false>(&backward_, forward_);
+      }
+    }
+    return meeting_node_ != -1;
+  }
+
+  // Returns the distance from source to target of the last computation, or
+  // kUnreachableDistance if there is no path.
+  int64 Distance() const { return best_distance_; }
+
+  // Fills path with the nodes of the last computed shortest path, from source
+  // to target. There must be such a path.
+  void GetPath(std::vector<NodeIndex>* path) const {
+    DCHECK_NE(-1, meeting_node_);
+    path->clear();
+    for (NodeIndex n = meeting_node_; n != -1; n = forward_.parent[n]) {
+      path->push_back(n);
+    }
+    std::reverse(path->begin(), path->end());
+    for (NodeIndex n = backward_.parent[meeting_node_]; n != -1;
+         n = backward_.parent[n]) {
+      path->push_back(n);
+    }
+  }
+
+ private:
+  // The state of the search in one direction. The parent of a node is the
+  // next node on the path towards the origin of the search (i.e. the
+  // successor of the node on the path to the target for the backward search).
+  struct SearchState {
+    explicit SearchState(NodeIndex num_nodes)
+        : distance(num_nodes, kUnreachableDistance),
+          parent(num_nodes, -1),
+          is_settled(num_nodes, false) {}
+
+    void Reach(NodeIndex node, int64 node_distance, NodeIndex node_parent) {
+      if (distance[node] == kUnreachableDistance) touched_nodes.push_back(node);
+      distance[node] = node_distance;
+      parent[node] = node_parent;
+      queue.Push(node_distance, node);
+    }
+
+    void Reset() {
+      for (const NodeIndex node : touched_nodes) {
+        distance[node] = kUnreachableDistance;
+        parent[node] = -1;
+        is_settled[node] = false;
+      }
+      touched_nodes.clear();
+      queue.Clear();
+    }
+
+    std::vector<int64> distance;
+    std::vector<NodeIndex> parent;
+    std::vector<bool> is_settled;
+    std::vector<NodeIndex> touched_nodes;
+    RadixHeap<NodeIndex> queue;
+  };
+
+  // Settles the next node of the given search and relaxes its arcs (the
+  // outgoing ones for the forward search, the incoming ones otherwise). Each
+  // node reached that was also reached by the other search gives a candidate
+  // path.
+  template <bool forward>
+  void ScanNextNode(SearchState* search, const SearchState& other) {
+    const NodeIndex node = search->queue.Top();
+    search->queue.Pop();
+    if (search->is_settled[node]) return;
+    search->is_settled[node] = true;
+    if (forward) {
+      for (const ArcIndex arc : graph_.OutgoingArcs(node)) {
+        RelaxArc(node, graph_.Head(arc), arc_lengths_[arc], search, other);
+      }
+    } else {
+      for (const ArcIndex arc : graph_.IncomingArcs(node)) {
+        RelaxArc(node, graph_.Head(arc), arc_lengths_[graph_.OppositeArc(arc)],
+                 search, other);
+      }
+    }
+  }
+
+  void RelaxArc(NodeIndex node, NodeIndex head, int64 length,
+                SearchState* search, const SearchState& other) {
+    DCHECK_GE(length, 0);
+    const int64 head_distance = search->distance[node] + length;
+    if (head_distance >= search->distance[head]) return;
+    search->Reach(head, head_distance, node);
+    if (other.distance[head] != kUnreachableDistance &&
+        head_distance + other.distance[head] < best_distance_) {
+      best_distance_ = head_distance + other.distance[head];
+      meeting_node_ = head;
+    }
+  }
+
+  const Graph& graph_;
+  const std::vector<int64>& arc_lengths_;
+  SearchState forward_;
+  SearchState backward_;
+
+  // The length of the best path found so far, and the node where the forward
+  // and backward paths meet.
+  int64 best_distance_;
+  NodeIndex meeting_node_;
+
+  DISALLOW_COPY_AND_ASSIGN(BidirectionalShortestPathSearch);
+};
+
+namespace internal {
+
+// The data shared by the threads of ComputeShortestPathDistanceMatrix().
+template <class Graph>
+struct DistanceMatrixData {
+  const Graph* graph;
+  const std::vector<int64>* arc_lengths;
+  const std::vector<typename Graph::NodeIndex>* sources;
+  const std::vector<typename Graph::NodeIndex>* targets;
+  std::vector<int64>* distances;
+};
+
+// Fills the rows first_source, first_source + source_step, ... of the
+// distance matrix. Different calls can be run in parallel as long as they
+// fill different rows.
+template <class Graph>
+void ComputeDistanceMatrixRows(const DistanceMatrixData<Graph>* data,
+                               int first_source, int source_step) {
+  ShortestPathSearch<Graph> search(data->graph, data->arc_lengths);
+  const int num_sources = data->sources->size();
+  const int num_targets = data->targets->size();
+  for (int i = first_source; i < num_sources; i += source_step) {
+    search.ComputeShortestPathsToTargets((*data->sources)[i], *data->targets);
+    // The matrix can have more than 2^31 entries.
+    const int64 row_start = static_cast<int64>(i) * num_targets;
+    for (int j = 0; j < num_targets; ++j) {
+      (*data->distances)[row_start + j] = search.Distance((*data->targets)[j]);
+    }
+  }
+}
+
+}  // namespace internal
+
+// Computes the shortest path distances from each of the sources to each of
+// the targets. On return, (*distances)[i * targets.size() + j] contains the
+// distance from sources[i] to targets[j], or kUnreachableDistance if there is
+// no path. One Dijkstra search is run per source, stopping once all the
+// targets are reached, and the searches are distributed over num_threads
+// threads (if num_threads is 1, they are all run in the calling thread).
+template <class Graph>
+void ComputeShortestPathDistanceMatrix(
+    const Graph& graph, const std::vector<int64>& arc_lengths,
+    const std::vector<typename Graph::NodeIndex>& sources,
+    const std::vector<typename Graph::NodeIndex>& targets, int num_threads,
+    std::vector<int64>* distances) {
+  distances->assign(sources.size() * targets.size(), kUnreachableDistance);
+  internal::DistanceMatrixData<Graph> data;
+  data.graph = &graph;
+  data.arc_lengths = &arc_lengths;
+  data.sources = &sources;
+  data.targets = &targets;
+  data.distances = distances;
+  const internal::DistanceMatrixData<Graph>* const shared_data = &data;
+  num_threads = std::max(1, std::min<int>(num_threads, sources.size()));
+  if (num_threads == 1) {
+    internal::ComputeDistanceMatrixRows(shared_data, 0, 1);
+    return;
+  }
+  // The destructor of the pool waits for all the rows to be computed.
+  ThreadPool pool("DistanceMatrix", num_threads);
+  pool.StartWorkers();
+  for (int i = 0; i < num_threads; ++i) {
+    pool.Add(NewCallback(&internal::ComputeDistanceMatrixRows<Graph>,
+                         shared_data, i, num_threads));
+  }
+}
+
+}  // namespace operations_research
+
+#endif  // OR_TOOLS_GRAPH_SHORTEST_PATH_SEARCH_H_
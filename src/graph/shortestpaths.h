@@ -35,6 +35,10 @@ namespace operations_research {
 // two nodes. Ownership of the callback is taken by the function that
 // will delete it in the end.  This function returns true if
 // 'start_node' and 'end_node' are connected, false otherwise.
+//
+// Note that this calls the callback for all the pairs of nodes, so it runs in
+// O(node_count^2). For sparse graphs, see ShortestPathSearch in
+// shortest_path_search.h which works on the graphs of graph.h.
 bool DijkstraShortestPath(int node_count, int start_node, int end_node,
                           ResultCallback2<int64, int, int>* const graph,
                           int64 disconnected_distance, std::vector<int>* nodes);
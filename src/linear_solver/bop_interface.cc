@@ -28,6 +28,11 @@
 
 #if defined(USE_BOP)
 
+DEFINE_int32(num_bop_threads, 0,
+             "If positive, number of concurrent Bop solvers. Their results "
+             "are not deterministic. 0 means the default, deterministic, "
+             "single-threaded solver.");
+
 namespace operations_research {
 namespace {
 
@@ -342,6 +347,19 @@ void BopInterface::ExtractObjective() {
 void BopInterface::SetParameters(const MPSolverParameters& param) {
   parameters_.Clear();
   SetCommonParameters(param);
+
+  // On request, run one solver per thread, exchanging their solutions and
+  // bounds as soon as they are found, so that the linear relaxation is solved
+  // concurrently with the search. This is not deterministic, so it is not the
+  // default. These can be overridden by the solver specific parameters.
+  if (FLAGS_num_bop_threads > 0) {
+    parameters_.set_number_of_solvers(FLAGS_num_bop_threads);
+    parameters_.set_num_bop_solvers_used_by_decomposition(
+        FLAGS_num_bop_threads);
+    parameters_.set_synchronization_type(
+        bop::BopParameters::SYNCHRONIZE_ASYNCHRONOUSLY);
+    parameters_.set_use_dedicated_lp_solver(true);
+  }
 }
 
 // All these have no effect.
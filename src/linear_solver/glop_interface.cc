@@ -33,6 +33,7 @@
 
 #include "google/protobuf/text_format.h"
 #include "base/hash.h"
+#include "glop/lp_snapshot.h"
 #include "glop/lp_solver.h"
 #include "glop/parameters.pb.h"
 #include "linear_solver/linear_solver.h"
@@ -46,6 +47,12 @@ namespace operations_research {
 
 namespace {
 
+// When the model is modified between two solves, the basis of the last solve
+// is used as a warm-start, and the preprocessing is skipped, only if the
+// number of new variables and constraints is at most this fraction of the
+// number of old ones. Otherwise, a full solve is likely to be faster.
+const double kMaxRelativeModelGrowthForWarmStart = 0.1;
+
 MPSolver::ResultStatus TranslateProblemStatus(glop::ProblemStatus status) {
   switch (status) {
     case glop::ProblemStatus::OPTIMAL:
@@ -109,6 +116,41 @@ MPSolver::BasisStatus TranslateConstraintStatus(glop::ConstraintStatus status) {
   LOG(DFATAL) << "Unknown constraint status: " << status;
   return MPSolver::FREE;
 }
+
+glop::VariableStatus TranslateToVariableStatus(MPSolver::BasisStatus status) {
+  switch (status) {
+    case MPSolver::FREE:
+      return glop::VariableStatus::FREE;
+    case MPSolver::AT_LOWER_BOUND:
+      return glop::VariableStatus::AT_LOWER_BOUND;
+    case MPSolver::AT_UPPER_BOUND:
+      return glop::VariableStatus::AT_UPPER_BOUND;
+    case MPSolver::FIXED_VALUE:
+      return glop::VariableStatus::FIXED_VALUE;
+    case MPSolver::BASIC:
+      return glop::VariableStatus::BASIC;
+  }
+  LOG(DFATAL) << "Unknown basis status: " << status;
+  return glop::VariableStatus::FREE;
+}
+
+glop::ConstraintStatus TranslateToConstraintStatus(
+    MPSolver::BasisStatus status) {
+  switch (status) {
+    case MPSolver::FREE:
+      return glop::ConstraintStatus::FREE;
+    case MPSolver::AT_LOWER_BOUND:
+      return glop::ConstraintStatus::AT_LOWER_BOUND;
+    case MPSolver::AT_UPPER_BOUND:
+      return glop::ConstraintStatus::AT_UPPER_BOUND;
+    case MPSolver::FIXED_VALUE:
+      return glop::ConstraintStatus::FIXED_VALUE;
+    case MPSolver::BASIC:
+      return glop::ConstraintStatus::BASIC;
+  }
+  LOG(DFATAL) << "Unknown basis status: " << status;
+  return glop::ConstraintStatus::FREE;
+}
 }  // Anonymous namespace
 
 class GLOPInterface : public MPSolverInterface {
@@ -164,14 +206,39 @@ class GLOPInterface : public MPSolverInterface {
   void SetLpAlgorithm(int value) override;
   bool ReadParameterFile(const std::string& filename) override;
 
+  void SetStartingLpBasis(
+      const std::vector<MPSolver::BasisStatus>& variable_statuses,
+      const std::vector<MPSolver::BasisStatus>& constraint_statuses) override;
+  bool WriteLpSnapshot(const std::string& file_name) override;
+
  private:
-  void NonIncrementalChange();
+  // Tells the LPSolver to start from the basis of the last solve, completed
+  // for the new variables and constraints, if the model didn't change too much
+  // since then. When the simplex algorithm is not imposed by the given
+  // parameters, this also chooses in them the one that is the most likely to
+  // keep the feasibility of this basis. Requires
+  // can_warm_start_from_last_solve_.
+  void WarmStartFromLastSolve(glop::GlopParameters* solve_parameters);
 
   glop::LinearProgram linear_program_;
   glop::LPSolver lp_solver_;
   std::vector<MPSolver::BasisStatus> column_status_;
   std::vector<MPSolver::BasisStatus> row_status_;
   glop::GlopParameters parameters_;
+
+  // The basis given by SetStartingLpBasis() for the next Solve(), if any.
+  glop::VariableStatusRow starting_variable_statuses_;
+  glop::ConstraintStatusColumn starting_constraint_statuses_;
+
+  // Whether the changes made to the model since the last Solve() may have
+  // made its basis primal (resp. dual) infeasible. Note that the new variables
+  // and constraints are not taken into account here.
+  bool primal_feasibility_may_be_lost_;
+  bool dual_feasibility_may_be_lost_;
+
+  // True if the last Solve() was optimal and the model was not reset since
+  // then, i.e. if the basis held by lp_solver_ can be used as a warm-start.
+  bool can_warm_start_from_last_solve_;
 };
 
 GLOPInterface::GLOPInterface(MPSolver* const solver)
@@ -180,13 +247,24 @@ GLOPInterface::GLOPInterface(MPSolver* const solver)
       lp_solver_(),
       column_status_(),
       row_status_(),
-      parameters_() {}
+      parameters_(),
+      primal_feasibility_may_be_lost_(false),
+      dual_feasibility_may_be_lost_(false),
+      can_warm_start_from_last_solve_(false) {}
 
 GLOPInterface::~GLOPInterface() {}
 
 MPSolver::ResultStatus GLOPInterface::Solve(const MPSolverParameters& param) {
-  // Reset extraction as Glop is not incremental yet.
-  Reset();
+  // The model modifications are applied to linear_program_ as they are made,
+  // and the new variables and constraints are appended to it by
+  // ExtractModel(). So unless incrementality is disabled, linear_program_ is
+  // only rebuilt from scratch after a Reset().
+  const bool incremental =
+      param.GetIntegerParam(MPSolverParameters::INCREMENTALITY) !=
+      MPSolverParameters::INCREMENTALITY_OFF;
+  if (!incremental) {
+    Reset();
+  }
   ExtractModel();
   SetParameters(param);
 
@@ -202,12 +280,28 @@ MPSolver::ResultStatus GLOPInterface::Solve(const MPSolverParameters& param) {
 
   solver_->SetSolverSpecificParametersAsString(
       solver_->solver_specific_parameter_string_);
-  lp_solver_.SetParameters(parameters_);
+
+  // The algorithm chosen for a warm-start only applies to this solve, so it is
+  // set on a copy of parameters_.
+  glop::GlopParameters solve_parameters = parameters_;
+  if (!starting_variable_statuses_.empty()) {
+    lp_solver_.SetInitialBasis(starting_variable_statuses_,
+                               starting_constraint_statuses_);
+    starting_variable_statuses_.clear();
+    starting_constraint_statuses_.clear();
+  } else if (incremental && can_warm_start_from_last_solve_) {
+    WarmStartFromLastSolve(&solve_parameters);
+  }
+  primal_feasibility_may_be_lost_ = false;
+  dual_feasibility_may_be_lost_ = false;
+
+  lp_solver_.SetParameters(solve_parameters);
   const glop::ProblemStatus status = lp_solver_.Solve(linear_program_);
 
   // The solution must be marked as synchronized even when no solution exists.
   sync_status_ = SOLUTION_SYNCHRONIZED;
   result_status_ = TranslateProblemStatus(status);
+  can_warm_start_from_last_solve_ = result_status_ == MPSolver::OPTIMAL;
   objective_value_ = lp_solver_.GetObjectiveValue();
 
   const size_t num_vars = solver_->variables_.size();
@@ -251,17 +345,75 @@ MPSolver::ResultStatus GLOPInterface::Solve(const MPSolverParameters& param) {
   return result_status_;
 }
 
+void GLOPInterface::WarmStartFromLastSolve(
+    glop::GlopParameters* solve_parameters) {
+  DCHECK(can_warm_start_from_last_solve_);
+  const glop::VariableStatusRow& variable_statuses =
+      lp_solver_.variable_statuses();
+  const glop::ConstraintStatusColumn& constraint_statuses =
+      lp_solver_.constraint_statuses();
+  const glop::ColIndex num_cols = linear_program_.num_variables();
+  const glop::RowIndex num_rows = linear_program_.num_constraints();
+  const glop::ColIndex num_old_cols = variable_statuses.size();
+  const glop::RowIndex num_old_rows = constraint_statuses.size();
+  if (num_old_cols > num_cols || num_old_rows > num_rows) return;
+  const int num_old = num_old_cols.value() + num_old_rows.value();
+  const int num_new =
+      (num_cols - num_old_cols).value() + (num_rows - num_old_rows).value();
+  if (num_old == 0 || num_new > kMaxRelativeModelGrowthForWarmStart * num_old) {
+    return;
+  }
+
+  // The new variables are given the FREE status, which the simplex replaces by
+  // a status compatible with their bounds. The new constraints are basic so
+  // that the old basis stays a basis.
+  glop::VariableStatusRow new_variable_statuses = variable_statuses;
+  new_variable_statuses.resize(num_cols, glop::VariableStatus::FREE);
+  glop::ConstraintStatusColumn new_constraint_statuses = constraint_statuses;
+  new_constraint_statuses.resize(num_rows, glop::ConstraintStatus::BASIC);
+  lp_solver_.SetInitialBasis(new_variable_statuses, new_constraint_statuses);
+  VLOG(1) << "Warm-starting from the last basis (" << num_new
+          << " new variables and constraints).";
+
+  // A new variable at one of its bounds doesn't change the basic solution but
+  // may have a negative reduced cost, and a new basic constraint may be
+  // violated. If only one of the two feasibilities may be lost, we use the
+  // algorithm that starts from the other one, i.e. the primal simplex after a
+  // change of objective and the dual simplex after a change of bounds. The
+  // algorithm imposed by LP_ALGORITHM or by the solver specific parameters is
+  // kept.
+  if (!solve_parameters->has_use_dual_simplex()) {
+    const bool primal_feasibility_may_be_lost =
+        primal_feasibility_may_be_lost_ || num_rows > num_old_rows;
+    const bool dual_feasibility_may_be_lost =
+        dual_feasibility_may_be_lost_ || num_cols > num_old_cols;
+    if (primal_feasibility_may_be_lost != dual_feasibility_may_be_lost) {
+      solve_parameters->set_use_dual_simplex(primal_feasibility_may_be_lost);
+    }
+  }
+}
+
 void GLOPInterface::Reset() {
   ResetExtractionInformation();
   linear_program_.Clear();
+  can_warm_start_from_last_solve_ = false;
 }
 
 void GLOPInterface::SetOptimizationDirection(bool maximize) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  linear_program_.SetMaximizationProblem(maximize);
+  dual_feasibility_may_be_lost_ = true;
 }
 
 void GLOPInterface::SetVariableBounds(int index, double lb, double ub) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  if (index != kNoIndex) {
+    DCHECK_LT(index, last_variable_index_);
+    linear_program_.SetVariableBounds(glop::ColIndex(index), lb, ub);
+    primal_feasibility_may_be_lost_ = true;
+  } else {
+    sync_status_ = MUST_RELOAD;
+  }
 }
 
 void GLOPInterface::SetVariableInteger(int index, bool integer) {
@@ -269,35 +421,91 @@ void GLOPInterface::SetVariableInteger(int index, bool integer) {
 }
 
 void GLOPInterface::SetConstraintBounds(int index, double lb, double ub) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  if (index != kNoIndex) {
+    DCHECK_LT(index, last_constraint_index_);
+    linear_program_.SetConstraintBounds(glop::RowIndex(index), lb, ub);
+    primal_feasibility_may_be_lost_ = true;
+  } else {
+    sync_status_ = MUST_RELOAD;
+  }
 }
 
 void GLOPInterface::AddRowConstraint(MPConstraint* const ct) {
-  NonIncrementalChange();
+  sync_status_ = MUST_RELOAD;
 }
 
 void GLOPInterface::AddVariable(MPVariable* const var) {
-  NonIncrementalChange();
+  sync_status_ = MUST_RELOAD;
 }
 
 void GLOPInterface::SetCoefficient(MPConstraint* const constraint,
                                    const MPVariable* const variable,
                                    double new_value, double old_value) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  const int constraint_index = constraint->index();
+  const int variable_index = variable->index();
+  if (constraint_index != kNoIndex && variable_index != kNoIndex) {
+    // The new coefficient is appended to the column, and the old one is
+    // removed by the LinearProgram::CleanUp() in Solve().
+    linear_program_.SetCoefficient(glop::RowIndex(constraint_index),
+                                   glop::ColIndex(variable_index), new_value);
+    primal_feasibility_may_be_lost_ = true;
+    dual_feasibility_may_be_lost_ = true;
+  } else {
+    // The coefficients of an unextracted variable or constraint are extracted
+    // with it.
+    sync_status_ = MUST_RELOAD;
+  }
 }
 
 void GLOPInterface::ClearConstraint(MPConstraint* const constraint) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  const int constraint_index = constraint->index();
+  // Constraint may not have been extracted yet.
+  if (constraint_index != kNoIndex) {
+    for (CoeffEntry entry : constraint->coefficients_) {
+      const int var_index = entry.first->index();
+      DCHECK_NE(kNoIndex, var_index);
+      linear_program_.SetCoefficient(glop::RowIndex(constraint_index),
+                                     glop::ColIndex(var_index), 0.0);
+    }
+    primal_feasibility_may_be_lost_ = true;
+    dual_feasibility_may_be_lost_ = true;
+  }
 }
 
 void GLOPInterface::SetObjectiveCoefficient(const MPVariable* const variable,
                                             double coefficient) {
-  NonIncrementalChange();
+  InvalidateSolutionSynchronization();
+  if (variable->index() != kNoIndex) {
+    linear_program_.SetObjectiveCoefficient(glop::ColIndex(variable->index()),
+                                            coefficient);
+    dual_feasibility_may_be_lost_ = true;
+  } else {
+    sync_status_ = MUST_RELOAD;
+  }
 }
 
-void GLOPInterface::SetObjectiveOffset(double value) { NonIncrementalChange(); }
+void GLOPInterface::SetObjectiveOffset(double value) {
+  InvalidateSolutionSynchronization();
+  linear_program_.SetObjectiveOffset(value);
+}
 
-void GLOPInterface::ClearObjective() { NonIncrementalChange(); }
+void GLOPInterface::ClearObjective() {
+  InvalidateSolutionSynchronization();
+  for (CoeffEntry entry : solver_->objective_->coefficients_) {
+    const int var_index = entry.first->index();
+    // Variable may have not been extracted yet.
+    if (var_index == kNoIndex) {
+      DCHECK_NE(MODEL_SYNCHRONIZED, sync_status_);
+    } else {
+      linear_program_.SetObjectiveCoefficient(glop::ColIndex(var_index), 0.0);
+    }
+  }
+  linear_program_.SetObjectiveOffset(0.0);
+  dual_feasibility_may_be_lost_ = true;
+}
 
 int64 GLOPInterface::iterations() const {
   return lp_solver_.GetNumberOfSimplexIterations();
@@ -335,10 +543,8 @@ std::string GLOPInterface::SolverVersion() const {
 void* GLOPInterface::underlying_solver() { return &lp_solver_; }
 
 void GLOPInterface::ExtractNewVariables() {
-  DCHECK_EQ(0, last_variable_index_);
-  DCHECK_EQ(0, last_constraint_index_);
-
   const glop::ColIndex num_cols(solver_->variables_.size());
+  if (num_cols == last_variable_index_) return;
   for (glop::ColIndex col(last_variable_index_); col < num_cols; ++col) {
     MPVariable* const var = solver_->variables_[col.value()];
     const glop::ColIndex new_col =
@@ -347,13 +553,24 @@ void GLOPInterface::ExtractNewVariables() {
     var->set_index(col.value());
     linear_program_.SetVariableBounds(col, var->lb(), var->ub());
   }
+
+  // Add the new variables to the constraints that were already extracted.
+  for (int i = 0; i < last_constraint_index_; ++i) {
+    MPConstraint* const ct = solver_->constraints_[i];
+    for (CoeffEntry entry : ct->coefficients_) {
+      const int var_index = entry.first->index();
+      DCHECK_NE(kNoIndex, var_index);
+      if (var_index >= last_variable_index_) {
+        linear_program_.SetCoefficient(glop::RowIndex(ct->index()),
+                                       glop::ColIndex(var_index), entry.second);
+      }
+    }
+  }
 }
 
 void GLOPInterface::ExtractNewConstraints() {
-  DCHECK_EQ(0, last_constraint_index_);
-
   const glop::RowIndex num_rows(solver_->constraints_.size());
-  for (glop::RowIndex row(0); row < num_rows; ++row) {
+  for (glop::RowIndex row(last_constraint_index_); row < num_rows; ++row) {
     MPConstraint* const ct = solver_->constraints_[row.value()];
     ct->set_index(row.value());
 
@@ -385,6 +602,8 @@ void GLOPInterface::ExtractObjective() {
 }
 
 void GLOPInterface::SetParameters(const MPSolverParameters& param) {
+  // Starts from the default parameters, so that nothing set for a previous
+  // solve is kept.
   parameters_.Clear();
   SetCommonParameters(param);
   SetScalingMode(param.GetIntegerParam(MPSolverParameters::SCALING));
@@ -478,9 +697,32 @@ bool GLOPInterface::ReadParameterFile(const std::string& filename) {
 #endif
 }
 
-void GLOPInterface::NonIncrementalChange() {
-  // The current implementation is not incremental.
-  sync_status_ = MUST_RELOAD;
+void GLOPInterface::SetStartingLpBasis(
+    const std::vector<MPSolver::BasisStatus>& variable_statuses,
+    const std::vector<MPSolver::BasisStatus>& constraint_statuses) {
+  starting_variable_statuses_.clear();
+  starting_constraint_statuses_.clear();
+  for (const MPSolver::BasisStatus status : variable_statuses) {
+    starting_variable_statuses_.push_back(TranslateToVariableStatus(status));
+  }
+  for (const MPSolver::BasisStatus status : constraint_statuses) {
+    starting_constraint_statuses_.push_back(
+        TranslateToConstraintStatus(status));
+  }
+}
+
+bool GLOPInterface::WriteLpSnapshot(const std::string& file_name) {
+  // The basis is only meaningful if the solution corresponds to the current
+  // model.
+  const bool has_basis = sync_status_ == SOLUTION_SYNCHRONIZED;
+  ExtractModel();
+  linear_program_.SetMaximizationProblem(maximize_);
+  linear_program_.CleanUp();
+  glop::BasisState basis;
+  if (has_basis) basis = lp_solver_.GetBasisState();
+  return glop::WriteLinearProgramSnapshot(linear_program_,
+                                          has_basis ? &basis : nullptr,
+                                          /*with_names=*/true, file_name);
 }
 
 // Register GLOP in the global linear solver factory.
@@ -39,6 +39,10 @@
 #include "util/fp_utils.h"
 #include "util/proto_tools.h"
 
+#if defined(USE_GLOP)
+#include "glop/lp_snapshot.h"
+#endif
+
 DEFINE_bool(verify_solution, false,
             "Systematically verify the solution when calling Solve()"
             ", and change the return value of Solve() to ABNORMAL if"
@@ -740,6 +744,110 @@ void MPSolver::SuppressOutput() { interface_->set_quiet(true); }
 
 bool MPSolver::InterruptSolve() { return interface_->InterruptSolve(); }
 
+void MPSolver::SetStartingLpBasis(
+    const std::vector<BasisStatus>& variable_statuses,
+    const std::vector<BasisStatus>& constraint_statuses) {
+  interface_->SetStartingLpBasis(variable_statuses, constraint_statuses);
+}
+
+bool MPSolver::WriteLpSnapshot(const std::string& file_name) {
+  return interface_->WriteLpSnapshot(file_name);
+}
+
+#if defined(USE_GLOP)
+namespace {
+// Converts the status of a glop structural or slack variable. The status of a
+// constraint is the one of its slack variable with a change of sign, see
+// glop::RevisedSimplex::GetConstraintStatus().
+MPSolver::BasisStatus GlopToMPSolverBasisStatus(glop::VariableStatus status,
+                                                bool is_slack) {
+  switch (status) {
+    case glop::VariableStatus::FREE:
+      return MPSolver::FREE;
+    case glop::VariableStatus::AT_LOWER_BOUND:
+      return is_slack ? MPSolver::AT_UPPER_BOUND : MPSolver::AT_LOWER_BOUND;
+    case glop::VariableStatus::AT_UPPER_BOUND:
+      return is_slack ? MPSolver::AT_LOWER_BOUND : MPSolver::AT_UPPER_BOUND;
+    case glop::VariableStatus::FIXED_VALUE:
+      return MPSolver::FIXED_VALUE;
+    case glop::VariableStatus::BASIC:
+      return MPSolver::BASIC;
+  }
+  LOG(DFATAL) << "Unknown variable status: " << static_cast<int>(status);
+  return MPSolver::FREE;
+}
+}  // namespace
+#endif
+
+bool MPSolver::LoadModelFromLpSnapshot(const std::string& file_name) {
+#if defined(USE_GLOP)
+  glop::LinearProgramSnapshot snapshot;
+  if (!snapshot.Open(file_name)) return false;
+  Clear();
+
+  const glop::ColIndex num_cols = snapshot.num_cols();
+  const glop::RowIndex num_rows = snapshot.num_rows();
+  const double* const objective_coefficients =
+      snapshot.objective_coefficients();
+  const double* const variable_lower_bounds = snapshot.variable_lower_bounds();
+  const double* const variable_upper_bounds = snapshot.variable_upper_bounds();
+  const uint8* const is_variable_integer = snapshot.is_variable_integer();
+  MPObjective* const objective = MutableObjective();
+  for (glop::ColIndex col(0); col < num_cols; ++col) {
+    const int i = col.value();
+    MPVariable* const variable =
+        MakeVar(variable_lower_bounds[i], variable_upper_bounds[i],
+                is_variable_integer[i] != 0, snapshot.GetVariableName(col));
+    objective->SetCoefficient(variable, objective_coefficients[i]);
+  }
+  const double* const constraint_lower_bounds =
+      snapshot.constraint_lower_bounds();
+  const double* const constraint_upper_bounds =
+      snapshot.constraint_upper_bounds();
+  for (glop::RowIndex row(0); row < num_rows; ++row) {
+    const int i = row.value();
+    MakeRowConstraint(constraint_lower_bounds[i], constraint_upper_bounds[i],
+                      snapshot.GetConstraintName(row));
+  }
+
+  // The matrix is stored by columns, the coefficients are thus scattered into
+  // the constraints. The row indices were checked by snapshot.Open().
+  const int64* const column_starts = snapshot.column_starts();
+  const int32* const entry_rows = snapshot.entry_rows();
+  const double* const entry_coefficients = snapshot.entry_coefficients();
+  for (int col = 0; col < num_cols.value(); ++col) {
+    MPVariable* const variable = variables_[col];
+    for (int64 i = column_starts[col]; i < column_starts[col + 1]; ++i) {
+      DCHECK(entry_rows[i] >= 0 && entry_rows[i] < num_rows.value());
+      constraints_[entry_rows[i]]->SetCoefficient(variable,
+                                                  entry_coefficients[i]);
+    }
+  }
+  objective->SetOptimizationDirection(snapshot.IsMaximizationProblem());
+  objective->SetOffset(snapshot.objective_offset());
+
+  glop::BasisState state;
+  if (snapshot.GetBasisState(&state)) {
+    std::vector<BasisStatus> variable_statuses(num_cols.value());
+    for (glop::ColIndex col(0); col < num_cols; ++col) {
+      variable_statuses[col.value()] =
+          GlopToMPSolverBasisStatus(state.statuses[col], /*is_slack=*/false);
+    }
+    std::vector<BasisStatus> constraint_statuses(num_rows.value());
+    for (glop::RowIndex row(0); row < num_rows; ++row) {
+      constraint_statuses[row.value()] = GlopToMPSolverBasisStatus(
+          state.statuses[num_cols + glop::RowToColIndex(row)],
+          /*is_slack=*/true);
+    }
+    SetStartingLpBasis(variable_statuses, constraint_statuses);
+  }
+  return true;
+#else
+  LOG(ERROR) << "LP snapshots require GLOP support.";
+  return false;
+#endif
+}
+
 MPVariable* MPSolver::MakeVar(double lb, double ub, bool integer,
                               const std::string& name) {
   const int var_index = NumVariables();
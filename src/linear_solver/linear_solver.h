@@ -423,6 +423,20 @@ class MPSolver {
   bool ExportModelAsMpsFormat(bool fixed_format, bool obfuscated,
                               std::string* model_str);
 
+  // ----- Binary LP snapshots -----
+
+  // Writes the model, together with the basis of the last solve if the
+  // solution is still synchronized with the model, to a binary snapshot file
+  // (see glop/lp_snapshot.h). Returns false if the underlying solver doesn't
+  // support snapshots (only GLOP does) or if the file couldn't be written.
+  bool WriteLpSnapshot(const std::string& file_name);
+
+  // Clears the model and loads the one stored in the given snapshot file. If
+  // the snapshot contains a basis, it is used to warm-start the next Solve()
+  // (see SetStartingLpBasis()). Returns false if the file is not a valid
+  // snapshot, or if GLOP support was not compiled in.
+  bool LoadModelFromLpSnapshot(const std::string& file_name);
+
   // ----- Misc -----
 
   // Advanced usage: pass solver specific parameters in text format. The format
@@ -444,6 +458,15 @@ class MPSolver {
     BASIC
   };
 
+  // Advanced usage: sets the basis used to warm-start the next solve of a
+  // linear program. The statuses are indexed like the variables and the
+  // constraints of the model, and have the same meaning as the ones returned by
+  // MPVariable::basis_status() and MPConstraint::basis_status(). The basis is
+  // ignored if its dimension doesn't match the model at solve time. Only GLOP
+  // supports this, the other solvers ignore it with a warning.
+  void SetStartingLpBasis(const std::vector<BasisStatus>& variable_statuses,
+                          const std::vector<BasisStatus>& constraint_statuses);
+
   // Infinity. You can use -MPSolver::infinity() for negative infinity.
   static double infinity() { return std::numeric_limits<double>::infinity(); }
 
@@ -1205,6 +1228,16 @@ class MPSolverInterface {
 
   virtual bool InterruptSolve() { return false; }
 
+  // See MPSolver::SetStartingLpBasis().
+  virtual void SetStartingLpBasis(
+      const std::vector<MPSolver::BasisStatus>& variable_statuses,
+      const std::vector<MPSolver::BasisStatus>& constraint_statuses) {
+    LOG(WARNING) << "Starting basis not supported by " << SolverVersion();
+  }
+
+  // See MPSolver::WriteLpSnapshot().
+  virtual bool WriteLpSnapshot(const std::string& file_name) { return false; }
+
   friend class MPSolver;
 
   // To access the maximize_ bool and the MPSolver.
@@ -362,6 +362,13 @@ SparseColumn* LinearProgram::GetMutableSparseColumn(ColIndex col) {
   return matrix_.mutable_column(col);
 }
 
+void LinearProgram::ClearAndReserveColumnEntries(
+    const StrictITIVector<ColIndex, EntryIndex>& num_entries) {
+  columns_are_known_to_be_clean_ = false;
+  transpose_matrix_is_consistent_ = false;
+  matrix_.ClearAndReserveColumnEntries(num_entries);
+}
+
 Fractional LinearProgram::GetObjectiveCoefficientForMinimizationVersion(
     ColIndex col) const {
   return maximize_ ? -objective_coefficients()[col]
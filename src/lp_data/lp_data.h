@@ -126,6 +126,12 @@ class LinearProgram {
   // duplicates or zero entries (i.e. if IsCleanedUp() is true for all columns).
   bool IsCleanedUp() const;
 
+  // Advanced usage: records that all the columns are already cleaned up so
+  // that the next IsCleanedUp() or CleanUp() calls run in O(1). This must only
+  // be used when the columns are known to be clean, for instance because they
+  // were copied from the columns of a cleaned-up LinearProgram.
+  void NotifyThatColumnsAreClean() { columns_are_known_to_be_clean_ = true; }
+
   // Functions that return the name of a variable or constraint. If the name is
   // empty, they return a special name that depends on the index.
   std::string GetVariableName(ColIndex col) const;
@@ -166,6 +172,14 @@ class LinearProgram {
   // Gets a pointer to the underlying SparseColumn with the given index.
   SparseColumn* GetMutableSparseColumn(ColIndex col);
 
+  // Clears the coefficients of all the variables and reserves room for
+  // num_entries[col] coefficients in the column of each variable col, see
+  // SparseMatrix::ClearAndReserveColumnEntries(). num_entries must have
+  // num_variables() elements. Filling the columns afterwards with at most this
+  // number of coefficients each does no allocation.
+  void ClearAndReserveColumnEntries(
+      const StrictITIVector<ColIndex, EntryIndex>& num_entries);
+
   // Returns the number of variables.
   ColIndex num_variables() const { return matrix_.num_cols(); }
 
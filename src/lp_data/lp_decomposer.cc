@@ -25,14 +25,43 @@ namespace glop {
 //------------------------------------------------------------------------------
 // LPDecomposer
 //------------------------------------------------------------------------------
+namespace {
+
+// Returns the global vector obtained by copying each local vector at the global
+// positions given by its cluster. The positions that do not belong to any
+// cluster are set to default_value.
+template <typename IndexType, typename T>
+StrictITIVector<IndexType, T> AggregateLocalVectors(
+    const std::vector<std::vector<IndexType>>& clusters, IndexType global_size,
+    const std::vector<StrictITIVector<IndexType, T>>& local_vectors,
+    const T& default_value) {
+  CHECK_EQ(local_vectors.size(), clusters.size());
+  StrictITIVector<IndexType, T> global_vector(global_size, default_value);
+  for (int problem = 0; problem < local_vectors.size(); ++problem) {
+    const StrictITIVector<IndexType, T>& local_vector = local_vectors[problem];
+    const std::vector<IndexType>& cluster = clusters[problem];
+    CHECK_EQ(local_vector.size(), IndexType(cluster.size()));
+    for (int i = 0; i < cluster.size(); ++i) {
+      global_vector[cluster[i]] = local_vector[IndexType(i)];
+    }
+  }
+  return global_vector;
+}
+
+}  // namespace
+
 LPDecomposer::LPDecomposer()
     : original_problem_(nullptr),
+      original_problem_is_cleaned_up_(false),
       clusters_(),
+      row_clusters_(),
+      local_rows_(),
       mutex_() {}
 
 void LPDecomposer::Decompose(const LinearProgram* linear_problem) {
   MutexLock mutex_lock(&mutex_);
   original_problem_ = linear_problem;
+  original_problem_is_cleaned_up_ = linear_problem->IsCleanedUp();
   clusters_.clear();
 
   const SparseMatrix& transposed_matrix =
@@ -61,6 +90,19 @@ void LPDecomposer::Decompose(const LinearProgram* linear_problem) {
   for (int i = 0; i < num_classes; ++i) {
     std::sort(clusters_[i].begin(), clusters_[i].end());
   }
+
+  // Compute the constraints of each cluster and their local index. Since the
+  // constraints are scanned in order, the row clusters are sorted.
+  row_clusters_.assign(num_classes, std::vector<RowIndex>());
+  local_rows_.assign(original_problem_->num_constraints(), kInvalidRow);
+  for (ColIndex ct(0); ct < num_ct; ++ct) {
+    const SparseColumn& sparse_constraint = transposed_matrix.column(ct);
+    if (sparse_constraint.IsEmpty()) continue;
+    const int cluster = classes[sparse_constraint.GetFirstRow().value()];
+    const RowIndex row = ColToRowIndex(ct);
+    local_rows_[row] = RowIndex(row_clusters_[cluster].size());
+    row_clusters_[cluster].push_back(row);
+  }
 }
 
 int LPDecomposer::GetNumberOfProblems() const {
@@ -76,80 +118,106 @@ const LinearProgram& LPDecomposer::original_problem() const {
 void LPDecomposer::ExtractLocalProblem(int problem_index, LinearProgram* lp) {
   CHECK(lp != nullptr);
   CHECK_GE(problem_index, 0);
-  CHECK_LT(problem_index, clusters_.size());
 
   lp->Clear();
 
-  MutexLock mutex_lock(&mutex_);
-  const std::vector<ColIndex>& cluster = clusters_[problem_index];
-  StrictITIVector<ColIndex, ColIndex> global_to_local(
-      original_problem_->num_variables(), kInvalidCol);
-  SparseBitset<RowIndex> constraints_to_use(
-      original_problem_->num_constraints());
-  lp->SetMaximizationProblem(original_problem_->IsMaximizationProblem());
-
-  // Create variables and get all constraints of the cluster.
-  const SparseMatrix& original_matrix = original_problem_->GetSparseMatrix();
-  const SparseMatrix& transposed_matrix =
-      original_problem_->GetTransposeSparseMatrix();
+  // The extraction itself only reads the decomposition and the original
+  // problem, so the mutex is released before it.
+  const LinearProgram* original_problem;
+  const std::vector<ColIndex>* cluster_ptr;
+  const std::vector<RowIndex>* row_cluster_ptr;
+  const RowMapping* local_rows;
+  bool is_cleaned_up;
+  {
+    MutexLock mutex_lock(&mutex_);
+    CHECK_LT(problem_index, clusters_.size());
+    original_problem = original_problem_;
+    cluster_ptr = &clusters_[problem_index];
+    row_cluster_ptr = &row_clusters_[problem_index];
+    local_rows = &local_rows_;
+    is_cleaned_up = original_problem_is_cleaned_up_;
+  }
+  const std::vector<ColIndex>& cluster = *cluster_ptr;
+  const std::vector<RowIndex>& row_cluster = *row_cluster_ptr;
+  lp->SetMaximizationProblem(original_problem->IsMaximizationProblem());
+
+  // Create the constraints first, so that the coefficients of each column can
+  // be added in order. Since the local rows are in the same order as the
+  // global ones, the columns of lp are then sorted if the original ones are.
+  for (int i = 0; i < row_cluster.size(); ++i) {
+    const RowIndex global_row = row_cluster[i];
+    const RowIndex local_row = lp->CreateNewConstraint();
+    CHECK_EQ(local_row, RowIndex(i));
+    lp->SetConstraintName(local_row,
+                          original_problem->GetConstraintName(global_row));
+    lp->SetConstraintBounds(
+        local_row, original_problem->constraint_lower_bounds()[global_row],
+        original_problem->constraint_upper_bounds()[global_row]);
+  }
+
+  // Create the variables and their columns.
+  const SparseMatrix& original_matrix = original_problem->GetSparseMatrix();
   for (int i = 0; i < cluster.size(); ++i) {
     const ColIndex global_col = cluster[i];
     const ColIndex local_col = lp->CreateNewVariable();
     CHECK_EQ(local_col, ColIndex(i));
-    CHECK(global_to_local[global_col] == kInvalidCol ||
-          global_to_local[global_col] == local_col)
-        << "If the mapping is already assigned it has to be the same.";
-    global_to_local[global_col] = local_col;
 
     lp->SetVariableName(local_col,
-                        original_problem_->GetVariableName(global_col));
+                        original_problem->GetVariableName(global_col));
     lp->SetVariableIntegrality(
-        local_col, original_problem_->is_variable_integer()[global_col]);
+        local_col, original_problem->is_variable_integer()[global_col]);
     lp->SetVariableBounds(
-        local_col, original_problem_->variable_lower_bounds()[global_col],
-        original_problem_->variable_upper_bounds()[global_col]);
+        local_col, original_problem->variable_lower_bounds()[global_col],
+        original_problem->variable_upper_bounds()[global_col]);
     lp->SetObjectiveCoefficient(
-        local_col, original_problem_->objective_coefficients()[global_col]);
+        local_col, original_problem->objective_coefficients()[global_col]);
 
     for (const SparseColumn::Entry e : original_matrix.column(global_col)) {
-      constraints_to_use.Set(e.row());
+      lp->SetCoefficient((*local_rows)[e.row()], local_col, e.coefficient());
     }
   }
-  // Create the constraints.
-  for (const RowIndex global_row :
-       constraints_to_use.PositionsSetAtLeastOnce()) {
-    const RowIndex local_row = lp->CreateNewConstraint();
-    lp->SetConstraintName(local_row,
-                          original_problem_->GetConstraintName(global_row));
-    lp->SetConstraintBounds(
-        local_row, original_problem_->constraint_lower_bounds()[global_row],
-        original_problem_->constraint_upper_bounds()[global_row]);
-
-    for (const SparseColumn::Entry e :
-         transposed_matrix.column(RowToColIndex(global_row))) {
-      const ColIndex global_col = RowToColIndex(e.row());
-      const ColIndex local_col = global_to_local[global_col];
-      lp->SetCoefficient(local_row, local_col, e.coefficient());
-    }
+  if (is_cleaned_up) {
+    lp->NotifyThatColumnsAreClean();
   }
 }
 
 DenseRow LPDecomposer::AggregateAssignments(
     const std::vector<DenseRow>& assignments) const {
-  CHECK_EQ(assignments.size(), clusters_.size());
+  MutexLock mutex_lock(&mutex_);
+  return AggregateLocalVectors(clusters_, original_problem_->num_variables(),
+                               assignments, Fractional(0.0));
+}
 
+VariableStatusRow LPDecomposer::AggregateVariableStatuses(
+    const std::vector<VariableStatusRow>& statuses) const {
   MutexLock mutex_lock(&mutex_);
-  DenseRow global_assignment(original_problem_->num_variables(),
-                             Fractional(0.0));
-  for (int problem = 0; problem < assignments.size(); ++problem) {
-    const DenseRow& local_assignment = assignments[problem];
-    const std::vector<ColIndex>& cluster = clusters_[problem];
-    for (int i = 0; i < local_assignment.size(); ++i) {
-      const ColIndex global_col = cluster[i];
-      global_assignment[global_col] = local_assignment[ColIndex(i)];
-    }
+  return AggregateLocalVectors(clusters_, original_problem_->num_variables(),
+                               statuses, VariableStatus::FREE);
+}
+
+DenseColumn LPDecomposer::AggregateConstraintValues(
+    const std::vector<DenseColumn>& values) const {
+  MutexLock mutex_lock(&mutex_);
+  return AggregateLocalVectors(row_clusters_,
+                               original_problem_->num_constraints(), values,
+                               Fractional(0.0));
+}
+
+ConstraintStatusColumn LPDecomposer::AggregateConstraintStatuses(
+    const std::vector<ConstraintStatusColumn>& statuses) const {
+  MutexLock mutex_lock(&mutex_);
+  return AggregateLocalVectors(row_clusters_,
+                               original_problem_->num_constraints(), statuses,
+                               ConstraintStatus::FREE);
+}
+
+bool LPDecomposer::HasEmptyConstraints() const {
+  MutexLock mutex_lock(&mutex_);
+  int num_rows_in_clusters = 0;
+  for (const std::vector<RowIndex>& row_cluster : row_clusters_) {
+    num_rows_in_clusters += row_cluster.size();
   }
-  return global_assignment;
+  return num_rows_in_clusters != original_problem_->num_constraints().value();
 }
 
 DenseRow LPDecomposer::ExtractLocalAssignment(int problem_index,
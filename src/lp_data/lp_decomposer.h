@@ -64,7 +64,10 @@ class LPDecomposer {
 
   // Fills lp with the problem_index^th independent problem generated by
   // Decompose().
-  // Note that this method runs in O(num-entries-in-generated-problem).
+  // Note that this method runs in O(num-entries-in-generated-problem). The
+  // mutex is only held while looking up the decomposition, so several
+  // independent problems can be extracted concurrently; Decompose() must not
+  // be called during the extractions.
   void ExtractLocalProblem(int problem_index, LinearProgram* lp)
       LOCKS_EXCLUDED(mutex_);
 
@@ -78,9 +81,44 @@ class LPDecomposer {
   DenseRow ExtractLocalAssignment(int problem_index, const DenseRow& assignment)
       LOCKS_EXCLUDED(mutex_);
 
+  // Same as AggregateAssignments() for the other parts of a linear program
+  // solution: the variable statuses, and the values (i.e. the dual values) or
+  // the statuses of the constraints. The constraints of the independent
+  // problem number i are the ones of the original problem in the same order as
+  // the ones created by ExtractLocalProblem(i, ...). The constraints that do
+  // not belong to any independent problem (see HasEmptyConstraints()) get a
+  // zero value and a FREE status.
+  VariableStatusRow AggregateVariableStatuses(
+      const std::vector<VariableStatusRow>& statuses) const
+      LOCKS_EXCLUDED(mutex_);
+  DenseColumn AggregateConstraintValues(
+      const std::vector<DenseColumn>& values) const LOCKS_EXCLUDED(mutex_);
+  ConstraintStatusColumn AggregateConstraintStatuses(
+      const std::vector<ConstraintStatusColumn>& statuses) const
+      LOCKS_EXCLUDED(mutex_);
+
+  // Returns true if some constraints of the original problem have no entries.
+  // Such constraints are not part of any of the independent problems, so it is
+  // up to the caller to check that they are feasible.
+  bool HasEmptyConstraints() const LOCKS_EXCLUDED(mutex_);
+
  private:
   const LinearProgram* original_problem_;
+
+  // The value of original_problem_->IsCleanedUp(), computed by Decompose()
+  // since the first call to IsCleanedUp() caches its result and is thus not
+  // thread-safe.
+  bool original_problem_is_cleaned_up_;
+
+  // The variables and the constraints of each independent problem, in
+  // increasing order.
   std::vector<std::vector<ColIndex>> clusters_;
+  std::vector<std::vector<RowIndex>> row_clusters_;
+
+  // The index of each constraint of the original problem in its independent
+  // problem, used to translate the column entries in ExtractLocalProblem(). It
+  // is kInvalidRow for the empty constraints.
+  RowMapping local_rows_;
 
   mutable Mutex mutex_;
 
@@ -17,14 +17,70 @@
 namespace operations_research {
 namespace glop {
 
-Fractional SquaredNorm(const SparseColumn& v) {
+namespace {
+
+// The functions below work the same on a SparseColumn and on a column of a
+// CompactSparseMatrix since both provide the same iteration interface.
+template <typename SparseColumnOrView>
+Fractional SparseSquaredNorm(const SparseColumnOrView& v) {
   Fractional sum(0.0);
-  for (const SparseColumn::Entry e : v) {
+  for (const typename SparseColumnOrView::Entry e : v) {
     sum += Square(e.coefficient());
   }
   return sum;
 }
 
+template <typename SparseColumnOrView>
+Fractional SparseInfinityNorm(const SparseColumnOrView& v) {
+  Fractional infinity_norm = 0.0;
+  for (const typename SparseColumnOrView::Entry e : v) {
+    infinity_norm = std::max(infinity_norm, fabs(e.coefficient()));
+  }
+  return infinity_norm;
+}
+
+template <typename SparseColumnOrView>
+Fractional SparseRestrictedInfinityNorm(
+    const SparseColumnOrView& column, const DenseBooleanColumn& row_to_consider,
+    RowIndex* row_index) {
+  Fractional infinity_norm = 0.0;
+  for (const typename SparseColumnOrView::Entry e : column) {
+    if (row_to_consider[e.row()] && fabs(e.coefficient()) > infinity_norm) {
+      infinity_norm = fabs(e.coefficient());
+      *row_index = e.row();
+    }
+  }
+  return infinity_norm;
+}
+
+template <typename SparseColumnOrView>
+void SparseSetSupportToFalse(const SparseColumnOrView& column,
+                             DenseBooleanColumn* b) {
+  for (const typename SparseColumnOrView::Entry e : column) {
+    if (e.coefficient() != 0.0) {
+      (*b)[e.row()] = false;
+    }
+  }
+}
+
+template <typename SparseColumnOrView>
+bool SparseIsDominated(const SparseColumnOrView& column,
+                       const DenseColumn& radius) {
+  for (const typename SparseColumnOrView::Entry e : column) {
+    DCHECK_GE(radius[e.row()], 0.0);
+    if (fabs(e.coefficient()) > radius[e.row()]) return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+Fractional SquaredNorm(const SparseColumn& v) { return SparseSquaredNorm(v); }
+
+Fractional SquaredNorm(const CompactSparseMatrix::ColumnView& v) {
+  return SparseSquaredNorm(v);
+}
+
 Fractional PreciseSquaredNorm(const SparseColumn& v) {
   KahanSum sum;
   for (const SparseColumn::Entry e : v) {
@@ -70,12 +126,10 @@ Fractional InfinityNorm(const DenseColumn& v) {
   return infinity_norm;
 }
 
-Fractional InfinityNorm(const SparseColumn& v) {
-  Fractional infinity_norm = 0.0;
-  for (const SparseColumn::Entry e : v) {
-    infinity_norm = std::max(infinity_norm, fabs(e.coefficient()));
-  }
-  return infinity_norm;
+Fractional InfinityNorm(const SparseColumn& v) { return SparseInfinityNorm(v); }
+
+Fractional InfinityNorm(const CompactSparseMatrix::ColumnView& v) {
+  return SparseInfinityNorm(v);
 }
 
 double Density(const DenseRow& row) {
@@ -108,30 +162,31 @@ void RemoveNearZeroEntries(Fractional threshold, DenseColumn* column) {
 Fractional RestrictedInfinityNorm(const SparseColumn& column,
                                   const DenseBooleanColumn& row_to_consider,
                                   RowIndex* row_index) {
-  Fractional infinity_norm = 0.0;
-  for (const SparseColumn::Entry e : column) {
-    if (row_to_consider[e.row()] && fabs(e.coefficient()) > infinity_norm) {
-      infinity_norm = fabs(e.coefficient());
-      *row_index = e.row();
-    }
-  }
-  return infinity_norm;
+  return SparseRestrictedInfinityNorm(column, row_to_consider, row_index);
+}
+
+Fractional RestrictedInfinityNorm(const CompactSparseMatrix::ColumnView& column,
+                                  const DenseBooleanColumn& row_to_consider,
+                                  RowIndex* row_index) {
+  return SparseRestrictedInfinityNorm(column, row_to_consider, row_index);
 }
 
 void SetSupportToFalse(const SparseColumn& column, DenseBooleanColumn* b) {
-  for (const SparseColumn::Entry e : column) {
-    if (e.coefficient() != 0.0) {
-      (*b)[e.row()] = false;
-    }
-  }
+  SparseSetSupportToFalse(column, b);
+}
+
+void SetSupportToFalse(const CompactSparseMatrix::ColumnView& column,
+                       DenseBooleanColumn* b) {
+  SparseSetSupportToFalse(column, b);
 }
 
 bool IsDominated(const SparseColumn& column, const DenseColumn& radius) {
-  for (const SparseColumn::Entry e : column) {
-    DCHECK_GE(radius[e.row()], 0.0);
-    if (fabs(e.coefficient()) > radius[e.row()]) return false;
-  }
-  return true;
+  return SparseIsDominated(column, radius);
+}
+
+bool IsDominated(const CompactSparseMatrix::ColumnView& column,
+                 const DenseColumn& radius) {
+  return SparseIsDominated(column, radius);
 }
 
 }  // namespace glop
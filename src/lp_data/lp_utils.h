@@ -19,6 +19,7 @@
 
 #include "base/accurate_sum.h"
 #include "lp_data/lp_types.h"
+#include "lp_data/sparse.h"
 #include "lp_data/sparse_column.h"
 
 namespace operations_research {
@@ -103,6 +104,7 @@ Fractional PreciseScalarProduct(const DenseRowOrColumn& u,
 // Returns the norm^2 (sum of the square of the entries) of the given column.
 // The precise version uses KahanSum and are about two times slower.
 Fractional SquaredNorm(const SparseColumn& v);
+Fractional SquaredNorm(const CompactSparseMatrix::ColumnView& v);
 Fractional SquaredNorm(const DenseColumn& v);
 Fractional PreciseSquaredNorm(const SparseColumn& v);
 Fractional PreciseSquaredNorm(const DenseColumn& v);
@@ -111,6 +113,7 @@ Fractional PreciseSquaredNorm(ScatteredColumnReference v);
 // Returns the maximum of the |coefficients| of 'v'.
 Fractional InfinityNorm(const DenseColumn& v);
 Fractional InfinityNorm(const SparseColumn& v);
+Fractional InfinityNorm(const CompactSparseMatrix::ColumnView& v);
 
 // Returns the fraction of non-zero entries of the given row.
 double Density(const DenseRow& row);
@@ -131,14 +134,21 @@ const DenseColumn& Transpose(const DenseRow& row);
 Fractional RestrictedInfinityNorm(const SparseColumn& column,
                                   const DenseBooleanColumn& rows_to_consider,
                                   RowIndex* row_index);
+Fractional RestrictedInfinityNorm(const CompactSparseMatrix::ColumnView& column,
+                                  const DenseBooleanColumn& rows_to_consider,
+                                  RowIndex* row_index);
 
 // Sets to false the entry b[row] if column[row] is non null.
 // Note that if 'b' was true only on the non-zero position of column, this can
 // be used as a fast way to clear 'b'.
 void SetSupportToFalse(const SparseColumn& column, DenseBooleanColumn* b);
+void SetSupportToFalse(const CompactSparseMatrix::ColumnView& column,
+                       DenseBooleanColumn* b);
 
 // Returns true iff for all 'row' we have '|column[row]| <= radius[row]'.
 bool IsDominated(const SparseColumn& column, const DenseColumn& radius);
+bool IsDominated(const CompactSparseMatrix::ColumnView& column,
+                 const DenseColumn& radius);
 
 // This cast based implementation should be safe, as long as DenseRow and
 // DenseColumn are implemented by the same underlying type.
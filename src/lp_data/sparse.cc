@@ -119,6 +119,40 @@ void SparseMatrix::CleanUp() {
   for (ColIndex col(0); col < num_cols; ++col) {
     columns_[col].CleanUp();
   }
+  CompactColumnEntries();
+}
+
+void SparseMatrix::ClearAndReserveColumnEntries(
+    const StrictITIVector<ColIndex, EntryIndex>& num_entries) {
+  const ColIndex num_cols(columns_.size());
+  DCHECK_EQ(num_cols, num_entries.size());
+  EntryIndex total_num_entries(0);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    total_num_entries += num_entries[col];
+  }
+  SparseColumn::EntryBlock block(total_num_entries);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    columns_[col].ClearAndUseEntryBlock(num_entries[col], &block);
+  }
+}
+
+void SparseMatrix::CompactColumnEntries() {
+  const ColIndex num_cols(columns_.size());
+  bool is_compact = true;
+  StrictITIVector<ColIndex, EntryIndex> num_entries(num_cols, EntryIndex(0));
+  for (ColIndex col(0); col < num_cols; ++col) {
+    const SparseColumn& column = columns_[col];
+    num_entries[col] = column.num_entries_with_duplicates();
+    if (!column.IsEmpty() && !column.UsesEntryBlock()) is_compact = false;
+  }
+  if (is_compact) return;
+  StrictITIVector<ColIndex, SparseColumn> old_columns;
+  old_columns.swap(columns_);
+  columns_.resize(num_cols, SparseColumn());
+  ClearAndReserveColumnEntries(num_entries);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    columns_[col].PopulateFromSparseVector(old_columns[col]);
+  }
 }
 
 bool SparseMatrix::CheckNoDuplicates() const {
@@ -169,6 +203,8 @@ void SparseMatrix::PopulateFromZero(RowIndex num_rows, ColIndex num_cols) {
 
 void SparseMatrix::PopulateFromIdentity(ColIndex num_cols) {
   PopulateFromZero(ColToRowIndex(num_cols), num_cols);
+  ClearAndReserveColumnEntries(
+      StrictITIVector<ColIndex, EntryIndex>(num_cols, EntryIndex(1)));
   for (ColIndex col(0); col < num_cols; ++col) {
     const RowIndex row = ColToRowIndex(col);
     columns_[col].SetCoefficient(row, Fractional(1.0));
@@ -179,17 +215,15 @@ template <typename Matrix>
 void SparseMatrix::PopulateFromTranspose(const Matrix& input) {
   Reset(RowToColIndex(input.num_rows()), ColToRowIndex(input.num_cols()));
 
-  // We do a first pass on the input matrix to resize the new columns properly.
-  StrictITIVector<RowIndex, EntryIndex> row_degree(input.num_rows(),
-                                                   EntryIndex(0));
+  // We do a first pass on the input matrix to reserve the new columns properly.
+  StrictITIVector<ColIndex, EntryIndex> row_degree(
+      RowToColIndex(input.num_rows()), EntryIndex(0));
   for (ColIndex col(0); col < input.num_cols(); ++col) {
     for (const SparseColumn::Entry e : input.column(col)) {
-      ++row_degree[e.row()];
+      ++row_degree[RowToColIndex(e.row())];
     }
   }
-  for (RowIndex row(0); row < input.num_rows(); ++row) {
-    columns_[RowToColIndex(row)].Reserve(row_degree[row]);
-  }
+  ClearAndReserveColumnEntries(row_degree);
 
   for (ColIndex col(0); col < input.num_cols(); ++col) {
     const RowIndex transposed_row = ColToRowIndex(col);
@@ -202,8 +236,16 @@ void SparseMatrix::PopulateFromTranspose(const Matrix& input) {
 }
 
 void SparseMatrix::PopulateFromSparseMatrix(const SparseMatrix& matrix) {
-  Reset(ColIndex(0), matrix.num_rows_);
-  columns_ = matrix.columns_;
+  const ColIndex num_cols = matrix.num_cols();
+  Reset(num_cols, matrix.num_rows_);
+  StrictITIVector<ColIndex, EntryIndex> num_entries(num_cols, EntryIndex(0));
+  for (ColIndex col(0); col < num_cols; ++col) {
+    num_entries[col] = matrix.columns_[col].num_entries_with_duplicates();
+  }
+  ClearAndReserveColumnEntries(num_entries);
+  for (ColIndex col(0); col < num_cols; ++col) {
+    columns_[col].PopulateFromSparseVector(matrix.columns_[col]);
+  }
 }
 
 template <typename Matrix>
@@ -212,6 +254,11 @@ void SparseMatrix::PopulateFromPermutedMatrix(
     const ColumnPermutation& inverse_col_perm) {
   const ColIndex num_cols = a.num_cols();
   Reset(num_cols, a.num_rows());
+  StrictITIVector<ColIndex, EntryIndex> num_entries(num_cols, EntryIndex(0));
+  for (ColIndex col(0); col < num_cols; ++col) {
+    num_entries[col] = a.column(inverse_col_perm[col]).num_entries();
+  }
+  ClearAndReserveColumnEntries(num_entries);
   for (ColIndex col(0); col < num_cols; ++col) {
     for (const SparseColumn::Entry e : a.column(inverse_col_perm[col])) {
       columns_[col].SetCoefficient(row_perm[e.row()], e.coefficient());
@@ -243,6 +290,7 @@ void SparseMatrix::PopulateFromLinearCombination(Fractional alpha,
     columns_[col].CleanUp();
     dense_column.Clear();
   }
+  CompactColumnEntries();
 }
 
 void SparseMatrix::PopulateFromProduct(const SparseMatrix& a,
@@ -269,6 +317,7 @@ void SparseMatrix::PopulateFromProduct(const SparseMatrix& a,
     columns_[col_b].CleanUp();
     tmp_column.Clear();
   }
+  CompactColumnEntries();
 }
 
 void SparseMatrix::DeleteColumns(const DenseBooleanRow& columns_to_delete) {
@@ -451,6 +500,35 @@ void CompactSparseMatrix::PopulateFromMatrixView(const MatrixView& input) {
   starts_[input.num_cols()] = index;
 }
 
+void CompactSparseMatrix::PopulateFromSparseMatrixAndAddSlacks(
+    const SparseMatrix& input) {
+  const ColIndex first_slack_col = input.num_cols();
+  num_rows_ = input.num_rows();
+  num_cols_ = first_slack_col + RowToColIndex(num_rows_);
+  const EntryIndex num_entries =
+      input.num_entries() + EntryIndex(num_rows_.value());
+  starts_.assign(num_cols_ + 1, EntryIndex(0));
+  coefficients_.assign(num_entries, 0.0);
+  rows_.assign(num_entries, RowIndex(0));
+  EntryIndex index(0);
+  for (ColIndex col(0); col < first_slack_col; ++col) {
+    starts_[col] = index;
+    for (const SparseColumn::Entry e : input.column(col)) {
+      coefficients_[index] = e.coefficient();
+      rows_[index] = e.row();
+      ++index;
+    }
+  }
+  for (RowIndex row(0); row < num_rows_; ++row) {
+    starts_[first_slack_col + RowToColIndex(row)] = index;
+    coefficients_[index] = 1.0;
+    rows_[index] = row;
+    ++index;
+  }
+  starts_[num_cols_] = index;
+  DCHECK_EQ(index, num_entries);
+}
+
 void CompactSparseMatrix::PopulateFromTranspose(
     const CompactSparseMatrix& input) {
   num_cols_ = RowToColIndex(input.num_rows());
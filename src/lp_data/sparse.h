@@ -44,6 +44,15 @@ namespace glop {
 // SparseMatrix is a class for sparse matrices suitable for computation.
 // Data is represented using the so-called compressed-column storage scheme.
 // Entries (row, col, value) are stored by column using a SparseColumn.
+// When the number of entries of each column is known in advance, i.e. in the
+// PopulateFrom*() functions, in CleanUp() and after
+// ClearAndReserveColumnEntries(), the entries of all the columns are stored
+// one column after the other in a single allocation shared by the columns (see
+// SparseVectorEntryBlock). A column can still be modified in place, and it is
+// moved to its own allocation only when it grows past its reserved range.
+// Code that only scans the matrix, like the simplex, should still work on a
+// CompactSparseMatrix built from it, which stores the rows and coefficients in
+// two separate arrays.
 //
 // Citing [Duff et al, 1987], a matrix is sparse if many of its coefficients are
 // zero and if there is an advantage in exploiting its zeros.
@@ -75,7 +84,9 @@ class SparseMatrix {
   bool IsEmpty() const;
 
   // Cleans the columns, i.e. removes zero-values entries, removes duplicates
-  // entries and sorts remaining entries in increasing row order.
+  // entries and sorts remaining entries in increasing row order. The entries of
+  // the columns are then moved back to a single allocation if some columns
+  // have their own.
   // Call with care: Runs in O(num_cols * column_cleanup), with each column
   // cleanup running in O(num_entries * log(num_entries)).
   void CleanUp();
@@ -100,6 +111,12 @@ class SparseMatrix {
   // Works in O(1).
   void Swap(SparseMatrix* matrix);
 
+  // Clears all the columns and reserves num_entries[col] entries for each
+  // column col in a single allocation. num_entries must have num_cols()
+  // elements.
+  void ClearAndReserveColumnEntries(
+      const StrictITIVector<ColIndex, EntryIndex>& num_entries);
+
   // Populates the matrix with num_cols columns of zeros. As the number of rows
   // is specified by num_rows, the matrix is not necessarily square.
   // Previous columns/values are deleted.
@@ -197,6 +214,10 @@ class SparseMatrix {
   // matrix of size num_rows x num_cols.
   void Reset(ColIndex num_cols, RowIndex num_rows);
 
+  // Moves the entries of all the columns to a single allocation, unless they
+  // already are in one. Runs in O(num_entries) when they are moved.
+  void CompactColumnEntries();
+
   // Vector of sparse columns.
   StrictITIVector<ColIndex, SparseColumn> columns_;
 
@@ -285,6 +306,14 @@ class CompactSparseMatrix {
   // each column is preserved.
   void PopulateFromMatrixView(const MatrixView& input);
 
+  // Creates a CompactSparseMatrix from the given SparseMatrix A followed by
+  // an identity matrix of size A.num_rows(), i.e. [A | I]. The slack column
+  // of the row r is thus the column A.num_cols() + r. This is equivalent to
+  // PopulateFromMatrixView() on a view of A and of an identity SparseMatrix,
+  // but the identity matrix is never built and the data of the whole matrix
+  // is allocated once.
+  void PopulateFromSparseMatrixAndAddSlacks(const SparseMatrix& input);
+
   // Creates a CompactSparseMatrix from the transpose of the given
   // CompactSparseMatrix. Note that the entries in each columns will be ordered
   // by row indices.
@@ -346,11 +375,45 @@ class CompactSparseMatrix {
   RowIndex EntryRow(EntryIndex i) const { return rows_[i]; }
 
   // Class to iterate on the entries of a given column with the same interface
-  // as for SparseColumn.
-  //
-  // TODO(user): Also add the 'for (ColumnView::Entry e : view) {}' iterator.
+  // as for SparseColumn. This includes the range-based loop:
+  // for (const CompactSparseMatrix::ColumnView::Entry e : view) {
+  //   const RowIndex row = e.row();
+  //   const Fractional coefficient = e.coefficient();
+  // }
   class ColumnView {
    public:
+    class Entry {
+     public:
+      Entry(RowIndex row, Fractional coefficient)
+          : row_(row), coefficient_(coefficient) {}
+      RowIndex row() const { return row_; }
+      Fractional coefficient() const { return coefficient_; }
+
+     private:
+      RowIndex row_;
+      Fractional coefficient_;
+    };
+
+    // The rows and the coefficients of the entries are stored in two separate
+    // arrays, so the iterator just advances two pointers in parallel.
+    class Iterator {
+     public:
+      Iterator(const RowIndex* row, const Fractional* coefficient)
+          : row_(row), coefficient_(coefficient) {}
+      Entry operator*() const { return Entry(*row_, *coefficient_); }
+      void operator++() {
+        ++row_;
+        ++coefficient_;
+      }
+      bool operator!=(const Iterator& other) const {
+        return row_ != other.row_;
+      }
+
+     private:
+      const RowIndex* row_;
+      const Fractional* coefficient_;
+    };
+
     ColumnView(EntryIndex num_entries, const RowIndex* const rows,
                const Fractional* const coefficients)
         : num_entries_(num_entries), rows_(rows), coefficients_(coefficients) {}
@@ -360,6 +423,32 @@ class CompactSparseMatrix {
     }
     RowIndex EntryRow(EntryIndex i) const { return rows_[i.value()]; }
 
+    Iterator begin() const { return Iterator(rows_, coefficients_); }
+    Iterator end() const {
+      return Iterator(rows_ + num_entries_.value(),
+                      coefficients_ + num_entries_.value());
+    }
+
+    // Same behavior as the SparseColumn functions with the same name.
+    bool IsEmpty() const { return num_entries_ == 0; }
+    RowIndex GetFirstRow() const {
+      DCHECK(!IsEmpty());
+      return rows_[0];
+    }
+    Fractional GetFirstCoefficient() const {
+      DCHECK(!IsEmpty());
+      return coefficients_[0];
+    }
+
+    // Returns the coefficient of the given row, or zero if there is no such
+    // entry. Runs in O(num_entries).
+    Fractional LookUpCoefficient(RowIndex row) const {
+      for (EntryIndex i(0); i < num_entries_; ++i) {
+        if (rows_[i.value()] == row) return coefficients_[i.value()];
+      }
+      return 0.0;
+    }
+
    private:
     const EntryIndex num_entries_;
     const RowIndex* const rows_;
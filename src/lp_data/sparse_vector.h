@@ -29,6 +29,7 @@
 #define OR_TOOLS_LP_DATA_SPARSE_VECTOR_H_
 
 #include <algorithm>
+#include <memory>
 #include <string>
 
 #include "base/logging.h"  // for CHECK*
@@ -41,6 +42,175 @@
 namespace operations_research {
 namespace glop {
 
+template <typename T>
+class SparseVectorStorage;
+
+// --------------------------------------------------------
+// SparseVectorEntryBlock
+// --------------------------------------------------------
+// A single allocation holding the entries of several SparseVector, typically
+// all the columns of a SparseMatrix. Each vector using the block gets its own
+// range of it (see SparseVector::ClearAndUseEntryBlock()), so the vectors are
+// contiguous in memory and filling them doesn't allocate once per vector. The
+// allocation is freed when the block and all the vectors using it are.
+template <typename T>
+class SparseVectorEntryBlock {
+ public:
+  explicit SparseVectorEntryBlock(EntryIndex size)
+      : entries_(static_cast<T*>(::operator new(size.value() * sizeof(T))),
+                 [](T* entries) { ::operator delete(entries); }),
+        size_(size),
+        num_used_(0) {}
+
+  // Returns the number of entries that are not yet given to a vector.
+  EntryIndex num_unused() const { return size_ - num_used_; }
+
+ private:
+  friend class SparseVectorStorage<T>;
+  std::shared_ptr<T> entries_;
+  EntryIndex size_;
+  EntryIndex num_used_;
+
+  DISALLOW_COPY_AND_ASSIGN(SparseVectorEntryBlock);
+};
+
+// --------------------------------------------------------
+// SparseVectorStorage
+// --------------------------------------------------------
+// The storage of the entries of a SparseVector: a minimal std::vector of
+// trivially copyable elements, indexed by EntryIndex, whose elements are
+// either owned or a range of a SparseVectorEntryBlock. In the latter case, the
+// elements are modified in place as long as they fit in the range, and moved
+// to an owned allocation when they grow past it. A copy always owns its
+// elements.
+template <typename T>
+class SparseVectorStorage {
+ public:
+  SparseVectorStorage()
+      : data_(nullptr), size_(0), capacity_(0), block_entries_() {}
+  SparseVectorStorage(const SparseVectorStorage& other)
+      : SparseVectorStorage() {
+    *this = other;
+  }
+  // The moves are noexcept so that a std::vector of SparseVector moves them
+  // when it grows, and the moved vectors keep using their entry block.
+  SparseVectorStorage(SparseVectorStorage&& other) noexcept
+      : SparseVectorStorage() {
+    swap(other);
+  }
+  ~SparseVectorStorage() { ReleaseOwnedData(); }
+
+  SparseVectorStorage& operator=(const SparseVectorStorage& other) {
+    if (this == &other) return *this;
+    if (other.size_ > capacity_) {
+      ReleaseOwnedData();
+      block_entries_.reset();
+      data_ = Allocate(other.size_);
+      capacity_ = other.size_;
+    }
+    std::copy(other.begin(), other.end(), data_);
+    size_ = other.size_;
+    return *this;
+  }
+  SparseVectorStorage& operator=(SparseVectorStorage&& other) noexcept {
+    swap(other);
+    return *this;
+  }
+
+  EntryIndex size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  T& operator[](EntryIndex i) { return data_[i.value()]; }
+  const T& operator[](EntryIndex i) const { return data_[i.value()]; }
+  T* begin() { return data_; }
+  T* end() { return data_ + size_.value(); }
+  const T* begin() const { return data_; }
+  const T* end() const { return data_ + size_.value(); }
+  T& front() { return data_[0]; }
+  const T& front() const { return data_[0]; }
+  T& back() { return data_[size_.value() - 1]; }
+  const T& back() const { return data_[size_.value() - 1]; }
+
+  void clear() { size_ = EntryIndex(0); }
+  void resize_down(EntryIndex size) {
+    DCHECK_LE(size, size_);
+    size_ = size;
+  }
+  void resize(EntryIndex size, const T& value) {
+    reserve(size);
+    if (size > size_) std::fill(end(), data_ + size.value(), value);
+    size_ = size;
+  }
+  void reserve(EntryIndex capacity) {
+    if (capacity > capacity_) Reallocate(capacity);
+  }
+  void push_back(const T& value) {
+    if (size_ == capacity_) {
+      // value may be one of our elements.
+      const T copy = value;
+      Reallocate(std::max(size_ + 1, size_ + size_));
+      data_[size_.value()] = copy;
+    } else {
+      data_[size_.value()] = value;
+    }
+    ++size_;
+  }
+  void erase(T* position) {
+    std::copy(position + 1, end(), position);
+    --size_;
+  }
+  void swap(SparseVectorStorage& other) noexcept {
+    std::swap(data_, other.data_);
+    std::swap(size_, other.size_);
+    std::swap(capacity_, other.capacity_);
+    block_entries_.swap(other.block_entries_);
+  }
+
+  // Clears the storage and releases its memory.
+  void ClearAndRelease() { SparseVectorStorage().swap(*this); }
+
+  // Clears the storage and makes it use the next capacity entries of the given
+  // block.
+  void ClearAndUseEntryBlock(EntryIndex capacity,
+                             SparseVectorEntryBlock<T>* block) {
+    DCHECK_LE(capacity, block->num_unused());
+    ReleaseOwnedData();
+    data_ = block->entries_.get() + block->num_used_.value();
+    size_ = EntryIndex(0);
+    capacity_ = capacity;
+    block_entries_ = block->entries_;
+    block->num_used_ += capacity;
+  }
+
+  // Returns true if the elements are in a SparseVectorEntryBlock.
+  bool UsesEntryBlock() const { return block_entries_ != nullptr; }
+
+ private:
+  static T* Allocate(EntryIndex capacity) {
+    return static_cast<T*>(::operator new(capacity.value() * sizeof(T)));
+  }
+  void ReleaseOwnedData() {
+    if (block_entries_ == nullptr) ::operator delete(data_);
+  }
+
+  // Moves the elements to a new owned allocation of the given capacity.
+  void Reallocate(EntryIndex capacity) {
+    T* const data = Allocate(capacity);
+    std::copy(begin(), end(), data);
+    ReleaseOwnedData();
+    block_entries_.reset();
+    data_ = data;
+    capacity_ = capacity;
+  }
+
+  T* data_;
+  EntryIndex size_;
+  EntryIndex capacity_;
+
+  // The entries of the block containing data_, if any. This keeps the block
+  // alive as long as this storage uses it.
+  std::shared_ptr<T> block_entries_;
+};
+
 // --------------------------------------------------------
 // SparseVector
 // --------------------------------------------------------
@@ -65,6 +235,9 @@ namespace glop {
 // index-based APIs and leveraging iterator-based APIs; if possible.
 template <typename IndexType>
 class SparseVector {
+ protected:
+  struct InternalEntry;
+
  public:
   typedef IndexType Index;
 
@@ -101,6 +274,19 @@ class SparseVector {
   // Reserve the underlying storage for the given number of entries.
   void Reserve(EntryIndex size);
 
+  // A single allocation that can hold the entries of several vectors, see
+  // SparseVectorEntryBlock.
+  typedef SparseVectorEntryBlock<InternalEntry> EntryBlock;
+
+  // Clears the vector and makes it store its entries in the next capacity
+  // entries of the given block, so up to capacity entries can then be added
+  // without any allocation. If more are added, the entries are moved to an
+  // allocation of their own. The vector can be used as usual in both cases.
+  void ClearAndUseEntryBlock(EntryIndex capacity, EntryBlock* block);
+
+  // Returns true if the entries are stored in an EntryBlock.
+  bool UsesEntryBlock() const { return entry_.UsesEntryBlock(); }
+
   // Returns true if the vector is empty.
   bool IsEmpty() const;
 
@@ -240,6 +426,10 @@ class SparseVector {
     return EntryIndex(entry_.size());
   }
 
+  // Same as num_entries(), but counts the duplicates, if any. This is the
+  // size needed to store the vector, e.g. in an EntryBlock.
+  EntryIndex num_entries_with_duplicates() const { return entry_.size(); }
+
   // Returns the first entry's index and coefficient; note that 'first' doesn't
   // mean 'entry with the smallest index'.
   // Runs in O(1).
@@ -300,9 +490,9 @@ class SparseVector {
   const InternalEntry& entry(EntryIndex i) const { return entry_[i]; }
 
   // Vector of entries. Not necessarily sorted.
-  // TODO(user): try splitting the std::vector<InternalEntry> into two vectors
-  // of index and coefficient, like it is done in SparseMatrix.
-  StrictITIVector<EntryIndex, InternalEntry> entry_;
+  // TODO(user): try splitting the InternalEntry into two vectors of index and
+  // coefficient, like it is done in CompactSparseMatrix.
+  SparseVectorStorage<InternalEntry> entry_;
 
   // This is here to speed up the CheckNoDuplicates() methods and is mutable
   // so we can perform checks on const argument.
@@ -378,14 +568,20 @@ void SparseVector<IndexType>::Clear() {
 
 template <typename IndexType>
 void SparseVector<IndexType>::ClearAndRelease() {
-  StrictITIVector<EntryIndex, InternalEntry> empty;
-  empty.swap(entry_);
+  entry_.ClearAndRelease();
   may_contain_duplicates_ = false;
 }
 
 template <typename IndexType>
 void SparseVector<IndexType>::Reserve(EntryIndex size) {
-  entry_.reserve(size.value());
+  entry_.reserve(size);
+}
+
+template <typename IndexType>
+void SparseVector<IndexType>::ClearAndUseEntryBlock(EntryIndex capacity,
+                                                    EntryBlock* block) {
+  entry_.ClearAndUseEntryBlock(capacity, block);
+  may_contain_duplicates_ = false;
 }
 
 template <typename IndexType>
@@ -589,7 +589,8 @@ void MakeAllLiteralsPositive(LinearBooleanProblem* problem) {
 }
 
 void FindLinearBooleanProblemSymmetries(
-    const LinearBooleanProblem& problem,
+    const LinearBooleanProblem& problem, double time_limit_in_seconds,
+    int num_threads,
     std::vector<std::unique_ptr<SparsePermutation>>* generators) {
   typedef GraphSymmetryFinder::Graph Graph;
   std::vector<int> equivalence_classes;
@@ -622,11 +623,19 @@ void FindLinearBooleanProblemSymmetries(
   }
   GraphSymmetryFinder symmetry_finder(*graph,
                                       /*is_undirected=*/true);
+  symmetry_finder.set_num_threads(num_threads);
   std::vector<int> factorized_automorphism_group_size;
-  // TODO(user): inject the appropriate time limit here.
-  CHECK_OK(symmetry_finder.FindSymmetries(
-      /*time_limit_seconds=*/std::numeric_limits<double>::infinity(),
-      &equivalence_classes, generators, &factorized_automorphism_group_size));
+  const util::Status status = symmetry_finder.FindSymmetries(
+      time_limit_in_seconds, &equivalence_classes, generators,
+      &factorized_automorphism_group_size);
+  if (status.error_code() == util::error::DEADLINE_EXCEEDED) {
+    // The generators found so far are still valid symmetries.
+    LOG(INFO) << "Time limit reached during the symmetry detection: "
+              << status.error_message();
+  } else if (!status.ok()) {
+    LOG(DFATAL) << "Error during the symmetry detection: " << status;
+    generators->clear();
+  }
 
   // Remove from the permutations the part not concerning the literals.
   // Note that some permutation may becomes empty, which means that we had
@@ -104,8 +104,14 @@ void MakeAllLiteralsPositive(LinearBooleanProblem* problem);
 // generator is a permutation of the integer range [0, 2n) where n is the number
 // of variables of the problem. They are permutations of the (index
 // representation of the) problem literals.
+//
+// The search stops after the given time limit, in which case only the
+// generators found so far are returned: they are still valid symmetries, but
+// may not generate the whole group. The symmetry finder uses the given number
+// of threads.
 void FindLinearBooleanProblemSymmetries(
-    const LinearBooleanProblem& problem,
+    const LinearBooleanProblem& problem, double time_limit_in_seconds,
+    int num_threads,
     std::vector<std::unique_ptr<SparsePermutation>>* generators);
 
 // Maps all the literals of the problem. Note that this converts the cost of a
@@ -15,6 +15,7 @@
 #define OR_TOOLS_UTIL_TIME_LIMIT_H_
 
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <limits>
 #include <vector>
@@ -117,13 +118,22 @@ class TimeLimit {
   // i.e. LimitReached() returns true when the value of
   // external_boolean_as_limit is true whatever the time limits are.
   //
-  // Note that external_boolean_as_limit is not protected by a mutex; This
-  // should not prevent usage in a mutli-threading environment because the
-  // change is atomic and it is usually not critical to wrongly return false in
-  // LimitReached() once in case of race between the change of the Boolean and
-  // the check of the limit.
+  // Note that external_boolean_as_limit is read without any synchronization;
+  // when it is written by another thread while this time limit is in use,
+  // register a std::atomic<bool> instead, see below.
   void RegisterExternalBooleanAsLimit(const bool* external_boolean_as_limit) {
     external_boolean_as_limit_ = external_boolean_as_limit;
+    external_atomic_boolean_as_limit_ = nullptr;
+  }
+
+  // Same as above, but for a Boolean that is written by another thread while
+  // this time limit is in use, e.g. to interrupt a set of concurrent searches.
+  // Only one of the two external Booleans can be registered at a time:
+  // registering one unregisters the other.
+  void RegisterExternalBooleanAsLimit(
+      const std::atomic<bool>* external_atomic_boolean_as_limit) {
+    external_boolean_as_limit_ = nullptr;
+    external_atomic_boolean_as_limit_ = external_atomic_boolean_as_limit;
   }
 
  private:
@@ -143,6 +153,7 @@ class TimeLimit {
   double elapsed_deterministic_time_;
 
   const bool* external_boolean_as_limit_;
+  const std::atomic<bool>* external_atomic_boolean_as_limit_;
 
   DISALLOW_COPY_AND_ASSIGN(TimeLimit);
 };
@@ -159,7 +170,8 @@ inline TimeLimit::TimeLimit(double limit_in_seconds, double deterministic_limit)
       running_max_(kHistorySize),
       deterministic_limit_(deterministic_limit),
       elapsed_deterministic_time_(0.0),
-      external_boolean_as_limit_(nullptr) {
+      external_boolean_as_limit_(nullptr),
+      external_atomic_boolean_as_limit_(nullptr) {
 #ifndef ANDROID_JNI
   if (FLAGS_time_limit_use_usertime) {
     user_timer_.Start();
@@ -172,6 +184,10 @@ inline bool TimeLimit::LimitReached() {
   if (external_boolean_as_limit_ != nullptr && *external_boolean_as_limit_) {
     return true;
   }
+  if (external_atomic_boolean_as_limit_ != nullptr &&
+      external_atomic_boolean_as_limit_->load(std::memory_order_relaxed)) {
+    return true;
+  }
 
   if (GetDeterministicTimeLeft() <= 0.0) {
     return true;
@@ -28,13 +28,16 @@
 // Therefore, you don't need to use const IntTupleSet& in methods. Just do:
 // void MyMethod(IntTupleSet tuple_set) { ... }
 //
-// This class is thread hostile as the copy and reference counter are
-// not protected by a mutex.
+// The reference counter is atomic: IntTupleSets sharing the same data can be
+// copied and destroyed concurrently by different threads, as long as none of
+// them modifies the data. This is how the workers of a parallel solve share
+// large tuple sets. Otherwise, this class is thread hostile.
 
 #ifndef OR_TOOLS_UTIL_TUPLE_SET_H_
 #define OR_TOOLS_UTIL_TUPLE_SET_H_
 
 #include <algorithm>
+#include <atomic>
 #include "base/hash.h"
 #include "base/hash.h"
 #include <vector>
@@ -119,7 +122,7 @@ class IntTupleSet {
 
    private:
     const int arity_;
-    int num_owners_;
+    std::atomic<int> num_owners_;
     // Concatenation of all tuples ever added.
     std::vector<int64> flat_tuples_;
     // Maps a tuple's fingerprint to the list of tuples with this